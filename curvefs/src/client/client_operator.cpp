@@ -209,6 +209,88 @@ CURVEFS_ERROR RenameOperator::CommitTx() {
     return CURVEFS_ERROR::OK;
 }
 
+// The commit of metaserver is unknown, the txids known before may be the
+// ones before the commit, preparing with them rolls back the transaction
+// committed, so they are got from mds again before falling back.
+CURVEFS_ERROR RenameOperator::CheckCommitted(uint64_t txId) {
+    if (!metaClient_->RefreshTxId(fsId_)) {
+        LOG(ERROR) << "RefreshTxId failed, DebugString = " << DebugString();
+        return CURVEFS_ERROR::INTERNAL;
+    }
+
+    auto rc = GetTxId();
+    if (rc != CURVEFS_ERROR::OK) {
+        return rc;
+    } else if (txId != 0 && srcTxId_ >= txId) {
+        return CURVEFS_ERROR::OK;
+    }
+    return CURVEFS_ERROR::NOTSUPPORT;
+}
+
+CURVEFS_ERROR RenameOperator::Rename() {
+    Dentry dentry(srcDentry_);
+    dentry.set_txid(srcTxId_);
+    Dentry newDentry(srcDentry_);
+    newDentry.set_parentinodeid(newParentId_);
+    newDentry.set_name(newname_);
+    newDentry.set_txid(dstTxId_);
+
+    uint64_t txId = 0;
+    uint64_t dstTxId = 0;
+    auto rc = metaClient_->Rename(dentry, newDentry, &txId, &dstTxId);
+    if (rc == MetaStatusCode::TX_COMMIT_UNKNOWN) {
+        LOG_ERROR("Rename", rc);
+        auto ret = CheckCommitted(txId);
+        if (ret != CURVEFS_ERROR::OK) {
+            return ret;
+        }
+    } else if (rc != MetaStatusCode::OK) {
+        LOG_ERROR("Rename", rc);
+        return CURVEFS_ERROR::NOTSUPPORT;
+    }
+
+    // the dentrys are the ones committed, same as PrepareTx() does
+    dentry_ = dentry;
+    dentry_.set_txid(txId);
+    dentry_.set_flag(dentry_.flag() |
+                     DentryFlag::DELETE_MARK_FLAG |
+                     DentryFlag::TRANSACTION_PREPARE_FLAG);
+    newDentry_ = newDentry;
+    newDentry_.set_txid(dstTxId);
+    newDentry_.set_flag(newDentry_.flag() |
+                        DentryFlag::TRANSACTION_PREPARE_FLAG);
+    return CURVEFS_ERROR::OK;
+}
+
+void RenameOperator::UpdateDirStat(
+    const std::shared_ptr<DirStatManager> &dirStatManager) {
+    std::shared_ptr<InodeWrapper> inodeWrapper;
+    InodeAttr attr;
+    if (oldInodeId_ != 0) {
+        auto rc = inodeManager_->GetInode(oldInodeId_, inodeWrapper);
+        if (rc != CURVEFS_ERROR::OK) {
+            LOG_ERROR("GetInode", rc);
+        } else {
+            inodeWrapper->GetInodeAttrLocked(&attr);
+            dirStatManager->OnUnlink(newParentId_, attr,
+                                     inodeWrapper->GetParent());
+        }
+    }
+
+    auto rc = inodeManager_->GetInode(srcDentry_.inodeid(), inodeWrapper);
+    if (rc != CURVEFS_ERROR::OK) {
+        LOG_ERROR("GetInode", rc);
+        return;
+    }
+    inodeWrapper->GetInodeAttrLocked(&attr);
+    uint64_t owner = inodeWrapper->GetParent();
+    uint64_t newOwner = owner;
+    dirStatManager->OnRename(parentId_, newParentId_, attr, owner, &newOwner);
+    if (newOwner != owner) {
+        inodeWrapper->SetParent(newOwner);
+    }
+}
+
 void RenameOperator::UnlinkOldInode() {
     if (oldInodeId_ == 0) {
         return;
@@ -230,8 +312,8 @@ void RenameOperator::UnlinkOldInode() {
 void RenameOperator::UpdateCache() {
     dentryManager_->DeleteCache(parentId_, name_);
     dentryManager_->InsertOrReplaceCache(newDentry_);
-    SetTxId(srcPartitionId_, srcTxId_ + 1);
-    SetTxId(dstPartitionId_, dstTxId_ + 1);
+    SetTxId(srcPartitionId_, dentry_.txid());
+    SetTxId(dstPartitionId_, newDentry_.txid());
 }
 
 }  // namespace client
@@ -29,6 +29,7 @@
 
 #include "curvefs/src/client/inode_cache_manager.h"
 #include "curvefs/src/client/dentry_cache_manager.h"
+#include "curvefs/src/client/dir_stat_manager.h"
 #include "curvefs/src/client/rpcclient/mds_client.h"
 
 namespace curvefs {
@@ -52,6 +53,14 @@ class RenameOperator {
     CURVEFS_ERROR Precheck();
     CURVEFS_ERROR PrepareTx();
     CURVEFS_ERROR CommitTx();
+    // prepare and commit the transaction by the leader of source
+    // partition instead of PrepareTx() and CommitTx(), NOTSUPPORT
+    // is returned if it failed and the client should run it by itself,
+    // after the txids are refreshed from mds if the commit is unknown
+    CURVEFS_ERROR Rename();
+    // account the rename in the stats of directories, and the overwritten
+    // inode as unlinked, should be called before UnlinkOldInode()
+    void UpdateDirStat(const std::shared_ptr<DirStatManager> &dirStatManager);
     void UnlinkOldInode();
     void UpdateCache();
 
@@ -60,6 +69,9 @@ class RenameOperator {
 
     CURVEFS_ERROR CheckOverwrite();
 
+    // OK if the transaction of |txId| is committed on mds, NOTSUPPORT if not
+    CURVEFS_ERROR CheckCommitted(uint64_t txId);
+
     CURVEFS_ERROR GetTxId(uint32_t fsId,
                           uint64_t inodeId,
                           uint32_t* partitionId,
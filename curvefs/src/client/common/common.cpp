@@ -55,6 +55,24 @@ std::ostream &operator<<(std::ostream &os, MetaServerOpType optype) {
     case MetaServerOpType::GetOrModifyS3ChunkInfo:
         os << "GetOrModifyS3ChunkInfo";
         break;
+    case MetaServerOpType::BatchGetInodeAttr:
+        os << "BatchGetInodeAttr";
+        break;
+    case MetaServerOpType::BatchUpdateInode:
+        os << "BatchUpdateInode";
+        break;
+    case MetaServerOpType::CreateInodeAndDentry:
+        os << "CreateInodeAndDentry";
+        break;
+    case MetaServerOpType::UnlinkDentryAndDecNlink:
+        os << "UnlinkDentryAndDecNlink";
+        break;
+    case MetaServerOpType::Rename:
+        os << "Rename";
+        break;
+    case MetaServerOpType::UpdateDirStat:
+        os << "UpdateDirStat";
+        break;
     default:
         os << "Unknow opType";
     }
@@ -54,6 +54,12 @@ enum class MetaServerOpType {
     CreateInode,
     DeleteInode,
     GetOrModifyS3ChunkInfo,
+    BatchGetInodeAttr,
+    BatchUpdateInode,
+    CreateInodeAndDentry,
+    UnlinkDentryAndDecNlink,
+    Rename,
+    UpdateDirStat,
 };
 
 std::ostream &operator<<(std::ostream &os, MetaServerOpType optype);
@@ -131,6 +131,10 @@ void InitDiskCacheOption(Configuration *conf,
                               &diskCacheOption->avgReadFileBytes);
     conf->GetValueFatalIfFail("diskCache.avgReadFileIops",
                               &diskCacheOption->avgReadFileIops);
+    conf->GetValueFatalIfFail("diskCache.ioThreads",
+                              &diskCacheOption->ioThreads);
+    conf->GetValueFatalIfFail("diskCache.ioQueueDepth",
+                              &diskCacheOption->ioQueueDepth);
 }
 
 void InitS3Option(Configuration *conf, S3Option *s3Opt) {
@@ -146,6 +150,14 @@ void InitS3Option(Configuration *conf, S3Option *s3Opt) {
                               &s3Opt->s3ClientAdaptorOpt.prefetchBlocks);
     conf->GetValueFatalIfFail("s3.prefetchExecQueueNum",
                               &s3Opt->s3ClientAdaptorOpt.prefetchExecQueueNum);
+    conf->GetValueFatalIfFail("s3.readParallelism",
+                              &s3Opt->s3ClientAdaptorOpt.readParallelism);
+    conf->GetValueFatalIfFail("s3.flushParallelism",
+                              &s3Opt->s3ClientAdaptorOpt.flushParallelism);
+    conf->GetValueFatalIfFail("s3.uploadParallelism",
+                              &s3Opt->s3ClientAdaptorOpt.uploadParallelism);
+    conf->GetValueFatalIfFail("s3.flushLowWatermark",
+                              &s3Opt->s3ClientAdaptorOpt.flushLowWatermark);
     conf->GetValueFatalIfFail("s3.intervalSec",
                               &s3Opt->s3ClientAdaptorOpt.intervalSec);
     conf->GetValueFatalIfFail("s3.flushIntervalSec",
@@ -196,10 +208,14 @@ void InitFuseClientOption(Configuration *conf, FuseClientOption *clientOption) {
                               &clientOption->attrTimeOut);
     conf->GetValueFatalIfFail("fuseClient.entryTimeOut",
                               &clientOption->entryTimeOut);
+    conf->GetValueFatalIfFail("fuseClient.negativeEntryTimeOut",
+                              &clientOption->negativeEntryTimeOut);
     conf->GetValueFatalIfFail("fuseClient.listDentryLimit",
                               &clientOption->listDentryLimit);
     conf->GetValueFatalIfFail("fuseClient.flushPeriodSec",
                               &clientOption->flushPeriodSec);
+    conf->GetValueFatalIfFail("fuseClient.openLeaseMs",
+                              &clientOption->openLeaseMs);
     conf->GetValueFatalIfFail("fuseClient.maxNameLength",
                               &clientOption->maxNameLength);
     conf->GetValueFatalIfFail("fuseClient.iCacheLruSize",
@@ -210,6 +226,20 @@ void InitFuseClientOption(Configuration *conf, FuseClientOption *clientOption) {
                               &clientOption->enableICacheMetrics);
     conf->GetValueFatalIfFail("fuseClient.enableDCacheMetrics",
                               &clientOption->enableDCacheMetrics);
+    conf->GetValueFatalIfFail("fuseClient.enableReaddirPlus",
+                              &clientOption->enableReaddirPlus);
+    conf->GetValueFatalIfFail("fuseClient.enableWritebackCache",
+                              &clientOption->enableWritebackCache);
+    conf->GetValueFatalIfFail("fuseClient.maxWriteSize",
+                              &clientOption->maxWriteSize);
+    conf->GetValueFatalIfFail("fuseClient.enableCompoundMetaOp",
+                              &clientOption->enableCompoundMetaOp);
+    conf->GetValueFatalIfFail("fuseClient.enableMetaserverRename",
+                              &clientOption->enableMetaserverRename);
+    conf->GetValueFatalIfFail("fuseClient.enableDirStat",
+                              &clientOption->enableDirStat);
+    conf->GetValueFatalIfFail("fuseClient.dirStatFlushIntervalMs",
+                              &clientOption->dirStatFlushIntervalMs);
 
     conf->GetValueFatalIfFail("client.dummyserver.startport",
                               &clientOption->dummyServerStartPort);
@@ -99,6 +99,10 @@ struct DiskCacheOption {
     uint64_t avgFlushIops;
     // the read throttle iops of disk cache
     uint64_t avgReadFileIops;
+    // threads doing disk cache io, 0 means io in the caller thread
+    uint32_t ioThreads;
+    // the max io requests queued for the cache disk
+    uint32_t ioQueueDepth;
 };
 
 struct S3ClientAdaptorOption {
@@ -108,6 +112,14 @@ struct S3ClientAdaptorOption {
     uint64_t pageSize;
     uint32_t prefetchBlocks;
     uint32_t prefetchExecQueueNum;
+    // max range gets in flight for one read, 1 means read serially
+    uint32_t readParallelism;
+    // files flushed concurrently, 1 means flush serially
+    uint32_t flushParallelism;
+    // max put requests in flight of the mount, 0 means no limit
+    uint32_t uploadParallelism;
+    // start flushing radically when write cache use ratio exceeds it
+    uint32_t flushLowWatermark;
     uint32_t intervalSec;
     uint32_t flushIntervalSec;
     uint64_t writeCacheMaxByte;
@@ -144,13 +156,22 @@ struct FuseClientOption {
 
     double attrTimeOut;
     double entryTimeOut;
+    double negativeEntryTimeOut;
     uint32_t listDentryLimit;
     uint32_t flushPeriodSec;
+    uint32_t openLeaseMs;
     uint32_t maxNameLength;
     uint64_t iCacheLruSize;
     uint64_t dCacheLruSize;
     bool enableICacheMetrics;
     bool enableDCacheMetrics;
+    bool enableReaddirPlus;
+    bool enableWritebackCache;
+    uint32_t maxWriteSize;
+    bool enableCompoundMetaOp;
+    bool enableMetaserverRename;
+    bool enableDirStat;
+    uint32_t dirStatFlushIntervalMs;
 
     uint32_t dummyServerStartPort;
 };
@@ -21,8 +21,11 @@
  * Author: xuchaojie
  */
 
+#include <string.h>
+
 #include <string>
 #include <memory>
+#include <vector>
 
 #include "curvefs/src/client/curve_fuse_op.h"
 #include "curvefs/src/client/fuse_client.h"
@@ -63,6 +66,42 @@ void EnableSplice(struct fuse_conn_info* conn) {
     }
 }
 
+void SetReaddirPlus(struct fuse_conn_info* conn, bool enable) {
+    if (!enable) {
+        conn->want &= ~FUSE_CAP_READDIRPLUS;
+        LOG(INFO) << "FUSE_CAP_READDIRPLUS disabled";
+        return;
+    }
+
+    // the dir buffer of an opened directory is built by either readdir
+    // or readdirplus, so never let kernel mix them in one directory stream
+    conn->want &= ~FUSE_CAP_READDIRPLUS_AUTO;
+    if (conn->capable & FUSE_CAP_READDIRPLUS) {
+        conn->want |= FUSE_CAP_READDIRPLUS;
+        LOG(INFO) << "FUSE_CAP_READDIRPLUS enabled";
+    }
+}
+
+bool EnableWritebackCache(struct fuse_conn_info* conn, bool enable) {
+    if (!enable) {
+        return false;
+    }
+    if (!(conn->capable & FUSE_CAP_WRITEBACK_CACHE)) {
+        LOG(WARNING) << "FUSE_CAP_WRITEBACK_CACHE is not supported by kernel";
+        return false;
+    }
+    conn->want |= FUSE_CAP_WRITEBACK_CACHE;
+    LOG(INFO) << "FUSE_CAP_WRITEBACK_CACHE enabled";
+    return true;
+}
+
+void SetMaxWrite(struct fuse_conn_info* conn, uint32_t maxWrite) {
+    // libfuse limits max_write to its receive buffer size (1MB since 3.6),
+    // and asks kernel for enough max_pages
+    conn->max_write = maxWrite;
+    LOG(INFO) << "max_write = " << conn->max_write;
+}
+
 }  // namespace
 
 int InitGlog(const char *confPath, const char *argv0) {
@@ -137,6 +176,10 @@ void FuseOpInit(void *userdata, struct fuse_conn_info *conn) {
     }
 
     EnableSplice(conn);
+    SetReaddirPlus(conn, fuseClientOption->enableReaddirPlus);
+    g_ClientInstance->SetWritebackCache(
+        EnableWritebackCache(conn, fuseClientOption->enableWritebackCache));
+    SetMaxWrite(conn, fuseClientOption->maxWriteSize);
 }
 
 void FuseOpDestroy(void *userdata) {
@@ -169,6 +212,12 @@ void FuseReplyErrByErrCode(fuse_req_t req, CURVEFS_ERROR errcode) {
     case CURVEFS_ERROR::NAMETOOLONG:
         fuse_reply_err(req, ENAMETOOLONG);
         break;
+    case CURVEFS_ERROR::NODATA:
+        fuse_reply_err(req, ENODATA);
+        break;
+    case CURVEFS_ERROR::OUT_OF_RANGE:
+        fuse_reply_err(req, ERANGE);
+        break;
     default:
         fuse_reply_err(req, EIO);
         break;
@@ -208,6 +257,19 @@ void FuseOpReadDir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
     fuse_reply_buf(req, buffer, rSize);
 }
 
+void FuseOpReadDirPlus(fuse_req_t req, fuse_ino_t ino, size_t size, off_t off,
+                       struct fuse_file_info *fi) {
+    char *buffer = nullptr;
+    size_t rSize = 0;
+    CURVEFS_ERROR ret = g_ClientInstance->FuseOpReadDirPlus(
+        req, ino, size, off, fi, &buffer, &rSize);
+    if (ret != CURVEFS_ERROR::OK) {
+        FuseReplyErrByErrCode(req, ret);
+        return;
+    }
+    fuse_reply_buf(req, buffer, rSize);
+}
+
 void FuseOpOpen(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
     CURVEFS_ERROR ret = g_ClientInstance->FuseOpOpen(req, ino, fi);
     if (ret != CURVEFS_ERROR::OK) {
@@ -250,6 +312,49 @@ void FuseOpWrite(fuse_req_t req, fuse_ino_t ino, const char *buf, size_t size,
     fuse_reply_write(req, wSize);
 }
 
+void FuseOpWriteBuf(fuse_req_t req, fuse_ino_t ino, struct fuse_bufvec *bufv,
+                    off_t off, struct fuse_file_info *fi) {
+    // with FUSE_CAP_SPLICE_READ, the data is in a pipe, copy it into a
+    // per-thread buffer directly, instead of libfuse allocating and filling
+    // a new buffer for each write request before calling write
+    static thread_local std::vector<char> buffer;
+
+    const char *data = nullptr;
+    size_t size = fuse_buf_size(bufv);
+    if (bufv->count == 1 && !(bufv->buf[0].flags & FUSE_BUF_IS_FD)) {
+        data = static_cast<const char *>(bufv->buf[0].mem) + bufv->off;
+        size -= bufv->off;
+    } else {
+        if (buffer.size() < size) {
+            buffer.resize(size);
+        }
+        struct fuse_bufvec dst;
+        memset(&dst, 0, sizeof(dst));
+        dst.count = 1;
+        dst.buf[0].size = size;
+        dst.buf[0].mem = buffer.data();
+        ssize_t res = fuse_buf_copy(&dst, bufv,
+                                    static_cast<fuse_buf_copy_flags>(0));
+        if (res < 0) {
+            LOG(ERROR) << "fuse_buf_copy failed, ino = " << ino
+                       << ", size = " << size << ", ret = " << res;
+            fuse_reply_err(req, -res);
+            return;
+        }
+        data = buffer.data();
+        size = res;
+    }
+
+    size_t wSize = 0;
+    CURVEFS_ERROR ret =
+        g_ClientInstance->FuseOpWrite(req, ino, data, size, off, fi, &wSize);
+    if (ret != CURVEFS_ERROR::OK) {
+        FuseReplyErrByErrCode(req, ret);
+        return;
+    }
+    fuse_reply_write(req, wSize);
+}
+
 void FuseOpCreate(fuse_req_t req, fuse_ino_t parent, const char *name,
                   mode_t mode, struct fuse_file_info *fi) {
     fuse_entry_param e;
@@ -373,6 +478,22 @@ void FuseOpReadLink(fuse_req_t req, fuse_ino_t ino) {
     fuse_reply_readlink(req, linkStr.c_str());
 }
 
+void FuseOpGetXattr(fuse_req_t req, fuse_ino_t ino, const char *name,
+                    size_t size) {
+    std::string value;
+    CURVEFS_ERROR ret =
+        g_ClientInstance->FuseOpGetXattr(req, ino, name, &value, size);
+    if (ret != CURVEFS_ERROR::OK) {
+        FuseReplyErrByErrCode(req, ret);
+        return;
+    }
+    if (size == 0) {
+        fuse_reply_xattr(req, value.size());
+    } else {
+        fuse_reply_buf(req, value.data(), value.size());
+    }
+}
+
 void FuseOpRelease(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi) {
     CURVEFS_ERROR ret = g_ClientInstance->FuseOpRelease(req, ino, fi);
     FuseReplyErrByErrCode(req, ret);
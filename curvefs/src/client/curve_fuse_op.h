@@ -190,6 +190,32 @@ void FuseOpSetAttr(fuse_req_t req, fuse_ino_t ino, struct stat *attr,
  */
 void FuseOpReadLink(fuse_req_t req, fuse_ino_t ino);
 
+/**
+ * Get an extended attribute
+ *
+ * If size is zero, the size of the value should be sent with
+ * fuse_reply_xattr.
+ *
+ * If the size is non-zero, and the value fits in the buffer, the
+ * value should be sent with fuse_reply_buf.
+ *
+ * If the size is too small for the value, the ERANGE error should
+ * be sent.
+ *
+ * Valid replies:
+ *   fuse_reply_buf
+ *   fuse_reply_data
+ *   fuse_reply_xattr
+ *   fuse_reply_err
+ *
+ * @param req request handle
+ * @param ino the inode number
+ * @param name of the extended attribute
+ * @param size maximum size of the value to send
+ */
+void FuseOpGetXattr(fuse_req_t req, fuse_ino_t ino, const char *name,
+                    size_t size);
+
 /**
  * Create file node
  *
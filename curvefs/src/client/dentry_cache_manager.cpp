@@ -28,35 +28,77 @@
 #include <utility>
 #include <unordered_map>
 
+#include "src/common/timeutility.h"
+
 using ::curvefs::metaserver::MetaStatusCode_Name;
 
 namespace curvefs {
 namespace client {
 
 using curve::common::WriteLockGuard;
+using curve::common::TimeUtility;
 using NameLockGuard = ::curve::common::GenericNameLockGuard<Mutex>;
 
 void DentryCacheManagerImpl::InsertOrReplaceCache(const Dentry &dentry) {
     std::string key = GetDentryCacheKey(dentry.parentinodeid(), dentry.name());
     NameLockGuard lock(nameLock_, key);
-    dCache_->Put(key, dentry);
+    DentryCacheKey cacheKey(dentry.parentinodeid(), dentry.name());
+    negativeCache_->Remove(cacheKey);
+    dCache_->Put(cacheKey, dentry);
 }
 
 void DentryCacheManagerImpl::DeleteCache(uint64_t parentId,
                                          const std::string &name) {
     std::string key = GetDentryCacheKey(parentId, name);
     NameLockGuard lock(nameLock_, key);
-    dCache_->Remove(key);
+    dCache_->Remove(DentryCacheKey(parentId, name));
+}
+
+bool DentryCacheManagerImpl::GetDentryFromCache(const DentryCacheKey &key,
+                                                const std::string &name,
+                                                Dentry *out,
+                                                CURVEFS_ERROR *ret) {
+    if (dCache_->Get(key, out) && out->name() == name) {
+        *ret = CURVEFS_ERROR::OK;
+        return true;
+    }
+
+    NegativeDentry negative;
+    if (negativeTimeoutMs_ > 0 && negativeCache_->Get(key, &negative) &&
+        negative.name == name &&
+        negative.expireTimeMs > TimeUtility::GetTimeofDayMs()) {
+        *ret = CURVEFS_ERROR::NOTEXIST;
+        return true;
+    }
+    return false;
+}
+
+void DentryCacheManagerImpl::PutNegativeCache(const DentryCacheKey &key,
+                                              const std::string &name) {
+    if (negativeTimeoutMs_ == 0) {
+        return;
+    }
+    NegativeDentry negative;
+    negative.name = name;
+    negative.expireTimeMs = TimeUtility::GetTimeofDayMs() + negativeTimeoutMs_;
+    negativeCache_->Put(key, negative);
 }
 
 CURVEFS_ERROR DentryCacheManagerImpl::GetDentry(uint64_t parent,
                                                 const std::string &name,
                                                 Dentry *out) {
+    // the lru cache is thread safe, lookups which hit the cache need not
+    // build the name lock key
+    DentryCacheKey cacheKey(parent, name);
+    CURVEFS_ERROR rc;
+    if (GetDentryFromCache(cacheKey, name, out, &rc)) {
+        return rc;
+    }
+
     std::string key = GetDentryCacheKey(parent, name);
     NameLockGuard lock(nameLock_, key);
-    bool ok = dCache_->Get(key, out);
-    if (ok) {
-        return CURVEFS_ERROR::OK;
+    if (GetDentryFromCache(cacheKey, name, out, &rc)) {
+        return rc;
     }
 
     MetaStatusCode ret = metaClient_->GetDentry(fsId_, parent, name, out);
@@ -65,16 +107,23 @@ CURVEFS_ERROR DentryCacheManagerImpl::GetDentry(uint64_t parent,
             << "metaClient_ GetDentry failed, MetaStatusCode = " << ret
             << ", MetaStatusCode_Name = " << MetaStatusCode_Name(ret)
             << ", parent = " << parent << ", name = " << name;
+        if (ret == MetaStatusCode::NOT_FOUND) {
+            PutNegativeCache(cacheKey, name);
+        }
         return MetaStatusCodeToCurvefsErrCode(ret);
     }
 
-    dCache_->Put(key, *out);
+    dCache_->Put(cacheKey, *out);
     return CURVEFS_ERROR::OK;
 }
 
 CURVEFS_ERROR DentryCacheManagerImpl::CreateDentry(const Dentry &dentry) {
     std::string key = GetDentryCacheKey(dentry.parentinodeid(), dentry.name());
     NameLockGuard lock(nameLock_, key);
+    DentryCacheKey cacheKey(dentry.parentinodeid(), dentry.name());
+    // drop the negative entry first, the name may be created even if
+    // the rpc fails (e.g. timeout)
+    negativeCache_->Remove(cacheKey);
     MetaStatusCode ret = metaClient_->CreateDentry(dentry);
     if (ret != MetaStatusCode::OK) {
         LOG(ERROR) << "metaClient_ CreateDentry failed, MetaStatusCode = "
@@ -85,7 +134,7 @@ CURVEFS_ERROR DentryCacheManagerImpl::CreateDentry(const Dentry &dentry) {
         return MetaStatusCodeToCurvefsErrCode(ret);
     }
 
-    dCache_->Put(key, dentry);
+    dCache_->Put(cacheKey, dentry);
     return CURVEFS_ERROR::OK;
 }
 
@@ -93,7 +142,8 @@ CURVEFS_ERROR DentryCacheManagerImpl::DeleteDentry(uint64_t parent,
                                                    const std::string &name) {
     std::string key = GetDentryCacheKey(parent, name);
     NameLockGuard lock(nameLock_, key);
-    dCache_->Remove(key);
+    DentryCacheKey cacheKey(parent, name);
+    dCache_->Remove(cacheKey);
 
     MetaStatusCode ret = metaClient_->DeleteDentry(fsId_, parent, name);
     if (ret != MetaStatusCode::OK && ret != MetaStatusCode::NOT_FOUND) {
@@ -102,6 +152,33 @@ CURVEFS_ERROR DentryCacheManagerImpl::DeleteDentry(uint64_t parent,
                    << ", parent = " << parent << ", name = " << name;
         return MetaStatusCodeToCurvefsErrCode(ret);
     }
+
+    PutNegativeCache(cacheKey, name);
+    return CURVEFS_ERROR::OK;
+}
+
+CURVEFS_ERROR DentryCacheManagerImpl::UnlinkDentryAndDecNlink(
+    uint64_t parent, const std::string &name, uint64_t inodeid) {
+    std::string key = GetDentryCacheKey(parent, name);
+    NameLockGuard lock(nameLock_, key);
+    DentryCacheKey cacheKey(parent, name);
+
+    MetaStatusCode ret =
+        metaClient_->UnlinkDentryAndDecNlink(fsId_, parent, name, inodeid);
+    if (ret == MetaStatusCode::PARTITION_ID_MISSMATCH) {
+        return CURVEFS_ERROR::NOTSUPPORT;
+    }
+    dCache_->Remove(cacheKey);
+    if (ret != MetaStatusCode::OK && ret != MetaStatusCode::NOT_FOUND) {
+        LOG(ERROR) << "metaClient_ UnlinkDentryAndDecNlink failed"
+                   << ", MetaStatusCode = " << ret
+                   << ", MetaStatusCode_Name = " << MetaStatusCode_Name(ret)
+                   << ", parent = " << parent << ", name = " << name
+                   << ", inodeid = " << inodeid;
+        return MetaStatusCodeToCurvefsErrCode(ret);
+    }
+
+    PutNegativeCache(cacheKey, name);
     return CURVEFS_ERROR::OK;
 }
 
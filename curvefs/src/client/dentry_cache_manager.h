@@ -24,6 +24,7 @@
 #ifndef CURVEFS_SRC_CLIENT_DENTRY_CACHE_MANAGER_H_
 #define CURVEFS_SRC_CLIENT_DENTRY_CACHE_MANAGER_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <list>
@@ -45,6 +46,43 @@ namespace client {
 using rpcclient::MetaServerClient;
 using rpcclient::MetaServerClientImpl;
 
+// key of dentry cache. the hash of name is used instead of the name itself
+// to avoid building a string on every lookup, so the name of the cached
+// entry should be checked when the cache hits.
+struct DentryCacheKey {
+    uint64_t parent;
+    uint64_t nameHash;
+
+    DentryCacheKey() : parent(0), nameHash(0) {}
+    DentryCacheKey(uint64_t parentId, const std::string &name)
+        : parent(parentId), nameHash(std::hash<std::string>()(name)) {}
+
+    bool operator==(const DentryCacheKey &other) const {
+        return parent == other.parent && nameHash == other.nameHash;
+    }
+};
+
+// a name known to be not exist under the parent
+struct NegativeDentry {
+    std::string name;
+    uint64_t expireTimeMs;
+};
+
+}  // namespace client
+}  // namespace curvefs
+
+namespace std {
+template <>
+struct hash<curvefs::client::DentryCacheKey> {
+    size_t operator()(const curvefs::client::DentryCacheKey &key) const {
+        return key.nameHash ^ (key.parent * 0x9e3779b97f4a7c15ULL);
+    }
+};
+}  // namespace std
+
+namespace curvefs {
+namespace client {
+
 class DentryCacheManager {
  public:
     DentryCacheManager() : fsId_(0) {}
@@ -54,7 +92,9 @@ class DentryCacheManager {
         fsId_ = fsId;
     }
 
-    virtual CURVEFS_ERROR Init(uint64_t cacheSize, bool enableCacheMetrics) = 0;
+    // names not found are cached for `negativeTimeoutMs`, 0 means disable
+    virtual CURVEFS_ERROR Init(uint64_t cacheSize, bool enableCacheMetrics,
+                               uint32_t negativeTimeoutMs) = 0;
 
     virtual void InsertOrReplaceCache(const Dentry& dentry) = 0;
 
@@ -68,6 +108,11 @@ class DentryCacheManager {
     virtual CURVEFS_ERROR DeleteDentry(uint64_t parent,
         const std::string &name) = 0;
 
+    // delete the dentry and decrease the nlink of its inode by one request,
+    // NOTSUPPORT is returned if they should be deleted separately
+    virtual CURVEFS_ERROR UnlinkDentryAndDecNlink(uint64_t parent,
+        const std::string &name, uint64_t inodeid) = 0;
+
     virtual CURVEFS_ERROR ListDentry(uint64_t parent,
         std::list<Dentry> *dentryList, uint32_t limit) = 0;
 
@@ -81,22 +126,33 @@ class DentryCacheManagerImpl : public DentryCacheManager {
  public:
     DentryCacheManagerImpl()
       : metaClient_(std::make_shared<MetaServerClientImpl>()),
-        dCache_(nullptr) {}
+        dCache_(nullptr),
+        negativeCache_(nullptr),
+        negativeTimeoutMs_(0) {}
 
     explicit DentryCacheManagerImpl(
         const std::shared_ptr<MetaServerClient> &metaClient)
       : metaClient_(metaClient),
-        dCache_(nullptr) {}
+        dCache_(nullptr),
+        negativeCache_(nullptr),
+        negativeTimeoutMs_(0) {}
 
-    CURVEFS_ERROR Init(uint64_t cacheSize, bool enableCacheMetrics) override {
+    CURVEFS_ERROR Init(uint64_t cacheSize, bool enableCacheMetrics,
+                       uint32_t negativeTimeoutMs) override {
         if (enableCacheMetrics) {
             dCache_ = std::make_shared<
-                LRUCache<std::string, Dentry>>(cacheSize,
+                LRUCache<DentryCacheKey, Dentry>>(cacheSize,
                     std::make_shared<CacheMetrics>("dcache"));
+            negativeCache_ = std::make_shared<
+                LRUCache<DentryCacheKey, NegativeDentry>>(cacheSize,
+                    std::make_shared<CacheMetrics>("dcache_negative"));
         } else {
             dCache_ = std::make_shared<
-                LRUCache<std::string, Dentry>>(cacheSize);
+                LRUCache<DentryCacheKey, Dentry>>(cacheSize);
+            negativeCache_ = std::make_shared<
+                LRUCache<DentryCacheKey, NegativeDentry>>(cacheSize);
         }
+        negativeTimeoutMs_ = negativeTimeoutMs;
         return CURVEFS_ERROR::OK;
     }
 
@@ -112,6 +168,9 @@ class DentryCacheManagerImpl : public DentryCacheManager {
     CURVEFS_ERROR DeleteDentry(uint64_t parent,
         const std::string &name) override;
 
+    CURVEFS_ERROR UnlinkDentryAndDecNlink(uint64_t parent,
+        const std::string &name, uint64_t inodeid) override;
+
     CURVEFS_ERROR ListDentry(uint64_t parent,
         std::list<Dentry> *dentryList, uint32_t limit) override;
 
@@ -119,10 +178,22 @@ class DentryCacheManagerImpl : public DentryCacheManager {
         return std::to_string(parent) + kDentryKeyDelimiter + name;
     }
 
+ private:
+    // get dentry from cache without rpc, return false if the cache misses.
+    // when hits, `ret` is NOTEXIST if the name is in the negative cache.
+    bool GetDentryFromCache(const DentryCacheKey &key, const std::string &name,
+                            Dentry *out, CURVEFS_ERROR *ret);
+
+    void PutNegativeCache(const DentryCacheKey &key, const std::string &name);
+
  private:
     std::shared_ptr<MetaServerClient> metaClient_;
-    // key is parentId + name
-    std::shared_ptr<LRUCache<std::string, Dentry>> dCache_;
+    std::shared_ptr<LRUCache<DentryCacheKey, Dentry>> dCache_;
+    // names not exist, so repeated lookups of them (e.g. searching PATH or
+    // python imports) do not go to metaserver until the entry expires
+    std::shared_ptr<LRUCache<DentryCacheKey, NegativeDentry>> negativeCache_;
+    uint32_t negativeTimeoutMs_;
+    // lock by parentId + name, to keep the cache consistent with metaserver
     curve::common::GenericNameLock<Mutex> nameLock_;
 };
 
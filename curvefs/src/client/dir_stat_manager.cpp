@@ -0,0 +1,241 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2022-06-27
+ * Author: chenwei
+ */
+
+#include "curvefs/src/client/dir_stat_manager.h"
+
+#include <butil/fast_rand.h>
+#include <glog/logging.h>
+
+#include <utility>
+
+namespace curvefs {
+namespace client {
+
+using ::curvefs::metaserver::FsFileType;
+using ::curvefs::metaserver::MetaStatusCode;
+using ::curvefs::metaserver::MetaStatusCode_Name;
+
+namespace {
+
+bool IsZero(const DirStat &stat) {
+    return stat.bytes() == 0 && stat.files() == 0 && stat.subdirs() == 0;
+}
+
+void Merge(const DirStat &delta, DirStat *stat) {
+    stat->set_bytes(stat->bytes() + delta.bytes());
+    stat->set_files(stat->files() + delta.files());
+    stat->set_subdirs(stat->subdirs() + delta.subdirs());
+}
+
+}  // namespace
+
+void DirStatManager::Start() {
+    if (isStop_.exchange(false)) {
+        flushThread_ = Thread(&DirStatManager::FlushLoop, this);
+        LOG(INFO) << "Start dir stat flush thread ok.";
+    }
+}
+
+void DirStatManager::Stop() {
+    if (!isStop_.exchange(true)) {
+        sleeper_.interrupt();
+        flushThread_.join();
+        Flush();
+        LOG(INFO) << "Stop dir stat flush thread ok.";
+    }
+}
+
+void DirStatManager::FlushLoop() {
+    while (sleeper_.wait_for(std::chrono::milliseconds(flushIntervalMs_))) {
+        Flush();
+    }
+}
+
+void DirStatManager::Flush() {
+    std::lock_guard<std::mutex> flushLock(flushMtx_);
+    // the failed deltas may be applied already, they're resent as they
+    // are with the same request ids
+    std::vector<Update> updates;
+    updates.swap(failed_);
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (const auto &item : pending_) {
+            updates.push_back({item.first, butil::fast_rand(), item.second});
+        }
+        pending_.clear();
+    }
+
+    // each round adds the deltas to the directories, and the deltas are
+    // merged by the parents returned for the next round
+    int depth = 0;
+    while (!updates.empty() && depth++ < kMaxDirDepth) {
+        std::unordered_map<uint64_t, DirStat> parents;
+        for (const auto &update : updates) {
+            if (IsZero(update.delta)) {
+                continue;
+            }
+
+            uint64_t parent = 0;
+            MetaStatusCode rc = metaClient_->UpdateDirStat(
+                fsId_, update.inodeId, update.delta, update.requestId, 0,
+                &parent, nullptr);
+            if (rc == MetaStatusCode::OK) {
+                if (parent != 0) {
+                    Merge(update.delta, &parents[parent]);
+                }
+            } else if (rc == MetaStatusCode::NOT_FOUND ||
+                       rc == MetaStatusCode::PARAM_ERROR) {
+                VLOG(3) << "UpdateDirStat of inode " << update.inodeId
+                        << " fail, the delta is dropped, rc = "
+                        << MetaStatusCode_Name(rc);
+            } else {
+                LOG(WARNING) << "UpdateDirStat of inode " << update.inodeId
+                             << " fail, retry later, rc = "
+                             << MetaStatusCode_Name(rc);
+                failed_.push_back(update);
+            }
+        }
+
+        updates.clear();
+        for (const auto &item : parents) {
+            updates.push_back({item.first, butil::fast_rand(), item.second});
+        }
+    }
+
+    LOG_IF(ERROR, !updates.empty())
+        << "Directories are deeper than " << kMaxDirDepth
+        << ", the deltas of " << updates.size()
+        << " directories are dropped";
+}
+
+void DirStatManager::Add(uint64_t inodeId, int64_t bytes, int64_t files,
+                         int64_t subdirs) {
+    if (inodeId == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    DirStat *stat = &pending_[inodeId];
+    stat->set_bytes(stat->bytes() + bytes);
+    stat->set_files(stat->files() + files);
+    stat->set_subdirs(stat->subdirs() + subdirs);
+}
+
+DirStat DirStatManager::GetPendingDelta(uint64_t inodeId) {
+    std::lock_guard<std::mutex> flushLock(flushMtx_);
+    std::lock_guard<std::mutex> lock(mtx_);
+    DirStat stat;
+    auto it = pending_.find(inodeId);
+    if (it != pending_.end()) {
+        stat = it->second;
+    }
+    for (const auto &update : failed_) {
+        if (update.inodeId == inodeId) {
+            Merge(update.delta, &stat);
+        }
+    }
+    return stat;
+}
+
+void DirStatManager::OnCreate(uint64_t parent, const InodeAttr &attr) {
+    if (attr.type() == FsFileType::TYPE_DIRECTORY) {
+        Add(parent, 0, 0, 1);
+    } else {
+        Add(parent, attr.length(), 1, 0);
+    }
+}
+
+void DirStatManager::OnLink(uint64_t parent, uint64_t owner) {
+    if (owner == 0) {
+        return;
+    }
+    Add(parent, 0, 1, 0);
+}
+
+void DirStatManager::OnUnlink(uint64_t parent, const InodeAttr &attr,
+                              uint64_t owner) {
+    if (owner == 0) {
+        return;
+    }
+    if (attr.type() == FsFileType::TYPE_DIRECTORY) {
+        Add(parent, 0, 0, -1);
+        return;
+    }
+    Add(parent, 0, -1, 0);
+    if (attr.nlink() <= 1) {
+        Add(owner, -static_cast<int64_t>(attr.length()), 0, 0);
+    }
+}
+
+void DirStatManager::OnRename(uint64_t parent, uint64_t newParent,
+                              const InodeAttr &attr, uint64_t owner,
+                              uint64_t *newOwner) {
+    *newOwner = owner;
+    if (owner == 0 || parent == newParent) {
+        return;
+    }
+
+    bool isDir = attr.type() == FsFileType::TYPE_DIRECTORY;
+    if (!isDir) {
+        Add(parent, 0, -1, 0);
+        Add(newParent, 0, 1, 0);
+        if (owner != parent) {
+            // counted in the directory of another link
+            return;
+        }
+    }
+
+    // reparent the inode first, so the deltas flushed to it from now on
+    // go to the new parent, and the stats returned are the ones to move
+    uint64_t unused = 0;
+    DirStat stat;
+    MetaStatusCode rc = metaClient_->UpdateDirStat(
+        fsId_, attr.inodeid(), DirStat(), 0, newParent, &unused, &stat);
+    if (rc != MetaStatusCode::OK) {
+        LOG(ERROR) << "Reparent inode " << attr.inodeid() << " from "
+                   << parent << " to " << newParent
+                   << " fail, it's still counted in the old one, rc = "
+                   << MetaStatusCode_Name(rc);
+        return;
+    }
+    *newOwner = newParent;
+
+    if (isDir) {
+        Add(parent, -stat.bytes(), -stat.files(), -stat.subdirs() - 1);
+        Add(newParent, stat.bytes(), stat.files(), stat.subdirs() + 1);
+    } else {
+        int64_t length = attr.length();
+        Add(parent, -length, 0, 0);
+        Add(newParent, length, 0, 0);
+    }
+}
+
+void DirStatManager::OnLengthChange(uint64_t owner, uint64_t oldLength,
+                                    uint64_t newLength) {
+    if (owner == 0 || oldLength == newLength) {
+        return;
+    }
+    Add(owner, static_cast<int64_t>(newLength) -
+                   static_cast<int64_t>(oldLength), 0, 0);
+}
+
+}  // namespace client
+}  // namespace curvefs
@@ -0,0 +1,150 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2022-06-27
+ * Author: chenwei
+ */
+
+#ifndef CURVEFS_SRC_CLIENT_DIR_STAT_MANAGER_H_
+#define CURVEFS_SRC_CLIENT_DIR_STAT_MANAGER_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "curvefs/src/client/rpcclient/metaserver_client.h"
+#include "src/common/concurrent/concurrent.h"
+#include "src/common/interruptible_sleeper.h"
+
+namespace curvefs {
+namespace client {
+
+using ::curve::common::Atomic;
+using ::curve::common::InterruptibleSleeper;
+using ::curve::common::Thread;
+using ::curvefs::metaserver::DirStat;
+using ::curvefs::metaserver::InodeAttr;
+using rpcclient::MetaServerClient;
+
+// the xattrs of directory to get its recursive stats
+const char kXattrDirRBytes[] = "curve.dir.rbytes";
+const char kXattrDirRFiles[] = "curve.dir.rfiles";
+const char kXattrDirRSubdirs[] = "curve.dir.rsubdirs";
+const char kXattrDirREntries[] = "curve.dir.rentries";  // files + subdirs
+
+// the deeper directories are not propagated to avoid endless loop when
+// the parents form a cycle by concurrent renames
+const int kMaxDirDepth = 4096;
+
+// Maintain the recursive stats (bytes, files and subdirs under it) of the
+// directories incrementally. The namespace changes made by this client are
+// collected as deltas of their parents, and flushed to metaserver in
+// background, each directory returns its parent and the delta is added to
+// the parent in the next round, up to root. Each delta sent carries a random
+// request id, and a failed one is resent with the same id rather than merged
+// into the new deltas, so metaserver adds it once even if it was applied.
+//
+// The bytes of a file are counted in `parent` of the inode rather than the
+// directories holding its dentrys, so a hard linked file is counted once.
+// The inodes without `parent` are created before dir stats, and are not
+// counted at all.
+class DirStatManager {
+ public:
+    explicit DirStatManager(const std::shared_ptr<MetaServerClient> &metaClient)
+        : metaClient_(metaClient), fsId_(0), flushIntervalMs_(1000),
+          isStop_(true) {}
+
+    virtual ~DirStatManager() { Stop(); }
+
+    void Init(uint32_t flushIntervalMs) {
+        flushIntervalMs_ = flushIntervalMs;
+    }
+
+    void SetFsId(uint32_t fsId) {
+        fsId_ = fsId;
+    }
+
+    void Start();
+
+    // stop the background flush, the pending deltas are flushed
+    void Stop();
+
+    // flush the pending deltas up to root
+    void Flush();
+
+    // `attr` is the new inode
+    void OnCreate(uint64_t parent, const InodeAttr &attr);
+
+    // a link of inode is created under `parent`, whose `owner` is the
+    // directory it's counted in
+    void OnLink(uint64_t parent, uint64_t owner);
+
+    // `attr` is the inode before unlink
+    void OnUnlink(uint64_t parent, const InodeAttr &attr, uint64_t owner);
+
+    // called after the dentry is renamed from `parent` to `newParent`,
+    // the stats of a directory or the bytes of a file owned by `parent`
+    // are moved to `newParent` and the inode is reparented, `newOwner`
+    // is set to the directory the inode is counted in after rename
+    void OnRename(uint64_t parent, uint64_t newParent, const InodeAttr &attr,
+                  uint64_t owner, uint64_t *newOwner);
+
+    void OnLengthChange(uint64_t owner, uint64_t oldLength,
+                        uint64_t newLength);
+
+    // the delta not flushed yet, for test
+    DirStat GetPendingDelta(uint64_t inodeId);
+
+ private:
+    struct Update {
+        uint64_t inodeId;
+        uint64_t requestId;
+        DirStat delta;
+    };
+
+    void Add(uint64_t inodeId, int64_t bytes, int64_t files,
+             int64_t subdirs);
+
+    void FlushLoop();
+
+ private:
+    std::shared_ptr<MetaServerClient> metaClient_;
+    uint32_t fsId_;
+    uint32_t flushIntervalMs_;
+
+    std::mutex mtx_;
+    // deltas to be added to the directories
+    std::unordered_map<uint64_t, DirStat> pending_;
+
+    // only one flush runs at a time
+    std::mutex flushMtx_;
+    // the deltas failed to flush, resent by the next flush, guarded by
+    // flushMtx_
+    std::vector<Update> failed_;
+
+    Atomic<bool> isStop_;
+    InterruptibleSleeper sleeper_;
+    Thread flushThread_;
+};
+
+}  // namespace client
+}  // namespace curvefs
+
+#endif  // CURVEFS_SRC_CLIENT_DIR_STAT_MANAGER_H_
@@ -47,6 +47,8 @@ std::map<CURVEFS_ERROR, std::string> err2Msg = {
     {CURVEFS_ERROR::NAMETOOLONG, "name too long"},
     {CURVEFS_ERROR::MOUNT_POINT_EXIST, "mount point already exist"},
     {CURVEFS_ERROR::MOUNT_FAILED, "mount failed"},
+    {CURVEFS_ERROR::NODATA, "no data available"},
+    {CURVEFS_ERROR::OUT_OF_RANGE, "out of range"},
 };
 
 std::ostream &operator<<(std::ostream &os, CURVEFS_ERROR code) {
@@ -26,6 +26,8 @@
 #include <list>
 #include <algorithm>
 #include <cstring>
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -43,6 +45,7 @@ using ::curvefs::common::S3Info;
 using ::curvefs::common::Volume;
 using ::curvefs::mds::topology::PartitionTxId;
 using ::curvefs::mds::FSStatusCode_Name;
+using ::curvefs::metaserver::MetaStatusCode_Name;
 
 #define RETURN_IF_UNSUCCESS(action)                                            \
     do {                                                                       \
@@ -99,8 +102,10 @@ CURVEFS_ERROR FuseClient::Init(const FuseClientOption &option) {
     if (ret3 != CURVEFS_ERROR::OK) {
         return ret3;
     }
-    ret3 =
-        dentryManager_->Init(option.dCacheLruSize, option.enableDCacheMetrics);
+    ret3 = dentryManager_->Init(
+        option.dCacheLruSize, option.enableDCacheMetrics,
+        static_cast<uint32_t>(option.negativeEntryTimeOut * 1000));
+    dirStatManager_->Init(option.dirStatFlushIntervalMs);
     return ret3;
 }
 
@@ -113,6 +118,9 @@ CURVEFS_ERROR FuseClient::Run() {
     if (isStop_.exchange(false)) {
         flushThread_ = Thread(&FuseClient::FlushInodeLoop, this);
         LOG(INFO) << "Start fuse client flush thread ok.";
+        if (option_.enableDirStat) {
+            dirStatManager_->Start();
+        }
         return CURVEFS_ERROR::OK;
     }
     return CURVEFS_ERROR::INTERNAL;
@@ -123,6 +131,7 @@ void FuseClient::Fini() {
         LOG(INFO) << "stop fuse client flush thread ...";
         sleeper_.interrupt();
         flushThread_.join();
+        dirStatManager_->Stop();
     }
     LOG(INFO) << "stop fuse client flush thread ok.";
 }
@@ -179,6 +188,7 @@ CURVEFS_ERROR FuseClient::FuseOpInit(void *userdata,
     fsInfo_ = std::make_shared<FsInfo>(fsInfo);
     inodeManager_->SetFsId(fsInfo.fsid());
     dentryManager_->SetFsId(fsInfo.fsid());
+    dirStatManager_->SetFsId(fsInfo.fsid());
     LOG(INFO) << "Mount " << fsName << " on " << mountPointWithHost
               << " success!";
 
@@ -195,6 +205,9 @@ void FuseClient::FuseOpDestroy(void *userdata) {
     }
 
     FlushAll();
+    if (option_.enableDirStat) {
+        dirStatManager_->Flush();
+    }
     dirBuf_->DirBufferFreeAll();
 
     struct MountOption *mOpts = (struct MountOption *)userdata;
@@ -233,6 +246,16 @@ void FuseClient::GetDentryParamFromInode(
     param->entry_timeout = option_.entryTimeOut;
 }
 
+void FuseClient::GetDentryParamFromInodeAttr(const InodeAttr &attr,
+                                             fuse_entry_param *param) {
+    memset(param, 0, sizeof(fuse_entry_param));
+    param->ino = attr.inodeid();
+    param->generation = 0;
+    InodeAttrToStat(attr, &param->attr);
+    param->attr_timeout = option_.attrTimeOut;
+    param->entry_timeout = option_.entryTimeOut;
+}
+
 CURVEFS_ERROR FuseClient::FuseOpLookup(fuse_req_t req, fuse_ino_t parent,
                                        const char *name, fuse_entry_param *e) {
     VLOG(1) << "FuseOpLookup parent: " << parent
@@ -242,6 +265,14 @@ CURVEFS_ERROR FuseClient::FuseOpLookup(fuse_req_t req, fuse_ino_t parent,
     }
     Dentry dentry;
     CURVEFS_ERROR ret = dentryManager_->GetDentry(parent, name, &dentry);
+    if (ret == CURVEFS_ERROR::NOTEXIST && option_.negativeEntryTimeOut > 0) {
+        // reply a negative entry, so that the kernel caches the name
+        // as not exist and later lookups do not come to client
+        memset(e, 0, sizeof(fuse_entry_param));
+        e->ino = 0;
+        e->entry_timeout = option_.negativeEntryTimeOut;
+        return CURVEFS_ERROR::OK;
+    }
     if (ret != CURVEFS_ERROR::OK) {
         if (ret != CURVEFS_ERROR::NOTEXIST) {
             LOG(WARNING) << "dentryManager_ get dentry fail, ret = " << ret
@@ -250,15 +281,15 @@ CURVEFS_ERROR FuseClient::FuseOpLookup(fuse_req_t req, fuse_ino_t parent,
         }
         return ret;
     }
-    std::shared_ptr<InodeWrapper> inodeWrapper;
+    InodeAttr attr;
     fuse_ino_t ino = dentry.inodeid();
-    ret = inodeManager_->GetInode(ino, inodeWrapper);
+    ret = inodeManager_->GetInodeAttr(ino, &attr);
     if (ret != CURVEFS_ERROR::OK) {
-        LOG(ERROR) << "inodeManager get inode fail, ret = " << ret
+        LOG(ERROR) << "inodeManager get inode attr fail, ret = " << ret
                    << ", inodeid = " << ino;
         return ret;
     }
-    GetDentryParamFromInode(inodeWrapper, e);
+    GetDentryParamFromInodeAttr(attr, e);
     return ret;
 }
 
@@ -275,10 +306,12 @@ CURVEFS_ERROR FuseClient::FuseOpOpen(fuse_req_t req, fuse_ino_t ino,
 
     ::curve::common::UniqueLock lgGuard = inodeWrapper->GetUniqueLock();
 
-    ret = inodeWrapper->Open();
+    bool keepCache = false;
+    ret = inodeWrapper->Open(&keepCache);
     if (ret != CURVEFS_ERROR::OK) {
         return ret;
     }
+    fi->keep_cache = keepCache && !(fi->flags & O_TRUNC);
 
     if (fi->flags & O_TRUNC) {
         if (fi->flags & O_WRONLY || fi->flags & O_RDWR) {
@@ -308,6 +341,61 @@ CURVEFS_ERROR FuseClient::FuseOpOpen(fuse_req_t req, fuse_ino_t ino,
     return ret;
 }
 
+CURVEFS_ERROR FuseClient::CreateInodeWithDentry(
+    const InodeParam &param, Dentry *dentry,
+    std::shared_ptr<InodeWrapper> &inodeWrapper) {
+    CURVEFS_ERROR ret;
+    if (option_.enableCompoundMetaOp) {
+        ret = inodeManager_->CreateInodeAndDentry(param, dentry, inodeWrapper);
+        if (ret == CURVEFS_ERROR::OK) {
+            dentryManager_->InsertOrReplaceCache(*dentry);
+            VLOG(6) << "inodeManager CreateInodeAndDentry success"
+                    << ", parent = " << dentry->parentinodeid()
+                    << ", name = " << dentry->name()
+                    << ", inode id = " << dentry->inodeid();
+            return ret;
+        } else if (ret != CURVEFS_ERROR::NOTSUPPORT) {
+            LOG(ERROR) << "inodeManager CreateInodeAndDentry fail, ret = "
+                       << ret << ", parent = " << dentry->parentinodeid()
+                       << ", name = " << dentry->name()
+                       << ", mode = " << param.mode;
+            return ret;
+        }
+        // the partition of parent can't hold the inode, create them apart
+    }
+
+    ret = inodeManager_->CreateInode(param, inodeWrapper);
+    if (ret != CURVEFS_ERROR::OK) {
+        LOG(ERROR) << "inodeManager CreateInode fail, ret = " << ret
+                   << ", parent = " << dentry->parentinodeid()
+                   << ", name = " << dentry->name()
+                   << ", mode = " << param.mode;
+        return ret;
+    }
+
+    VLOG(6) << "inodeManager CreateInode success"
+            << ", parent = " << dentry->parentinodeid()
+            << ", name = " << dentry->name() << ", mode = " << param.mode
+            << ", inode id = " << inodeWrapper->GetInodeId();
+
+    dentry->set_inodeid(inodeWrapper->GetInodeId());
+    ret = dentryManager_->CreateDentry(*dentry);
+    if (ret != CURVEFS_ERROR::OK) {
+        LOG(ERROR) << "dentryManager_ CreateDentry fail, ret = " << ret
+                   << ", parent = " << dentry->parentinodeid()
+                   << ", name = " << dentry->name()
+                   << ", mode = " << param.mode;
+
+        CURVEFS_ERROR ret2 =
+            inodeManager_->DeleteInode(inodeWrapper->GetInodeId());
+        if (ret2 != CURVEFS_ERROR::OK) {
+            LOG(ERROR) << "Also delete inode failed, ret = " << ret2
+                       << ", inodeid = " << inodeWrapper->GetInodeId();
+        }
+    }
+    return ret;
+}
+
 CURVEFS_ERROR FuseClient::MakeNode(fuse_req_t req, fuse_ino_t parent,
                                    const char *name, mode_t mode,
                                    FsFileType type, dev_t rdev,
@@ -328,44 +416,26 @@ CURVEFS_ERROR FuseClient::MakeNode(fuse_req_t req, fuse_ino_t parent,
     param.mode = mode;
     param.type = type;
     param.rdev = rdev;
-
-    std::shared_ptr<InodeWrapper> inodeWrapper;
-    CURVEFS_ERROR ret = inodeManager_->CreateInode(param, inodeWrapper);
-    if (ret != CURVEFS_ERROR::OK) {
-        LOG(ERROR) << "inodeManager CreateInode fail, ret = " << ret
-                   << ", parent = " << parent << ", name = " << name
-                   << ", mode = " << mode;
-        return ret;
-    }
-
-    VLOG(6) << "inodeManager CreateInode success"
-            << ", parent = " << parent << ", name = " << name
-            << ", mode = " << mode
-            << ", inode id = " << inodeWrapper->GetInodeId();
+    param.parent = parent;
 
     Dentry dentry;
     dentry.set_fsid(fsInfo_->fsid());
-    dentry.set_inodeid(inodeWrapper->GetInodeId());
     dentry.set_parentinodeid(parent);
     dentry.set_name(name);
     if (type == FsFileType::TYPE_FILE || type == FsFileType::TYPE_S3) {
         dentry.set_flag(DentryFlag::TYPE_FILE_FLAG);
     }
 
-    ret = dentryManager_->CreateDentry(dentry);
+    std::shared_ptr<InodeWrapper> inodeWrapper;
+    CURVEFS_ERROR ret = CreateInodeWithDentry(param, &dentry, inodeWrapper);
     if (ret != CURVEFS_ERROR::OK) {
-        LOG(ERROR) << "dentryManager_ CreateDentry fail, ret = " << ret
-                   << ", parent = " << parent << ", name = " << name
-                   << ", mode = " << mode;
-
-        CURVEFS_ERROR ret2 =
-            inodeManager_->DeleteInode(inodeWrapper->GetInodeId());
-        if (ret2 != CURVEFS_ERROR::OK) {
-            LOG(ERROR) << "Also delete inode failed, ret = " << ret2
-                       << ", inodeid = " << inodeWrapper->GetInodeId();
-        }
         return ret;
     }
+    if (option_.enableDirStat) {
+        InodeAttr attr;
+        inodeWrapper->GetInodeAttrLocked(&attr);
+        dirStatManager_->OnCreate(parent, attr);
+    }
 
     std::shared_ptr<InodeWrapper> parentInodeWrapper;
     ret = inodeManager_->GetInode(parent, parentInodeWrapper);
@@ -443,11 +513,44 @@ CURVEFS_ERROR FuseClient::RemoveNode(fuse_req_t req, fuse_ino_t parent,
         }
     }
 
-    ret = dentryManager_->DeleteDentry(parent, name);
-    if (ret != CURVEFS_ERROR::OK) {
-        LOG(ERROR) << "dentryManager_ DeleteDentry fail, ret = " << ret
-                   << ", parent = " << parent << ", name = " << name;
-        return ret;
+    // the inode before unlink, for dir stats, the attributes are mostly
+    // cached by the lookup before, and only they are fetched if not
+    InodeAttr attr;
+    uint64_t owner = 0;
+    if (option_.enableDirStat) {
+        ret = inodeManager_->GetInodeAttr(ino, &attr);
+        if (ret != CURVEFS_ERROR::OK) {
+            LOG(ERROR) << "inodeManager get inode attr fail, ret = " << ret
+                       << ", inodeid = " << ino;
+            return ret;
+        }
+        owner = attr.parent();
+    }
+
+    bool unlinked = false;
+    if (option_.enableCompoundMetaOp) {
+        ret = dentryManager_->UnlinkDentryAndDecNlink(parent, name, ino);
+        if (ret == CURVEFS_ERROR::OK) {
+            unlinked = true;
+        } else if (ret != CURVEFS_ERROR::NOTSUPPORT) {
+            LOG(ERROR) << "dentryManager_ UnlinkDentryAndDecNlink fail"
+                       << ", ret = " << ret << ", parent = " << parent
+                       << ", name = " << name << ", inodeid = " << ino;
+            return ret;
+        }
+        // the inode isn't in the partition of parent, unlink them apart
+    }
+
+    if (!unlinked) {
+        ret = dentryManager_->DeleteDentry(parent, name);
+        if (ret != CURVEFS_ERROR::OK) {
+            LOG(ERROR) << "dentryManager_ DeleteDentry fail, ret = " << ret
+                       << ", parent = " << parent << ", name = " << name;
+            return ret;
+        }
+    }
+    if (option_.enableDirStat) {
+        dirStatManager_->OnUnlink(parent, attr, owner);
     }
 
     std::shared_ptr<InodeWrapper> parentInodeWrapper;
@@ -464,19 +567,22 @@ CURVEFS_ERROR FuseClient::RemoveNode(fuse_req_t req, fuse_ino_t parent,
         return ret;
     }
 
-    std::shared_ptr<InodeWrapper> inodeWrapper;
-    ret = inodeManager_->GetInode(ino, inodeWrapper);
-    if (ret != CURVEFS_ERROR::OK) {
-        LOG(ERROR) << "inodeManager get inode fail, ret = " << ret
-                   << ", inodeid = " << ino;
-        return ret;
-    }
+    if (!unlinked) {
+        std::shared_ptr<InodeWrapper> inodeWrapper;
+        ret = inodeManager_->GetInode(ino, inodeWrapper);
+        if (ret != CURVEFS_ERROR::OK) {
+            LOG(ERROR) << "inodeManager get inode fail, ret = " << ret
+                       << ", inodeid = " << ino;
+            return ret;
+        }
 
-    // also return ok even if unlink failed.
-    ret = inodeWrapper->UnLinkLocked();
-    if (ret != CURVEFS_ERROR::OK) {
-        LOG(ERROR) << "UnLink failed, ret = " << ret << ", inodeid = " << ino
-                   << ", parent = " << parent << ", name = " << name;
+        // also return ok even if unlink failed.
+        ret = inodeWrapper->UnLinkLocked();
+        if (ret != CURVEFS_ERROR::OK) {
+            LOG(ERROR) << "UnLink failed, ret = " << ret
+                       << ", inodeid = " << ino << ", parent = " << parent
+                       << ", name = " << name;
+        }
     }
     inodeManager_->ClearInodeCache(ino);
     return CURVEFS_ERROR::OK;
@@ -521,12 +627,48 @@ static void dirbuf_add(fuse_req_t req, struct DirBufferHead *b,
                       dentry.name().c_str(), &stbuf, b->size);
 }
 
+void FuseClient::DirBufferAddPlus(fuse_req_t req, DirBufferHead *b,
+                                  const Dentry &dentry,
+                                  const InodeAttr *attr) {
+    fuse_entry_param param;
+    if (attr != nullptr) {
+        GetDentryParamFromInodeAttr(*attr, &param);
+    } else {
+        // zero ino tells the kernel no attributes are returned
+        memset(&param, 0, sizeof(param));
+        param.attr.st_ino = dentry.inodeid();
+    }
+    size_t oldsize = b->size;
+    b->size += fuse_add_direntry_plus(req, NULL, 0, dentry.name().c_str(),
+                                      NULL, 0);
+    b->p = static_cast<char *>(realloc(b->p, b->size));
+    fuse_add_direntry_plus(req, b->p + oldsize, b->size - oldsize,
+                           dentry.name().c_str(), &param, b->size);
+}
+
 CURVEFS_ERROR FuseClient::FuseOpReadDir(fuse_req_t req, fuse_ino_t ino,
                                         size_t size, off_t off,
                                         struct fuse_file_info *fi,
                                         char **buffer, size_t *rSize) {
     VLOG(6) << "FuseOpReadDir ino: " << ino << ", size: " << size
             << ", off = " << off;
+    return ReadDirInternal(req, ino, size, off, fi, buffer, rSize, false);
+}
+
+CURVEFS_ERROR FuseClient::FuseOpReadDirPlus(fuse_req_t req, fuse_ino_t ino,
+                                            size_t size, off_t off,
+                                            struct fuse_file_info *fi,
+                                            char **buffer, size_t *rSize) {
+    VLOG(6) << "FuseOpReadDirPlus ino: " << ino << ", size: " << size
+            << ", off = " << off;
+    return ReadDirInternal(req, ino, size, off, fi, buffer, rSize, true);
+}
+
+CURVEFS_ERROR FuseClient::ReadDirInternal(fuse_req_t req, fuse_ino_t ino,
+                                          size_t size, off_t off,
+                                          struct fuse_file_info *fi,
+                                          char **buffer, size_t *rSize,
+                                          bool plus) {
     std::shared_ptr<InodeWrapper> inodeWrapper;
     CURVEFS_ERROR ret = inodeManager_->GetInode(ino, inodeWrapper);
     if (ret != CURVEFS_ERROR::OK) {
@@ -548,8 +690,15 @@ CURVEFS_ERROR FuseClient::FuseOpReadDir(fuse_req_t req, fuse_ino_t ino,
                        << ", parent = " << ino;
             return ret;
         }
-        for (const auto &dentry : dentryList) {
-            dirbuf_add(req, bufHead, dentry);
+        if (plus) {
+            ret = FillDirBufferPlus(req, bufHead, dentryList);
+            if (ret != CURVEFS_ERROR::OK) {
+                return ret;
+            }
+        } else {
+            for (const auto &dentry : dentryList) {
+                dirbuf_add(req, bufHead, dentry);
+            }
         }
         bufHead->wasRead = true;
     }
@@ -563,6 +712,48 @@ CURVEFS_ERROR FuseClient::FuseOpReadDir(fuse_req_t req, fuse_ino_t ino,
     return ret;
 }
 
+CURVEFS_ERROR FuseClient::FillDirBufferPlus(fuse_req_t req,
+                                            DirBufferHead *bufHead,
+                                            const std::list<Dentry> &dentrys) {
+    // get attributes page by page, so a huge directory
+    // will not issue a huge batch at once
+    uint32_t limit = option_.listDentryLimit;
+    auto iter = dentrys.begin();
+    while (iter != dentrys.end()) {
+        auto pageBegin = iter;
+        std::set<uint64_t> inodeIds;
+        for (uint32_t count = 0; iter != dentrys.end() && count < limit;
+             ++iter, ++count) {
+            inodeIds.insert(iter->inodeid());
+        }
+
+        std::map<uint64_t, InodeAttr> attrs;
+        CURVEFS_ERROR ret = inodeManager_->BatchGetInodeAttr(inodeIds, &attrs);
+        if (ret != CURVEFS_ERROR::OK) {
+            LOG(ERROR) << "inodeManager BatchGetInodeAttr fail, ret = " << ret
+                       << ", inode count = " << inodeIds.size();
+            return ret;
+        }
+
+        for (auto it = pageBegin; it != iter; ++it) {
+            auto attr = attrs.find(it->inodeid());
+            if (attr == attrs.end()) {
+                // the inode may be deleted after listing dentry, or its
+                // partition is unknown, the entry is still listed as
+                // readdir does
+                VLOG(3) << "inode not found when readdirplus"
+                        << ", inodeid = " << it->inodeid()
+                        << ", name = " << it->name();
+                DirBufferAddPlus(req, bufHead, *it, nullptr);
+                continue;
+            }
+            dentryManager_->InsertOrReplaceCache(*it);
+            DirBufferAddPlus(req, bufHead, *it, &attr->second);
+        }
+    }
+    return CURVEFS_ERROR::OK;
+}
+
 CURVEFS_ERROR FuseClient::FuseOpRename(fuse_req_t req, fuse_ino_t parent,
                                        const char *name, fuse_ino_t newparent,
                                        const char *newname) {
@@ -576,12 +767,46 @@ CURVEFS_ERROR FuseClient::FuseOpRename(fuse_req_t req, fuse_ino_t parent,
         RenameOperator(fsInfo_->fsid(), parent, name, newparent, newname,
                        dentryManager_, inodeManager_, metaClient_, mdsClient_);
 
-    curve::common::LockGuard lg(renameMutex_);
+    // the renames on the same names are serialized, otherwise two renames
+    // onto one target both find and unlink the inode overwritten
+    std::string srcKey = std::to_string(parent) + "/" + name;
+    std::string dstKey = std::to_string(newparent) + "/" + newname;
+    if (dstKey < srcKey) {
+        std::swap(srcKey, dstKey);
+    }
+    curve::common::NameLockGuard firstGuard(renameNameLock_, srcKey);
+    std::unique_ptr<curve::common::NameLockGuard> secondGuard;
+    if (dstKey != srcKey) {
+        secondGuard.reset(
+            new curve::common::NameLockGuard(renameNameLock_, dstKey));
+    }
+
     CURVEFS_ERROR rc = CURVEFS_ERROR::OK;
+    if (option_.enableMetaserverRename) {
+        curve::common::ReadLockGuard rlg(renameLock_);
+        RETURN_IF_UNSUCCESS(GetTxId);
+        RETURN_IF_UNSUCCESS(Precheck);
+        rc = renameOp.Rename();
+        if (rc == CURVEFS_ERROR::OK) {
+            if (option_.enableDirStat) {
+                renameOp.UpdateDirStat(dirStatManager_);
+            }
+            renameOp.UnlinkOldInode();
+            renameOp.UpdateCache();
+            return rc;
+        } else if (rc != CURVEFS_ERROR::NOTSUPPORT) {
+            return rc;
+        }
+    }
+
+    curve::common::WriteLockGuard wlg(renameLock_);
     RETURN_IF_UNSUCCESS(GetTxId);
     RETURN_IF_UNSUCCESS(Precheck);
     RETURN_IF_UNSUCCESS(PrepareTx);
     RETURN_IF_UNSUCCESS(CommitTx);
+    if (option_.enableDirStat) {
+        renameOp.UpdateDirStat(dirStatManager_);
+    }
     renameOp.UnlinkOldInode();
     renameOp.UpdateCache();
     return rc;
@@ -590,14 +815,14 @@ CURVEFS_ERROR FuseClient::FuseOpRename(fuse_req_t req, fuse_ino_t parent,
 CURVEFS_ERROR FuseClient::FuseOpGetAttr(fuse_req_t req, fuse_ino_t ino,
                                         struct fuse_file_info *fi,
                                         struct stat *attr) {
-    std::shared_ptr<InodeWrapper> inodeWrapper;
-    CURVEFS_ERROR ret = inodeManager_->GetInode(ino, inodeWrapper);
+    InodeAttr inodeAttr;
+    CURVEFS_ERROR ret = inodeManager_->GetInodeAttr(ino, &inodeAttr);
     if (ret != CURVEFS_ERROR::OK) {
-        LOG(ERROR) << "inodeManager get inode fail, ret = " << ret
+        LOG(ERROR) << "inodeManager get inode attr fail, ret = " << ret
                    << ", inodeid = " << ino;
         return ret;
     }
-    inodeWrapper->GetInodeAttrLocked(attr);
+    InodeAttrToStat(inodeAttr, attr);
     return ret;
 }
 
@@ -655,6 +880,7 @@ CURVEFS_ERROR FuseClient::FuseOpSetAttr(fuse_req_t req, fuse_ino_t ino,
         inode->set_ctime_ns(now.tv_nsec);
     }
     if (to_set & FUSE_SET_ATTR_SIZE) {
+        uint64_t oldLength = inode->length();
         CURVEFS_ERROR tRet = Truncate(inode, attr->st_size);
         if (tRet != CURVEFS_ERROR::OK) {
             LOG(ERROR) << "truncate file fail, ret = " << ret
@@ -662,6 +888,10 @@ CURVEFS_ERROR FuseClient::FuseOpSetAttr(fuse_req_t req, fuse_ino_t ino,
             return tRet;
         }
         inode->set_length(attr->st_size);
+        if (option_.enableDirStat) {
+            dirStatManager_->OnLengthChange(inode->parent(), oldLength,
+                                            attr->st_size);
+        }
         ret = inodeWrapper->Sync();
         if (ret != CURVEFS_ERROR::OK) {
             return ret;
@@ -695,34 +925,23 @@ CURVEFS_ERROR FuseClient::FuseOpSymlink(fuse_req_t req, const char *link,
     param.mode = S_IFLNK | 0777;
     param.type = FsFileType::TYPE_SYM_LINK;
     param.symlink = link;
+    param.parent = parent;
 
-    std::shared_ptr<InodeWrapper> inodeWrapper;
-    CURVEFS_ERROR ret = inodeManager_->CreateInode(param, inodeWrapper);
-    if (ret != CURVEFS_ERROR::OK) {
-        LOG(ERROR) << "inodeManager CreateInode fail, ret = " << ret
-                   << ", parent = " << parent << ", name = " << name
-                   << ", mode = " << param.mode;
-        return ret;
-    }
     Dentry dentry;
     dentry.set_fsid(fsInfo_->fsid());
-    dentry.set_inodeid(inodeWrapper->GetInodeId());
     dentry.set_parentinodeid(parent);
     dentry.set_name(name);
-    ret = dentryManager_->CreateDentry(dentry);
-    if (ret != CURVEFS_ERROR::OK) {
-        LOG(ERROR) << "dentryManager_ CreateDentry fail, ret = " << ret
-                   << ", parent = " << parent << ", name = " << name
-                   << ", mode = " << param.mode;
 
-        CURVEFS_ERROR ret2 =
-            inodeManager_->DeleteInode(inodeWrapper->GetInodeId());
-        if (ret2 != CURVEFS_ERROR::OK) {
-            LOG(ERROR) << "Also delete inode failed, ret = " << ret2
-                       << ", inodeid = " << inodeWrapper->GetInodeId();
-        }
+    std::shared_ptr<InodeWrapper> inodeWrapper;
+    CURVEFS_ERROR ret = CreateInodeWithDentry(param, &dentry, inodeWrapper);
+    if (ret != CURVEFS_ERROR::OK) {
         return ret;
     }
+    if (option_.enableDirStat) {
+        InodeAttr attr;
+        inodeWrapper->GetInodeAttrLocked(&attr);
+        dirStatManager_->OnCreate(parent, attr);
+    }
 
     std::shared_ptr<InodeWrapper> parentInodeWrapper;
     ret = inodeManager_->GetInode(parent, parentInodeWrapper);
@@ -782,6 +1001,9 @@ CURVEFS_ERROR FuseClient::FuseOpLink(fuse_req_t req, fuse_ino_t ino,
         }
         return ret;
     }
+    if (option_.enableDirStat) {
+        dirStatManager_->OnLink(newparent, inodeWrapper->GetParent());
+    }
 
     std::shared_ptr<InodeWrapper> parentInodeWrapper;
     ret = inodeManager_->GetInode(newparent, parentInodeWrapper);
@@ -816,6 +1038,63 @@ CURVEFS_ERROR FuseClient::FuseOpReadLink(fuse_req_t req, fuse_ino_t ino,
     return CURVEFS_ERROR::OK;
 }
 
+CURVEFS_ERROR FuseClient::FuseOpGetXattr(fuse_req_t req, fuse_ino_t ino,
+                                         const char *name, std::string *value,
+                                         size_t size) {
+    VLOG(9) << "FuseOpGetXattr, ino: " << ino << ", name: " << name
+            << ", size: " << size;
+    if (!option_.enableDirStat) {
+        // kernel won't send getxattr any more
+        return CURVEFS_ERROR::NOTSUPPORT;
+    }
+    // kernel asks for xattrs like "security.capability" on every write,
+    // answer them without rpc
+    enum { kBytes, kFiles, kSubdirs, kEntries } key;
+    if (strcmp(name, kXattrDirRBytes) == 0) {
+        key = kBytes;
+    } else if (strcmp(name, kXattrDirRFiles) == 0) {
+        key = kFiles;
+    } else if (strcmp(name, kXattrDirRSubdirs) == 0) {
+        key = kSubdirs;
+    } else if (strcmp(name, kXattrDirREntries) == 0) {
+        key = kEntries;
+    } else {
+        return CURVEFS_ERROR::NODATA;
+    }
+
+    // the stats are updated by metaserver, not the cached inode
+    Inode inode;
+    MetaStatusCode rc = metaClient_->GetInode(fsInfo_->fsid(), ino, &inode);
+    if (rc != MetaStatusCode::OK) {
+        LOG(ERROR) << "metaClient GetInode fail, ret = "
+                   << MetaStatusCode_Name(rc) << ", inodeid = " << ino;
+        return MetaStatusCodeToCurvefsErrCode(rc);
+    }
+    if (inode.type() != FsFileType::TYPE_DIRECTORY) {
+        return CURVEFS_ERROR::NODATA;
+    }
+
+    const DirStat &stat = inode.dirstat();
+    switch (key) {
+        case kBytes:
+            *value = std::to_string(stat.bytes());
+            break;
+        case kFiles:
+            *value = std::to_string(stat.files());
+            break;
+        case kSubdirs:
+            *value = std::to_string(stat.subdirs());
+            break;
+        case kEntries:
+            *value = std::to_string(stat.files() + stat.subdirs());
+            break;
+    }
+    if (size != 0 && size < value->size()) {
+        return CURVEFS_ERROR::OUT_OF_RANGE;
+    }
+    return CURVEFS_ERROR::OK;
+}
+
 CURVEFS_ERROR FuseClient::FuseOpRelease(fuse_req_t req, fuse_ino_t ino,
                                         struct fuse_file_info *fi) {
     LOG(INFO) << "FuseOpRelease, ino: " << ino;
@@ -829,7 +1108,10 @@ CURVEFS_ERROR FuseClient::FuseOpRelease(fuse_req_t req, fuse_ino_t ino,
 
     ::curve::common::UniqueLock lgGuard = inodeWrapper->GetUniqueLock();
 
-    ret = inodeWrapper->Release();
+    ret = inodeWrapper->Release(option_.openLeaseMs);
+    if (ret == CURVEFS_ERROR::OK && inodeWrapper->IsOpenLeaseHeld()) {
+        inodeManager_->AddOpenLease(inodeWrapper);
+    }
     return ret;
 }
 
@@ -26,6 +26,7 @@
 #include <unistd.h>
 #include <sys/stat.h>
 
+#include <list>
 #include <map>
 #include <memory>
 #include <string>
@@ -36,6 +37,7 @@
 #include "curvefs/src/client/common/config.h"
 #include "curvefs/src/client/dentry_cache_manager.h"
 #include "curvefs/src/client/dir_buffer.h"
+#include "curvefs/src/client/dir_stat_manager.h"
 #include "curvefs/src/client/fuse_common.h"
 #include "curvefs/src/client/inode_cache_manager.h"
 #include "curvefs/src/client/rpcclient/mds_client.h"
@@ -44,6 +46,7 @@
 #include "curvefs/src/common/fast_align.h"
 #include "curvefs/src/client/metric/client_metric.h"
 #include "src/common/concurrent/concurrent.h"
+#include "src/common/concurrent/name_lock.h"
 
 #define DirectIOAlignemnt 512
 
@@ -76,10 +79,12 @@ class FuseClient {
         inodeManager_(std::make_shared<InodeCacheManagerImpl>(metaClient_)),
         dentryManager_(std::make_shared<DentryCacheManagerImpl>(metaClient_)),
         dirBuf_(std::make_shared<DirBuffer>()),
+        dirStatManager_(std::make_shared<DirStatManager>(metaClient_)),
         fsInfo_(nullptr),
         mdsBase_(nullptr),
         isStop_(true),
-        init_(false) {}
+        init_(false),
+        writebackCache_(false) {}
 
     virtual ~FuseClient() {}
 
@@ -92,10 +97,12 @@ class FuseClient {
             inodeManager_(inodeManager),
             dentryManager_(dentryManager),
             dirBuf_(std::make_shared<DirBuffer>()),
+            dirStatManager_(std::make_shared<DirStatManager>(metaClient)),
             fsInfo_(nullptr),
             mdsBase_(nullptr),
             isStop_(true),
-            init_(false) {}
+            init_(false),
+            writebackCache_(false) {}
 
     virtual CURVEFS_ERROR Init(const FuseClientOption &option);
 
@@ -156,6 +163,11 @@ class FuseClient {
                                         struct fuse_file_info* fi,
                                         char** buffer, size_t* rSize);
 
+    virtual CURVEFS_ERROR FuseOpReadDirPlus(fuse_req_t req, fuse_ino_t ino,
+                                            size_t size, off_t off,
+                                            struct fuse_file_info* fi,
+                                            char** buffer, size_t* rSize);
+
     virtual CURVEFS_ERROR FuseOpRename(fuse_req_t req, fuse_ino_t parent,
                                        const char* name, fuse_ino_t newparent,
                                        const char* newname);
@@ -180,6 +192,12 @@ class FuseClient {
     virtual CURVEFS_ERROR FuseOpReadLink(fuse_req_t req, fuse_ino_t ino,
                                          std::string* linkStr);
 
+    // only the recursive stats of directories are supported, `value` is
+    // not returned if `size` is 0, OUT_OF_RANGE if `size` is too small
+    virtual CURVEFS_ERROR FuseOpGetXattr(fuse_req_t req, fuse_ino_t ino,
+                                         const char* name, std::string* value,
+                                         size_t size);
+
     virtual CURVEFS_ERROR FuseOpRelease(fuse_req_t req, fuse_ino_t ino,
                                         struct fuse_file_info* fi);
 
@@ -196,6 +214,11 @@ class FuseClient {
         return fsInfo_;
     }
 
+    // called when kernel writeback cache is negotiated in init
+    void SetWritebackCache(bool enable) {
+        writebackCache_ = enable;
+    }
+
     virtual void FlushInode();
 
     virtual void FlushInodeAll();
@@ -214,6 +237,9 @@ class FuseClient {
         const std::shared_ptr<InodeWrapper> &inodeWrapper_,
         fuse_entry_param *param);
 
+    void GetDentryParamFromInodeAttr(const InodeAttr &attr,
+                                     fuse_entry_param *param);
+
     int AddHostNameToMountPointStr(const std::string& mountPointStr,
                                    std::string* out) {
         char hostname[kMaxHostNameLength];
@@ -227,6 +253,25 @@ class FuseClient {
     }
 
  private:
+    CURVEFS_ERROR ReadDirInternal(fuse_req_t req, fuse_ino_t ino, size_t size,
+                                  off_t off, struct fuse_file_info* fi,
+                                  char** buffer, size_t* rSize, bool plus);
+
+    // fill the dir buffer with entries and their attributes for readdirplus
+    CURVEFS_ERROR FillDirBufferPlus(fuse_req_t req, DirBufferHead* bufHead,
+                                    const std::list<Dentry>& dentrys);
+
+    // the entry is added without attributes if `attr` is nullptr,
+    // the kernel looks it up when needed
+    void DirBufferAddPlus(fuse_req_t req, DirBufferHead* b,
+                          const Dentry& dentry, const InodeAttr* attr);
+
+    // create the inode and the dentry pointing to it, by one request if
+    // enableCompoundMetaOp, `dentry->inodeid()` is set to the new inode
+    CURVEFS_ERROR CreateInodeWithDentry(
+        const InodeParam& param, Dentry* dentry,
+        std::shared_ptr<InodeWrapper>& inodeWrapper);  // NOLINT
+
     virtual CURVEFS_ERROR Truncate(Inode* inode, uint64_t length) = 0;
 
     virtual void FlushInodeLoop();
@@ -251,6 +296,9 @@ class FuseClient {
     // dir buffer
     std::shared_ptr<DirBuffer> dirBuf_;
 
+    // recursive stats of directories
+    std::shared_ptr<DirStatManager> dirStatManager_;
+
     // filesystem info
     std::shared_ptr<FsInfo> fsInfo_;
 
@@ -261,6 +309,9 @@ class FuseClient {
 
     std::shared_ptr<FSMetric> fsMetric_;
 
+    // whether kernel writeback cache is enabled
+    bool writebackCache_;
+
  private:
     MDSBaseClient* mdsBase_;
 
@@ -270,7 +321,13 @@ class FuseClient {
 
     Thread flushThread_;
 
-    curve::common::Mutex renameMutex_;
+    // the renames run by metaserver go on concurrently, and the ones
+    // run by the client go on exclusively
+    curve::common::RWLock renameLock_;
+
+    // serializes the renames whose source or target name is the same,
+    // keyed by "parent/name"
+    curve::common::NameLock renameNameLock_;
 };
 
 }  // namespace client
@@ -107,19 +107,15 @@ CURVEFS_ERROR FuseS3Client::FuseOpWrite(fuse_req_t req, fuse_ino_t ino,
     }
 
     ::curve::common::UniqueLock lgGuard = inodeWrapper->GetUniqueLock();
-    Inode *inode = inodeWrapper->GetMutableInodeUnlocked();
 
     *wSize = wRet;
-    // update file len
-    if (inode->length() < off + *wSize) {
-        inode->set_length(off + *wSize);
+    uint64_t oldLength = inodeWrapper->GetMutableInodeUnlocked()->length();
+    inodeWrapper->UpdateAfterWriteUnLocked(off, *wSize, writebackCache_);
+    if (option_.enableDirStat) {
+        const Inode *inode = inodeWrapper->GetMutableInodeUnlocked();
+        dirStatManager_->OnLengthChange(inode->parent(), oldLength,
+                                        inode->length());
     }
-    struct timespec now;
-    clock_gettime(CLOCK_REALTIME, &now);
-    inode->set_mtime(now.tv_sec);
-    inode->set_mtime_ns(now.tv_nsec);
-    inode->set_ctime(now.tv_sec);
-    inode->set_ctime_ns(now.tv_nsec);
 
     inodeManager_->ShipToFlush(inodeWrapper);
 
@@ -200,19 +200,14 @@ CURVEFS_ERROR FuseVolumeClient::FuseOpWrite(fuse_req_t req, fuse_ino_t ino,
         return ret;
     }
     *wSize = size;
-    // update file len
-    if (inode.length() < off + *wSize) {
-        inode.set_length(off + *wSize);
-    }
-
-    struct timespec now;
-    clock_gettime(CLOCK_REALTIME, &now);
-    inode.set_mtime(now.tv_sec);
-    inode.set_mtime_ns(now.tv_nsec);
-    inode.set_ctime(now.tv_sec);
-    inode.set_ctime_ns(now.tv_nsec);
-
     inodeWrapper->SwapInode(&inode);
+    uint64_t oldLength = inode.length();  // swapped out
+    inodeWrapper->UpdateAfterWriteUnLocked(off, *wSize, writebackCache_);
+    if (option_.enableDirStat) {
+        const Inode *newInode = inodeWrapper->GetMutableInodeUnlocked();
+        dirStatManager_->OnLengthChange(newInode->parent(), oldLength,
+                                        newInode->length());
+    }
     inodeManager_->ShipToFlush(inodeWrapper);
 
     if (fi->flags & O_DIRECT || fi->flags & O_SYNC || fi->flags & O_DSYNC) {
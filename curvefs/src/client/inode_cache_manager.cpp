@@ -25,8 +25,14 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <list>
 #include <map>
+#include <set>
 #include <utility>
+#include <vector>
+
+#include "src/common/timeutility.h"
 
 using ::curvefs::metaserver::Inode;
 using ::curvefs::metaserver::MetaStatusCode_Name;
@@ -35,6 +41,69 @@ namespace curvefs {
 namespace client {
 
 using NameLockGuard = ::curve::common::GenericNameLockGuard<Mutex>;
+using ::curvefs::client::rpcclient::MetaServerClientDone;
+using ::curvefs::metaserver::BatchUpdateInodeResponse;
+using ::curve::common::TimeUtility;
+
+// max number of inodes flushed by one BatchUpdateInode rpc
+const size_t kMaxBatchUpdateInodeNum = 128;
+
+class BatchUpdateInodeAsyncDone : public MetaServerClientDone {
+ public:
+    struct SyncingInode {
+        std::shared_ptr<InodeWrapper> inodeWrapper;
+        bool syncingAttr;
+        bool syncingS3ChunkInfo;
+    };
+
+    BatchUpdateInodeAsyncDone() {}
+    ~BatchUpdateInodeAsyncDone() {}
+
+    void Add(const std::shared_ptr<InodeWrapper> &inodeWrapper,
+             bool syncingAttr, bool syncingS3ChunkInfo) {
+        inodes_.push_back({inodeWrapper, syncingAttr, syncingS3ChunkInfo});
+    }
+
+    BatchUpdateInodeResponse *GetResponse() {
+        return &response_;
+    }
+
+    void Run() override {
+        std::unique_ptr<BatchUpdateInodeAsyncDone> self_guard(this);
+        MetaStatusCode ret = GetStatusCode();
+        bool failed =
+            ret != MetaStatusCode::OK && ret != MetaStatusCode::NOT_FOUND;
+        LOG_IF(ERROR, failed) << "metaClient_ BatchUpdateInode failed, "
+                              << "MetaStatusCode: " << ret
+                              << ", MetaStatusCode_Name: "
+                              << MetaStatusCode_Name(ret)
+                              << ", inode count: " << inodes_.size()
+                              << ", failed inode count: "
+                              << response_.failedinodeid_size();
+        // the batch is applied if metaserver tells the failed inodes,
+        // otherwise none of the inodes is updated
+        std::set<uint64_t> failedInodeIds(
+            response_.failedinodeid().begin(),
+            response_.failedinodeid().end());
+        for (const auto &inode : inodes_) {
+            if (failed && (failedInodeIds.empty() ||
+                           failedInodeIds.count(
+                               inode.inodeWrapper->GetInodeId()) != 0)) {
+                inode.inodeWrapper->MarkInodeError();
+            }
+            if (inode.syncingAttr) {
+                inode.inodeWrapper->ReleaseSyncingInode();
+            }
+            if (inode.syncingS3ChunkInfo) {
+                inode.inodeWrapper->ReleaseSyncingS3ChunkInfo();
+            }
+        }
+    }
+
+ private:
+    std::vector<SyncingInode> inodes_;
+    BatchUpdateInodeResponse response_;
+};
 
 CURVEFS_ERROR InodeCacheManagerImpl::GetInode(uint64_t inodeid,
     std::shared_ptr<InodeWrapper> &out) {
@@ -44,6 +113,20 @@ CURVEFS_ERROR InodeCacheManagerImpl::GetInode(uint64_t inodeid,
         return CURVEFS_ERROR::OK;
     }
 
+    std::shared_ptr<InodeWrapper> leased;
+    {
+        curve::common::LockGuard lg(openLeaseMapMutex_);
+        auto it = openLeaseMap_.find(inodeid);
+        if (it != openLeaseMap_.end()) {
+            leased = it->second;
+        }
+    }
+    if (leased != nullptr) {
+        out = leased;
+        PutInodeCache(inodeid, out);
+        return CURVEFS_ERROR::OK;
+    }
+
     Inode inode;
     MetaStatusCode ret2 = metaClient_->GetInode(fsId_, inodeid, &inode);
     if (ret2 != MetaStatusCode::OK) {
@@ -56,11 +139,82 @@ CURVEFS_ERROR InodeCacheManagerImpl::GetInode(uint64_t inodeid,
 
     out = std::make_shared<InodeWrapper>(
         std::move(inode), metaClient_);
+    PutInodeCache(inodeid, out);
+    return CURVEFS_ERROR::OK;
+}
 
-    std::shared_ptr<InodeWrapper> eliminatedOne;
-    bool eliminated = iCache_->Put(inodeid, out, &eliminatedOne);
-    if (eliminated) {
-        eliminatedOne->FlushAsync();
+CURVEFS_ERROR InodeCacheManagerImpl::GetInodeAttr(uint64_t inodeid,
+                                                  InodeAttr *out) {
+    {
+        NameLockGuard lock(nameLock_, std::to_string(inodeid));
+        std::shared_ptr<InodeWrapper> inodeWrapper;
+        if (iCache_->Get(inodeid, &inodeWrapper)) {
+            inodeWrapper->GetInodeAttrLocked(out);
+            return CURVEFS_ERROR::OK;
+        }
+        if (iAttrCache_->Get(inodeid, out)) {
+            return CURVEFS_ERROR::OK;
+        }
+    }
+
+    // only fetch the attributes, the s3 chunk infos of a large file
+    // are not needed by stat
+    std::map<uint64_t, InodeAttr> attrs;
+    CURVEFS_ERROR ret = BatchGetInodeAttr({inodeid}, &attrs);
+    if (ret != CURVEFS_ERROR::OK) {
+        return ret;
+    }
+    auto it = attrs.find(inodeid);
+    if (it == attrs.end()) {
+        return CURVEFS_ERROR::NOTEXIST;
+    }
+    out->Swap(&(it->second));
+    return CURVEFS_ERROR::OK;
+}
+
+CURVEFS_ERROR InodeCacheManagerImpl::BatchGetInodeAttr(
+    const std::set<uint64_t> &inodeIds,
+    std::map<uint64_t, InodeAttr> *attrs) {
+    std::set<uint64_t> missed;
+    for (const auto &inodeid : inodeIds) {
+        NameLockGuard lock(nameLock_, std::to_string(inodeid));
+        std::shared_ptr<InodeWrapper> inodeWrapper;
+        InodeAttr attr;
+        if (iCache_->Get(inodeid, &inodeWrapper)) {
+            inodeWrapper->GetInodeAttrLocked(&attr);
+        } else if (!iAttrCache_->Get(inodeid, &attr)) {
+            missed.insert(inodeid);
+            continue;
+        }
+        attrs->emplace(inodeid, std::move(attr));
+    }
+
+    if (missed.empty()) {
+        return CURVEFS_ERROR::OK;
+    }
+
+    std::list<InodeAttr> attrList;
+    MetaStatusCode ret =
+        metaClient_->BatchGetInodeAttr(fsId_, missed, &attrList);
+    if (ret != MetaStatusCode::OK) {
+        LOG(ERROR) << "metaClient_ BatchGetInodeAttr failed, MetaStatusCode = "
+                   << ret << ", MetaStatusCode_Name = "
+                   << MetaStatusCode_Name(ret)
+                   << ", inode count = " << missed.size();
+        return MetaStatusCodeToCurvefsErrCode(ret);
+    }
+
+    for (auto &attr : attrList) {
+        uint64_t inodeid = attr.inodeid();
+        NameLockGuard lock(nameLock_, std::to_string(inodeid));
+        // the inode may be loaded into iCache_ during the rpc, which is newer
+        std::shared_ptr<InodeWrapper> inodeWrapper;
+        if (iCache_->Get(inodeid, &inodeWrapper)) {
+            inodeWrapper->GetInodeAttrLocked(&attr);
+        } else {
+            iAttrCache_->Put(inodeid, attr);
+        }
+        (*attrs)[inodeid] = std::move(attr);
     }
     return CURVEFS_ERROR::OK;
 }
@@ -79,21 +233,44 @@ CURVEFS_ERROR InodeCacheManagerImpl::CreateInode(
     out = std::make_shared<InodeWrapper>(
         std::move(inode), metaClient_);
 
-    std::shared_ptr<InodeWrapper> eliminatedOne;
-    bool eliminated = false;
-    {
-        NameLockGuard lock(nameLock_, std::to_string(inodeid));
-        eliminated = iCache_->Put(inodeid, out, &eliminatedOne);
-    }
-    if (eliminated) {
-        eliminatedOne->FlushAsync();
+    NameLockGuard lock(nameLock_, std::to_string(inodeid));
+    PutInodeCache(inodeid, out);
+    return CURVEFS_ERROR::OK;
+}
+
+CURVEFS_ERROR InodeCacheManagerImpl::CreateInodeAndDentry(
+    const InodeParam &param, Dentry *dentry,
+    std::shared_ptr<InodeWrapper> &out) {
+    Inode inode;
+    MetaStatusCode ret =
+        metaClient_->CreateInodeAndDentry(param, dentry, &inode);
+    if (ret == MetaStatusCode::PARTITION_ALLOC_ID_FAIL ||
+        ret == MetaStatusCode::PARTITION_ID_MISSMATCH) {
+        VLOG(3) << "metaClient_ CreateInodeAndDentry not supported by the"
+                << " partition of parent " << dentry->parentinodeid()
+                << ", MetaStatusCode_Name = " << MetaStatusCode_Name(ret);
+        return CURVEFS_ERROR::NOTSUPPORT;
+    } else if (ret != MetaStatusCode::OK) {
+        LOG(ERROR) << "metaClient_ CreateInodeAndDentry failed, MetaStatusCode"
+                   << " = " << ret
+                   << ", MetaStatusCode_Name = " << MetaStatusCode_Name(ret)
+                   << ", parent = " << dentry->parentinodeid()
+                   << ", name = " << dentry->name();
+        return MetaStatusCodeToCurvefsErrCode(ret);
     }
+    uint64_t inodeid = inode.inodeid();
+    out = std::make_shared<InodeWrapper>(
+        std::move(inode), metaClient_);
+
+    NameLockGuard lock(nameLock_, std::to_string(inodeid));
+    PutInodeCache(inodeid, out);
     return CURVEFS_ERROR::OK;
 }
 
 CURVEFS_ERROR InodeCacheManagerImpl::DeleteInode(uint64_t inodeid) {
     NameLockGuard lock(nameLock_, std::to_string(inodeid));
     iCache_->Remove(inodeid);
+    iAttrCache_->Remove(inodeid);
     MetaStatusCode ret = metaClient_->DeleteInode(fsId_, inodeid);
     if (ret != MetaStatusCode::OK && ret != MetaStatusCode::NOT_FOUND) {
         LOG(ERROR) << "metaClient_ DeleteInode failed, MetaStatusCode = " << ret
@@ -102,42 +279,154 @@ CURVEFS_ERROR InodeCacheManagerImpl::DeleteInode(uint64_t inodeid) {
         return MetaStatusCodeToCurvefsErrCode(ret);
     }
 
+    {
+        curve::common::LockGuard lg(openLeaseMapMutex_);
+        openLeaseMap_.erase(inodeid);
+    }
     curve::common::LockGuard lg2(dirtyMapMutex_);
     dirtyMap_.erase(inodeid);
     return CURVEFS_ERROR::OK;
 }
 
 void InodeCacheManagerImpl::ClearInodeCache(uint64_t inodeid) {
+    std::shared_ptr<InodeWrapper> leased;
     {
         NameLockGuard lock(nameLock_, std::to_string(inodeid));
         iCache_->Remove(inodeid);
+        iAttrCache_->Remove(inodeid);
+        curve::common::LockGuard lg(openLeaseMapMutex_);
+        auto it = openLeaseMap_.find(inodeid);
+        if (it != openLeaseMap_.end()) {
+            leased = it->second;
+            openLeaseMap_.erase(it);
+        }
+    }
+    if (leased != nullptr) {
+        // the wrapper is dropped, release its lease now
+        curve::common::UniqueLock ulk = leased->GetUniqueLock();
+        if (leased->ReleaseOpenLease(0, true)) {
+            leased->FlushAsync();
+        }
     }
     curve::common::LockGuard lg2(dirtyMapMutex_);
     dirtyMap_.erase(inodeid);
 }
 
+// caller should hold the name lock of inodeid
+void InodeCacheManagerImpl::PutInodeCache(
+    uint64_t inodeid, const std::shared_ptr<InodeWrapper> &inodeWrapper) {
+    iAttrCache_->Remove(inodeid);
+
+    std::shared_ptr<InodeWrapper> eliminatedOne;
+    bool eliminated = iCache_->Put(inodeid, inodeWrapper, &eliminatedOne);
+    if (eliminated) {
+        // attributes of the eliminated inode may be cached by
+        // BatchGetInodeAttr before it was loaded, which are stale now
+        iAttrCache_->Remove(eliminatedOne->GetInodeId());
+        eliminatedOne->FlushAsync();
+    }
+}
+
 void InodeCacheManagerImpl::ShipToFlush(
     const std::shared_ptr<InodeWrapper> &inodeWrapper) {
     curve::common::LockGuard lg(dirtyMapMutex_);
     dirtyMap_.emplace(inodeWrapper->GetInodeId(), inodeWrapper);
 }
 
+void InodeCacheManagerImpl::AddOpenLease(
+    const std::shared_ptr<InodeWrapper> &inodeWrapper) {
+    curve::common::LockGuard lg(openLeaseMapMutex_);
+    openLeaseMap_[inodeWrapper->GetInodeId()] = inodeWrapper;
+}
+
+void InodeCacheManagerImpl::ReleaseOpenLeases(bool force) {
+    std::vector<std::shared_ptr<InodeWrapper>> leases;
+    {
+        curve::common::LockGuard lg(openLeaseMapMutex_);
+        for (const auto &item : openLeaseMap_) {
+            leases.push_back(item.second);
+        }
+    }
+
+    uint64_t nowMs = TimeUtility::GetTimeofDayMs();
+    for (const auto &inodeWrapper : leases) {
+        curve::common::UniqueLock ulk = inodeWrapper->GetUniqueLock();
+        if (inodeWrapper->ReleaseOpenLease(nowMs, force)) {
+            ShipToFlush(inodeWrapper);
+        }
+        if (!inodeWrapper->IsOpenLeaseHeld()) {
+            // released or reopened
+            curve::common::LockGuard lg(openLeaseMapMutex_);
+            auto it = openLeaseMap_.find(inodeWrapper->GetInodeId());
+            if (it != openLeaseMap_.end() && it->second == inodeWrapper) {
+                openLeaseMap_.erase(it);
+            }
+        }
+    }
+}
+
 void InodeCacheManagerImpl::FlushAll() {
+    ReleaseOpenLeases(true);
     while (!dirtyMap_.empty()) {
         FlushInodeOnce();
     }
 }
 
 void InodeCacheManagerImpl::FlushInodeOnce() {
+    ReleaseOpenLeases(false);
+
     std::map<uint64_t, std::shared_ptr<InodeWrapper>> temp_;
     {
         curve::common::LockGuard lg(dirtyMapMutex_);
         temp_.swap(dirtyMap_);
     }
+
+    // group dirty inodes by partition, inodes in the same partition are
+    // flushed together by BatchUpdateInode rpcs
+    std::map<uint32_t, std::vector<std::shared_ptr<InodeWrapper>>> groups;
     for (auto it = temp_.begin(); it != temp_.end(); it++) {
-        curve::common::UniqueLock ulk = it->second->GetUniqueLock();
-        it->second->FlushAsync();
+        uint32_t partitionId = 0;
+        uint64_t txId = 0;
+        MetaStatusCode ret =
+            metaClient_->GetTxId(fsId_, it->first, &partitionId, &txId);
+        if (ret == MetaStatusCode::OK) {
+            groups[partitionId].push_back(it->second);
+        } else {
+            curve::common::UniqueLock ulk = it->second->GetUniqueLock();
+            it->second->FlushAsync();
+        }
+    }
+
+    for (const auto &group : groups) {
+        const auto &inodes = group.second;
+        for (size_t i = 0; i < inodes.size(); i += kMaxBatchUpdateInodeNum) {
+            size_t end = std::min(inodes.size(), i + kMaxBatchUpdateInodeNum);
+            FlushInodesInPartition(inodes.begin() + i, inodes.begin() + end);
+        }
+    }
+}
+
+void InodeCacheManagerImpl::FlushInodesInPartition(
+    InodeWrapperIter begin, InodeWrapperIter end) {
+    BatchUpdateInodeRequest request;
+    request.set_fsid(fsId_);
+    auto *done = new BatchUpdateInodeAsyncDone();
+    for (auto it = begin; it != end; ++it) {
+        bool syncingAttr = false;
+        bool syncingS3ChunkInfo = false;
+        curve::common::UniqueLock ulk = (*it)->GetUniqueLock();
+        (*it)->FlushToBatch(&request, &syncingAttr, &syncingS3ChunkInfo);
+        if (syncingAttr || syncingS3ChunkInfo) {
+            done->Add(*it, syncingAttr, syncingS3ChunkInfo);
+        }
+    }
+
+    if (request.updateinode_size() == 0 &&
+        request.s3chunkinfoadd_size() == 0) {
+        delete done;
+        return;
     }
+    metaClient_->BatchUpdateInodeAsync(request, done->GetResponse(), done);
 }
 
 
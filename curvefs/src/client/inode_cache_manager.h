@@ -27,6 +27,8 @@
 #include <memory>
 #include <unordered_map>
 #include <map>
+#include <set>
+#include <vector>
 
 #include "src/common/lru_cache.h"
 
@@ -45,6 +47,7 @@ namespace client {
 using rpcclient::MetaServerClient;
 using rpcclient::MetaServerClientImpl;
 using rpcclient::InodeParam;
+using ::curvefs::metaserver::InodeAttr;
 
 class InodeCacheManager {
  public:
@@ -61,9 +64,20 @@ class InodeCacheManager {
     virtual CURVEFS_ERROR GetInode(uint64_t inodeid,
         std::shared_ptr<InodeWrapper> &out) = 0;   // NOLINT
 
+    virtual CURVEFS_ERROR GetInodeAttr(uint64_t inodeid, InodeAttr *out) = 0;
+
+    virtual CURVEFS_ERROR BatchGetInodeAttr(
+        const std::set<uint64_t> &inodeIds,
+        std::map<uint64_t, InodeAttr> *attrs) = 0;
+
     virtual CURVEFS_ERROR CreateInode(const InodeParam &param,
         std::shared_ptr<InodeWrapper> &out) = 0;   // NOLINT
 
+    // create the inode and its dentry by one request in the partition of
+    // parent, NOTSUPPORT is returned if they should be created separately
+    virtual CURVEFS_ERROR CreateInodeAndDentry(const InodeParam &param,
+        Dentry *dentry, std::shared_ptr<InodeWrapper> &out) = 0;   // NOLINT
+
     virtual CURVEFS_ERROR DeleteInode(uint64_t inodeid) = 0;
 
     virtual void ClearInodeCache(uint64_t inodeid) = 0;
@@ -71,6 +85,11 @@ class InodeCacheManager {
     virtual void ShipToFlush(
         const std::shared_ptr<InodeWrapper> &inodeWrapper) = 0;
 
+    // track the open lease held by the inode after its last close, the
+    // lease is released by the flusher after it expires
+    virtual void AddOpenLease(
+        const std::shared_ptr<InodeWrapper> &inodeWrapper) = 0;
+
     virtual void FlushAll() = 0;
 
     virtual void FlushInodeOnce() = 0;
@@ -83,21 +102,28 @@ class InodeCacheManagerImpl : public InodeCacheManager {
  public:
     InodeCacheManagerImpl()
       : metaClient_(std::make_shared<MetaServerClientImpl>()),
-        iCache_(nullptr) {}
+        iCache_(nullptr),
+        iAttrCache_(nullptr) {}
 
     explicit InodeCacheManagerImpl(
         const std::shared_ptr<MetaServerClient> &metaClient)
       : metaClient_(metaClient),
-        iCache_(nullptr) {}
+        iCache_(nullptr),
+        iAttrCache_(nullptr) {}
 
     CURVEFS_ERROR Init(uint64_t cacheSize, bool enableCacheMetrics) override {
         if (enableCacheMetrics) {
             iCache_ = std::make_shared<
                 LRUCache<uint64_t, std::shared_ptr<InodeWrapper>>>(cacheSize,
                     std::make_shared<CacheMetrics>("icache"));
+            iAttrCache_ = std::make_shared<
+                LRUCache<uint64_t, InodeAttr>>(cacheSize,
+                    std::make_shared<CacheMetrics>("iattrcache"));
         } else {
             iCache_ = std::make_shared<
                 LRUCache<uint64_t, std::shared_ptr<InodeWrapper>>>(cacheSize);
+            iAttrCache_ = std::make_shared<
+                LRUCache<uint64_t, InodeAttr>>(cacheSize);
         }
         return CURVEFS_ERROR::OK;
     }
@@ -105,9 +131,19 @@ class InodeCacheManagerImpl : public InodeCacheManager {
     CURVEFS_ERROR GetInode(uint64_t inodeid,
         std::shared_ptr<InodeWrapper> &out) override;    // NOLINT
 
+    CURVEFS_ERROR GetInodeAttr(uint64_t inodeid, InodeAttr *out) override;
+
+    CURVEFS_ERROR BatchGetInodeAttr(
+        const std::set<uint64_t> &inodeIds,
+        std::map<uint64_t, InodeAttr> *attrs) override;
+
     CURVEFS_ERROR CreateInode(const InodeParam &param,
         std::shared_ptr<InodeWrapper> &out) override;    // NOLINT
 
+    CURVEFS_ERROR CreateInodeAndDentry(const InodeParam &param,
+        Dentry *dentry,
+        std::shared_ptr<InodeWrapper> &out) override;    // NOLINT
+
     CURVEFS_ERROR DeleteInode(uint64_t inodeid) override;
 
     void ClearInodeCache(uint64_t inodeid) override;
@@ -115,20 +151,48 @@ class InodeCacheManagerImpl : public InodeCacheManager {
     void ShipToFlush(
         const std::shared_ptr<InodeWrapper> &inodeWrapper) override;
 
+    void AddOpenLease(
+        const std::shared_ptr<InodeWrapper> &inodeWrapper) override;
+
     void FlushAll() override;
 
     void FlushInodeOnce() override;
 
+ private:
+    // clear the open flag of inodes whose open lease expired, or of all
+    // inodes holding a lease if `force`
+    void ReleaseOpenLeases(bool force);
+
+    void PutInodeCache(uint64_t inodeid,
+                       const std::shared_ptr<InodeWrapper> &inodeWrapper);
+
+    using InodeWrapperIter =
+        std::vector<std::shared_ptr<InodeWrapper>>::const_iterator;
+
+    // flush dirty inodes in the same partition by one BatchUpdateInode rpc
+    void FlushInodesInPartition(InodeWrapperIter begin, InodeWrapperIter end);
+
  private:
     std::shared_ptr<MetaServerClient> metaClient_;
     std::shared_ptr<LRUCache<uint64_t, std::shared_ptr<InodeWrapper>>> iCache_;
 
+    // attributes got by BatchGetInodeAttr (e.g. readdirplus), an inode
+    // is either in iCache_ or in iAttrCache_, the full inode in iCache_
+    // may be modified locally and always takes precedence
+    std::shared_ptr<LRUCache<uint64_t, InodeAttr>> iAttrCache_;
+
     // dirty map, key is inodeid
     std::map<uint64_t, std::shared_ptr<InodeWrapper>> dirtyMap_;
 
     // dirty map mutex
     curve::common::Mutex dirtyMapMutex_;
 
+    // inodes closed but the open flag is still held, key is inodeid.
+    // the inode may be evicted from iCache_, and will be reused from here
+    // to keep only one wrapper of the inode
+    std::map<uint64_t, std::shared_ptr<InodeWrapper>> openLeaseMap_;
+    curve::common::Mutex openLeaseMapMutex_;
+
     curve::common::GenericNameLock<Mutex> nameLock_;
 };
 
@@ -22,7 +22,11 @@
 
 #include "curvefs/src/client/inode_wrapper.h"
 
+#include <list>
+#include <set>
+
 #include "curvefs/src/client/rpcclient/metaserver_client.h"
+#include "src/common/timeutility.h"
 
 using ::curvefs::metaserver::MetaStatusCode_Name;
 
@@ -32,6 +36,7 @@ namespace client {
 using rpcclient::MetaServerClient;
 using rpcclient::MetaServerClientImpl;
 using rpcclient::MetaServerClientDone;
+using ::curve::common::TimeUtility;
 
 std::ostream &operator<<(std::ostream &os, const struct stat &attr) {
     os << "{ st_ino = " << attr.st_ino << ", st_mode = " << attr.st_mode
@@ -168,6 +173,28 @@ void InodeWrapper::FlushS3ChunkInfoAsync() {
     }
 }
 
+void InodeWrapper::FlushToBatch(BatchUpdateInodeRequest *request,
+                                bool *syncingAttr, bool *syncingS3ChunkInfo) {
+    *syncingAttr = false;
+    *syncingS3ChunkInfo = false;
+    if (dirty_) {
+        LockSyncingInode();
+        // pool, copyset and partition are filled in by metaserver client
+        rpcclient::FillUpdateInodeRequest(inode_,
+                                          request->add_updateinode());
+        dirty_ = false;
+        *syncingAttr = true;
+    }
+
+    if (!s3ChunkInfoAdd_.empty()) {
+        LockSyncingS3ChunkInfo();
+        auto *add = request->add_s3chunkinfoadd();
+        add->set_inodeid(inode_.inodeid());
+        add->mutable_s3chunkinfoadd()->swap(s3ChunkInfoAdd_);
+        *syncingS3ChunkInfo = true;
+    }
+}
+
 CURVEFS_ERROR InodeWrapper::RefreshS3ChunkInfo() {
     curve::common::UniqueLock lock = GetSyncingS3ChunkInfoUniqueLock();
     google::protobuf::Map<
@@ -281,33 +308,87 @@ CURVEFS_ERROR InodeWrapper::DecreaseNLink() {
     return CURVEFS_ERROR::INTERNAL;
 }
 
-CURVEFS_ERROR InodeWrapper::Open() {
+CURVEFS_ERROR InodeWrapper::Open(bool *keepCache) {
     CURVEFS_ERROR ret = CURVEFS_ERROR::OK;
+    bool unchanged = false;
     if (0 == openCount_) {
-        ret = SetOpenFlag(true);
-        if (ret != CURVEFS_ERROR::OK) {
-            return ret;
+        if (openLeaseHeld_) {
+            // the open flag is still set in metaserver
+            openLeaseHeld_ = false;
+            unchanged = keepCache != nullptr &&
+                        inode_.length() == closedLength_ &&
+                        inode_.mtime() == closedMtime_ &&
+                        inode_.mtime_ns() == closedMtimeNs_ &&
+                        UnchangedInMetaServer();
+        } else {
+            ret = SetOpenFlag(true);
+            if (ret != CURVEFS_ERROR::OK) {
+                return ret;
+            }
         }
     }
     openCount_++;
+    if (keepCache != nullptr) {
+        *keepCache = unchanged;
+    }
     return CURVEFS_ERROR::OK;
 }
 
+// the cached inode only sees the writes of this client, the ones of
+// others are found by the attributes in metaserver
+bool InodeWrapper::UnchangedInMetaServer() {
+    std::list<InodeAttr> attrs;
+    MetaStatusCode ret = metaClient_->BatchGetInodeAttr(
+        inode_.fsid(), std::set<uint64_t>{inode_.inodeid()}, &attrs);
+    if (ret != MetaStatusCode::OK || attrs.empty()) {
+        LOG(WARNING) << "metaClient_ BatchGetInodeAttr failed, ret = " << ret
+                     << ", inodeid = " << inode_.inodeid()
+                     << ", the page cache is dropped";
+        return false;
+    }
+    const InodeAttr &attr = attrs.front();
+    return attr.length() == closedLength_ && attr.mtime() == closedMtime_ &&
+           attr.mtime_ns() == closedMtimeNs_;
+}
+
 bool InodeWrapper::IsOpen() { return openCount_ > 0; }
 
-CURVEFS_ERROR InodeWrapper::Release() {
+CURVEFS_ERROR InodeWrapper::Release(uint32_t leaseMs) {
     CURVEFS_ERROR ret = CURVEFS_ERROR::OK;
     if (1 == openCount_) {
-        ret = SetOpenFlag(false);
-        if (ret != CURVEFS_ERROR::OK) {
-            return ret;
+        if (leaseMs > 0) {
+            openLeaseHeld_ = true;
+            openLeaseExpireMs_ = TimeUtility::GetTimeofDayMs() + leaseMs;
+            closedLength_ = inode_.length();
+            closedMtime_ = inode_.mtime();
+            closedMtimeNs_ = inode_.mtime_ns();
+        } else {
+            ret = SetOpenFlag(false);
+            if (ret != CURVEFS_ERROR::OK) {
+                return ret;
+            }
         }
     }
     openCount_--;
     return CURVEFS_ERROR::OK;
 }
 
+bool InodeWrapper::ReleaseOpenLease(uint64_t nowMs, bool force) {
+    if (!openLeaseHeld_ || openCount_ > 0) {
+        return false;
+    }
+    if (!force && openLeaseExpireMs_ > nowMs) {
+        return false;
+    }
+    openLeaseHeld_ = false;
+    inode_.set_openflag(false);
+    dirty_ = true;
+    return true;
+}
+
 CURVEFS_ERROR InodeWrapper::SetOpenFlag(bool flag) {
+    // wait for the inflight flush, which may carry a stale open flag
+    curve::common::UniqueLock lock = GetSyncingInodeUniqueLock();
     bool old = inode_.openflag();
     inode_.set_openflag(flag);
     MetaStatusCode ret = metaClient_->UpdateInode(inode_);
@@ -25,6 +25,7 @@
 #define CURVEFS_SRC_CLIENT_INODE_WRAPPER_H_
 
 #include <sys/stat.h>
+#include <time.h>
 
 #include <utility>
 #include <memory>
@@ -33,9 +34,11 @@
 #include "curvefs/proto/metaserver.pb.h"
 #include "curvefs/src/client/error_code.h"
 #include "curvefs/src/client/rpcclient/metaserver_client.h"
+#include "curvefs/src/common/inode_attr.h"
 #include "src/common/concurrent/concurrent.h"
 
 using ::curvefs::metaserver::Inode;
+using ::curvefs::metaserver::InodeAttr;
 using ::curvefs::metaserver::VolumeExtentList;
 using ::curvefs::metaserver::S3ChunkInfoList;
 using ::curvefs::metaserver::S3ChunkInfo;
@@ -53,11 +56,41 @@ const uint32_t kOptimalIOBlockSize = 0x10000u;
 
 using rpcclient::MetaServerClient;
 using rpcclient::MetaServerClientImpl;
+using rpcclient::BatchUpdateInodeRequest;
 
 std::ostream &operator<<(std::ostream &os, const struct stat &attr);
 void AppendS3ChunkInfoToMap(uint64_t chunkIndex, const S3ChunkInfo &info,
     google::protobuf::Map<uint64_t, S3ChunkInfoList> *s3ChunkInfoMap);
 
+// fill stat by Inode or InodeAttr, they have the same attribute accessors
+template <typename T>
+void InodeAttrToStat(const T &inode, struct stat *attr) {
+    memset(attr, 0, sizeof(*attr));
+    attr->st_ino = inode.inodeid();
+    attr->st_mode = inode.mode();
+    attr->st_nlink = inode.nlink();
+    attr->st_uid = inode.uid();
+    attr->st_gid = inode.gid();
+    attr->st_size = inode.length();
+    attr->st_rdev = inode.rdev();
+    attr->st_atim.tv_sec = inode.atime();
+    attr->st_atim.tv_nsec = inode.atime_ns();
+    attr->st_mtim.tv_sec = inode.mtime();
+    attr->st_mtim.tv_nsec = inode.mtime_ns();
+    attr->st_ctim.tv_sec = inode.ctime();
+    attr->st_ctim.tv_nsec = inode.ctime_ns();
+    attr->st_blksize = kOptimalIOBlockSize;
+
+    switch (inode.type()) {
+        case metaserver::TYPE_S3:
+            attr->st_blocks = (inode.length() + 511) / 512;
+            break;
+        default:
+            attr->st_blocks = 0;
+            break;
+    }
+}
+
 class InodeWrapper : public std::enable_shared_from_this<InodeWrapper> {
  public:
     InodeWrapper(const Inode &inode,
@@ -66,7 +99,12 @@ class InodeWrapper : public std::enable_shared_from_this<InodeWrapper> {
         openCount_(0),
         status_(InodeStatus::Normal),
         metaClient_(metaClient),
-        dirty_(false) {}
+        dirty_(false),
+        openLeaseHeld_(false),
+        openLeaseExpireMs_(0),
+        closedLength_(0),
+        closedMtime_(0),
+        closedMtimeNs_(0) {}
 
     InodeWrapper(Inode &&inode,
         const std::shared_ptr<MetaServerClient> &metaClient)
@@ -74,7 +112,12 @@ class InodeWrapper : public std::enable_shared_from_this<InodeWrapper> {
         openCount_(0),
         status_(InodeStatus::Normal),
         metaClient_(metaClient),
-        dirty_(false) {}
+        dirty_(false),
+        openLeaseHeld_(false),
+        openLeaseExpireMs_(0),
+        closedLength_(0),
+        closedMtime_(0),
+        closedMtimeNs_(0) {}
 
     ~InodeWrapper() {}
 
@@ -120,6 +163,17 @@ class InodeWrapper : public std::enable_shared_from_this<InodeWrapper> {
         dirty_ = true;
     }
 
+    // the directory this inode is counted in by dir stats
+    uint64_t GetParent() const {
+        curve::common::UniqueLock lg(mtx_);
+        return inode_.parent();
+    }
+
+    void SetParent(uint64_t parent) {
+        curve::common::UniqueLock lg(mtx_);
+        inode_.set_parent(parent);
+    }
+
     Inode GetInodeUnlocked() const {
         return inode_;
     }
@@ -141,36 +195,17 @@ class InodeWrapper : public std::enable_shared_from_this<InodeWrapper> {
     }
 
     void GetInodeAttrUnLocked(struct stat *attr) {
-        memset(attr, 0, sizeof(*attr));
-        attr->st_ino = inode_.inodeid();
-        attr->st_mode = inode_.mode();
-        attr->st_nlink = inode_.nlink();
-        attr->st_uid = inode_.uid();
-        attr->st_gid = inode_.gid();
-        attr->st_size = inode_.length();
-        attr->st_rdev = inode_.rdev();
-        attr->st_atim.tv_sec = inode_.atime();
-        attr->st_atim.tv_nsec = inode_.atime_ns();
-        attr->st_mtim.tv_sec = inode_.mtime();
-        attr->st_mtim.tv_nsec = inode_.mtime_ns();
-        attr->st_ctim.tv_sec = inode_.ctime();
-        attr->st_ctim.tv_nsec = inode_.ctime_ns();
-        attr->st_blksize = kOptimalIOBlockSize;
-
-        switch (inode_.type()) {
-            case metaserver::TYPE_S3:
-                attr->st_blocks = (inode_.length() + 511) / 512;
-                break;
-            default:
-                attr->st_blocks = 0;
-                break;
-        }
-
+        InodeAttrToStat(inode_, attr);
         VLOG(6) << "GetInodeAttr attr =  " << *attr
                 << ", inodeid = " << inode_.inodeid();
         return;
     }
 
+    void GetInodeAttrLocked(InodeAttr *attr) {
+        curve::common::UniqueLock lg(mtx_);
+        curvefs::common::InodeToAttr(inode_, attr);
+    }
+
     void UpdateInode(const Inode &inode) {
         inode_ = inode;
         dirty_ = true;
@@ -181,6 +216,26 @@ class InodeWrapper : public std::enable_shared_from_this<InodeWrapper> {
         dirty_ = true;
     }
 
+    // update length and times after [off, off + size) is written.
+    // in kernel writeback cache mode, mtime and ctime are maintained by
+    // kernel and sent by setattr, while dirty pages may be written back
+    // long after that, so the times are not touched by writes.
+    void UpdateAfterWriteUnLocked(uint64_t off, uint64_t size,
+                                  bool writebackCache) {
+        if (inode_.length() < off + size) {
+            inode_.set_length(off + size);
+        }
+        if (!writebackCache) {
+            struct timespec now;
+            clock_gettime(CLOCK_REALTIME, &now);
+            inode_.set_mtime(now.tv_sec);
+            inode_.set_mtime_ns(now.tv_nsec);
+            inode_.set_ctime(now.tv_sec);
+            inode_.set_ctime_ns(now.tv_nsec);
+        }
+        dirty_ = true;
+    }
+
     curve::common::UniqueLock GetUniqueLock() {
         return curve::common::UniqueLock(mtx_);
     }
@@ -214,13 +269,34 @@ class InodeWrapper : public std::enable_shared_from_this<InodeWrapper> {
 
     void FlushS3ChunkInfoAsync();
 
+    // move dirty attributes and s3 chunk info to be appended of this inode
+    // into `request` of a batch flush, the syncing locks of the moved parts
+    // are held and should be released when the batch is done
+    void FlushToBatch(BatchUpdateInodeRequest *request, bool *syncingAttr,
+                      bool *syncingS3ChunkInfo);
+
     CURVEFS_ERROR RefreshS3ChunkInfo();
 
-    CURVEFS_ERROR Open();
+    // `keepCache` is set to true if the file is reopened within the open
+    // lease of the last close and not changed since then, by this client
+    // or others in metaserver, so the page cache of kernel is still valid
+    CURVEFS_ERROR Open(bool *keepCache = nullptr);
 
     bool IsOpen();
 
-    CURVEFS_ERROR Release();
+    // when the last reference is released, the open flag is kept in
+    // metaserver for `leaseMs`, so reopening the file within the lease
+    // needs no rpc. 0 means clear the open flag at once.
+    CURVEFS_ERROR Release(uint32_t leaseMs = 0);
+
+    bool IsOpenLeaseHeld() const {
+        return openLeaseHeld_;
+    }
+
+    // drop the open lease if it expires before `nowMs` (or anyway if
+    // `force`), the open flag is cleared and the inode becomes dirty.
+    // return true if the lease is dropped.
+    bool ReleaseOpenLease(uint64_t nowMs, bool force);
 
     void SetOpenCount(uint32_t openCount) {
         openCount_ = openCount;
@@ -250,6 +326,10 @@ class InodeWrapper : public std::enable_shared_from_this<InodeWrapper> {
         status_ = InodeStatus::Error;
     }
 
+    InodeStatus GetStatus() const {
+        return status_;
+    }
+
     void LockSyncingInode() const {
         syncingInodeMtx_.lock();
     }
@@ -277,6 +357,9 @@ class InodeWrapper : public std::enable_shared_from_this<InodeWrapper> {
  private:
     CURVEFS_ERROR SetOpenFlag(bool flag);
 
+    // whether the length and mtime in metaserver are the ones at close
+    bool UnchangedInMetaServer();
+
  private:
      Inode inode_;
      uint32_t openCount_;
@@ -288,6 +371,15 @@ class InodeWrapper : public std::enable_shared_from_this<InodeWrapper> {
      bool dirty_;
      mutable ::curve::common::Mutex mtx_;
 
+     // the open flag is still set in metaserver after the last close
+     bool openLeaseHeld_;
+     uint64_t openLeaseExpireMs_;
+     // length and mtime at the last close, to tell whether the file is
+     // changed when reopened within the lease
+     uint64_t closedLength_;
+     uint64_t closedMtime_;
+     uint32_t closedMtimeNs_;
+
      mutable ::curve::common::Mutex syncingInodeMtx_;
      mutable ::curve::common::Mutex syncingS3ChunkInfoMtx_;
 };
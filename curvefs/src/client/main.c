@@ -30,6 +30,7 @@ static const struct fuse_lowlevel_ops curve_ll_oper = {
     .lookup     = FuseOpLookup,
     .rename     = FuseOpRename,
     .write      = FuseOpWrite,
+    .write_buf  = FuseOpWriteBuf,
     .read       = FuseOpRead,
     .open       = FuseOpOpen,
     .create     = FuseOpCreate,
@@ -44,9 +45,11 @@ static const struct fuse_lowlevel_ops curve_ll_oper = {
     .symlink    = FuseOpSymlink,
     .link       = FuseOpLink,
     .readlink   = FuseOpReadLink,
+    .getxattr   = FuseOpGetXattr,
     .release    = FuseOpRelease,
     .fsync      = FuseOpFsync,
     .releasedir = FuseOpReleaseDir,
+    .readdirplus = FuseOpReadDirPlus,
 };
 
 int main(int argc, char *argv[]) {
@@ -69,14 +69,22 @@ struct MetaServerClientMetric {
 
     // inode
     InterfaceMetric getInode;
+    InterfaceMetric batchGetInodeAttr;
     InterfaceMetric createInode;
     InterfaceMetric updateInode;
+    InterfaceMetric batchUpdateInode;
     InterfaceMetric deleteInode;
     InterfaceMetric createRootInode;
     InterfaceMetric appendS3ChunkInfo;
+    InterfaceMetric updateDirStat;
+
+    // inode and dentry
+    InterfaceMetric createInodeAndDentry;
+    InterfaceMetric unlinkDentryAndDecNlink;
 
     // tnx
     InterfaceMetric prepareRenameTx;
+    InterfaceMetric rename;
 
     // partition
     InterfaceMetric createPartition;
@@ -88,12 +96,18 @@ struct MetaServerClientMetric {
           getDentry(prefix, "getDentry"), listDentry(prefix, "listDentry"),
           createDentry(prefix, "createDentry"),
           deleteDentry(prefix, "deleteDentry"), getInode(prefix, "getInode"),
+          batchGetInodeAttr(prefix, "batchGetInodeAttr"),
           createInode(prefix, "createInode"),
           updateInode(prefix, "updateInode"),
+          batchUpdateInode(prefix, "batchUpdateInode"),
           deleteInode(prefix, "deleteInode"),
           createRootInode(prefix, "createRootInode"),
           appendS3ChunkInfo(prefix, "appendS3ChunkInfo"),
+          updateDirStat(prefix, "updateDirStat"),
+          createInodeAndDentry(prefix, "createInodeAndDentry"),
+          unlinkDentryAndDecNlink(prefix, "unlinkDentryAndDecNlink"),
           prepareRenameTx(prefix, "prepareRenameTx"),
+          rename(prefix, "rename"),
           createPartition(prefix, "createPartition") {}
 };
 
@@ -139,10 +153,15 @@ struct DiskCacheMetric {
 
     std::string fsName;
     InterfaceMetric writeS3;
+    // async writes of the io threads, latency includes the queueing
+    InterfaceMetric asyncWrite;
+    bvar::Adder<int64_t> asyncPending;
     explicit DiskCacheMetric(const std::string &name = "")
         : fsName(!name.empty() ? name
                                : prefix + curve::common::ToHexString(this)),
-          writeS3(prefix, fsName + "_write_s3") {}
+          writeS3(prefix, fsName + "_write_s3"),
+          asyncWrite(prefix, fsName + "_async_write"),
+          asyncPending(prefix, fsName + "_async_pending") {}
 };
 
 }  // namespace metric
@@ -39,8 +39,14 @@
 namespace curvefs {
 namespace client {
 namespace rpcclient {
+using curvefs::metaserver::BatchGetInodeAttrRequest;
+using curvefs::metaserver::BatchGetInodeAttrResponse;
+using curvefs::metaserver::BatchUpdateInodeRequest;
+using curvefs::metaserver::BatchUpdateInodeResponse;
 using curvefs::metaserver::CreateDentryRequest;
 using curvefs::metaserver::CreateDentryResponse;
+using curvefs::metaserver::CreateInodeAndDentryRequest;
+using curvefs::metaserver::CreateInodeAndDentryResponse;
 using curvefs::metaserver::CreateInodeRequest;
 using curvefs::metaserver::CreateInodeResponse;
 using curvefs::metaserver::DeleteDentryRequest;
@@ -54,10 +60,17 @@ using curvefs::metaserver::GetDentryResponse;
 using curvefs::metaserver::GetInodeRequest;
 using curvefs::metaserver::GetInodeResponse;
 using curvefs::metaserver::Inode;
+using curvefs::metaserver::InodeS3ChunkInfoAdd;
 using curvefs::metaserver::ListDentryRequest;
 using curvefs::metaserver::ListDentryResponse;
 using curvefs::metaserver::PrepareRenameTxRequest;
 using curvefs::metaserver::PrepareRenameTxResponse;
+using curvefs::metaserver::RenameRequest;
+using curvefs::metaserver::RenameResponse;
+using curvefs::metaserver::UnlinkDentryAndDecNlinkRequest;
+using curvefs::metaserver::UnlinkDentryAndDecNlinkResponse;
+using curvefs::metaserver::UpdateDirStatRequest;
+using curvefs::metaserver::UpdateDirStatResponse;
 using curvefs::metaserver::UpdateInodeRequest;
 using curvefs::metaserver::UpdateInodeResponse;
 
@@ -116,13 +129,15 @@ struct InodeParam {
     FsFileType type;
     uint64_t rdev;
     std::string symlink;
+    // parent of the new inode, 0 if unknown
+    uint64_t parent = 0;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const InodeParam& p) {
     os << "fsid: " << p.fsId << ", length: " << p.length << ", uid: " << p.uid
        << ", gid: " << p.gid << ", mode: " << p.mode << ", type: " << p.type
        << ", rdev: " << p.rdev
-       << ", symlink: " << p.symlink;
+       << ", symlink: " << p.symlink << ", parent: " << p.parent;
 
     return os;
 }
@@ -20,6 +20,7 @@
  * Author: lixiaocui
  */
 
+#include <algorithm>
 #include <iterator>
 #include <vector>
 #include <map>
@@ -34,9 +35,12 @@ namespace curvefs {
 namespace client {
 namespace rpcclient {
 
+// the renames committed concurrently may return out of order,
+// the txid of a partition never goes back
 void MetaCache::SetTxId(uint32_t partitionId, uint64_t txId) {
     WriteLockGuard w(txIdLock_);
-    partitionTxId_[partitionId] = txId;
+    auto& current = partitionTxId_[partitionId];
+    current = std::max(current, txId);
 }
 
 void MetaCache::GetTxId(uint32_t partitionId, uint64_t *txId) {
@@ -47,6 +51,19 @@ void MetaCache::GetTxId(uint32_t partitionId, uint64_t *txId) {
     }
 }
 
+bool MetaCache::RefreshTxId(uint32_t fsId) {
+    PatitionInfoList partitionInfos;
+    if (!mdsClient_->ListPartition(fsId, &partitionInfos)) {
+        LOG(ERROR) << "list partition for {fsid:" << fsId << "} fail";
+        return false;
+    }
+
+    for (const auto &partition : partitionInfos) {
+        SetTxId(partition.partitionid(), partition.txid());
+    }
+    return true;
+}
+
 bool MetaCache::GetTxId(uint32_t fsId, uint64_t inodeId, uint32_t *partitionId,
                         uint64_t *txId) {
     for (const auto &partition : partitionInfos_) {
@@ -60,6 +77,34 @@ bool MetaCache::GetTxId(uint32_t fsId, uint64_t inodeId, uint32_t *partitionId,
     return false;
 }
 
+bool MetaCache::GroupInodesByPartition(
+    uint32_t fsID, const std::set<uint64_t> &inodeIDs,
+    std::map<uint32_t, std::vector<uint64_t>> *groups) {
+    // list infos from mds
+    if (!ListPartitions(fsID)) {
+        LOG(ERROR) << "group inodes for {fsid:" << fsID
+                   << "} fail, partition list not exist";
+        return false;
+    }
+
+    ReadLockGuard rl(rwlock4Partitions_);
+    for (const auto &inodeID : inodeIDs) {
+        auto iter = std::find_if(
+            partitionInfos_.begin(), partitionInfos_.end(),
+            [inodeID](const PartitionInfo &partition) {
+                return partition.start() <= inodeID &&
+                       partition.end() >= inodeID;
+            });
+        if (iter == partitionInfos_.end()) {
+            LOG(WARNING) << "{fsid:" << fsID << ", inodeid:" << inodeID
+                         << "} do not find partition";
+            continue;
+        }
+        (*groups)[iter->partitionid()].push_back(inodeID);
+    }
+    return true;
+}
+
 bool MetaCache::GetTarget(uint32_t fsID, uint64_t inodeID,
                           CopysetTarget *target, uint64_t *applyIndex,
                           bool refresh) {
@@ -31,6 +31,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <set>
 
 #include "curvefs/proto/common.pb.h"
 #include "curvefs/src/client/common/common.h"
@@ -120,6 +121,15 @@ class MetaCache {
     virtual bool GetTxId(uint32_t fsId, uint64_t inodeId, uint32_t *partitionId,
                          uint64_t *txId);
 
+    // get the txids committed on mds, used when a commit is unknown
+    virtual bool RefreshTxId(uint32_t fsId);
+
+    // group inodes by the partition they belong to, inodes not in any
+    // partition are left out
+    virtual bool GroupInodesByPartition(
+        uint32_t fsID, const std::set<uint64_t> &inodeIDs,
+        std::map<uint32_t, std::vector<uint64_t>> *groups);
+
     virtual bool GetTarget(uint32_t fsID, uint64_t inodeID,
                            CopysetTarget *target, uint64_t *applyIndex,
                            bool refresh = false);
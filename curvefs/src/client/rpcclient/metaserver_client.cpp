@@ -22,7 +22,10 @@
 
 #include "curvefs/src/client/rpcclient/metaserver_client.h"
 
+#include <butil/fast_rand.h>
+
 #include <algorithm>
+#include <map>
 #include <vector>
 
 using curvefs::metaserver::GetOrModifyS3ChunkInfoRequest;
@@ -39,7 +42,12 @@ using PrepareRenameTxExcutor = TaskExecutor;
 using DeleteInodeExcutor = TaskExecutor;
 using UpdateInodeExcutor = TaskExecutor;
 using GetInodeExcutor = TaskExecutor;
+using BatchGetInodeAttrExcutor = TaskExecutor;
 using GetOrModifyS3ChunkInfoExcutor = TaskExecutor;
+using BatchUpdateInodeExcutor = TaskExecutor;
+using UnlinkDentryAndDecNlinkExcutor = TaskExecutor;
+using RenameExcutor = TaskExecutor;
+using UpdateDirStatExcutor = TaskExecutor;
 
 MetaStatusCode MetaServerClientImpl::Init(
     const ExcutorOpt &excutorOpt, std::shared_ptr<MetaCache> metaCache,
@@ -87,6 +95,10 @@ void MetaServerClientImpl::SetTxId(uint32_t partitionId, uint64_t txId) {
     metaCache_->SetTxId(partitionId, txId);
 }
 
+bool MetaServerClientImpl::RefreshTxId(uint32_t fsId) {
+    return metaCache_->RefreshTxId(fsId);
+}
+
 MetaStatusCode MetaServerClientImpl::GetDentry(uint32_t fsId, uint64_t inodeid,
                                                const std::string &name,
                                                Dentry *out) {
@@ -101,6 +113,7 @@ MetaStatusCode MetaServerClientImpl::GetDentry(uint32_t fsId, uint64_t inodeid,
         request.set_parentinodeid(inodeid);
         request.set_name(name);
         request.set_txid(txId);
+        request.set_appliedindex(applyIndex);
 
         curvefs::metaserver::MetaServerService_Stub stub(channel);
         stub.GetDentry(cntl, &request, &response, nullptr);
@@ -162,6 +175,7 @@ MetaStatusCode MetaServerClientImpl::ListDentry(uint32_t fsId, uint64_t inodeid,
         request.set_txid(txId);
         request.set_last(last);
         request.set_count(count);
+        request.set_appliedindex(applyIndex);
 
         curvefs::metaserver::MetaServerService_Stub stub(channel);
         stub.ListDentry(cntl, &request, &response, nullptr);
@@ -390,6 +404,7 @@ MetaStatusCode MetaServerClientImpl::GetInode(uint32_t fsId, uint64_t inodeid,
         request.set_partitionid(partitionID);
         request.set_fsid(fsId);
         request.set_inodeid(inodeid);
+        request.set_appliedindex(applyIndex);
 
         curvefs::metaserver::MetaServerService_Stub stub(channel);
         stub.GetInode(cntl, &request, &response, nullptr);
@@ -434,6 +449,102 @@ MetaStatusCode MetaServerClientImpl::GetInode(uint32_t fsId, uint64_t inodeid,
     return ConvertToMetaStatusCode(excutor.DoRPCTask());
 }
 
+MetaStatusCode MetaServerClientImpl::BatchGetInodeAttr(
+    uint32_t fsId, const std::set<uint64_t> &inodeIds,
+    std::list<InodeAttr> *attrs) {
+    // group inodes by partition, the partitions are resolved together
+    std::map<uint32_t, std::vector<uint64_t>> groups;
+    if (!metaCache_->GroupInodesByPartition(fsId, inodeIds, &groups)) {
+        LOG(WARNING) << "BatchGetInodeAttr: group inodes by partition fail"
+                     << ", fsId = " << fsId;
+        return MetaStatusCode::RPC_ERROR;
+    }
+
+    for (const auto &group : groups) {
+        MetaStatusCode ret =
+            BatchGetInodeAttrInPartition(fsId, group.second, attrs);
+        if (ret != MetaStatusCode::OK) {
+            return ret;
+        }
+    }
+    return MetaStatusCode::OK;
+}
+
+MetaStatusCode MetaServerClientImpl::BatchGetInodeAttrInPartition(
+    uint32_t fsId, const std::vector<uint64_t> &inodeIds,
+    std::list<InodeAttr> *attrs) {
+    auto task = RPCTask {
+        metaserverClientMetric_->batchGetInodeAttr.qps.count << 1;
+        BatchGetInodeAttrRequest request;
+        BatchGetInodeAttrResponse response;
+        request.set_poolid(poolID);
+        request.set_copysetid(copysetID);
+        request.set_partitionid(partitionID);
+        request.set_fsid(fsId);
+        request.set_appliedindex(applyIndex);
+        *request.mutable_inodeid() = {inodeIds.begin(), inodeIds.end()};
+
+        curvefs::metaserver::MetaServerService_Stub stub(channel);
+        stub.BatchGetInodeAttr(cntl, &request, &response, nullptr);
+
+        if (cntl->Failed()) {
+            metaserverClientMetric_->batchGetInodeAttr.eps.count << 1;
+            LOG(WARNING) << "BatchGetInodeAttr Failed, errorcode = "
+                         << cntl->ErrorCode()
+                         << ", error content:" << cntl->ErrorText()
+                         << ", log id = " << cntl->log_id();
+            return -cntl->ErrorCode();
+        }
+
+        MetaStatusCode ret = response.statuscode();
+        if (ret != MetaStatusCode::OK) {
+            LOG(WARNING) << "BatchGetInodeAttr: fsId = " << fsId
+                         << ", first inodeid = " << inodeIds.front()
+                         << ", count = " << inodeIds.size()
+                         << ", errcode = " << ret
+                         << ", errmsg = " << MetaStatusCode_Name(ret);
+        } else if (response.has_appliedindex()) {
+            metaCache_->UpdateApplyIndex(CopysetGroupID(poolID, copysetID),
+                                         response.appliedindex());
+            for (auto &attr : *response.mutable_attr()) {
+                attrs->emplace_back();
+                attrs->back().Swap(&attr);
+            }
+        } else {
+            LOG(WARNING) << "BatchGetInodeAttr: fsId = " << fsId
+                         << ", first inodeid = " << inodeIds.front()
+                         << " ok, but applyIndex not set in response: "
+                         << response.ShortDebugString();
+            return -1;
+        }
+        return ret;
+    };
+
+    auto taskCtx = std::make_shared<TaskContext>(
+        MetaServerOpType::BatchGetInodeAttr, task, fsId, inodeIds.front());
+    BatchGetInodeAttrExcutor excutor(opt_, metaCache_, channelManager_,
+                                     taskCtx);
+    return ConvertToMetaStatusCode(excutor.DoRPCTask());
+}
+
+void FillUpdateInodeRequest(const Inode &inode, UpdateInodeRequest *request) {
+    request->set_inodeid(inode.inodeid());
+    request->set_fsid(inode.fsid());
+    request->set_length(inode.length());
+    request->set_ctime(inode.ctime());
+    request->set_mtime(inode.mtime());
+    request->set_atime(inode.atime());
+    request->set_uid(inode.uid());
+    request->set_gid(inode.gid());
+    request->set_mode(inode.mode());
+    request->set_nlink(inode.nlink());
+    request->set_openflag(inode.openflag());
+    if (inode.has_volumeextentlist()) {
+        request->mutable_volumeextentlist()->CopyFrom(
+            inode.volumeextentlist());
+    }
+}
+
 MetaStatusCode MetaServerClientImpl::UpdateInode(const Inode &inode) {
     auto task = RPCTask {
         metaserverClientMetric_->updateInode.qps.count << 1;
@@ -442,23 +553,7 @@ MetaStatusCode MetaServerClientImpl::UpdateInode(const Inode &inode) {
         request.set_poolid(poolID);
         request.set_copysetid(copysetID);
         request.set_partitionid(partitionID);
-        request.set_inodeid(inode.inodeid());
-        request.set_fsid(inode.fsid());
-        request.set_length(inode.length());
-        request.set_ctime(inode.ctime());
-        request.set_mtime(inode.mtime());
-        request.set_atime(inode.atime());
-        request.set_uid(inode.uid());
-        request.set_gid(inode.gid());
-        request.set_mode(inode.mode());
-        request.set_nlink(inode.nlink());
-        request.set_openflag(inode.openflag());
-        if (inode.has_volumeextentlist()) {
-            curvefs::metaserver::VolumeExtentList *vlist =
-                new curvefs::metaserver::VolumeExtentList;
-            vlist->CopyFrom(inode.volumeextentlist());
-            request.set_allocated_volumeextentlist(vlist);
-        }
+        FillUpdateInodeRequest(inode, &request);
         curvefs::metaserver::MetaServerService_Stub stub(channel);
         stub.UpdateInode(cntl, &request, &response, nullptr);
 
@@ -556,23 +651,7 @@ void MetaServerClientImpl::UpdateInodeAsync(const Inode &inode,
         request.set_poolid(poolID);
         request.set_copysetid(copysetID);
         request.set_partitionid(partitionID);
-        request.set_inodeid(inode.inodeid());
-        request.set_fsid(inode.fsid());
-        request.set_length(inode.length());
-        request.set_ctime(inode.ctime());
-        request.set_mtime(inode.mtime());
-        request.set_atime(inode.atime());
-        request.set_uid(inode.uid());
-        request.set_gid(inode.gid());
-        request.set_mode(inode.mode());
-        request.set_nlink(inode.nlink());
-        request.set_openflag(inode.openflag());
-        if (inode.has_volumeextentlist()) {
-            curvefs::metaserver::VolumeExtentList *vlist =
-                new curvefs::metaserver::VolumeExtentList;
-            vlist->CopyFrom(inode.volumeextentlist());
-            request.set_allocated_volumeextentlist(vlist);
-        }
+        FillUpdateInodeRequest(inode, &request);
 
         auto *rpcDone = new UpdateInodeRpcDone(taskExecutorDone,
             metaserverClientMetric_);
@@ -616,6 +695,10 @@ MetaStatusCode MetaServerClientImpl::GetOrModifyS3ChunkInfo(
         request.set_inodeid(inodeId);
         request.set_returns3chunkinfomap(returnS3ChunkInfoMap);
         *(request.mutable_s3chunkinfoadd()) = s3ChunkInfos;
+        // the request only gets s3 chunk info can be served by leader lease
+        if (s3ChunkInfos.empty()) {
+            request.set_appliedindex(applyIndex);
+        }
 
         curvefs::metaserver::MetaServerService_Stub stub(channel);
         stub.GetOrModifyS3ChunkInfo(cntl, &request, &response, nullptr);
@@ -759,6 +842,109 @@ void MetaServerClientImpl::GetOrModifyS3ChunkInfoAsync(
     taskDone_guard.release();
 }
 
+class BatchUpdateInodeRpcDone : public MetaServerClientRpcDoneBase {
+ public:
+    BatchUpdateInodeRpcDone(TaskExecutorDone *done,
+        const std::shared_ptr<MetaServerClientMetric> &metaserverClientMetric,
+        BatchUpdateInodeResponse *out):
+        MetaServerClientRpcDoneBase(done, metaserverClientMetric),
+        out_(out) {}
+    virtual ~BatchUpdateInodeRpcDone() {}
+    void Run() override;
+    BatchUpdateInodeResponse response;
+
+ private:
+    BatchUpdateInodeResponse *out_;
+};
+
+void BatchUpdateInodeRpcDone::Run() {
+    std::unique_ptr<BatchUpdateInodeRpcDone> self_guard(this);
+    brpc::ClosureGuard done_guard(done_);
+    auto taskCtx = done_->GetTaskExcutor()->GetTaskCxt();
+    auto& cntl = taskCtx->cntl_;
+    auto metaCache = done_->GetTaskExcutor()->GetMetaCache();
+    if (cntl.Failed()) {
+        metaserverClientMetric_->batchUpdateInode.eps.count << 1;
+        LOG(WARNING) << "BatchUpdateInode Failed, errorcode = "
+                     << cntl.ErrorCode()
+                     << ", error content: " << cntl.ErrorText()
+                     << ", log id: " << cntl.log_id();
+        done_->SetRetCode(-cntl.ErrorCode());
+        return;
+    }
+
+    out_->CopyFrom(response);
+    MetaStatusCode ret = response.statuscode();
+    if (ret != MetaStatusCode::OK) {
+        LOG(WARNING) << "BatchUpdateInode, first inodeId: "
+                     << taskCtx->inodeID
+                     << ", fsId: " << taskCtx->fsID
+                     << ", errcode = " << ret
+                     << ", errmsg = " << MetaStatusCode_Name(ret);
+    } else if (response.has_appliedindex()) {
+        metaCache->UpdateApplyIndex(taskCtx->target.groupID,
+                                     response.appliedindex());
+    } else {
+        LOG(WARNING) << "BatchUpdateInode, first inodeId: "
+                     << taskCtx->inodeID
+                     << ", fsId: " << taskCtx->fsID
+                     << " ok, but applyIndex not set in response: "
+                     << response.DebugString();
+        done_->SetRetCode(-1);
+        return;
+    }
+
+    VLOG(6) << "BatchUpdateInode success, "
+            << "response: " << response.DebugString();
+    done_->SetRetCode(ret);
+    return;
+}
+
+void MetaServerClientImpl::BatchUpdateInodeAsync(
+    const BatchUpdateInodeRequest &request, BatchUpdateInodeResponse *response,
+    MetaServerClientDone *done) {
+    // all inodes are in the same partition, route by any one of them
+    uint64_t inodeId = request.updateinode_size() > 0
+                           ? request.updateinode(0).inodeid()
+                           : request.s3chunkinfoadd(0).inodeid();
+
+    auto task = AsyncRPCTask {
+        metaserverClientMetric_->batchUpdateInode.qps.count << 1;
+
+        BatchUpdateInodeRequest batchRequest(request);
+        batchRequest.set_poolid(poolID);
+        batchRequest.set_copysetid(copysetID);
+        batchRequest.set_partitionid(partitionID);
+        for (auto &update : *batchRequest.mutable_updateinode()) {
+            update.set_poolid(poolID);
+            update.set_copysetid(copysetID);
+            update.set_partitionid(partitionID);
+        }
+
+        auto *rpcDone = new BatchUpdateInodeRpcDone(taskExecutorDone,
+            metaserverClientMetric_, response);
+
+        curvefs::metaserver::MetaServerService_Stub stub(channel);
+        stub.BatchUpdateInode(cntl, &batchRequest, &rpcDone->response,
+                              rpcDone);
+        return MetaStatusCode::OK;
+    };
+
+    auto taskCtx = std::make_shared<TaskContext>(
+        MetaServerOpType::BatchUpdateInode, task, request.fsid(), inodeId);
+    auto excutor = std::make_shared<BatchUpdateInodeExcutor>(opt_,
+        metaCache_, channelManager_, taskCtx);
+    TaskExecutorDone *taskDone = new TaskExecutorDone(
+        excutor, done);
+    brpc::ClosureGuard taskDone_guard(taskDone);
+    int ret = excutor->DoAsyncRPCTask(taskDone);
+    if (ret < 0) {
+        taskDone->SetRetCode(ret);
+        return;
+    }
+    taskDone_guard.release();
+}
+
 MetaStatusCode MetaServerClientImpl::CreateInode(const InodeParam &param,
                                                  Inode *out) {
     auto task = RPCTask {
@@ -776,6 +962,9 @@ MetaStatusCode MetaServerClientImpl::CreateInode(const InodeParam &param,
         request.set_type(param.type);
         request.set_rdev(param.rdev);
         request.set_symlink(param.symlink);
+        if (param.parent != 0) {
+            request.set_parent(param.parent);
+        }
         curvefs::metaserver::MetaServerService_Stub stub(channel);
         stub.CreateInode(cntl, &request, &response, nullptr);
 
@@ -871,6 +1060,309 @@ MetaStatusCode MetaServerClientImpl::DeleteInode(uint32_t fsId,
     return ConvertToMetaStatusCode(excutor.DoRPCTask());
 }
 
+MetaStatusCode MetaServerClientImpl::CreateInodeAndDentry(
+    const InodeParam &param, Dentry *dentry, Inode *out) {
+    // the same id is sent by the retries, so the metaserver recognizes the
+    // retry of the request which has created the inode and dentry
+    const uint64_t requestId = butil::fast_rand();
+    auto task = RPCTask {
+        metaserverClientMetric_->createInodeAndDentry.qps.count << 1;
+        CreateInodeAndDentryResponse response;
+        CreateInodeAndDentryRequest request;
+        request.set_poolid(poolID);
+        request.set_copysetid(copysetID);
+        request.set_partitionid(partitionID);
+        request.set_fsid(param.fsId);
+        request.set_length(param.length);
+        request.set_uid(param.uid);
+        request.set_gid(param.gid);
+        request.set_mode(param.mode);
+        request.set_type(param.type);
+        request.set_rdev(param.rdev);
+        request.set_symlink(param.symlink);
+        request.set_parentinodeid(dentry->parentinodeid());
+        request.set_name(dentry->name());
+        request.set_txid(txId);
+        if (dentry->has_flag()) {
+            request.set_flag(dentry->flag());
+        }
+        request.set_requestid(requestId);
+        curvefs::metaserver::MetaServerService_Stub stub(channel);
+        stub.CreateInodeAndDentry(cntl, &request, &response, nullptr);
+
+        if (cntl->Failed()) {
+            metaserverClientMetric_->createInodeAndDentry.eps.count << 1;
+            LOG(WARNING) << "CreateInodeAndDentry Failed, errorcode = "
+                         << cntl->ErrorCode()
+                         << ", error content:" << cntl->ErrorText()
+                         << ", log id = " << cntl->log_id();
+            return -cntl->ErrorCode();
+        }
+
+        MetaStatusCode ret = response.statuscode();
+        if (ret != MetaStatusCode::OK) {
+            LOG(WARNING) << "CreateInodeAndDentry:  param = " << param
+                         << ", parent = " << dentry->parentinodeid()
+                         << ", name = " << dentry->name()
+                         << ", errcode = " << ret
+                         << ", errmsg = " << MetaStatusCode_Name(ret)
+                         << ", pool: " << poolID << ", copyset: " << copysetID
+                         << ", partition: " << partitionID;
+        } else if (response.has_inode() && response.has_appliedindex()) {
+            *out = response.inode();
+            dentry->set_inodeid(out->inodeid());
+            dentry->set_txid(txId);
+
+            metaCache_->UpdateApplyIndex(CopysetGroupID(poolID, copysetID),
+                                         response.appliedindex());
+        } else {
+            LOG(WARNING) << "CreateInodeAndDentry:  param = " << param
+                         << " ok, but applyIndex or inode not set in response:"
+                         << response.DebugString();
+            return -1;
+        }
+
+        VLOG(6) << "CreateInodeAndDentry success, request: "
+                << request.DebugString()
+                << "response: " << response.DebugString();
+        return ret;
+    };
+
+    auto taskCtx = std::make_shared<TaskContext>(
+        MetaServerOpType::CreateInodeAndDentry, task, param.fsId,
+        dentry->parentinodeid());
+    CreateInodeAndDentryExcutor excutor(opt_, metaCache_, channelManager_,
+                                        taskCtx);
+    return ConvertToMetaStatusCode(excutor.DoRPCTask());
+}
+
+MetaStatusCode MetaServerClientImpl::UnlinkDentryAndDecNlink(
+    uint32_t fsId, uint64_t parentInodeId, const std::string &name,
+    uint64_t inodeid) {
+    // the inode must be in the partition of parent, don't bother metaserver
+    // if the partitions we known tell it's not
+    uint32_t parentPartition = 0;
+    uint32_t partition = 0;
+    uint64_t unused;
+    if (!metaCache_->GetTxId(fsId, parentInodeId, &parentPartition,
+                             &unused) ||
+        !metaCache_->GetTxId(fsId, inodeid, &partition, &unused) ||
+        parentPartition != partition) {
+        return MetaStatusCode::PARTITION_ID_MISSMATCH;
+    }
+
+    auto task = RPCTask {
+        metaserverClientMetric_->unlinkDentryAndDecNlink.qps.count << 1;
+        UnlinkDentryAndDecNlinkResponse response;
+        UnlinkDentryAndDecNlinkRequest request;
+        request.set_poolid(poolID);
+        request.set_copysetid(copysetID);
+        request.set_partitionid(partitionID);
+        request.set_fsid(fsId);
+        request.set_txid(txId);
+        request.set_parentinodeid(parentInodeId);
+        request.set_name(name);
+        request.set_inodeid(inodeid);
+
+        curvefs::metaserver::MetaServerService_Stub stub(channel);
+        stub.UnlinkDentryAndDecNlink(cntl, &request, &response, nullptr);
+
+        if (cntl->Failed()) {
+            metaserverClientMetric_->unlinkDentryAndDecNlink.eps.count << 1;
+            LOG(WARNING) << "UnlinkDentryAndDecNlink Failed, errorcode = "
+                         << cntl->ErrorCode()
+                         << ", error content:" << cntl->ErrorText()
+                         << ", log id = " << cntl->log_id();
+            return -cntl->ErrorCode();
+        }
+
+        MetaStatusCode ret = response.statuscode();
+        if (ret != MetaStatusCode::OK) {
+            LOG(WARNING) << "UnlinkDentryAndDecNlink:  fsid = " << fsId
+                         << ", parent = " << parentInodeId
+                         << ", name = " << name << ", inodeid = " << inodeid
+                         << ", errcode = " << ret
+                         << ", errmsg = " << MetaStatusCode_Name(ret);
+        } else if (response.has_appliedindex()) {
+            metaCache_->UpdateApplyIndex(CopysetGroupID(poolID, copysetID),
+                                         response.appliedindex());
+        } else {
+            LOG(WARNING) << "UnlinkDentryAndDecNlink:  fsid = " << fsId
+                         << ", parent = " << parentInodeId
+                         << ", name = " << name
+                         << " ok, but applyIndex not set in response:"
+                         << response.DebugString();
+            return -1;
+        }
+
+        VLOG(6) << "UnlinkDentryAndDecNlink success, request: "
+                << request.DebugString()
+                << "response: " << response.DebugString();
+        return ret;
+    };
+
+    auto taskCtx = std::make_shared<TaskContext>(
+        MetaServerOpType::UnlinkDentryAndDecNlink, task, fsId, parentInodeId);
+    UnlinkDentryAndDecNlinkExcutor excutor(opt_, metaCache_, channelManager_,
+                                           taskCtx);
+    return ConvertToMetaStatusCode(excutor.DoRPCTask());
+}
+
+MetaStatusCode MetaServerClientImpl::Rename(const Dentry &dentry,
+                                            const Dentry &newDentry,
+                                            uint64_t *txId,
+                                            uint64_t *dstTxId) {
+    auto task = RPCTask {
+        metaserverClientMetric_->rename.qps.count << 1;
+
+        // the leader of destination partition is told to the coordinator,
+        // which prepares the transaction on it
+        CopysetTarget dstTarget;
+        uint64_t dstApplyIndex = 0;
+        if (!metaCache_->GetTarget(newDentry.fsid(),
+                                   newDentry.parentinodeid(), &dstTarget,
+                                   &dstApplyIndex)) {
+            LOG(WARNING) << "Rename: get target of destination failed"
+                         << ", newDentry = " << newDentry.ShortDebugString();
+            return MetaStatusCode::RPC_ERROR;
+        }
+
+        RenameRequest request;
+        RenameResponse response;
+        request.set_poolid(poolID);
+        request.set_copysetid(copysetID);
+        request.set_partitionid(partitionID);
+        *request.mutable_dentry() = dentry;
+        *request.mutable_newdentry() = newDentry;
+        request.set_dstpoolid(dstTarget.groupID.poolID);
+        request.set_dstcopysetid(dstTarget.groupID.copysetID);
+        request.set_dstpartitionid(dstTarget.partitionID);
+        request.set_dstleaderaddr(
+            butil::endpoint2str(dstTarget.endPoint).c_str());
+
+        curvefs::metaserver::MetaServerService_Stub stub(channel);
+        stub.Rename(cntl, &request, &response, nullptr);
+
+        if (cntl->Failed()) {
+            metaserverClientMetric_->rename.eps.count << 1;
+            LOG(WARNING) << "Rename failed"
+                         << ", errorCode = " << cntl->ErrorCode()
+                         << ", errorText = " << cntl->ErrorText()
+                         << ", logId = " << cntl->log_id();
+            return -cntl->ErrorCode();
+        }
+
+        auto rc = response.statuscode();
+        if (rc == MetaStatusCode::TX_COMMIT_UNKNOWN) {
+            // the txids tried are returned if the commit is unknown
+            LOG(WARNING) << "Rename: commit unknown, response: "
+                         << response.ShortDebugString();
+            if (response.has_txid() && response.has_dsttxid()) {
+                *txId = response.txid();
+                *dstTxId = response.dsttxid();
+            }
+        } else if (rc != MetaStatusCode::OK) {
+            LOG(WARNING) << "Rename: retCode = " << rc
+                         << ", message = " << MetaStatusCode_Name(rc);
+        } else if (response.has_appliedindex() && response.has_txid() &&
+                   response.has_dsttxid()) {
+            metaCache_->UpdateApplyIndex(CopysetGroupID(poolID, copysetID),
+                                         response.appliedindex());
+            *txId = response.txid();
+            *dstTxId = response.dsttxid();
+        } else {
+            LOG(WARNING) << "Rename OK"
+                         << ", but applyIndex or txid not set in response:"
+                         << response.DebugString();
+            return -1;
+        }
+
+        VLOG(6) << "Rename success, request: " << request.DebugString()
+                << "response: " << response.DebugString();
+        return rc;
+    };
+
+    auto taskCtx = std::make_shared<TaskContext>(
+        MetaServerOpType::Rename, task, dentry.fsid(), dentry.parentinodeid());
+    RenameExcutor excutor(opt_, metaCache_, channelManager_, taskCtx);
+    return ConvertToMetaStatusCode(excutor.DoRPCTask());
+}
+
+MetaStatusCode MetaServerClientImpl::UpdateDirStat(uint32_t fsId,
+                                                   uint64_t inodeId,
+                                                   const DirStat &delta,
+                                                   uint64_t requestId,
+                                                   uint64_t newParent,
+                                                   uint64_t *parent,
+                                                   DirStat *stat) {
+    auto task = RPCTask {
+        metaserverClientMetric_->updateDirStat.qps.count << 1;
+        UpdateDirStatResponse response;
+        UpdateDirStatRequest request;
+        request.set_poolid(poolID);
+        request.set_copysetid(copysetID);
+        request.set_partitionid(partitionID);
+        request.set_fsid(fsId);
+        request.set_inodeid(inodeId);
+        if (delta.bytes() != 0 || delta.files() != 0 ||
+            delta.subdirs() != 0) {
+            *request.mutable_delta() = delta;
+            if (requestId != 0) {
+                request.set_requestid(requestId);
+            }
+        }
+        if (newParent != 0) {
+            request.set_parent(newParent);
+        }
+
+        curvefs::metaserver::MetaServerService_Stub stub(channel);
+        stub.UpdateDirStat(cntl, &request, &response, nullptr);
+
+        if (cntl->Failed()) {
+            metaserverClientMetric_->updateDirStat.eps.count << 1;
+            LOG(WARNING) << "UpdateDirStat Failed, errorcode = "
+                         << cntl->ErrorCode()
+                         << ", error content:" << cntl->ErrorText()
+                         << ", log id = " << cntl->log_id();
+            return -cntl->ErrorCode();
+        }
+
+        MetaStatusCode ret = response.statuscode();
+        if (ret != MetaStatusCode::OK) {
+            LOG(WARNING) << "UpdateDirStat:  fsid = " << fsId
+                         << ", inodeid = " << inodeId
+                         << ", errcode = " << ret
+                         << ", errmsg = " << MetaStatusCode_Name(ret);
+        } else if (response.has_appliedindex()) {
+            metaCache_->UpdateApplyIndex(CopysetGroupID(poolID, copysetID),
+                                         response.appliedindex());
+            *parent = response.parent();
+            if (stat != nullptr) {
+                if (response.has_stat()) {
+                    *stat = response.stat();
+                } else {
+                    stat->Clear();
+                }
+            }
+        } else {
+            LOG(WARNING) << "UpdateDirStat:  fsid = " << fsId
+                         << ", inodeid = " << inodeId
+                         << " ok, but applyIndex not set in response:"
+                         << response.DebugString();
+            return -1;
+        }
+
+        VLOG(6) << "UpdateDirStat success, request: " << request.DebugString()
+                << "response: " << response.DebugString();
+        return ret;
+    };
+
+    auto taskCtx = std::make_shared<TaskContext>(
+        MetaServerOpType::UpdateDirStat, task, fsId, inodeId);
+    UpdateDirStatExcutor excutor(opt_, metaCache_, channelManager_, taskCtx);
+    return ConvertToMetaStatusCode(excutor.DoRPCTask());
+}
+
 }  // namespace rpcclient
 }  // namespace client
 }  // namespace curvefs
@@ -25,6 +25,7 @@
 
 #include <list>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -37,8 +38,10 @@
 
 using ::curvefs::client::metric::MetaServerClientMetric;
 using ::curvefs::metaserver::Dentry;
+using ::curvefs::metaserver::DirStat;
 using ::curvefs::metaserver::FsFileType;
 using ::curvefs::metaserver::Inode;
+using ::curvefs::metaserver::InodeAttr;
 using ::curvefs::metaserver::MetaStatusCode;
 using ::curvefs::space::AllocateType;
 using ::curvefs::metaserver::S3ChunkInfoList;
@@ -47,6 +50,10 @@ namespace curvefs {
 namespace client {
 namespace rpcclient {
 
+// fill the attributes of `inode` to update into `request`, pool, copyset
+// and partition are left to the caller
+void FillUpdateInodeRequest(const Inode &inode, UpdateInodeRequest *request);
+
 class MetaServerClient {
  public:
     MetaServerClient() {}
@@ -62,6 +69,9 @@ class MetaServerClient {
 
     virtual void SetTxId(uint32_t partitionId, uint64_t txId) = 0;
 
+    // get the txids of the partitions of fs from mds
+    virtual bool RefreshTxId(uint32_t fsId) = 0;
+
     virtual MetaStatusCode GetDentry(uint32_t fsId, uint64_t inodeid,
                                      const std::string &name, Dentry *out) = 0;
 
@@ -80,6 +90,13 @@ class MetaServerClient {
     virtual MetaStatusCode GetInode(uint32_t fsId, uint64_t inodeid,
                                     Inode *out) = 0;
 
+    // get attributes of inodes, the inodes are grouped by partition and
+    // each group is sent to metaserver by one rpc. inodes not found are
+    // skipped in the result.
+    virtual MetaStatusCode BatchGetInodeAttr(uint32_t fsId,
+                                             const std::set<uint64_t> &inodeIds,
+                                             std::list<InodeAttr> *attrs) = 0;
+
     virtual MetaStatusCode UpdateInode(const Inode &inode) = 0;
 
     virtual void UpdateInodeAsync(const Inode &inode,
@@ -99,9 +116,55 @@ class MetaServerClient {
             uint64_t, S3ChunkInfoList> &s3ChunkInfos,
         MetaServerClientDone *done) = 0;
 
+    // update attributes and append s3 chunk info of many inodes by one rpc,
+    // all inodes in `request` should belong to the same partition. pool,
+    // copyset and partition of the request are filled in by the client.
+    // `response` is set before `done` runs if metaserver replies, it
+    // tells the inodes failed to update.
+    virtual void BatchUpdateInodeAsync(const BatchUpdateInodeRequest &request,
+                                       BatchUpdateInodeResponse *response,
+                                       MetaServerClientDone *done) = 0;
+
     virtual MetaStatusCode CreateInode(const InodeParam &param, Inode *out) = 0;
 
     virtual MetaStatusCode DeleteInode(uint32_t fsId, uint64_t inodeid) = 0;
+
+    // create the inode and its dentry under `dentry->parentinodeid()` by
+    // one request in the partition of parent, `dentry->inodeid()` is set
+    // to the new inode. PARTITION_ALLOC_ID_FAIL is returned if the partition
+    // of parent can't hold the inode, they should be created separately.
+    virtual MetaStatusCode CreateInodeAndDentry(const InodeParam &param,
+                                                Dentry *dentry,
+                                                Inode *out) = 0;
+
+    // delete the dentry and decrease the nlink of `inodeid` by one request,
+    // PARTITION_ID_MISSMATCH is returned if the inode isn't in the partition
+    // of parent, they should be deleted separately.
+    virtual MetaStatusCode UnlinkDentryAndDecNlink(uint32_t fsId,
+                                                   uint64_t parentInodeId,
+                                                   const std::string &name,
+                                                   uint64_t inodeid) = 0;
+
+    // rename `dentry` to `newDentry` by the leader of the partition of
+    // `dentry->parentinodeid()`, which runs the transaction on both
+    // partitions and commits it to mds, the txids of the dentrys are the
+    // ones known by the client, and the committed ones are returned
+    virtual MetaStatusCode Rename(const Dentry &dentry,
+                                  const Dentry &newDentry,
+                                  uint64_t *txId, uint64_t *dstTxId) = 0;
+
+    // add `delta` to the recursive stat of directory `inodeId`, and set
+    // its parent to `newParent` if it isn't 0, the parent of the inode
+    // is returned by `parent`, which is 0 if it's unknown, and the stat
+    // after update by `stat` if it's not nullptr. `requestId` identifies
+    // the delta, a delta resent must use the same one so it's added once,
+    // 0 means the request isn't deduplicated
+    virtual MetaStatusCode UpdateDirStat(uint32_t fsId, uint64_t inodeId,
+                                         const DirStat &delta,
+                                         uint64_t requestId,
+                                         uint64_t newParent,
+                                         uint64_t *parent,
+                                         DirStat *stat) = 0;
 };
 
 class MetaServerClientImpl : public MetaServerClient {
@@ -119,6 +182,8 @@ class MetaServerClientImpl : public MetaServerClient {
 
     void SetTxId(uint32_t partitionId, uint64_t txId) override;
 
+    bool RefreshTxId(uint32_t fsId) override;
+
     MetaStatusCode GetDentry(uint32_t fsId, uint64_t inodeid,
                              const std::string &name, Dentry *out) override;
 
@@ -136,6 +201,10 @@ class MetaServerClientImpl : public MetaServerClient {
     MetaStatusCode GetInode(uint32_t fsId, uint64_t inodeid,
                             Inode *out) override;
 
+    MetaStatusCode BatchGetInodeAttr(uint32_t fsId,
+                                     const std::set<uint64_t> &inodeIds,
+                                     std::list<InodeAttr> *attrs) override;
+
     MetaStatusCode UpdateInode(const Inode &inode) override;
 
     void UpdateInodeAsync(const Inode &inode,
@@ -155,10 +224,35 @@ class MetaServerClientImpl : public MetaServerClient {
             uint64_t, S3ChunkInfoList> &s3ChunkInfos,
         MetaServerClientDone *done) override;
 
+    void BatchUpdateInodeAsync(const BatchUpdateInodeRequest &request,
+                               BatchUpdateInodeResponse *response,
+                               MetaServerClientDone *done) override;
+
     MetaStatusCode CreateInode(const InodeParam &param, Inode *out) override;
 
     MetaStatusCode DeleteInode(uint32_t fsId, uint64_t inodeid) override;
 
+    MetaStatusCode CreateInodeAndDentry(const InodeParam &param,
+                                        Dentry *dentry, Inode *out) override;
+
+    MetaStatusCode UnlinkDentryAndDecNlink(uint32_t fsId,
+                                           uint64_t parentInodeId,
+                                           const std::string &name,
+                                           uint64_t inodeid) override;
+
+    MetaStatusCode Rename(const Dentry &dentry, const Dentry &newDentry,
+                          uint64_t *txId, uint64_t *dstTxId) override;
+
+    MetaStatusCode UpdateDirStat(uint32_t fsId, uint64_t inodeId,
+                                 const DirStat &delta, uint64_t requestId,
+                                 uint64_t newParent, uint64_t *parent,
+                                 DirStat *stat) override;
+
+ private:
+    MetaStatusCode BatchGetInodeAttrInPartition(
+        uint32_t fsId, const std::vector<uint64_t> &inodeIds,
+        std::list<InodeAttr> *attrs);
+
  private:
     ExcutorOpt opt_;
 
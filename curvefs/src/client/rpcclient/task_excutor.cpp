@@ -326,6 +326,14 @@ bool CreateInodeExcutor::GetTarget() {
     return true;
 }
 
+bool CreateInodeAndDentryExcutor::OnReturn(int retCode) {
+    if (retCode == MetaStatusCode::PARTITION_ALLOC_ID_FAIL) {
+        OnPartitionAllocIDFail();
+        return false;
+    }
+    return TaskExecutor::OnReturn(retCode);
+}
+
 }  // namespace rpcclient
 }  // namespace client
 }  // namespace curvefs
@@ -108,7 +108,7 @@ class TaskExecutor {
     int DoRPCTask();
     int DoAsyncRPCTask(TaskExecutorDone *done);
 
-    bool OnReturn(int retCode);
+    virtual bool OnReturn(int retCode);
     void PreProcessBeforeRetry(int retCode);
 
     std::shared_ptr<TaskContext> GetTaskCxt() const {
@@ -215,6 +215,21 @@ class CreateInodeExcutor : public TaskExecutor {
     bool GetTarget() override;
 };
 
+// create inode and dentry in the partition of parent, the inode can't be
+// created elsewhere if the partition has no inode id left, so it's not
+// retried and the caller should fall back to create them separately
+class CreateInodeAndDentryExcutor : public TaskExecutor {
+ public:
+    explicit CreateInodeAndDentryExcutor(
+        const ExcutorOpt &opt,
+        const std::shared_ptr<MetaCache> &metaCache,
+        const std::shared_ptr<ChannelManager<MetaserverID>> &channelManager,
+        const std::shared_ptr<TaskContext> &task)
+        : TaskExecutor(opt, metaCache, channelManager, task) {}
+
+    bool OnReturn(int retCode) override;
+};
+
 }  // namespace rpcclient
 }  // namespace client
 }  // namespace curvefs
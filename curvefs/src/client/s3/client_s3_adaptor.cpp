@@ -48,8 +48,14 @@ S3ClientAdaptorImpl::Init(const S3ClientAdaptorOption& option, S3Client* client,
     fuseMaxSize_ = option.fuseMaxSize;
     prefetchBlocks_ = option.prefetchBlocks;
     prefetchExecQueueNum_ = option.prefetchExecQueueNum;
+    readParallelism_ = option.readParallelism;
+    flushParallelism_ = option.flushParallelism;
+    uploadParallelism_ = option.uploadParallelism;
+    uploadInflight_ = 0;
     diskCacheType_ = option.diskCacheOpt.diskCacheType;
     memCacheNearfullRatio_ = option.nearfullRatio;
+    flushLowWatermark_ =
+        std::min(option.flushLowWatermark, option.nearfullRatio);
     throttleBaseSleepUs_ = option.baseSleepUs;
     flushIntervalSec_ = option.flushIntervalSec;
     client_ = client;
@@ -62,6 +68,10 @@ S3ClientAdaptorImpl::Init(const S3ClientAdaptorOption& option, S3Client* client,
               << ", chunk size: " << chunkSize_
               << ", prefetchBlocks: " << prefetchBlocks_
               << ", prefetchExecQueueNum: " << prefetchExecQueueNum_
+              << ", readParallelism: " << readParallelism_
+              << ", flushParallelism: " << flushParallelism_
+              << ", uploadParallelism: " << uploadParallelism_
+              << ", flushLowWatermark: " << flushLowWatermark_
               << ", intervalSec: " << option.intervalSec
               << ", flushIntervalSec: " << option.flushIntervalSec
               << ", writeCacheMaxByte: " << option.writeCacheMaxByte
@@ -69,6 +79,9 @@ S3ClientAdaptorImpl::Init(const S3ClientAdaptorOption& option, S3Client* client,
               << ", nearfullRatio: " << option.nearfullRatio
               << ", baseSleepUs: " << option.baseSleepUs;
     toStop_.store(false, std::memory_order_release);
+    if (flushParallelism_ > 1) {
+        flushThreadPool_.Start(flushParallelism_);
+    }
     bgFlushThread_ = Thread(&S3ClientAdaptorImpl::BackGroundFlush, this);
 
     if (HasDiskCache()) {
@@ -259,6 +272,26 @@ FSStatusCode S3ClientAdaptorImpl::AllocS3ChunkId(uint32_t fsId,
     return mdsClient_->AllocS3ChunkId(fsId, chunkId);
 }
 
+void S3ClientAdaptorImpl::AcquireUploadSlot() {
+    if (uploadParallelism_ == 0) {
+        return;
+    }
+    std::unique_lock<std::mutex> lk(uploadMtx_);
+    uploadCond_.wait(lk, [this]() {
+        return uploadInflight_ < uploadParallelism_;
+    });
+    uploadInflight_++;
+}
+
+void S3ClientAdaptorImpl::ReleaseUploadSlot() {
+    if (uploadParallelism_ == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lk(uploadMtx_);
+    uploadInflight_--;
+    uploadCond_.notify_one();
+}
+
 void S3ClientAdaptorImpl::BackGroundFlush() {
     while (!toStop_.load(std::memory_order_acquire)) {
         {
@@ -268,7 +301,9 @@ void S3ClientAdaptorImpl::BackGroundFlush() {
                 cond_.wait(lck);
             }
         }
-        if (fsCacheManager_->MemCacheRatio() > memCacheNearfullRatio_) {
+        // flush radically once the write cache exceeds the low watermark,
+        // so that writers rarely hit WaitFlush
+        if (fsCacheManager_->MemCacheRatio() > flushLowWatermark_) {
             VLOG(3) << "BackGroundFlush radically, write cache num is: "
                       << fsCacheManager_->GetDataCacheNum()
                       << "cache ratio is: " << fsCacheManager_->MemCacheRatio();
@@ -292,6 +327,7 @@ int S3ClientAdaptorImpl::Stop() {
     toStop_.store(true, std::memory_order_release);
     FsSyncSignal();
     bgFlushThread_.join();
+    flushThreadPool_.Stop();
     if (HasDiskCache()) {
         for (auto& q : downloadTaskQueues_) {
             bthread::execution_queue_stop(q);
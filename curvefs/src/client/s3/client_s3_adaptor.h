@@ -40,6 +40,7 @@
 #include "curvefs/src/client/s3/client_s3.h"
 #include "curvefs/src/client/s3/client_s3_cache_manager.h"
 #include "curvefs/src/client/s3/disk_cache_manager_impl.h"
+#include "src/common/concurrent/task_thread_pool.h"
 #include "src/common/wait_interval.h"
 namespace curvefs {
 namespace client {
@@ -127,6 +128,16 @@ class S3ClientAdaptorImpl : public S3ClientAdaptor {
     uint32_t GetPrefetchBlocks() {
         return prefetchBlocks_;
     }
+    uint32_t GetReadParallelism() {
+        return readParallelism_;
+    }
+    // nullptr if files are flushed serially
+    curve::common::TaskThreadPool<> *GetFlushThreadPool() {
+        return flushParallelism_ > 1 ? &flushThreadPool_ : nullptr;
+    }
+    // block until the put requests in flight is under uploadParallelism
+    void AcquireUploadSlot();
+    void ReleaseUploadSlot();
     uint32_t GetDiskCacheType() {
         return diskCacheType_;
     }
@@ -200,9 +211,13 @@ class S3ClientAdaptorImpl : public S3ClientAdaptor {
     uint32_t fuseMaxSize_;
     uint32_t prefetchBlocks_;
     uint32_t prefetchExecQueueNum_;
+    uint32_t readParallelism_;
+    uint32_t flushParallelism_;
+    uint32_t uploadParallelism_;
     std::string allocateServerEps_;
     uint32_t flushIntervalSec_;
     uint32_t memCacheNearfullRatio_;
+    uint32_t flushLowWatermark_;
     uint32_t throttleBaseSleepUs_;
     Thread bgFlushThread_;
     std::atomic<bool> toStop_;
@@ -221,6 +236,10 @@ class S3ClientAdaptorImpl : public S3ClientAdaptor {
     std::vector<bthread::ExecutionQueueId<AsyncDownloadTask>>
       downloadTaskQueues_;
     uint32_t pageSize_;
+    curve::common::TaskThreadPool<> flushThreadPool_;
+    std::mutex uploadMtx_;
+    std::condition_variable uploadCond_;
+    uint32_t uploadInflight_;
 };
 
 }  // namespace client
@@ -30,6 +30,17 @@
 namespace curvefs {
 namespace client {
 
+FsCacheManager::FsCacheManager(S3ClientAdaptorImpl *s3ClientAdaptor,
+                               uint64_t readCacheMaxByte,
+                               uint64_t writeCacheMaxByte)
+    : lruByte_(0), wDataCacheNum_(0), wDataCacheByte_(0),
+      readCacheMaxByte_(readCacheMaxByte),
+      writeCacheMaxByte_(writeCacheMaxByte),
+      s3ClientAdaptor_(s3ClientAdaptor), isWaiting_(false),
+      pagePool_(std::make_shared<PagePool>(
+          s3ClientAdaptor->GetPageSize(),
+          readCacheMaxByte + writeCacheMaxByte, writeCacheMaxByte)) {}
+
 FileCacheManagerPtr FsCacheManager::FindFileCacheManager(uint64_t inodeId) {
     ReadLockGuard readLockGuard(rwLock_);
 
@@ -140,10 +151,41 @@ CURVEFS_ERROR FsCacheManager::FsSync(bool force) {
         WriteLockGuard writeLockGuard(rwLock_);
         tmp = fileCacheManagerMap_;
     }
-    auto iter = tmp.begin();
     VLOG(3) << "FsSync force: " << force;
-    for (; iter != tmp.end(); iter++) {
-        ret = iter->second->Flush(force);
+    // flush the files in parallel, and handle the results in order
+    std::vector<CURVEFS_ERROR> rets(tmp.size(), CURVEFS_ERROR::OK);
+    auto flushPool = s3ClientAdaptor_->GetFlushThreadPool();
+    if (flushPool != nullptr && tmp.size() > 1) {
+        curve::common::CountDownEvent flushed(tmp.size());
+        size_t i = 0;
+        for (auto &item : tmp) {
+            FileCacheManagerPtr fileCacheManager = item.second;
+            CURVEFS_ERROR *fileRet = &rets[i++];
+            flushPool->Enqueue(
+                [fileCacheManager, force, fileRet, &flushed]() mutable {
+                    *fileRet = fileCacheManager->Flush(force);
+                    // drop the reference before signal, the use count is
+                    // checked to release the file cache below
+                    fileCacheManager.reset();
+                    flushed.Signal();
+                });
+        }
+        flushed.Wait();
+    } else {
+        size_t i = 0;
+        for (auto &item : tmp) {
+            CURVEFS_ERROR fileRet = item.second->Flush(force);
+            rets[i++] = fileRet;
+            if (fileRet != CURVEFS_ERROR::OK &&
+                fileRet != CURVEFS_ERROR::NOTEXIST) {
+                break;
+            }
+        }
+    }
+
+    auto iter = tmp.begin();
+    for (size_t i = 0; iter != tmp.end(); iter++, i++) {
+        ret = rets[i];
         if (ret == CURVEFS_ERROR::OK) {
             continue;
         } else if (ret == CURVEFS_ERROR::NOTEXIST) {
@@ -252,6 +294,7 @@ int FileCacheManager::Read(uint64_t inodeId, uint64_t offset, uint64_t length,
     int ret = 0;
     uint64_t readOffset = 0;
     std::vector<ReadRequest> totalRequests;
+    uint32_t prefetchBlocks = UpdateReadahead(offset, length);
 
     //  Find offset~len in the write and read cache,
     //  and The parts that are not in the cache are placed in the totalRequests
@@ -336,7 +379,8 @@ int FileCacheManager::Read(uint64_t inodeId, uint64_t offset, uint64_t length,
                         << ",inodeId:" << tmp_req.inodeId;
             }
 
-            ret = ReadFromS3(totalS3Requests, &responses, fileLen);
+            ret = ReadFromS3(totalS3Requests, &responses, fileLen,
+                             prefetchBlocks);
             if (ret < 0) {
                 retry++;
                 responses.clear();
@@ -371,32 +415,80 @@ int FileCacheManager::Read(uint64_t inodeId, uint64_t offset, uint64_t length,
     return readOffset;
 }
 
+uint32_t FileCacheManager::UpdateReadahead(uint64_t offset,
+                                           uint64_t length) {
+    uint64_t blockSize = s3ClientAdaptor_->GetBlockSize();
+    uint32_t maxWindow = s3ClientAdaptor_->GetPrefetchBlocks();
+    curve::common::LockGuard lg(readaheadMtx_);
+    // fuse may send the requests of a sequential stream out of order,
+    // so the reads close to the end of last read are still sequential
+    uint64_t distance = offset > readaheadNextOffset_
+                            ? offset - readaheadNextOffset_
+                            : readaheadNextOffset_ - offset;
+    if (distance <= blockSize) {
+        if (readaheadWindow_ == 0) {
+            readaheadWindow_ = std::min(1U, maxWindow);
+        }
+        readaheadNextOffset_ =
+            std::max(readaheadNextOffset_, offset + length);
+    } else {
+        VLOG_IF(6, readaheadWindow_ != 0)
+            << "random read, stop prefetch, inode: " << inode_
+            << ", offset: " << offset << ", expect: " << readaheadNextOffset_;
+        readaheadWindow_ = 0;
+        readaheadNextOffset_ = offset + length;
+    }
+    return readaheadWindow_;
+}
+
+void FileCacheManager::GrowReadahead() {
+    uint32_t maxWindow = s3ClientAdaptor_->GetPrefetchBlocks();
+    curve::common::LockGuard lg(readaheadMtx_);
+    if (readaheadWindow_ == 0 || readaheadWindow_ >= maxWindow) {
+        return;
+    }
+    readaheadWindow_ = std::min(readaheadWindow_ * 2, maxWindow);
+    VLOG(6) << "grow prefetch window, inode: " << inode_
+            << ", window: " << readaheadWindow_;
+}
+
 int FileCacheManager::ReadFromS3(const std::vector<S3ReadRequest> &requests,
                                  std::vector<S3ReadResponse> *responses,
-                                 uint64_t fileLen) {
+                                 uint64_t fileLen, uint32_t prefetchBlocks) {
     uint64_t chunkSize = s3ClientAdaptor_->GetChunkSize();
     uint64_t blockSize = s3ClientAdaptor_->GetBlockSize();
+    uint32_t readParallelism = s3ClientAdaptor_->GetReadParallelism();
+    bool async = readParallelism > 1;
     std::vector<S3ReadRequest>::const_iterator iter = requests.begin();
-    std::atomic<uint64_t> pendingReq(0);
-    curve::common::CountDownEvent cond(1);
-    bool async = false;
+    int ret = 0;
+    bool s3Miss = false;
+    // the range gets in flight, the callbacks reference the variables
+    // on this stack, so all of them must be waited before return
+    curve::common::Mutex asyncMtx;
+    curve::common::ConditionVariable asyncCond;
+    uint32_t pendingReq = 0;
+    uint64_t asyncBytes = 0;
+    uint64_t asyncStart = butil::cpuwide_time_us();
+    std::vector<std::shared_ptr<GetObjectAsyncContext>> failedReq;
     // first is chunkIndex, second is vector chunkPos
     std::map<uint64_t, std::vector<uint64_t>> dataCacheMap;
     GetObjectAsyncCallBack cb =
         [&](const S3Adapter *adapter,
             const std::shared_ptr<GetObjectAsyncContext> &context) {
-            if (context->retCode == 0) {
-                pendingReq.fetch_sub(1, std::memory_order_relaxed);
-                cond.Signal();
-                return;
+            // notify under the lock, otherwise the waiter may return
+            // and destroy the condition variable before notified
+            curve::common::LockGuard lg(asyncMtx);
+            if (context->retCode < 0) {
+                LOG(WARNING) << "Get Object failed, key: " << context->key
+                             << ", offset: " << context->offset
+                             << ", retry it later";
+                failedReq.emplace_back(context);
             }
-
-            LOG(WARNING) << "Get Object failed, key: " << context->key
-                         << ", offset: " << context->offset;
-            s3ClientAdaptor_->GetS3Client()->DownloadAsync(context);
+            pendingReq--;
+            asyncCond.notify_all();
         };
 
-    for (; iter != requests.end(); iter++) {
+    for (; iter != requests.end() && ret >= 0; iter++) {
         uint64_t blockIndex = iter->offset % chunkSize / blockSize;
         uint64_t blockPos = iter->offset % chunkSize % blockSize;
         uint64_t chunkIndex = iter->offset / chunkSize;
@@ -410,18 +502,17 @@ int FileCacheManager::ReadFromS3(const std::vector<S3ReadRequest> &requests,
         dataCacheVec.push_back(chunkPos);
         S3ReadResponse response(len);
         if (!response.GetDataBuf()) {
-            return -1;
+            ret = -1;
+            break;
         }
         VLOG(6) << "HandleReadRequest blockPos:" << blockPos << ",len:" << len
                 << ",blockIndex:" << blockIndex
                 << ",objectOffset:" << objectOffset << ",chunkid"
                 << iter->chunkId << ",fsid" << iter->fsId
                 << ",inodeId:" << iter->inodeId;
-        // prefetch read
-        if (s3ClientAdaptor_->HasDiskCache()) {
+        // prefetch read, the window is 0 on random access
+        if (s3ClientAdaptor_->HasDiskCache() && prefetchBlocks > 0) {
             uint64_t blockIndexTmp = blockIndex;
-            // the counts of blocks that need prefetch
-            uint32_t prefetchBlocks = s3ClientAdaptor_->GetPrefetchBlocks();
             std::vector<std::string> prefetchObjs;
             for (int count = 0; count < prefetchBlocks; count++) {
                 std::string name = curvefs::common::s3util::GenObjName(
@@ -452,49 +543,54 @@ int FileCacheManager::ReadFromS3(const std::vector<S3ReadRequest> &requests,
                 iter->chunkId, blockIndex, iter->compaction, iter->fsId,
                 iter->inodeId);
             uint64_t start = butil::cpuwide_time_us();
-            if (async) {
-                VLOG(9) << "async read s3";
+            if (s3ClientAdaptor_->HasDiskCache() &&
+                s3ClientAdaptor_->GetDiskCacheManager()->IsCached(name)) {
+                VLOG(9) << "cached in disk: " << name;
+                ret = s3ClientAdaptor_->GetDiskCacheManager()->Read(
+                    name, response.GetDataBuf() + readOffset,
+                    blockPos - objectOffset, n);
+                if (s3ClientAdaptor_->s3Metric_.get() != nullptr) {
+                    s3ClientAdaptor_->CollectMetrics(
+                        &s3ClientAdaptor_->s3Metric_->adaptorReadDiskCache,
+                        n, start);
+                }
+            } else if (async) {
+                VLOG(9) << "async read s3: " << name;
+                s3Miss = true;
                 auto context = std::make_shared<GetObjectAsyncContext>();
                 context->key = name;
                 context->buf = response.GetDataBuf() + readOffset;
                 context->offset = blockPos - objectOffset;
                 context->len = n;
                 context->cb = cb;
-                pendingReq.fetch_add(1, std::memory_order_relaxed);
+                {
+                    curve::common::UniqueLock lk(asyncMtx);
+                    asyncCond.wait(lk, [&]() {
+                        return pendingReq < readParallelism;
+                    });
+                    pendingReq++;
+                }
+                asyncBytes += n;
                 s3ClientAdaptor_->GetS3Client()->DownloadAsync(context);
             } else {
-                VLOG(9) << "sync read s3";
-                int ret = 0;
-                if (s3ClientAdaptor_->HasDiskCache() &&
-                    s3ClientAdaptor_->GetDiskCacheManager()->IsCached(name)) {
-                    VLOG(9) << "cached in disk: " << name;
-                    ret = s3ClientAdaptor_->GetDiskCacheManager()->Read(
-                        name, response.GetDataBuf() + readOffset,
-                        blockPos - objectOffset, n);
-                    if (s3ClientAdaptor_->s3Metric_.get() != nullptr) {
-                        s3ClientAdaptor_->CollectMetrics(
-                            &s3ClientAdaptor_->s3Metric_->adaptorReadDiskCache,
-                            n, start);
-                    }
-                } else {
-                    VLOG(9) << "not cached in disk: " << name;
-                    ret = s3ClientAdaptor_->GetS3Client()->Download(
-                        name, response.GetDataBuf() + readOffset,
-                        blockPos - objectOffset, n);
-                    if (s3ClientAdaptor_->s3Metric_.get() != nullptr) {
-                        s3ClientAdaptor_->CollectMetrics(
-                            &s3ClientAdaptor_->s3Metric_->adaptorReadS3, n,
-                            start);
-                    }
-                }
-                if (ret < 0) {
-                    LOG(ERROR) << "get obj failed, name is: " << name
-                               << ", offset is: " << blockPos
-                               << ", objoffset is: " << objectOffset
-                               << ", len: " << n << ", ret is: " << ret;
-                    return ret;
+                VLOG(9) << "sync read s3: " << name;
+                s3Miss = true;
+                ret = s3ClientAdaptor_->GetS3Client()->Download(
+                    name, response.GetDataBuf() + readOffset,
+                    blockPos - objectOffset, n);
+                if (s3ClientAdaptor_->s3Metric_.get() != nullptr) {
+                    s3ClientAdaptor_->CollectMetrics(
+                        &s3ClientAdaptor_->s3Metric_->adaptorReadS3, n,
+                        start);
                 }
             }
+            if (ret < 0) {
+                LOG(ERROR) << "get obj failed, name is: " << name
+                           << ", offset is: " << blockPos
+                           << ", objoffset is: " << objectOffset
+                           << ", len: " << n << ", ret is: " << ret;
+                break;
+            }
 
             len -= n;
             readOffset += n;
@@ -509,9 +605,36 @@ int FileCacheManager::ReadFromS3(const std::vector<S3ReadRequest> &requests,
         responses->emplace_back(std::move(response));
     }
 
-    while (pendingReq.load(std::memory_order_acquire)) {
-        cond.Wait();
+    {
+        curve::common::UniqueLock lk(asyncMtx);
+        asyncCond.wait(lk, [&]() { return pendingReq == 0; });
+    }
+    if (asyncBytes > 0 && s3ClientAdaptor_->s3Metric_.get() != nullptr) {
+        s3ClientAdaptor_->CollectMetrics(
+            &s3ClientAdaptor_->s3Metric_->adaptorReadS3, asyncBytes,
+            asyncStart);
+    }
+    if (ret < 0) {
+        return ret;
+    }
+    // retry the failed range gets synchronously, so that the caller can
+    // still tell the object not exist from other errors
+    for (auto &context : failedReq) {
+        ret = s3ClientAdaptor_->GetS3Client()->Download(
+            context->key, context->buf, context->offset, context->len);
+        if (ret < 0) {
+            LOG(ERROR) << "get obj failed, name is: " << context->key
+                       << ", offset is: " << context->offset
+                       << ", len: " << context->len << ", ret is: " << ret;
+            return ret;
+        }
+    }
+
+    // sequential read has to wait for s3, enlarge the prefetch window
+    if (s3Miss && prefetchBlocks > 0 && s3ClientAdaptor_->HasDiskCache()) {
+        GrowReadahead();
     }
+
     uint32_t i = 0;
     for (auto &dataCacheMapIter : dataCacheMap) {
         ChunkCacheManagerPtr chunkCacheManager =
@@ -555,15 +678,19 @@ class AsyncPrefetchCallback {
             return;
         }
 
-        int ret = s3Client_->GetDiskCacheManager()->WriteReadDirect(
-            context->key, context->buf, context->len);
-        LOG_IF(ERROR, ret < 0)
-            << "write read directly failed, key: " << context->key;
+        // stage it in the io threads of the cache disk, do not block
+        // the callback thread of s3
+        char *buf = guard.release();
+        std::string key = context->key;
+        s3Client_->GetDiskCacheManager()->WriteReadDirectAsync(
+            key, buf, context->len, [fileCache, buf, key](int ret) {
+                std::unique_ptr<char[]> guard(buf);
+                LOG_IF(ERROR, ret < 0)
+                    << "write read directly failed, key: " << key;
 
-        {
-            curve::common::LockGuard lg(fileCache->downloadMtx_);
-            fileCache->downloadingObj_.erase(context->key);
-        }
+                curve::common::LockGuard lg(fileCache->downloadMtx_);
+                fileCache->downloadingObj_.erase(key);
+            });
     }
 
  private:
@@ -1422,6 +1549,7 @@ DataCache::DataCache(S3ClientAdaptorImpl *s3ClientAdaptor,
                      ChunkCacheManager *chunkCacheManager, uint64_t chunkPos,
                      uint64_t len, const char *data)
     : s3ClientAdaptor_(s3ClientAdaptor), chunkCacheManager_(chunkCacheManager),
+      pagePool_(s3ClientAdaptor->GetFsCacheManager()->GetPagePool()),
       dirty_(true), delete_(false), inReadCache_(false) {
     uint64_t blockSize = s3ClientAdaptor->GetBlockSize();
     uint32_t pageSize = s3ClientAdaptor->GetPageSize();
@@ -1443,7 +1571,7 @@ DataCache::DataCache(S3ClientAdaptorImpl *s3ClientAdaptor,
         } else {
             n = len;
         }
-        PageDataMap &pdMap = dataMap_[blockIndex];
+        BlockPages &pages = dataMap_[blockIndex];
         blockLen = n;
         pageIndex = blockPos / pageSize;
         pagePos = blockPos % pageSize;
@@ -1454,16 +1582,13 @@ DataCache::DataCache(S3ClientAdaptorImpl *s3ClientAdaptor,
                 m = blockLen;
             }
 
-            PageData *pageData = new PageData();
-            pageData->data = new char[pageSize];
-            memset(pageData->data, 0, pageSize);
-            memcpy(pageData->data + pagePos, data + dataOffset, m);
+            char *page = pagePool_->Allocate();
+            memcpy(page + pagePos, data + dataOffset, m);
             if (pagePos + m < pageSize) {
                 tailZeroLen = pageSize - pagePos - m;
             }
-            pageData->index = pageIndex;
-            assert(pdMap.count(pageIndex) == 0);
-            pdMap.emplace(pageIndex, pageData);
+            assert(pages.Get(pageIndex) == nullptr);
+            pages.Set(pageIndex, page);
             pageIndex++;
             blockLen -= m;
             dataOffset += m;
@@ -1505,8 +1630,7 @@ void DataCache::CopyBufToDataCache(uint64_t dataCachePos, uint64_t len,
             n = len;
         }
         blockLen = n;
-        PageDataMap &pdMap = dataMap_[blockIndex];
-        PageData *pageData;
+        BlockPages &pages = dataMap_[blockIndex];
         pageIndex = blockPos / pageSize;
         pagePos = blockPos % pageSize;
         while (blockLen > 0) {
@@ -1515,17 +1639,13 @@ void DataCache::CopyBufToDataCache(uint64_t dataCachePos, uint64_t len,
             } else {
                 m = blockLen;
             }
-            if (pdMap.count(pageIndex)) {
-                pageData = pdMap[pageIndex];
-            } else {
-                pageData = new PageData();
-                pageData->data = new char[pageSize];
-                memset(pageData->data, 0, pageSize);
-                pageData->index = pageIndex;
-                pdMap.emplace(pageIndex, pageData);
+            char *page = pages.Get(pageIndex);
+            if (page == nullptr) {
+                page = pagePool_->Allocate();
+                pages.Set(pageIndex, page);
                 addLen += pageSize;
             }
-            memcpy(pageData->data + pagePos, data + dataOffset, m);
+            memcpy(page + pagePos, data + dataOffset, m);
             pageIndex++;
             blockLen -= m;
             dataOffset += m;
@@ -1564,9 +1684,8 @@ void DataCache::AddDataBefore(uint64_t len, const char *data) {
             n = tmpLen;
         }
 
-        PageDataMap &pdMap = dataMap_[blockIndex];
+        BlockPages &pages = dataMap_[blockIndex];
         blockLen = n;
-        PageData *pageData = NULL;
         pageIndex = blockPos / pageSize;
         pagePos = blockPos % pageSize;
         while (blockLen > 0) {
@@ -1576,16 +1695,12 @@ void DataCache::AddDataBefore(uint64_t len, const char *data) {
                 m = blockLen;
             }
 
-            if (pdMap.count(pageIndex)) {
-                pageData = pdMap[pageIndex];
-            } else {
-                pageData = new PageData();
-                pageData->data = new char[pageSize];
-                memset(pageData->data, 0, pageSize);
-                pageData->index = pageIndex;
-                pdMap.emplace(pageIndex, pageData);
+            char *page = pages.Get(pageIndex);
+            if (page == nullptr) {
+                page = pagePool_->Allocate();
+                pages.Set(pageIndex, page);
             }
-            memcpy(pageData->data + pagePos, data + dataOffset, m);
+            memcpy(page + pagePos, data + dataOffset, m);
             pageIndex++;
             blockLen -= m;
             dataOffset += m;
@@ -1621,8 +1736,8 @@ void DataCache::MergeDataCacheToDataCache(DataCachePtr mergeDataCache,
     uint64_t pageIndex = blockPos / pageSize;
     uint64_t pagePos = blockPos % pageSize;
     char *data = nullptr;
-    PageData *meragePage = nullptr;
-    PageDataMap *pdMap = &dataMap_[blockIndex];
+    char *meragePage = nullptr;
+    BlockPages *pages = &dataMap_[blockIndex];
     int n = 0;
 
     VLOG(9) << "MergeDataCacheToDataCache dataOffset:" << dataOffset
@@ -1636,12 +1751,12 @@ void DataCache::MergeDataCacheToDataCache(DataCachePtr mergeDataCache,
         if (pageIndex == maxPageInBlock) {
             blockIndex++;
             pageIndex = 0;
-            pdMap = &dataMap_[blockIndex];
+            pages = &dataMap_[blockIndex];
         }
         meragePage = mergeDataCache->GetPageData(blockIndex, pageIndex);
         assert(meragePage);
-        if (pdMap->count(pageIndex)) {
-            data = (*pdMap)[pageIndex]->data;
+        data = pages->Get(pageIndex);
+        if (data != nullptr) {
             if (pagePos + len > pageSize) {
                 n = pageSize - pagePos;
             } else {
@@ -1649,10 +1764,10 @@ void DataCache::MergeDataCacheToDataCache(DataCachePtr mergeDataCache,
             }
             VLOG(9) << "MergeDataCacheToDataCache n:" << n
                     << ", pagePos:" << pagePos;
-            memcpy(data + pagePos, meragePage->data + pagePos, n);
+            memcpy(data + pagePos, meragePage + pagePos, n);
             // mergeDataCache->ReleasePageData(blockIndex, pageIndex);
         } else {
-            pdMap->emplace(pageIndex, meragePage);
+            pages->Set(pageIndex, meragePage);
             mergeDataCache->ErasePageData(blockIndex, pageIndex);
             n = pageSize;
             actualLen_ += pageSize;
@@ -1813,11 +1928,11 @@ void DataCache::Truncate(uint64_t size) {
         } else {
             n = truncateLen;
         }
-        PageDataMap &pdMap = dataMap_[blockIndex];
+        BlockPages &pages = dataMap_[blockIndex];
         blockLen = n;
         pageIndex = blockPos / pageSize;
         uint64_t pagePos = blockPos % pageSize;
-        PageData *pageData = nullptr;
+        char *page = nullptr;
         while (blockLen > 0) {
             if (pagePos + blockLen > pageSize) {
                 m = pageSize - pagePos;
@@ -1826,23 +1941,22 @@ void DataCache::Truncate(uint64_t size) {
             }
 
             if (pagePos == 0) {
-                if (pdMap.count(pageIndex)) {
-                    pageData = pdMap[pageIndex];
-                    delete pageData->data;
-                    pdMap.erase(pageIndex);
+                page = pages.Erase(pageIndex);
+                if (page != nullptr) {
+                    pagePool_->Free(page);
                     actualLen_ -= pageSize;
                 }
             } else {
-                if (pdMap.count(pageIndex)) {
-                    pageData = pdMap[pageIndex];
-                    memset(pageData->data + pagePos, 0, m);
+                page = pages.Get(pageIndex);
+                if (page != nullptr) {
+                    memset(page + pagePos, 0, m);
                 }
             }
             pageIndex++;
             blockLen -= m;
             pagePos = (pagePos + m) % pageSize;
         }
-        if (pdMap.empty()) {
+        if (pages.Empty()) {
             dataMap_.erase(blockIndex);
         }
         blockIndex++;
@@ -1887,8 +2001,8 @@ void DataCache::CopyDataCacheToBuf(uint64_t offset, uint64_t len, char *data) {
             n = len;
         }
         blockLen = n;
-        PageDataMap &pdMap = dataMap_[blockIndex];
-        PageData *pageData = NULL;
+        BlockPages &pages = dataMap_[blockIndex];
+        char *page = nullptr;
         pageIndex = blockPos / pageSize;
         pagePos = blockPos % pageSize;
         while (blockLen > 0) {
@@ -1898,9 +2012,9 @@ void DataCache::CopyDataCacheToBuf(uint64_t offset, uint64_t len, char *data) {
                 m = blockLen;
             }
 
-            assert(pdMap.count(pageIndex));
-            pageData = pdMap[pageIndex];
-            memcpy(data + dataOffset, pageData->data + pagePos, m);
+            page = pages.Get(pageIndex);
+            assert(page != nullptr);
+            memcpy(data + dataOffset, page + pagePos, m);
             pageIndex++;
             blockLen -= m;
             dataOffset += m;
@@ -1986,17 +2100,19 @@ CURVEFS_ERROR DataCache::Flush(uint64_t inodeId, bool force) {
         PutObjectAsyncCallBack cb =
             [&](const std::shared_ptr<PutObjectAsyncContext> &context) {
                 if (context->retCode == 0) {
-                    if (pendingReq.fetch_sub(1) == 1) {
-                        VLOG(9) << "pendingReq is over";
-                        cond.Signal();
-                    }
                     if (s3ClientAdaptor_->s3Metric_.get() != nullptr) {
                         s3ClientAdaptor_->CollectMetrics(
                             &s3ClientAdaptor_->s3Metric_->adaptorWriteS3,
                             context->bufferSize, context->startTime);
                     }
-                    VLOG(9) << "PutObjectAsyncCallBack: " << context->key
-                            << " pendingReq is: " << pendingReq;
+                    VLOG(9) << "PutObjectAsyncCallBack: " << context->key;
+                    s3ClientAdaptor_->ReleaseUploadSlot();
+                    // the flusher may return once signaled, do not touch
+                    // anything on its stack after that
+                    if (pendingReq.fetch_sub(1) == 1) {
+                        VLOG(9) << "pendingReq is over";
+                        cond.Signal();
+                    }
                     return;
                 }
 
@@ -2016,45 +2132,54 @@ CURVEFS_ERROR DataCache::Flush(uint64_t inodeId, bool force) {
 
             objectName = curvefs::common::s3util::GenObjName(
                 chunkId, blockIndex, 0, fsId, inodeId);
-            int ret = 0;
-            uint64_t start = butil::cpuwide_time_us();
-            if (useDiskCache) {
-                ret = s3ClientAdaptor_->GetDiskCacheManager()->Write(
-                    objectName, data + writeOffset, n);
-            } else {
-                auto context = std::make_shared<PutObjectAsyncContext>();
-                context->key = objectName;
-                context->buffer = data + writeOffset;
-                context->bufferSize = n;
-                context->cb = cb;
-                context->startTime = butil::cpuwide_time_us();
-                uploadTasks.emplace_back(context);
-            }
-            if (ret < 0) {
-                LOG(ERROR) << "write object fail. object: " << objectName;
-                delete[] data;
-                dirty_.store(true, std::memory_order_release);
-                return CURVEFS_ERROR::INTERNAL;
-            }
-            if (useDiskCache) {
-                if (s3ClientAdaptor_->s3Metric_.get() != nullptr) {
-                    s3ClientAdaptor_->CollectMetrics(
-                        &s3ClientAdaptor_->s3Metric_->adaptorWriteDiskCache, n,
-                        start);
-                }
-            }
+            auto context = std::make_shared<PutObjectAsyncContext>();
+            context->key = objectName;
+            context->buffer = data + writeOffset;
+            context->bufferSize = n;
+            context->cb = cb;
+            context->startTime = butil::cpuwide_time_us();
+            uploadTasks.emplace_back(context);
             tmpLen -= n;
             blockIndex++;
             writeOffset += n;
             blockPos = (blockPos + n) % blockSize;
         }
-        if (!useDiskCache) {
+        std::atomic<bool> diskWriteFailed(false);
+        if (useDiskCache) {
+            // blocks are staged to the cache disk by its io threads
+            pendingReq.fetch_add(uploadTasks.size(), std::memory_order_seq_cst);
+            for (auto &context : uploadTasks) {
+                uint64_t start = butil::cpuwide_time_us();
+                uint64_t len = context->bufferSize;
+                std::string key = context->key;
+                s3ClientAdaptor_->GetDiskCacheManager()->WriteAsync(
+                    key, context->buffer, len, [&, len, start, key](int ret) {
+                        if (ret < 0) {
+                            LOG(ERROR) << "write object fail. object: "
+                                       << key;
+                            diskWriteFailed.store(true);
+                        } else if (s3ClientAdaptor_->s3Metric_.get() !=
+                                   nullptr) {
+                            s3ClientAdaptor_->CollectMetrics(
+                                &s3ClientAdaptor_->s3Metric_
+                                     ->adaptorWriteDiskCache,
+                                len, start);
+                        }
+                        if (pendingReq.fetch_sub(1) == 1) {
+                            cond.Signal();
+                        }
+                    });
+            }
+        } else {
             pendingReq.fetch_add(uploadTasks.size(), std::memory_order_seq_cst);
             VLOG(9) << "pendingReq init: " << pendingReq;
             for (auto iter = uploadTasks.begin(); iter != uploadTasks.end();
                  ++iter) {
                 VLOG(9) << "upload start: " << (*iter)->key
                         << " len : " << (*iter)->bufferSize;
+                // the put requests in flight of the mount are bounded
+                s3ClientAdaptor_->AcquireUploadSlot();
+                (*iter)->startTime = butil::cpuwide_time_us();
                 s3ClientAdaptor_->GetS3Client()->UploadAsync(*iter);
             }
         }
@@ -2065,6 +2190,10 @@ CURVEFS_ERROR DataCache::Flush(uint64_t inodeId, bool force) {
         }
 
         delete[] data;
+        if (diskWriteFailed.load()) {
+            dirty_.store(true, std::memory_order_release);
+            return CURVEFS_ERROR::INTERNAL;
+        }
         VLOG(9) << "update inode start, chunkId:" << chunkId
                 << ",offset:" << offset << ",len:" << writeOffset
                 << ",inodeId:" << inodeId << ",chunkIndex:" << chunkIndex;
@@ -36,6 +36,7 @@
 #include "curvefs/proto/metaserver.pb.h"
 #include "curvefs/src/client/error_code.h"
 #include "curvefs/src/client/s3/client_s3.h"
+#include "curvefs/src/client/s3/page_pool.h"
 #include "curvefs/src/client/common/common.h"
 #include "src/common/concurrent/concurrent.h"
 #include "src/common/timeutility.h"
@@ -89,11 +90,44 @@ struct ObjectChunkInfo {
     uint64_t objectOffset;  // s3 object's begin in the block
 };
 
-struct PageData {
-    uint64_t index;
-    char *data;
+// the pages of a block in a flat array indexed by the page index,
+// nullptr means the page is not cached
+class BlockPages {
+ public:
+    BlockPages() : count_(0) {}
+
+    char *Get(uint64_t pageIndex) const {
+        return pageIndex < pages_.size() ? pages_[pageIndex] : nullptr;
+    }
+
+    void Set(uint64_t pageIndex, char *page) {
+        if (pageIndex >= pages_.size()) {
+            pages_.resize(pageIndex + 1, nullptr);
+        }
+        if (pages_[pageIndex] == nullptr) {
+            count_++;
+        }
+        pages_[pageIndex] = page;
+    }
+
+    // return the erased page, the caller owns it
+    char *Erase(uint64_t pageIndex) {
+        char *page = Get(pageIndex);
+        if (page != nullptr) {
+            pages_[pageIndex] = nullptr;
+            count_--;
+        }
+        return page;
+    }
+
+    bool Empty() const { return count_ == 0; }
+
+    const std::vector<char *> &Pages() const { return pages_; }
+
+ private:
+    std::vector<char *> pages_;
+    uint32_t count_;
 };
-using PageDataMap = std::map<uint64_t, PageData *>;
 
 class DataCache : public std::enable_shared_from_this<DataCache> {
  public:
@@ -101,12 +135,9 @@ class DataCache : public std::enable_shared_from_this<DataCache> {
               ChunkCacheManager *chunkCacheManager, uint64_t chunkPos,
               uint64_t len, const char *data);
     virtual ~DataCache() {
-        auto iter = dataMap_.begin();
-        for (; iter != dataMap_.end(); iter++) {
-            auto pageIter = iter->second.begin();
-            for (; pageIter != iter->second.end(); pageIter++) {
-                delete[] pageIter->second->data;
-                delete pageIter->second;
+        for (auto &block : dataMap_) {
+            for (char *page : block.second.Pages()) {
+                pagePool_->Free(page);
             }
         }
     }
@@ -116,23 +147,24 @@ class DataCache : public std::enable_shared_from_this<DataCache> {
     void Truncate(uint64_t size);
     uint64_t GetChunkPos() { return chunkPos_; }
     uint64_t GetLen() { return len_; }
-    PageData *GetPageData(uint64_t blockIndex, uint64_t pageIndex) {
-        PageDataMap &pdMap = dataMap_[blockIndex];
-        if (pdMap.count(pageIndex)) {
-            return pdMap[pageIndex];
+    char *GetPageData(uint64_t blockIndex, uint64_t pageIndex) {
+        auto iter = dataMap_.find(blockIndex);
+        if (iter == dataMap_.end()) {
+            return nullptr;
         }
-        return nullptr;
+        return iter->second.Get(pageIndex);
     }
 
+    // the page is moved to another data cache, do not free it
     void ErasePageData(uint64_t blockIndex, uint64_t pageIndex) {
         curve::common::LockGuard lg(mtx_);
-        PageDataMap &pdMap = dataMap_[blockIndex];
-        auto iter = pdMap.find(pageIndex);
-        if (iter != pdMap.end()) {
-            pdMap.erase(iter);
+        auto iter = dataMap_.find(blockIndex);
+        if (iter == dataMap_.end()) {
+            return;
         }
-        if (pdMap.empty()) {
-            dataMap_.erase(blockIndex);
+        iter->second.Erase(pageIndex);
+        if (iter->second.Empty()) {
+            dataMap_.erase(iter);
         }
     }
 
@@ -172,6 +204,7 @@ class DataCache : public std::enable_shared_from_this<DataCache> {
  private:
     S3ClientAdaptorImpl *s3ClientAdaptor_;
     ChunkCacheManager* chunkCacheManager_;
+    std::shared_ptr<PagePool> pagePool_;
     uint64_t chunkPos_;  // useful chunkPos
     uint64_t len_;  // useful len
     uint64_t actualChunkPos_;  // after alignment the actual chunkPos
@@ -181,7 +214,7 @@ class DataCache : public std::enable_shared_from_this<DataCache> {
     std::atomic<bool> dirty_;
     std::atomic<bool> delete_;
     std::atomic<bool> inReadCache_;
-    std::map<uint64_t, PageDataMap> dataMap_;  // first is block index
+    std::map<uint64_t, BlockPages> dataMap_;  // first is block index
 };
 
 class S3ReadResponse {
@@ -259,7 +292,8 @@ class FileCacheManager {
  public:
     FileCacheManager(uint32_t fsid, uint64_t inode,
                      S3ClientAdaptorImpl *s3ClientAdaptor)
-        : fsId_(fsid), inode_(inode), s3ClientAdaptor_(s3ClientAdaptor) {}
+        : fsId_(fsid), inode_(inode), s3ClientAdaptor_(s3ClientAdaptor),
+          readaheadNextOffset_(0), readaheadWindow_(0) {}
     ChunkCacheManagerPtr FindOrCreateChunkCacheManager(uint64_t index);
     void ReleaseChunkCacheManager(uint64_t index);
     void ReleaseCache();
@@ -271,7 +305,19 @@ class FileCacheManager {
 
     uint64_t GetInodeId() const { return inode_; }
 
+    // the blocks to prefetch for the next read that misses the mem cache
+    uint32_t GetReadaheadWindow() {
+        curve::common::LockGuard lg(readaheadMtx_);
+        return readaheadWindow_;
+    }
+
  private:
+    // track the access pattern of the file like kernel readahead,
+    // sequential reads open the prefetch window and random reads close it.
+    // return the prefetch window for this read
+    uint32_t UpdateReadahead(uint64_t offset, uint64_t length);
+    // sequential read still has to wait for s3, prefetch is not far enough
+    void GrowReadahead();
     void WriteChunk(uint64_t index, uint64_t chunkPos, uint64_t writeLen,
                     const char *dataBuf);
     void ReadChunk(uint64_t index, uint64_t chunkPos, uint64_t readLen,
@@ -283,7 +329,7 @@ class FileCacheManager {
                            uint64_t fsId, uint64_t inodeId);
     int ReadFromS3(const std::vector<S3ReadRequest> &requests,
                             std::vector<S3ReadResponse> *responses,
-                            uint64_t fileLen);
+                            uint64_t fileLen, uint32_t prefetchBlocks);
     void PrefetchS3Objs(std::vector<std::string> prefetchObjs);
     void HandleReadRequest(const ReadRequest &request,
                            const S3ChunkInfo &s3ChunkInfo,
@@ -306,16 +352,17 @@ class FileCacheManager {
     S3ClientAdaptorImpl *s3ClientAdaptor_;
     curve::common::Mutex downloadMtx_;
     std::set<std::string> downloadingObj_;
+    curve::common::Mutex readaheadMtx_;
+    // the end of the last read
+    uint64_t readaheadNextOffset_;
+    // prefetch window in blocks, 0 means random access
+    uint32_t readaheadWindow_;
 };
 
 class FsCacheManager {
  public:
     FsCacheManager(S3ClientAdaptorImpl *s3ClientAdaptor,
-                   uint64_t readCacheMaxByte, uint64_t writeCacheMaxByte)
-        : lruByte_(0), wDataCacheNum_(0), wDataCacheByte_(0),
-          readCacheMaxByte_(readCacheMaxByte),
-          writeCacheMaxByte_(writeCacheMaxByte),
-          s3ClientAdaptor_(s3ClientAdaptor), isWaiting_(false) {}
+                   uint64_t readCacheMaxByte, uint64_t writeCacheMaxByte);
 
     FileCacheManagerPtr FindFileCacheManager(uint64_t inodeId);
     FileCacheManagerPtr FindOrCreateFileCacheManager(uint64_t fsId,
@@ -397,6 +444,8 @@ class FsCacheManager {
         return lruByte_;
     }
 
+    std::shared_ptr<PagePool> GetPagePool() { return pagePool_; }
+
  private:
     class ReadCacheReleaseExecutor {
      public:
@@ -434,6 +483,8 @@ class FsCacheManager {
     bool isWaiting_;
     std::mutex mutex_;
     std::condition_variable cond_;
+    // the memory of read and write caches are both limited, so is the pool
+    std::shared_ptr<PagePool> pagePool_;
 
     ReadCacheReleaseExecutor releaseReadCache_;
 };
@@ -0,0 +1,360 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2022-03-02
+ */
+
+#include "curvefs/src/client/s3/disk_cache_index.h"
+
+#include <glog/logging.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <tuple>
+
+#include "src/common/string_util.h"
+
+namespace curvefs {
+namespace client {
+
+const uint32_t kIndexShardNum = 32;
+const char kIndexFileHeader[] = "curvefs disk cache index v1";
+// rewrite the index file only if the journal has more records than
+// this and twice the entries
+const uint64_t kCompactMinRecords = 100000;
+
+DiskCacheIndex::DiskCacheIndex()
+    : clock_(0), size_(0), totalBytes_(0), journal_(nullptr),
+      journalRecords_(0), snapshotting_(false) {
+    for (uint32_t i = 0; i < kIndexShardNum; i++) {
+        shards_.emplace_back(new Shard());
+    }
+}
+
+DiskCacheIndex::~DiskCacheIndex() {
+    curve::common::LockGuard lg(journalMtx_);
+    if (journal_ != nullptr) {
+        fclose(journal_);
+        journal_ = nullptr;
+    }
+}
+
+DiskCacheIndex::Shard *DiskCacheIndex::GetShard(const std::string &name) {
+    return shards_[std::hash<std::string>{}(name) % shards_.size()].get();
+}
+
+void DiskCacheIndex::Clear() {
+    for (auto &shard : shards_) {
+        curve::common::LockGuard lg(shard->mtx);
+        shard->entries.clear();
+        shard->lru.clear();
+    }
+    size_ = 0;
+    totalBytes_ = 0;
+}
+
+int DiskCacheIndex::Load(const std::string &path) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        LOG(INFO) << "disk cache index not exist, path = " << path;
+        return -1;
+    }
+    std::string line;
+    if (!std::getline(in, line) || line != kIndexFileHeader) {
+        LOG(WARNING) << "disk cache index is broken, path = " << path;
+        return -1;
+    }
+
+    uint64_t records = 0;
+    while (std::getline(in, line)) {
+        bool valid = false;
+        if (line.size() > 2 && line[0] == '+' && line[1] == ' ') {
+            size_t pos = line.find(' ', 2);
+            uint64_t size = 0;
+            if (pos != std::string::npos && pos + 1 < line.size() &&
+                curve::common::StringToUll(line.substr(2, pos - 2), &size)) {
+                Add(line.substr(pos + 1), size);
+                valid = true;
+            }
+        } else if (line.size() > 2 && line[0] == '-' && line[1] == ' ') {
+            Remove(line.substr(2));
+            valid = true;
+        }
+        // the last record may be cut off if the client crashed, the
+        // changes after it are unknown, so the cache dir has to be scanned
+        if (!valid) {
+            LOG(WARNING) << "disk cache index has a broken record"
+                         << ", path = " << path << ", line = " << line;
+            Clear();
+            return -1;
+        }
+        records++;
+    }
+    LOG(INFO) << "load disk cache index success, path = " << path
+              << ", records = " << records << ", entries = " << Size()
+              << ", bytes = " << TotalBytes();
+    return 0;
+}
+
+FILE *DiskCacheIndex::WriteSnapshot(const std::string &path) {
+    std::vector<std::tuple<uint64_t, uint64_t, std::string>> entries;
+    entries.reserve(Size());
+    for (auto &shard : shards_) {
+        curve::common::LockGuard lg(shard->mtx);
+        for (const auto &item : shard->entries) {
+            entries.emplace_back(item.second.atime, item.second.size,
+                                 item.first);
+        }
+    }
+    // least recently used first, so replaying keeps the lru order
+    std::sort(entries.begin(), entries.end());
+
+    FILE *fp = fopen(path.c_str(), "w");
+    if (fp == nullptr) {
+        LOG(ERROR) << "open disk cache index error, path = " << path;
+        return nullptr;
+    }
+    bool ok = fprintf(fp, "%s\n", kIndexFileHeader) > 0;
+    for (const auto &entry : entries) {
+        if (!ok) {
+            break;
+        }
+        std::string record = "+ " + std::to_string(std::get<1>(entry)) +
+                             " " + std::get<2>(entry) + "\n";
+        ok = fputs(record.c_str(), fp) >= 0;
+    }
+    ok = ok && fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+    if (!ok) {
+        LOG(ERROR) << "write disk cache index error, path = " << path;
+        fclose(fp);
+        unlink(path.c_str());
+        return nullptr;
+    }
+    VLOG(3) << "write disk cache index success, path = " << path
+            << ", entries = " << entries.size();
+    return fp;
+}
+
+int DiskCacheIndex::Persist(const std::string &path) {
+    curve::common::LockGuard persistLg(persistMtx_);
+    {
+        curve::common::LockGuard lg(journalMtx_);
+        snapshotting_ = true;
+        pendingRecords_.clear();
+    }
+
+    // the changes made while writing the snapshot are still journaled to
+    // the old file, and appended to the new one after the snapshot,
+    // replaying the ones already in the snapshot again is harmless
+    std::string tmpPath = path + ".tmp";
+    FILE *fp = WriteSnapshot(tmpPath);
+
+    curve::common::LockGuard lg(journalMtx_);
+    snapshotting_ = false;
+    bool ok = (fp != nullptr);
+    for (const auto &record : pendingRecords_) {
+        if (!ok) {
+            break;
+        }
+        ok = fputs(record.c_str(), fp) >= 0;
+    }
+    uint64_t records = pendingRecords_.size();
+    pendingRecords_.clear();
+    ok = ok && fflush(fp) == 0;
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        LOG(ERROR) << "persist disk cache index error, path = " << path;
+        if (fp != nullptr) {
+            fclose(fp);
+        }
+        unlink(tmpPath.c_str());
+        // go on with the old journal if any, otherwise
+        // do not leave an outdated index behind
+        if (journal_ == nullptr) {
+            unlink(path.c_str());
+        }
+        return -1;
+    }
+
+    // the file renamed is the journal from now on
+    if (journal_ != nullptr) {
+        fclose(journal_);
+    }
+    journal_ = fp;
+    path_ = path;
+    journalRecords_ = records;
+    return 0;
+}
+
+void DiskCacheIndex::Close() {
+    curve::common::LockGuard persistLg(persistMtx_);
+    std::string path;
+    {
+        curve::common::LockGuard lg(journalMtx_);
+        if (journal_ == nullptr) {
+            return;
+        }
+        fclose(journal_);
+        journal_ = nullptr;
+        path = path_;
+    }
+
+    std::string tmpPath = path + ".tmp";
+    FILE *fp = WriteSnapshot(tmpPath);
+    bool ok = (fp != nullptr) && (fclose(fp) == 0);
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        unlink(path.c_str());
+    }
+}
+
+void DiskCacheIndex::CompactIfNeeded() {
+    std::string path;
+    {
+        curve::common::LockGuard lg(journalMtx_);
+        if (journal_ == nullptr || journalRecords_ < kCompactMinRecords ||
+            journalRecords_ < 2 * Size()) {
+            return;
+        }
+        path = path_;
+    }
+    VLOG(3) << "compact disk cache index, path = " << path;
+    Persist(path);
+}
+
+void DiskCacheIndex::AppendRecord(const std::string &record) {
+    curve::common::LockGuard lg(journalMtx_);
+    if (snapshotting_) {
+        pendingRecords_.push_back(record);
+    }
+    if (journal_ == nullptr) {
+        return;
+    }
+    if (fputs(record.c_str(), journal_) < 0 || fflush(journal_) != 0) {
+        // the index can not be trusted any more, fall back to
+        // scanning the cache dir at the next mount
+        LOG(ERROR) << "append disk cache index error, path = " << path_;
+        fclose(journal_);
+        journal_ = nullptr;
+        unlink(path_.c_str());
+        return;
+    }
+    journalRecords_++;
+}
+
+void DiskCacheIndex::Add(const std::string &name, uint64_t size) {
+    Shard *shard = GetShard(name);
+    {
+        curve::common::LockGuard lg(shard->mtx);
+        auto iter = shard->entries.find(name);
+        if (iter != shard->entries.end()) {
+            totalBytes_ -= iter->second.size;
+            totalBytes_ += size;
+            iter->second.size = size;
+            iter->second.atime = clock_++;
+            shard->lru.splice(shard->lru.begin(), shard->lru,
+                              iter->second.lruIter);
+        } else {
+            shard->lru.push_front(name);
+            shard->entries.emplace(
+                name, Entry{size, clock_++, shard->lru.begin()});
+            size_++;
+            totalBytes_ += size;
+        }
+        AppendRecord("+ " + std::to_string(size) + " " + name + "\n");
+    }
+}
+
+bool DiskCacheIndex::Get(const std::string &name) {
+    Shard *shard = GetShard(name);
+    curve::common::LockGuard lg(shard->mtx);
+    auto iter = shard->entries.find(name);
+    if (iter == shard->entries.end()) {
+        return false;
+    }
+    iter->second.atime = clock_++;
+    shard->lru.splice(shard->lru.begin(), shard->lru, iter->second.lruIter);
+    return true;
+}
+
+bool DiskCacheIndex::Remove(const std::string &name) {
+    Shard *shard = GetShard(name);
+    {
+        curve::common::LockGuard lg(shard->mtx);
+        auto iter = shard->entries.find(name);
+        if (iter == shard->entries.end()) {
+            return false;
+        }
+        totalBytes_ -= iter->second.size;
+        size_--;
+        shard->lru.erase(iter->second.lruIter);
+        shard->entries.erase(iter);
+        AppendRecord("- " + name + "\n");
+    }
+    return true;
+}
+
+bool DiskCacheIndex::PopLru(std::string *name, uint64_t *size) {
+    // the victim is the oldest tail of all shards, the shards are not
+    // locked together, so it is only approximately the global lru
+    Shard *victim = nullptr;
+    uint64_t oldest = UINT64_MAX;
+    for (auto &shard : shards_) {
+        curve::common::LockGuard lg(shard->mtx);
+        if (shard->lru.empty()) {
+            continue;
+        }
+        uint64_t atime = shard->entries.find(shard->lru.back())->second.atime;
+        if (atime < oldest) {
+            oldest = atime;
+            victim = shard.get();
+        }
+    }
+    if (victim == nullptr) {
+        return false;
+    }
+    {
+        curve::common::LockGuard lg(victim->mtx);
+        if (victim->lru.empty()) {
+            return false;
+        }
+        *name = victim->lru.back();
+        auto iter = victim->entries.find(*name);
+        *size = iter->second.size;
+        totalBytes_ -= iter->second.size;
+        size_--;
+        victim->entries.erase(iter);
+        victim->lru.pop_back();
+        AppendRecord("- " + *name + "\n");
+    }
+    return true;
+}
+
+uint64_t DiskCacheIndex::Size() {
+    return size_.load();
+}
+
+uint64_t DiskCacheIndex::TotalBytes() {
+    return totalBytes_.load();
+}
+
+}  // namespace client
+}  // namespace curvefs
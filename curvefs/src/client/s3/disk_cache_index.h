@@ -0,0 +1,146 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2022-03-02
+ */
+
+#ifndef CURVEFS_SRC_CLIENT_S3_DISK_CACHE_INDEX_H_
+#define CURVEFS_SRC_CLIENT_S3_DISK_CACHE_INDEX_H_
+
+#include <atomic>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "src/common/concurrent/concurrent.h"
+
+namespace curvefs {
+namespace client {
+
+// Index of the objects in the read cache dir of the disk cache.
+// Object names are hashed into shards, each shard has its own lock, a hash
+// map for O(1) lookup and a lru list, so lookups of the read path do not
+// contend on one lock and trim evicts the least recently used objects.
+//
+// The index can be persisted in a file of the cache dir, so a remount
+// rebuilds it without scanning the cache dir. The file is a snapshot of all
+// entries in lru order followed by a journal of the adds and removes since
+// the snapshot, one record per line:
+//     + <size> <name>
+//     - <name>
+// Accesses are not journaled, the recency is saved by the snapshot taken
+// when the index is closed. A record is journaled under the lock of its
+// shard, so the records of an object are in the order of the changes.
+// Snapshots are written and synced without blocking the changes, which are
+// kept meanwhile and appended after the snapshot.
+class DiskCacheIndex {
+ public:
+    DiskCacheIndex();
+    ~DiskCacheIndex();
+
+    /**
+     * @brief load entries from the index file
+     * @return 0 success, -1 the file not exist or is broken, and nothing
+     *         is loaded
+     */
+    int Load(const std::string &path);
+
+    /**
+     * @brief write a snapshot to the index file and journal later
+     *        changes to it
+     */
+    int Persist(const std::string &path);
+
+    /**
+     * @brief write a snapshot and stop journaling
+     */
+    void Close();
+
+    /**
+     * @brief rewrite the index file if the journal grows too large
+     */
+    void CompactIfNeeded();
+
+    // insert or update an entry, and make it the most recently used one
+    void Add(const std::string &name, uint64_t size);
+
+    // return whether the object is cached, and mark it recently used
+    bool Get(const std::string &name);
+
+    bool Remove(const std::string &name);
+
+    // remove the least recently used entry
+    bool PopLru(std::string *name, uint64_t *size);
+
+    uint64_t Size();
+
+    uint64_t TotalBytes();
+
+ private:
+    struct Entry {
+        uint64_t size;
+        uint64_t atime;
+        std::list<std::string>::iterator lruIter;
+    };
+
+    struct Shard {
+        curve::common::Mutex mtx;
+        std::unordered_map<std::string, Entry> entries;
+        // front is the most recently used
+        std::list<std::string> lru;
+    };
+
+    Shard *GetShard(const std::string &name);
+
+    void Clear();
+
+    // caller must hold the lock of the shard of the record
+    void AppendRecord(const std::string &record);
+
+    // write the entries to |path| and sync it, return the file still
+    // open for appending, or nullptr if failed
+    FILE *WriteSnapshot(const std::string &path);
+
+ private:
+    std::vector<std::unique_ptr<Shard>> shards_;
+    // logical clock for ordering accesses between shards
+    std::atomic<uint64_t> clock_;
+    std::atomic<uint64_t> size_;
+    std::atomic<uint64_t> totalBytes_;
+
+    // serialize Persist() and Close()
+    curve::common::Mutex persistMtx_;
+
+    // protect journal, taken after the lock of shard
+    curve::common::Mutex journalMtx_;
+    std::string path_;
+    FILE *journal_;
+    uint64_t journalRecords_;
+    // whether a snapshot is being written, the records meanwhile
+    // are kept in |pendingRecords_|
+    bool snapshotting_;
+    std::vector<std::string> pendingRecords_;
+};
+
+}  // namespace client
+}  // namespace curvefs
+
+#endif  // CURVEFS_SRC_CLIENT_S3_DISK_CACHE_INDEX_H_
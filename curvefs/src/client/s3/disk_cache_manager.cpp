@@ -24,6 +24,9 @@
 #include <string>
 #include <cstdio>
 #include <memory>
+#include <set>
+#include <utility>
+#include <vector>
 
 #include "curvefs/src/client/s3/client_s3_adaptor.h"
 #include "curvefs/src/client/s3/disk_cache_manager.h"
@@ -32,6 +35,9 @@ namespace curvefs {
 
 namespace client {
 
+// file in the cache dir which persists the index of cache read files
+const char kDiskCacheIndexFile[] = "cacheindex";
+
 /**
  * use curl -L mdsIp:port/flags/avgFlushBytes?setvalue=true
  * for dynamic parameter configuration
@@ -93,16 +99,29 @@ int DiskCacheManager::Init(S3Client *client,
     std::thread uploadThread =
         std::thread(&DiskCacheManager::UploadAllCacheWriteFile, this);
     uploadThread.detach();
-    // load all cache read file
-    ret = cacheRead_->LoadAllCacheReadFile(&cachedObjName_);
-    if (ret < 0) {
-        LOG(ERROR) << "load all cache read file error. ret = " << ret;
-        return ret;
+    // load the index of cache read files,
+    // scan the cache read dir only if the index is not usable
+    std::string indexPath = cacheDir_ + "/" + kDiskCacheIndexFile;
+    bool indexLoaded = (cachedObjIndex_.Load(indexPath) == 0);
+    if (!indexLoaded) {
+        ret = LoadAllCacheReadFile();
+        if (ret < 0) {
+            LOG(ERROR) << "load all cache read file error. ret = " << ret;
+            return ret;
+        }
+    }
+    if (cachedObjIndex_.Persist(indexPath) < 0) {
+        LOG(WARNING) << "persist disk cache index fail"
+                     << ", cache dir will be scanned at next mount.";
     }
     // start trim thread
     TrimRun();
 
-    SetDiskInitUsedBytes();
+    if (indexLoaded) {
+        AddDiskUsedBytes(cachedObjIndex_.TotalBytes());
+    } else {
+        SetDiskInitUsedBytes();
+    }
     SetDiskFsUsedRatio();
 
     FLAGS_avgFlushIops = option_.diskCacheOpt.avgFlushIops;
@@ -144,16 +163,31 @@ int DiskCacheManager::UploadAllCacheWriteFile() {
     return cacheWrite_->UploadAllCacheWriteFile();
 }
 
-void DiskCacheManager::AddCache(const std::string name) {
-    std::lock_guard<bthread::Mutex> lk(mtx_);
-    cachedObjName_.emplace(name);
+int DiskCacheManager::LoadAllCacheReadFile() {
+    std::set<std::string> cachedObjName;
+    int ret = cacheRead_->LoadAllCacheReadFile(&cachedObjName);
+    if (ret < 0) {
+        return ret;
+    }
+    std::string cacheReadFullDir = GetCacheReadFullDir();
+    for (const auto &name : cachedObjName) {
+        struct stat statFile;
+        uint64_t size = 0;
+        std::string cacheReadFile = cacheReadFullDir + "/" + name;
+        if (posixWrapper_->stat(cacheReadFile.c_str(), &statFile) == 0) {
+            size = statFile.st_size;
+        }
+        cachedObjIndex_.Add(name, size);
+    }
+    return 0;
+}
+
+void DiskCacheManager::AddCache(const std::string name, uint64_t size) {
+    cachedObjIndex_.Add(name, size);
 }
 
 bool DiskCacheManager::IsCached(const std::string name) {
-    std::lock_guard<bthread::Mutex> lk(mtx_);
-    std::set<std::string>::iterator cacheKeyIter;
-    cacheKeyIter = cachedObjName_.find(name);
-    if (cacheKeyIter == cachedObjName_.end()) {
+    if (!cachedObjIndex_.Get(name)) {
         VLOG(9) << "not cached, name = " << name;
         return false;
     }
@@ -170,6 +204,8 @@ int DiskCacheManager::UmountDiskCache() {
     }
     TrimStop();
     cacheWrite_->AsyncUploadStop();
+    // save the lru order for the next mount
+    cachedObjIndex_.Close();
     LOG(INFO) << "umount disk cache end.";
     return 0;
 }
@@ -325,29 +361,28 @@ void DiskCacheManager::TrimCache() {
         VLOG(9) << "trim thread wake up.";
         InitQosParam();
         SetDiskFsUsedRatio();
+        cachedObjIndex_.CompactIfNeeded();
         if (IsDiskCacheFull()) {
             VLOG(3) << "disk cache full, begin trim.";
             std::string cacheReadFullDir;
             std::string cacheWriteFullDir;
             cacheReadFullDir = GetCacheReadFullDir();
             cacheWriteFullDir = GetCacheWriteFullDir();
-            std::set<std::string> cachedObjNameTmp;
-            {
-                std::lock_guard<bthread::Mutex> lk(mtx_);
-                cachedObjNameTmp = cachedObjName_;
-            }
+            // files not uploaded yet, added back after trim
+            std::vector<std::pair<std::string, uint64_t>> skipped;
             while (!IsDiskCacheSafe()) {
-                std::string cacheReadFile, cacheWriteFile;
-                std::set<std::string>::iterator cacheKeyIter;
-                cacheKeyIter = cachedObjNameTmp.begin();
-                if (cacheKeyIter == cachedObjNameTmp.end()) {
+                std::string name;
+                uint64_t size = 0;
+                // evict the least recently used first
+                if (!cachedObjIndex_.PopLru(&name, &size)) {
                     VLOG(3) << "remove disk file error"
-                               << ", cachedObjName is empty.";
+                               << ", cachedObjIndex is empty.";
                     break;
                 }
 
-                cacheReadFile = cacheReadFullDir + "/" + *cacheKeyIter;
-                cacheWriteFile = cacheWriteFullDir + "/" + *cacheKeyIter;
+                std::string cacheReadFile, cacheWriteFile;
+                cacheReadFile = cacheReadFullDir + "/" + name;
+                cacheWriteFile = cacheWriteFullDir + "/" + name;
                 struct stat statFile;
                 int ret;
                 ret = posixWrapper_->stat(cacheWriteFile.c_str(), &statFile);
@@ -359,28 +394,15 @@ void DiskCacheManager::TrimCache() {
                 if (ret == 0) {
                     VLOG(3) << "do not remove this disk file"
                             << ", file has not been uploaded to S3."
-                            << ", file is: " << *cacheKeyIter;
-                    cachedObjNameTmp.erase(cacheKeyIter);
+                            << ", file is: " << name;
+                    skipped.emplace_back(name, size);
                     continue;
                 }
-                {
-                    std::lock_guard<bthread::Mutex> lk(mtx_);
-                    std::set<std::string>::iterator iter;
-                    iter = cachedObjName_.find(*cacheKeyIter);
-                    if (iter == cachedObjName_.end()) {
-                        VLOG(6) << "remove disk file error"
-                                << ", file is not exist in cachedObjName"
-                                << ", file is: " << *cacheKeyIter;
-                        cachedObjNameTmp.erase(cacheKeyIter);
-                        continue;
-                    }
-                    cachedObjName_.erase(iter);
-                }
                 struct stat statReadFile;
                 ret = posixWrapper_->stat(cacheReadFile.c_str(), &statReadFile);
                 if (ret != 0) {
                     VLOG(3) << "remove disk file error"
-                               << ", file is: " << *cacheKeyIter;
+                               << ", file is: " << name;
                     continue;
                 }
                 // if remove disk file before delete cache,
@@ -390,14 +412,14 @@ void DiskCacheManager::TrimCache() {
                 ret = posixWrapper_->remove(toDelFile);
                 if (ret < 0) {
                     LOG(ERROR)
-                        << "remove disk file error, file is: " << *cacheKeyIter;
-                    cachedObjNameTmp.erase(cacheKeyIter);
+                        << "remove disk file error, file is: " << name;
                     continue;
                 }
                 DecDiskUsedBytes(statReadFile.st_size);
-                VLOG(3) << "remove disk file success, file is: "
-                        << *cacheKeyIter;
-                cachedObjNameTmp.erase(cacheKeyIter);
+                VLOG(3) << "remove disk file success, file is: " << name;
+            }
+            for (const auto &item : skipped) {
+                cachedObjIndex_.Add(item.first, item.second);
             }
             VLOG(3) << "trim over.";
         }
@@ -36,6 +36,7 @@
 #include "curvefs/src/client/s3/client_s3.h"
 #include "curvefs/src/client/s3/disk_cache_write.h"
 #include "curvefs/src/client/s3/disk_cache_read.h"
+#include "curvefs/src/client/s3/disk_cache_index.h"
 #include "curvefs/src/client/common/config.h"
 namespace curvefs {
 namespace client {
@@ -60,10 +61,11 @@ class DiskCacheManager {
     virtual bool IsCached(const std::string name);
 
     /**
-     * @brief add obj to cachedObjName
+     * @brief add obj to cachedObjIndex
      * @param[in] name obj name
+     * @param[in] size obj size
      */
-    void AddCache(const std::string name);
+    void AddCache(const std::string name, uint64_t size = 0);
 
     int CreateDir();
     std::string GetCacheReadFullDir();
@@ -97,6 +99,7 @@ class DiskCacheManager {
      */
     int TrimStop();
     void InitMetrics(const std::string &fsName);
+    std::shared_ptr<DiskCacheMetric> GetMetric() { return metric_; }
 
  private:
     /**
@@ -123,6 +126,10 @@ class DiskCacheManager {
          return;
     }
     void SetDiskInitUsedBytes();
+    /**
+     * @brief scan the cache read dir to build the index.
+    */
+    int LoadAllCacheReadFile();
     uint64_t GetDiskUsedbytes() {
         return usedBytes_.load(std::memory_order_seq_cst);
     }
@@ -148,9 +155,8 @@ class DiskCacheManager {
     std::string cacheDir_;
     std::shared_ptr<DiskCacheWrite> cacheWrite_;
     std::shared_ptr<DiskCacheRead> cacheRead_;
-    std::set<std::string> cachedObjName_;
-
-    bthread::Mutex mtx_;
+    // index of the cache read files, persisted in the cache dir
+    DiskCacheIndex cachedObjIndex_;
 
     S3Client *client_;
     std::shared_ptr<PosixWrapper> posixWrapper_;
@@ -35,6 +35,9 @@ DiskCacheManagerImpl::DiskCacheManagerImpl(
     std::shared_ptr<DiskCacheManager> diskCacheManager, S3Client *client) {
     diskCacheManager_ = diskCacheManager;
     client_ = client;
+    forceFlush_ = true;
+    ioThreads_ = 0;
+    ioPending_ = 0;
 }
 
 int DiskCacheManagerImpl::Init(const S3ClientAdaptorOption option) {
@@ -46,7 +49,21 @@ int DiskCacheManagerImpl::Init(const S3ClientAdaptorOption option) {
     }
 
     forceFlush_ = option.diskCacheOpt.forceFlush;
-    LOG(INFO) << "DiskCacheManagerImpl init end.";
+    ioThreads_ = option.diskCacheOpt.ioThreads;
+    if (ioThreads_ > 0) {
+        ret = ioThreadPool_.Start(ioThreads_,
+                                  option.diskCacheOpt.ioQueueDepth);
+        if (ret < 0) {
+            LOG(ERROR) << "start disk cache io threads error"
+                       << ", ioThreads = " << ioThreads_
+                       << ", ioQueueDepth = "
+                       << option.diskCacheOpt.ioQueueDepth;
+            return ret;
+        }
+    }
+    LOG(INFO) << "DiskCacheManagerImpl init end"
+              << ", ioThreads = " << ioThreads_
+              << ", ioQueueDepth = " << option.diskCacheOpt.ioQueueDepth;
     return 0;
 }
 
@@ -66,6 +83,62 @@ int DiskCacheManagerImpl::Write(const std::string name, const char *buf,
     return 0;
 }
 
+void DiskCacheManagerImpl::RunAsync(std::function<int()> io,
+                                    uint64_t length,
+                                    DiskCacheWriteCallBack done) {
+    if (ioThreads_ == 0) {
+        done(io());
+        return;
+    }
+
+    std::shared_ptr<DiskCacheMetric> metric = diskCacheManager_->GetMetric();
+    {
+        curve::common::LockGuard lg(ioMtx_);
+        ioPending_++;
+    }
+    if (metric != nullptr) {
+        metric->asyncPending << 1;
+    }
+    uint64_t start = butil::cpuwide_time_us();
+    // blocks when the queue of the cache disk is full
+    ioThreadPool_.Enqueue([this, io, length, done, metric, start]() {
+        int ret = io();
+        if (metric != nullptr) {
+            metric->asyncPending << -1;
+            if (ret < 0) {
+                metric->asyncWrite.eps.count << 1;
+            } else {
+                metric->asyncWrite.bps.count << length;
+                metric->asyncWrite.qps.count << 1;
+                metric->asyncWrite.latency
+                    << (butil::cpuwide_time_us() - start);
+            }
+        }
+        done(ret);
+        curve::common::LockGuard lg(ioMtx_);
+        if (--ioPending_ == 0) {
+            ioCond_.notify_all();
+        }
+    });
+}
+
+void DiskCacheManagerImpl::WriteAsync(const std::string name,
+                                      const char *buf, uint64_t length,
+                                      DiskCacheWriteCallBack done) {
+    RunAsync([this, name, buf, length]() {
+        return Write(name, buf, length);
+    }, length, done);
+}
+
+void DiskCacheManagerImpl::WriteReadDirectAsync(const std::string fileName,
+                                                const char *buf,
+                                                uint64_t length,
+                                                DiskCacheWriteCallBack done) {
+    RunAsync([this, fileName, buf, length]() {
+        return WriteReadDirect(fileName, buf, length);
+    }, length, done);
+}
+
 int DiskCacheManagerImpl::WriteDiskFile(const std::string name, const char *buf,
                                         uint64_t length) {
     VLOG(9) << "write name = " << name << ", length = " << length;
@@ -92,7 +165,7 @@ int DiskCacheManagerImpl::WriteDiskFile(const std::string name, const char *buf,
         return linkRet;
     }
     // add cache.
-    diskCacheManager_->AddCache(name);
+    diskCacheManager_->AddCache(name, length);
 
     // notify async load to s3
     diskCacheManager_->AsyncUploadEnqueue(name);
@@ -111,7 +184,7 @@ int DiskCacheManagerImpl::WriteReadDirect(const std::string fileName,
         return ret;
     }
     // add cache.
-    diskCacheManager_->AddCache(fileName);
+    diskCacheManager_->AddCache(fileName, length);
     return ret;
 }
 
@@ -146,6 +219,14 @@ bool DiskCacheManagerImpl::IsDiskCacheFull() {
 }
 
 int DiskCacheManagerImpl::UmountDiskCache() {
+    if (ioThreads_ > 0) {
+        // finish the queued io before the cache is umounted
+        {
+            curve::common::UniqueLock lk(ioMtx_);
+            ioCond_.wait(lk, [this]() { return ioPending_ == 0; });
+        }
+        ioThreadPool_.Stop();
+    }
     int ret;
     ret = diskCacheManager_->UmountDiskCache();
     if (ret < 0) {
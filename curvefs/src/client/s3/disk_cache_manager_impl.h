@@ -24,11 +24,13 @@
 
 #include <bthread/mutex.h>
 
+#include <functional>
 #include <string>
 #include <vector>
 #include <set>
 
 #include "src/common/concurrent/concurrent.h"
+#include "src/common/concurrent/task_thread_pool.h"
 #include "src/common/interruptible_sleeper.h"
 #include "curvefs/src/common/wrap_posix.h"
 #include "curvefs/src/client/common/common.h"
@@ -44,6 +46,9 @@ using curvefs::common::PosixWrapper;
 
 class S3ClientAdaptorOption;
 
+// called with the return value of the write
+using DiskCacheWriteCallBack = std::function<void(int)>;
+
 struct DiskCacheOption {
     DiskCacheType diskCacheType;
     uint64_t trimCheckIntervalSec;
@@ -60,6 +65,8 @@ struct DiskCacheOption {
     uint64_t avgReadFileBytes;
     uint64_t avgFlushIops;
     uint64_t avgReadFileIops;
+    uint32_t ioThreads;
+    uint32_t ioQueueDepth;
 };
 
 class DiskCacheManagerImpl {
@@ -82,6 +89,14 @@ class DiskCacheManagerImpl {
      * @return success: write length, fail : < 0
      */
     int Write(const std::string name, const char* buf, uint64_t length);
+    /**
+     * @brief Write obj in the io threads, buf must be valid until done
+     *        is called. It blocks if the io queue is full, and writes
+     *        in the caller thread if io threads are not started.
+     * @param[in] done called with the return value of Write
+     */
+    void WriteAsync(const std::string name, const char* buf, uint64_t length,
+                    DiskCacheWriteCallBack done);
     /**
      * @brief whether obj is cached in cached disk
      * @param[in] name obj name
@@ -107,14 +122,29 @@ class DiskCacheManagerImpl {
     bool IsDiskCacheFull();
     int WriteReadDirect(const std::string fileName,
                         const char* buf, uint64_t length);
+    /**
+     * @brief WriteReadDirect in the io threads, same as WriteAsync
+     */
+    void WriteReadDirectAsync(const std::string fileName, const char* buf,
+                              uint64_t length, DiskCacheWriteCallBack done);
     void InitMetrics(std::string fsName);
 
  private:
     int WriteDiskFile(const std::string name, const char* buf, uint64_t length);
 
+    void RunAsync(std::function<int()> io, uint64_t length,
+                  DiskCacheWriteCallBack done);
+
     std::shared_ptr<DiskCacheManager> diskCacheManager_;
     bool forceFlush_;
     S3Client *client_;
+
+    // io threads of the cache disk, the queue depth is its capacity
+    uint32_t ioThreads_;
+    curve::common::TaskThreadPool<> ioThreadPool_;
+    curve::common::Mutex ioMtx_;
+    curve::common::ConditionVariable ioCond_;
+    uint64_t ioPending_;
 };
 
 }  // namespace client
@@ -0,0 +1,209 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2022-03-02
+ */
+
+#include "curvefs/src/client/s3/page_pool.h"
+
+#include <glog/logging.h>
+
+#include <cstring>
+#include <functional>
+#include <thread>  // NOLINT
+#include <utility>
+
+namespace curvefs {
+namespace client {
+
+// pages carved from one slab
+const uint64_t kSlabPageNum = 64;
+// shards of the free lists
+const uint32_t kPagePoolShardNum = 16;
+
+PagePool::PagePool(uint32_t pageSize, uint64_t maxSlabByte,
+                   uint64_t minSlabByte)
+    : pageSize_(pageSize),
+      slabSize_(kSlabPageNum * pageSize),
+      maxSlabByte_(maxSlabByte),
+      minSlabByte_(minSlabByte),
+      slabByte_(0),
+      usedPageNum_(0) {
+    for (uint32_t i = 0; i < kPagePoolShardNum; i++) {
+        shards_.emplace_back(new Shard());
+    }
+}
+
+PagePool::~PagePool() {
+    LOG_IF(WARNING, usedPageNum_.load() != 0)
+        << "page pool destroyed with pages in use: " << usedPageNum_.load();
+}
+
+char *PagePool::Allocate() {
+    usedPageNum_.fetch_add(1);
+    Shard *shard = GetShard();
+    char *page = AllocateFromShard(shard);
+    if (page == nullptr) {
+        page = AllocateFromNewSlab(shard);
+    }
+    // take the free pages of other shards before falling back to the heap
+    for (size_t i = 0; page == nullptr && i < shards_.size(); i++) {
+        if (shards_[i].get() != shard) {
+            page = AllocateFromShard(shards_[i].get());
+        }
+    }
+
+    if (page == nullptr) {
+        page = new char[pageSize_];
+    }
+    memset(page, 0, pageSize_);
+    return page;
+}
+
+void PagePool::Free(char *page) {
+    if (page == nullptr) {
+        return;
+    }
+
+    usedPageNum_.fetch_sub(1);
+    bool inSlab = false;
+    Slab *released = nullptr;
+    {
+        curve::common::ReadLockGuard rl(slabsLock_);
+        Slab *slab = FindSlab(page);
+        if (slab != nullptr) {
+            inSlab = true;
+            Shard *shard = slab->shard;
+            curve::common::LockGuard lg(shard->mtx);
+            slab->freePages.push_back(page);
+            if (slab->freePages.size() == kSlabPageNum &&
+                TryReleaseSlabByte()) {
+                // no page of the slab is in use, nobody else can reach it
+                // once it's off the free lists
+                shard->available.erase(slab);
+                shard->freePageNum -= kSlabPageNum - 1;
+                released = slab;
+            } else {
+                shard->available.insert(slab);
+                shard->freePageNum++;
+            }
+        }
+    }
+
+    if (!inSlab) {
+        delete[] page;
+    } else if (released != nullptr) {
+        curve::common::WriteLockGuard wl(slabsLock_);
+        slabs_.erase(released->data.get());
+    }
+}
+
+PagePool::Shard *PagePool::GetShard() {
+    size_t hash = std::hash<std::thread::id>()(std::this_thread::get_id());
+    return shards_[hash % shards_.size()].get();
+}
+
+char *PagePool::AllocateFromShard(Shard *shard) {
+    curve::common::LockGuard lg(shard->mtx);
+    if (shard->available.empty()) {
+        return nullptr;
+    }
+
+    // slabs at lower addresses are used first, so the others get idle
+    // and can be released
+    Slab *slab = *shard->available.begin();
+    char *page = slab->freePages.back();
+    slab->freePages.pop_back();
+    shard->freePageNum--;
+    if (slab->freePages.empty()) {
+        shard->available.erase(shard->available.begin());
+    }
+    return page;
+}
+
+char *PagePool::AllocateFromNewSlab(Shard *shard) {
+    uint64_t current = slabByte_.load();
+    do {
+        if (current + slabSize_ > maxSlabByte_) {
+            return nullptr;
+        }
+    } while (!slabByte_.compare_exchange_weak(current, current + slabSize_));
+
+    std::unique_ptr<Slab> slab(new Slab());
+    slab->data.reset(new char[slabSize_]);
+    slab->shard = shard;
+    char *start = slab->data.get();
+    // the first page is returned to the caller
+    for (uint64_t i = kSlabPageNum; i > 1; i--) {
+        slab->freePages.push_back(start + (i - 1) * pageSize_);
+    }
+
+    Slab *added = slab.get();
+    {
+        curve::common::WriteLockGuard wl(slabsLock_);
+        slabs_.emplace(start, std::move(slab));
+    }
+    {
+        curve::common::LockGuard lg(shard->mtx);
+        shard->available.insert(added);
+        shard->freePageNum += kSlabPageNum - 1;
+    }
+    return start;
+}
+
+PagePool::Slab *PagePool::FindSlab(char *page) {
+    auto iter = slabs_.upper_bound(page);
+    if (iter == slabs_.begin()) {
+        return nullptr;
+    }
+    --iter;
+    if (page >= iter->first + slabSize_) {
+        return nullptr;
+    }
+    return iter->second.get();
+}
+
+bool PagePool::TryReleaseSlabByte() {
+    uint64_t current = slabByte_.load();
+    do {
+        if (current < minSlabByte_ + slabSize_) {
+            return false;
+        }
+    } while (!slabByte_.compare_exchange_weak(current, current - slabSize_));
+    return true;
+}
+
+uint64_t PagePool::GetSlabByte() {
+    return slabByte_.load();
+}
+
+uint64_t PagePool::GetFreePageNum() {
+    uint64_t num = 0;
+    for (const auto &shard : shards_) {
+        curve::common::LockGuard lg(shard->mtx);
+        num += shard->freePageNum;
+    }
+    return num;
+}
+
+uint64_t PagePool::GetUsedPageNum() {
+    return usedPageNum_.load();
+}
+
+}  // namespace client
+}  // namespace curvefs
@@ -0,0 +1,114 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2022-03-02
+ */
+
+#ifndef CURVEFS_SRC_CLIENT_S3_PAGE_POOL_H_
+#define CURVEFS_SRC_CLIENT_S3_PAGE_POOL_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "src/common/concurrent/concurrent.h"
+
+namespace curvefs {
+namespace client {
+
+// Fixed size page allocator of the data caches.
+// Pages are carved from big slabs and recycled through free lists, so the
+// write path does not call malloc for every page and long mounts do not
+// fragment the heap. The total slab size is limited by maxSlabByte, beyond
+// which pages fall back to the heap and are freed when released. A slab
+// whose pages are all free is returned to the heap while the total slab
+// size is above minSlabByte.
+// Free lists are sharded by the allocating thread, a page is returned to
+// the shard of its slab.
+class PagePool {
+ public:
+    PagePool(uint32_t pageSize, uint64_t maxSlabByte,
+             uint64_t minSlabByte = 0);
+    ~PagePool();
+
+    // return a zeroed page
+    char *Allocate();
+
+    void Free(char *page);
+
+    uint32_t GetPageSize() const { return pageSize_; }
+
+    uint64_t GetSlabByte();
+
+    uint64_t GetFreePageNum();
+
+    // pages in use, including the ones from the heap
+    uint64_t GetUsedPageNum();
+
+ private:
+    struct Shard;
+
+    struct Slab {
+        std::unique_ptr<char[]> data;
+        Shard *shard;
+        // guarded by the mutex of shard
+        std::vector<char *> freePages;
+    };
+
+    struct Shard {
+        curve::common::Mutex mtx;
+        // slabs with free pages
+        std::set<Slab *> available;
+        uint64_t freePageNum = 0;
+    };
+
+    Shard *GetShard();
+
+    char *AllocateFromShard(Shard *shard);
+
+    // carve a new slab for shard if the limit allows
+    char *AllocateFromNewSlab(Shard *shard);
+
+    // the slab containing page, slabsLock_ should be held
+    Slab *FindSlab(char *page);
+
+    // take the bytes of a slab off the total if it's above minSlabByte
+    bool TryReleaseSlabByte();
+
+ private:
+    const uint32_t pageSize_;
+    const uint64_t slabSize_;
+    const uint64_t maxSlabByte_;
+    const uint64_t minSlabByte_;
+
+    // guards slabs_, it's only written when a slab is added or released
+    curve::common::RWLock slabsLock_;
+    // first is the start address of the slab
+    std::map<char *, std::unique_ptr<Slab>> slabs_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    curve::common::Atomic<uint64_t> slabByte_;
+    curve::common::Atomic<uint64_t> usedPageNum_;
+};
+
+}  // namespace client
+}  // namespace curvefs
+
+#endif  // CURVEFS_SRC_CLIENT_S3_PAGE_POOL_H_
@@ -0,0 +1,38 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2022-07-04
+ */
+
+#ifndef CURVEFS_SRC_COMMON_INODE_ATTR_H_
+#define CURVEFS_SRC_COMMON_INODE_ATTR_H_
+
+#include "curvefs/proto/metaserver.pb.h"
+
+namespace curvefs {
+namespace common {
+
+// copy the attributes of inode, shared by metaserver and client so the
+// fields of InodeAttr are kept in one place
+void InodeToAttr(const curvefs::metaserver::Inode &inode,
+                 curvefs::metaserver::InodeAttr *attr);
+
+}  // namespace common
+}  // namespace curvefs
+
+#endif  // CURVEFS_SRC_COMMON_INODE_ATTR_H_
@@ -51,6 +51,18 @@ const char* OperatorTypeName(OperatorType type) {
             return "DeletePartition";
         case OperatorType::PrepareRenameTx:
             return "PrepareRenameTx";
+        case OperatorType::GetOrModifyS3ChunkInfo:
+            return "GetOrModifyS3ChunkInfo";
+        case OperatorType::BatchGetInodeAttr:
+            return "BatchGetInodeAttr";
+        case OperatorType::BatchUpdateInode:
+            return "BatchUpdateInode";
+        case OperatorType::CreateInodeAndDentry:
+            return "CreateInodeAndDentry";
+        case OperatorType::UnlinkDentryAndDecNlink:
+            return "UnlinkDentryAndDecNlink";
+        case OperatorType::UpdateDirStat:
+            return "UpdateDirStat";
         default:
             return "Unknown";
     }
@@ -42,6 +42,11 @@ enum class OperatorType : uint32_t {
     DeletePartition,
     PrepareRenameTx,
     GetOrModifyS3ChunkInfo,
+    BatchGetInodeAttr,
+    BatchUpdateInode,
+    CreateInodeAndDentry,
+    UnlinkDentryAndDecNlink,
+    UpdateDirStat,
     /** Add new operator before `OperatorTypeMax` **/
     OperatorTypeMax,
 };
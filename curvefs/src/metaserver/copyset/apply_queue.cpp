@@ -73,6 +73,35 @@ void ApplyQueue::Flush() {
     event.Wait();
 }
 
+void ApplyQueue::Drain(std::function<void()> done) {
+    auto remaining =
+        std::make_shared<std::atomic<uint32_t>>(option_.workerCount);
+    auto callback =
+        std::make_shared<std::function<void()>>(std::move(done));
+
+    for (auto& worker : workers_) {
+        worker->tasks.Push([remaining, callback]() {
+            if (remaining->fetch_sub(1) == 1) {
+                (*callback)();
+            }
+        });
+    }
+}
+
+void ApplyQueue::ExclusiveTask::Arrive() {
+    std::unique_lock<std::mutex> lk(mtx_);
+    if (--waiting_ > 0) {
+        cond_.wait(lk, [this]() { return done_; });
+        return;
+    }
+
+    lk.unlock();
+    task_();
+    lk.lock();
+    done_ = true;
+    cond_.notify_all();
+}
+
 void ApplyQueue::Stop() {
     if (!running_.exchange(false)) {
         return;
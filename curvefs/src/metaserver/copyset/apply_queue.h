@@ -23,9 +23,13 @@
 #ifndef CURVEFS_SRC_METASERVER_COPYSET_APPLY_QUEUE_H_
 #define CURVEFS_SRC_METASERVER_COPYSET_APPLY_QUEUE_H_
 
+#include <algorithm>
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <utility>
 #include <vector>
@@ -55,6 +59,51 @@ class CURVE_CACHELINE_ALIGNMENT ApplyQueue {
             std::forward<Func>(f), std::forward<Args>(args)...);
     }
 
+    // Push a task which is executed after all the tasks pushed before, and
+    // before all the tasks pushed after, no matter which workers they are
+    // pushed to. The caller isn't blocked.
+    template <typename Func, typename... Args>
+    void PushExclusive(Func&& f, Args&&... args) {
+        auto task = std::make_shared<ExclusiveTask>(
+            option_.workerCount,
+            std::bind(std::forward<Func>(f), std::forward<Args>(args)...));
+        for (auto& worker : workers_) {
+            worker->tasks.Push([task]() { task->Arrive(); });
+        }
+    }
+
+    // Push a task which is executed after all the tasks pushed before to
+    // the workers of any of |hashes|, the other workers aren't blocked
+    template <typename Func, typename... Args>
+    void PushJoint(const std::vector<uint64_t>& hashes, Func&& f,
+                   Args&&... args) {
+        std::vector<uint32_t> workers;
+        workers.reserve(hashes.size());
+        for (auto hash : hashes) {
+            workers.push_back(hash % option_.workerCount);
+        }
+        std::sort(workers.begin(), workers.end());
+        workers.erase(std::unique(workers.begin(), workers.end()),
+                      workers.end());
+        if (workers.size() <= 1) {
+            workers_[workers.empty() ? 0 : workers[0]]->tasks.Push(
+                std::forward<Func>(f), std::forward<Args>(args)...);
+            return;
+        }
+
+        auto task = std::make_shared<ExclusiveTask>(
+            workers.size(),
+            std::bind(std::forward<Func>(f), std::forward<Args>(args)...));
+        for (auto worker : workers) {
+            workers_[worker]->tasks.Push([task]() { task->Arrive(); });
+        }
+    }
+
+    // Run |done| once all the tasks pushed before are executed. Unlike
+    // PushExclusive, the workers don't wait for each other, so the tasks
+    // pushed after may run before it.
+    void Drain(std::function<void()> done);
+
     void Flush();
 
     void Stop();
@@ -62,6 +111,25 @@ class CURVE_CACHELINE_ALIGNMENT ApplyQueue {
  private:
     void StartWorkers();
 
+    // An exclusive task is pushed to several workers, every one of them waits
+    // until all of them arrive at it, and the last one runs it. The tasks are
+    // pushed by one thread, so the workers never wait for each other in a
+    // cycle.
+    class ExclusiveTask {
+     public:
+        ExclusiveTask(uint32_t workerCount, std::function<void()> task)
+            : waiting_(workerCount), done_(false), task_(std::move(task)) {}
+
+        void Arrive();
+
+     private:
+        std::mutex mtx_;
+        std::condition_variable cond_;
+        uint32_t waiting_;
+        bool done_;
+        std::function<void()> task_;
+    };
+
     struct TaskWorker {
         explicit TaskWorker(size_t cap)
             : running(false), worker(), tasks(cap) {}
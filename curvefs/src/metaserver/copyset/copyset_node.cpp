@@ -70,6 +70,7 @@ CopysetNode::CopysetNode(PoolId poolId, CopysetId copysetId,
       epoch_(0),
       options_(),
       leaderTerm_(-1),
+      leaseReadTerm_(-1),
       peerId_(),
       raftNode_(),
       copysetDataPath_(),
@@ -233,8 +234,7 @@ void CopysetNode::on_apply(braft::Iterator& iter) {
                 std::bind(&MetaOperator::OnApply, metaClosure->GetOperator(),
                           iter.index(), doneGuard.release(),
                           TimeUtility::GetTimeofDayUs());
-            applyQueue_->Push(metaClosure->GetOperator()->HashCode(),
-                              std::move(task));
+            PushToApplyQueue(metaClosure->GetOperator(), std::move(task));
             timer.stop();
             g_concurrent_apply_wait_latency << timer.u_elapsed();
         } else {
@@ -243,17 +243,37 @@ void CopysetNode::on_apply(braft::Iterator& iter) {
             CHECK(metaOperator != nullptr) << "Decode raft log failed";
             butil::Timer timer;
             timer.start();
-            auto hashcode = metaOperator->HashCode();
-            auto task =
-                std::bind(&MetaOperator::OnApplyFromLog, metaOperator.release(),
-                          TimeUtility::GetTimeofDayUs());
-            applyQueue_->Push(hashcode, std::move(task));
+            auto* op = metaOperator.release();
+            auto task = std::bind(&MetaOperator::OnApplyFromLog, op,
+                                  TimeUtility::GetTimeofDayUs());
+            PushToApplyQueue(op, std::move(task));
             timer.stop();
             g_concurrent_apply_wait_latency << timer.u_elapsed();
         }
     }
 }
 
+void CopysetNode::PushToApplyQueue(MetaOperator* op,
+                                   std::function<void()> task) {
+    if (!op->BeforeApply()) {
+        applyQueue_->Flush();
+        op->BeforeApply();
+    }
+
+    if (op->IsExclusive()) {
+        applyQueue_->PushExclusive(std::move(task));
+        return;
+    }
+
+    std::vector<uint64_t> hashCodes;
+    op->GetHashCodes(&hashCodes);
+    if (hashCodes.size() == 1) {
+        applyQueue_->Push(hashCodes[0], std::move(task));
+    } else {
+        applyQueue_->PushJoint(hashCodes, std::move(task));
+    }
+}
+
 void CopysetNode::on_shutdown() {
     LOG(INFO) << "Copyset: " << name_ << " is shutdown";
 }
@@ -272,6 +292,9 @@ class OnSnapshotSaveDoneClosureImpl : public OnSnapshotSaveDoneClosure {
 
         if (ctx_->success) {
             writer_->add_file(kMetaDataFilename);
+            for (const auto& file : files_) {
+                writer_->add_file(file);
+            }
         }
 
         RaftSnapshotMetric::GetInstance().OnSnapshotSaveDone(ctx_);
@@ -291,11 +314,16 @@ class OnSnapshotSaveDoneClosureImpl : public OnSnapshotSaveDoneClosure {
                    << MetaStatusCode_Name(code);
     }
 
+    void AddFile(const std::string& filename) override {
+        files_.push_back(filename);
+    }
+
  private:
     CopysetNode* node_;
     braft::SnapshotWriter* writer_;
     braft::Closure* snapDone_;
     RaftSnapshotMetric::MetricContext* ctx_;
+    std::vector<std::string> files_;
 };
 
 void CopysetNode::on_snapshot_save(braft::SnapshotWriter* writer,
@@ -389,6 +417,14 @@ int CopysetNode::on_snapshot_load(braft::SnapshotReader* reader) {
 void CopysetNode::on_leader_start(int64_t term) {
     leaderTerm_.store(term, std::memory_order_release);
 
+    // the entries before this term are pushed to apply queue already, but
+    // some of them may be still in flight
+    if (applyQueue_) {
+        applyQueue_->Drain([this, term]() {
+            leaseReadTerm_.store(term, std::memory_order_release);
+        });
+    }
+
     LOG(INFO) << "Copyset: " << name_ << ", peer id: " << peerId_.to_string()
               << " become leader, term is " << term;
 }
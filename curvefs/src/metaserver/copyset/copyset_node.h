@@ -25,6 +25,7 @@
 
 #include <braft/raft.h>
 
+#include <functional>
 #include <list>
 #include <memory>
 #include <string>
@@ -50,6 +51,7 @@ using ::curvefs::metaserver::MetaStore;
 using ::curve::mds::heartbeat::ConfigChangeType;
 
 class CopysetNodeManager;
+class MetaOperator;
 
 // Implement our own business raft state machine
 class CopysetNode : public braft::StateMachine {
@@ -78,6 +80,25 @@ class CopysetNode : public braft::StateMachine {
 
     virtual bool IsLeaderTerm() const;
 
+    /**
+     * @brief Get current copyset node's leader lease status
+     */
+    virtual void GetLeaderLeaseStatus(braft::LeaderLeaseStatus* status);
+
+    /**
+     * @brief Whether current copyset node is leader and its lease is valid,
+     *        the leader with a valid lease can serve readonly requests
+     *        without proposing to raft
+     */
+    bool IsLeaseLeader(const braft::LeaderLeaseStatus& status) const;
+
+    /**
+     * @brief Whether the entries committed before current term are all
+     *        applied, lease read is served only after that, because they may
+     *        still be queued on other apply workers
+     */
+    bool IsLeaseReadReady() const;
+
     PoolId GetPoolId() const;
 
     const braft::PeerId& GetPeerId() const;
@@ -127,6 +148,11 @@ class CopysetNode : public braft::StateMachine {
     void FlushApplyQueue() { applyQueue_->Flush(); }
 
     void SetRaftNode(RaftNode* raftNode) { raftNode_.reset(raftNode); }
+
+    void PushToApplyQueueForTest(MetaOperator* op,
+                                 std::function<void()> task) {
+        PushToApplyQueue(op, std::move(task));
+    }
 #endif  // UNIT_TEST
 
  public:
@@ -184,6 +210,9 @@ class CopysetNode : public braft::StateMachine {
     bool FetchLeaderStatus(const braft::PeerId& peerId,
                            braft::NodeStatus* leaderStatus);
 
+    // push the task applying |op| to apply queue, called in log order
+    void PushToApplyQueue(MetaOperator* op, std::function<void()> task);
+
  private:
     const PoolId poolId_;
     const CopysetId copysetId_;
@@ -205,6 +234,9 @@ class CopysetNode : public braft::StateMachine {
     // current term, greater than 0 means leader
     std::atomic<int64_t> leaderTerm_;
 
+    // the leader term whose previous entries are all applied
+    std::atomic<int64_t> leaseReadTerm_;
+
     braft::PeerId peerId_;
 
     std::unique_ptr<RaftNode> raftNode_;
@@ -243,6 +275,25 @@ inline bool CopysetNode::IsLeaderTerm() const {
     return leaderTerm_.load(std::memory_order_acquire) > 0;
 }
 
+inline void CopysetNode::GetLeaderLeaseStatus(
+    braft::LeaderLeaseStatus* status) {
+    raftNode_->get_leader_lease_status(status);
+}
+
+inline bool CopysetNode::IsLeaseLeader(
+    const braft::LeaderLeaseStatus& status) const {
+    // the term of lease is different from current term if leader changed
+    // after the status is fetched
+    auto term = leaderTerm_.load(std::memory_order_acquire);
+    return term > 0 && status.state == braft::LEASE_VALID &&
+           status.term == term;
+}
+
+inline bool CopysetNode::IsLeaseReadReady() const {
+    auto term = leaderTerm_.load(std::memory_order_acquire);
+    return term > 0 && leaseReadTerm_.load(std::memory_order_acquire) == term;
+}
+
 inline PoolId CopysetNode::GetPoolId() const { return poolId_; }
 
 inline CopysetId CopysetNode::GetCopysetId() const { return copysetId_; }
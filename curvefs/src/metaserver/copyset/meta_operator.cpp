@@ -58,9 +58,24 @@ void MetaOperator::Propose() {
 
     // check if operator can bypass propose to raft
     if (CanBypassPropose()) {
-        FastApplyTask();
-        doneGuard.release();
-        return;
+        braft::LeaderLeaseStatus leaseStatus;
+        node_->GetLeaderLeaseStatus(&leaseStatus);
+        if (node_->IsLeaseLeader(leaseStatus) && node_->IsLeaseReadReady()) {
+            // no other node can be elected as leader before the lease
+            // expired, so current node's applied data are the latest
+            LeaseReadTask();
+            doneGuard.release();
+            return;
+        } else if (node_->IsLeaseLeader(leaseStatus) ||
+                   leaseStatus.state == braft::LEASE_DISABLED) {
+            // lease is disabled, or the entries of previous terms may be
+            // still applying, queue behind the ones on the same hash
+            FastApplyTask();
+            doneGuard.release();
+            return;
+        }
+
+        // lease is not ready or expired, read through raft
     }
 
     // propose to raft
@@ -102,18 +117,43 @@ void MetaOperator::FastApplyTask() {
     node_->GetApplyQueue()->Push(HashCode(), std::move(task));
 }
 
+void MetaOperator::LeaseReadTask() {
+    OnApply(node_->GetAppliedIndex(), new MetaOperatorClosure(this),
+            TimeUtility::GetTimeofDayUs());
+}
+
 bool GetInodeOperator::CanBypassPropose() const {
     auto* req = static_cast<const GetInodeRequest*>(request_);
     return req->has_appliedindex() &&
            node_->GetAppliedIndex() >= req->appliedindex();
 }
 
+bool BatchGetInodeAttrOperator::CanBypassPropose() const {
+    auto* req = static_cast<const BatchGetInodeAttrRequest*>(request_);
+    return req->has_appliedindex() &&
+           node_->GetAppliedIndex() >= req->appliedindex();
+}
+
 bool GetDentryOperator::CanBypassPropose() const {
     auto* req = static_cast<const GetDentryRequest*>(request_);
     return req->has_appliedindex() &&
            node_->GetAppliedIndex() >= req->appliedindex();
 }
 
+bool ListDentryOperator::CanBypassPropose() const {
+    auto* req = static_cast<const ListDentryRequest*>(request_);
+    return req->has_appliedindex() &&
+           node_->GetAppliedIndex() >= req->appliedindex();
+}
+
+bool GetOrModifyS3ChunkInfoOperator::CanBypassPropose() const {
+    // only the request which doesn't modify s3 chunk info is readonly
+    auto* req = static_cast<const GetOrModifyS3ChunkInfoRequest*>(request_);
+    return req->s3chunkinfoadd().empty() &&
+           req->s3chunkinforemove().empty() && req->has_appliedindex() &&
+           node_->GetAppliedIndex() >= req->appliedindex();
+}
+
 #define OPERATOR_ON_APPLY(TYPE)                                        \
     void TYPE##Operator::OnApply(int64_t index,                        \
                                  google::protobuf::Closure* done,      \
@@ -141,17 +181,58 @@ OPERATOR_ON_APPLY(ListDentry);
 OPERATOR_ON_APPLY(CreateDentry);
 OPERATOR_ON_APPLY(DeleteDentry);
 OPERATOR_ON_APPLY(GetInode);
-OPERATOR_ON_APPLY(CreateInode);
+OPERATOR_ON_APPLY(BatchGetInodeAttr);
 OPERATOR_ON_APPLY(UpdateInode);
+OPERATOR_ON_APPLY(BatchUpdateInode);
+OPERATOR_ON_APPLY(UpdateDirStat);
 OPERATOR_ON_APPLY(GetOrModifyS3ChunkInfo);
 OPERATOR_ON_APPLY(DeleteInode);
 OPERATOR_ON_APPLY(CreateRootInode);
 OPERATOR_ON_APPLY(CreatePartition);
 OPERATOR_ON_APPLY(DeletePartition);
 OPERATOR_ON_APPLY(PrepareRenameTx);
+OPERATOR_ON_APPLY(UnlinkDentryAndDecNlink);
 
 #undef OPERATOR_ON_APPLY
 
+// the inode is created with the id reserved in raft log order
+void CreateInodeOperator::OnApply(int64_t index,
+                                  google::protobuf::Closure* done,
+                                  uint64_t startTimeUs) {
+    brpc::ClosureGuard doneGuard(done);
+    auto* response = static_cast<CreateInodeResponse*>(response_);
+    auto status = node_->GetMetaStore()->CreateInode(
+        static_cast<const CreateInodeRequest*>(request_), inodeId_, response);
+    if (status == MetaStatusCode::OK) {
+        node_->UpdateAppliedIndex(index);
+        response->set_appliedindex(
+            std::max<uint64_t>(index, node_->GetAppliedIndex()));
+    }
+    node_->GetMetric()->OnOperatorComplete(
+        OperatorType::CreateInode,
+        TimeUtility::GetTimeofDayUs() - startTimeUs,
+        status == MetaStatusCode::OK);
+}
+
+void CreateInodeAndDentryOperator::OnApply(int64_t index,
+                                           google::protobuf::Closure* done,
+                                           uint64_t startTimeUs) {
+    brpc::ClosureGuard doneGuard(done);
+    auto* response = static_cast<CreateInodeAndDentryResponse*>(response_);
+    auto status = node_->GetMetaStore()->CreateInodeAndDentry(
+        static_cast<const CreateInodeAndDentryRequest*>(request_), inodeId_,
+        response);
+    if (status == MetaStatusCode::OK) {
+        node_->UpdateAppliedIndex(index);
+        response->set_appliedindex(
+            std::max<uint64_t>(index, node_->GetAppliedIndex()));
+    }
+    node_->GetMetric()->OnOperatorComplete(
+        OperatorType::CreateInodeAndDentry,
+        TimeUtility::GetTimeofDayUs() - startTimeUs,
+        status == MetaStatusCode::OK);
+}
+
 #define OPERATOR_ON_APPLY_FROM_LOG(TYPE)                                     \
     void TYPE##Operator::OnApplyFromLog(uint64_t startTimeUs) {              \
         std::unique_ptr<TYPE##Operator> selfGuard(this);                     \
@@ -165,17 +246,41 @@ OPERATOR_ON_APPLY(PrepareRenameTx);
 
 OPERATOR_ON_APPLY_FROM_LOG(CreateDentry);
 OPERATOR_ON_APPLY_FROM_LOG(DeleteDentry);
-OPERATOR_ON_APPLY_FROM_LOG(CreateInode);
 OPERATOR_ON_APPLY_FROM_LOG(UpdateInode);
+OPERATOR_ON_APPLY_FROM_LOG(BatchUpdateInode);
+OPERATOR_ON_APPLY_FROM_LOG(UpdateDirStat);
 OPERATOR_ON_APPLY_FROM_LOG(GetOrModifyS3ChunkInfo);
 OPERATOR_ON_APPLY_FROM_LOG(DeleteInode);
 OPERATOR_ON_APPLY_FROM_LOG(CreateRootInode);
 OPERATOR_ON_APPLY_FROM_LOG(CreatePartition);
 OPERATOR_ON_APPLY_FROM_LOG(DeletePartition);
 OPERATOR_ON_APPLY_FROM_LOG(PrepareRenameTx);
+OPERATOR_ON_APPLY_FROM_LOG(UnlinkDentryAndDecNlink);
 
 #undef OPERATOR_ON_APPLY_FROM_LOG
 
+void CreateInodeOperator::OnApplyFromLog(uint64_t startTimeUs) {
+    std::unique_ptr<CreateInodeOperator> selfGuard(this);
+    CreateInodeResponse response;
+    auto status = node_->GetMetaStore()->CreateInode(
+        static_cast<const CreateInodeRequest*>(request_), inodeId_, &response);
+    node_->GetMetric()->OnOperatorComplete(
+        OperatorType::CreateInode, TimeUtility::GetTimeofDayUs() - startTimeUs,
+        status == MetaStatusCode::OK);
+}
+
+void CreateInodeAndDentryOperator::OnApplyFromLog(uint64_t startTimeUs) {
+    std::unique_ptr<CreateInodeAndDentryOperator> selfGuard(this);
+    CreateInodeAndDentryResponse response;
+    auto status = node_->GetMetaStore()->CreateInodeAndDentry(
+        static_cast<const CreateInodeAndDentryRequest*>(request_), inodeId_,
+        &response);
+    node_->GetMetric()->OnOperatorComplete(
+        OperatorType::CreateInodeAndDentry,
+        TimeUtility::GetTimeofDayUs() - startTimeUs,
+        status == MetaStatusCode::OK);
+}
+
 #define READONLY_OPERATOR_ON_APPLY_FROM_LOG(TYPE)               \
     void TYPE##Operator::OnApplyFromLog(uint64_t startTimeUs) { \
         std::unique_ptr<TYPE##Operator> selfGuard(this);        \
@@ -185,6 +290,7 @@ OPERATOR_ON_APPLY_FROM_LOG(PrepareRenameTx);
 READONLY_OPERATOR_ON_APPLY_FROM_LOG(GetDentry);
 READONLY_OPERATOR_ON_APPLY_FROM_LOG(ListDentry);
 READONLY_OPERATOR_ON_APPLY_FROM_LOG(GetInode);
+READONLY_OPERATOR_ON_APPLY_FROM_LOG(BatchGetInodeAttr);
 
 #undef READONLY_OPERATOR_ON_APPLY_FROM_LOG
 
@@ -199,14 +305,19 @@ OPERATOR_REDIRECT(ListDentry);
 OPERATOR_REDIRECT(CreateDentry);
 OPERATOR_REDIRECT(DeleteDentry);
 OPERATOR_REDIRECT(GetInode);
+OPERATOR_REDIRECT(BatchGetInodeAttr);
 OPERATOR_REDIRECT(CreateInode);
 OPERATOR_REDIRECT(UpdateInode);
+OPERATOR_REDIRECT(BatchUpdateInode);
+OPERATOR_REDIRECT(UpdateDirStat);
 OPERATOR_REDIRECT(GetOrModifyS3ChunkInfo);
 OPERATOR_REDIRECT(DeleteInode);
 OPERATOR_REDIRECT(CreateRootInode);
 OPERATOR_REDIRECT(CreatePartition);
 OPERATOR_REDIRECT(DeletePartition);
 OPERATOR_REDIRECT(PrepareRenameTx);
+OPERATOR_REDIRECT(CreateInodeAndDentry);
+OPERATOR_REDIRECT(UnlinkDentryAndDecNlink);
 
 #undef OPERATOR_REDIRECT
 
@@ -220,47 +331,154 @@ OPERATOR_ON_FAILED(ListDentry);
 OPERATOR_ON_FAILED(CreateDentry);
 OPERATOR_ON_FAILED(DeleteDentry);
 OPERATOR_ON_FAILED(GetInode);
+OPERATOR_ON_FAILED(BatchGetInodeAttr);
 OPERATOR_ON_FAILED(CreateInode);
 OPERATOR_ON_FAILED(UpdateInode);
+OPERATOR_ON_FAILED(BatchUpdateInode);
+OPERATOR_ON_FAILED(UpdateDirStat);
 OPERATOR_ON_FAILED(GetOrModifyS3ChunkInfo);
 OPERATOR_ON_FAILED(DeleteInode);
 OPERATOR_ON_FAILED(CreateRootInode);
 OPERATOR_ON_FAILED(CreatePartition);
 OPERATOR_ON_FAILED(DeletePartition);
 OPERATOR_ON_FAILED(PrepareRenameTx);
+OPERATOR_ON_FAILED(CreateInodeAndDentry);
+OPERATOR_ON_FAILED(UnlinkDentryAndDecNlink);
 
 #undef OPERATOR_ON_FAILED
 
-#define OPERATOR_HASH_CODE(TYPE)                                           \
-    uint64_t TYPE##Operator::HashCode() const {                            \
-        return static_cast<const TYPE##Request*>(request_)->partitionid(); \
+bool CreateInodeOperator::BeforeApply() {
+    // the partition may be created by an operator still in apply queue
+    auto* request = static_cast<const CreateInodeRequest*>(request_);
+    if (request->type() == FsFileType::TYPE_SYM_LINK &&
+        request->symlink().empty()) {
+        // the request fails anyway, don't waste an id
+        return true;
+    }
+    auto status = node_->GetMetaStore()->ReserveInodeId(
+        request->partitionid(), &inodeId_);
+    return status != MetaStatusCode::PARTITION_NOT_FOUND;
+}
+
+bool CreateInodeAndDentryOperator::BeforeApply() {
+    auto status = node_->GetMetaStore()->ReserveInodeId(
+        static_cast<const CreateInodeAndDentryRequest*>(request_)
+            ->partitionid(),
+        &inodeId_);
+    return status != MetaStatusCode::PARTITION_NOT_FOUND;
+}
+
+namespace {
+
+inline uint64_t InodeHashCode(uint32_t partitionId, uint64_t inodeId) {
+    return (static_cast<uint64_t>(partitionId) << 32) ^ inodeId;
+}
+
+}  // namespace
+
+#define OPERATOR_HASH_CODE(TYPE, INODEID)                                \
+    uint64_t TYPE##Operator::HashCode() const {                          \
+        auto* request = static_cast<const TYPE##Request*>(request_);     \
+        return InodeHashCode(request->partitionid(), request->INODEID);  \
     }
 
-OPERATOR_HASH_CODE(GetDentry);
-OPERATOR_HASH_CODE(ListDentry);
-OPERATOR_HASH_CODE(CreateDentry);
-OPERATOR_HASH_CODE(DeleteDentry);
-OPERATOR_HASH_CODE(GetInode);
-OPERATOR_HASH_CODE(CreateInode);
-OPERATOR_HASH_CODE(UpdateInode);
-OPERATOR_HASH_CODE(GetOrModifyS3ChunkInfo);
-OPERATOR_HASH_CODE(DeleteInode);
-OPERATOR_HASH_CODE(CreateRootInode);
-OPERATOR_HASH_CODE(PrepareRenameTx);
-OPERATOR_HASH_CODE(DeletePartition);
+OPERATOR_HASH_CODE(GetDentry, parentinodeid());
+OPERATOR_HASH_CODE(ListDentry, dirinodeid());
+OPERATOR_HASH_CODE(CreateDentry, dentry().parentinodeid());
+OPERATOR_HASH_CODE(DeleteDentry, parentinodeid());
+OPERATOR_HASH_CODE(GetInode, inodeid());
+OPERATOR_HASH_CODE(UpdateInode, inodeid());
+OPERATOR_HASH_CODE(UpdateDirStat, inodeid());
+OPERATOR_HASH_CODE(GetOrModifyS3ChunkInfo, inodeid());
+OPERATOR_HASH_CODE(DeleteInode, inodeid());
+OPERATOR_HASH_CODE(UnlinkDentryAndDecNlink, parentinodeid());
 
 #undef OPERATOR_HASH_CODE
 
-#define PARTITION_OPERATOR_HASH_CODE(TYPE)                 \
-    uint64_t TYPE##Operator::HashCode() const {            \
-        return static_cast<const TYPE##Request*>(request_) \
-            ->partition()                                  \
-            .partitionid();                                \
+uint64_t CreateInodeOperator::HashCode() const {
+    return InodeHashCode(
+        static_cast<const CreateInodeRequest*>(request_)->partitionid(),
+        inodeId_);
+}
+
+// hashed by the parent whose dentrys and inode are changed, and by the
+// new inode, because when the log is replayed the requests on the new inode
+// follow it closely and must not be applied before it
+uint64_t CreateInodeAndDentryOperator::HashCode() const {
+    auto* request =
+        static_cast<const CreateInodeAndDentryRequest*>(request_);
+    return InodeHashCode(request->partitionid(), request->parentinodeid());
+}
+
+uint64_t CreateInodeAndDentryOperator::SecondHashCode() const {
+    return InodeHashCode(
+        static_cast<const CreateInodeAndDentryRequest*>(request_)
+            ->partitionid(),
+        inodeId_);
+}
+
+uint64_t UnlinkDentryAndDecNlinkOperator::SecondHashCode() const {
+    auto* request =
+        static_cast<const UnlinkDentryAndDecNlinkRequest*>(request_);
+    return InodeHashCode(request->partitionid(), request->inodeid());
+}
+
+// a batch read spans inodes, but it's hashed by partition as it is when it
+// bypasses raft rather than waiting for all workers, the writes replied
+// before it is proposed are applied already
+uint64_t BatchGetInodeAttrOperator::HashCode() const {
+    return static_cast<const BatchGetInodeAttrRequest*>(request_)
+        ->partitionid();
+}
+
+// a batch update is applied after the operators before it on any inode of
+// the batch, it's hashed by partition if the batch is empty
+uint64_t BatchUpdateInodeOperator::HashCode() const {
+    return static_cast<const BatchUpdateInodeRequest*>(request_)
+        ->partitionid();
+}
+
+void BatchUpdateInodeOperator::GetHashCodes(
+    std::vector<uint64_t>* hashCodes) const {
+    auto* request = static_cast<const BatchUpdateInodeRequest*>(request_);
+    for (const auto& update : request->updateinode()) {
+        hashCodes->push_back(
+            InodeHashCode(request->partitionid(), update.inodeid()));
+    }
+    for (const auto& item : request->s3chunkinfoadd()) {
+        hashCodes->push_back(
+            InodeHashCode(request->partitionid(), item.inodeid()));
     }
+    if (hashCodes->empty()) {
+        hashCodes->push_back(HashCode());
+    }
+}
 
-PARTITION_OPERATOR_HASH_CODE(CreatePartition);
+// exclusive operators aren't hashed when they're applied from raft log,
+// the hash codes are only used when readonly ones bypass raft
+#define EXCLUSIVE_OPERATOR(TYPE)                                           \
+    uint64_t TYPE##Operator::HashCode() const {                            \
+        return static_cast<const TYPE##Request*>(request_)->partitionid(); \
+    }                                                                      \
+    bool TYPE##Operator::IsExclusive() const {                             \
+        return true;                                                       \
+    }
+
+EXCLUSIVE_OPERATOR(CreateRootInode);
+EXCLUSIVE_OPERATOR(PrepareRenameTx);
+EXCLUSIVE_OPERATOR(DeletePartition);
 
-#undef PARTITION_OPERATOR_HASH_CODE
+#undef EXCLUSIVE_OPERATOR
+
+uint64_t CreatePartitionOperator::HashCode() const {
+    return static_cast<const CreatePartitionRequest*>(request_)
+        ->partition()
+        .partitionid();
+}
+
+bool CreatePartitionOperator::IsExclusive() const {
+    return true;
+}
 
 #define OPERATOR_TYPE(TYPE)                                \
     OperatorType TYPE##Operator::GetOperatorType() const { \
@@ -272,14 +490,19 @@ OPERATOR_TYPE(ListDentry);
 OPERATOR_TYPE(CreateDentry);
 OPERATOR_TYPE(DeleteDentry);
 OPERATOR_TYPE(GetInode);
+OPERATOR_TYPE(BatchGetInodeAttr);
 OPERATOR_TYPE(CreateInode);
 OPERATOR_TYPE(UpdateInode);
+OPERATOR_TYPE(BatchUpdateInode);
+OPERATOR_TYPE(UpdateDirStat);
 OPERATOR_TYPE(GetOrModifyS3ChunkInfo);
 OPERATOR_TYPE(DeleteInode);
 OPERATOR_TYPE(CreateRootInode);
 OPERATOR_TYPE(PrepareRenameTx);
 OPERATOR_TYPE(CreatePartition);
 OPERATOR_TYPE(DeletePartition);
+OPERATOR_TYPE(CreateInodeAndDentry);
+OPERATOR_TYPE(UnlinkDentryAndDecNlink);
 
 #undef OPERATOR_TYPE
 
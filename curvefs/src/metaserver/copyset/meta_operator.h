@@ -26,6 +26,8 @@
 #include <brpc/controller.h>
 #include <google/protobuf/message.h>
 
+#include <vector>
+
 #include "curvefs/proto/metaserver.pb.h"
 #include "curvefs/src/metaserver/copyset/copyset_node.h"
 
@@ -80,29 +82,48 @@ class MetaOperator {
 
     virtual void OnApplyFromLog(uint64_t startTimeUs) = 0;
 
+    // Called by raft apply thread in log order before current operator is
+    // pushed to apply queue, e.g., to reserve the id of the inode to create,
+    // returns false if it depends on the operators still in apply queue,
+    // and it's called again after apply queue is flushed
+    virtual bool BeforeApply() {
+        return true;
+    }
+
     // Get hash code of current operator which is used to push current operator
     // task to apply queue, and apply queue will guarantee that operators with
     // the same hash code are executed serially.
-    // Current, all operators' hash code is request's PARTITION-ID
-    // TODO(wuhanqing): Finer grained hash code
-    // e.g.,
-    // For dentry-related operator hash code is `parent-inode-id`
-    // For inode-related operator hash code is `inode-id`
-    // For partition-related operator hash code is `partition-id`
-    // but above hash policy has BUG
-    // scenario:
-    // two operators: create partition and create inode in this partition
-    // if leader crashed after second operator is executed, the new elected
-    // leader must apply those two operators, BUT those two operators are hashed
-    // by different ID, so they can be executed in parallel, and this can lead
-    // to create inode operator is executed prior to create partition operator
-    // Possible solution:
-    // 1. create a partition if crate inode found partition not exist
-    // 2. create inode wait partition create when found partition not exist
+    // For dentry-related operator hash code is `parent-inode-id`, and for
+    // inode-related operator hash code is `inode-id`, so a directory's
+    // dentrys and inode are modified serially.
     virtual uint64_t HashCode() const = 0;
 
+    // Hash code of the other inode changed by current operator, e.g., the
+    // inode of the dentry to unlink, the operator is applied after the
+    // operators before it with either hash code.
+    virtual uint64_t SecondHashCode() const {
+        return HashCode();
+    }
+
+    // Hash codes of all the inodes changed by current operator, the
+    // operator is applied after the operators before it with any of them.
+    virtual void GetHashCodes(std::vector<uint64_t>* hashCodes) const {
+        hashCodes->push_back(HashCode());
+        if (SecondHashCode() != HashCode()) {
+            hashCodes->push_back(SecondHashCode());
+        }
+    }
+
     virtual OperatorType GetOperatorType() const = 0;
 
+    // Exclusive operators are applied after all operators before them and
+    // before all operators after them in raft log, they are the operators
+    // on partitions, or on more than one inode or directory, e.g., an inode
+    // can't be created before the partition it belongs to is created.
+    virtual bool IsExclusive() const {
+        return false;
+    }
+
  private:
     /**
      * @brief Check whether current copyset node is leader
@@ -121,6 +142,12 @@ class MetaOperator {
      */
     void FastApplyTask();
 
+    /**
+     * @brief Apply readonly operator in current rpc thread, the caller must
+     *        ensure current node is leader and its lease is valid
+     */
+    void LeaseReadTask();
+
  private:
     /**
      * @brief Redirect request if current node is not leader
@@ -132,7 +159,8 @@ class MetaOperator {
     /**
      * @brief Whether an operator can bypass propose to raft,
      *        return true iff operator is readonly and request carry with
-     *        an valid appliedindex
+     *        an valid appliedindex, which means the writes seen by client
+     *        have been applied
      */
     virtual bool CanBypassPropose() const {
         return false;
@@ -197,6 +225,8 @@ class ListDentryOperator : public MetaOperator {
 
     void OnFailed(MetaStatusCode code) override;
 
+    bool CanBypassPropose() const override;
+
     OperatorType GetOperatorType() const override;
 };
 
@@ -238,6 +268,54 @@ class DeleteDentryOperator : public MetaOperator {
     OperatorType GetOperatorType() const override;
 };
 
+class CreateInodeAndDentryOperator : public MetaOperator {
+ public:
+    using MetaOperator::MetaOperator;
+
+    void OnApply(int64_t index, google::protobuf::Closure* done,
+                 uint64_t startTimeUs) override;
+
+    void OnApplyFromLog(uint64_t startTimeUs) override;
+
+    bool BeforeApply() override;
+
+    uint64_t HashCode() const override;
+
+    uint64_t SecondHashCode() const override;
+
+ private:
+    void Redirect() override;
+
+    void OnFailed(MetaStatusCode code) override;
+
+    OperatorType GetOperatorType() const override;
+
+ private:
+    // reserved by BeforeApply()
+    uint64_t inodeId_ = UINT64_MAX;
+};
+
+class UnlinkDentryAndDecNlinkOperator : public MetaOperator {
+ public:
+    using MetaOperator::MetaOperator;
+
+    void OnApply(int64_t index, google::protobuf::Closure* done,
+                 uint64_t startTimeUs) override;
+
+    void OnApplyFromLog(uint64_t startTimeUs) override;
+
+    uint64_t HashCode() const override;
+
+    uint64_t SecondHashCode() const override;
+
+ private:
+    void Redirect() override;
+
+    void OnFailed(MetaStatusCode code) override;
+
+    OperatorType GetOperatorType() const override;
+};
+
 class GetInodeOperator : public MetaOperator {
  public:
     using MetaOperator::MetaOperator;
@@ -259,6 +337,27 @@ class GetInodeOperator : public MetaOperator {
     OperatorType GetOperatorType() const override;
 };
 
+class BatchGetInodeAttrOperator : public MetaOperator {
+ public:
+    using MetaOperator::MetaOperator;
+
+    void OnApply(int64_t index, google::protobuf::Closure* done,
+                 uint64_t startTimeUs) override;
+
+    void OnApplyFromLog(uint64_t startTimeUs) override;
+
+    uint64_t HashCode() const override;
+
+ private:
+    void Redirect() override;
+
+    void OnFailed(MetaStatusCode code) override;
+
+    bool CanBypassPropose() const override;
+
+    OperatorType GetOperatorType() const override;
+};
+
 class CreateInodeOperator : public MetaOperator {
  public:
     using MetaOperator::MetaOperator;
@@ -268,6 +367,8 @@ class CreateInodeOperator : public MetaOperator {
 
     void OnApplyFromLog(uint64_t startTimeUs) override;
 
+    bool BeforeApply() override;
+
     uint64_t HashCode() const override;
 
  private:
@@ -276,6 +377,10 @@ class CreateInodeOperator : public MetaOperator {
     void OnFailed(MetaStatusCode code) override;
 
     OperatorType GetOperatorType() const override;
+
+ private:
+    // reserved by BeforeApply()
+    uint64_t inodeId_ = UINT64_MAX;
 };
 
 class UpdateInodeOperator : public MetaOperator {
@@ -297,6 +402,46 @@ class UpdateInodeOperator : public MetaOperator {
     OperatorType GetOperatorType() const override;
 };
 
+class BatchUpdateInodeOperator : public MetaOperator {
+ public:
+    using MetaOperator::MetaOperator;
+
+    void OnApply(int64_t index, google::protobuf::Closure* done,
+                 uint64_t startTimeUs) override;
+
+    void OnApplyFromLog(uint64_t startTimeUs) override;
+
+    uint64_t HashCode() const override;
+
+    void GetHashCodes(std::vector<uint64_t>* hashCodes) const override;
+
+ private:
+    void Redirect() override;
+
+    void OnFailed(MetaStatusCode code) override;
+
+    OperatorType GetOperatorType() const override;
+};
+
+class UpdateDirStatOperator : public MetaOperator {
+ public:
+    using MetaOperator::MetaOperator;
+
+    void OnApply(int64_t index, google::protobuf::Closure* done,
+                 uint64_t startTimeUs) override;
+
+    void OnApplyFromLog(uint64_t startTimeUs) override;
+
+    uint64_t HashCode() const override;
+
+ private:
+    void Redirect() override;
+
+    void OnFailed(MetaStatusCode code) override;
+
+    OperatorType GetOperatorType() const override;
+};
+
 class GetOrModifyS3ChunkInfoOperator : public MetaOperator {
  public:
      using MetaOperator::MetaOperator;
@@ -313,6 +458,8 @@ class GetOrModifyS3ChunkInfoOperator : public MetaOperator {
 
     void OnFailed(MetaStatusCode code) override;
 
+    bool CanBypassPropose() const override;
+
     OperatorType GetOperatorType() const override;
 };
 
@@ -352,6 +499,8 @@ class CreateRootInodeOperator : public MetaOperator {
     void OnFailed(MetaStatusCode code) override;
 
     OperatorType GetOperatorType() const override;
+
+    bool IsExclusive() const override;
 };
 
 class UpdateInodeS3VersionOperator : public MetaOperator {
@@ -390,6 +539,8 @@ class CreatePartitionOperator : public MetaOperator {
     void OnFailed(MetaStatusCode code) override;
 
     OperatorType GetOperatorType() const override;
+
+    bool IsExclusive() const override;
 };
 
 class DeletePartitionOperator : public MetaOperator {
@@ -409,6 +560,8 @@ class DeletePartitionOperator : public MetaOperator {
     void OnFailed(MetaStatusCode code) override;
 
     OperatorType GetOperatorType() const override;
+
+    bool IsExclusive() const override;
 };
 
 class PrepareRenameTxOperator : public MetaOperator {
@@ -428,6 +581,8 @@ class PrepareRenameTxOperator : public MetaOperator {
     void OnFailed(MetaStatusCode code) override;
 
     OperatorType GetOperatorType() const override;
+
+    bool IsExclusive() const override;
 };
 
 }  // namespace copyset
@@ -149,6 +149,23 @@ std::unique_ptr<MetaOperator> RaftLogCodec::Decode(CopysetNode* node,
             return ParseFromRaftLog<GetOrModifyS3ChunkInfoOperator,
                                     GetOrModifyS3ChunkInfoRequest>(
                                         node, type, meta);
+        case OperatorType::BatchGetInodeAttr:
+            return ParseFromRaftLog<BatchGetInodeAttrOperator,
+                                    BatchGetInodeAttrRequest>(node, type, meta);
+        case OperatorType::BatchUpdateInode:
+            return ParseFromRaftLog<BatchUpdateInodeOperator,
+                                    BatchUpdateInodeRequest>(node, type, meta);
+        case OperatorType::CreateInodeAndDentry:
+            return ParseFromRaftLog<CreateInodeAndDentryOperator,
+                                    CreateInodeAndDentryRequest>(
+                                        node, type, meta);
+        case OperatorType::UnlinkDentryAndDecNlink:
+            return ParseFromRaftLog<UnlinkDentryAndDecNlinkOperator,
+                                    UnlinkDentryAndDecNlinkRequest>(
+                                        node, type, meta);
+        case OperatorType::UpdateDirStat:
+            return ParseFromRaftLog<UpdateDirStatOperator,
+                                    UpdateDirStatRequest>(node, type, meta);
         default:
             LOG(ERROR) << "unexpected type: " << static_cast<uint32_t>(type);
             return nullptr;
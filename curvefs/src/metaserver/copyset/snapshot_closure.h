@@ -25,6 +25,8 @@
 
 #include <google/protobuf/stubs/callback.h>
 
+#include <string>
+
 #include "curvefs/proto/metaserver.pb.h"
 
 namespace curvefs {
@@ -38,6 +40,10 @@ class OnSnapshotSaveDoneClosure : public google::protobuf::Closure {
     virtual void SetSuccess() = 0;
 
     virtual void SetError(MetaStatusCode code) = 0;
+
+    // add a file saved in the snapshot directory besides the metadata
+    // file, e.g. the deltas of incremental snapshot
+    virtual void AddFile(const std::string& filename) = 0;
 };
 
 }  // namespace copyset
@@ -20,9 +20,12 @@
  * Author: chenwei
  */
 
+#include <algorithm>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "curvefs/src/metaserver/dentry_storage.h"
+#include "curvefs/src/metaserver/storage.h"
 
 namespace curvefs {
 namespace metaserver {
@@ -53,15 +56,26 @@ inline bool MemoryDentryStorage::HasDeleteMarkFlag(const Dentry& dentry) {
     return (dentry.flag() & DentryFlag::DELETE_MARK_FLAG) != 0;
 }
 
+MemoryDentryStorage::MemoryDentryStorage(bool trackChanges, uint32_t stripes)
+    : trackChanges_(trackChanges) {
+    stripes = std::max(stripes, 1u);
+    for (uint32_t i = 0; i < stripes; i++) {
+        stripes_.push_back(absl::make_unique<Stripe>());
+    }
+}
+
 // NOTE: Find() return the iterator of dentry which has the latest txid,
 // and it will clean the old txid's dentry if you specify compress to true
-Btree::iterator MemoryDentryStorage::Find(const Dentry& dentry, bool compress) {
+Btree::iterator MemoryDentryStorage::Find(Stripe* stripe,
+                                          const Dentry& dentry,
+                                          bool compress) {
+    Btree& dentryTree = stripe->dentryTree;
     auto ikey = dentry;
     ikey.set_txid(0);
 
     std::vector<Btree::iterator> its;
-    for (auto iter = dentryTree_.lower_bound(ikey);
-         iter != dentryTree_.end() && BelongSameOne(*iter, dentry);
+    for (auto iter = dentryTree.lower_bound(ikey);
+         iter != dentryTree.end() && BelongSameOne(*iter, dentry);
          iter++) {
         its.emplace_back(iter);
     }
@@ -69,9 +83,9 @@ Btree::iterator MemoryDentryStorage::Find(const Dentry& dentry, bool compress) {
     auto size = its.size();  // NOTE: size must belong [0, 2]
     if (size > 2) {
         LOG(ERROR) << "There are more than 2 dentrys";
-        return dentryTree_.end();
+        return dentryTree.end();
     } else if (size == 0) {
-        return dentryTree_.end();
+        return dentryTree.end();
     }
 
     // size == 1 || size == 2
@@ -80,19 +94,35 @@ Btree::iterator MemoryDentryStorage::Find(const Dentry& dentry, bool compress) {
     if (HasDeleteMarkFlag(*second)) {
         if (compress) {
             second++;
-            dentryTree_.erase(first, second);
+            for (auto iter = first; iter != second; iter++) {
+                MarkChanged(stripe, *iter);
+            }
+            dentryTree.erase(first, second);
         }
-        return dentryTree_.end();
+        return dentryTree.end();
     }
 
-    return compress ? dentryTree_.erase(first, second) : second;
+    if (compress) {
+        for (auto iter = first; iter != second; iter++) {
+            MarkChanged(stripe, *iter);
+        }
+        return dentryTree.erase(first, second);
+    }
+    return second;
+}
+
+void MemoryDentryStorage::MarkChanged(Stripe* stripe, const Dentry& dentry) {
+    if (trackChanges_) {
+        stripe->changedDentrys.insert(dentry);
+    }
 }
 
 MetaStatusCode MemoryDentryStorage::Insert(const Dentry& dentry) {
-    WriteLockGuard w(rwLock_);
+    Stripe& stripe = GetStripe(dentry);
+    WriteLockGuard w(stripe.rwLock);
 
-    auto iter = Find(dentry, true);
-    if (iter != dentryTree_.end()) {
+    auto iter = Find(&stripe, dentry, true);
+    if (iter != stripe.dentryTree.end()) {
         // Idempotence
         if (IsSameDentry(*iter, dentry)) {
             return MetaStatusCode::IDEMPOTENCE_OK;
@@ -100,27 +130,31 @@ MetaStatusCode MemoryDentryStorage::Insert(const Dentry& dentry) {
         return MetaStatusCode::DENTRY_EXIST;
     }
 
-    dentryTree_.emplace(dentry);
+    stripe.dentryTree.emplace(dentry);
+    MarkChanged(&stripe, dentry);
     return MetaStatusCode::OK;
 }
 
 MetaStatusCode MemoryDentryStorage::Delete(const Dentry& dentry) {
-    WriteLockGuard w(rwLock_);
+    Stripe& stripe = GetStripe(dentry);
+    WriteLockGuard w(stripe.rwLock);
 
-    auto iter = Find(dentry, true);
-    if (iter == dentryTree_.end()) {
+    auto iter = Find(&stripe, dentry, true);
+    if (iter == stripe.dentryTree.end()) {
         return MetaStatusCode::NOT_FOUND;
     }
 
-    dentryTree_.erase(iter);
+    MarkChanged(&stripe, *iter);
+    stripe.dentryTree.erase(iter);
     return MetaStatusCode::OK;
 }
 
 MetaStatusCode MemoryDentryStorage::Get(Dentry* dentry) {
-    ReadLockGuard r(rwLock_);
+    Stripe& stripe = GetStripe(*dentry);
+    ReadLockGuard r(stripe.rwLock);
 
-    auto iter = Find(*dentry, false);
-    if (iter == dentryTree_.end()) {
+    auto iter = Find(&stripe, *dentry, false);
+    if (iter == stripe.dentryTree.end()) {
         return MetaStatusCode::NOT_FOUND;
     }
 
@@ -135,13 +169,17 @@ MetaStatusCode MemoryDentryStorage::List(const Dentry& dentry,
     auto exclude = dentry.name();
     auto txId = dentry.txid();
 
+    // all dentrys of the directory are in one stripe
+    Stripe& stripe = GetStripe(dentry);
+    ReadLockGuard r(stripe.rwLock);
+
     // range = [lower, upper)
     uint32_t count = 0;
     auto ukey = dentry;
     ukey.set_parentinodeid(parentId + 1);
     ukey.set_name("");
-    auto lower = dentryTree_.lower_bound(dentry);
-    auto upper = dentryTree_.upper_bound(ukey);
+    auto lower = stripe.dentryTree.lower_bound(dentry);
+    auto upper = stripe.dentryTree.upper_bound(ukey);
     for (auto first = lower; first != upper; first++) {
         auto exist = false;
         auto iter = first;
@@ -177,21 +215,24 @@ MetaStatusCode MemoryDentryStorage::List(const Dentry& dentry,
 
 MetaStatusCode MemoryDentryStorage::HandleTx(TX_OP_TYPE type,
                                              const Dentry& dentry) {
-    WriteLockGuard w(rwLock_);
+    Stripe& stripe = GetStripe(dentry);
+    WriteLockGuard w(stripe.rwLock);
 
     auto rc = MetaStatusCode::OK;
     switch (type) {
         case TX_OP_TYPE::PREPARE:
             // For idempotence, do not judge the return value
-            dentryTree_.emplace(dentry);
+            stripe.dentryTree.emplace(dentry);
+            MarkChanged(&stripe, dentry);
             break;
 
         case TX_OP_TYPE::COMMIT:
-            Find(dentry, true);
+            Find(&stripe, dentry, true);
             break;
 
         case TX_OP_TYPE::ROLLBACK:
-            dentryTree_.erase(dentry);
+            stripe.dentryTree.erase(dentry);
+            MarkChanged(&stripe, dentry);
             break;
 
         default:
@@ -202,17 +243,385 @@ MetaStatusCode MemoryDentryStorage::HandleTx(TX_OP_TYPE type,
 }
 
 size_t MemoryDentryStorage::Size() {
-    ReadLockGuard r(rwLock_);
-    return dentryTree_.size();
+    size_t size = 0;
+    for (auto& stripe : stripes_) {
+        ReadLockGuard r(stripe->rwLock);
+        size += stripe->dentryTree.size();
+    }
+    return size;
 }
 
 void MemoryDentryStorage::Clear() {
-    ReadLockGuard w(rwLock_);
-    dentryTree_.clear();
+    for (auto& stripe : stripes_) {
+        WriteLockGuard w(stripe->rwLock);
+        if (trackChanges_) {
+            stripe->changedDentrys.insert(stripe->dentryTree.begin(),
+                                          stripe->dentryTree.end());
+        }
+        stripe->dentryTree.clear();
+    }
+}
+
+std::shared_ptr<Iterator> MemoryDentryStorage::NewIterator(
+    uint32_t partitionId) {
+    std::vector<std::shared_ptr<Iterator>> children;
+    for (auto& stripe : stripes_) {
+        auto container = std::shared_ptr<ContainerType>(
+            &stripe->dentryTree, [](ContainerType*) {});  // don't release
+        children.push_back(
+            std::make_shared<SetContainerIterator<ContainerType>>(
+                ENTRY_TYPE::DENTRY, partitionId, container));
+    }
+    return std::make_shared<MergeIterator>(children);
+}
+
+MetaStatusCode MemoryDentryStorage::TakeChanges(DentryChanges* changes) {
+    for (auto& stripe : stripes_) {
+        WriteLockGuard w(stripe->rwLock);
+        for (const auto& dentry : stripe->changedDentrys) {
+            auto iter = stripe->dentryTree.find(dentry);
+            if (iter == stripe->dentryTree.end()) {
+                changes->removedDentrys.push_back(dentry);
+            } else {
+                changes->dentrys.push_back(*iter);
+            }
+        }
+        stripe->changedDentrys.clear();
+    }
+    return MetaStatusCode::OK;
+}
+
+void MemoryDentryStorage::ClearChanges() {
+    for (auto& stripe : stripes_) {
+        WriteLockGuard w(stripe->rwLock);
+        stripe->changedDentrys.clear();
+    }
+}
+
+KVDentryStorage::KVDentryStorage(std::shared_ptr<KVStore> store,
+                                 bool trackChanges)
+    : store_(store), count_(0), trackChanges_(trackChanges) {}
+
+std::string KVDentryStorage::EncodePrefix(const Dentry& dentry) {
+    std::string key;
+    EncodeUint32(dentry.fsid(), &key);
+    EncodeUint64(dentry.parentinodeid(), &key);
+    key.append(dentry.name());
+    key.push_back('\0');
+    return key;
+}
+
+std::string KVDentryStorage::EncodeKey(const Dentry& dentry) {
+    std::string key = EncodePrefix(dentry);
+    EncodeUint64(dentry.txid(), &key);
+    return key;
+}
+
+inline bool KVDentryStorage::HasDeleteMarkFlag(const Dentry& dentry) {
+    return (dentry.flag() & DentryFlag::DELETE_MARK_FLAG) != 0;
+}
+
+MetaStatusCode KVDentryStorage::Find(const Dentry& dentry,
+                                     bool compress,
+                                     Dentry* out) {
+    // versions of the dentry are sorted by txid
+    std::vector<Dentry> dentrys;
+    std::string prefix = EncodePrefix(dentry);
+    auto iter = store_->NewIterator();
+    for (iter->Seek(prefix);
+         iter->Valid() && iter->key().starts_with(prefix);
+         iter->Next()) {
+        Dentry current;
+        if (!current.ParseFromArray(iter->value().data(),
+                                    iter->value().size())) {
+            LOG(ERROR) << "Parse dentry failed";
+            return MetaStatusCode::PARSE_FROM_STRING_FAILED;
+        } else if (current.txid() > dentry.txid()) {
+            break;
+        }
+        dentrys.emplace_back(std::move(current));
+    }
+    if (!iter->status().ok()) {
+        LOG(ERROR) << "Iterate store failed, error = "
+                   << iter->status().ToString();
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+    iter.reset();
+
+    auto size = dentrys.size();  // NOTE: size must belong [0, 2]
+    if (size > 2) {
+        LOG(ERROR) << "There are more than 2 dentrys";
+        return MetaStatusCode::NOT_FOUND;
+    } else if (size == 0) {
+        return MetaStatusCode::NOT_FOUND;
+    }
+
+    // size == 1 || size == 2
+    auto rc = MetaStatusCode::OK;
+    auto obsolete = size - 1;
+    if (HasDeleteMarkFlag(dentrys[size - 1])) {
+        rc = MetaStatusCode::NOT_FOUND;
+        obsolete = size;
+    } else {
+        *out = dentrys[size - 1];
+    }
+
+    for (size_t i = 0; compress && i < obsolete; i++) {
+        auto ret = DeleteLocked(dentrys[i]);
+        if (ret != MetaStatusCode::OK) {
+            return ret;
+        }
+    }
+    return rc;
+}
+
+MetaStatusCode KVDentryStorage::PutLocked(const Dentry& dentry) {
+    std::string key = EncodeKey(dentry);
+    std::string value;
+    leveldb::Status s = store_->Get(key, &value);
+    if (s.ok()) {
+        // same as emplace to btree, the exist one is kept
+        return MetaStatusCode::OK;
+    } else if (!s.IsNotFound()) {
+        LOG(ERROR) << "Get dentry from store failed, dentry = ("
+                   << dentry.ShortDebugString()
+                   << "), error = " << s.ToString();
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+
+    if (!dentry.SerializeToString(&value)) {
+        return MetaStatusCode::SERIALIZE_TO_STRING_FAILED;
+    }
+    s = store_->Put(key, value);
+    if (!s.ok()) {
+        LOG(ERROR) << "Put dentry to store failed, dentry = ("
+                   << dentry.ShortDebugString()
+                   << "), error = " << s.ToString();
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+    count_++;
+    if (trackChanges_) {
+        changedDentrys_.insert(dentry);
+    }
+    return MetaStatusCode::OK;
+}
+
+MetaStatusCode KVDentryStorage::DeleteLocked(const Dentry& dentry) {
+    leveldb::Status s = store_->Delete(EncodeKey(dentry));
+    if (!s.ok()) {
+        LOG(ERROR) << "Delete dentry from store failed, dentry = ("
+                   << dentry.ShortDebugString()
+                   << "), error = " << s.ToString();
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+    count_--;
+    if (trackChanges_) {
+        changedDentrys_.insert(dentry);
+    }
+    return MetaStatusCode::OK;
+}
+
+MetaStatusCode KVDentryStorage::Insert(const Dentry& dentry) {
+    WriteLockGuard w(rwLock_);
+
+    Dentry exist;
+    auto rc = Find(dentry, true, &exist);
+    if (rc == MetaStatusCode::OK) {
+        // Idempotence
+        if (exist.inodeid() == dentry.inodeid()) {
+            return MetaStatusCode::IDEMPOTENCE_OK;
+        }
+        return MetaStatusCode::DENTRY_EXIST;
+    } else if (rc != MetaStatusCode::NOT_FOUND) {
+        return rc;
+    }
+
+    return PutLocked(dentry);
 }
 
-DentryStorage::ContainerType* MemoryDentryStorage::GetContainer() {
-    return &dentryTree_;
+MetaStatusCode KVDentryStorage::Delete(const Dentry& dentry) {
+    WriteLockGuard w(rwLock_);
+
+    Dentry exist;
+    auto rc = Find(dentry, true, &exist);
+    if (rc != MetaStatusCode::OK) {
+        return rc;
+    }
+    return DeleteLocked(exist);
+}
+
+MetaStatusCode KVDentryStorage::Get(Dentry* dentry) {
+    ReadLockGuard r(rwLock_);
+
+    Dentry exist;
+    auto rc = Find(*dentry, false, &exist);
+    if (rc == MetaStatusCode::OK) {
+        dentry->set_inodeid(exist.inodeid());
+    }
+    return rc;
+}
+
+MetaStatusCode KVDentryStorage::List(const Dentry& dentry,
+                                     std::vector<Dentry>* dentrys,
+                                     uint32_t limit) {
+    auto exclude = dentry.name();
+    auto txId = dentry.txid();
+
+    // range = [dentry, next parent), all keys of the parent have the prefix
+    std::string prefix;
+    EncodeUint32(dentry.fsid(), &prefix);
+    EncodeUint64(dentry.parentinodeid(), &prefix);
+
+    // the iterator reads an implicit snapshot, so the lock is not needed
+    uint32_t count = 0;
+    bool exist = false;
+    bool full = false;
+    Dentry latest;
+    auto collect = [&]() {
+        if (exist) {
+            dentrys->push_back(latest);
+            VLOG(1) << "ListDentry, dentry = ("
+                    << latest.ShortDebugString() << ")";
+            if (limit != 0 && ++count >= limit) {
+                full = true;
+            }
+        }
+        exist = false;
+    };
+
+    auto iter = store_->NewIterator();
+    for (iter->Seek(EncodeKey(dentry));
+         iter->Valid() && iter->key().starts_with(prefix);
+         iter->Next()) {
+        Dentry current;
+        if (!current.ParseFromArray(iter->value().data(),
+                                    iter->value().size())) {
+            LOG(ERROR) << "Parse dentry failed";
+            return MetaStatusCode::PARSE_FROM_STRING_FAILED;
+        }
+
+        // versions of one name are adjacent
+        if (exist && latest.name() != current.name()) {
+            collect();
+            if (full) {
+                break;
+            }
+        }
+
+        if (current.name() != exclude && current.txid() <= txId) {
+            if (HasDeleteMarkFlag(current)) {
+                exist = false;
+            } else {
+                exist = true;
+                latest = std::move(current);
+            }
+        }
+    }
+    if (!full) {
+        collect();
+    }
+
+    return dentrys->empty() ? MetaStatusCode::NOT_FOUND : MetaStatusCode::OK;
+}
+
+MetaStatusCode KVDentryStorage::HandleTx(TX_OP_TYPE type,
+                                         const Dentry& dentry) {
+    WriteLockGuard w(rwLock_);
+
+    auto rc = MetaStatusCode::OK;
+    Dentry exist;
+    std::string value;
+    switch (type) {
+        case TX_OP_TYPE::PREPARE:
+            rc = PutLocked(dentry);
+            break;
+
+        case TX_OP_TYPE::COMMIT:
+            rc = Find(dentry, true, &exist);
+            if (rc == MetaStatusCode::NOT_FOUND) {
+                rc = MetaStatusCode::OK;
+            }
+            break;
+
+        case TX_OP_TYPE::ROLLBACK:
+            if (store_->Get(EncodeKey(dentry), &value).ok()) {
+                rc = DeleteLocked(dentry);
+            }
+            break;
+
+        default:
+            rc = MetaStatusCode::PARAM_ERROR;
+    }
+
+    return rc;
+}
+
+size_t KVDentryStorage::Size() {
+    return count_.load();
+}
+
+void KVDentryStorage::Clear() {
+    WriteLockGuard w(rwLock_);
+
+    leveldb::WriteBatch batch;
+    auto iter = store_->NewIterator();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        batch.Delete(iter->key());
+        Dentry dentry;
+        if (trackChanges_ && dentry.ParseFromArray(iter->value().data(),
+                                                   iter->value().size())) {
+            changedDentrys_.insert(std::move(dentry));
+        }
+    }
+    iter.reset();
+
+    leveldb::Status s = store_->Write(&batch);
+    LOG_IF(ERROR, !s.ok()) << "Clear dentrys failed, error = "
+                           << s.ToString();
+    count_ = 0;
+}
+
+std::shared_ptr<Iterator> KVDentryStorage::NewIterator(uint32_t partitionId) {
+    // the snapshot and the count must be taken at the same time
+    ReadLockGuard r(rwLock_);
+    return std::make_shared<KVStoreIterator>(
+        store_,
+        type2str(ENTRY_TYPE::DENTRY) + ":" + std::to_string(partitionId),
+        count_.load());
+}
+
+MetaStatusCode KVDentryStorage::TakeChanges(DentryChanges* changes) {
+    WriteLockGuard w(rwLock_);
+    auto rc = MetaStatusCode::OK;
+    for (const auto& dentry : changedDentrys_) {
+        std::string value;
+        leveldb::Status s = store_->Get(EncodeKey(dentry), &value);
+        if (s.IsNotFound()) {
+            changes->removedDentrys.push_back(dentry);
+            continue;
+        } else if (!s.ok()) {
+            LOG(ERROR) << "Get dentry from store failed, dentry = ("
+                       << dentry.ShortDebugString()
+                       << "), error = " << s.ToString();
+            rc = MetaStatusCode::STORAGE_INTERNAL_ERROR;
+            break;
+        }
+
+        Dentry current;
+        if (!current.ParseFromString(value)) {
+            LOG(ERROR) << "Parse dentry failed";
+            rc = MetaStatusCode::PARSE_FROM_STRING_FAILED;
+            break;
+        }
+        changes->dentrys.push_back(std::move(current));
+    }
+    changedDentrys_.clear();
+    return rc;
+}
+
+void KVDentryStorage::ClearChanges() {
+    WriteLockGuard w(rwLock_);
+    changedDentrys_.clear();
 }
 
 }  // namespace metaserver
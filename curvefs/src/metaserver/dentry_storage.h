@@ -23,7 +23,9 @@
 #ifndef CURVEFS_SRC_METASERVER_DENTRY_STORAGE_H_
 #define CURVEFS_SRC_METASERVER_DENTRY_STORAGE_H_
 
+#include <atomic>
 #include <list>
+#include <memory>
 #include <string>
 #include <vector>
 #include <functional>
@@ -32,6 +34,8 @@
 
 #include "src/common/concurrent/rw_lock.h"
 #include "curvefs/proto/metaserver.pb.h"
+#include "curvefs/src/metaserver/iterator.h"
+#include "curvefs/src/metaserver/kv_storage.h"
 
 namespace curvefs {
 namespace metaserver {
@@ -49,6 +53,14 @@ using Btree = absl::btree_set<Dentry>;
 
 bool operator==(const Dentry& lhs, const Dentry& rhs);
 
+// dentrys changed since the changes were taken last time, see
+// DentryStorage::TakeChanges()
+struct DentryChanges {
+    // inserted dentrys, the versions of a dentry are different entries
+    std::vector<Dentry> dentrys;
+    std::vector<Dentry> removedDentrys;
+};
+
 class DentryStorage {
  public:
     using ContainerType = Btree;
@@ -78,11 +90,24 @@ class DentryStorage {
 
     virtual void Clear() = 0;
 
-    virtual ContainerType* GetContainer() = 0;
+    // iterate all dentrys of the partition for dumping
+    virtual std::shared_ptr<Iterator> NewIterator(uint32_t partitionId) = 0;
+
+    // changes are only tracked if the storage is created with
+    // |trackChanges|, they are saved in the delta of incremental snapshot
+    virtual MetaStatusCode TakeChanges(DentryChanges* changes) = 0;
+    // forget the changes tracked, e.g. after a full snapshot is taken
+    virtual void ClearChanges() = 0;
 };
 
+// Dentrys are striped by parent inode id, each stripe has its own lock and
+// btree, so the operators on different directories of a partition don't
+// contend for one lock. All dentrys of a directory are in the same stripe.
 class MemoryDentryStorage : public DentryStorage {
  public:
+    explicit MemoryDentryStorage(bool trackChanges = false,
+                                 uint32_t stripes = 1);
+
     MetaStatusCode Insert(const Dentry& dentry) override;
 
     MetaStatusCode Delete(const Dentry& dentry) override;
@@ -99,21 +124,97 @@ class MemoryDentryStorage : public DentryStorage {
 
     void Clear() override;
 
-    ContainerType* GetContainer() override;
+    std::shared_ptr<Iterator> NewIterator(uint32_t partitionId) override;
+
+    MetaStatusCode TakeChanges(DentryChanges* changes) override;
+
+    void ClearChanges() override;
 
  private:
+    struct Stripe {
+        RWLock rwLock;
+        Btree dentryTree;
+        // only the keys of dentrys are used
+        Btree changedDentrys;
+    };
+
+    Stripe& GetStripe(const Dentry& dentry) {
+        return *stripes_[dentry.parentinodeid() % stripes_.size()];
+    }
+
     bool BelongSameOne(const Dentry& lhs, const Dentry& rhs);
 
     bool IsSameDentry(const Dentry& lhs, const Dentry& rhs);
 
     bool HasDeleteMarkFlag(const Dentry& dentry);
 
-    Btree::iterator Find(const Dentry& dentry, bool compress);
+    // caller must hold the lock of |stripe|, and hold the write lock
+    // if |compress| is true
+    Btree::iterator Find(Stripe* stripe, const Dentry& dentry, bool compress);
+
+    // caller must hold the write lock of |stripe|
+    void MarkChanged(Stripe* stripe, const Dentry& dentry);
+
+ private:
+    std::vector<std::unique_ptr<Stripe>> stripes_;
+
+    bool trackChanges_;
+};
+
+// Dentrys are kept in a leveldb store, the key is
+// fsid + parentinodeid + name + '\0' + txid, so the order of keys is
+// the same as the order of the btree of MemoryDentryStorage.
+class KVDentryStorage : public DentryStorage {
+ public:
+    explicit KVDentryStorage(std::shared_ptr<KVStore> store,
+                             bool trackChanges = false);
+
+    MetaStatusCode Insert(const Dentry& dentry) override;
+
+    MetaStatusCode Delete(const Dentry& dentry) override;
+
+    MetaStatusCode Get(Dentry* dentry) override;
+
+    MetaStatusCode List(const Dentry& dentry,
+                        std::vector<Dentry>* dentrys,
+                        uint32_t limit) override;
+
+    MetaStatusCode HandleTx(TX_OP_TYPE type, const Dentry& dentry) override;
+
+    size_t Size() override;
+
+    void Clear() override;
+
+    std::shared_ptr<Iterator> NewIterator(uint32_t partitionId) override;
+
+    MetaStatusCode TakeChanges(DentryChanges* changes) override;
+
+    void ClearChanges() override;
+
+ private:
+    static std::string EncodePrefix(const Dentry& dentry);
+
+    static std::string EncodeKey(const Dentry& dentry);
+
+    bool HasDeleteMarkFlag(const Dentry& dentry);
+
+    // same as MemoryDentryStorage::Find(), return the dentry which has
+    // the latest txid in |out|, caller must hold the lock, and hold the
+    // write lock if |compress| is true
+    MetaStatusCode Find(const Dentry& dentry, bool compress, Dentry* out);
+
+    MetaStatusCode PutLocked(const Dentry& dentry);
+
+    MetaStatusCode DeleteLocked(const Dentry& dentry);
 
  private:
     RWLock rwLock_;
+    std::shared_ptr<KVStore> store_;
+    std::atomic<size_t> count_;
 
-    Btree dentryTree_;
+    bool trackChanges_;
+    // only the keys of dentrys are used
+    Btree changedDentrys_;
 };
 
 }  // namespace metaserver
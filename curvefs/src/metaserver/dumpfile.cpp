@@ -21,6 +21,7 @@
  */
 
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <sys/prctl.h>
@@ -64,8 +65,20 @@ do { \
 using ::curve::common::CRC32;
 
 const std::string DumpFile::kCurvefs_ = "CURVEFS";  // NOLINT
-const uint8_t DumpFile::kVersion_ = 1;
+const uint8_t DumpFile::kVersion_ = 2;
 const uint32_t DumpFile::kMaxStringLength_ = 1024 * 1024 * 1024;  // 1GB
+const uint64_t DumpFile::kMaxBlockLength_ = 4 * 1024 * 1024;  // 4MB
+
+namespace {
+
+template <typename Int>
+Int DecodeInt(const char* buffer) {
+    Int num;
+    memcpy(reinterpret_cast<char*>(&num), buffer, sizeof(Int));
+    return num;
+}
+
+}  // namespace
 
 std::ostream& operator<<(std::ostream& os, DUMPFILE_ERROR code) {
     static auto code2str = std::map<DUMPFILE_ERROR, std::string> {
@@ -120,7 +133,9 @@ DumpFile::DumpFile(const std::string& pathname)
     : pathname_(pathname),
       fd_(-1),
       fs_(Ext4FileSystemImpl::getInstance()),
-      loadStatus_(DUMPFILE_LOAD_STATUS::INCOMPLETE) {}
+      loadStatus_(DUMPFILE_LOAD_STATUS::INCOMPLETE),
+      mapAddr_(nullptr),
+      mapLength_(0) {}
 
 DUMPFILE_ERROR DumpFile::Open() {
     if (fd_ >= 0) {
@@ -139,6 +154,7 @@ DUMPFILE_ERROR DumpFile::Open() {
 }
 
 DUMPFILE_ERROR DumpFile::Close() {
+    Unmap();
     if (fd_ < 0) {
         return DUMPFILE_ERROR::OK;
     }
@@ -223,6 +239,16 @@ DUMPFILE_ERROR DumpFile::SaveEntry(const std::string& entry,
     return retCode;
 }
 
+DUMPFILE_ERROR DumpFile::SaveBlockHeader(const std::string& key,
+                                         uint32_t npairs,
+                                         uint64_t length,
+                                         off_t offset,
+                                         uint32_t* blockCheckSum) {
+    RETURN_IF_UNSUCCESS(SaveEntry(key, &offset, blockCheckSum));
+    RETURN_IF_UNSUCCESS(SaveInt<uint32_t>(npairs, &offset, blockCheckSum));
+    return SaveInt<uint64_t>(length, &offset, blockCheckSum);
+}
+
 template <typename Int>
 DUMPFILE_ERROR DumpFile::LoadInt(Int* num, off_t* offset, uint32_t* checkSum) {
     size_t length = sizeof(Int);
@@ -284,18 +310,57 @@ DUMPFILE_ERROR DumpFile::Save(std::shared_ptr<Iterator> iter) {
     RETURN_IF_UNSUCCESS(SaveInt<uint8_t>(kVersion_, &offset, &checkSum));
     RETURN_IF_UNSUCCESS(SaveInt<uint64_t>(iter->Size(), &offset, &checkSum));
 
-    // Step2: save key-value pairs
+    // Step2: save key-value pairs in blocks
     uint64_t nPairs = 0;
+    uint64_t nBlocks = 0;
+    std::string blockKey;
+    uint32_t blockPairs = 0;
+    uint64_t blockLength = 0;
+    off_t blockOffset = 0;
+    uint32_t blockCheckSum = 0;
+    auto closeBlock = [&]() -> DUMPFILE_ERROR {
+        RETURN_IF_UNSUCCESS(SaveBlockHeader(
+            blockKey, blockPairs, blockLength, blockOffset, &blockCheckSum));
+        RETURN_IF_UNSUCCESS(
+            SaveInt<uint32_t>(blockCheckSum, &offset, &checkSum));
+        nBlocks++;
+        blockPairs = 0;
+        return DUMPFILE_ERROR::OK;
+    };
+
     for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
         auto key = iter->Key();
         auto value = iter->Value();
 
-        RETURN_IF_UNSUCCESS(SaveEntry(key, &offset, &checkSum));
-        RETURN_IF_UNSUCCESS(SaveEntry(value, &offset, &checkSum));
+        if (blockPairs > 0 &&
+            (key != blockKey || blockLength >= kMaxBlockLength_ ||
+             blockPairs == UINT32_MAX)) {
+            RETURN_IF_UNSUCCESS(closeBlock());
+        }
+
+        // the header of block is saved when the block is closed
+        if (blockPairs == 0) {
+            blockKey = key;
+            blockLength = 0;
+            blockOffset = offset;
+            blockCheckSum = 0;
+            offset += sizeof(uint32_t) + key.size() + sizeof(uint32_t) +
+                      sizeof(uint64_t);
+        }
+
+        off_t valueOffset = offset;
+        RETURN_IF_UNSUCCESS(SaveEntry(value, &offset, &blockCheckSum));
+        blockLength += offset - valueOffset;
+        blockPairs++;
         nPairs++;
     }
 
-    // Step3: save checksum
+    if (blockPairs > 0) {
+        RETURN_IF_UNSUCCESS(closeBlock());
+    }
+
+    // Step3: save number of blocks and checksum
+    RETURN_IF_UNSUCCESS(SaveInt<uint64_t>(nBlocks, &offset, &checkSum));
     RETURN_IF_UNSUCCESS(SaveInt<uint32_t>(checkSum, &offset, &checkSum));
 
     // Step4: sync
@@ -307,6 +372,7 @@ DUMPFILE_ERROR DumpFile::Save(std::shared_ptr<Iterator> iter) {
 
     LOG(INFO) << "Save success, iterator size = " << iter->Size()
               << ", number of saved entrys = " << nPairs
+              << ", number of saved blocks = " << nBlocks
               << ", checksum = " << checkSum;
     return DUMPFILE_ERROR::OK;
 }
@@ -448,6 +514,165 @@ std::shared_ptr<Iterator> DumpFile::Load() {
     return std::make_shared<DumpFileIterator>(this);
 }
 
+DUMPFILE_ERROR DumpFile::Map() {
+    // the file maybe saved again since last mapping
+    Unmap();
+
+    struct stat info;
+    if (fs_->Fstat(fd_, &info) != 0) {
+        LOG(ERROR) << "Fstat file " << pathname_ << " failed";
+        return DUMPFILE_ERROR::FSTAT_FAILED;
+    } else if (info.st_size == 0) {
+        return DUMPFILE_ERROR::READ_FAILED;
+    }
+
+    void* addr = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (addr == MAP_FAILED) {
+        LOG(ERROR) << "Mmap file " << pathname_ << " failed, error = "
+                   << strerror(errno);
+        return DUMPFILE_ERROR::READ_FAILED;
+    }
+
+    // the blocks are read in parallel, let the kernel read ahead all of them
+    ::madvise(addr, info.st_size, MADV_WILLNEED);
+    mapAddr_ = static_cast<char*>(addr);
+    mapLength_ = info.st_size;
+    return DUMPFILE_ERROR::OK;
+}
+
+void DumpFile::Unmap() {
+    if (mapAddr_ != nullptr) {
+        ::munmap(mapAddr_, mapLength_);
+        mapAddr_ = nullptr;
+        mapLength_ = 0;
+    }
+}
+
+DUMPFILE_LOAD_STATUS DumpFile::MapBlocks(std::vector<DumpFileBlock>* blocks) {
+    blocks->clear();
+    if (fd_ < 0 || Map() != DUMPFILE_ERROR::OK) {
+        return DUMPFILE_LOAD_STATUS::INVALID_FILE;
+    }
+
+    size_t offset = 0;
+    uint32_t checkSum = 0;
+    auto fetch = [&](uint64_t length, uint32_t* crc) -> const char* {
+        if (length > mapLength_ - offset) {
+            return nullptr;
+        }
+        const char* buffer = mapAddr_ + offset;
+        offset += length;
+        if (crc != nullptr) {
+            *crc = CRC32(*crc, buffer, length);
+        }
+        return buffer;
+    };
+
+    // magic, version, size
+    const char* buffer = fetch(kCurvefs_.size(), &checkSum);
+    if (buffer == nullptr ||
+        std::string(buffer, kCurvefs_.size()) != kCurvefs_) {
+        return DUMPFILE_LOAD_STATUS::INVALID_MAGIC;
+    }
+    buffer = fetch(sizeof(uint8_t), &checkSum);
+    if (buffer == nullptr || DecodeInt<uint8_t>(buffer) != kVersion_) {
+        return DUMPFILE_LOAD_STATUS::INVALID_VERSION;
+    }
+    buffer = fetch(sizeof(uint64_t), &checkSum);
+    if (buffer == nullptr) {
+        return DUMPFILE_LOAD_STATUS::INVALID_SIZE;
+    }
+    uint64_t size = DecodeInt<uint64_t>(buffer);
+
+    // headers of blocks
+    uint64_t nPairs = 0;
+    while (nPairs < size) {
+        DumpFileBlock block;
+        block.header = mapAddr_ + offset;
+        buffer = fetch(sizeof(uint32_t), nullptr);
+        if (buffer == nullptr ||
+            DecodeInt<uint32_t>(buffer) > kMaxStringLength_) {
+            return DUMPFILE_LOAD_STATUS::INVALID_PAIRS;
+        }
+        uint32_t keyLength = DecodeInt<uint32_t>(buffer);
+        buffer = fetch(keyLength, nullptr);
+        if (buffer == nullptr) {
+            return DUMPFILE_LOAD_STATUS::INVALID_PAIRS;
+        }
+        block.key = std::string(buffer, keyLength);
+        buffer = fetch(sizeof(uint32_t), nullptr);
+        if (buffer == nullptr || DecodeInt<uint32_t>(buffer) == 0) {
+            return DUMPFILE_LOAD_STATUS::INVALID_PAIRS;
+        }
+        block.npairs = DecodeInt<uint32_t>(buffer);
+        buffer = fetch(sizeof(uint64_t), nullptr);
+        if (buffer == nullptr) {
+            return DUMPFILE_LOAD_STATUS::INVALID_PAIRS;
+        }
+        block.length = DecodeInt<uint64_t>(buffer);
+        block.headerLength = mapAddr_ + offset - block.header;
+        block.values = fetch(block.length, nullptr);
+        buffer = fetch(sizeof(uint32_t), &checkSum);
+        if (block.values == nullptr || buffer == nullptr) {
+            return DUMPFILE_LOAD_STATUS::INVALID_PAIRS;
+        }
+        block.checkSum = DecodeInt<uint32_t>(buffer);
+
+        nPairs += block.npairs;
+        blocks->push_back(std::move(block));
+    }
+
+    // number of blocks, checksum
+    buffer = fetch(sizeof(uint64_t), &checkSum);
+    if (nPairs != size || buffer == nullptr ||
+        DecodeInt<uint64_t>(buffer) != blocks->size()) {
+        return DUMPFILE_LOAD_STATUS::INVALID_PAIRS;
+    }
+    uint32_t crc4calc = checkSum;
+    buffer = fetch(sizeof(uint32_t), nullptr);
+    if (buffer == nullptr || DecodeInt<uint32_t>(buffer) != crc4calc) {
+        return DUMPFILE_LOAD_STATUS::INVALID_CHECKSUM;
+    }
+
+    return DUMPFILE_LOAD_STATUS::COMPLETE;
+}
+
+DUMPFILE_LOAD_STATUS DumpFile::LoadBlock(const DumpFileBlock& block,
+                                         const ValueCallback& callback) const {
+    uint32_t checkSum = CRC32(0, block.values, block.length);
+    checkSum = CRC32(checkSum, block.header, block.headerLength);
+    if (checkSum != block.checkSum) {
+        LOG(ERROR) << "Block checksum mismatch, key = " << block.key
+                   << ", loaded checksum = " << block.checkSum
+                   << ", calculate checksum = " << checkSum;
+        return DUMPFILE_LOAD_STATUS::INVALID_CHECKSUM;
+    }
+
+    uint64_t offset = 0;
+    for (uint32_t i = 0; i < block.npairs; i++) {
+        if (block.length - offset < sizeof(uint32_t)) {
+            return DUMPFILE_LOAD_STATUS::INVALID_PAIRS;
+        }
+        uint32_t length = DecodeInt<uint32_t>(block.values + offset);
+        offset += sizeof(uint32_t);
+        if (length > kMaxStringLength_) {
+            LOG(ERROR) << "The loaded string is too large, size("
+                       << length << ") > limit(" << kMaxStringLength_ << ")";
+            return DUMPFILE_LOAD_STATUS::INVALID_PAIRS;
+        } else if (length > block.length - offset) {
+            return DUMPFILE_LOAD_STATUS::INVALID_PAIRS;
+        }
+
+        if (!callback(block.values + offset, length)) {
+            return DUMPFILE_LOAD_STATUS::INCOMPLETE;
+        }
+        offset += length;
+    }
+
+    return offset == block.length ? DUMPFILE_LOAD_STATUS::COMPLETE :
+                                    DUMPFILE_LOAD_STATUS::INVALID_PAIRS;
+}
+
 DUMPFILE_LOAD_STATUS DumpFile::GetLoadStatus() {
     return loadStatus_;
 }
@@ -463,7 +688,10 @@ DumpFileIterator::DumpFileIterator(DumpFile* dumpfile)
       size_(0),
       isValid_(false),
       startTime_(::curve::common::TimeUtility::GetTimeofDayMs()),
-      dumpfile_(dumpfile) {
+      dumpfile_(dumpfile),
+      version_(0),
+      blockIndex_(0),
+      valueIndex_(0) {
 }
 
 bool DumpFileIterator::Valid() {
@@ -494,6 +722,11 @@ void DumpFileIterator::SeekToFirst() {
         retCode != DUMPFILE_ERROR::OK || version < 1 || version > maxVersion,
         DUMPFILE_LOAD_STATUS::INVALID_VERSION);
 
+    version_ = version;
+    if (version_ > 1) {
+        return SeekToFirstBlock();
+    }
+
     // size
     uint64_t size;
     retCode = dumpfile_->LoadInt<uint64_t>(&size, &offset_, &checkSum_);
@@ -528,9 +761,51 @@ void DumpFileIterator::End() {
     EXIT_LOAD_IF_UNEXPECT(true, status);
 }
 
+void DumpFileIterator::SeekToFirstBlock() {
+    auto status = dumpfile_->MapBlocks(&blocks_);
+    EXIT_LOAD_IF_UNEXPECT(status != DUMPFILE_LOAD_STATUS::COMPLETE, status);
+
+    for (const auto& block : blocks_) {
+        size_ += block.npairs;
+    }
+    isValid_ = true;
+    NextInBlock();
+}
+
+void DumpFileIterator::NextInBlock() {
+    while (valueIndex_ == values_.size()) {
+        if (blockIndex_ == blocks_.size()) {
+            auto endTime = ::curve::common::TimeUtility::GetTimeofDayMs();
+            double elapsed = (endTime - startTime_) * 1.0 / 1000;
+            LOG(INFO) << "Load success, cost " << elapsed << " seconds"
+                      << ", loaded size = " << size_
+                      << ", number of loaded entrys = " << nPairs_
+                      << ", number of loaded blocks = " << blocks_.size();
+            EXIT_LOAD_IF_UNEXPECT(true, DUMPFILE_LOAD_STATUS::COMPLETE);
+        }
+
+        // enter the next block, its values are verified here
+        values_.clear();
+        valueIndex_ = 0;
+        auto status = dumpfile_->LoadBlock(
+            blocks_[blockIndex_++], [this](const char* value, size_t length) {
+                values_.emplace_back(value, length);
+                return true;
+            });
+        EXIT_LOAD_IF_UNEXPECT(status != DUMPFILE_LOAD_STATUS::COMPLETE,
+                              status);
+    }
+
+    nPairs_++;
+    iter_.first = blocks_[blockIndex_ - 1].key;
+    iter_.second = std::move(values_[valueIndex_++]);
+}
+
 void DumpFileIterator::Next() {
     if (!isValid_) {
         return;
+    } else if (version_ > 1) {
+        return NextInBlock();
     } else if (nPairs_ == size_) {
         return End();
     }
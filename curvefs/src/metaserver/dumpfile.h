@@ -23,9 +23,11 @@
 #ifndef CURVEFS_SRC_METASERVER_DUMPFILE_H_
 #define CURVEFS_SRC_METASERVER_DUMPFILE_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "curvefs/src/metaserver/iterator.h"
 
@@ -76,14 +78,35 @@ std::ostream& operator<<(std::ostream& os, DUMPFILE_ERROR code);
 std::ostream& operator<<(std::ostream& os, DUMPFILE_LOAD_STATUS code);
 
 /*
- * dumpfile format:
- *   +---------+---------+------+-----------------+-----------+
- *   | CURVEFS | version | size | key_value_pairs | check_sum |
- *   +---------+---------+------+-----------------+-----------+
+ * dumpfile format (version 2):
+ *   +---------+---------+------+---------+-----+---------+---------+----------+
+ *   | CURVEFS | version | size | block_1 | ... | block_n | nblocks | checksum |
+ *   +---------+---------+------+---------+-----+---------+---------+----------+
  *      CURVEFS:  "CURVEFS" (7-bytes)
  *      version:  uint8_t   (1-byte)
  *      size:     uint64_t  (8-bytes)
- *      checksum: uint32_t  (4-bytes)
+ *      nblocks:  uint64_t  (8-bytes)
+ *      checksum: uint32_t  (4-bytes), crc of the magic, version, size,
+ *                checksums of blocks and nblocks
+ *
+ * block format:
+ *   +------------+-----+--------+--------+----------------+---------+-----+-----------------+
+ *   | key_length | key | npairs | length | value_1_length | value_1 | ... | block_check_sum |
+ *   +------------+-----+--------+--------+----------------+---------+-----+-----------------+
+ *      key_length:      uint32_t (4-bytes)
+ *      value_*_length:  uint32_t (4-bytes)
+ *      npairs:          uint32_t (4-bytes)
+ *      length:          uint64_t (8-bytes), the length of values
+ *      block_check_sum: uint32_t (4-bytes), crc of the values and then
+ *                       the block header
+ *
+ *   consecutive pairs with the same key are saved in one block, so the
+ *   blocks can be verified and decoded independently.
+ *
+ * dumpfile format (version 1):
+ *   +---------+---------+------+-----------------+-----------+
+ *   | CURVEFS | version | size | key_value_pairs | check_sum |
+ *   +---------+---------+------+-----------------+-----------+
  *
  * key_value_pairs format:
  *   +--------------+-------+----------------+---------+-----+--------------+-------+----------------+---------+
@@ -91,6 +114,18 @@ std::ostream& operator<<(std::ostream& os, DUMPFILE_LOAD_STATUS code);
  *   +--------------+-------+----------------+---------+-----+--------------+-------+----------------+---------+
  *      *length: uint32_t (4-bytes)
  */
+
+// a block of the mmaped dumpfile, it's valid until the dumpfile is closed
+struct DumpFileBlock {
+    std::string key;
+    uint32_t npairs;
+    const char* header;
+    size_t headerLength;
+    const char* values;
+    uint64_t length;
+    uint32_t checkSum;
+};
+
 class DumpFile {
  public:
     explicit DumpFile(const std::string& pathname);
@@ -105,6 +140,18 @@ class DumpFile {
 
     std::shared_ptr<Iterator> Load();
 
+    // Map the whole dumpfile and index its blocks, only the headers of
+    // blocks are read here. Returns INVALID_VERSION for dumpfile of
+    // version 1, which has no blocks and must be loaded by Load()
+    DUMPFILE_LOAD_STATUS MapBlocks(std::vector<DumpFileBlock>* blocks);
+
+    // Verify the checksum of |block| and invoke |callback| for its values
+    // in order, it's safe to load different blocks in parallel
+    using ValueCallback = std::function<bool(const char* value,
+                                             size_t length)>;
+    DUMPFILE_LOAD_STATUS LoadBlock(const DumpFileBlock& block,
+                                   const ValueCallback& callback) const;
+
     DUMPFILE_LOAD_STATUS GetLoadStatus();
 
     void SetLoadStatus(DUMPFILE_LOAD_STATUS status);
@@ -137,6 +184,16 @@ class DumpFile {
                              off_t* offset,
                              uint32_t* checkSum);
 
+    DUMPFILE_ERROR SaveBlockHeader(const std::string& key,
+                                   uint32_t npairs,
+                                   uint64_t length,
+                                   off_t offset,
+                                   uint32_t* blockCheckSum);
+
+    DUMPFILE_ERROR Map();
+
+    void Unmap();
+
     static void SignalHandler(int signo, siginfo_t* siginfo, void* ucontext);
 
     DUMPFILE_ERROR InitSignals();
@@ -159,13 +216,21 @@ class DumpFile {
 
     DUMPFILE_LOAD_STATUS loadStatus_;
 
+    char* mapAddr_;
+
+    size_t mapLength_;
+
     static const std::string kCurvefs_;
 
     static const uint8_t kVersion_;
 
     static const uint32_t kMaxStringLength_;
+
+    static const uint64_t kMaxBlockLength_;
 };
 
+// Iterate the pairs of dumpfile in order, the dumpfile of version 2 is
+// read from the blocks mapped
 class DumpFileIterator : public Iterator {
  public:
     using Iter = std::pair<std::string, std::string>;
@@ -190,6 +255,10 @@ class DumpFileIterator : public Iterator {
  private:
     void End();
 
+    void SeekToFirstBlock();
+
+    void NextInBlock();
+
  private:
     off_t offset_;
 
@@ -206,6 +275,17 @@ class DumpFileIterator : public Iterator {
     uint64_t startTime_;
 
     DumpFile* dumpfile_;
+
+    uint8_t version_;
+
+    std::vector<DumpFileBlock> blocks_;
+
+    size_t blockIndex_;
+
+    // values of the current block, they are verified when it's entered
+    std::vector<std::string> values_;
+
+    size_t valueIndex_;
 };
 
 }  // namespace metaserver
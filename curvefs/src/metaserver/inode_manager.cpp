@@ -25,6 +25,7 @@
 #include <glog/logging.h>
 #include <google/protobuf/util/message_differencer.h>
 #include <list>
+#include <map>
 
 #include "curvefs/src/common/define.h"
 #include "src/common/timeutility.h"
@@ -40,12 +41,12 @@ MetaStatusCode InodeManager::CreateInode(uint32_t fsId, uint64_t inodeId,
                                          uint32_t gid, uint32_t mode,
                                          FsFileType type,
                                          const std::string &symlink,
-                                         uint64_t rdev,
+                                         uint64_t rdev, uint64_t parent,
                                          Inode *newInode) {
     VLOG(1) << "CreateInode, fsId = " << fsId << ", length = " << length
             << ", uid = " << uid << ", gid = " << gid << ", mode = " << mode
             << ", type =" << FsFileType_Name(type) << ", symlink = " << symlink
-            << ", rdev = " << rdev;
+            << ", rdev = " << rdev << ", parent = " << parent;
     if (type == FsFileType::TYPE_SYM_LINK && symlink.empty()) {
         return MetaStatusCode::SYM_LINK_EMPTY;
     }
@@ -57,6 +58,9 @@ MetaStatusCode InodeManager::CreateInode(uint32_t fsId, uint64_t inodeId,
     if (type == FsFileType::TYPE_SYM_LINK) {
         inode.set_symlink(symlink);
     }
+    if (parent != 0) {
+        inode.set_parent(parent);
+    }
 
     // 2. insert inode
     MetaStatusCode ret = inodeStorage_->Insert(inode);
@@ -148,12 +152,39 @@ MetaStatusCode InodeManager::GetInode(uint32_t fsId, uint64_t inodeId,
         return ret;
     }
 
+    // s3 chunk infos are kept apart from the inode
+    ret = inodeStorage_->ListS3ChunkInfo(InodeKey(fsId, inodeId), 0,
+                                         UINT64_MAX,
+                                         inode->mutable_s3chunkinfomap());
+    if (ret != MetaStatusCode::OK) {
+        LOG(ERROR) << "ListS3ChunkInfo fail, fsId = " << fsId
+                   << ", inodeId = " << inodeId
+                   << ", ret = " << MetaStatusCode_Name(ret);
+        return ret;
+    }
+
     VLOG(1) << "GetInode success, fsId = " << fsId << ", inodeId = " << inodeId
             << ", " << inode->ShortDebugString();
 
     return MetaStatusCode::OK;
 }
 
+MetaStatusCode InodeManager::GetInodeAttr(uint32_t fsId, uint64_t inodeId,
+                                          InodeAttr *attr) {
+    VLOG(1) << "GetInodeAttr, fsId = " << fsId << ", inodeId = " << inodeId;
+    NameLockGuard lg(inodeLock_, GetInodeLockName(fsId, inodeId));
+    MetaStatusCode ret = inodeStorage_->GetAttr(InodeKey(fsId, inodeId), attr);
+    if (ret != MetaStatusCode::OK) {
+        LOG_IF(ERROR, ret != MetaStatusCode::NOT_FOUND)
+            << "GetInodeAttr fail, fsId = " << fsId
+            << ", inodeId = " << inodeId
+            << ", ret = " << MetaStatusCode_Name(ret);
+        return ret;
+    }
+
+    return MetaStatusCode::OK;
+}
+
 MetaStatusCode InodeManager::DeleteInode(uint32_t fsId, uint64_t inodeId) {
     VLOG(1) << "DeleteInode, fsId = " << fsId << ", inodeId = " << inodeId;
     NameLockGuard lg(inodeLock_, GetInodeLockName(fsId, inodeId));
@@ -216,6 +247,14 @@ MetaStatusCode InodeManager::UpdateInode(const UpdateInodeRequest &request) {
         old->mutable_volumeextentlist()->CopyFrom(request.volumeextentlist());
     }
 
+    // persist the modification if the storage is not in memory
+    ret = inodeStorage_->Update(*old);
+    if (ret != MetaStatusCode::OK) {
+        LOG(ERROR) << "UpdateInode fail, " << request.ShortDebugString()
+                   << ", ret: " << MetaStatusCode_Name(ret);
+        return ret;
+    }
+
     if (needAddTrash) {
         trash_->Add(old->fsid(), old->inodeid(), old->dtime());
     }
@@ -224,6 +263,54 @@ MetaStatusCode InodeManager::UpdateInode(const UpdateInodeRequest &request) {
     return MetaStatusCode::OK;
 }
 
+MetaStatusCode InodeManager::UpdateDirStat(const UpdateDirStatRequest &request,
+                                           uint64_t *parent, DirStat *stat) {
+    VLOG(1) << "UpdateDirStat, " << request.ShortDebugString();
+    NameLockGuard lg(inodeLock_, GetInodeLockName(
+            request.fsid(), request.inodeid()));
+
+    std::shared_ptr<Inode> inode;
+    MetaStatusCode ret = inodeStorage_->Get(
+        InodeKey(request.fsid(), request.inodeid()), &inode);
+    if (ret != MetaStatusCode::OK) {
+        LOG_IF(ERROR, ret != MetaStatusCode::NOT_FOUND)
+            << "GetInode fail, " << request.ShortDebugString()
+            << ", ret: " << MetaStatusCode_Name(ret);
+        return ret;
+    }
+
+    if (request.has_delta()) {
+        if (inode->type() != FsFileType::TYPE_DIRECTORY) {
+            LOG(ERROR) << "UpdateDirStat of non-directory, "
+                       << request.ShortDebugString();
+            return MetaStatusCode::PARAM_ERROR;
+        }
+        DirStat *dirStat = inode->mutable_dirstat();
+        dirStat->set_bytes(dirStat->bytes() + request.delta().bytes());
+        dirStat->set_files(dirStat->files() + request.delta().files());
+        dirStat->set_subdirs(dirStat->subdirs() + request.delta().subdirs());
+    }
+    if (request.has_parent()) {
+        inode->set_parent(request.parent());
+    }
+
+    if (request.has_delta() || request.has_parent()) {
+        ret = inodeStorage_->Update(*inode);
+        if (ret != MetaStatusCode::OK) {
+            LOG(ERROR) << "UpdateInode fail, " << request.ShortDebugString()
+                       << ", ret: " << MetaStatusCode_Name(ret);
+            return ret;
+        }
+    }
+
+    *parent = inode->parent();
+    if (inode->has_dirstat()) {
+        *stat = inode->dirstat();
+    }
+    VLOG(1) << "UpdateDirStat success, " << request.ShortDebugString();
+    return MetaStatusCode::OK;
+}
+
 void MergeToS3ChunkInfoList(const S3ChunkInfoList &listToAdd,
     S3ChunkInfoList *listToMerge) {
     for (int i = 0; i < listToAdd.s3chunks_size(); i++) {
@@ -253,33 +340,55 @@ void RemoveFromS3ChunkInfoList(const S3ChunkInfoList &listToRemove,
     listToMerge->Swap(&newList);
 }
 
-int ProcessRequestFromS3Compact(
+// get the s3 chunk info list of a chunk, a chunk without s3 chunk info
+// gets an empty list
+MetaStatusCode GetS3ChunkInfoList(InodeStorage* storage, const InodeKey& key,
+                                  uint64_t chunkIndex, S3ChunkInfoList* list) {
+    MetaStatusCode ret = storage->GetS3ChunkInfoList(key, chunkIndex, list);
+    if (ret == MetaStatusCode::NOT_FOUND) {
+        list->Clear();
+        return MetaStatusCode::OK;
+    }
+    return ret;
+}
+
+MetaStatusCode ProcessRequestFromS3Compact(
     const google::protobuf::Map<uint64_t, S3ChunkInfoList>& s3ChunkInfoAdd,
     const google::protobuf::Map<uint64_t, S3ChunkInfoList>& s3ChunkInfoRemove,
-    Inode* inode) {
+    const InodeKey& key, InodeStorage* storage) {
     VLOG(9) << "s3compact: request from s3compaction, inodeId:"
-            << inode->inodeid();
+            << key.inodeId;
     auto checkWithLog = [](bool cond) {
         if (!cond)
             LOG(WARNING) << "s3compact: bad GetOrModifyS3ChunkInfo request";
         return cond;
     };
     if (!checkWithLog(s3ChunkInfoAdd.size() == s3ChunkInfoRemove.size()))
-        return -1;
+        return MetaStatusCode::PARAM_ERROR;
+
+    // check all chunks before modifying any of them
+    std::map<uint64_t, S3ChunkInfoList> newLists;
     for (const auto& item : s3ChunkInfoAdd) {
         const auto& chunkIndex = item.first;
         const auto& toAddList = item.second;
-        if (!checkWithLog(toAddList.s3chunks_size() == 1)) return -1;
+        if (!checkWithLog(toAddList.s3chunks_size() == 1))
+            return MetaStatusCode::PARAM_ERROR;
         if (!checkWithLog(s3ChunkInfoRemove.find(chunkIndex) !=
                           s3ChunkInfoRemove.end()))
-            return -1;
+            return MetaStatusCode::PARAM_ERROR;
         const auto& toRemoveList = s3ChunkInfoRemove.at(chunkIndex);
-        const auto& origItem = inode->s3chunkinfomap().find(chunkIndex);
-        if (!checkWithLog(origItem != inode->s3chunkinfomap().end())) return -1;
+        S3ChunkInfoList origList;
+        MetaStatusCode ret =
+            storage->GetS3ChunkInfoList(key, chunkIndex, &origList);
+        if (ret == MetaStatusCode::NOT_FOUND) {
+            checkWithLog(false);
+            return MetaStatusCode::PARAM_ERROR;
+        } else if (ret != MetaStatusCode::OK) {
+            return ret;
+        }
         // delete and insert
         const auto& compactChunkId = toAddList.s3chunks(0).chunkid();
-        S3ChunkInfoList newList;
-        const auto& origList = origItem->second;
+        S3ChunkInfoList& newList = newLists[chunkIndex];
         bool inserted = false;
         const auto& toRemoveS3chunks = toRemoveList.s3chunks();
         for (int i = 0; i < origList.s3chunks_size(); i++) {
@@ -311,9 +420,16 @@ int ProcessRequestFromS3Compact(
             VLOG(9) << "s3compact: add chunkid "
                     << toAddList.s3chunks(0).chunkid();
         }
-        inode->mutable_s3chunkinfomap()->at(chunkIndex).Swap(&newList);
     }
-    return 0;
+
+    for (const auto& item : newLists) {
+        MetaStatusCode ret =
+            storage->UpdateS3ChunkInfoList(key, item.first, item.second);
+        if (ret != MetaStatusCode::OK) {
+            return ret;
+        }
+    }
+    return MetaStatusCode::OK;
 }
 
 MetaStatusCode InodeManager::GetOrModifyS3ChunkInfo(
@@ -328,9 +444,9 @@ MetaStatusCode InodeManager::GetOrModifyS3ChunkInfo(
 
     NameLockGuard lg(inodeLock_, GetInodeLockName(
             fsId, inodeId));
+    InodeKey key(fsId, inodeId);
     std::shared_ptr<Inode> old;
-    MetaStatusCode ret = inodeStorage_->Get(
-        InodeKey(fsId, inodeId), &old);
+    MetaStatusCode ret = inodeStorage_->Get(key, &old);
     if (ret != MetaStatusCode::OK) {
         LOG(ERROR) << "GetInode fail, fsId: " << fsId
                    << ", inodeId: " << inodeId
@@ -342,54 +458,48 @@ MetaStatusCode InodeManager::GetOrModifyS3ChunkInfo(
         // judge if duplicated add or not
         if (!s3ChunkInfoAdd.empty()) {
             auto ix = s3ChunkInfoAdd.begin();
-            auto it = old->mutable_s3chunkinfomap()->find(
-                ix->first);
-            if (it != old->mutable_s3chunkinfomap()->end()) {
-                auto &s3chunkInfo = ix->second.s3chunks(0);
-                auto s3Chunks = it->second.mutable_s3chunks();
-                auto s3chunkIt =
-                    std::find_if(s3Chunks->begin(), s3Chunks->end(),
-                         [&](const S3ChunkInfo& c) {
-                             return MessageDifferencer::Equals(c, s3chunkInfo);
-                         });
-                if (s3chunkIt != s3Chunks->end()) {
-                    // duplicated
-                    duplicated = true;
-                }
+            S3ChunkInfoList list;
+            ret = GetS3ChunkInfoList(inodeStorage_.get(), key, ix->first,
+                                     &list);
+            if (ret != MetaStatusCode::OK) {
+                return ret;
+            }
+            auto &s3chunkInfo = ix->second.s3chunks(0);
+            auto s3chunkIt =
+                std::find_if(list.s3chunks().begin(), list.s3chunks().end(),
+                     [&](const S3ChunkInfo& c) {
+                         return MessageDifferencer::Equals(c, s3chunkInfo);
+                     });
+            if (s3chunkIt != list.s3chunks().end()) {
+                // duplicated
+                duplicated = true;
             }
         }
         if (!duplicated) {
             if (fromS3Compaction) {
-                int r = ProcessRequestFromS3Compact(s3ChunkInfoAdd,
-                    s3ChunkInfoRemove, old.get());
-                if (r == -1) {
-                    return MetaStatusCode::PARAM_ERROR;
-                }
+                ret = ProcessRequestFromS3Compact(s3ChunkInfoAdd,
+                    s3ChunkInfoRemove, key, inodeStorage_.get());
             } else {
-                for (auto &item : s3ChunkInfoAdd) {
-                    auto it = old->mutable_s3chunkinfomap()->find(item.first);
-                    if (it != old->mutable_s3chunkinfomap()->end()) {
-                        MergeToS3ChunkInfoList(item.second, &(it->second));
-                    } else {
-                        old->mutable_s3chunkinfomap()->insert(
-                            {item.first, item.second});
-                    }
-                }
-
-                for (auto &item : s3ChunkInfoRemove) {
-                    auto it = old->mutable_s3chunkinfomap()->find(item.first);
-                    if (it != old->mutable_s3chunkinfomap()->end()) {
-                        RemoveFromS3ChunkInfoList(item.second, &(it->second));
-                        if (0 == it->second.s3chunks_size()) {
-                            old->mutable_s3chunkinfomap()->erase(it);
-                        }
-                    }
-                }
+                ret = ModifyS3ChunkInfo(key, s3ChunkInfoAdd,
+                                        s3ChunkInfoRemove);
+            }
+            if (ret != MetaStatusCode::OK) {
+                LOG(ERROR) << "ModifyS3ChunkInfo fail, fsId: " << fsId
+                           << ", inodeId: " << inodeId
+                           << ", ret: " << MetaStatusCode_Name(ret);
+                return ret;
             }
         }
     }
     if (returnS3ChunkInfoMap) {
-        *out = old->s3chunkinfomap();
+        out->clear();
+        ret = inodeStorage_->ListS3ChunkInfo(key, 0, UINT64_MAX, out);
+        if (ret != MetaStatusCode::OK) {
+            LOG(ERROR) << "ListS3ChunkInfo fail, fsId: " << fsId
+                       << ", inodeId: " << inodeId
+                       << ", ret: " << MetaStatusCode_Name(ret);
+            return ret;
+        }
     }
 
     VLOG(1) << "GetOrModifyS3ChunkInfo success, fsId: " << fsId
@@ -398,6 +508,47 @@ MetaStatusCode InodeManager::GetOrModifyS3ChunkInfo(
     return MetaStatusCode::OK;
 }
 
+MetaStatusCode InodeManager::ModifyS3ChunkInfo(
+    const InodeKey& key,
+    const google::protobuf::Map<uint64_t, S3ChunkInfoList>& s3ChunkInfoAdd,
+    const google::protobuf::Map<uint64_t, S3ChunkInfoList>&
+        s3ChunkInfoRemove) {
+    // only the lists of chunks in request are read and written
+    std::map<uint64_t, S3ChunkInfoList> lists;
+    MetaStatusCode ret;
+    for (auto &item : s3ChunkInfoAdd) {
+        auto &list = lists[item.first];
+        ret = GetS3ChunkInfoList(inodeStorage_.get(), key, item.first, &list);
+        if (ret != MetaStatusCode::OK) {
+            return ret;
+        }
+        MergeToS3ChunkInfoList(item.second, &list);
+    }
+
+    for (auto &item : s3ChunkInfoRemove) {
+        auto it = lists.find(item.first);
+        if (it == lists.end()) {
+            it = lists.emplace(item.first, S3ChunkInfoList()).first;
+            ret = GetS3ChunkInfoList(inodeStorage_.get(), key, item.first,
+                                     &(it->second));
+            if (ret != MetaStatusCode::OK) {
+                return ret;
+            }
+        }
+        RemoveFromS3ChunkInfoList(item.second, &(it->second));
+    }
+
+    // an empty list removes the chunk
+    for (auto &item : lists) {
+        ret = inodeStorage_->UpdateS3ChunkInfoList(key, item.first,
+                                                   item.second);
+        if (ret != MetaStatusCode::OK) {
+            return ret;
+        }
+    }
+    return MetaStatusCode::OK;
+}
+
 MetaStatusCode InodeManager::UpdateInodeWhenCreateOrRemoveSubNode(
     uint32_t fsId, uint64_t inodeId, bool isCreate) {
     VLOG(1) << "UpdateInodeWhenCreateOrRemoveSubNode, fsId = " << fsId
@@ -431,11 +582,68 @@ MetaStatusCode InodeManager::UpdateInodeWhenCreateOrRemoveSubNode(
     inode->set_mtime(now.tv_sec);
     inode->set_mtime_ns(now.tv_nsec);
 
+    ret = inodeStorage_->Update(*inode);
+    if (ret != MetaStatusCode::OK) {
+        LOG(ERROR) << "UpdateInode fail, " << inode->ShortDebugString()
+                   << ", ret = " << MetaStatusCode_Name(ret);
+        return ret;
+    }
+
     VLOG(1) << "UpdateInodeWhenCreateOrRemoveSubNode success, "
             << inode->ShortDebugString();
     return MetaStatusCode::OK;
 }
 
+MetaStatusCode InodeManager::UnlinkInode(uint32_t fsId, uint64_t inodeId) {
+    VLOG(1) << "UnlinkInode, fsId = " << fsId << ", inodeId = " << inodeId;
+    NameLockGuard lg(inodeLock_, GetInodeLockName(fsId, inodeId));
+
+    std::shared_ptr<Inode> inode;
+    MetaStatusCode ret = inodeStorage_->Get(InodeKey(fsId, inodeId), &inode);
+    if (ret != MetaStatusCode::OK) {
+        LOG(ERROR) << "GetInode fail, fsId = " << fsId
+                   << ", inodeId = " << inodeId
+                   << ", ret = " << MetaStatusCode_Name(ret);
+        return ret;
+    }
+
+    uint32_t nlink = inode->nlink();
+    if (nlink == 0) {
+        // already be deleted
+        return MetaStatusCode::OK;
+    }
+    // a directory has only the link of its '.' left once it's removed
+    --nlink;
+    if (nlink == 1 && inode->type() == FsFileType::TYPE_DIRECTORY) {
+        nlink = 0;
+    }
+    inode->set_nlink(nlink);
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    inode->set_ctime(now.tv_sec);
+    inode->set_ctime_ns(now.tv_nsec);
+    inode->set_mtime(now.tv_sec);
+    inode->set_mtime_ns(now.tv_nsec);
+    if (nlink == 0) {
+        inode->set_dtime(now.tv_sec);
+    }
+
+    ret = inodeStorage_->Update(*inode);
+    if (ret != MetaStatusCode::OK) {
+        LOG(ERROR) << "UpdateInode fail, " << inode->ShortDebugString()
+                   << ", ret = " << MetaStatusCode_Name(ret);
+        return ret;
+    }
+
+    if (nlink == 0) {
+        trash_->Add(fsId, inodeId, inode->dtime());
+    }
+
+    VLOG(1) << "UnlinkInode success, " << inode->ShortDebugString();
+    return MetaStatusCode::OK;
+}
+
 MetaStatusCode InodeManager::InsertInode(const Inode &inode) {
     VLOG(1) << "InsertInode, " << inode.ShortDebugString();
 
@@ -454,6 +662,36 @@ MetaStatusCode InodeManager::InsertInode(const Inode &inode) {
     return MetaStatusCode::OK;
 }
 
+MetaStatusCode InodeManager::UpsertInode(const Inode &inode) {
+    VLOG(1) << "UpsertInode, " << inode.ShortDebugString();
+    NameLockGuard lg(inodeLock_, GetInodeLockName(
+            inode.fsid(), inode.inodeid()));
+
+    std::shared_ptr<Inode> old;
+    MetaStatusCode ret = inodeStorage_->Get(InodeKey(inode), &old);
+    if (ret == MetaStatusCode::NOT_FOUND) {
+        return InsertInode(inode);
+    } else if (ret != MetaStatusCode::OK) {
+        LOG(ERROR) << "GetInode fail, " << inode.ShortDebugString()
+                   << ", ret = " << MetaStatusCode_Name(ret);
+        return ret;
+    }
+
+    // the inode with nlink 0 is in trash already
+    bool needAddTrash = old->nlink() != 0 && inode.nlink() == 0;
+    ret = inodeStorage_->Update(inode);
+    if (ret != MetaStatusCode::OK) {
+        LOG(ERROR) << "UpdateInode fail, " << inode.ShortDebugString()
+                   << ", ret = " << MetaStatusCode_Name(ret);
+        return ret;
+    }
+
+    if (needAddTrash) {
+        trash_->Add(inode.fsid(), inode.inodeid(), inode.dtime());
+    }
+    return MetaStatusCode::OK;
+}
+
 void InodeManager::GetInodeIdList(std::list<uint64_t>* inodeIdList) {
     inodeStorage_->GetInodeIdList(inodeIdList);
 }
@@ -46,15 +46,24 @@ class InodeManager {
     MetaStatusCode CreateInode(uint32_t fsId, uint64_t inodeId, uint64_t length,
                                uint32_t uid, uint32_t gid, uint32_t mode,
                                FsFileType type, const std::string &symlink,
-                               uint64_t rdev, Inode *inode);
+                               uint64_t rdev, uint64_t parent, Inode *inode);
     MetaStatusCode CreateRootInode(uint32_t fsId, uint32_t uid, uint32_t gid,
                                    uint32_t mode);
     MetaStatusCode GetInode(uint32_t fsId, uint64_t inodeId, Inode *inode);
 
+    MetaStatusCode GetInodeAttr(uint32_t fsId, uint64_t inodeId,
+                                InodeAttr *attr);
+
     MetaStatusCode DeleteInode(uint32_t fsId, uint64_t inodeId);
 
     MetaStatusCode UpdateInode(const UpdateInodeRequest &request);
 
+    // add the delta to the stats of directory and/or set its parent,
+    // |parent| is set to the parent after update, and |stat| to the
+    // stats if the directory has any
+    MetaStatusCode UpdateDirStat(const UpdateDirStatRequest &request,
+                                 uint64_t *parent, DirStat *stat);
+
     MetaStatusCode GetOrModifyS3ChunkInfo(
         uint32_t fsId, uint64_t inodeId,
         const google::protobuf::Map<uint64_t, S3ChunkInfoList>& s3ChunkInfoAdd,
@@ -67,8 +76,15 @@ class InodeManager {
     MetaStatusCode UpdateInodeWhenCreateOrRemoveSubNode(uint32_t fsId,
         uint64_t inodeId, bool isCreate);
 
+    // decrease the nlink of the inode whose dentry is removed, the inode
+    // is moved to trash if no link is left
+    MetaStatusCode UnlinkInode(uint32_t fsId, uint64_t inodeId);
+
     MetaStatusCode InsertInode(const Inode &inode);
 
+    // insert the inode, or replace the existing one
+    MetaStatusCode UpsertInode(const Inode &inode);
+
     void GetInodeIdList(std::list<uint64_t>* inodeIdList);
 
  private:
@@ -76,6 +92,14 @@ class InodeManager {
                                uint32_t uid, uint32_t gid, uint32_t mode,
                                FsFileType type, uint64_t rdev, Inode *inode);
 
+    // merge and remove s3 chunk infos of chunks, caller must hold the
+    // name lock of the inode
+    MetaStatusCode ModifyS3ChunkInfo(
+        const InodeKey& key,
+        const google::protobuf::Map<uint64_t, S3ChunkInfoList>& s3ChunkInfoAdd,
+        const google::protobuf::Map<uint64_t, S3ChunkInfoList>&
+            s3ChunkInfoRemove);
+
     std::string GetInodeLockName(uint32_t fsId, uint64_t inodeId) {
         return std::to_string(fsId) + "_" + std::to_string(inodeId);
     }
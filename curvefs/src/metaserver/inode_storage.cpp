@@ -25,23 +25,63 @@
 #include <algorithm>
 #include <vector>
 
+#include "absl/cleanup/cleanup.h"
+#include "absl/memory/memory.h"
+#include "curvefs/src/common/inode_attr.h"
+#include "curvefs/src/metaserver/storage.h"
+
 namespace curvefs {
 namespace metaserver {
+
+namespace {
+
+// the inode kept in storage, without s3 chunk infos
+std::shared_ptr<Inode> StripS3ChunkInfo(const Inode &inode) {
+    auto out = std::make_shared<Inode>();
+    if (inode.s3chunkinfomap().empty()) {
+        *out = inode;
+    } else {
+        Inode copy = inode;
+        copy.clear_s3chunkinfomap();
+        out->Swap(&copy);
+    }
+    return out;
+}
+
+}  // namespace
+
+MemoryInodeStorage::MemoryInodeStorage(bool trackChanges, uint32_t stripes)
+    : trackChanges_(trackChanges) {
+    stripes = std::max(stripes, 1u);
+    for (uint32_t i = 0; i < stripes; i++) {
+        stripes_.push_back(absl::make_unique<Stripe>());
+    }
+}
+
 MetaStatusCode MemoryInodeStorage::Insert(const Inode &inode) {
-    WriteLockGuard writeLockGuard(rwLock_);
-    std::shared_ptr<Inode> newInode = std::make_shared<Inode>(inode);
-    auto it = inodeMap_.emplace(InodeKey(inode), newInode);
-    if (it.second == false) {
+    InodeKey key(inode);
+    Stripe &stripe = GetStripe(key);
+    WriteLockGuard writeLockGuard(stripe.rwLock);
+    auto it = stripe.inodeMap.find(key);
+    if (it != stripe.inodeMap.end()) {
         return MetaStatusCode::INODE_EXIST;
     }
+    stripe.inodeMap.emplace(key, StripS3ChunkInfo(inode));
+    if (trackChanges_) {
+        stripe.changedInodes.insert(key);
+    }
+    for (const auto &item : inode.s3chunkinfomap()) {
+        UpdateS3ChunkInfoListLocked(&stripe, key, item.first, item.second);
+    }
     return MetaStatusCode::OK;
 }
 
 MetaStatusCode MemoryInodeStorage::Get(
     const InodeKey &key, std::shared_ptr<Inode> *inode) {
-    ReadLockGuard readLockGuard(rwLock_);
-    auto it = inodeMap_.find(key);
-    if (it == inodeMap_.end()) {
+    Stripe &stripe = GetStripe(key);
+    ReadLockGuard readLockGuard(stripe.rwLock);
+    auto it = stripe.inodeMap.find(key);
+    if (it == stripe.inodeMap.end()) {
         return MetaStatusCode::NOT_FOUND;
     }
     *inode = it->second;
@@ -49,49 +89,604 @@ MetaStatusCode MemoryInodeStorage::Get(
 }
 
 MetaStatusCode MemoryInodeStorage::GetCopy(const InodeKey &key, Inode *inode) {
-    ReadLockGuard readLockGuard(rwLock_);
-    auto it = inodeMap_.find(key);
-    if (it == inodeMap_.end()) {
+    Stripe &stripe = GetStripe(key);
+    ReadLockGuard readLockGuard(stripe.rwLock);
+    auto it = stripe.inodeMap.find(key);
+    if (it == stripe.inodeMap.end()) {
         return MetaStatusCode::NOT_FOUND;
     }
     *inode = *(it->second);
     return MetaStatusCode::OK;
 }
 
+MetaStatusCode MemoryInodeStorage::GetAttr(const InodeKey &key,
+                                           InodeAttr *attr) {
+    Stripe &stripe = GetStripe(key);
+    ReadLockGuard readLockGuard(stripe.rwLock);
+    auto it = stripe.inodeMap.find(key);
+    if (it == stripe.inodeMap.end()) {
+        return MetaStatusCode::NOT_FOUND;
+    }
+
+    curvefs::common::InodeToAttr(*(it->second), attr);
+    return MetaStatusCode::OK;
+}
+
 MetaStatusCode MemoryInodeStorage::Delete(const InodeKey &key) {
-    WriteLockGuard writeLockGuard(rwLock_);
-    auto it = inodeMap_.find(key);
-    if (it != inodeMap_.end()) {
-        inodeMap_.erase(it);
+    Stripe &stripe = GetStripe(key);
+    WriteLockGuard writeLockGuard(stripe.rwLock);
+    auto it = stripe.inodeMap.find(key);
+    if (it != stripe.inodeMap.end()) {
+        stripe.inodeMap.erase(it);
+        auto begin = stripe.s3ChunkInfoMap.lower_bound(
+            S3ChunkInfoKey(key.fsId, key.inodeId, 0));
+        auto end = stripe.s3ChunkInfoMap.upper_bound(
+            S3ChunkInfoKey(key.fsId, key.inodeId, UINT64_MAX));
+        if (trackChanges_) {
+            stripe.changedInodes.insert(key);
+            for (auto iter = begin; iter != end; ++iter) {
+                stripe.changedS3ChunkInfoLists.insert(iter->first);
+            }
+        }
+        stripe.s3ChunkInfoMap.erase(begin, end);
         return MetaStatusCode::OK;
     }
     return MetaStatusCode::NOT_FOUND;
 }
 
 MetaStatusCode MemoryInodeStorage::Update(const Inode &inode) {
-    WriteLockGuard writeLockGuard(rwLock_);
-    auto it = inodeMap_.find(InodeKey(inode));
-    if (it == inodeMap_.end()) {
+    InodeKey key(inode);
+    Stripe &stripe = GetStripe(key);
+    WriteLockGuard writeLockGuard(stripe.rwLock);
+    auto it = stripe.inodeMap.find(key);
+    if (it == stripe.inodeMap.end()) {
         return MetaStatusCode::NOT_FOUND;
     }
-    *(it->second) = inode;
+    // the inode may be the one got by Get() and modified in place
+    if (it->second.get() != &inode) {
+        *(it->second) = inode;
+    }
+    it->second->clear_s3chunkinfomap();
+    if (trackChanges_) {
+        stripe.changedInodes.insert(key);
+    }
     return MetaStatusCode::OK;
 }
 
 int MemoryInodeStorage::Count() {
+    int count = 0;
+    for (auto &stripe : stripes_) {
+        ReadLockGuard readLockGuard(stripe->rwLock);
+        count += stripe->inodeMap.size();
+    }
+    return count;
+}
+
+void MemoryInodeStorage::GetInodeIdList(std::list<uint64_t>* inodeIdList) {
+    for (auto &stripe : stripes_) {
+        ReadLockGuard readLockGuard(stripe->rwLock);
+        for (const auto &item : stripe->inodeMap) {
+            inodeIdList->push_back(item.second->inodeid());
+        }
+    }
+}
+
+std::shared_ptr<Iterator> MemoryInodeStorage::NewIterator(
+    uint32_t partitionId) {
+    std::vector<std::shared_ptr<Iterator>> children;
+    for (auto &stripe : stripes_) {
+        auto container = std::shared_ptr<ContainerType>(
+            &stripe->inodeMap, [](ContainerType*) {});  // don't release storage
+        children.push_back(
+            std::make_shared<MapContainerIterator<ContainerType>>(
+                ENTRY_TYPE::INODE, partitionId, container));
+    }
+    return std::make_shared<MergeIterator>(children);
+}
+
+MetaStatusCode MemoryInodeStorage::GetS3ChunkInfoList(
+    const InodeKey &key, uint64_t chunkIndex, S3ChunkInfoList *list) {
+    Stripe &stripe = GetStripe(key);
+    ReadLockGuard readLockGuard(stripe.rwLock);
+    auto it = stripe.s3ChunkInfoMap.find(
+        S3ChunkInfoKey(key.fsId, key.inodeId, chunkIndex));
+    if (it == stripe.s3ChunkInfoMap.end()) {
+        return MetaStatusCode::NOT_FOUND;
+    }
+    *list = it->second.s3chunkinfolist();
+    return MetaStatusCode::OK;
+}
+
+void MemoryInodeStorage::UpdateS3ChunkInfoListLocked(
+    Stripe *stripe, const InodeKey &key, uint64_t chunkIndex,
+    const S3ChunkInfoList &list) {
+    S3ChunkInfoKey chunkKey(key.fsId, key.inodeId, chunkIndex);
+    if (trackChanges_) {
+        stripe->changedS3ChunkInfoLists.insert(chunkKey);
+    }
+    if (list.s3chunks_size() == 0) {
+        stripe->s3ChunkInfoMap.erase(chunkKey);
+        return;
+    }
+
+    InodeS3ChunkInfoList &value = stripe->s3ChunkInfoMap[chunkKey];
+    value.set_fsid(key.fsId);
+    value.set_inodeid(key.inodeId);
+    value.set_chunkindex(chunkIndex);
+    *value.mutable_s3chunkinfolist() = list;
+}
+
+MetaStatusCode MemoryInodeStorage::UpdateS3ChunkInfoList(
+    const InodeKey &key, uint64_t chunkIndex, const S3ChunkInfoList &list) {
+    Stripe &stripe = GetStripe(key);
+    WriteLockGuard writeLockGuard(stripe.rwLock);
+    UpdateS3ChunkInfoListLocked(&stripe, key, chunkIndex, list);
+    return MetaStatusCode::OK;
+}
+
+MetaStatusCode MemoryInodeStorage::ListS3ChunkInfo(const InodeKey &key,
+                                                   uint64_t beginIndex,
+                                                   uint64_t endIndex,
+                                                   S3ChunkInfoMap *out) {
+    Stripe &stripe = GetStripe(key);
+    ReadLockGuard readLockGuard(stripe.rwLock);
+    auto it = stripe.s3ChunkInfoMap.lower_bound(
+        S3ChunkInfoKey(key.fsId, key.inodeId, beginIndex));
+    auto end = stripe.s3ChunkInfoMap.lower_bound(
+        S3ChunkInfoKey(key.fsId, key.inodeId, endIndex));
+    for (; it != end; ++it) {
+        (*out)[it->first.chunkIndex] = it->second.s3chunkinfolist();
+    }
+    return MetaStatusCode::OK;
+}
+
+std::shared_ptr<Iterator> MemoryInodeStorage::NewS3ChunkInfoIterator(
+    uint32_t partitionId) {
+    std::vector<std::shared_ptr<Iterator>> children;
+    for (auto &stripe : stripes_) {
+        auto container = std::shared_ptr<S3ChunkInfoContainerType>(
+            &stripe->s3ChunkInfoMap,
+            [](S3ChunkInfoContainerType*) {});  // don't release storage
+        children.push_back(
+            std::make_shared<MapContainerIterator<S3ChunkInfoContainerType>>(
+                ENTRY_TYPE::S3_CHUNK_INFO_LIST, partitionId, container));
+    }
+    return std::make_shared<MergeIterator>(children);
+}
+
+MetaStatusCode MemoryInodeStorage::TakeChanges(InodeChanges *changes) {
+    for (auto &stripe : stripes_) {
+        WriteLockGuard writeLockGuard(stripe->rwLock);
+        for (const auto &key : stripe->changedInodes) {
+            auto it = stripe->inodeMap.find(key);
+            if (it == stripe->inodeMap.end()) {
+                changes->removedInodes.push_back(key);
+            } else {
+                changes->inodes.push_back(*(it->second));
+            }
+        }
+
+        for (const auto &key : stripe->changedS3ChunkInfoLists) {
+            auto it = stripe->s3ChunkInfoMap.find(key);
+            if (it != stripe->s3ChunkInfoMap.end()) {
+                changes->s3ChunkInfoLists.push_back(it->second);
+                continue;
+            }
+            InodeS3ChunkInfoList removed;
+            removed.set_fsid(key.fsId);
+            removed.set_inodeid(key.inodeId);
+            removed.set_chunkindex(key.chunkIndex);
+            removed.mutable_s3chunkinfolist();
+            changes->s3ChunkInfoLists.push_back(std::move(removed));
+        }
+
+        stripe->changedInodes.clear();
+        stripe->changedS3ChunkInfoLists.clear();
+    }
+    return MetaStatusCode::OK;
+}
+
+void MemoryInodeStorage::ClearChanges() {
+    for (auto &stripe : stripes_) {
+        WriteLockGuard writeLockGuard(stripe->rwLock);
+        stripe->changedInodes.clear();
+        stripe->changedS3ChunkInfoLists.clear();
+    }
+}
+
+KVInodeStorage::KVInodeStorage(std::shared_ptr<KVStore> store,
+                               std::shared_ptr<KVStore> chunkStore,
+                               uint64_t cacheCapacity,
+                               bool trackChanges)
+    : store_(store),
+      chunkStore_(chunkStore),
+      cache_(cacheCapacity),
+      count_(0),
+      chunkCount_(0),
+      trackChanges_(trackChanges) {}
+
+std::string KVInodeStorage::EncodeKey(const InodeKey &key) {
+    std::string ikey;
+    EncodeUint32(key.fsId, &ikey);
+    EncodeUint64(key.inodeId, &ikey);
+    return ikey;
+}
+
+std::string KVInodeStorage::EncodeChunkKey(const InodeKey &key,
+                                           uint64_t chunkIndex) {
+    std::string ckey = EncodeKey(key);
+    EncodeUint64(chunkIndex, &ckey);
+    return ckey;
+}
+
+MetaStatusCode KVInodeStorage::GetLocked(const InodeKey &key,
+                                         std::shared_ptr<Inode> *inode) {
+    std::string ikey = EncodeKey(key);
+    if (cache_.Get(ikey, inode)) {
+        return MetaStatusCode::OK;
+    }
+
+    // writers hold the write lock, so the value filled is not stale
+    std::string value;
+    leveldb::Status s = store_->Get(ikey, &value);
+    if (s.IsNotFound()) {
+        return MetaStatusCode::NOT_FOUND;
+    } else if (!s.ok()) {
+        LOG(ERROR) << "Get inode from store failed, fsId = " << key.fsId
+                   << ", inodeId = " << key.inodeId
+                   << ", error = " << s.ToString();
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+
+    auto out = std::make_shared<Inode>();
+    if (!out->ParseFromString(value)) {
+        LOG(ERROR) << "Parse inode failed, fsId = " << key.fsId
+                   << ", inodeId = " << key.inodeId;
+        return MetaStatusCode::PARSE_FROM_STRING_FAILED;
+    }
+    cache_.Put(ikey, out);
+    *inode = out;
+    return MetaStatusCode::OK;
+}
+
+MetaStatusCode KVInodeStorage::Insert(const Inode &inode) {
+    WriteLockGuard writeLockGuard(rwLock_);
+    std::shared_ptr<Inode> old;
+    auto rc = GetLocked(InodeKey(inode), &old);
+    if (rc == MetaStatusCode::OK) {
+        return MetaStatusCode::INODE_EXIST;
+    } else if (rc != MetaStatusCode::NOT_FOUND) {
+        return rc;
+    }
+
+    auto newInode = StripS3ChunkInfo(inode);
+    std::string value;
+    if (!newInode->SerializeToString(&value)) {
+        return MetaStatusCode::SERIALIZE_TO_STRING_FAILED;
+    }
+    std::string ikey = EncodeKey(InodeKey(inode));
+    leveldb::Status s = store_->Put(ikey, value);
+    if (!s.ok()) {
+        LOG(ERROR) << "Put inode to store failed, inode = "
+                   << newInode->ShortDebugString()
+                   << ", error = " << s.ToString();
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+    count_++;
+    cache_.Put(ikey, newInode);
+    if (trackChanges_) {
+        changedInodes_.insert(InodeKey(inode));
+    }
+
+    for (const auto &item : inode.s3chunkinfomap()) {
+        rc = UpdateS3ChunkInfoListLocked(InodeKey(inode), item.first,
+                                         item.second);
+        if (rc != MetaStatusCode::OK) {
+            return rc;
+        }
+    }
+    return MetaStatusCode::OK;
+}
+
+MetaStatusCode KVInodeStorage::Get(const InodeKey &key,
+                                   std::shared_ptr<Inode> *inode) {
     ReadLockGuard readLockGuard(rwLock_);
-    return inodeMap_.size();
+    return GetLocked(key, inode);
 }
 
-InodeStorage::ContainerType* MemoryInodeStorage::GetContainer() {
-    return &inodeMap_;
+MetaStatusCode KVInodeStorage::GetCopy(const InodeKey &key, Inode *inode) {
+    ReadLockGuard readLockGuard(rwLock_);
+    std::shared_ptr<Inode> out;
+    auto rc = GetLocked(key, &out);
+    if (rc == MetaStatusCode::OK) {
+        *inode = *out;
+    }
+    return rc;
 }
 
-void MemoryInodeStorage::GetInodeIdList(std::list<uint64_t>* inodeIdList) {
+MetaStatusCode KVInodeStorage::GetAttr(const InodeKey &key,
+                                       InodeAttr *attr) {
+    ReadLockGuard readLockGuard(rwLock_);
+    std::shared_ptr<Inode> out;
+    auto rc = GetLocked(key, &out);
+    if (rc == MetaStatusCode::OK) {
+        curvefs::common::InodeToAttr(*out, attr);
+    }
+    return rc;
+}
+
+MetaStatusCode KVInodeStorage::Delete(const InodeKey &key) {
+    WriteLockGuard writeLockGuard(rwLock_);
+    std::shared_ptr<Inode> old;
+    auto rc = GetLocked(key, &old);
+    if (rc != MetaStatusCode::OK) {
+        return rc;
+    }
+
+    std::string ikey = EncodeKey(key);
+    leveldb::Status s = store_->Delete(ikey);
+    if (!s.ok()) {
+        LOG(ERROR) << "Delete inode from store failed, fsId = " << key.fsId
+                   << ", inodeId = " << key.inodeId
+                   << ", error = " << s.ToString();
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+    count_--;
+    cache_.Remove(ikey);
+    if (trackChanges_) {
+        changedInodes_.insert(key);
+    }
+    return DeleteS3ChunkInfoLocked(key);
+}
+
+MetaStatusCode KVInodeStorage::Update(const Inode &inode) {
+    WriteLockGuard writeLockGuard(rwLock_);
+    std::shared_ptr<Inode> old;
+    auto rc = GetLocked(InodeKey(inode), &old);
+    if (rc != MetaStatusCode::OK) {
+        return rc;
+    }
+
+    // the inode may be the one got by Get() and modified in place
+    if (old.get() != &inode) {
+        *old = inode;
+    }
+    old->clear_s3chunkinfomap();
+
+    std::string value;
+    if (!old->SerializeToString(&value)) {
+        return MetaStatusCode::SERIALIZE_TO_STRING_FAILED;
+    }
+    leveldb::Status s = store_->Put(EncodeKey(InodeKey(inode)), value);
+    if (!s.ok()) {
+        LOG(ERROR) << "Put inode to store failed, inode = "
+                   << old->ShortDebugString()
+                   << ", error = " << s.ToString();
+        // the cached inode is not the one in store now
+        cache_.Remove(EncodeKey(InodeKey(inode)));
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+    if (trackChanges_) {
+        changedInodes_.insert(InodeKey(inode));
+    }
+    return MetaStatusCode::OK;
+}
+
+int KVInodeStorage::Count() {
+    return count_.load();
+}
+
+void KVInodeStorage::GetInodeIdList(std::list<uint64_t>* inodeIdList) {
+    auto iter = store_->NewIterator();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        inodeIdList->push_back(DecodeUint64(iter->key().data() + 4));
+    }
+}
+
+std::shared_ptr<Iterator> KVInodeStorage::NewIterator(uint32_t partitionId) {
+    // the snapshot and the count must be taken at the same time
+    ReadLockGuard readLockGuard(rwLock_);
+    return std::make_shared<KVStoreIterator>(
+        store_, type2str(ENTRY_TYPE::INODE) + ":" + std::to_string(partitionId),
+        count_.load());
+}
+
+MetaStatusCode KVInodeStorage::GetS3ChunkInfoList(const InodeKey &key,
+                                                  uint64_t chunkIndex,
+                                                  S3ChunkInfoList *list) {
+    ReadLockGuard readLockGuard(rwLock_);
+    std::string value;
+    leveldb::Status s = chunkStore_->Get(EncodeChunkKey(key, chunkIndex),
+                                         &value);
+    if (s.IsNotFound()) {
+        return MetaStatusCode::NOT_FOUND;
+    } else if (!s.ok()) {
+        LOG(ERROR) << "Get s3 chunk info list from store failed, fsId = "
+                   << key.fsId << ", inodeId = " << key.inodeId
+                   << ", chunkIndex = " << chunkIndex
+                   << ", error = " << s.ToString();
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+
+    InodeS3ChunkInfoList out;
+    if (!out.ParseFromString(value)) {
+        return MetaStatusCode::PARSE_FROM_STRING_FAILED;
+    }
+    list->Swap(out.mutable_s3chunkinfolist());
+    return MetaStatusCode::OK;
+}
+
+MetaStatusCode KVInodeStorage::UpdateS3ChunkInfoListLocked(
+    const InodeKey &key, uint64_t chunkIndex, const S3ChunkInfoList &list) {
+    std::string ckey = EncodeChunkKey(key, chunkIndex);
+    std::string value;
+    leveldb::Status s = chunkStore_->Get(ckey, &value);
+    if (!s.ok() && !s.IsNotFound()) {
+        LOG(ERROR) << "Get s3 chunk info list from store failed, fsId = "
+                   << key.fsId << ", inodeId = " << key.inodeId
+                   << ", chunkIndex = " << chunkIndex
+                   << ", error = " << s.ToString();
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+    bool exist = s.ok();
+
+    if (list.s3chunks_size() == 0) {
+        if (!exist) {
+            return MetaStatusCode::OK;
+        }
+        s = chunkStore_->Delete(ckey);
+    } else {
+        InodeS3ChunkInfoList newList;
+        newList.set_fsid(key.fsId);
+        newList.set_inodeid(key.inodeId);
+        newList.set_chunkindex(chunkIndex);
+        *newList.mutable_s3chunkinfolist() = list;
+        if (!newList.SerializeToString(&value)) {
+            return MetaStatusCode::SERIALIZE_TO_STRING_FAILED;
+        }
+        s = chunkStore_->Put(ckey, value);
+    }
+    if (!s.ok()) {
+        LOG(ERROR) << "Update s3 chunk info list failed, fsId = " << key.fsId
+                   << ", inodeId = " << key.inodeId
+                   << ", chunkIndex = " << chunkIndex
+                   << ", error = " << s.ToString();
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+
+    if (list.s3chunks_size() == 0) {
+        chunkCount_--;
+    } else if (!exist) {
+        chunkCount_++;
+    }
+    if (trackChanges_) {
+        changedS3ChunkInfoLists_.emplace(key.fsId, key.inodeId, chunkIndex);
+    }
+    return MetaStatusCode::OK;
+}
+
+MetaStatusCode KVInodeStorage::UpdateS3ChunkInfoList(
+    const InodeKey &key, uint64_t chunkIndex, const S3ChunkInfoList &list) {
+    WriteLockGuard writeLockGuard(rwLock_);
+    return UpdateS3ChunkInfoListLocked(key, chunkIndex, list);
+}
+
+MetaStatusCode KVInodeStorage::DeleteS3ChunkInfoLocked(const InodeKey &key) {
+    std::string prefix = EncodeKey(key);
+    leveldb::WriteBatch batch;
+    uint64_t count = 0;
+    auto iter = chunkStore_->NewIterator();
+    for (iter->Seek(prefix);
+         iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
+        batch.Delete(iter->key());
+        count++;
+        if (trackChanges_) {
+            changedS3ChunkInfoLists_.emplace(
+                key.fsId, key.inodeId,
+                DecodeUint64(iter->key().data() + prefix.size()));
+        }
+    }
+    if (count == 0) {
+        return MetaStatusCode::OK;
+    }
+
+    leveldb::Status s = chunkStore_->Write(&batch);
+    if (!s.ok()) {
+        LOG(ERROR) << "Delete s3 chunk info lists failed, fsId = " << key.fsId
+                   << ", inodeId = " << key.inodeId
+                   << ", error = " << s.ToString();
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+    chunkCount_ -= count;
+    return MetaStatusCode::OK;
+}
+
+MetaStatusCode KVInodeStorage::ListS3ChunkInfo(const InodeKey &key,
+                                               uint64_t beginIndex,
+                                               uint64_t endIndex,
+                                               S3ChunkInfoMap *out) {
     ReadLockGuard readLockGuard(rwLock_);
-    for (auto it = inodeMap_.begin(); it != inodeMap_.end(); ++it) {
-        inodeIdList->push_back(it->second->inodeid());
+    std::string begin = EncodeChunkKey(key, beginIndex);
+    std::string end = EncodeChunkKey(key, endIndex);
+    auto iter = chunkStore_->NewIterator();
+    for (iter->Seek(begin);
+         iter->Valid() && iter->key().compare(end) < 0; iter->Next()) {
+        InodeS3ChunkInfoList list;
+        if (!list.ParseFromArray(iter->value().data(),
+                                 iter->value().size())) {
+            LOG(ERROR) << "Parse s3 chunk info list failed, fsId = "
+                       << key.fsId << ", inodeId = " << key.inodeId;
+            return MetaStatusCode::PARSE_FROM_STRING_FAILED;
+        }
+        (*out)[list.chunkindex()].Swap(list.mutable_s3chunkinfolist());
+    }
+    if (!iter->status().ok()) {
+        LOG(ERROR) << "List s3 chunk info failed, fsId = " << key.fsId
+                   << ", inodeId = " << key.inodeId
+                   << ", error = " << iter->status().ToString();
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
     }
+    return MetaStatusCode::OK;
+}
+
+std::shared_ptr<Iterator> KVInodeStorage::NewS3ChunkInfoIterator(
+    uint32_t partitionId) {
+    ReadLockGuard readLockGuard(rwLock_);
+    return std::make_shared<KVStoreIterator>(
+        chunkStore_,
+        type2str(ENTRY_TYPE::S3_CHUNK_INFO_LIST) + ":" +
+            std::to_string(partitionId),
+        chunkCount_.load());
+}
+
+MetaStatusCode KVInodeStorage::TakeChanges(InodeChanges *changes) {
+    WriteLockGuard writeLockGuard(rwLock_);
+    auto defer = absl::MakeCleanup([this]() {
+        changedInodes_.clear();
+        changedS3ChunkInfoLists_.clear();
+    });
+
+    for (const auto &key : changedInodes_) {
+        std::shared_ptr<Inode> inode;
+        auto rc = GetLocked(key, &inode);
+        if (rc == MetaStatusCode::NOT_FOUND) {
+            changes->removedInodes.push_back(key);
+        } else if (rc == MetaStatusCode::OK) {
+            changes->inodes.push_back(*inode);
+        } else {
+            return rc;
+        }
+    }
+
+    for (const auto &key : changedS3ChunkInfoLists_) {
+        std::string value;
+        leveldb::Status s = chunkStore_->Get(
+            EncodeChunkKey(InodeKey(key.fsId, key.inodeId), key.chunkIndex),
+            &value);
+        InodeS3ChunkInfoList list;
+        if (s.IsNotFound()) {
+            list.set_fsid(key.fsId);
+            list.set_inodeid(key.inodeId);
+            list.set_chunkindex(key.chunkIndex);
+            list.mutable_s3chunkinfolist();
+        } else if (!s.ok()) {
+            LOG(ERROR) << "Get s3 chunk info list from store failed, fsId = "
+                       << key.fsId << ", inodeId = " << key.inodeId
+                       << ", chunkIndex = " << key.chunkIndex
+                       << ", error = " << s.ToString();
+            return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+        } else if (!list.ParseFromString(value)) {
+            return MetaStatusCode::PARSE_FROM_STRING_FAILED;
+        }
+        changes->s3ChunkInfoLists.push_back(std::move(list));
+    }
+    return MetaStatusCode::OK;
+}
+
+void KVInodeStorage::ClearChanges() {
+    WriteLockGuard writeLockGuard(rwLock_);
+    changedInodes_.clear();
+    changedS3ChunkInfoLists_.clear();
 }
 
 }  // namespace metaserver
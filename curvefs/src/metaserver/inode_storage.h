@@ -23,13 +23,23 @@
 #ifndef CURVEFS_SRC_METASERVER_INODE_STORAGE_H_
 #define CURVEFS_SRC_METASERVER_INODE_STORAGE_H_
 
+#include <atomic>
 #include <functional>
+#include <map>
+#include <set>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <list>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "curvefs/proto/metaserver.pb.h"
+#include "curvefs/src/metaserver/iterator.h"
+#include "curvefs/src/metaserver/kv_storage.h"
 #include "src/common/concurrent/rw_lock.h"
+#include "src/common/lru_cache.h"
 
 using curve::common::ReadLockGuard;
 using curve::common::WriteLockGuard;
@@ -61,27 +71,94 @@ struct hashInode {
     }
 };
 
+struct S3ChunkInfoKey {
+    uint32_t fsId;
+    uint64_t inodeId;
+    uint64_t chunkIndex;
+
+    S3ChunkInfoKey(uint32_t fs, uint64_t inode, uint64_t index)
+        : fsId(fs), inodeId(inode), chunkIndex(index) {}
+
+    bool operator<(const S3ChunkInfoKey &k1) const {
+        if (fsId != k1.fsId) {
+            return fsId < k1.fsId;
+        }
+        if (inodeId != k1.inodeId) {
+            return inodeId < k1.inodeId;
+        }
+        return chunkIndex < k1.chunkIndex;
+    }
+};
+
+using S3ChunkInfoMap = google::protobuf::Map<uint64_t, S3ChunkInfoList>;
+
+// entries changed since the changes were taken last time, the current
+// values of the changed entries are kept, see InodeStorage::TakeChanges()
+struct InodeChanges {
+    // inserted or updated inodes
+    std::vector<Inode> inodes;
+    std::vector<InodeKey> removedInodes;
+    // a removed s3 chunk info list is an empty one
+    std::vector<InodeS3ChunkInfoList> s3ChunkInfoLists;
+};
+
 class InodeStorage {
  public:
     using ContainerType = std::unordered_map<
         InodeKey, std::shared_ptr<Inode>, hashInode>;
+    using S3ChunkInfoContainerType =
+        std::map<S3ChunkInfoKey, InodeS3ChunkInfoList>;
 
  public:
+    // The s3 chunk infos of an inode are kept apart from the inode, the
+    // inodes in storage never carry them. The s3 chunk infos in the inode
+    // passed to Insert() are moved to the s3 chunk info lists, and they
+    // are ignored by Update(). Delete() removes them with the inode.
     virtual MetaStatusCode Insert(const Inode &inode) = 0;
     virtual MetaStatusCode Get(
         const InodeKey &key, std::shared_ptr<Inode> *inode) = 0;
     virtual MetaStatusCode GetCopy(
         const InodeKey &key, Inode *inode) = 0;
+    virtual MetaStatusCode GetAttr(
+        const InodeKey &key, InodeAttr *attr) = 0;
     virtual MetaStatusCode Delete(const InodeKey &key) = 0;
     virtual MetaStatusCode Update(const Inode &inode) = 0;
     virtual int Count() = 0;
-    virtual ContainerType* GetContainer() = 0;
     virtual void GetInodeIdList(std::list<uint64_t>* InodeIdList) = 0;
+    // iterate all inodes of the partition for dumping
+    virtual std::shared_ptr<Iterator> NewIterator(uint32_t partitionId) = 0;
+
+    // s3 chunk info
+    virtual MetaStatusCode GetS3ChunkInfoList(
+        const InodeKey &key, uint64_t chunkIndex, S3ChunkInfoList *list) = 0;
+    // an empty |list| removes the s3 chunk info list of the chunk
+    virtual MetaStatusCode UpdateS3ChunkInfoList(
+        const InodeKey &key, uint64_t chunkIndex,
+        const S3ChunkInfoList &list) = 0;
+    // add the s3 chunk info lists of chunks in [beginIndex, endIndex) to |out|
+    virtual MetaStatusCode ListS3ChunkInfo(
+        const InodeKey &key, uint64_t beginIndex, uint64_t endIndex,
+        S3ChunkInfoMap *out) = 0;
+    // iterate all s3 chunk info lists of the partition for dumping
+    virtual std::shared_ptr<Iterator> NewS3ChunkInfoIterator(
+        uint32_t partitionId) = 0;
+
+    // changes are only tracked if the storage is created with
+    // |trackChanges|, they are saved in the delta of incremental snapshot
+    virtual MetaStatusCode TakeChanges(InodeChanges *changes) = 0;
+    // forget the changes tracked, e.g. after a full snapshot is taken
+    virtual void ClearChanges() = 0;
+
     virtual ~InodeStorage() = default;
 };
 
+// Inodes are striped by inode id, each stripe has its own lock, so the
+// operators on different inodes of a partition don't contend for one lock.
 class MemoryInodeStorage : public InodeStorage {
  public:
+    explicit MemoryInodeStorage(bool trackChanges = false,
+                                uint32_t stripes = 1);
+
     /**
      * @brief insert inode to storage
      *
@@ -112,6 +189,17 @@ class MemoryInodeStorage : public InodeStorage {
      */
     MetaStatusCode GetCopy(const InodeKey &key, Inode *inode) override;
 
+    /**
+     * @brief get inode attributes from storage, without copying
+     *        the volume extents or s3 chunk infos
+     *
+     * @param[in] key: the key of inode want to get
+     * @param[out] attr: the inode attributes got
+     *
+     * @return If inode not exist, return NOT_FOUND; else return OK
+     */
+    MetaStatusCode GetAttr(const InodeKey &key, InodeAttr *attr) override;
+
     /**
      * @brief delete inode from storage
      *
@@ -132,19 +220,146 @@ class MemoryInodeStorage : public InodeStorage {
 
     int Count() override;
 
+    void GetInodeIdList(std::list<uint64_t>* inodeIdList) override;
+
+    std::shared_ptr<Iterator> NewIterator(uint32_t partitionId) override;
+
     /**
-     * @brief get Inode container
+     * @brief get s3 chunk info list of a chunk
      *
-     * @return Inode container, here returns inodeMap_ pointer
+     * @return If the chunk has no s3 chunk info, return NOT_FOUND;
+     *         else return OK
      */
-    ContainerType* GetContainer() override;
+    MetaStatusCode GetS3ChunkInfoList(const InodeKey &key,
+                                      uint64_t chunkIndex,
+                                      S3ChunkInfoList *list) override;
+
+    MetaStatusCode UpdateS3ChunkInfoList(
+        const InodeKey &key, uint64_t chunkIndex,
+        const S3ChunkInfoList &list) override;
+
+    MetaStatusCode ListS3ChunkInfo(const InodeKey &key, uint64_t beginIndex,
+                                   uint64_t endIndex,
+                                   S3ChunkInfoMap *out) override;
+
+    std::shared_ptr<Iterator> NewS3ChunkInfoIterator(
+        uint32_t partitionId) override;
+
+    MetaStatusCode TakeChanges(InodeChanges *changes) override;
+
+    void ClearChanges() override;
+
+ private:
+    struct Stripe {
+        RWLock rwLock;
+        // use fsid + inodeid as key
+        ContainerType inodeMap;
+        // use fsid + inodeid + chunk index as key
+        S3ChunkInfoContainerType s3ChunkInfoMap;
+
+        std::unordered_set<InodeKey, hashInode> changedInodes;
+        std::set<S3ChunkInfoKey> changedS3ChunkInfoLists;
+    };
+
+    Stripe &GetStripe(const InodeKey &key) {
+        return *stripes_[key.inodeId % stripes_.size()];
+    }
+
+    // caller must hold the write lock of |stripe|
+    void UpdateS3ChunkInfoListLocked(Stripe *stripe, const InodeKey &key,
+                                     uint64_t chunkIndex,
+                                     const S3ChunkInfoList &list);
+
+ private:
+    std::vector<std::unique_ptr<Stripe>> stripes_;
+
+    bool trackChanges_;
+};
+
+// Inodes are kept in a leveldb store, and the recently used ones are
+// cached in memory, so the memory usage depends on the working set
+// instead of the number of inodes.
+class KVInodeStorage : public InodeStorage {
+ public:
+    // s3 chunk info lists are kept in |chunkStore|, they are not cached
+    KVInodeStorage(std::shared_ptr<KVStore> store,
+                   std::shared_ptr<KVStore> chunkStore,
+                   uint64_t cacheCapacity,
+                   bool trackChanges = false);
+
+    MetaStatusCode Insert(const Inode &inode) override;
+
+    /**
+     * @brief get inode from storage, the inode returned is cached, modify
+     *        it and call Update() to persist the modification
+     */
+    MetaStatusCode Get(
+        const InodeKey &key, std::shared_ptr<Inode> *inode) override;
+
+    MetaStatusCode GetCopy(const InodeKey &key, Inode *inode) override;
+
+    MetaStatusCode GetAttr(const InodeKey &key, InodeAttr *attr) override;
+
+    MetaStatusCode Delete(const InodeKey &key) override;
+
+    MetaStatusCode Update(const Inode &inode) override;
+
+    int Count() override;
 
     void GetInodeIdList(std::list<uint64_t>* inodeIdList) override;
 
+    std::shared_ptr<Iterator> NewIterator(uint32_t partitionId) override;
+
+    MetaStatusCode GetS3ChunkInfoList(const InodeKey &key,
+                                      uint64_t chunkIndex,
+                                      S3ChunkInfoList *list) override;
+
+    MetaStatusCode UpdateS3ChunkInfoList(
+        const InodeKey &key, uint64_t chunkIndex,
+        const S3ChunkInfoList &list) override;
+
+    MetaStatusCode ListS3ChunkInfo(const InodeKey &key, uint64_t beginIndex,
+                                   uint64_t endIndex,
+                                   S3ChunkInfoMap *out) override;
+
+    std::shared_ptr<Iterator> NewS3ChunkInfoIterator(
+        uint32_t partitionId) override;
+
+    MetaStatusCode TakeChanges(InodeChanges *changes) override;
+
+    void ClearChanges() override;
+
+ private:
+    static std::string EncodeKey(const InodeKey &key);
+
+    static std::string EncodeChunkKey(const InodeKey &key,
+                                      uint64_t chunkIndex);
+
+    // get inode from cache or store, caller must hold the lock
+    MetaStatusCode GetLocked(const InodeKey &key,
+                             std::shared_ptr<Inode> *inode);
+
+    // caller must hold the write lock
+    MetaStatusCode UpdateS3ChunkInfoListLocked(const InodeKey &key,
+                                               uint64_t chunkIndex,
+                                               const S3ChunkInfoList &list);
+
+    // caller must hold the write lock
+    MetaStatusCode DeleteS3ChunkInfoLocked(const InodeKey &key);
+
  private:
     RWLock rwLock_;
-    // use fsid + inodeid as key
-    ContainerType inodeMap_;
+    std::shared_ptr<KVStore> store_;
+    std::shared_ptr<KVStore> chunkStore_;
+    // key is the encoded key of inode
+    curve::common::LRUCache<std::string, std::shared_ptr<Inode>> cache_;
+    std::atomic<int> count_;
+    // number of s3 chunk info lists in |chunkStore_|
+    std::atomic<uint64_t> chunkCount_;
+
+    bool trackChanges_;
+    std::unordered_set<InodeKey, hashInode> changedInodes_;
+    std::set<S3ChunkInfoKey> changedS3ChunkInfoLists_;
 };
 
 }  // namespace metaserver
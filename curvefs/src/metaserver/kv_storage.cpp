@@ -0,0 +1,199 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2022-03-02
+ */
+
+#include "curvefs/src/metaserver/kv_storage.h"
+
+#include <glog/logging.h>
+
+#include "src/fs/local_filesystem.h"
+
+namespace curvefs {
+namespace metaserver {
+
+using ::curve::fs::FileSystemType;
+using ::curve::fs::LocalFsFactory;
+
+void KVStorageOption::InitKVStorageOptionFromConf(
+    std::shared_ptr<Configuration> conf) {
+    conf->GetValueFatalIfFail("storage.type", &type);
+    conf->GetValueFatalIfFail("storage.dataDir", &dataDir);
+    conf->GetValueFatalIfFail("storage.blockCacheBytes", &blockCacheBytes);
+    conf->GetValueFatalIfFail("storage.writeBufferBytes", &writeBufferBytes);
+    conf->GetValueFatalIfFail("storage.maxOpenFiles", &maxOpenFiles);
+    conf->GetValueFatalIfFail("storage.inodeCacheCapacity",
+                              &inodeCacheCapacity);
+    conf->GetValueFatalIfFail("storage.incrementalSnapshot",
+                              &incrementalSnapshot);
+    conf->GetValueFatalIfFail("storage.snapshotMaxDeltas",
+                              &snapshotMaxDeltas);
+    conf->GetValueFatalIfFail("storage.snapshotMaxDeltaPercent",
+                              &snapshotMaxDeltaPercent);
+    conf->GetValueFatalIfFail("storage.snapshotLoadConcurrency",
+                              &snapshotLoadConcurrency);
+    conf->GetValueFatalIfFail("storage.lockStripes", &lockStripes);
+}
+
+KVStore::KVStore(leveldb::DB *db, const std::string &path)
+    : db_(db), path_(path) {}
+
+KVStore::~KVStore() {
+    db_.reset();
+    leveldb::Status s = leveldb::DestroyDB(path_, leveldb::Options());
+    LOG_IF(WARNING, !s.ok()) << "Destroy store failed, path = " << path_
+                             << ", error = " << s.ToString();
+    auto fs = LocalFsFactory::CreateFs(FileSystemType::EXT4, "");
+    if (fs->DirExists(path_)) {
+        fs->Delete(path_);
+    }
+}
+
+leveldb::Status KVStore::Get(const std::string &key, std::string *value) {
+    return db_->Get(leveldb::ReadOptions(), key, value);
+}
+
+leveldb::Status KVStore::Put(const std::string &key,
+                             const std::string &value) {
+    return db_->Put(leveldb::WriteOptions(), key, value);
+}
+
+leveldb::Status KVStore::Delete(const std::string &key) {
+    return db_->Delete(leveldb::WriteOptions(), key);
+}
+
+leveldb::Status KVStore::Write(leveldb::WriteBatch *batch) {
+    return db_->Write(leveldb::WriteOptions(), batch);
+}
+
+std::unique_ptr<leveldb::Iterator> KVStore::NewIterator(
+    const leveldb::Snapshot *snapshot) {
+    leveldb::ReadOptions options;
+    options.snapshot = snapshot;
+    // a full scan should not pollute the block cache
+    options.fill_cache = (snapshot == nullptr);
+    return std::unique_ptr<leveldb::Iterator>(db_->NewIterator(options));
+}
+
+const leveldb::Snapshot *KVStore::GetSnapshot() {
+    return db_->GetSnapshot();
+}
+
+void KVStore::ReleaseSnapshot(const leveldb::Snapshot *snapshot) {
+    db_->ReleaseSnapshot(snapshot);
+}
+
+KVStoreIterator::KVStoreIterator(std::shared_ptr<KVStore> store,
+                                 const std::string &key, uint64_t size)
+    : store_(store),
+      snapshot_(store->GetSnapshot()),
+      iter_(store->NewIterator(snapshot_)),
+      key_(key),
+      size_(size) {}
+
+KVStoreIterator::~KVStoreIterator() {
+    iter_.reset();
+    store_->ReleaseSnapshot(snapshot_);
+}
+
+uint64_t KVStoreIterator::Size() {
+    return size_;
+}
+
+bool KVStoreIterator::Valid() {
+    return iter_->Valid();
+}
+
+void KVStoreIterator::SeekToFirst() {
+    iter_->SeekToFirst();
+}
+
+void KVStoreIterator::Next() {
+    iter_->Next();
+}
+
+std::string KVStoreIterator::Key() {
+    return key_;
+}
+
+std::string KVStoreIterator::Value() {
+    return iter_->value().ToString();
+}
+
+int KVStoreIterator::Status() {
+    return iter_->status().ok() ? 0 : 1;
+}
+
+int KVStorageManager::Init(const KVStorageOption &option) {
+    option_ = option;
+    if (option.type == "memory") {
+        enabled_ = false;
+        LOG(INFO) << "Keep inodes and dentrys in memory";
+        return 0;
+    } else if (option.type != "leveldb") {
+        LOG(ERROR) << "Unknown storage type: " << option.type;
+        return -1;
+    }
+
+    // partitions are rebuilt from raft, the stores of the last run
+    // are useless
+    auto fs = LocalFsFactory::CreateFs(FileSystemType::EXT4, "");
+    if (fs->DirExists(option.dataDir) && fs->Delete(option.dataDir) != 0) {
+        LOG(ERROR) << "Remove storage dir failed, dir = " << option.dataDir;
+        return -1;
+    }
+    if (fs->Mkdir(option.dataDir) != 0) {
+        LOG(ERROR) << "Create storage dir failed, dir = " << option.dataDir;
+        return -1;
+    }
+
+    blockCache_.reset(leveldb::NewLRUCache(option.blockCacheBytes));
+    enabled_ = true;
+    LOG(INFO) << "Keep inodes and dentrys in leveldb, dir = "
+              << option.dataDir;
+    return 0;
+}
+
+std::shared_ptr<KVStore> KVStorageManager::NewStore(const std::string &name) {
+    std::string path =
+        option_.dataDir + "/" + name + "_" + std::to_string(seq_++);
+
+    leveldb::Options options;
+    options.create_if_missing = true;
+    options.error_if_exists = true;
+    options.block_cache = blockCache_.get();
+    if (option_.writeBufferBytes != 0) {
+        options.write_buffer_size = option_.writeBufferBytes;
+    }
+    if (option_.maxOpenFiles != 0) {
+        options.max_open_files = option_.maxOpenFiles;
+    }
+
+    leveldb::DB *db = nullptr;
+    leveldb::Status s = leveldb::DB::Open(options, path, &db);
+    if (!s.ok()) {
+        LOG(ERROR) << "Open store failed, path = " << path
+                   << ", error = " << s.ToString();
+        return nullptr;
+    }
+    return std::make_shared<KVStore>(db, path);
+}
+
+}  // namespace metaserver
+}  // namespace curvefs
@@ -0,0 +1,213 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2022-03-02
+ */
+
+#ifndef CURVEFS_SRC_METASERVER_KV_STORAGE_H_
+#define CURVEFS_SRC_METASERVER_KV_STORAGE_H_
+
+#include <leveldb/cache.h>
+#include <leveldb/db.h>
+#include <leveldb/write_batch.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "curvefs/src/metaserver/iterator.h"
+#include "src/common/configuration.h"
+
+namespace curvefs {
+namespace metaserver {
+
+using ::curve::common::Configuration;
+
+struct KVStorageOption {
+    // "memory": inodes and dentrys are all kept in memory
+    // "leveldb": inodes and dentrys are kept in leveldb under |dataDir|,
+    //            only the recently used inodes are cached in memory
+    std::string type;
+    std::string dataDir;
+    uint64_t blockCacheBytes;
+    uint64_t writeBufferBytes;
+    uint32_t maxOpenFiles;
+    // max number of inodes cached in memory for each partition
+    uint64_t inodeCacheCapacity;
+    // save the entries changed since the last raft snapshot as a delta
+    // of the last one, instead of saving all entries every time
+    bool incrementalSnapshot;
+    // save all entries as a new base if there are |snapshotMaxDeltas|
+    // deltas already, or the entries of deltas are more than
+    // |snapshotMaxDeltaPercent| percent of the entries of base
+    uint32_t snapshotMaxDeltas;
+    uint32_t snapshotMaxDeltaPercent;
+    // number of threads to load the partitions of raft snapshot
+    uint32_t snapshotLoadConcurrency;
+    // number of lock stripes of the inodes and dentrys of each partition
+    // kept in memory, inodes are striped by inode id and dentrys by parent
+    // inode id, so the operators on different inodes can be applied
+    // concurrently
+    uint32_t lockStripes;
+
+    KVStorageOption()
+      : type("memory"),
+        blockCacheBytes(0),
+        writeBufferBytes(0),
+        maxOpenFiles(0),
+        inodeCacheCapacity(0),
+        incrementalSnapshot(false),
+        snapshotMaxDeltas(0),
+        snapshotMaxDeltaPercent(0),
+        snapshotLoadConcurrency(1),
+        lockStripes(1) {}
+
+    void InitKVStorageOptionFromConf(std::shared_ptr<Configuration> conf);
+};
+
+// big endian encoding keeps the order of integers in the order of keys
+inline void EncodeUint32(uint32_t value, std::string *dst) {
+    for (int i = 3; i >= 0; i--) {
+        dst->push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+    }
+}
+
+inline void EncodeUint64(uint64_t value, std::string *dst) {
+    for (int i = 7; i >= 0; i--) {
+        dst->push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+    }
+}
+
+inline uint64_t DecodeUint64(const char *src) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value = (value << 8) | static_cast<uint8_t>(src[i]);
+    }
+    return value;
+}
+
+// A leveldb instance owned by one storage of a partition.
+// The data of a store is not trusted after restart, the partition is
+// rebuilt from the raft snapshot and log, so the store is destroyed
+// when it is released.
+class KVStore {
+ public:
+    KVStore(leveldb::DB *db, const std::string &path);
+
+    ~KVStore();
+
+    leveldb::Status Get(const std::string &key, std::string *value);
+
+    leveldb::Status Put(const std::string &key, const std::string &value);
+
+    leveldb::Status Delete(const std::string &key);
+
+    leveldb::Status Write(leveldb::WriteBatch *batch);
+
+    // iterate the store, or the snapshot if it's not nullptr
+    std::unique_ptr<leveldb::Iterator> NewIterator(
+        const leveldb::Snapshot *snapshot = nullptr);
+
+    const leveldb::Snapshot *GetSnapshot();
+
+    void ReleaseSnapshot(const leveldb::Snapshot *snapshot);
+
+    const std::string &GetPath() const { return path_; }
+
+ private:
+    std::unique_ptr<leveldb::DB> db_;
+    std::string path_;
+};
+
+// Iterate a snapshot of the store for dumping the partition, the value is
+// the serialized entry which is loaded by LoadFromFile().
+class KVStoreIterator : public Iterator {
+ public:
+    // |key| is the key of every entry in the dump file,
+    // |size| is the number of entries in the snapshot
+    KVStoreIterator(std::shared_ptr<KVStore> store, const std::string &key,
+                    uint64_t size);
+
+    ~KVStoreIterator() override;
+
+    uint64_t Size() override;
+
+    bool Valid() override;
+
+    void SeekToFirst() override;
+
+    void Next() override;
+
+    std::string Key() override;
+
+    std::string Value() override;
+
+    int Status() override;
+
+ private:
+    std::shared_ptr<KVStore> store_;
+    const leveldb::Snapshot *snapshot_;
+    std::unique_ptr<leveldb::Iterator> iter_;
+    std::string key_;
+    uint64_t size_;
+};
+
+class KVStorageManager {
+ public:
+    static KVStorageManager &GetInstance() {
+        static KVStorageManager instance_;
+        return instance_;
+    }
+
+    /**
+     * @brief init the manager, the stores left in |dataDir| by the
+     *        last run are removed
+     *
+     * @return 0 success, -1 fail
+     */
+    int Init(const KVStorageOption &option);
+
+    // whether the storages of partitions are kept in leveldb
+    bool Enabled() const { return enabled_; }
+
+    const KVStorageOption &GetOption() const { return option_; }
+
+    /**
+     * @brief open a new empty store
+     *
+     * @return the store, or nullptr if fail
+     */
+    std::shared_ptr<KVStore> NewStore(const std::string &name);
+
+ private:
+    KVStorageManager() : enabled_(false), seq_(0) {}
+
+ private:
+    KVStorageOption option_;
+    bool enabled_;
+    // stores of a partition reloaded from snapshot use new directories
+    std::atomic<uint64_t> seq_;
+    // block cache shared by all stores
+    std::unique_ptr<leveldb::Cache> blockCache_;
+};
+
+}  // namespace metaserver
+}  // namespace curvefs
+
+#endif  // CURVEFS_SRC_METASERVER_KV_STORAGE_H_
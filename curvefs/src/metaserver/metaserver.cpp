@@ -30,6 +30,7 @@
 
 #include "absl/memory/memory.h"
 #include "curvefs/src/metaserver/copyset/copyset_service.h"
+#include "curvefs/src/metaserver/kv_storage.h"
 #include "curvefs/src/metaserver/metaserver_service.h"
 #include "curvefs/src/metaserver/register.h"
 #include "curvefs/src/metaserver/s3compact_manager.h"
@@ -45,6 +46,7 @@ DECLARE_bool(raft_sync_meta);
 DECLARE_bool(raft_sync_segments);
 DECLARE_bool(raft_use_fsync_rather_than_fdatasync);
 DECLARE_int32(raft_max_install_snapshot_tasks_num);
+DECLARE_bool(raft_enable_leader_lease);
 
 }  // namespace braft
 
@@ -143,6 +145,13 @@ void Metaserver::Init() {
     trashOption.s3Adaptor = s3Adaptor_;
     TrashManager::GetInstance().Init(trashOption);
 
+    // partitions are created when copysets are loaded, so the kv storage
+    // must be inited before the copyset node manager
+    KVStorageOption kvStorageOption;
+    kvStorageOption.InitKVStorageOptionFromConf(conf_);
+    LOG_IF(FATAL, KVStorageManager::GetInstance().Init(kvStorageOption) != 0)
+        << "Failed to init kv storage manager";
+
     // NOTE: Do not arbitrarily adjust the order, there are dependencies
     //       between different modules
     InitLocalFileSystem();
@@ -150,6 +159,11 @@ void Metaserver::Init() {
     InitHeartbeat();
     InitInflightThrottle();
 
+    RenameCoordinatorOption renameCoordinatorOption;
+    renameCoordinatorOption.InitRenameCoordinatorOptionFromConf(conf_);
+    renameCoordinator_ = absl::make_unique<RenameCoordinator>(
+        copysetNodeManager_, renameCoordinatorOption);
+
     S3CompactManager::GetInstance().Init(conf_);
 
     PartitionCleanOption partitionCleanOption;
@@ -179,7 +193,8 @@ void Metaserver::Run() {
     // add internal server
     server_ = absl::make_unique<brpc::Server>();
     metaService_ = absl::make_unique<MetaServerServiceImpl>(
-        copysetNodeManager_, inflightThrottle_.get());
+        copysetNodeManager_, inflightThrottle_.get(),
+        renameCoordinator_.get());
     copysetService_ =
         absl::make_unique<CopysetServiceImpl>(copysetNodeManager_);
     raftCliService2_ = absl::make_unique<RaftCliService2>(copysetNodeManager_);
@@ -411,6 +426,9 @@ void Metaserver::InitBRaftFlags(const std::shared_ptr<Configuration>& conf) {
     dummy(conf, "raft_max_install_snapshot_tasks_num",
           "braft.raft_max_install_snapshot_tasks_num",
           &braft::FLAGS_raft_max_install_snapshot_tasks_num);
+    dummy(conf, "raft_enable_leader_lease",
+          "braft.raft_enable_leader_lease",
+          &braft::FLAGS_raft_enable_leader_lease);
 }
 
 }  // namespace metaserver
@@ -38,6 +38,7 @@
 #include "curvefs/src/metaserver/inflight_throttle.h"
 #include "curvefs/src/metaserver/metaserver_service.h"
 #include "curvefs/src/metaserver/partition_clean_manager.h"
+#include "curvefs/src/metaserver/rename_coordinator.h"
 #include "src/common/configuration.h"
 #include "src/fs/local_filesystem.h"
 
@@ -105,6 +106,7 @@ class Metaserver {
     RegisterOptions registerOptions_;
 
     std::unique_ptr<InflightThrottle> inflightThrottle_;
+    std::unique_ptr<RenameCoordinator> renameCoordinator_;
     std::shared_ptr<curve::fs::LocalFileSystem> localFileSystem_;
 };
 }  // namespace metaserver
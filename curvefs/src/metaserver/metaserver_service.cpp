@@ -38,15 +38,20 @@ using ::curvefs::metaserver::copyset::ListDentryOperator;
 using ::curvefs::metaserver::copyset::CreateDentryOperator;
 using ::curvefs::metaserver::copyset::DeleteDentryOperator;
 using ::curvefs::metaserver::copyset::GetInodeOperator;
+using ::curvefs::metaserver::copyset::BatchGetInodeAttrOperator;
 using ::curvefs::metaserver::copyset::CreateInodeOperator;
 using ::curvefs::metaserver::copyset::CreateRootInodeOperator;
 using ::curvefs::metaserver::copyset::UpdateInodeOperator;
+using ::curvefs::metaserver::copyset::BatchUpdateInodeOperator;
+using ::curvefs::metaserver::copyset::UpdateDirStatOperator;
 using ::curvefs::metaserver::copyset::GetOrModifyS3ChunkInfoOperator;
 using ::curvefs::metaserver::copyset::DeleteInodeOperator;
 using ::curvefs::metaserver::copyset::UpdateInodeS3VersionOperator;
 using ::curvefs::metaserver::copyset::CreatePartitionOperator;
 using ::curvefs::metaserver::copyset::DeletePartitionOperator;
 using ::curvefs::metaserver::copyset::PrepareRenameTxOperator;
+using ::curvefs::metaserver::copyset::CreateInodeAndDentryOperator;
+using ::curvefs::metaserver::copyset::UnlinkDentryAndDecNlinkOperator;
 
 namespace {
 
@@ -149,6 +154,17 @@ void MetaServerServiceImpl::GetInode(
                                         request->copysetid());
 }
 
+void MetaServerServiceImpl::BatchGetInodeAttr(
+    ::google::protobuf::RpcController* controller,
+    const ::curvefs::metaserver::BatchGetInodeAttrRequest* request,
+    ::curvefs::metaserver::BatchGetInodeAttrResponse* response,
+    ::google::protobuf::Closure* done) {
+    OperatorHelper helper(copysetNodeManager_, inflightThrottle_);
+    helper.operator()<BatchGetInodeAttrOperator>(
+        controller, request, response, done, request->poolid(),
+        request->copysetid());
+}
+
 void MetaServerServiceImpl::CreateInode(
     ::google::protobuf::RpcController* controller,
     const ::curvefs::metaserver::CreateInodeRequest* request,
@@ -182,6 +198,28 @@ void MetaServerServiceImpl::UpdateInode(
                                            request->copysetid());
 }
 
+void MetaServerServiceImpl::BatchUpdateInode(
+    ::google::protobuf::RpcController* controller,
+    const ::curvefs::metaserver::BatchUpdateInodeRequest* request,
+    ::curvefs::metaserver::BatchUpdateInodeResponse* response,
+    ::google::protobuf::Closure* done) {
+    OperatorHelper helper(copysetNodeManager_, inflightThrottle_);
+    helper.operator()<BatchUpdateInodeOperator>(
+        controller, request, response, done, request->poolid(),
+        request->copysetid());
+}
+
+void MetaServerServiceImpl::UpdateDirStat(
+    ::google::protobuf::RpcController* controller,
+    const ::curvefs::metaserver::UpdateDirStatRequest* request,
+    ::curvefs::metaserver::UpdateDirStatResponse* response,
+    ::google::protobuf::Closure* done) {
+    OperatorHelper helper(copysetNodeManager_, inflightThrottle_);
+    helper.operator()<UpdateDirStatOperator>(
+        controller, request, response, done, request->poolid(),
+        request->copysetid());
+}
+
 void MetaServerServiceImpl::GetOrModifyS3ChunkInfo(
     ::google::protobuf::RpcController* controller,
     const ::curvefs::metaserver::GetOrModifyS3ChunkInfoRequest* request,
@@ -235,5 +273,65 @@ void MetaServerServiceImpl::PrepareRenameTx(
                                                request->copysetid());
 }
 
+// the rename is queued to the coordinator on the leader of source partition,
+// which prepares and commits the transaction for the client
+void MetaServerServiceImpl::Rename(google::protobuf::RpcController* controller,
+                                   const RenameRequest* request,
+                                   RenameResponse* response,
+                                   google::protobuf::Closure* done) {
+    brpc::ClosureGuard doneGuard(done);
+    if (inflightThrottle_->IsOverLoad()) {
+        LOG_EVERY_N(WARNING, 100)
+            << "service overload, request: " << request->ShortDebugString();
+        response->set_statuscode(MetaStatusCode::OVERLOAD);
+        return;
+    }
+
+    if (renameCoordinator_ == nullptr) {
+        LOG(WARNING) << "Rename coordinator not found, request: "
+                     << request->ShortDebugString();
+        response->set_statuscode(MetaStatusCode::UNKNOWN_ERROR);
+        return;
+    }
+
+    auto* node = copysetNodeManager_->GetCopysetNode(request->poolid(),
+                                                     request->copysetid());
+    if (!node) {
+        LOG(WARNING) << "Copyset not found, request: "
+                     << request->ShortDebugString();
+        response->set_statuscode(MetaStatusCode::COPYSET_NOTEXIST);
+        return;
+    } else if (!node->IsLeaderTerm()) {
+        response->set_statuscode(MetaStatusCode::REDIRECTED);
+        return;
+    }
+
+    renameCoordinator_->Rename(
+        request, response,
+        new MetaServiceClosure(inflightThrottle_, doneGuard.release()));
+}
+
+void MetaServerServiceImpl::CreateInodeAndDentry(
+    google::protobuf::RpcController* controller,
+    const CreateInodeAndDentryRequest* request,
+    CreateInodeAndDentryResponse* response,
+    google::protobuf::Closure* done) {
+    OperatorHelper helper(copysetNodeManager_, inflightThrottle_);
+    helper.operator()<CreateInodeAndDentryOperator>(
+        controller, request, response, done, request->poolid(),
+        request->copysetid());
+}
+
+void MetaServerServiceImpl::UnlinkDentryAndDecNlink(
+    google::protobuf::RpcController* controller,
+    const UnlinkDentryAndDecNlinkRequest* request,
+    UnlinkDentryAndDecNlinkResponse* response,
+    google::protobuf::Closure* done) {
+    OperatorHelper helper(copysetNodeManager_, inflightThrottle_);
+    helper.operator()<UnlinkDentryAndDecNlinkOperator>(
+        controller, request, response, done, request->poolid(),
+        request->copysetid());
+}
+
 }  // namespace metaserver
 }  // namespace curvefs
@@ -29,6 +29,7 @@
 #include "curvefs/proto/metaserver.pb.h"
 #include "curvefs/src/metaserver/copyset/copyset_node_manager.h"
 #include "curvefs/src/metaserver/inflight_throttle.h"
+#include "curvefs/src/metaserver/rename_coordinator.h"
 
 namespace curvefs {
 namespace metaserver {
@@ -38,9 +39,11 @@ using ::curvefs::metaserver::copyset::CopysetNodeManager;
 class MetaServerServiceImpl : public MetaServerService {
  public:
     MetaServerServiceImpl(CopysetNodeManager* copysetNodeManager,
-                          InflightThrottle* inflightThrottle)
+                          InflightThrottle* inflightThrottle,
+                          RenameCoordinator* renameCoordinator = nullptr)
         : copysetNodeManager_(copysetNodeManager),
-          inflightThrottle_(inflightThrottle) {}
+          inflightThrottle_(inflightThrottle),
+          renameCoordinator_(renameCoordinator) {}
 
     void GetDentry(::google::protobuf::RpcController* controller,
                    const ::curvefs::metaserver::GetDentryRequest* request,
@@ -62,6 +65,11 @@ class MetaServerServiceImpl : public MetaServerService {
                   const ::curvefs::metaserver::GetInodeRequest* request,
                   ::curvefs::metaserver::GetInodeResponse* response,
                   ::google::protobuf::Closure* done) override;
+    void BatchGetInodeAttr(
+        ::google::protobuf::RpcController* controller,
+        const ::curvefs::metaserver::BatchGetInodeAttrRequest* request,
+        ::curvefs::metaserver::BatchGetInodeAttrResponse* response,
+        ::google::protobuf::Closure* done) override;
     void CreateInode(::google::protobuf::RpcController* controller,
                      const ::curvefs::metaserver::CreateInodeRequest* request,
                      ::curvefs::metaserver::CreateInodeResponse* response,
@@ -75,6 +83,16 @@ class MetaServerServiceImpl : public MetaServerService {
                      const ::curvefs::metaserver::UpdateInodeRequest* request,
                      ::curvefs::metaserver::UpdateInodeResponse* response,
                      ::google::protobuf::Closure* done) override;
+    void BatchUpdateInode(
+        ::google::protobuf::RpcController* controller,
+        const ::curvefs::metaserver::BatchUpdateInodeRequest* request,
+        ::curvefs::metaserver::BatchUpdateInodeResponse* response,
+        ::google::protobuf::Closure* done) override;
+    void UpdateDirStat(
+        ::google::protobuf::RpcController* controller,
+        const ::curvefs::metaserver::UpdateDirStatRequest* request,
+        ::curvefs::metaserver::UpdateDirStatResponse* response,
+        ::google::protobuf::Closure* done) override;
     void GetOrModifyS3ChunkInfo(
         ::google::protobuf::RpcController* controller,
         const ::curvefs::metaserver::GetOrModifyS3ChunkInfoRequest* request,
@@ -100,9 +118,27 @@ class MetaServerServiceImpl : public MetaServerService {
                          PrepareRenameTxResponse* response,
                          google::protobuf::Closure* done) override;
 
+    void Rename(google::protobuf::RpcController* controller,
+                const RenameRequest* request,
+                RenameResponse* response,
+                google::protobuf::Closure* done) override;
+
+    void CreateInodeAndDentry(
+        google::protobuf::RpcController* controller,
+        const CreateInodeAndDentryRequest* request,
+        CreateInodeAndDentryResponse* response,
+        google::protobuf::Closure* done) override;
+
+    void UnlinkDentryAndDecNlink(
+        google::protobuf::RpcController* controller,
+        const UnlinkDentryAndDecNlinkRequest* request,
+        UnlinkDentryAndDecNlinkResponse* response,
+        google::protobuf::Closure* done) override;
+
  private:
     CopysetNodeManager* copysetNodeManager_;
     InflightThrottle* inflightThrottle_;
+    RenameCoordinator* renameCoordinator_;
 };
 }  // namespace metaserver
 }  // namespace curvefs
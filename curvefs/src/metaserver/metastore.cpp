@@ -20,7 +20,12 @@
  * @Author: chenwei
  */
 #include "curvefs/src/metaserver/metastore.h"
+#include <dirent.h>
 #include <glog/logging.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <set>
 #include <thread>  // NOLINT
 #include <unordered_map>
 #include <unordered_set>
@@ -35,16 +40,57 @@ namespace metaserver {
 
 // NOTE: if we use set we need define hash function, it's complicate
 using PartitionContainerType = std::unordered_map<uint32_t, PartitionInfo>;
-using InodeContainerType = InodeStorage::ContainerType;
-using DentryContainerType = DentryStorage::ContainerType;
 using PendingTxContainerType = std::unordered_map<int, PrepareRenameTxRequest>;
 
 using PartitionIteratorType = MapContainerIterator<PartitionContainerType>;
-using InodeIteratorType = MapContainerIterator<InodeContainerType>;
-using DentryIteratorType = SetContainerIterator<DentryContainerType>;
 using PendingTxIteratorType = MapContainerIterator<PendingTxContainerType>;
 
-MetaStoreImpl::MetaStoreImpl(copyset::CopysetNode* node) : copysetNode_(node) {}
+// entries of delta are copied out of storages
+using RemovedEntriesIteratorType =
+    SetContainerIterator<std::vector<RemovedEntries>>;
+using InodeVectorIteratorType = SetContainerIterator<std::vector<Inode>>;
+using S3ChunkInfoVectorIteratorType =
+    SetContainerIterator<std::vector<InodeS3ChunkInfoList>>;
+using DentryVectorIteratorType = SetContainerIterator<std::vector<Dentry>>;
+using AppliedRequestsIteratorType =
+    SetContainerIterator<std::vector<AppliedRequests>>;
+
+namespace {
+
+// deltas of snapshot are named |base|.delta.1, |base|.delta.2, ...
+std::string DeltaPath(const std::string& base, size_t index) {
+    return base + ".delta." + std::to_string(index);
+}
+
+std::string DirName(const std::string& path) {
+    auto pos = path.find_last_of('/');
+    return pos == std::string::npos ? "." : path.substr(0, pos);
+}
+
+std::string BaseName(const std::string& path) {
+    auto pos = path.find_last_of('/');
+    return pos == std::string::npos ? path : path.substr(pos + 1);
+}
+
+bool GetFileInode(const std::string& path, ino_t* ino) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    *ino = st.st_ino;
+    return true;
+}
+
+template <typename CreateRequest>
+bool IsSymlinkEmpty(const CreateRequest* request) {
+    return request->type() == FsFileType::TYPE_SYM_LINK &&
+           (!request->has_symlink() || request->symlink().empty());
+}
+
+}  // namespace
+
+MetaStoreImpl::MetaStoreImpl(copyset::CopysetNode* node)
+    : copysetNode_(node), partitionChanged_(false) {}
 
 bool MetaStoreImpl::LoadPartition(uint32_t partitionId, void* entry) {
     auto partitionInfo = reinterpret_cast<PartitionInfo*>(entry);
@@ -71,6 +117,23 @@ bool MetaStoreImpl::LoadInode(uint32_t partitionId, void* entry) {
     return true;
 }
 
+bool MetaStoreImpl::LoadS3ChunkInfoList(uint32_t partitionId, void* entry) {
+    auto partition = GetPartition(partitionId);
+    if (nullptr == partition) {
+        LOG(ERROR) << "Partition not found, partitionId = " << partitionId;
+        return false;
+    }
+
+    auto list = reinterpret_cast<InodeS3ChunkInfoList*>(entry);
+    MetaStatusCode rc = partition->InsertS3ChunkInfoList(*list);
+    if (rc != MetaStatusCode::OK) {
+        LOG(ERROR) << "InsertS3ChunkInfoList failed, retCode = "
+                   << MetaStatusCode_Name(rc);
+        return false;
+    }
+    return true;
+}
+
 bool MetaStoreImpl::LoadDentry(uint32_t partitionId, void* entry) {
     auto partition = GetPartition(partitionId);
     if (nullptr == partition) {
@@ -104,18 +167,111 @@ bool MetaStoreImpl::LoadPendingTx(uint32_t partitionId, void* entry) {
     return true;
 }
 
+bool MetaStoreImpl::LoadPartitionDelta(uint32_t partitionId, void* entry) {
+    auto partitionInfo = reinterpret_cast<PartitionInfo*>(entry);
+    partitionId = partitionInfo->partitionid();
+    auto partition = GetPartition(partitionId);
+    if (nullptr == partition) {
+        LOG(ERROR) << "Partition not found, partitionId = " << partitionId;
+        return false;
+    }
+
+    // partitions are not created or deleted between base and deltas,
+    // and the pending tx is saved in every delta
+    partition->SetNextId(partitionInfo->nextid());
+    partition->SetStatus(partitionInfo->status());
+    partition->ClearPendingTx();
+    return true;
+}
+
+bool MetaStoreImpl::LoadInodeDelta(uint32_t partitionId, void* entry) {
+    auto partition = GetPartition(partitionId);
+    if (nullptr == partition) {
+        LOG(ERROR) << "Partition not found, partitionId = " << partitionId;
+        return false;
+    }
+
+    auto inode = reinterpret_cast<Inode*>(entry);
+    MetaStatusCode rc = partition->UpsertInode(*inode);
+    if (rc != MetaStatusCode::OK) {
+        LOG(ERROR) << "UpsertInode failed, retCode = "
+                   << MetaStatusCode_Name(rc);
+        return false;
+    }
+    return true;
+}
+
+bool MetaStoreImpl::LoadDentryDelta(uint32_t partitionId, void* entry) {
+    auto partition = GetPartition(partitionId);
+    if (nullptr == partition) {
+        LOG(ERROR) << "Partition not found, partitionId = " << partitionId;
+        return false;
+    }
+
+    auto dentry = reinterpret_cast<Dentry*>(entry);
+    MetaStatusCode rc = partition->UpsertDentry(*dentry);
+    if (rc != MetaStatusCode::OK) {
+        LOG(ERROR) << "UpsertDentry failed, retCode = "
+                   << MetaStatusCode_Name(rc);
+        return false;
+    }
+    return true;
+}
+
+bool MetaStoreImpl::LoadRemovedEntries(uint32_t partitionId, void* entry) {
+    auto partition = GetPartition(partitionId);
+    if (nullptr == partition) {
+        LOG(ERROR) << "Partition not found, partitionId = " << partitionId;
+        return false;
+    }
+
+    auto entries = reinterpret_cast<RemovedEntries*>(entry);
+    MetaStatusCode rc = partition->RemoveEntries(*entries);
+    if (rc != MetaStatusCode::OK) {
+        LOG(ERROR) << "RemoveEntries failed, retCode = "
+                   << MetaStatusCode_Name(rc);
+        return false;
+    }
+    return true;
+}
+
+bool MetaStoreImpl::LoadAppliedRequests(uint32_t partitionId, void* entry) {
+    auto partition = GetPartition(partitionId);
+    if (nullptr == partition) {
+        LOG(ERROR) << "Partition not found, partitionId = " << partitionId;
+        return false;
+    }
+
+    auto requests = reinterpret_cast<AppliedRequests*>(entry);
+    partition->SetAppliedRequests(*requests);
+    return true;
+}
+
 bool MetaStoreImpl::Load(const std::string& pathname) {
+    bool delta = false;
+    std::atomic<uint64_t> entries(0);
     auto callback = [&](ENTRY_TYPE entryType, uint32_t paritionId,
                         void* entry) -> bool {
+        entries++;
         switch (entryType) {
             case ENTRY_TYPE::PARTITION:
-                return LoadPartition(paritionId, entry);
+                return delta ? LoadPartitionDelta(paritionId, entry)
+                             : LoadPartition(paritionId, entry);
             case ENTRY_TYPE::INODE:
-                return LoadInode(paritionId, entry);
+                return delta ? LoadInodeDelta(paritionId, entry)
+                             : LoadInode(paritionId, entry);
+            case ENTRY_TYPE::S3_CHUNK_INFO_LIST:
+                // an empty list of delta removes the list
+                return LoadS3ChunkInfoList(paritionId, entry);
             case ENTRY_TYPE::DENTRY:
-                return LoadDentry(paritionId, entry);
+                return delta ? LoadDentryDelta(paritionId, entry)
+                             : LoadDentry(paritionId, entry);
             case ENTRY_TYPE::PENDING_TX:
                 return LoadPendingTx(paritionId, entry);
+            case ENTRY_TYPE::REMOVED_ENTRIES:
+                return LoadRemovedEntries(paritionId, entry);
+            case ENTRY_TYPE::APPLIED_REQUESTS:
+                return LoadAppliedRequests(paritionId, entry);
             case ENTRY_TYPE::UNKNOWN:
             default:
                 break;
@@ -125,15 +281,39 @@ bool MetaStoreImpl::Load(const std::string& pathname) {
         return false;
     };
 
-    // Load from raft snap file to memory
+    // Load from raft snap file to memory, the partitions are loaded
+    // in parallel
     WriteLockGuard writeLockGuard(rwLock_);
-    auto succ = LoadFromFile(pathname, callback);
+    auto concurrency =
+        KVStorageManager::GetInstance().GetOption().snapshotLoadConcurrency;
+    SnapshotFiles files;
+    auto succ = LoadFromFile(pathname, callback, concurrency) &&
+                GetFileInode(pathname, &files.base);
+    files.baseEntries = entries;
+
+    // apply the deltas in order
+    delta = true;
+    ino_t ino = 0;
+    for (size_t i = 1; succ && GetFileInode(DeltaPath(pathname, i), &ino);
+         i++) {
+        entries = 0;
+        succ = LoadFromFile(DeltaPath(pathname, i), callback, concurrency);
+        files.deltas.push_back(ino);
+        files.deltaEntries += entries;
+    }
+
     if (!succ) {
         partitionMap_.clear();
         LOG(ERROR) << "Load metadata failed.";
+    } else {
+        LOG(INFO) << "Load metadata success, base entries = "
+                  << files.baseEntries << ", deltas = " << files.deltas.size()
+                  << ", delta entries = " << files.deltaEntries;
     }
 
     for (auto it = partitionMap_.begin(); it != partitionMap_.end(); it++) {
+        // the entries loaded are in the snapshot already
+        it->second->ClearChanges();
         if (it->second->GetStatus() == PartitionStatus::DELETING) {
             uint32_t partitionId = it->second->GetPartitionId();
             std::shared_ptr<PartitionCleaner> partitionCleaner =
@@ -143,6 +323,12 @@ bool MetaStoreImpl::Load(const std::string& pathname) {
         }
     }
 
+    files.valid = succ;
+    partitionChanged_ = false;
+    {
+        std::lock_guard<std::mutex> guard(snapshotMutex_);
+        lastSnapshot_ = files;
+    }
     return succ;
 }
 
@@ -161,24 +347,17 @@ std::shared_ptr<Iterator> MetaStoreImpl::NewPartitionIterator() {
 
 std::shared_ptr<Iterator> MetaStoreImpl::NewInodeIterator(
     std::shared_ptr<Partition> partition) {
-    auto partitionId = partition->GetPartitionId();
-    auto cntr = partition->GetInodeContainer();
-    auto container = std::shared_ptr<InodeContainerType>(
-        cntr, [](InodeContainerType*) {});  // don't release storage
-    auto iterator = std::make_shared<InodeIteratorType>(ENTRY_TYPE::INODE,
-                                                        partitionId, container);
-    return iterator;
+    return partition->NewInodeIterator();
+}
+
+std::shared_ptr<Iterator> MetaStoreImpl::NewS3ChunkInfoIterator(
+    std::shared_ptr<Partition> partition) {
+    return partition->NewS3ChunkInfoIterator();
 }
 
 std::shared_ptr<Iterator> MetaStoreImpl::NewDentryIterator(
     std::shared_ptr<Partition> partition) {
-    auto partitionId = partition->GetPartitionId();
-    auto cntr = partition->GetDentryContainer();
-    auto container = std::shared_ptr<DentryContainerType>(
-        cntr, [](DentryContainerType*) {});  // don't release storage
-    auto iterator = std::make_shared<DentryIteratorType>(
-        ENTRY_TYPE::DENTRY, partitionId, container);
-    return iterator;
+    return partition->NewDentryIterator();
 }
 
 std::shared_ptr<Iterator> MetaStoreImpl::NewPendingTxIterator(
@@ -195,31 +374,173 @@ std::shared_ptr<Iterator> MetaStoreImpl::NewPendingTxIterator(
     return iterator;
 }
 
-void MetaStoreImpl::SaveBackground(const std::string& path,
-                                   OnSnapshotSaveDoneClosure* done) {
-    LOG(INFO) << "Save metadata to file background.";
+std::shared_ptr<Iterator> MetaStoreImpl::NewAppliedRequestsIterator(
+    std::shared_ptr<Partition> partition) {
+    AppliedRequests requests;
+    partition->GetAppliedRequests(&requests);
+    auto container = std::make_shared<std::vector<AppliedRequests>>();
+    // the records are never emptied once added, so nothing is saved
+    // for a partition without any
+    if (requests.createrequestids_size() > 0 ||
+        requests.dirstatrequestids_size() > 0) {
+        container->push_back(std::move(requests));
+    }
 
-    std::vector<std::shared_ptr<Iterator>> children;
-    auto iterator = NewPartitionIterator();  // partition
-    children.push_back(iterator);
+    return std::make_shared<AppliedRequestsIteratorType>(
+        ENTRY_TYPE::APPLIED_REQUESTS, partition->GetPartitionId(),
+        container);
+}
 
-    for (const auto& item : partitionMap_) {
-        auto partition = item.second;
+bool MetaStoreImpl::NewDeltaIterators(
+    std::shared_ptr<Partition> partition,
+    std::vector<std::shared_ptr<Iterator>>* children) {
+    auto partitionId = partition->GetPartitionId();
+    InodeChanges inodeChanges;
+    DentryChanges dentryChanges;
+    auto rc = partition->TakeChanges(&inodeChanges, &dentryChanges);
+    if (rc != MetaStatusCode::OK) {
+        LOG(ERROR) << "Take changes of partition failed, partitionId = "
+                   << partitionId << ", retCode = " << MetaStatusCode_Name(rc);
+        return false;
+    }
 
-        iterator = NewInodeIterator(partition);  // inode
-        children.push_back(iterator);
+    auto removed = std::make_shared<std::vector<RemovedEntries>>();
+    if (!inodeChanges.removedInodes.empty() ||
+        !dentryChanges.removedDentrys.empty()) {
+        RemovedEntries entries;
+        for (const auto& key : inodeChanges.removedInodes) {
+            entries.add_fsids(key.fsId);
+            entries.add_inodeids(key.inodeId);
+        }
+        *entries.mutable_dentrys() = {dentryChanges.removedDentrys.begin(),
+                                      dentryChanges.removedDentrys.end()};
+        removed->push_back(std::move(entries));
+    }
+    children->push_back(std::make_shared<RemovedEntriesIteratorType>(
+        ENTRY_TYPE::REMOVED_ENTRIES, partitionId, removed));
+
+    children->push_back(std::make_shared<InodeVectorIteratorType>(
+        ENTRY_TYPE::INODE, partitionId,
+        std::make_shared<std::vector<Inode>>(
+            std::move(inodeChanges.inodes))));
+
+    children->push_back(std::make_shared<S3ChunkInfoVectorIteratorType>(
+        ENTRY_TYPE::S3_CHUNK_INFO_LIST, partitionId,
+        std::make_shared<std::vector<InodeS3ChunkInfoList>>(
+            std::move(inodeChanges.s3ChunkInfoLists))));
+
+    children->push_back(std::make_shared<DentryVectorIteratorType>(
+        ENTRY_TYPE::DENTRY, partitionId,
+        std::make_shared<std::vector<Dentry>>(
+            std::move(dentryChanges.dentrys))));
+
+    children->push_back(NewPendingTxIterator(partition));
+    children->push_back(NewAppliedRequestsIterator(partition));
+    return true;
+}
 
-        iterator = NewDentryIterator(partition);  // dentry
-        children.push_back(iterator);
+bool MetaStoreImpl::LinkLastSnapshot(const std::string& path,
+                                     const SnapshotFiles& last) {
+    // snapshots of raft are in sibling directories, look for the one
+    // which has the files of the last snapshot
+    std::string dir = DirName(path);
+    std::string parent = DirName(dir);
+    std::string name = BaseName(path);
+    auto isLastSnapshot = [&](const std::string& base) {
+        ino_t ino;
+        if (!GetFileInode(base, &ino) || ino != last.base) {
+            return false;
+        }
+        for (size_t i = 0; i < last.deltas.size(); i++) {
+            if (!GetFileInode(DeltaPath(base, i + 1), &ino) ||
+                ino != last.deltas[i]) {
+                return false;
+            }
+        }
+        return true;
+    };
 
-        iterator = NewPendingTxIterator(partition);  // pending tx
-        children.push_back(iterator);
+    std::string lastPath;
+    DIR* dp = ::opendir(parent.c_str());
+    if (dp == nullptr) {
+        LOG(WARNING) << "Open snapshot directory failed, dir = " << parent
+                     << ", error = " << strerror(errno);
+        return false;
+    }
+    struct dirent* entry;
+    while ((entry = ::readdir(dp)) != nullptr) {
+        std::string current = parent + "/" + entry->d_name;
+        if (current != dir && isLastSnapshot(current + "/" + name)) {
+            lastPath = current + "/" + name;
+            break;
+        }
+    }
+    ::closedir(dp);
+
+    if (lastPath.empty()) {
+        LOG(WARNING) << "The files of last snapshot are not found, dir = "
+                     << parent;
+        return false;
     }
 
+    std::vector<std::string> linked;
+    for (size_t i = 0; i <= last.deltas.size(); i++) {
+        auto from = (i == 0) ? lastPath : DeltaPath(lastPath, i);
+        auto to = (i == 0) ? path : DeltaPath(path, i);
+        if (::link(from.c_str(), to.c_str()) != 0) {
+            LOG(WARNING) << "Link snapshot file failed, from = " << from
+                         << ", to = " << to
+                         << ", error = " << strerror(errno);
+            for (const auto& file : linked) {
+                ::unlink(file.c_str());
+            }
+            return false;
+        }
+        linked.push_back(to);
+    }
+    return true;
+}
+
+void MetaStoreImpl::SaveBackground(
+    const std::string& path,
+    std::vector<std::shared_ptr<Iterator>> children,
+    SnapshotFiles last,
+    OnSnapshotSaveDoneClosure* done) {
+    bool delta = last.valid;
+    std::string filename =
+        delta ? DeltaPath(path, last.deltas.size() + 1) : path;
+    LOG(INFO) << "Save metadata to file " << filename << " background.";
+
+    // NOTE: the forked child process can't read leveldb safely, the
+    //       iterators of kv storage read the snapshots taken in Save(),
+    //       and the entries of delta are copied out in Save()
+    bool background = !delta && !KVStorageManager::GetInstance().Enabled();
     auto mergeIterator = std::make_shared<MergeIterator>(children);
-    bool succ = SaveToFile(path, mergeIterator);
-    LOG(INFO) << "Save metadata to file " << (succ ? "success" : "fail");
+    uint64_t entries = mergeIterator->Size();
+    ino_t ino = 0;
+    bool succ = SaveToFile(filename, mergeIterator, background) &&
+                GetFileInode(filename, &ino);
+    LOG(INFO) << "Save metadata to file " << (succ ? "success" : "fail")
+              << ", entries = " << entries;
+
+    SnapshotFiles files = last;
+    if (delta) {
+        files.deltas.push_back(ino);
+        files.deltaEntries += entries;
+    } else {
+        files.base = ino;
+        files.baseEntries = entries;
+    }
+    files.valid = succ;
+    {
+        std::lock_guard<std::mutex> guard(snapshotMutex_);
+        lastSnapshot_ = files;
+    }
+
     if (succ) {
+        for (size_t i = 1; i <= files.deltas.size(); i++) {
+            done->AddFile(BaseName(DeltaPath(path, i)));
+        }
         done->SetSuccess();
     } else {
         done->SetError(MetaStatusCode::SAVE_META_FAIL);
@@ -231,8 +552,78 @@ void MetaStoreImpl::SaveBackground(const std::string& path,
 bool MetaStoreImpl::Save(const std::string& path,
                          OnSnapshotSaveDoneClosure* done) {
     ReadLockGuard readLockGuard(rwLock_);
-    std::thread th =
-        std::thread(&MetaStoreImpl::SaveBackground, this, path, done);
+
+    SnapshotFiles last;
+    {
+        std::lock_guard<std::mutex> guard(snapshotMutex_);
+        last = lastSnapshot_;
+    }
+
+    // save the entries changed since the last snapshot as a delta, the
+    // base and deltas are compacted into a new base if the deltas are
+    // too many or too large
+    std::vector<std::shared_ptr<Iterator>> children;
+    const auto& option = KVStorageManager::GetInstance().GetOption();
+    if (option.incrementalSnapshot && last.valid && !partitionChanged_ &&
+        last.deltas.size() < option.snapshotMaxDeltas) {
+        children.push_back(NewPartitionIterator());
+        bool succ = true;
+        for (const auto& item : partitionMap_) {
+            if (!NewDeltaIterators(item.second, &children)) {
+                succ = false;
+                break;
+            }
+        }
+
+        uint64_t entries = 0;
+        for (const auto& child : children) {
+            entries += child->Size();
+        }
+        succ = succ &&
+               (last.deltaEntries + entries) * 100 <=
+                   last.baseEntries * option.snapshotMaxDeltaPercent &&
+               LinkLastSnapshot(path, last);
+        if (succ) {
+            std::thread th = std::thread(&MetaStoreImpl::SaveBackground, this,
+                                         path, std::move(children), last,
+                                         done);
+            th.detach();
+            return true;
+        }
+
+        // the changes taken are saved in the new base
+        LOG(INFO) << "Save all entries of metadata as a new base";
+        children.clear();
+    }
+
+    // iterators are created here, so the snapshots of kv storage are
+    // taken at the point of raft snapshot
+    auto iterator = NewPartitionIterator();  // partition
+    children.push_back(iterator);
+
+    for (const auto& item : partitionMap_) {
+        auto partition = item.second;
+        partition->ClearChanges();
+
+        iterator = NewInodeIterator(partition);  // inode
+        children.push_back(iterator);
+
+        iterator = NewS3ChunkInfoIterator(partition);  // s3 chunk info
+        children.push_back(iterator);
+
+        iterator = NewDentryIterator(partition);  // dentry
+        children.push_back(iterator);
+
+        iterator = NewPendingTxIterator(partition);  // pending tx
+        children.push_back(iterator);
+
+        iterator = NewAppliedRequestsIterator(partition);  // applied requests
+        children.push_back(iterator);
+    }
+
+    partitionChanged_ = false;
+    std::thread th = std::thread(&MetaStoreImpl::SaveBackground, this, path,
+                                 std::move(children), SnapshotFiles(), done);
     th.detach();
     return true;
 }
@@ -245,6 +636,8 @@ bool MetaStoreImpl::Clear() {
         PartitionCleanManager::GetInstance().Remove(it->first);
     }
     partitionMap_.clear();
+    std::lock_guard<std::mutex> guard(snapshotMutex_);
+    lastSnapshot_ = SnapshotFiles();
     return true;
 }
 
@@ -263,6 +656,7 @@ MetaStatusCode MetaStoreImpl::CreatePartition(
 
     partitionMap_.emplace(partition.partitionid(),
                           std::make_shared<Partition>(partition));
+    partitionChanged_ = true;
     response->set_statuscode(MetaStatusCode::OK);
     return MetaStatusCode::OK;
 }
@@ -286,6 +680,7 @@ MetaStatusCode MetaStoreImpl::DeletePartition(
         it->second->ClearS3Compact();
         PartitionCleanManager::GetInstance().Remove(partitionId);
         partitionMap_.erase(it);
+        partitionChanged_ = true;
         response->set_statuscode(MetaStatusCode::OK);
         return MetaStatusCode::OK;
     }
@@ -299,6 +694,7 @@ MetaStatusCode MetaStoreImpl::DeletePartition(
         PartitionCleanManager::GetInstance().Add(partitionId, partitionCleaner,
                                                  copysetNode_);
         it->second->SetStatus(PartitionStatus::DELETING);
+        partitionChanged_ = true;
         TrashManager::GetInstance().Remove(partitionId);
         it->second->ClearS3Compact();
     } else {
@@ -442,8 +838,81 @@ MetaStatusCode MetaStoreImpl::PrepareRenameTx(
 }
 
 // inode
+MetaStatusCode MetaStoreImpl::CreateInodeAndDentry(
+    const CreateInodeAndDentryRequest* request, uint64_t inodeId,
+    CreateInodeAndDentryResponse* response) {
+    if (IsSymlinkEmpty(request)) {
+        response->set_statuscode(MetaStatusCode::SYM_LINK_EMPTY);
+        return MetaStatusCode::SYM_LINK_EMPTY;
+    }
+
+    ReadLockGuard readLockGuard(rwLock_);
+    std::shared_ptr<Partition> partition = GetPartition(request->partitionid());
+    if (partition == nullptr) {
+        MetaStatusCode status = MetaStatusCode::PARTITION_NOT_FOUND;
+        response->set_statuscode(status);
+        return status;
+    }
+
+    MetaStatusCode status = partition->CreateInodeAndDentry(
+        *request, inodeId, response->mutable_inode());
+    response->set_statuscode(status);
+    if (status != MetaStatusCode::OK) {
+        response->clear_inode();
+    }
+    return status;
+}
+
+MetaStatusCode MetaStoreImpl::UnlinkDentryAndDecNlink(
+    const UnlinkDentryAndDecNlinkRequest* request,
+    UnlinkDentryAndDecNlinkResponse* response) {
+    ReadLockGuard readLockGuard(rwLock_);
+    std::shared_ptr<Partition> partition = GetPartition(request->partitionid());
+    if (partition == nullptr) {
+        MetaStatusCode status = MetaStatusCode::PARTITION_NOT_FOUND;
+        response->set_statuscode(status);
+        return status;
+    }
+
+    Dentry dentry;
+    dentry.set_fsid(request->fsid());
+    dentry.set_inodeid(request->inodeid());
+    dentry.set_parentinodeid(request->parentinodeid());
+    dentry.set_name(request->name());
+    dentry.set_txid(request->txid());
+
+    auto rc = partition->UnlinkDentryAndDecNlink(dentry);
+    response->set_statuscode(rc);
+    return rc;
+}
+
 MetaStatusCode MetaStoreImpl::CreateInode(const CreateInodeRequest* request,
                                           CreateInodeResponse* response) {
+    uint64_t inodeId = UINT64_MAX;
+    // the request fails anyway, don't waste an id
+    if (!IsSymlinkEmpty(request)) {
+        ReserveInodeId(request->partitionid(), &inodeId);
+    }
+    return CreateInode(request, inodeId, response);
+}
+
+MetaStatusCode MetaStoreImpl::ReserveInodeId(uint32_t partitionId,
+                                             uint64_t* inodeId) {
+    *inodeId = UINT64_MAX;
+    ReadLockGuard readLockGuard(rwLock_);
+    std::shared_ptr<Partition> partition = GetPartition(partitionId);
+    if (partition == nullptr) {
+        return MetaStatusCode::PARTITION_NOT_FOUND;
+    }
+
+    *inodeId = partition->GetNewInodeId();
+    return *inodeId == UINT64_MAX ? MetaStatusCode::PARTITION_ALLOC_ID_FAIL
+                                  : MetaStatusCode::OK;
+}
+
+MetaStatusCode MetaStoreImpl::CreateInode(const CreateInodeRequest* request,
+                                          uint64_t inodeId,
+                                          CreateInodeResponse* response) {
     uint32_t fsId = request->fsid();
     uint64_t length = request->length();
     uint32_t uid = request->uid();
@@ -453,16 +922,12 @@ MetaStatusCode MetaStoreImpl::CreateInode(const CreateInodeRequest* request,
     std::string symlink;
     uint32_t rdev = request->rdev();
     if (type == FsFileType::TYPE_SYM_LINK) {
-        if (!request->has_symlink()) {
+        if (IsSymlinkEmpty(request)) {
             response->set_statuscode(MetaStatusCode::SYM_LINK_EMPTY);
             return MetaStatusCode::SYM_LINK_EMPTY;
         }
 
         symlink = request->symlink();
-        if (symlink.empty()) {
-            response->set_statuscode(MetaStatusCode::SYM_LINK_EMPTY);
-            return MetaStatusCode::SYM_LINK_EMPTY;
-        }
     }
 
     ReadLockGuard readLockGuard(rwLock_);
@@ -473,8 +938,9 @@ MetaStatusCode MetaStoreImpl::CreateInode(const CreateInodeRequest* request,
         return status;
     }
     MetaStatusCode status =
-        partition->CreateInode(fsId, length, uid, gid, mode, type, symlink,
-                               rdev, response->mutable_inode());
+        partition->CreateInode(fsId, inodeId, length, uid, gid, mode, type,
+                               symlink, rdev, request->parent(),
+                               response->mutable_inode());
     response->set_statuscode(status);
     if (status != MetaStatusCode::OK) {
         response->clear_inode();
@@ -530,6 +996,40 @@ MetaStatusCode MetaStoreImpl::GetInode(const GetInodeRequest* request,
     return status;
 }
 
+MetaStatusCode MetaStoreImpl::BatchGetInodeAttr(
+    const BatchGetInodeAttrRequest* request,
+    BatchGetInodeAttrResponse* response) {
+    uint32_t fsId = request->fsid();
+
+    ReadLockGuard readLockGuard(rwLock_);
+    std::shared_ptr<Partition> partition = GetPartition(request->partitionid());
+    if (partition == nullptr) {
+        MetaStatusCode status = MetaStatusCode::PARTITION_NOT_FOUND;
+        response->set_statuscode(status);
+        return status;
+    }
+
+    MetaStatusCode status = MetaStatusCode::OK;
+    for (const auto& inodeId : request->inodeid()) {
+        InodeAttr attr;
+        status = partition->GetInodeAttr(fsId, inodeId, &attr);
+        if (status == MetaStatusCode::OK) {
+            response->add_attr()->Swap(&attr);
+        } else if (status == MetaStatusCode::NOT_FOUND) {
+            // the inode may be deleted after its dentry was listed
+            status = MetaStatusCode::OK;
+        } else {
+            break;
+        }
+    }
+
+    if (status != MetaStatusCode::OK) {
+        response->clear_attr();
+    }
+    response->set_statuscode(status);
+    return status;
+}
+
 MetaStatusCode MetaStoreImpl::DeleteInode(const DeleteInodeRequest* request,
                                           DeleteInodeResponse* response) {
     uint32_t fsId = request->fsid();
@@ -571,6 +1071,60 @@ MetaStatusCode MetaStoreImpl::UpdateInode(const UpdateInodeRequest* request,
     return status;
 }
 
+MetaStatusCode MetaStoreImpl::BatchUpdateInode(
+    const BatchUpdateInodeRequest* request,
+    BatchUpdateInodeResponse* response) {
+    for (const auto& update : request->updateinode()) {
+        if (update.has_volumeextentlist() &&
+            !update.s3chunkinfomap().empty()) {
+            LOG(ERROR) << "only one of type space info, choose volume or s3"
+                       << ", inodeId = " << update.inodeid();
+            response->set_statuscode(MetaStatusCode::PARAM_ERROR);
+            return MetaStatusCode::PARAM_ERROR;
+        }
+    }
+
+    ReadLockGuard readLockGuard(rwLock_);
+    std::shared_ptr<Partition> partition = GetPartition(request->partitionid());
+    if (partition == nullptr) {
+        MetaStatusCode status = MetaStatusCode::PARTITION_NOT_FOUND;
+        response->set_statuscode(status);
+        return status;
+    }
+
+    std::set<uint64_t> failedInodeIds;
+    MetaStatusCode status =
+        partition->BatchUpdateInode(*request, &failedInodeIds);
+    response->set_statuscode(status);
+    for (const auto& inodeId : failedInodeIds) {
+        response->add_failedinodeid(inodeId);
+    }
+    return status;
+}
+
+MetaStatusCode MetaStoreImpl::UpdateDirStat(
+    const UpdateDirStatRequest* request, UpdateDirStatResponse* response) {
+    ReadLockGuard readLockGuard(rwLock_);
+    std::shared_ptr<Partition> partition = GetPartition(request->partitionid());
+    if (partition == nullptr) {
+        MetaStatusCode status = MetaStatusCode::PARTITION_NOT_FOUND;
+        response->set_statuscode(status);
+        return status;
+    }
+
+    uint64_t parent = 0;
+    DirStat stat;
+    MetaStatusCode status = partition->UpdateDirStat(*request, &parent, &stat);
+    response->set_statuscode(status);
+    if (status == MetaStatusCode::OK) {
+        response->set_parent(parent);
+        if (stat.IsInitialized()) {
+            *response->mutable_stat() = stat;
+        }
+    }
+    return status;
+}
+
 MetaStatusCode MetaStoreImpl::GetOrModifyS3ChunkInfo(
     const GetOrModifyS3ChunkInfoRequest* request,
     GetOrModifyS3ChunkInfoResponse* response) {
@@ -23,10 +23,15 @@
 #ifndef CURVEFS_SRC_METASERVER_METASTORE_H_
 #define CURVEFS_SRC_METASERVER_METASTORE_H_
 
+#include <sys/types.h>
+
+#include <atomic>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <vector>
 #include "curvefs/proto/metaserver.pb.h"
 #include "curvefs/src/metaserver/copyset/snapshot_closure.h"
 #include "curvefs/src/metaserver/partition.h"
@@ -47,13 +52,23 @@ using curvefs::metaserver::CreateDentryRequest;
 using curvefs::metaserver::CreateDentryResponse;
 using curvefs::metaserver::DeleteDentryRequest;
 using curvefs::metaserver::DeleteDentryResponse;
+using curvefs::metaserver::CreateInodeAndDentryRequest;
+using curvefs::metaserver::CreateInodeAndDentryResponse;
+using curvefs::metaserver::UnlinkDentryAndDecNlinkRequest;
+using curvefs::metaserver::UnlinkDentryAndDecNlinkResponse;
 // inode
 using curvefs::metaserver::GetInodeRequest;
 using curvefs::metaserver::GetInodeResponse;
+using curvefs::metaserver::BatchGetInodeAttrRequest;
+using curvefs::metaserver::BatchGetInodeAttrResponse;
 using curvefs::metaserver::CreateInodeRequest;
 using curvefs::metaserver::CreateInodeResponse;
 using curvefs::metaserver::UpdateInodeRequest;
 using curvefs::metaserver::UpdateInodeResponse;
+using curvefs::metaserver::BatchUpdateInodeRequest;
+using curvefs::metaserver::BatchUpdateInodeResponse;
+using curvefs::metaserver::UpdateDirStatRequest;
+using curvefs::metaserver::UpdateDirStatResponse;
 using curvefs::metaserver::DeleteInodeRequest;
 using curvefs::metaserver::DeleteInodeResponse;
 using curvefs::metaserver::CreateRootInodeRequest;
@@ -103,10 +118,30 @@ class MetaStore {
         const PrepareRenameTxRequest* request,
         PrepareRenameTxResponse* response) = 0;
 
+    // create the inode with the id reserved by ReserveInodeId() and its
+    // dentry in the partition of parent
+    virtual MetaStatusCode CreateInodeAndDentry(
+        const CreateInodeAndDentryRequest* request, uint64_t inodeId,
+        CreateInodeAndDentryResponse* response) = 0;
+
+    virtual MetaStatusCode UnlinkDentryAndDecNlink(
+        const UnlinkDentryAndDecNlinkRequest* request,
+        UnlinkDentryAndDecNlinkResponse* response) = 0;
+
     // inode
     virtual MetaStatusCode CreateInode(const CreateInodeRequest* request,
                                        CreateInodeResponse* response) = 0;
 
+    // reserve the id of an inode to create in the partition, the ids are
+    // reserved in raft log order, so the inodes can be created concurrently
+    // by CreateInode() with the reserved ids in the same way on all peers
+    virtual MetaStatusCode ReserveInodeId(uint32_t partitionId,
+                                          uint64_t* inodeId) = 0;
+
+    virtual MetaStatusCode CreateInode(const CreateInodeRequest* request,
+                                       uint64_t inodeId,
+                                       CreateInodeResponse* response) = 0;
+
     virtual MetaStatusCode CreateRootInode(
         const CreateRootInodeRequest* request,
         CreateRootInodeResponse* response) = 0;
@@ -114,12 +149,23 @@ class MetaStore {
     virtual MetaStatusCode GetInode(const GetInodeRequest* request,
                                     GetInodeResponse* response) = 0;
 
+    virtual MetaStatusCode BatchGetInodeAttr(
+        const BatchGetInodeAttrRequest* request,
+        BatchGetInodeAttrResponse* response) = 0;
+
     virtual MetaStatusCode DeleteInode(const DeleteInodeRequest* request,
                                        DeleteInodeResponse* response) = 0;
 
     virtual MetaStatusCode UpdateInode(const UpdateInodeRequest* request,
                                        UpdateInodeResponse* response) = 0;
 
+    virtual MetaStatusCode BatchUpdateInode(
+        const BatchUpdateInodeRequest* request,
+        BatchUpdateInodeResponse* response) = 0;
+
+    virtual MetaStatusCode UpdateDirStat(const UpdateDirStatRequest* request,
+                                         UpdateDirStatResponse* response) = 0;
+
     virtual MetaStatusCode GetOrModifyS3ChunkInfo(
         const GetOrModifyS3ChunkInfoRequest* request,
         GetOrModifyS3ChunkInfoResponse* response) = 0;
@@ -158,22 +204,48 @@ class MetaStoreImpl : public MetaStore {
     MetaStatusCode PrepareRenameTx(const PrepareRenameTxRequest* request,
                                    PrepareRenameTxResponse* response) override;
 
+    MetaStatusCode CreateInodeAndDentry(
+        const CreateInodeAndDentryRequest* request, uint64_t inodeId,
+        CreateInodeAndDentryResponse* response) override;
+
+    MetaStatusCode UnlinkDentryAndDecNlink(
+        const UnlinkDentryAndDecNlinkRequest* request,
+        UnlinkDentryAndDecNlinkResponse* response) override;
+
     // inode
     MetaStatusCode CreateInode(const CreateInodeRequest* request,
                                CreateInodeResponse* response) override;
 
+    MetaStatusCode ReserveInodeId(uint32_t partitionId,
+                                  uint64_t* inodeId) override;
+
+    MetaStatusCode CreateInode(const CreateInodeRequest* request,
+                               uint64_t inodeId,
+                               CreateInodeResponse* response) override;
+
     MetaStatusCode CreateRootInode(const CreateRootInodeRequest* request,
                                    CreateRootInodeResponse* response) override;
 
     MetaStatusCode GetInode(const GetInodeRequest* request,
                             GetInodeResponse* response) override;
 
+    MetaStatusCode BatchGetInodeAttr(
+        const BatchGetInodeAttrRequest* request,
+        BatchGetInodeAttrResponse* response) override;
+
     MetaStatusCode DeleteInode(const DeleteInodeRequest* request,
                                DeleteInodeResponse* response) override;
 
     MetaStatusCode UpdateInode(const UpdateInodeRequest* request,
                                UpdateInodeResponse* response) override;
 
+    MetaStatusCode BatchUpdateInode(
+        const BatchUpdateInodeRequest* request,
+        BatchUpdateInodeResponse* response) override;
+
+    MetaStatusCode UpdateDirStat(const UpdateDirStatRequest* request,
+                                 UpdateDirStatResponse* response) override;
+
     MetaStatusCode GetOrModifyS3ChunkInfo(
         const GetOrModifyS3ChunkInfoRequest* request,
         GetOrModifyS3ChunkInfoResponse* response) override;
@@ -181,26 +253,74 @@ class MetaStoreImpl : public MetaStore {
     std::shared_ptr<Partition> GetPartition(uint32_t partitionId);
 
  private:
+    // The files of the last snapshot. A snapshot is a base which has all
+    // entries, and deltas which have the entries changed since the last
+    // snapshot. The files are identified by inodes, they are hard linked
+    // into the directory of the next snapshot.
+    struct SnapshotFiles {
+        bool valid;
+        ino_t base;
+        std::vector<ino_t> deltas;
+        uint64_t baseEntries;
+        uint64_t deltaEntries;
+
+        SnapshotFiles()
+            : valid(false), base(0), baseEntries(0), deltaEntries(0) {}
+    };
+
     bool LoadPartition(uint32_t partitionId, void* entry);
 
     bool LoadInode(uint32_t partitionId, void* entry);
 
+    bool LoadS3ChunkInfoList(uint32_t partitionId, void* entry);
+
     bool LoadDentry(uint32_t partitionId, void* entry);
 
     bool LoadPendingTx(uint32_t partitionId, void* entry);
 
+    // the entries of delta replace the ones loaded before
+    bool LoadPartitionDelta(uint32_t partitionId, void* entry);
+
+    bool LoadInodeDelta(uint32_t partitionId, void* entry);
+
+    bool LoadDentryDelta(uint32_t partitionId, void* entry);
+
+    bool LoadRemovedEntries(uint32_t partitionId, void* entry);
+
+    // the records of base or delta replace the ones loaded before
+    bool LoadAppliedRequests(uint32_t partitionId, void* entry);
+
     std::shared_ptr<Iterator> NewPartitionIterator();
 
     std::shared_ptr<Iterator> NewInodeIterator(
         std::shared_ptr<Partition> partition);
 
+    std::shared_ptr<Iterator> NewS3ChunkInfoIterator(
+        std::shared_ptr<Partition> partition);
+
     std::shared_ptr<Iterator> NewDentryIterator(
         std::shared_ptr<Partition> partition);
 
     std::shared_ptr<Iterator> NewPendingTxIterator(
         std::shared_ptr<Partition> partition);
 
+    std::shared_ptr<Iterator> NewAppliedRequestsIterator(
+        std::shared_ptr<Partition> partition);
+
+    // iterators of the entries changed since the last snapshot
+    bool NewDeltaIterators(std::shared_ptr<Partition> partition,
+                           std::vector<std::shared_ptr<Iterator>>* children);
+
+    // link the base and deltas of the last snapshot to |path|, return
+    // false if a full snapshot should be saved instead
+    bool LinkLastSnapshot(const std::string& path,
+                          const SnapshotFiles& last);
+
+    // save a delta of the last snapshot if |last| is valid, else save
+    // all entries as a new base
     void SaveBackground(const std::string& path,
+                        std::vector<std::shared_ptr<Iterator>> children,
+                        SnapshotFiles last,
                         OnSnapshotSaveDoneClosure* done);
 
  private:
@@ -209,6 +329,12 @@ class MetaStoreImpl : public MetaStore {
     std::list<uint32_t> partitionIds_;
 
     copyset::CopysetNode* copysetNode_;
+
+    // the delta only has the changes of existing partitions, so a full
+    // snapshot is saved after partitions are created or deleted
+    std::atomic<bool> partitionChanged_;
+    std::mutex snapshotMutex_;  // protect lastSnapshot_
+    SnapshotFiles lastSnapshot_;
 };
 }  // namespace metaserver
 }  // namespace curvefs
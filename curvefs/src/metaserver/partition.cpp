@@ -35,8 +35,7 @@ namespace metaserver {
 Partition::Partition(const PartitionInfo& paritionInfo) {
     assert(paritionInfo.start() <= paritionInfo.end());
 
-    inodeStorage_ = std::make_shared<MemoryInodeStorage>();
-    dentryStorage_ = std::make_shared<MemoryDentryStorage>();
+    InitStorage(paritionInfo.partitionid());
     trash_ = std::make_shared<TrashImpl>(inodeStorage_);
     inodeManager_ = std::make_shared<InodeManager>(inodeStorage_, trash_);
     txManager_ = std::make_shared<TxManager>(dentryStorage_);
@@ -55,6 +54,36 @@ Partition::Partition(const PartitionInfo& paritionInfo) {
     }
 }
 
+void Partition::InitStorage(uint32_t partitionId) {
+    auto& manager = KVStorageManager::GetInstance();
+    bool trackChanges = manager.GetOption().incrementalSnapshot;
+    if (manager.Enabled()) {
+        auto inodeStore =
+            manager.NewStore("inode_" + std::to_string(partitionId));
+        auto chunkStore =
+            manager.NewStore("s3chunkinfo_" + std::to_string(partitionId));
+        auto dentryStore =
+            manager.NewStore("dentry_" + std::to_string(partitionId));
+        // the snapshot of partitions in memory can't be saved without
+        // fork when the kv storage is enabled, so don't fall back
+        LOG_IF(FATAL, inodeStore == nullptr || chunkStore == nullptr ||
+                      dentryStore == nullptr)
+            << "Open kv storage failed, partitionId = " << partitionId;
+        inodeStorage_ = std::make_shared<KVInodeStorage>(
+            inodeStore, chunkStore, manager.GetOption().inodeCacheCapacity,
+            trackChanges);
+        dentryStorage_ =
+            std::make_shared<KVDentryStorage>(dentryStore, trackChanges);
+        return;
+    }
+
+    uint32_t stripes = manager.GetOption().lockStripes;
+    inodeStorage_ =
+        std::make_shared<MemoryInodeStorage>(trackChanges, stripes);
+    dentryStorage_ =
+        std::make_shared<MemoryDentryStorage>(trackChanges, stripes);
+}
+
 // dentry
 MetaStatusCode Partition::CreateDentry(const Dentry& dentry, bool isLoadding) {
     if (!IsInodeBelongs(dentry.fsid(), dentry.parentinodeid())) {
@@ -154,6 +183,10 @@ bool Partition::InsertPendingTx(const PrepareRenameTxRequest& pendingTx) {
     return txManager_->InsertPendingTx(renameTx);
 }
 
+void Partition::ClearPendingTx() {
+    txManager_->DeletePendingTx();
+}
+
 bool Partition::FindPendingTx(PrepareRenameTxRequest* pendingTx) {
     if (GetStatus() == PartitionStatus::DELETING) {
         return false;
@@ -173,6 +206,165 @@ bool Partition::FindPendingTx(PrepareRenameTxRequest* pendingTx) {
     return true;
 }
 
+MetaStatusCode Partition::CreateInodeAndDentry(
+    const CreateInodeAndDentryRequest& request, uint64_t inodeId,
+    Inode* inode) {
+    uint32_t fsId = request.fsid();
+    uint64_t parentInodeId = request.parentinodeid();
+    if (!IsInodeBelongs(fsId, parentInodeId)) {
+        return MetaStatusCode::PARTITION_ID_MISSMATCH;
+    }
+
+    if (GetStatus() == PartitionStatus::DELETING) {
+        return MetaStatusCode::PARTITION_DELETING;
+    }
+
+    if (inodeId == UINT64_MAX) {
+        return MetaStatusCode::PARTITION_ALLOC_ID_FAIL;
+    }
+
+    if (!IsInodeBelongs(fsId, inodeId)) {
+        return MetaStatusCode::PARTITION_ID_MISSMATCH;
+    }
+
+    // the client retries on timeout, the id reserved for the retry is unused
+    if (GetCreatedInode(request, inode)) {
+        return MetaStatusCode::OK;
+    }
+
+    // check the parent first, so nothing is left if it doesn't exist
+    InodeAttr parentAttr;
+    MetaStatusCode ret =
+        inodeManager_->GetInodeAttr(fsId, parentInodeId, &parentAttr);
+    if (ret != MetaStatusCode::OK) {
+        return ret;
+    }
+
+    std::string symlink;
+    if (request.type() == FsFileType::TYPE_SYM_LINK) {
+        symlink = request.symlink();
+    }
+    ret = inodeManager_->CreateInode(fsId, inodeId, request.length(),
+                                     request.uid(), request.gid(),
+                                     request.mode(), request.type(), symlink,
+                                     request.rdev(), parentInodeId, inode);
+    if (ret != MetaStatusCode::OK) {
+        return ret;
+    }
+
+    Dentry dentry;
+    dentry.set_fsid(fsId);
+    dentry.set_inodeid(inodeId);
+    dentry.set_parentinodeid(parentInodeId);
+    dentry.set_name(request.name());
+    dentry.set_txid(request.txid());
+    if (request.has_flag()) {
+        dentry.set_flag(request.flag());
+    }
+
+    ret = dentryManager_->CreateDentry(dentry);
+    if (ret != MetaStatusCode::OK) {
+        MetaStatusCode ret2 = inodeManager_->DeleteInode(fsId, inodeId);
+        LOG_IF(ERROR, ret2 != MetaStatusCode::OK)
+            << "Remove the inode of dentry not created failed, fsId = "
+            << fsId << ", inodeId = " << inodeId
+            << ", ret = " << MetaStatusCode_Name(ret2);
+        return ret == MetaStatusCode::IDEMPOTENCE_OK
+                   ? MetaStatusCode::DENTRY_EXIST
+                   : ret;
+    }
+
+    ret = inodeManager_->UpdateInodeWhenCreateOrRemoveSubNode(
+        fsId, parentInodeId, true);
+    if (ret == MetaStatusCode::OK && request.has_requestid()) {
+        RecordCreatedInode(request.requestid(), inodeId);
+    }
+    return ret;
+}
+
+bool Partition::GetCreatedInode(const CreateInodeAndDentryRequest& request,
+                                Inode* inode) {
+    if (!request.has_requestid()) {
+        return false;
+    }
+
+    uint64_t inodeId = 0;
+    {
+        std::lock_guard<std::mutex> lk(createdMtx_);
+        auto iter = createdInodes_.find(request.requestid());
+        if (iter == createdInodes_.end()) {
+            return false;
+        }
+        inodeId = iter->second;
+    }
+
+    // the dentry may be removed or renamed after it's created
+    Dentry dentry;
+    dentry.set_fsid(request.fsid());
+    dentry.set_parentinodeid(request.parentinodeid());
+    dentry.set_name(request.name());
+    dentry.set_txid(request.txid());
+    if (dentryManager_->GetDentry(&dentry) != MetaStatusCode::OK ||
+        dentry.inodeid() != inodeId) {
+        return false;
+    }
+
+    if (inodeManager_->GetInode(request.fsid(), inodeId, inode) !=
+            MetaStatusCode::OK ||
+        inode->type() != request.type()) {
+        return false;
+    }
+
+    LOG(INFO) << "CreateInodeAndDentry is retried, fsId = " << request.fsid()
+              << ", parent = " << request.parentinodeid()
+              << ", name = " << request.name() << ", inodeId = " << inodeId
+              << ", requestId = " << request.requestid();
+    return true;
+}
+
+void Partition::RecordCreatedInode(uint64_t requestId, uint64_t inodeId) {
+    // retries come soon after the request, so only the recent ones are kept
+    static constexpr size_t kMaxCreatedRecords = 4096;
+
+    std::lock_guard<std::mutex> lk(createdMtx_);
+    if (!createdInodes_.emplace(requestId, inodeId).second) {
+        return;
+    }
+    createdRequests_.push_back(requestId);
+    if (createdRequests_.size() > kMaxCreatedRecords) {
+        createdInodes_.erase(createdRequests_.front());
+        createdRequests_.pop_front();
+    }
+}
+
+MetaStatusCode Partition::UnlinkDentryAndDecNlink(const Dentry& dentry) {
+    if (!IsInodeBelongs(dentry.fsid(), dentry.parentinodeid()) ||
+        !IsInodeBelongs(dentry.fsid(), dentry.inodeid())) {
+        return MetaStatusCode::PARTITION_ID_MISSMATCH;
+    }
+
+    if (GetStatus() == PartitionStatus::DELETING) {
+        return MetaStatusCode::PARTITION_DELETING;
+    }
+
+    Dentry current = dentry;
+    MetaStatusCode ret = dentryManager_->GetDentry(&current);
+    if (ret != MetaStatusCode::OK) {
+        return ret;
+    }
+    if (current.inodeid() != dentry.inodeid()) {
+        // changed (e.g. renamed) since the client got it
+        return MetaStatusCode::PARAM_ERROR;
+    }
+
+    ret = DeleteDentry(dentry);
+    if (ret != MetaStatusCode::OK) {
+        return ret;
+    }
+
+    return inodeManager_->UnlinkInode(dentry.fsid(), dentry.inodeid());
+}
+
 // inode
 MetaStatusCode Partition::CreateInode(uint32_t fsId, uint64_t length,
                                       uint32_t uid, uint32_t gid, uint32_t mode,
@@ -188,7 +380,21 @@ MetaStatusCode Partition::CreateInode(uint32_t fsId, uint64_t length,
         return MetaStatusCode::PARTITION_DELETING;
     }
 
-    uint64_t inodeId = GetNewInodeId();
+    return CreateInode(fsId, GetNewInodeId(), length, uid, gid, mode, type,
+                       symlink, rdev, 0, inode);
+}
+
+MetaStatusCode Partition::CreateInode(uint32_t fsId, uint64_t inodeId,
+                                      uint64_t length, uint32_t uid,
+                                      uint32_t gid, uint32_t mode,
+                                      FsFileType type,
+                                      const std::string& symlink,
+                                      uint64_t rdev, uint64_t parent,
+                                      Inode* inode) {
+    if (GetStatus() == PartitionStatus::DELETING) {
+        return MetaStatusCode::PARTITION_DELETING;
+    }
+
     if (inodeId == UINT64_MAX) {
         return MetaStatusCode::PARTITION_ALLOC_ID_FAIL;
     }
@@ -198,7 +404,7 @@ MetaStatusCode Partition::CreateInode(uint32_t fsId, uint64_t length,
     }
 
     return inodeManager_->CreateInode(fsId, inodeId, length, uid, gid, mode,
-                                      type, symlink, rdev, inode);
+                                      type, symlink, rdev, parent, inode);
 }
 
 MetaStatusCode Partition::CreateRootInode(uint32_t fsId, uint32_t uid,
@@ -223,6 +429,15 @@ MetaStatusCode Partition::GetInode(uint32_t fsId, uint64_t inodeId,
     return inodeManager_->GetInode(fsId, inodeId, inode);
 }
 
+MetaStatusCode Partition::GetInodeAttr(uint32_t fsId, uint64_t inodeId,
+                                       InodeAttr* attr) {
+    if (!IsInodeBelongs(fsId, inodeId)) {
+        return MetaStatusCode::PARTITION_ID_MISSMATCH;
+    }
+
+    return inodeManager_->GetInodeAttr(fsId, inodeId, attr);
+}
+
 MetaStatusCode Partition::DeleteInode(uint32_t fsId, uint64_t inodeId) {
     if (!IsInodeBelongs(fsId, inodeId)) {
         return MetaStatusCode::PARTITION_ID_MISSMATCH;
@@ -243,6 +458,138 @@ MetaStatusCode Partition::UpdateInode(const UpdateInodeRequest& request) {
     return inodeManager_->UpdateInode(request);
 }
 
+MetaStatusCode Partition::BatchUpdateInode(
+    const BatchUpdateInodeRequest& request,
+    std::set<uint64_t>* failedInodeIds) {
+    uint32_t fsId = request.fsid();
+    for (const auto& update : request.updateinode()) {
+        if (!IsInodeBelongs(update.fsid(), update.inodeid())) {
+            return MetaStatusCode::PARTITION_ID_MISSMATCH;
+        }
+    }
+    for (const auto& item : request.s3chunkinfoadd()) {
+        if (!IsInodeBelongs(fsId, item.inodeid())) {
+            return MetaStatusCode::PARTITION_ID_MISSMATCH;
+        }
+    }
+
+    if (GetStatus() == PartitionStatus::DELETING) {
+        return MetaStatusCode::PARTITION_DELETING;
+    }
+
+    MetaStatusCode status = MetaStatusCode::OK;
+    auto record = [&status, failedInodeIds](uint64_t inodeId,
+                                             MetaStatusCode ret) {
+        if (ret == MetaStatusCode::OK || ret == MetaStatusCode::NOT_FOUND) {
+            return;
+        }
+        failedInodeIds->insert(inodeId);
+        if (status == MetaStatusCode::OK) {
+            status = ret;
+        }
+    };
+
+    for (const auto& update : request.updateinode()) {
+        record(update.inodeid(), inodeManager_->UpdateInode(update));
+    }
+
+    google::protobuf::Map<uint64_t, S3ChunkInfoList> emptyRemove;
+    for (const auto& item : request.s3chunkinfoadd()) {
+        record(item.inodeid(),
+               inodeManager_->GetOrModifyS3ChunkInfo(
+                   fsId, item.inodeid(), item.s3chunkinfoadd(), emptyRemove,
+                   false, nullptr, false));
+    }
+    return status;
+}
+
+MetaStatusCode Partition::UpdateDirStat(const UpdateDirStatRequest& request,
+                                        uint64_t* parent, DirStat* stat) {
+    if (!IsInodeBelongs(request.fsid(), request.inodeid())) {
+        return MetaStatusCode::PARTITION_ID_MISSMATCH;
+    }
+
+    if (GetStatus() == PartitionStatus::DELETING) {
+        return MetaStatusCode::PARTITION_DELETING;
+    }
+
+    if (!request.has_requestid() || !request.has_delta()) {
+        return inodeManager_->UpdateDirStat(request, parent, stat);
+    }
+
+    if (IsDirStatApplied(request.requestid())) {
+        // a retry, the delta is added already
+        LOG(INFO) << "UpdateDirStat is retried, fsId = " << request.fsid()
+                  << ", inodeId = " << request.inodeid()
+                  << ", requestId = " << request.requestid();
+        UpdateDirStatRequest retry(request);
+        retry.clear_delta();
+        return inodeManager_->UpdateDirStat(retry, parent, stat);
+    }
+
+    MetaStatusCode ret = inodeManager_->UpdateDirStat(request, parent, stat);
+    if (ret == MetaStatusCode::OK) {
+        RecordDirStatApplied(request.requestid());
+    }
+    return ret;
+}
+
+bool Partition::IsDirStatApplied(uint64_t requestId) {
+    std::lock_guard<std::mutex> lk(dirStatMtx_);
+    return dirStatRequestIds_.count(requestId) != 0;
+}
+
+void Partition::RecordDirStatApplied(uint64_t requestId) {
+    // each flush of every client sends one delta per directory, so more
+    // are kept than the created inodes
+    static constexpr size_t kMaxDirStatRecords = 65536;
+
+    std::lock_guard<std::mutex> lk(dirStatMtx_);
+    if (!dirStatRequestIds_.insert(requestId).second) {
+        return;
+    }
+    dirStatRequests_.push_back(requestId);
+    if (dirStatRequests_.size() > kMaxDirStatRecords) {
+        dirStatRequestIds_.erase(dirStatRequests_.front());
+        dirStatRequests_.pop_front();
+    }
+}
+
+void Partition::GetAppliedRequests(AppliedRequests* requests) {
+    {
+        std::lock_guard<std::mutex> lk(createdMtx_);
+        for (auto requestId : createdRequests_) {
+            requests->add_createrequestids(requestId);
+            requests->add_createdinodeids(createdInodes_[requestId]);
+        }
+    }
+
+    std::lock_guard<std::mutex> lk(dirStatMtx_);
+    *requests->mutable_dirstatrequestids() = {dirStatRequests_.begin(),
+                                              dirStatRequests_.end()};
+}
+
+void Partition::SetAppliedRequests(const AppliedRequests& requests) {
+    {
+        std::lock_guard<std::mutex> lk(createdMtx_);
+        createdInodes_.clear();
+        createdRequests_.clear();
+        int size = std::min(requests.createrequestids_size(),
+                            requests.createdinodeids_size());
+        for (int i = 0; i < size; i++) {
+            createdInodes_.emplace(requests.createrequestids(i),
+                                   requests.createdinodeids(i));
+            createdRequests_.push_back(requests.createrequestids(i));
+        }
+    }
+
+    std::lock_guard<std::mutex> lk(dirStatMtx_);
+    dirStatRequestIds_ = {requests.dirstatrequestids().begin(),
+                          requests.dirstatrequestids().end()};
+    dirStatRequests_ = {requests.dirstatrequestids().begin(),
+                        requests.dirstatrequestids().end()};
+}
+
 MetaStatusCode Partition::GetOrModifyS3ChunkInfo(
     uint32_t fsId, uint64_t inodeId,
     const google::protobuf::Map<uint64_t, S3ChunkInfoList>& s3ChunkInfoAdd,
@@ -271,6 +618,17 @@ MetaStatusCode Partition::InsertInode(const Inode& inode) {
     return inodeManager_->InsertInode(inode);
 }
 
+MetaStatusCode Partition::InsertS3ChunkInfoList(
+    const InodeS3ChunkInfoList& list) {
+    if (!IsInodeBelongs(list.fsid(), list.inodeid())) {
+        return MetaStatusCode::PARTITION_ID_MISSMATCH;
+    }
+
+    return inodeStorage_->UpdateS3ChunkInfoList(
+        InodeKey(list.fsid(), list.inodeid()), list.chunkindex(),
+        list.s3chunkinfolist());
+}
+
 void Partition::GetInodeIdList(std::list<uint64_t>* InodeIdList) {
     inodeManager_->GetInodeIdList(InodeIdList);
 }
@@ -322,12 +680,16 @@ uint32_t Partition::GetPartitionId() { return partitionInfo_.partitionid(); }
 
 PartitionInfo Partition::GetPartitionInfo() { return partitionInfo_; }
 
-InodeStorage::ContainerType* Partition::GetInodeContainer() {
-    return inodeStorage_->GetContainer();
+std::shared_ptr<Iterator> Partition::NewInodeIterator() {
+    return inodeStorage_->NewIterator(partitionInfo_.partitionid());
+}
+
+std::shared_ptr<Iterator> Partition::NewS3ChunkInfoIterator() {
+    return inodeStorage_->NewS3ChunkInfoIterator(partitionInfo_.partitionid());
 }
 
-DentryStorage::ContainerType* Partition::GetDentryContainer() {
-    return dentryStorage_->GetContainer();
+std::shared_ptr<Iterator> Partition::NewDentryIterator() {
+    return dentryStorage_->NewIterator(partitionInfo_.partitionid());
 }
 
 uint64_t Partition::GetNewInodeId() {
@@ -347,5 +709,64 @@ uint32_t Partition::GetInodeNum() {
 uint32_t Partition::GetDentryNum() {
     return dentryStorage_->Size();
 }
+
+MetaStatusCode Partition::TakeChanges(InodeChanges* inodeChanges,
+                                      DentryChanges* dentryChanges) {
+    // take both, so the changes are always cleared
+    auto rc = inodeStorage_->TakeChanges(inodeChanges);
+    auto rc2 = dentryStorage_->TakeChanges(dentryChanges);
+    return rc != MetaStatusCode::OK ? rc : rc2;
+}
+
+void Partition::ClearChanges() {
+    inodeStorage_->ClearChanges();
+    dentryStorage_->ClearChanges();
+}
+
+MetaStatusCode Partition::UpsertInode(const Inode& inode) {
+    if (!IsInodeBelongs(inode.fsid(), inode.inodeid())) {
+        return MetaStatusCode::PARTITION_ID_MISSMATCH;
+    }
+
+    return inodeManager_->UpsertInode(inode);
+}
+
+MetaStatusCode Partition::UpsertDentry(const Dentry& dentry) {
+    if (!IsInodeBelongs(dentry.fsid(), dentry.parentinodeid())) {
+        return MetaStatusCode::PARTITION_ID_MISSMATCH;
+    }
+
+    // rollback and prepare remove and put the exact version of dentry
+    auto rc = dentryStorage_->HandleTx(DentryStorage::TX_OP_TYPE::ROLLBACK,
+                                       dentry);
+    if (rc != MetaStatusCode::OK) {
+        return rc;
+    }
+    return dentryStorage_->HandleTx(DentryStorage::TX_OP_TYPE::PREPARE,
+                                    dentry);
+}
+
+MetaStatusCode Partition::RemoveEntries(const RemovedEntries& entries) {
+    if (entries.fsids_size() != entries.inodeids_size()) {
+        return MetaStatusCode::PARAM_ERROR;
+    }
+
+    for (int i = 0; i < entries.inodeids_size(); i++) {
+        auto rc = inodeStorage_->Delete(
+            InodeKey(entries.fsids(i), entries.inodeids(i)));
+        if (rc != MetaStatusCode::OK && rc != MetaStatusCode::NOT_FOUND) {
+            return rc;
+        }
+    }
+
+    for (const auto& dentry : entries.dentrys()) {
+        auto rc = dentryStorage_->HandleTx(
+            DentryStorage::TX_OP_TYPE::ROLLBACK, dentry);
+        if (rc != MetaStatusCode::OK) {
+            return rc;
+        }
+    }
+    return MetaStatusCode::OK;
+}
 }  // namespace metaserver
 }  // namespace curvefs
@@ -22,10 +22,14 @@
 
 #ifndef CURVEFS_SRC_METASERVER_PARTITION_H_
 #define CURVEFS_SRC_METASERVER_PARTITION_H_
+#include <deque>
 #include <list>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <set>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include "curvefs/proto/common.pb.h"
 #include "curvefs/src/common/define.h"
@@ -33,6 +37,8 @@
 #include "curvefs/src/metaserver/dentry_storage.h"
 #include "curvefs/src/metaserver/inode_manager.h"
 #include "curvefs/src/metaserver/inode_storage.h"
+#include "curvefs/src/metaserver/iterator.h"
+#include "curvefs/src/metaserver/kv_storage.h"
 #include "curvefs/src/metaserver/s3compact.h"
 #include "curvefs/src/metaserver/trash_manager.h"
 namespace curvefs {
@@ -66,19 +72,51 @@ class Partition {
 
     bool FindPendingTx(PrepareRenameTxRequest* pendingTx);
 
+    void ClearPendingTx();
+
+    // create the inode with the reserved id and its dentry under parent,
+    // the inode is removed if the dentry can't be created, a retry of the
+    // request which has succeeded gets the inode created by it
+    MetaStatusCode CreateInodeAndDentry(
+        const CreateInodeAndDentryRequest& request, uint64_t inodeId,
+        Inode* inode);
+
+    // delete the dentry and decrease the nlink of its inode, fail without
+    // any change if the dentry doesn't point to dentry.inodeid()
+    MetaStatusCode UnlinkDentryAndDecNlink(const Dentry& dentry);
+
     // inode
     MetaStatusCode CreateInode(uint32_t fsId, uint64_t length, uint32_t uid,
                                uint32_t gid, uint32_t mode, FsFileType type,
                                const std::string& symlink, uint64_t rdev,
                                Inode* inode);
+    // create the inode with the id got by GetNewInodeId() before, so the
+    // inodes can be created concurrently
+    MetaStatusCode CreateInode(uint32_t fsId, uint64_t inodeId,
+                               uint64_t length, uint32_t uid, uint32_t gid,
+                               uint32_t mode, FsFileType type,
+                               const std::string& symlink, uint64_t rdev,
+                               uint64_t parent, Inode* inode);
     MetaStatusCode CreateRootInode(uint32_t fsId, uint32_t uid, uint32_t gid,
                                    uint32_t mode);
     MetaStatusCode GetInode(uint32_t fsId, uint64_t inodeId, Inode* inode);
 
+    MetaStatusCode GetInodeAttr(uint32_t fsId, uint64_t inodeId,
+                                InodeAttr* attr);
+
     MetaStatusCode DeleteInode(uint32_t fsId, uint64_t inodeId);
 
     MetaStatusCode UpdateInode(const UpdateInodeRequest& request);
 
+    // apply all updates even if some of them failed, inodes that
+    // do not exist are skipped, return the first failure if any
+    // the inodes failed to update are added to `failedInodeIds`
+    MetaStatusCode BatchUpdateInode(const BatchUpdateInodeRequest& request,
+                                    std::set<uint64_t>* failedInodeIds);
+
+    MetaStatusCode UpdateDirStat(const UpdateDirStatRequest& request,
+                                 uint64_t* parent, DirStat* stat);
+
     MetaStatusCode GetOrModifyS3ChunkInfo(
         uint32_t fsId, uint64_t inodeId,
         const google::protobuf::Map<uint64_t, S3ChunkInfoList>& s3ChunkInfoAdd,
@@ -90,6 +128,8 @@ class Partition {
 
     MetaStatusCode InsertInode(const Inode& inode);
 
+    MetaStatusCode InsertS3ChunkInfoList(const InodeS3ChunkInfoList& list);
+
     void GetInodeIdList(std::list<uint64_t>* InodeIdList);
 
     // if patition has no inode or no dentry, it is deletable
@@ -111,9 +151,11 @@ class Partition {
 
     PartitionInfo GetPartitionInfo();
 
-    InodeStorage::ContainerType* GetInodeContainer();
+    std::shared_ptr<Iterator> NewInodeIterator();
+
+    std::shared_ptr<Iterator> NewS3ChunkInfoIterator();
 
-    DentryStorage::ContainerType* GetDentryContainer();
+    std::shared_ptr<Iterator> NewDentryIterator();
 
     // get new inode id in partition range.
     // if no available inode id in this partiton ,return UINT64_MAX
@@ -129,8 +171,47 @@ class Partition {
 
     PartitionStatus GetStatus() { return partitionInfo_.status(); }
 
+    void SetNextId(uint64_t nextId) { partitionInfo_.set_nextid(nextId); }
+
     void ClearS3Compact() { s3compact_ = nullptr; }
 
+    // incremental snapshot, see MetaStoreImpl::Save()
+    // take the entries changed since the last snapshot
+    MetaStatusCode TakeChanges(InodeChanges* inodeChanges,
+                               DentryChanges* dentryChanges);
+
+    void ClearChanges();
+
+    // apply the entries of a delta, the entries in the delta replace
+    // the ones in partition as a whole
+    MetaStatusCode UpsertInode(const Inode& inode);
+
+    MetaStatusCode UpsertDentry(const Dentry& dentry);
+
+    MetaStatusCode RemoveEntries(const RemovedEntries& entries);
+
+    // the recent requests recorded for deduplicating the retries, they are
+    // saved with the partition in every raft snapshot
+    void GetAppliedRequests(AppliedRequests* requests);
+
+    // replace the records with the ones loaded from snapshot
+    void SetAppliedRequests(const AppliedRequests& requests);
+
+ private:
+    // keep inodes and dentrys in leveldb if it's enabled, else in memory
+    void InitStorage(uint32_t partitionId);
+
+    // get the inode created by the request before if it's a retry
+    bool GetCreatedInode(const CreateInodeAndDentryRequest& request,
+                         Inode* inode);
+
+    void RecordCreatedInode(uint64_t requestId, uint64_t inodeId);
+
+    // whether the dir stat delta of the request is applied before
+    bool IsDirStatApplied(uint64_t requestId);
+
+    void RecordDirStatApplied(uint64_t requestId);
+
  private:
     std::shared_ptr<InodeStorage> inodeStorage_;
     std::shared_ptr<DentryStorage> dentryStorage_;
@@ -141,6 +222,17 @@ class Partition {
 
     PartitionInfo partitionInfo_;
     std::shared_ptr<S3Compact> s3compact_;
+
+    // inodes created by the recent CreateInodeAndDentry requests, keyed by
+    // request id
+    std::mutex createdMtx_;
+    std::unordered_map<uint64_t, uint64_t> createdInodes_;
+    std::deque<uint64_t> createdRequests_;
+
+    // the recent dir stat deltas applied
+    std::mutex dirStatMtx_;
+    std::unordered_set<uint64_t> dirStatRequestIds_;
+    std::deque<uint64_t> dirStatRequests_;
 };
 }  // namespace metaserver
 }  // namespace curvefs
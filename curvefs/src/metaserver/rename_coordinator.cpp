@@ -0,0 +1,539 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2022-06-20
+ * Author: chenwei
+ */
+
+#include "curvefs/src/metaserver/rename_coordinator.h"
+
+#include <brpc/channel.h>
+#include <brpc/controller.h>
+#include <bthread/bthread.h>
+#include <bthread/countdown_event.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <functional>
+
+#include "curvefs/src/metaserver/copyset/meta_operator.h"
+#include "src/common/string_util.h"
+
+namespace curvefs {
+namespace metaserver {
+
+using ::curvefs::mds::topology::CommitTxRequest;
+using ::curvefs::mds::topology::CommitTxResponse;
+using ::curvefs::mds::topology::ListPartitionRequest;
+using ::curvefs::mds::topology::ListPartitionResponse;
+using ::curvefs::mds::topology::TopologyService_Stub;
+using ::curvefs::mds::topology::TopoStatusCode;
+using ::curvefs::metaserver::copyset::PrepareRenameTxOperator;
+
+namespace {
+
+// closure for proposing to local raft, simply wait
+class PrepareRenameTxClosure : public google::protobuf::Closure {
+ public:
+    void Run() override {
+        event_.signal();
+    }
+
+    void Wait() {
+        event_.wait();
+    }
+
+ private:
+    bthread::CountdownEvent event_;
+};
+
+struct PrepareRemoteArg {
+    std::function<MetaStatusCode()> prepare;
+    MetaStatusCode rc = MetaStatusCode::OK;
+};
+
+void* RunPrepareRemote(void* arg) {
+    auto* prepareArg = static_cast<PrepareRemoteArg*>(arg);
+    prepareArg->rc = prepareArg->prepare();
+    return nullptr;
+}
+
+struct BatchArg {
+    RenameCoordinator* coordinator;
+    std::function<void()> run;
+};
+
+bool SameDentry(const Dentry& lhs, const Dentry& rhs) {
+    return lhs.parentinodeid() == rhs.parentinodeid() &&
+           lhs.name() == rhs.name();
+}
+
+bool Conflict(const RenameRequest& lhs, const RenameRequest& rhs) {
+    return SameDentry(lhs.dentry(), rhs.dentry()) ||
+           SameDentry(lhs.dentry(), rhs.newdentry()) ||
+           SameDentry(lhs.newdentry(), rhs.dentry()) ||
+           SameDentry(lhs.newdentry(), rhs.newdentry());
+}
+
+}  // namespace
+
+void RenameCoordinatorOption::InitRenameCoordinatorOptionFromConf(
+    std::shared_ptr<Configuration> conf) {
+    std::string mdsAddrsStr;
+    conf->GetValueFatalIfFail("mds.listen.addr", &mdsAddrsStr);
+    ::curve::common::SplitString(mdsAddrsStr, ",", &mdsAddrs);
+    conf->GetValueFatalIfFail("renameTx.maxBatchSize", &maxBatchSize);
+    conf->GetValueFatalIfFail("renameTx.rpcTimeoutMs", &rpcTimeoutMs);
+    conf->GetValueFatalIfFail("renameTx.rpcRetryIntervalMs",
+                              &rpcRetryIntervalMs);
+    conf->GetValueFatalIfFail("renameTx.mdsMaxRetryTimes",
+                              &mdsMaxRetryTimes);
+}
+
+RenameCoordinator::~RenameCoordinator() {
+    std::unique_lock<std::mutex> lk(mtx_);
+    cond_.wait(lk, [this]() { return runningBatches_ == 0; });
+}
+
+void RenameCoordinator::Rename(const RenameRequest* request,
+                               RenameResponse* response,
+                               google::protobuf::Closure* done) {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        tasks_.push_back(RenameTask{request, response, done});
+    }
+    Schedule();
+}
+
+// the batch which finishes schedules the renames queued meanwhile,
+// so no rename is left behind when the partitions are free
+void RenameCoordinator::Schedule() {
+    while (true) {
+        Batch batch;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            if (!TakeBatch(&batch)) {
+                return;
+            }
+            runningBatches_++;
+        }
+
+        auto* arg = new BatchArg();
+        arg->coordinator = this;
+        arg->run = [this, batch]() {
+            RunBatch(batch);
+
+            std::lock_guard<std::mutex> lk(mtx_);
+            busyPartitions_.erase(batch[0].request->partitionid());
+            busyPartitions_.erase(batch[0].request->dstpartitionid());
+        };
+
+        bthread_t tid;
+        if (bthread_start_background(&tid, nullptr, RunBatchInBackground,
+                                     arg) != 0) {
+            LOG(WARNING) << "Start bthread for rename batch failed";
+            RunBatchInBackground(arg);
+        }
+    }
+}
+
+void* RenameCoordinator::RunBatchInBackground(void* arg) {
+    std::unique_ptr<BatchArg> batchArg(static_cast<BatchArg*>(arg));
+    auto* coordinator = batchArg->coordinator;
+    batchArg->run();
+    coordinator->Schedule();
+
+    std::lock_guard<std::mutex> lk(coordinator->mtx_);
+    coordinator->runningBatches_--;
+    coordinator->cond_.notify_all();
+    return nullptr;
+}
+
+bool RenameCoordinator::TakeBatch(Batch* batch) {
+    auto iter = tasks_.begin();
+    for (; iter != tasks_.end(); ++iter) {
+        if (busyPartitions_.count(iter->request->partitionid()) == 0 &&
+            busyPartitions_.count(iter->request->dstpartitionid()) == 0) {
+            break;
+        }
+    }
+    if (iter == tasks_.end()) {
+        return false;
+    }
+
+    auto srcPartitionId = iter->request->partitionid();
+    auto dstPartitionId = iter->request->dstpartitionid();
+    batch->push_back(*iter);
+    iter = tasks_.erase(iter);
+
+    while (iter != tasks_.end() && batch->size() < option_.maxBatchSize) {
+        const auto* request = iter->request;
+        bool joinable = request->partitionid() == srcPartitionId &&
+                        request->dstpartitionid() == dstPartitionId &&
+                        std::none_of(batch->begin(), batch->end(),
+                                     [request](const RenameTask& task) {
+                                         return Conflict(*task.request,
+                                                         *request);
+                                     });
+        if (joinable) {
+            batch->push_back(*iter);
+            iter = tasks_.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+
+    busyPartitions_.insert(srcPartitionId);
+    busyPartitions_.insert(dstPartitionId);
+    return true;
+}
+
+uint64_t RenameCoordinator::NextTxId(uint32_t partitionId,
+                                     uint64_t knownTxId) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto iter = txIds_.find(partitionId);
+    if (iter != txIds_.end()) {
+        knownTxId = std::max(knownTxId, iter->second);
+    }
+    return knownTxId + 1;
+}
+
+bool RenameCoordinator::RefreshStaleTxIds(
+    uint32_t fsId, const std::vector<uint32_t>& partitionIds) {
+    for (auto partitionId : partitionIds) {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            if (staleTxIds_.count(partitionId) == 0) {
+                continue;
+            }
+        }
+
+        uint64_t txId = 0;
+        if (!RefreshTxId(fsId, partitionId, &txId)) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lk(mtx_);
+        staleTxIds_.erase(partitionId);
+        txIds_[partitionId] = txId;
+    }
+    return true;
+}
+
+void RenameCoordinator::RunBatch(const Batch& batch) {
+    const auto& first = *batch[0].request;
+    bool samePartition = first.partitionid() == first.dstpartitionid();
+
+    // the txids known by the clients may be older than the one whose
+    // commit is unknown, preparing with them rolls back a committed one
+    if (!RefreshStaleTxIds(first.dentry().fsid(),
+                           {first.partitionid(), first.dstpartitionid()})) {
+        LOG(WARNING) << "Refresh txid from mds failed"
+                     << ", srcPartitionId = " << first.partitionid()
+                     << ", dstPartitionId = " << first.dstpartitionid();
+        FinishBatch(batch, MetaStatusCode::TX_COMMIT_UNKNOWN, 0, 0, 0);
+        return;
+    }
+
+    uint64_t knownTxId = 0;
+    uint64_t knownDstTxId = 0;
+    for (const auto& task : batch) {
+        knownTxId = std::max(knownTxId, task.request->dentry().txid());
+        knownDstTxId = std::max(knownDstTxId,
+                                task.request->newdentry().txid());
+    }
+
+    uint64_t txId, dstTxId;
+    if (samePartition) {
+        txId = NextTxId(first.partitionid(),
+                        std::max(knownTxId, knownDstTxId));
+        dstTxId = txId;
+    } else {
+        txId = NextTxId(first.partitionid(), knownTxId);
+        dstTxId = NextTxId(first.dstpartitionid(), knownDstTxId);
+    }
+
+    PrepareRenameTxRequest srcRequest;
+    srcRequest.set_poolid(first.poolid());
+    srcRequest.set_copysetid(first.copysetid());
+    srcRequest.set_partitionid(first.partitionid());
+    PrepareRenameTxRequest dstRequest;
+    dstRequest.set_poolid(first.dstpoolid());
+    dstRequest.set_copysetid(first.dstcopysetid());
+    dstRequest.set_partitionid(first.dstpartitionid());
+
+    for (const auto& task : batch) {
+        auto* dentry = srcRequest.add_dentrys();
+        *dentry = task.request->dentry();
+        dentry->set_txid(txId);
+        dentry->set_flag(dentry->flag() |
+                         DentryFlag::DELETE_MARK_FLAG |
+                         DentryFlag::TRANSACTION_PREPARE_FLAG);
+
+        auto* newDentry = samePartition ? srcRequest.add_dentrys()
+                                        : dstRequest.add_dentrys();
+        *newDentry = task.request->newdentry();
+        newDentry->set_txid(dstTxId);
+        newDentry->set_flag(newDentry->flag() |
+                            DentryFlag::TRANSACTION_PREPARE_FLAG);
+    }
+
+    // prepare on both partitions in parallel, the one prepared is
+    // rolled back by the next transaction with the same txid if the
+    // other one failed
+    PrepareRemoteArg remoteArg;
+    bthread_t tid;
+    bool remoteStarted = false;
+    if (!samePartition) {
+        remoteArg.prepare = [&]() {
+            return PrepareRemote(first.dstleaderaddr(), dstRequest);
+        };
+        remoteStarted = bthread_start_background(&tid, nullptr,
+                                                 RunPrepareRemote,
+                                                 &remoteArg) == 0;
+        if (!remoteStarted) {
+            RunPrepareRemote(&remoteArg);
+        }
+    }
+
+    uint64_t appliedIndex = 0;
+    auto rc = PrepareLocal(srcRequest, &appliedIndex);
+    if (remoteStarted) {
+        bthread_join(tid, nullptr);
+    }
+    if (rc == MetaStatusCode::OK && remoteArg.rc != MetaStatusCode::OK) {
+        LOG(WARNING) << "Prepare rename tx on " << first.dstleaderaddr()
+                     << " failed, retCode = "
+                     << MetaStatusCode_Name(remoteArg.rc);
+        // not REDIRECTED and so on, which make the client retry with
+        // the leader of source partition, the client falls back to
+        // prepare on destination partition by itself instead
+        rc = MetaStatusCode::RPC_ERROR;
+    }
+    if (rc != MetaStatusCode::OK) {
+        LOG(WARNING) << "Prepare rename tx failed, retCode = "
+                     << MetaStatusCode_Name(rc)
+                     << ", srcPartitionId = " << first.partitionid()
+                     << ", dstPartitionId = " << first.dstpartitionid()
+                     << ", batch size = " << batch.size();
+        FinishBatch(batch, rc, 0, 0, 0);
+        return;
+    }
+
+    std::vector<PartitionTxId> txIds;
+    PartitionTxId partitionTxId;
+    partitionTxId.set_partitionid(first.partitionid());
+    partitionTxId.set_txid(txId);
+    txIds.push_back(partitionTxId);
+    if (!samePartition) {
+        partitionTxId.set_partitionid(first.dstpartitionid());
+        partitionTxId.set_txid(dstTxId);
+        txIds.push_back(partitionTxId);
+    }
+
+    rc = CommitTx(txIds);
+    if (rc == MetaStatusCode::TX_COMMIT_UNKNOWN) {
+        // the txids tried are returned, so the clients can tell whether
+        // the renames are committed by the txids on mds
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            txIds_.erase(first.partitionid());
+            txIds_.erase(first.dstpartitionid());
+            staleTxIds_.insert(first.partitionid());
+            staleTxIds_.insert(first.dstpartitionid());
+        }
+        FinishBatch(batch, rc, txId, dstTxId, 0);
+        return;
+    } else if (rc != MetaStatusCode::OK) {
+        FinishBatch(batch, rc, 0, 0, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        txIds_[first.partitionid()] = txId;
+        txIds_[first.dstpartitionid()] = dstTxId;
+    }
+    FinishBatch(batch, MetaStatusCode::OK, txId, dstTxId, appliedIndex);
+}
+
+void RenameCoordinator::FinishBatch(const Batch& batch, MetaStatusCode rc,
+                                    uint64_t txId, uint64_t dstTxId,
+                                    uint64_t appliedIndex) {
+    for (const auto& task : batch) {
+        task.response->set_statuscode(rc);
+        if (txId != 0) {
+            task.response->set_txid(txId);
+            task.response->set_dsttxid(dstTxId);
+        }
+        if (rc == MetaStatusCode::OK) {
+            task.response->set_appliedindex(appliedIndex);
+        }
+        task.done->Run();
+    }
+}
+
+MetaStatusCode RenameCoordinator::PrepareLocal(
+    const PrepareRenameTxRequest& request, uint64_t* appliedIndex) {
+    auto* node = copysetNodeManager_->GetCopysetNode(request.poolid(),
+                                                     request.copysetid());
+    if (node == nullptr) {
+        LOG(WARNING) << "Copyset not found, poolId = " << request.poolid()
+                     << ", copysetId = " << request.copysetid();
+        return MetaStatusCode::COPYSET_NOTEXIST;
+    }
+
+    PrepareRenameTxResponse response;
+    PrepareRenameTxClosure done;
+    auto* op = new PrepareRenameTxOperator(node, nullptr, &request, &response,
+                                           &done);
+    op->Propose();
+    done.Wait();
+
+    *appliedIndex = response.appliedindex();
+    return response.statuscode();
+}
+
+MetaStatusCode RenameCoordinator::PrepareRemote(
+    const std::string& leaderAddr, const PrepareRenameTxRequest& request) {
+    brpc::Channel channel;
+    if (channel.Init(leaderAddr.c_str(), nullptr) != 0) {
+        LOG(WARNING) << "Init channel to " << leaderAddr << " failed";
+        return MetaStatusCode::RPC_ERROR;
+    }
+
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(option_.rpcTimeoutMs);
+    PrepareRenameTxResponse response;
+    MetaServerService_Stub stub(&channel);
+    stub.PrepareRenameTx(&cntl, &request, &response, nullptr);
+    if (cntl.Failed()) {
+        LOG(WARNING) << "PrepareRenameTx to " << leaderAddr
+                     << " failed, errorCode = " << cntl.ErrorCode()
+                     << ", errorText = " << cntl.ErrorText();
+        return MetaStatusCode::RPC_ERROR;
+    }
+    return response.statuscode();
+}
+
+bool RenameCoordinator::CallMds(
+    const std::function<bool(brpc::Channel*)>& call, bool* sent) {
+    *sent = false;
+    for (uint32_t retry = 0; retry < option_.mdsMaxRetryTimes; retry++) {
+        if (retry > 0) {
+            bthread_usleep(option_.rpcRetryIntervalMs * 1000);
+        }
+
+        std::string mdsAddr;
+        {
+            std::lock_guard<std::mutex> lk(mdsMtx_);
+            mdsAddr = option_.mdsAddrs[mdsIndex_];
+        }
+
+        brpc::Channel channel;
+        if (channel.Init(mdsAddr.c_str(), nullptr) == 0) {
+            *sent = true;
+            if (call(&channel)) {
+                return true;
+            }
+        } else {
+            LOG(WARNING) << "Init channel to mds " << mdsAddr << " failed";
+        }
+
+        std::lock_guard<std::mutex> lk(mdsMtx_);
+        mdsIndex_ = (mdsIndex_ + 1) % option_.mdsAddrs.size();
+    }
+    return false;
+}
+
+MetaStatusCode RenameCoordinator::CommitTx(
+    const std::vector<PartitionTxId>& txIds) {
+    CommitTxRequest request;
+    for (const auto& txId : txIds) {
+        *request.add_partitiontxids() = txId;
+    }
+
+    CommitTxResponse response;
+    bool sent = false;
+    bool succ = CallMds([&](brpc::Channel* channel) {
+        brpc::Controller cntl;
+        cntl.set_timeout_ms(option_.rpcTimeoutMs);
+        TopologyService_Stub stub(channel);
+        stub.CommitTx(&cntl, &request, &response, nullptr);
+        if (cntl.Failed()) {
+            LOG(WARNING) << "CommitTx to mds failed, errorCode = "
+                         << cntl.ErrorCode()
+                         << ", errorText = " << cntl.ErrorText();
+            return false;
+        }
+        return true;
+    }, &sent);
+
+    if (!succ) {
+        LOG(ERROR) << "CommitTx failed after retry, request = "
+                   << request.ShortDebugString();
+        return sent ? MetaStatusCode::TX_COMMIT_UNKNOWN
+                    : MetaStatusCode::RPC_ERROR;
+    } else if (response.statuscode() != TopoStatusCode::TOPO_OK) {
+        LOG(ERROR) << "CommitTx failed, retCode = "
+                   << TopoStatusCode_Name(response.statuscode())
+                   << ", request = " << request.ShortDebugString();
+        return MetaStatusCode::RPC_ERROR;
+    }
+    return MetaStatusCode::OK;
+}
+
+bool RenameCoordinator::RefreshTxId(uint32_t fsId, uint32_t partitionId,
+                                    uint64_t* txId) {
+    ListPartitionRequest request;
+    request.set_fsid(fsId);
+
+    ListPartitionResponse response;
+    bool sent = false;
+    bool succ = CallMds([&](brpc::Channel* channel) {
+        brpc::Controller cntl;
+        cntl.set_timeout_ms(option_.rpcTimeoutMs);
+        TopologyService_Stub stub(channel);
+        stub.ListPartition(&cntl, &request, &response, nullptr);
+        if (cntl.Failed()) {
+            LOG(WARNING) << "ListPartition from mds failed, errorCode = "
+                         << cntl.ErrorCode()
+                         << ", errorText = " << cntl.ErrorText();
+            return false;
+        }
+        return true;
+    }, &sent);
+
+    if (!succ || response.statuscode() != TopoStatusCode::TOPO_OK) {
+        LOG(ERROR) << "ListPartition failed, fsId = " << fsId;
+        return false;
+    }
+
+    for (const auto& info : response.partitioninfolist()) {
+        if (info.partitionid() == partitionId) {
+            *txId = info.txid();
+            return true;
+        }
+    }
+    LOG(ERROR) << "Partition not found in mds, fsId = " << fsId
+               << ", partitionId = " << partitionId;
+    return false;
+}
+
+}  // namespace metaserver
+}  // namespace curvefs
@@ -0,0 +1,176 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2022-06-20
+ * Author: chenwei
+ */
+
+#ifndef CURVEFS_SRC_METASERVER_RENAME_COORDINATOR_H_
+#define CURVEFS_SRC_METASERVER_RENAME_COORDINATOR_H_
+
+#include <google/protobuf/stubs/callback.h>
+
+#include <condition_variable>  // NOLINT
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "curvefs/proto/metaserver.pb.h"
+#include "curvefs/proto/topology.pb.h"
+#include "curvefs/src/metaserver/copyset/copyset_node_manager.h"
+#include "src/common/configuration.h"
+
+namespace brpc {
+class Channel;
+}  // namespace brpc
+
+namespace curvefs {
+namespace metaserver {
+
+using ::curve::common::Configuration;
+using ::curvefs::mds::topology::PartitionTxId;
+using ::curvefs::metaserver::copyset::CopysetNodeManager;
+
+struct RenameCoordinatorOption {
+    std::vector<std::string> mdsAddrs;
+    // max number of renames committed in one transaction
+    uint32_t maxBatchSize;
+    uint32_t rpcTimeoutMs;
+    uint32_t rpcRetryIntervalMs;
+    // max times of trying the rpcs to mds
+    uint32_t mdsMaxRetryTimes;
+
+    RenameCoordinatorOption()
+      : maxBatchSize(32),
+        rpcTimeoutMs(1000),
+        rpcRetryIntervalMs(100),
+        mdsMaxRetryTimes(3) {}
+
+    void InitRenameCoordinatorOptionFromConf(
+        std::shared_ptr<Configuration> conf);
+};
+
+// Run the rename transaction for the clients on the leader of the source
+// partition, instead of letting the client prepare the transaction on both
+// partitions and commit it to mds one rpc after another:
+//   (1) prepare the dentrys of source partition by proposing to local raft
+//       and the ones of destination partition by rpc to its leader,
+//       both in parallel
+//   (2) commit the new txids of both partitions to mds
+//
+// The renames queued from the same source partition to the same destination
+// partition are committed in one transaction if their dentrys are different,
+// and the renames on a busy partition wait until the running transaction is
+// done, because each partition can have only one pending transaction.
+//
+// If the commit to mds times out, the transaction may or may not be
+// committed, the rename fails with TX_COMMIT_UNKNOWN and the txids of the
+// partitions are got from mds again before the next transaction on them.
+class RenameCoordinator {
+ public:
+    RenameCoordinator(CopysetNodeManager* copysetNodeManager,
+                      const RenameCoordinatorOption& option)
+        : copysetNodeManager_(copysetNodeManager), option_(option),
+          runningBatches_(0), mdsIndex_(0) {}
+
+    // wait for the batches running in background
+    virtual ~RenameCoordinator();
+
+    // `done` is run after the rename is committed or failed, the batches
+    // run in background bthreads instead of the caller's
+    void Rename(const RenameRequest* request, RenameResponse* response,
+                google::protobuf::Closure* done);
+
+ protected:
+    struct RenameTask {
+        const RenameRequest* request;
+        RenameResponse* response;
+        google::protobuf::Closure* done;
+    };
+
+    using Batch = std::vector<RenameTask>;
+
+    virtual MetaStatusCode PrepareLocal(const PrepareRenameTxRequest& request,
+                                        uint64_t* appliedIndex);
+
+    virtual MetaStatusCode PrepareRemote(
+        const std::string& leaderAddr, const PrepareRenameTxRequest& request);
+
+    // return OK if committed, RPC_ERROR if not, and TX_COMMIT_UNKNOWN if
+    // the request may have reached mds but no response is received
+    virtual MetaStatusCode CommitTx(const std::vector<PartitionTxId>& txIds);
+
+    // get the txid of the partition committed on mds
+    virtual bool RefreshTxId(uint32_t fsId, uint32_t partitionId,
+                             uint64_t* txId);
+
+ private:
+    // start the runnable batches in background
+    void Schedule();
+
+    static void* RunBatchInBackground(void* arg);
+
+    // take the first runnable rename and the ones can be committed
+    // with it, caller must hold |mtx_|
+    bool TakeBatch(Batch* batch);
+
+    void RunBatch(const Batch& batch);
+
+    // get the txids of the partitions whose last commit is unknown
+    bool RefreshStaleTxIds(uint32_t fsId,
+                           const std::vector<uint32_t>& partitionIds);
+
+    // try |call| on the mds one after another, at most |mdsMaxRetryTimes|
+    // times, |call| returns false if the rpc failed; |sent| is set if
+    // any request may have reached mds
+    bool CallMds(const std::function<bool(brpc::Channel*)>& call,
+                 bool* sent);
+
+    void FinishBatch(const Batch& batch, MetaStatusCode rc, uint64_t txId,
+                     uint64_t dstTxId, uint64_t appliedIndex);
+
+    uint64_t NextTxId(uint32_t partitionId, uint64_t knownTxId);
+
+ private:
+    CopysetNodeManager* copysetNodeManager_;
+    RenameCoordinatorOption option_;
+
+    std::mutex mtx_;
+    std::list<RenameTask> tasks_;
+    // partitions which have a running transaction
+    std::unordered_set<uint32_t> busyPartitions_;
+    // the last txid committed by this coordinator of each partition
+    std::unordered_map<uint32_t, uint64_t> txIds_;
+    // partitions whose last commit is unknown
+    std::unordered_set<uint32_t> staleTxIds_;
+    uint32_t runningBatches_;
+    std::condition_variable cond_;
+
+    std::mutex mdsMtx_;
+    uint64_t mdsIndex_;
+};
+
+}  // namespace metaserver
+}  // namespace curvefs
+
+#endif  // CURVEFS_SRC_METASERVER_RENAME_COORDINATOR_H_
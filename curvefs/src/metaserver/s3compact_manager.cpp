@@ -132,6 +132,11 @@ void S3CompactWorkQueueOption::Init(std::shared_ptr<Configuration> conf) {
     conf->GetValueFatalIfFail("s3compactwq.s3_read_max_retry", &s3ReadMaxRetry);
     conf->GetValueFatalIfFail("s3compactwq.s3_read_retry_interval",
                               &s3ReadRetryInterval);
+    conf->GetValueFatalIfFail("s3compactwq.overlap_ratio_threshold",
+                              &overlapRatioThreshold);
+    conf->GetValueFatalIfFail("s3compactwq.s3_concurrency", &s3Concurrency);
+    conf->GetValueFatalIfFail("s3compactwq.s3_iops_limit", &s3IopsLimit);
+    conf->GetValueFatalIfFail("s3compactwq.s3_bps_limit_mb", &s3BpsLimitMB);
 }
 
 void S3CompactManager::Init(std::shared_ptr<Configuration> conf) {
@@ -80,6 +80,14 @@ struct S3CompactWorkQueueOption {
     uint64_t s3infocacheSize;
     uint64_t s3ReadMaxRetry;
     uint64_t s3ReadRetryInterval;
+    // only the fragments overlapping each other are merged if the ratio
+    // of overwritten bytes among them exceeds it
+    double overlapRatioThreshold;
+    // the objs read and written in parallel by a compaction
+    uint64_t s3Concurrency;
+    // the s3 budget shared by all compactions, 0 means no limit
+    uint64_t s3IopsLimit;
+    uint64_t s3BpsLimitMB;
 
     void Init(std::shared_ptr<Configuration> conf);
 };
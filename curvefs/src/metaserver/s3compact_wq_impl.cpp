@@ -25,7 +25,9 @@
 #include <algorithm>
 #include <deque>
 #include <list>
+#include <map>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -33,8 +35,10 @@
 
 #include "curvefs/src/common/s3util.h"
 #include "curvefs/src/metaserver/copyset/meta_operator.h"
+#include "src/common/concurrent/count_down_event.h"
 
 using curve::common::Configuration;
+using curve::common::CountDownEvent;
 using curve::common::InitS3AdaptorOption;
 using curve::common::S3Adapter;
 using curve::common::S3AdapterOption;
@@ -113,6 +117,7 @@ void S3CompactWorkQueueImpl::DeleteObjs(const std::vector<std::string>& objs,
     for (const auto& obj : objs) {
         VLOG(9) << "s3compact: delete " << obj;
         const Aws::String aws_key(obj.c_str(), obj.size());
+        throttle_.Add(false, 0);
         int ret =
             s3adapter->DeleteObject(aws_key);  // don't care success or not
         if (ret != 0) {
@@ -121,6 +126,82 @@ void S3CompactWorkQueueImpl::DeleteObjs(const std::vector<std::string>& objs,
     }
 }
 
+S3ChunkInfoList S3CompactWorkQueueImpl::PlanCompaction(
+    const S3ChunkInfoList& s3chunkinfolist) {
+    const int size = s3chunkinfolist.s3chunks_size();
+    // group the fragments overlapping each other by sweeping them in
+    // offset order, the data of a group is contiguous
+    std::vector<int> byOffset(size);
+    std::iota(byOffset.begin(), byOffset.end(), 0);
+    std::stable_sort(byOffset.begin(), byOffset.end(), [&](int a, int b) {
+        return s3chunkinfolist.s3chunks(a).offset() <
+               s3chunkinfolist.s3chunks(b).offset();
+    });
+    struct Group {
+        uint64_t begin = 0;  // the group covers [begin, end)
+        uint64_t end = 0;
+        uint64_t bytes = 0;  // total len of the fragments
+        int count = 0;
+        bool shared = false;  // shares objs with other groups
+    };
+    std::vector<Group> groups;
+    std::vector<int> groupOf(size);
+    for (auto i : byOffset) {
+        const auto& chunkinfo = s3chunkinfolist.s3chunks(i);
+        uint64_t end = chunkinfo.offset() + chunkinfo.len();
+        if (groups.empty() || chunkinfo.offset() >= groups.back().end) {
+            groups.emplace_back();
+            groups.back().begin = chunkinfo.offset();
+        }
+        auto& group = groups.back();
+        group.count++;
+        group.bytes += chunkinfo.len();
+        group.end = std::max(group.end, end);
+        groupOf[i] = groups.size() - 1;
+    }
+
+    // the objs are named by chunkid and compaction, the ones shared by
+    // groups can't be deleted after merging only one of them
+    std::map<std::pair<uint64_t, uint64_t>, int> objGroup;
+    for (int i = 0; i < size; i++) {
+        const auto& chunkinfo = s3chunkinfolist.s3chunks(i);
+        auto key = std::make_pair(chunkinfo.chunkid(), chunkinfo.compaction());
+        auto it = objGroup.emplace(key, groupOf[i]).first;
+        if (it->second != groupOf[i]) {
+            groups[it->second].shared = true;
+            groups[groupOf[i]].shared = true;
+        }
+    }
+
+    int best = -1;
+    for (size_t g = 0; g < groups.size(); g++) {
+        const auto& group = groups[g];
+        if (group.count < 2 || group.shared || group.bytes == 0) continue;
+        double overlapRatio =
+            1 - static_cast<double>(group.end - group.begin) / group.bytes;
+        if (overlapRatio <= opts_.overlapRatioThreshold) continue;
+        if (best < 0 || group.count > groups[best].count) best = g;
+    }
+    // merging the group leaves the chunk still fragmented, it would be
+    // compacted again and again, so rewrite the whole chunk
+    if (best < 0 ||
+        size - groups[best].count + 1 > opts_.fragmentThreshold) {
+        VLOG(6) << "s3compact: merge all " << size << " fragments";
+        return s3chunkinfolist;
+    }
+
+    S3ChunkInfoList toMerge;
+    for (int i = 0; i < size; i++) {
+        if (groupOf[i] == best) {
+            *toMerge.add_s3chunks() = s3chunkinfolist.s3chunks(i);
+        }
+    }
+    VLOG(6) << "s3compact: merge " << toMerge.s3chunks_size() << " of "
+            << size << " fragments, [" << groups[best].begin << ", "
+            << groups[best].end << ")";
+    return toMerge;
+}
+
 std::list<struct S3CompactWorkQueueImpl::Node>
 S3CompactWorkQueueImpl::BuildValidList(const S3ChunkInfoList& s3chunkinfolist,
                                        uint64_t inodeLen) {
@@ -301,75 +382,47 @@ void S3CompactWorkQueueImpl::GenS3ReadRequests(
     newChunkInfo->newCompaction = newCompaction;
 }
 
-int S3CompactWorkQueueImpl::ReadFullChunk(
-    const struct S3CompactCtx& ctx, const std::list<struct Node>& validList,
-    std::string* fullChunk, struct S3NewChunkInfo* newChunkInfo) {
-    std::vector<struct S3Request> s3reqs;
-    std::vector<std::string> readContent;
-    // generate s3request first
-    GenS3ReadRequests(ctx, validList, &s3reqs, newChunkInfo);
-    VLOG(9) << "s3compact: s3 request generated";
-    for (const auto& s3req : s3reqs) {
-        VLOG(9) << "index:" << s3req.reqIndex << ", zero:" << s3req.zero
-                << ", s3objname:" << s3req.objName << ", off:" << s3req.off
-                << ", len:" << s3req.len;
-    }
-    readContent.resize(s3reqs.size());
-    std::unordered_map<std::string, std::vector<struct S3Request*>> objReqs;
-    for (auto& req : s3reqs) {
-        if (req.zero) {
-            objReqs["zero"].emplace_back(&req);
-        } else {
-            objReqs[req.objName].emplace_back(&req);
-        }
-    }
-    // process zero first and will not fail
-    if (objReqs.find("zero") != objReqs.end()) {
-        for (const auto& req : objReqs["zero"]) {
-            readContent[req->reqIndex] = std::string(req->len, '\0');
-        }
-        objReqs.erase("zero");
-    }
-    // read and process objs one by one
+int S3CompactWorkQueueImpl::ReadObjs(
+    const struct S3CompactCtx& ctx,
+    std::vector<std::shared_ptr<GetObjectAsyncContext>> contexts) {
     uint64_t retry = 0;
-    for (auto it = objReqs.begin(); it != objReqs.end(); it++) {
-        std::string buf;
-        const std::string& objName = it->first;
-        const auto& reqs = it->second;
-        const Aws::String aws_key(objName.c_str(), objName.size());
-        const auto maxRetry = opts_.s3ReadMaxRetry;
-        const auto retryInterval = opts_.s3ReadRetryInterval;
-        while (retry <= maxRetry) {
-            // why we need retry
-            // if you enable client's diskcache,
-            // metadata may be newer than data in s3
-            // which means you cannot read data from s3
-            // we have to wait data to be flushed to s3
-            int ret = ctx.s3adapter->GetObject(aws_key, &buf);
-            if (ret != 0) {
-                LOG(WARNING)
-                    << "s3compact: get s3 obj " << objName << " failed";
-                if (retry == maxRetry) return -1;  // no chance
-                retry++;
-                LOG(WARNING) << "s3compact: will retry after " << retryInterval
-                             << " seconds, current retry time:" << retry;
-                std::this_thread::sleep_for(
-                    std::chrono::seconds(retryInterval));
-                continue;
-            }
-            for (const auto& req : reqs) {
-                readContent[req->reqIndex] = buf.substr(req->off, req->len);
+    const auto maxRetry = opts_.s3ReadMaxRetry;
+    const auto retryInterval = opts_.s3ReadRetryInterval;
+    while (true) {
+        CountDownEvent done(contexts.size());
+        for (auto& context : contexts) {
+            context->cb = [&done](
+                const S3Adapter*,
+                const std::shared_ptr<GetObjectAsyncContext>&) {
+                done.Signal();
+            };
+            throttle_.Add(true, context->len);
+            ctx.s3adapter->GetObjectAsync(context);
+        }
+        done.Wait();
+
+        std::vector<std::shared_ptr<GetObjectAsyncContext>> failed;
+        for (auto& context : contexts) {
+            if (context->retCode != 0) {
+                LOG(WARNING) << "s3compact: get s3 obj " << context->key
+                             << " failed";
+                failed.emplace_back(std::move(context));
             }
-            break;
         }
+        if (failed.empty()) return 0;
+
+        // why we need retry
+        // if you enable client's diskcache,
+        // metadata may be newer than data in s3
+        // which means you cannot read data from s3
+        // we have to wait data to be flushed to s3
+        if (retry == maxRetry) return -1;  // no chance
+        retry++;
+        LOG(WARNING) << "s3compact: will retry after " << retryInterval
+                     << " seconds, current retry time:" << retry;
+        std::this_thread::sleep_for(std::chrono::seconds(retryInterval));
+        contexts.swap(failed);
     }
-
-    // merge all read content
-    for (auto content : readContent) {
-        (*fullChunk) += std::move(content);
-    }
-
-    return 0;
 }
 
 MetaStatusCode S3CompactWorkQueueImpl::UpdateInode(
@@ -396,37 +449,95 @@ MetaStatusCode S3CompactWorkQueueImpl::UpdateInode(
     return response.statuscode();
 }
 
-int S3CompactWorkQueueImpl::WriteFullChunk(
+int S3CompactWorkQueueImpl::WriteObjs(
+    const struct S3CompactCtx& ctx,
+    const std::vector<std::shared_ptr<PutObjectAsyncContext>>& contexts,
+    std::vector<std::string>* objsAdded) {
+    CountDownEvent done(contexts.size());
+    for (const auto& context : contexts) {
+        VLOG(9) << "s3compact: put " << context->key << ", size "
+                << context->bufferSize;
+        context->cb = [&done](const std::shared_ptr<PutObjectAsyncContext>&) {
+            done.Signal();
+        };
+        throttle_.Add(false, context->bufferSize);
+        ctx.s3adapter->PutObjectAsync(context);
+    }
+    done.Wait();
+
+    int ret = 0;
+    for (const auto& context : contexts) {
+        if (context->retCode != 0) {
+            LOG(WARNING) << "s3compact: put s3 object " << context->key
+                         << " failed";
+            ret = -1;
+        } else {
+            objsAdded->emplace_back(context->key);
+        }
+    }
+    return ret;
+}
+
+int S3CompactWorkQueueImpl::CopyChunk(
     const struct S3CompactCtx& ctx, const struct S3NewChunkInfo& newChunkInfo,
-    const std::string& fullChunk, std::vector<std::string>* objsAdded) {
-    uint64_t chunkLen = fullChunk.length();
+    const std::vector<struct S3Request>& reqs, uint64_t* len,
+    std::vector<std::string>* objsAdded) {
     const auto& blockSize = ctx.blockSize;
-    const auto& chunkSize = ctx.chunkSize;
     const auto& newOff = newChunkInfo.newOff;
-    uint64_t offRoundDown = newOff / chunkSize * chunkSize;
-    uint64_t startIndex = (newOff - newOff / chunkSize * chunkSize) / blockSize;
-    for (uint64_t index = startIndex;
-         index * blockSize + offRoundDown < newOff + chunkLen; index += 1) {
-        std::string objName = curvefs::common::s3util::GenObjName(
-            newChunkInfo.newChunkId, index, newChunkInfo.newCompaction,
-            ctx.fsId, ctx.inodeId);
-        const Aws::String aws_key(objName.c_str(), objName.size());
-        int ret;
-        uint64_t s3objBegin =
-            std::max(newOff, offRoundDown + index * blockSize);
-        uint64_t s3objEnd = std::min(
-            newOff + chunkLen - 1, offRoundDown + (index + 1) * blockSize - 1);
-        VLOG(9) << "s3compact: put " << objName << ", [" << s3objBegin << "-"
-                << s3objEnd << "]";
-        ret = ctx.s3adapter->PutObject(
-            aws_key,
-            fullChunk.substr(s3objBegin - newOff, s3objEnd - s3objBegin + 1));
+    // the requests are contiguous from newOff
+    std::vector<uint64_t> reqOffs;
+    uint64_t end = newOff;
+    for (const auto& req : reqs) {
+        reqOffs.push_back(end);
+        end += req.len;
+    }
+    *len = end - newOff;
+
+    // each request reads part of a block obj, so it's written to the new
+    // obj at the same index, the objs are copied window by window to
+    // bound the memory
+    const uint64_t window = std::max<uint64_t>(opts_.s3Concurrency, 1);
+    uint64_t offRoundDown = newOff / ctx.chunkSize * ctx.chunkSize;
+    uint64_t index = (newOff - offRoundDown) / blockSize;
+    size_t next = 0;
+    for (uint64_t begin = newOff; begin < end;) {
+        uint64_t windowEnd =
+            std::min(end, offRoundDown + (index + window) * blockSize);
+        // holes and zero requests are left as zero
+        std::string buf(windowEnd - begin, '\0');
+        std::vector<std::shared_ptr<GetObjectAsyncContext>> reads;
+        for (; next < reqs.size() && reqOffs[next] < windowEnd; next++) {
+            const auto& req = reqs[next];
+            if (req.zero) continue;
+            auto context = std::make_shared<GetObjectAsyncContext>();
+            context->key = req.objName;
+            context->buf = &buf[reqOffs[next] - begin];
+            context->offset = req.off;
+            context->len = req.len;
+            reads.emplace_back(std::move(context));
+        }
+        if (ReadObjs(ctx, std::move(reads)) != 0) {
+            return -1;
+        }
+
+        std::vector<std::shared_ptr<PutObjectAsyncContext>> writes;
+        for (uint64_t pos = begin; pos < windowEnd; index++) {
+            uint64_t objEnd =
+                std::min(windowEnd, offRoundDown + (index + 1) * blockSize);
+            auto context = std::make_shared<PutObjectAsyncContext>();
+            context->key = curvefs::common::s3util::GenObjName(
+                newChunkInfo.newChunkId, index, newChunkInfo.newCompaction,
+                ctx.fsId, ctx.inodeId);
+            context->buffer = buf.data() + (pos - begin);
+            context->bufferSize = objEnd - pos;
+            writes.emplace_back(std::move(context));
+            pos = objEnd;
+        }
+        int ret = WriteObjs(ctx, writes, objsAdded);
         if (ret != 0) {
-            LOG(WARNING) << "s3compact: put s3 object " << objName << " failed";
             return ret;
-        } else {
-            objsAdded->emplace_back(std::move(objName));
         }
+        begin = windowEnd;
     }
     return 0;
 }
@@ -522,9 +633,10 @@ void S3CompactWorkQueueImpl::CompactChunk(
         [&]() { VLOG(6) << "s3compact: exit index " << index; });
     VLOG(6) << "s3compact: begin to compact index " << index;
     const auto& s3chunkinfolist = inode.s3chunkinfomap().at(index);
-    // 1.1 build valid list
+    // 1.1 plan and build valid list
+    S3ChunkInfoList toMerge(PlanCompaction(s3chunkinfolist));
     std::list<struct S3CompactWorkQueueImpl::Node> validList(
-        BuildValidList(s3chunkinfolist, inode.length()));
+        BuildValidList(toMerge, inode.length()));
     VLOG(6) << "s3compact: finish build valid list";
     VLOG(9) << "s3compact: show valid list";
     for (const auto& node : validList) {
@@ -533,31 +645,40 @@ void S3CompactWorkQueueImpl::CompactChunk(
                 << ", chunkoff:" << node.chunkoff
                 << ", chunklen:" << node.chunklen << ", zero:" << node.zero;
     }
-    // 1.2  first read full chunk
+    // 1.2 generate s3 requests
     struct S3NewChunkInfo newChunkInfo;
-    std::string fullChunk;
-    int ret = ReadFullChunk(compactCtx, validList, &fullChunk, &newChunkInfo);
-    if (ret != 0) {
-        LOG(WARNING) << "s3compact: ReadFullChunk failed, index " << index;
-        s3infoCache_->InvalidateS3Info(
-            compactCtx.fsId);  // maybe s3info changed?
-        return;
+    std::vector<struct S3Request> s3reqs;
+    GenS3ReadRequests(compactCtx, validList, &s3reqs, &newChunkInfo);
+    VLOG(9) << "s3compact: s3 request generated";
+    for (const auto& s3req : s3reqs) {
+        VLOG(9) << "index:" << s3req.reqIndex << ", zero:" << s3req.zero
+                << ", s3objname:" << s3req.objName << ", off:" << s3req.off
+                << ", len:" << s3req.len;
+    }
+    // the fragments not merged may have the same chunkid, the new objs
+    // must not overwrite theirs
+    for (const auto& chunkinfo : s3chunkinfolist.s3chunks()) {
+        if (chunkinfo.chunkid() == newChunkInfo.newChunkId &&
+            chunkinfo.compaction() >= newChunkInfo.newCompaction) {
+            newChunkInfo.newCompaction = chunkinfo.compaction() + 1;
+        }
     }
-    VLOG(6) << "s3compact: finish read full chunk, size: " << fullChunk.size();
     VLOG(6) << "s3compact: new s3chunk info will be id:"
             << newChunkInfo.newChunkId << ", off:" << newChunkInfo.newOff
             << ", compaction:" << newChunkInfo.newCompaction;
-    // 1.3 then write objs with newChunkid and newCompaction
+    // 1.3 then copy data to objs with newChunkid and newCompaction
+    uint64_t newLen = 0;
     std::vector<std::string> objsAdded;
-    ret = WriteFullChunk(compactCtx, newChunkInfo, fullChunk, &objsAdded);
+    int ret =
+        CopyChunk(compactCtx, newChunkInfo, s3reqs, &newLen, &objsAdded);
     if (ret != 0) {
-        LOG(WARNING) << "s3compact: WriteFullChunk failed, index " << index;
+        LOG(WARNING) << "s3compact: CopyChunk failed, index " << index;
         s3infoCache_->InvalidateS3Info(
             compactCtx.fsId);  // maybe s3info changed?
         DeleteObjs(objsAdded, compactCtx.s3adapter);
         return;
     }
-    VLOG(6) << "s3compact: finish write full chunk";
+    VLOG(6) << "s3compact: finish copy chunk, size: " << newLen;
     // 1.4 record add/delete
     objsAddedMap->emplace(index, std::move(objsAdded));
     // to add
@@ -566,13 +687,13 @@ void S3CompactWorkQueueImpl::CompactChunk(
     toAdd.set_chunkid(newChunkInfo.newChunkId);
     toAdd.set_compaction(newChunkInfo.newCompaction);
     toAdd.set_offset(newChunkInfo.newOff);
-    toAdd.set_len(fullChunk.length());
-    toAdd.set_size(fullChunk.length());
+    toAdd.set_len(newLen);
+    toAdd.set_size(newLen);
     toAdd.set_zero(false);
     *toAddList.add_s3chunks() = std::move(toAdd);
     s3ChunkInfoAdd->insert({index, std::move(toAddList)});
     // to remove
-    s3ChunkInfoRemove->insert({index, s3chunkinfolist});
+    s3ChunkInfoRemove->insert({index, std::move(toMerge)});
 }
 
 void S3CompactWorkQueueImpl::DeleteObjsOfS3ChunkInfoList(
@@ -590,6 +711,7 @@ void S3CompactWorkQueueImpl::DeleteObjsOfS3ChunkInfoList(
                 ctx.inodeId);
             VLOG(6) << "s3compact: delete " << objName;
             const Aws::String aws_key(objName.c_str(), objName.size());
+            throttle_.Add(false, 0);
             int r = ctx.s3adapter->DeleteObject(
                 aws_key);  // don't care success or not
             if (r != 0)
@@ -627,7 +749,7 @@ void S3CompactWorkQueueImpl::CompactChunks(const struct S3CompactTask& task) {
                                           &blockSize, &chunkSize);
     if (s3adapter == nullptr) return;
 
-    // 1. read full chunk & write new objs, each chunk one by one
+    // 1. merge fragments & write new objs, each chunk one by one
     struct S3CompactCtx compactCtx {
         task.inodeKey.inodeId, task.inodeKey.fsId, task.pinfo, blockSize,
             chunkSize, s3adapterIndex, s3adapter
@@ -663,9 +785,10 @@ void S3CompactWorkQueueImpl::CompactChunks(const struct S3CompactTask& task) {
         s3adapterManager_->ReleaseS3Adapter(s3adapterIndex);
         return;
     }
-    auto ret =
-        UpdateInode(task.copysetNodeWrapper->Get(), compactCtx.pinfo, inodeId,
-                    std::move(s3ChunkInfoAdd), std::move(s3ChunkInfoRemove));
+    auto ret = UpdateInode(
+        task.copysetNodeWrapper->Get(), compactCtx.pinfo, inodeId,
+        std::move(s3ChunkInfoAdd),
+        ::google::protobuf::Map<uint64_t, S3ChunkInfoList>(s3ChunkInfoRemove));
     if (ret != MetaStatusCode::OK) {
         LOG(WARNING) << "s3compact: UpdateInode failed, inodeKey = "
                      << compactCtx.fsId << "," << compactCtx.inodeId
@@ -680,9 +803,8 @@ void S3CompactWorkQueueImpl::CompactChunks(const struct S3CompactTask& task) {
 
     // 3. delete old objs
     VLOG(6) << "s3compact: start delete old objs";
-    for (const auto& item : objsAddedMap) {
-        const auto& l = inode.s3chunkinfomap().at(item.first);
-        DeleteObjsOfS3ChunkInfoList(compactCtx, l);
+    for (const auto& item : s3ChunkInfoRemove) {
+        DeleteObjsOfS3ChunkInfoList(compactCtx, item.second);
     }
     VLOG(6) << "s3compact: finish delete objs";
     s3adapterManager_->ReleaseS3Adapter(s3adapterIndex);
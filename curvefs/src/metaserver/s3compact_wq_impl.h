@@ -40,12 +40,16 @@
 #include "src/common/concurrent/task_thread_pool.h"
 #include "src/common/configuration.h"
 #include "src/common/s3_adapter.h"
+#include "src/common/throttle.h"
 
 using curve::common::Configuration;
+using curve::common::GetObjectAsyncContext;
 using curve::common::InitS3AdaptorOption;
+using curve::common::PutObjectAsyncContext;
 using curve::common::S3Adapter;
 using curve::common::S3AdapterOption;
 using curve::common::TaskThreadPool;
+using curve::common::Throttle;
 using curvefs::metaserver::copyset::CopysetNode;
 
 namespace curvefs {
@@ -76,11 +80,18 @@ class S3CompactWorkQueueImpl : public TaskThreadPool<> {
                            const S3CompactWorkQueueOption& opts)
         : s3adapterManager_(s3adapterManager),
           s3infoCache_(s3infoCache),
-          opts_(opts) {}
+          opts_(opts) {
+        curve::common::ReadWriteThrottleParams params;
+        params.iopsTotal.limit = opts_.s3IopsLimit;
+        params.bpsTotal.limit = opts_.s3BpsLimitMB * 1024 * 1024;
+        throttle_.UpdateThrottleParams(params);
+    }
 
     std::shared_ptr<S3AdapterManager> s3adapterManager_;
     std::shared_ptr<S3InfoCache> s3infoCache_;
     S3CompactWorkQueueOption opts_;
+    // s3 requests of all workers are throttled together
+    Throttle throttle_;
     std::deque<InodeKey> compactingInodes_;
     void Enqueue(std::shared_ptr<InodeManager> inodeManager, InodeKey inodeKey,
                  PartitionInfo pinfo, CopysetNode* copyset);
@@ -176,24 +187,34 @@ class S3CompactWorkQueueImpl : public TaskThreadPool<> {
                               uint64_t* blockSize, uint64_t* chunkSize);
     void DeleteObjs(const std::vector<std::string>& objsAdded,
                     S3Adapter* s3adapter);
+    // pick the s3chunkinfos to merge, the group of fragments overlapping
+    // each other with most fragments if merging it is enough, otherwise
+    // the whole list
+    S3ChunkInfoList PlanCompaction(const S3ChunkInfoList& s3chunkinfolist);
     std::list<struct Node> BuildValidList(
         const S3ChunkInfoList& s3chunkinfolist, uint64_t inodeLen);
     void GenS3ReadRequests(const struct S3CompactCtx& ctx,
                            const std::list<struct Node>& validList,
                            std::vector<struct S3Request>* reqs,
                            struct S3NewChunkInfo* newChunkInfo);
-    int ReadFullChunk(const struct S3CompactCtx& ctx,
-                      const std::list<struct Node>& validList,
-                      std::string* fullChunk,
-                      struct S3NewChunkInfo* newChunkInfo);
+    // ranged read in parallel, retry the failed ones
+    int ReadObjs(const struct S3CompactCtx& ctx,
+                 std::vector<std::shared_ptr<GetObjectAsyncContext>> contexts);
+    // write in parallel, the objs written are added to `objsAdded`
+    int WriteObjs(
+        const struct S3CompactCtx& ctx,
+        const std::vector<std::shared_ptr<PutObjectAsyncContext>>& contexts,
+        std::vector<std::string>* objsAdded);
+    // read the data of `reqs` and write them as the objs of new s3chunkinfo,
+    // a window of `s3Concurrency` objs at a time
+    int CopyChunk(const struct S3CompactCtx& ctx,
+                  const struct S3NewChunkInfo& newChunkInfo,
+                  const std::vector<struct S3Request>& reqs, uint64_t* len,
+                  std::vector<std::string>* objsAdded);
     virtual MetaStatusCode UpdateInode(
         CopysetNode* copysetNode, const PartitionInfo& pinfo, uint64_t inodeId,
         ::google::protobuf::Map<uint64_t, S3ChunkInfoList>&& s3ChunkInfoAdd,
         ::google::protobuf::Map<uint64_t, S3ChunkInfoList>&& s3ChunkInfoRemove);
-    int WriteFullChunk(const struct S3CompactCtx& ctx,
-                       const struct S3NewChunkInfo& newChunkInfo,
-                       const std::string& fullChunk,
-                       std::vector<std::string>* objsAdded);
     void CompactChunk(
         const struct S3CompactCtx& compactCtx, uint64_t index,
         const Inode& inode,
@@ -25,8 +25,12 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <atomic>
+#include <map>
 #include <string>
 #include <memory>
+#include <thread>  // NOLINT
 #include <vector>
 #include <utility>
 
@@ -48,6 +52,9 @@ enum class ENTRY_TYPE {
     DENTRY,
     PARTITION,
     PENDING_TX,
+    S3_CHUNK_INFO_LIST,
+    REMOVED_ENTRIES,
+    APPLIED_REQUESTS,
     UNKNOWN,
 };
 
@@ -57,6 +64,9 @@ static std::vector<Pair> pairs{
     Pair(ENTRY_TYPE::DENTRY, "d"),
     Pair(ENTRY_TYPE::PARTITION, "p"),
     Pair(ENTRY_TYPE::PENDING_TX, "t"),
+    Pair(ENTRY_TYPE::S3_CHUNK_INFO_LIST, "s"),
+    Pair(ENTRY_TYPE::REMOVED_ENTRIES, "r"),
+    Pair(ENTRY_TYPE::APPLIED_REQUESTS, "a"),
     Pair(ENTRY_TYPE::UNKNOWN, "u"),
 };
 
@@ -259,10 +269,11 @@ inline std::pair<ENTRY_TYPE, uint32_t> Extract(const std::string& key) {
 template<typename EntryType, typename Callback>
 inline bool InvokeCallback(ENTRY_TYPE entryType,
                            uint32_t partitionId,
-                           const std::string& value,
+                           const char* value,
+                           size_t length,
                            Callback callback) {
     EntryType entry;
-    if (!entry.ParseFromString(value)) {
+    if (!entry.ParseFromArray(value, length)) {
         LOG(ERROR) << "Decode string to entry failed.";
         return false;
     } else if (!callback(entryType, partitionId, (void*)(&entry))) {  // NOLINT
@@ -272,8 +283,10 @@ inline bool InvokeCallback(ENTRY_TYPE entryType,
     return true;
 }
 
+// save in a forked child process if |background| is true
 inline bool SaveToFile(const std::string& pathname,
-                       std::shared_ptr<MergeIterator> iterator) {
+                       std::shared_ptr<MergeIterator> iterator,
+                       bool background = true) {
     auto dumpfile = DumpFile(pathname);
     if (dumpfile.Open() != DUMPFILE_ERROR::OK) {
         LOG(ERROR) << "Open dumpfile failed";
@@ -281,7 +294,8 @@ inline bool SaveToFile(const std::string& pathname,
     }
 
     auto defer = absl::MakeCleanup([&dumpfile]() { dumpfile.Close(); });
-    auto retCode = dumpfile.SaveBackground(iterator);
+    auto retCode = background ? dumpfile.SaveBackground(iterator)
+                              : dumpfile.Save(iterator);
     LOG(INFO) << "retcode = " << retCode;
     return (retCode == DUMPFILE_ERROR::OK) && (iterator->Status() == 0);
 }
@@ -289,14 +303,59 @@ inline bool SaveToFile(const std::string& pathname,
 #define CASE_TYPE_CALLBACK(TYPE, type) \
 case ENTRY_TYPE::TYPE: \
     if (!InvokeCallback<type, Callback>( \
-        entryType, partitionId, value, callback)) { \
+        entryType, partitionId, value, length, callback)) { \
         return false; \
     } \
     break
 
+template<typename Callback>
+inline bool LoadEntry(const std::string& key,
+                      const char* value,
+                      size_t length,
+                      Callback callback) {
+    auto ret = Extract(key);
+    auto entryType = ret.first;
+    auto partitionId = ret.second;
+    switch (entryType) {
+        CASE_TYPE_CALLBACK(INODE, Inode);
+        CASE_TYPE_CALLBACK(DENTRY, Dentry);
+        CASE_TYPE_CALLBACK(PARTITION, PartitionInfo);
+        CASE_TYPE_CALLBACK(PENDING_TX, PrepareRenameTxRequest);
+        CASE_TYPE_CALLBACK(S3_CHUNK_INFO_LIST, InodeS3ChunkInfoList);
+        CASE_TYPE_CALLBACK(REMOVED_ENTRIES, RemovedEntries);
+        CASE_TYPE_CALLBACK(APPLIED_REQUESTS, AppliedRequests);
+        // TODO(Wine93): add pending tx
+        default:
+            LOG(ERROR) << "Unknown entry type, key = " << key;
+            return false;
+    }
+    return true;
+}
+
+// load the dumpfile of version 1 pair by pair
+template<typename Callback>
+inline bool LoadFromFileInOrder(DumpFile* dumpfile, Callback callback) {
+    auto iter = dumpfile->Load();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        auto key = iter->Key();
+        auto value = iter->Value();
+        if (!LoadEntry(key, value.data(), value.size(), callback)) {
+            return false;
+        }
+    }
+
+    return dumpfile->GetLoadStatus() == DUMPFILE_LOAD_STATUS::COMPLETE;
+}
+
+// The blocks of dumpfile are verified, decoded and loaded by |concurrency|
+// threads. The partitions at the beginning of the file are loaded first,
+// and then the blocks of each partition are loaded by one thread in the
+// order of file, so |callback| must be safe to be invoked for different
+// partitions at the same time.
 template<typename Callback>
 inline bool LoadFromFile(const std::string& pathname,
-                         Callback callback) {
+                         Callback callback,
+                         uint32_t concurrency = 1) {
     auto dumpfile = DumpFile(pathname);
     if (dumpfile.Open() != DUMPFILE_ERROR::OK) {
         return false;
@@ -304,27 +363,85 @@ inline bool LoadFromFile(const std::string& pathname,
 
     auto defer = absl::MakeCleanup([&dumpfile]() { dumpfile.Close(); });
 
-    auto iter = dumpfile.Load();
-    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
-        auto key = iter->Key();
-        auto value = iter->Value();
+    std::vector<DumpFileBlock> blocks;
+    auto status = dumpfile.MapBlocks(&blocks);
+    if (status == DUMPFILE_LOAD_STATUS::INVALID_VERSION) {
+        return LoadFromFileInOrder(&dumpfile, callback);
+    } else if (status != DUMPFILE_LOAD_STATUS::COMPLETE) {
+        LOG(ERROR) << "Map dumpfile failed, pathname = " << pathname
+                   << ", loadStatus = " << status;
+        return false;
+    }
+
+    auto loadBlock = [&](const DumpFileBlock& block) {
+        auto status = dumpfile.LoadBlock(
+            block, [&](const char* value, size_t length) {
+                return LoadEntry(block.key, value, length, callback);
+            });
+        LOG_IF(ERROR, status != DUMPFILE_LOAD_STATUS::COMPLETE)
+            << "Load block failed, key = " << block.key
+            << ", loadStatus = " << status;
+        return status == DUMPFILE_LOAD_STATUS::COMPLETE;
+    };
+
+    size_t index = 0;
+    for (; index < blocks.size() &&
+           Extract(blocks[index].key).first == ENTRY_TYPE::PARTITION;
+         index++) {
+        if (!loadBlock(blocks[index])) {
+            return false;
+        }
+    }
+
+    struct Task {
+        uint64_t length = 0;
+        std::vector<const DumpFileBlock*> blocks;
+    };
+    std::map<uint32_t, Task> partitions;
+    for (; index < blocks.size(); index++) {
+        auto& task = partitions[Extract(blocks[index].key).second];
+        task.length += blocks[index].length;
+        task.blocks.push_back(&blocks[index]);
+    }
 
-        auto ret = Extract(key);
-        auto entryType = ret.first;
-        auto partitionId = ret.second;
-        switch (entryType) {
-            CASE_TYPE_CALLBACK(INODE, Inode);
-            CASE_TYPE_CALLBACK(DENTRY, Dentry);
-            CASE_TYPE_CALLBACK(PARTITION, PartitionInfo);
-            CASE_TYPE_CALLBACK(PENDING_TX, PrepareRenameTxRequest);
-            // TODO(Wine93): add pending tx
-            default:
-                LOG(ERROR) << "Unknown entry type, key = " << key;
-                return false;
+    // load the larger partitions first to balance the threads
+    std::vector<Task*> tasks;
+    for (auto& item : partitions) {
+        tasks.push_back(&item.second);
+    }
+    std::sort(tasks.begin(), tasks.end(), [](Task* lhs, Task* rhs) {
+        return lhs->length > rhs->length;
+    });
+
+    std::atomic<size_t> next(0);
+    std::atomic<bool> succ(true);
+    auto worker = [&]() {
+        for (size_t i = next++; i < tasks.size() && succ; i = next++) {
+            for (const auto* block : tasks[i]->blocks) {
+                if (!succ || !loadBlock(*block)) {
+                    succ = false;
+                    break;
+                }
+            }
         }
+    };
+
+    size_t nthreads = std::min<size_t>(std::max<uint32_t>(concurrency, 1),
+                                       tasks.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < nthreads; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
     }
 
-    return dumpfile.GetLoadStatus() == DUMPFILE_LOAD_STATUS::COMPLETE;
+    LOG(INFO) << "Load dumpfile " << pathname << " "
+              << (succ ? "success" : "fail") << ", blocks = " << blocks.size()
+              << ", partitions = " << tasks.size()
+              << ", threads = " << std::max<size_t>(nthreads, 1);
+    return succ;
 }
 
 }  // namespace metaserver
@@ -20,6 +20,10 @@
  * Author: Jingli Chen (Wine93)
  */
 
+#include <set>
+#include <string>
+#include <utility>
+
 #include "curvefs/src/metaserver/dentry_storage.h"
 #include "curvefs/src/metaserver/transaction.h"
 
@@ -81,13 +85,21 @@ std::ostream& operator<<(std::ostream& os, const RenameTx& renameTx) {
 TxManager::TxManager(std::shared_ptr<DentryStorage> storage)
     : storage_(storage) {}
 
+// the dentrys of a transaction are the ones of a rename, or the ones of
+// a batch of renames committed together, they must be different dentrys
+// with the same txid in the same fs
 MetaStatusCode TxManager::PreCheck(const std::vector<Dentry>& dentrys) {
-    auto size = dentrys.size();
-    if (size != 1 && size != 2) {
+    if (dentrys.empty()) {
         return MetaStatusCode::PARAM_ERROR;
-    } else if (size == 2) {
-         if (dentrys[0].fsid() != dentrys[1].fsid() ||
-             dentrys[0].txid() != dentrys[1].txid()) {
+    }
+
+    std::set<std::pair<uint64_t, std::string>> keys;
+    for (const auto& dentry : dentrys) {
+        if (dentry.fsid() != dentrys[0].fsid() ||
+            dentry.txid() != dentrys[0].txid()) {
+            return MetaStatusCode::PARAM_ERROR;
+        } else if (!keys.emplace(dentry.parentinodeid(),
+                                 dentry.name()).second) {
             return MetaStatusCode::PARAM_ERROR;
         }
     }
@@ -139,6 +139,16 @@ MetaStatusCode TrashImpl::DeleteInodeAndData(const TrashItem &item) {
     if (FsFileType::TYPE_FILE == inode.type()) {
         // TODO(xuchaojie) : delete on volume
     } else if (FsFileType::TYPE_S3 == inode.type()) {
+        // s3 chunk infos are kept apart from the inode
+        ret = inodeStorage_->ListS3ChunkInfo(
+            InodeKey(item.fsId, item.inodeId), 0, UINT64_MAX,
+            inode.mutable_s3chunkinfomap());
+        if (ret != MetaStatusCode::OK) {
+            LOG(WARNING) << "ListS3ChunkInfo fail, fsId = " << item.fsId
+                         << ", inodeId = " << item.inodeId
+                         << ", ret = " << MetaStatusCode_Name(ret);
+            return ret;
+        }
         int retVal = s3Adaptor_->Delete(inode);
         if (retVal != 0) {
             LOG(ERROR) << "S3ClientAdaptor delete s3 data failed"
@@ -33,6 +33,7 @@
 namespace curvefs {
 namespace client {
 
+using ::testing::SaveArg;
 using ::testing::SetArgPointee;
 using rpcclient::MockMetaServerClient;
 using rpcclient::MockMdsClient;
@@ -186,5 +187,90 @@ TEST_F(ClientOperatorTest, CommitTx) {
     ASSERT_EQ(rc, CURVEFS_ERROR::OK);
 }
 
+TEST_F(ClientOperatorTest, Rename) {
+    EXPECT_CALL(*metaClient_, GetTxId(_, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(1), SetArgPointee<3>(5),
+                        Return(MetaStatusCode::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(2), SetArgPointee<3>(7),
+                        Return(MetaStatusCode::OK)));
+    ASSERT_EQ(renameOp_->GetTxId(), CURVEFS_ERROR::OK);
+
+    // CASE 1: Rename fail, the client should run the transaction by itself
+    EXPECT_CALL(*metaClient_, Rename(_, _, _, _))
+        .WillOnce(Return(MetaStatusCode::RPC_ERROR));
+
+    auto rc = renameOp_->Rename();
+    ASSERT_EQ(rc, CURVEFS_ERROR::NOTSUPPORT);
+
+    // CASE 2: Rename success, the txids committed are set
+    Dentry dentry, newDentry;
+    EXPECT_CALL(*metaClient_, Rename(_, _, _, _))
+        .WillOnce(DoAll(SaveArg<0>(&dentry), SaveArg<1>(&newDentry),
+                        SetArgPointee<2>(9), SetArgPointee<3>(8),
+                        Return(MetaStatusCode::OK)));
+
+    rc = renameOp_->Rename();
+    ASSERT_EQ(rc, CURVEFS_ERROR::OK);
+    ASSERT_EQ(dentry.txid(), 5);
+    ASSERT_EQ(newDentry.parentinodeid(), newParentId_);
+    ASSERT_EQ(newDentry.name(), newname_);
+    ASSERT_EQ(newDentry.txid(), 7);
+
+    EXPECT_CALL(*dentryManager_, DeleteCache(parentId_, name_));
+    EXPECT_CALL(*dentryManager_, InsertOrReplaceCache(_));
+    EXPECT_CALL(*metaClient_, SetTxId(1, 9));
+    EXPECT_CALL(*metaClient_, SetTxId(2, 8));
+    renameOp_->UpdateCache();
+}
+
+TEST_F(ClientOperatorTest, RenameCommitUnknown) {
+    EXPECT_CALL(*metaClient_, GetTxId(_, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(1), SetArgPointee<3>(5),
+                        Return(MetaStatusCode::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(2), SetArgPointee<3>(7),
+                        Return(MetaStatusCode::OK)));
+    ASSERT_EQ(renameOp_->GetTxId(), CURVEFS_ERROR::OK);
+
+    // CASE 1: refresh txids fail, the client can't fall back
+    EXPECT_CALL(*metaClient_, Rename(_, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(6), SetArgPointee<3>(8),
+                        Return(MetaStatusCode::TX_COMMIT_UNKNOWN)));
+    EXPECT_CALL(*metaClient_, RefreshTxId(fsId_))
+        .WillOnce(Return(false));
+    ASSERT_EQ(renameOp_->Rename(), CURVEFS_ERROR::INTERNAL);
+
+    // CASE 2: not committed on mds, fall back with the txids refreshed
+    EXPECT_CALL(*metaClient_, Rename(_, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(6), SetArgPointee<3>(8),
+                        Return(MetaStatusCode::TX_COMMIT_UNKNOWN)));
+    EXPECT_CALL(*metaClient_, RefreshTxId(fsId_))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*metaClient_, GetTxId(_, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(1), SetArgPointee<3>(5),
+                        Return(MetaStatusCode::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(2), SetArgPointee<3>(7),
+                        Return(MetaStatusCode::OK)));
+    ASSERT_EQ(renameOp_->Rename(), CURVEFS_ERROR::NOTSUPPORT);
+
+    // CASE 3: committed on mds, the rename succeeds
+    EXPECT_CALL(*metaClient_, Rename(_, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(6), SetArgPointee<3>(8),
+                        Return(MetaStatusCode::TX_COMMIT_UNKNOWN)));
+    EXPECT_CALL(*metaClient_, RefreshTxId(fsId_))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*metaClient_, GetTxId(_, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(1), SetArgPointee<3>(6),
+                        Return(MetaStatusCode::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(2), SetArgPointee<3>(8),
+                        Return(MetaStatusCode::OK)));
+    ASSERT_EQ(renameOp_->Rename(), CURVEFS_ERROR::OK);
+
+    EXPECT_CALL(*dentryManager_, DeleteCache(parentId_, name_));
+    EXPECT_CALL(*dentryManager_, InsertOrReplaceCache(_));
+    EXPECT_CALL(*metaClient_, SetTxId(1, 6));
+    EXPECT_CALL(*metaClient_, SetTxId(2, 8));
+    renameOp_->UpdateCache();
+}
+
 }  // namespace client
 }  // namespace curvefs
@@ -26,6 +26,10 @@
 #include <google/protobuf/util/message_differencer.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+
 #include "curvefs/test/client/mock_client_s3.h"
 #include "curvefs/test/client/mock_inode_cache_manager.h"
 #include "curvefs/test/client/mock_mds_client.h"
@@ -101,6 +105,11 @@ class ClientS3AdaptorTest : public testing::Test {
         option.blockSize = 1 * 1024 * 1024;
         option.chunkSize = 4 * 1024 * 1024;
         option.pageSize = 64 * 1024;
+        option.prefetchBlocks = 4;
+        option.readParallelism = 1;
+        option.flushParallelism = 1;
+        option.uploadParallelism = 0;
+        option.flushLowWatermark = 100;
         option.intervalSec = 5000;
         option.flushIntervalSec = 5000;
         option.readCacheMaxByte = 104857600;
@@ -2897,5 +2906,170 @@ TEST_F(ClientS3AdaptorTest, test_fssync_overlap_write) {
     gObjectDataMaps.clear();
 }
 
+TEST_F(ClientS3AdaptorTest, test_parallel_read_and_readahead) {
+    S3ClientAdaptorOption option;
+    option.blockSize = 1 * 1024 * 1024;
+    option.chunkSize = 4 * 1024 * 1024;
+    option.pageSize = 64 * 1024;
+    option.prefetchBlocks = 4;
+    option.readParallelism = 4;
+    option.flushParallelism = 1;
+    option.uploadParallelism = 0;
+    option.nearfullRatio = 70;
+    option.flushLowWatermark = 30;
+    option.intervalSec = 5000;
+    option.flushIntervalSec = 5000;
+    option.readCacheMaxByte = 104857600;
+    option.writeCacheMaxByte = 10485760000;
+    option.diskCacheOpt.diskCacheType = (DiskCacheType)0;
+    MockS3Client mockS3Client;
+    auto mockInodeManager = std::make_shared<MockInodeCacheManager>();
+    auto mockMdsClient = std::make_shared<MockMdsClient>();
+    S3ClientAdaptorImpl s3ClientAdaptor;
+    ASSERT_EQ(CURVEFS_ERROR::OK,
+              s3ClientAdaptor.Init(option, &mockS3Client, mockInodeManager,
+                                   mockMdsClient));
+    s3ClientAdaptor.SetFsId(2);
+
+    uint64_t readFileLen = 3 * 1024 * 1024;
+    curvefs::metaserver::Inode inode;
+    InitInode(&inode);
+    inode.set_length(readFileLen);
+    S3ChunkInfoList s3ChunkInfoList;
+    S3ChunkInfo *s3ChunkInfo = s3ChunkInfoList.add_s3chunks();
+    s3ChunkInfo->set_chunkid(26);
+    s3ChunkInfo->set_compaction(0);
+    s3ChunkInfo->set_offset(0);
+    s3ChunkInfo->set_len(readFileLen);
+    s3ChunkInfo->set_size(readFileLen);
+    s3ChunkInfo->set_zero(false);
+    inode.mutable_s3chunkinfomap()->insert({0, s3ChunkInfoList});
+    auto inodeWrapper = std::make_shared<InodeWrapper>(inode, nullptr);
+    EXPECT_CALL(*mockInodeManager, GetInode(_, _))
+        .WillRepeatedly(
+            DoAll(SetArgReferee<1>(inodeWrapper), Return(CURVEFS_ERROR::OK)));
+
+    // each block is a range get, the first one fails and is retried
+    std::atomic<int> asyncGets(0);
+    EXPECT_CALL(mockS3Client, DownloadAsync(_))
+        .Times(3)
+        .WillRepeatedly(
+            Invoke([&](std::shared_ptr<GetObjectAsyncContext> context) {
+                memset(context->buf, 'c', context->len);
+                context->retCode = asyncGets.fetch_add(1) == 0 ? -1 : 0;
+                context->cb(nullptr, context);
+            }));
+    EXPECT_CALL(mockS3Client, Download(_, _, _, _))
+        .WillOnce(Invoke(
+            [](const std::string &name, char *buf, uint64_t offset,
+               uint64_t len) {
+                memset(buf, 'c', len);
+                return static_cast<int>(len);
+            }));
+
+    std::unique_ptr<char[]> buf(new char[readFileLen]);
+    ASSERT_EQ(readFileLen, s3ClientAdaptor.Read(inode.inodeid(), 0,
+                                                readFileLen, buf.get()));
+    for (uint64_t i = 0; i < readFileLen; i++) {
+        ASSERT_EQ('c', buf[i]);
+    }
+
+    // sequential read opens the prefetch window, random read closes it
+    auto fileCache = s3ClientAdaptor.GetFsCacheManager()->FindFileCacheManager(
+        inode.inodeid());
+    ASSERT_NE(nullptr, fileCache);
+    ASSERT_EQ(1, fileCache->GetReadaheadWindow());
+    ASSERT_EQ(1024, s3ClientAdaptor.Read(inode.inodeid(), 0, 1024,
+                                         buf.get()));
+    ASSERT_EQ(0, fileCache->GetReadaheadWindow());
+    ASSERT_EQ(1024, s3ClientAdaptor.Read(inode.inodeid(), 1024, 1024,
+                                         buf.get()));
+    ASSERT_EQ(1, fileCache->GetReadaheadWindow());
+
+    EXPECT_CALL(mockS3Client, Deinit()).Times(1);
+    s3ClientAdaptor.Stop();
+}
+
+TEST_F(ClientS3AdaptorTest, test_parallel_fssync) {
+    S3ClientAdaptorOption option;
+    option.blockSize = 1 * 1024 * 1024;
+    option.chunkSize = 4 * 1024 * 1024;
+    option.pageSize = 64 * 1024;
+    option.prefetchBlocks = 4;
+    option.readParallelism = 1;
+    option.flushParallelism = 4;
+    option.uploadParallelism = 2;
+    option.nearfullRatio = 70;
+    option.flushLowWatermark = 30;
+    option.intervalSec = 5000;
+    option.flushIntervalSec = 5000;
+    option.readCacheMaxByte = 104857600;
+    option.writeCacheMaxByte = 10485760000;
+    option.diskCacheOpt.diskCacheType = (DiskCacheType)0;
+    MockS3Client mockS3Client;
+    auto mockInodeManager = std::make_shared<MockInodeCacheManager>();
+    auto mockMdsClient = std::make_shared<MockMdsClient>();
+    S3ClientAdaptorImpl s3ClientAdaptor;
+    ASSERT_EQ(CURVEFS_ERROR::OK,
+              s3ClientAdaptor.Init(option, &mockS3Client, mockInodeManager,
+                                   mockMdsClient));
+    s3ClientAdaptor.SetFsId(2);
+
+    const int fileNum = 3;
+    std::map<uint64_t, std::shared_ptr<InodeWrapper>> inodes;
+    for (int i = 0; i < fileNum; i++) {
+        curvefs::metaserver::Inode inode;
+        InitInode(&inode);
+        inodes.emplace(inode.inodeid(),
+                       std::make_shared<InodeWrapper>(inode, nullptr));
+    }
+    EXPECT_CALL(*mockMdsClient, AllocS3ChunkId(_, _))
+        .WillRepeatedly(
+            DoAll(SetArgPointee<1>(25), Return(FSStatusCode::OK)));
+    EXPECT_CALL(*mockInodeManager, GetInode(_, _))
+        .WillRepeatedly(Invoke(
+            [&](uint64_t inodeId, std::shared_ptr<InodeWrapper> &out) {
+                out = inodes[inodeId];
+                return CURVEFS_ERROR::OK;
+            }));
+    // the put requests in flight never exceed uploadParallelism
+    std::atomic<int> inflight(0);
+    std::atomic<int> maxInflight(0);
+    EXPECT_CALL(mockS3Client, UploadAsync(_))
+        .Times(fileNum * 2)
+        .WillRepeatedly(Invoke(
+            [&](const std::shared_ptr<PutObjectAsyncContext> &context) {
+                int now = inflight.fetch_add(1) + 1;
+                int max = maxInflight.load();
+                while (now > max &&
+                       !maxInflight.compare_exchange_weak(max, now)) {
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                inflight.fetch_sub(1);
+                context->retCode = 0;
+                context->cb(context);
+            }));
+
+    uint64_t len = 2 * 1024 * 1024;
+    std::unique_ptr<char[]> buf(new char[len]);
+    memset(buf.get(), 'a', len);
+    for (auto &item : inodes) {
+        ASSERT_EQ(len, s3ClientAdaptor.Write(item.first, 0, len, buf.get()));
+    }
+
+    auto fsCacheManager = s3ClientAdaptor.GetFsCacheManager();
+    ASSERT_EQ(fileNum, fsCacheManager->GetDataCacheNum());
+    ASSERT_EQ(CURVEFS_ERROR::OK, s3ClientAdaptor.FsSync());
+    ASSERT_EQ(0, fsCacheManager->GetDataCacheNum());
+    ASSERT_LE(maxInflight.load(), 2);
+    for (auto &item : inodes) {
+        ASSERT_EQ(1, item.second->GetMutableInodeUnlocked()
+                         ->s3chunkinfomap().size());
+    }
+
+    EXPECT_CALL(mockS3Client, Deinit()).Times(1);
+    s3ClientAdaptor.Stop();
+}
+
 }  // namespace client
 }  // namespace curvefs
@@ -22,6 +22,10 @@
 
 #include <gtest/gtest.h>
 
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
 #include "curvefs/src/client/s3/client_s3_adaptor.h"
 #include "curvefs/src/client/s3/client_s3_cache_manager.h"
 #include "curvefs/test/client/mock_chunk_cache_manager.h"
@@ -43,6 +47,10 @@ TEST(FsCacheManagerTest, test_read_lru_cache_size) {
     option.blockSize = 1 * 1024 * 1024;
     option.chunkSize = 4 * 1024 * 1024;
     option.pageSize = 64 * 1024;
+    option.flushParallelism = 1;
+    option.uploadParallelism = 0;
+    option.nearfullRatio = 70;
+    option.flushLowWatermark = 30;
     option.intervalSec = 5000;
     option.flushIntervalSec = 5000;
     option.readCacheMaxByte = 104857600;
@@ -96,5 +104,125 @@ TEST(FsCacheManagerTest, test_read_lru_cache_size) {
     }
 }
 
+TEST(FsCacheManagerTest, test_page_pool) {
+    uint32_t pageSize = 4096;
+    // only one slab of 64 pages, which is kept when idle
+    PagePool pool(pageSize, 64 * pageSize, 64 * pageSize);
+    std::vector<char *> pages;
+    for (int i = 0; i < 65; ++i) {
+        char *page = pool.Allocate();
+        ASSERT_EQ(0, page[0]);
+        ASSERT_EQ(0, page[pageSize - 1]);
+        memset(page, 'a', pageSize);
+        pages.push_back(page);
+    }
+    // the last page comes from the heap
+    ASSERT_EQ(64ull * pageSize, pool.GetSlabByte());
+    ASSERT_EQ(0, pool.GetFreePageNum());
+    ASSERT_EQ(65, pool.GetUsedPageNum());
+
+    for (char *page : pages) {
+        pool.Free(page);
+    }
+    ASSERT_EQ(64, pool.GetFreePageNum());
+    ASSERT_EQ(0, pool.GetUsedPageNum());
+
+    // pages are recycled and zeroed
+    char *page = pool.Allocate();
+    ASSERT_EQ(0, page[0]);
+    ASSERT_EQ(63, pool.GetFreePageNum());
+    ASSERT_EQ(64ull * pageSize, pool.GetSlabByte());
+    pool.Free(page);
+}
+
+TEST(FsCacheManagerTest, test_page_pool_release_slab) {
+    uint32_t pageSize = 4096;
+    // two slabs at most, one is kept when idle
+    PagePool pool(pageSize, 128 * pageSize, 64 * pageSize);
+    std::vector<char *> pages;
+    for (int i = 0; i < 128; ++i) {
+        pages.push_back(pool.Allocate());
+    }
+    ASSERT_EQ(128ull * pageSize, pool.GetSlabByte());
+    ASSERT_EQ(0, pool.GetFreePageNum());
+
+    for (char *page : pages) {
+        pool.Free(page);
+    }
+    ASSERT_EQ(64ull * pageSize, pool.GetSlabByte());
+    ASSERT_EQ(64, pool.GetFreePageNum());
+    ASSERT_EQ(0, pool.GetUsedPageNum());
+}
+
+TEST(FsCacheManagerTest, test_page_pool_multi_thread) {
+    uint32_t pageSize = 4096;
+    PagePool pool(pageSize, 256 * pageSize);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&pool, pageSize]() {
+            std::vector<char *> pages;
+            for (int round = 0; round < 100; ++round) {
+                for (int j = 0; j < 64; ++j) {
+                    char *page = pool.Allocate();
+                    ASSERT_EQ(0, page[pageSize - 1]);
+                    memset(page, 'a', pageSize);
+                    pages.push_back(page);
+                }
+                for (char *page : pages) {
+                    pool.Free(page);
+                }
+                pages.clear();
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    ASSERT_EQ(0, pool.GetUsedPageNum());
+    // all idle slabs are released without a low watermark
+    ASSERT_EQ(0, pool.GetSlabByte());
+    ASSERT_EQ(0, pool.GetFreePageNum());
+}
+
+TEST(FsCacheManagerTest, test_data_cache_pages) {
+    S3ClientAdaptorOption option;
+    option.blockSize = 1 * 1024 * 1024;
+    option.chunkSize = 4 * 1024 * 1024;
+    option.pageSize = 64 * 1024;
+    option.flushParallelism = 1;
+    option.uploadParallelism = 0;
+    option.nearfullRatio = 70;
+    option.flushLowWatermark = 30;
+    option.intervalSec = 5000;
+    option.flushIntervalSec = 5000;
+    option.readCacheMaxByte = 104857600;
+    option.writeCacheMaxByte = 104857600;
+    option.diskCacheOpt.diskCacheType = (DiskCacheType)0;
+    S3ClientAdaptorImpl *s3ClientAdaptor = new S3ClientAdaptorImpl();
+    s3ClientAdaptor->Init(option, nullptr, nullptr, nullptr);
+    auto pagePool = s3ClientAdaptor->GetFsCacheManager()->GetPagePool();
+    auto mockCacheMgr = std::make_shared<MockChunkCacheManager>();
+
+    uint64_t len = 200 * 1024;
+    std::unique_ptr<char[]> buf(new char[len]);
+    memset(buf.get(), 'a', len);
+    std::unique_ptr<char[]> readBuf(new char[len]);
+    {
+        // [10KiB, 210KiB) spans 4 pages, the head and tail are zero filled
+        auto dataCache = std::make_shared<DataCache>(
+            s3ClientAdaptor, mockCacheMgr.get(), 10 * 1024, len, buf.get());
+        ASSERT_EQ(4, pagePool->GetUsedPageNum());
+        ASSERT_EQ(4 * option.pageSize, dataCache->GetActualLen());
+        dataCache->CopyDataCacheToBuf(0, len, readBuf.get());
+        ASSERT_EQ(0, memcmp(buf.get(), readBuf.get(), len));
+
+        // the pages after 118KiB are dropped
+        dataCache->Truncate(108 * 1024);
+        ASSERT_EQ(2, pagePool->GetUsedPageNum());
+        ASSERT_EQ(2 * option.pageSize, dataCache->GetActualLen());
+    }
+    ASSERT_EQ(0, pagePool->GetUsedPageNum());
+}
+
 }  // namespace client
 }  // namespace curvefs
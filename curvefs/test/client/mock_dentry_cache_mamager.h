@@ -38,8 +38,9 @@ class MockDentryCacheManager : public DentryCacheManager {
     MockDentryCacheManager() {}
     ~MockDentryCacheManager() {}
 
-    MOCK_METHOD2(Init, CURVEFS_ERROR(
-        uint64_t cacheSize, bool enableCacheMetrics));
+    MOCK_METHOD3(Init, CURVEFS_ERROR(
+        uint64_t cacheSize, bool enableCacheMetrics,
+        uint32_t negativeTimeoutMs));
 
     MOCK_METHOD1(InsertOrReplaceCache, void(const Dentry& dentry));
 
@@ -53,6 +54,9 @@ class MockDentryCacheManager : public DentryCacheManager {
     MOCK_METHOD2(DeleteDentry, CURVEFS_ERROR(uint64_t parent,
                                              const std::string &name));
 
+    MOCK_METHOD3(UnlinkDentryAndDecNlink, CURVEFS_ERROR(uint64_t parent,
+        const std::string &name, uint64_t inodeid));
+
     MOCK_METHOD3(ListDentry, CURVEFS_ERROR(uint64_t parent,
                                            std::list<Dentry> *dentryList,
                                            uint32_t limit));
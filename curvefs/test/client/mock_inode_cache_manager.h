@@ -24,7 +24,9 @@
 #define CURVEFS_TEST_CLIENT_MOCK_INODE_CACHE_MANAGER_H_
 
 #include <gmock/gmock.h>
+#include <map>
 #include <memory>
+#include <set>
 
 #include "curvefs/src/client/inode_cache_manager.h"
 
@@ -42,9 +44,19 @@ class MockInodeCacheManager : public InodeCacheManager {
     MOCK_METHOD2(GetInode, CURVEFS_ERROR(
         uint64_t inodeid, std::shared_ptr<InodeWrapper> &out));     // NOLINT
 
+    MOCK_METHOD2(GetInodeAttr, CURVEFS_ERROR(
+        uint64_t inodeid, InodeAttr *out));
+
+    MOCK_METHOD2(BatchGetInodeAttr, CURVEFS_ERROR(
+        const std::set<uint64_t> &inodeIds,
+        std::map<uint64_t, InodeAttr> *attrs));
+
     MOCK_METHOD2(CreateInode, CURVEFS_ERROR(const InodeParam &param,
         std::shared_ptr<InodeWrapper> &out));     // NOLINT
 
+    MOCK_METHOD3(CreateInodeAndDentry, CURVEFS_ERROR(const InodeParam &param,
+        Dentry *dentry, std::shared_ptr<InodeWrapper> &out));     // NOLINT
+
     MOCK_METHOD1(DeleteInode, CURVEFS_ERROR(uint64_t inodeid));
 
     MOCK_METHOD1(ClearInodeCache, void(uint64_t inodeid));
@@ -52,6 +64,9 @@ class MockInodeCacheManager : public InodeCacheManager {
     MOCK_METHOD1(ShipToFlush, void(
         const std::shared_ptr<InodeWrapper> &inodeWrapper));
 
+    MOCK_METHOD1(AddOpenLease, void(
+        const std::shared_ptr<InodeWrapper> &inodeWrapper));
+
     MOCK_METHOD0(FlushAll, void());
 
     MOCK_METHOD0(FlushInodeOnce, void());
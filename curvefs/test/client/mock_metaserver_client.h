@@ -56,6 +56,8 @@ class MockMetaServerClient : public MetaServerClient {
 
     MOCK_METHOD2(SetTxId, void(uint32_t partitionId, uint64_t txId));
 
+    MOCK_METHOD1(RefreshTxId, bool(uint32_t fsId));
+
     MOCK_METHOD4(GetDentry, MetaStatusCode(uint32_t fsId, uint64_t inodeid,
                   const std::string &name, Dentry *out));
 
@@ -74,11 +76,19 @@ class MockMetaServerClient : public MetaServerClient {
     MOCK_METHOD3(GetInode, MetaStatusCode(
             uint32_t fsId, uint64_t inodeid, Inode *out));
 
+    MOCK_METHOD3(BatchGetInodeAttr, MetaStatusCode(
+            uint32_t fsId, const std::set<uint64_t> &inodeIds,
+            std::list<InodeAttr> *attrs));
+
     MOCK_METHOD1(UpdateInode, MetaStatusCode(const Inode &inode));
 
     MOCK_METHOD2(UpdateInodeAsync, void(const Inode &inode,
         MetaServerClientDone *done));
 
+    MOCK_METHOD3(BatchUpdateInodeAsync, void(
+        const BatchUpdateInodeRequest &request,
+        BatchUpdateInodeResponse *response, MetaServerClientDone *done));
+
     MOCK_METHOD5(GetOrModifyS3ChunkInfo, MetaStatusCode(
         uint32_t fsId, uint64_t inodeId,
         const google::protobuf::Map<
@@ -97,6 +107,20 @@ class MockMetaServerClient : public MetaServerClient {
             const InodeParam &param, Inode *out));
 
     MOCK_METHOD2(DeleteInode, MetaStatusCode(uint32_t fsId, uint64_t inodeid));
+
+    MOCK_METHOD3(CreateInodeAndDentry, MetaStatusCode(
+            const InodeParam &param, Dentry *dentry, Inode *out));
+
+    MOCK_METHOD4(UnlinkDentryAndDecNlink, MetaStatusCode(uint32_t fsId,
+            uint64_t parentInodeId, const std::string &name,
+            uint64_t inodeid));
+
+    MOCK_METHOD4(Rename, MetaStatusCode(const Dentry &dentry,
+            const Dentry &newDentry, uint64_t *txId, uint64_t *dstTxId));
+
+    MOCK_METHOD7(UpdateDirStat, MetaStatusCode(uint32_t fsId,
+            uint64_t inodeId, const DirStat &delta, uint64_t requestId,
+            uint64_t newParent, uint64_t *parent, DirStat *stat));
 };
 
 }  // namespace rpcclient
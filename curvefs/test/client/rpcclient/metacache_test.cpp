@@ -246,6 +246,29 @@ TEST_F(MetaCacheTest, SetTxId) {
     succ = metaCache_.GetTxId(fsId, inodeId, &partitionId, &txId);
     ASSERT_EQ(partitionId, expect.partitionID);
     ASSERT_EQ(txId, 123);
+
+    // CASE 3: SetTxId with smaller txid, txid doesn't go back
+    metaCache_.SetTxId(partitionId, 100);
+    succ = metaCache_.GetTxId(fsId, inodeId, &partitionId, &txId);
+    ASSERT_EQ(partitionId, expect.partitionID);
+    ASSERT_EQ(txId, 123);
+
+    // CASE 4: RefreshTxId fail
+    EXPECT_CALL(*mockMdsClient_.get(), ListPartition(fsId, _))
+        .WillOnce(Return(false));
+    ASSERT_FALSE(metaCache_.RefreshTxId(fsId));
+
+    // CASE 5: RefreshTxId gets the txid committed by others
+    auto partitions = pInfoList_;
+    for (auto &partition : partitions) {
+        partition.set_txid(200);
+    }
+    EXPECT_CALL(*mockMdsClient_.get(), ListPartition(fsId, _))
+        .WillOnce(DoAll(SetArgPointee<1>(partitions), Return(true)));
+    ASSERT_TRUE(metaCache_.RefreshTxId(fsId));
+    succ = metaCache_.GetTxId(fsId, inodeId, &partitionId, &txId);
+    ASSERT_EQ(partitionId, expect.partitionID);
+    ASSERT_EQ(txId, 200);
 }
 
 TEST_F(MetaCacheTest, test_SelectTarget) {
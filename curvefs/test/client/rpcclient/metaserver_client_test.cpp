@@ -25,6 +25,8 @@
 #include <gtest/gtest.h>
 #include <google/protobuf/util/message_differencer.h>
 
+#include <future>  // NOLINT
+
 #include "curvefs/src/client/rpcclient/metaserver_client.h"
 #include "curvefs/test/client/rpcclient/mock_metacache.h"
 #include "curvefs/test/client/rpcclient/mock_metaserver_service.h"
@@ -39,6 +41,7 @@ using ::testing::_;
 using ::testing::DoAll;
 using ::testing::Invoke;
 using ::testing::Return;
+using ::testing::SaveArgPointee;
 using ::testing::SetArgPointee;
 
 using ::curvefs::metaserver::Dentry;
@@ -572,6 +575,77 @@ TEST_F(MetaServerClientImplTest, PrepareRenameTx) {
     ASSERT_EQ(rc, MetaStatusCode::RPC_ERROR);
 }
 
+TEST_F(MetaServerClientImplTest, test_Rename) {
+    curvefs::metaserver::RenameResponse response;
+    uint64_t applyIndex = 10;
+    Dentry dentry;
+    dentry.set_fsid(1);
+    dentry.set_inodeid(2);
+    dentry.set_parentinodeid(3);
+    dentry.set_name("A");
+    dentry.set_txid(4);
+    Dentry newDentry(dentry);
+    newDentry.set_parentinodeid(5);
+    newDentry.set_name("B");
+    newDentry.set_txid(6);
+
+    CopysetTarget dstTarget = target_;
+    dstTarget.groupID = CopysetGroupID(1, 101);
+    dstTarget.partitionID = 201;
+    EXPECT_CALL(*mockMetacache_.get(), GetTarget(_, 3, _, _, _))
+        .WillRepeatedly(DoAll(SetArgPointee<2>(target_),
+                              SetArgPointee<3>(applyIndex), Return(true)));
+    EXPECT_CALL(*mockMetacache_.get(), GetTarget(_, 5, _, _, _))
+        .WillRepeatedly(DoAll(SetArgPointee<2>(dstTarget),
+                              SetArgPointee<3>(applyIndex), Return(true)));
+
+    // CASE 1: Rename success
+    response.set_statuscode(MetaStatusCode::OK);
+    response.set_appliedindex(applyIndex);
+    response.set_txid(5);
+    response.set_dsttxid(7);
+    RenameRequest request;
+    EXPECT_CALL(mockMetaServerService_, Rename(_, _, _, _))
+        .WillOnce(DoAll(SaveArgPointee<1>(&request),
+                        SetArgPointee<2>(response),
+                        Invoke(SetRpcService<RenameRequest,
+                                             RenameResponse>)));
+    EXPECT_CALL(*mockMetacache_.get(), UpdateApplyIndex(_, _));
+
+    uint64_t txId = 0;
+    uint64_t dstTxId = 0;
+    auto rc = metaserverCli_.Rename(dentry, newDentry, &txId, &dstTxId);
+    ASSERT_EQ(rc, MetaStatusCode::OK);
+    ASSERT_EQ(txId, 5);
+    ASSERT_EQ(dstTxId, 7);
+    ASSERT_EQ(request.partitionid(), target_.partitionID);
+    ASSERT_EQ(request.dstpoolid(), dstTarget.groupID.poolID);
+    ASSERT_EQ(request.dstcopysetid(), dstTarget.groupID.copysetID);
+    ASSERT_EQ(request.dstpartitionid(), dstTarget.partitionID);
+    ASSERT_EQ(request.dstleaderaddr(), addr_);
+    ASSERT_EQ(request.dentry().txid(), 4);
+    ASSERT_EQ(request.newdentry().txid(), 6);
+
+    // CASE 2: Rename fail
+    response.set_statuscode(MetaStatusCode::RPC_ERROR);
+    EXPECT_CALL(mockMetaServerService_, Rename(_, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(response),
+                        Invoke(SetRpcService<RenameRequest,
+                                             RenameResponse>)));
+
+    rc = metaserverCli_.Rename(dentry, newDentry, &txId, &dstTxId);
+    ASSERT_EQ(rc, MetaStatusCode::RPC_ERROR);
+
+    // CASE 3: get target of destination fail, no rpc is sent
+    EXPECT_CALL(*mockMetacache_.get(), GetTarget(_, 5, _, _, _))
+        .WillRepeatedly(Return(false));
+    EXPECT_CALL(mockMetaServerService_, Rename(_, _, _, _))
+        .Times(0);
+
+    rc = metaserverCli_.Rename(dentry, newDentry, &txId, &dstTxId);
+    ASSERT_EQ(rc, MetaStatusCode::RPC_ERROR);
+}
+
 TEST_F(MetaServerClientImplTest, test_GetInode) {
     // in
     uint32_t fsid = 1;
@@ -665,6 +739,81 @@ TEST_F(MetaServerClientImplTest, test_GetInode) {
     ASSERT_EQ(MetaStatusCode::RPC_ERROR, status);
 }
 
+TEST_F(MetaServerClientImplTest, test_BatchGetInodeAttr) {
+    // in
+    uint32_t fsid = 1;
+    std::set<uint64_t> inodeIds{2, 3, 4};
+
+    // out
+    uint64_t applyIndex = 10;
+    std::list<curvefs::metaserver::InodeAttr> attrs;
+
+    curvefs::metaserver::BatchGetInodeAttrResponse response;
+    EXPECT_CALL(*mockMetacache_.get(), GetTarget(_, _, _, _, _))
+        .WillRepeatedly(DoAll(SetArgPointee<2>(target_),
+                              SetArgPointee<3>(applyIndex), Return(true)));
+
+    // test0: list partitions fail
+    EXPECT_CALL(*mockMetacache_.get(), GroupInodesByPartition(fsid, _, _))
+        .WillOnce(Return(false));
+    MetaStatusCode status =
+        metaserverCli_.BatchGetInodeAttr(fsid, inodeIds, &attrs);
+    ASSERT_EQ(MetaStatusCode::RPC_ERROR, status);
+
+    std::map<uint32_t, std::vector<uint64_t>> groups{{1, {2}}, {2, {3}}};
+    EXPECT_CALL(*mockMetacache_.get(), GroupInodesByPartition(fsid, _, _))
+        .WillRepeatedly(DoAll(SetArgPointee<2>(groups), Return(true)));
+
+    // test1: rpc error
+    EXPECT_CALL(mockMetaServerService_, BatchGetInodeAttr(_, _, _, _))
+        .WillRepeatedly(Invoke(SetRpcService<BatchGetInodeAttrRequest,
+                                             BatchGetInodeAttrResponse, true>));
+    status = metaserverCli_.BatchGetInodeAttr(fsid, inodeIds, &attrs);
+    ASSERT_EQ(MetaStatusCode::RPC_ERROR, status);
+
+    // test2: one rpc per partition, inode 4 is not in any partition
+    response.set_statuscode(MetaStatusCode::OK);
+    response.set_appliedindex(10);
+    auto *attr = response.add_attr();
+    attr->set_inodeid(2);
+    attr->set_fsid(fsid);
+    attr->set_length(10);
+    attr->set_ctime(1623835517);
+    attr->set_ctime_ns(0);
+    attr->set_mtime(1623835517);
+    attr->set_mtime_ns(0);
+    attr->set_atime(1623835517);
+    attr->set_atime_ns(0);
+    attr->set_uid(1);
+    attr->set_gid(1);
+    attr->set_mode(1);
+    attr->set_nlink(1);
+    attr->set_type(curvefs::metaserver::FsFileType::TYPE_FILE);
+    EXPECT_CALL(mockMetaServerService_, BatchGetInodeAttr(_, _, _, _))
+        .Times(2)
+        .WillRepeatedly(DoAll(
+            SetArgPointee<2>(response),
+            Invoke(SetRpcService<BatchGetInodeAttrRequest,
+                                 BatchGetInodeAttrResponse>)));
+    EXPECT_CALL(*mockMetacache_.get(), UpdateApplyIndex(_, _)).Times(2);
+
+    status = metaserverCli_.BatchGetInodeAttr(fsid, inodeIds, &attrs);
+    ASSERT_EQ(MetaStatusCode::OK, status);
+    ASSERT_EQ(2, attrs.size());
+    ASSERT_EQ(2, attrs.front().inodeid());
+
+    // test3: response do not have applyindex
+    attrs.clear();
+    response.clear_appliedindex();
+    EXPECT_CALL(mockMetaServerService_, BatchGetInodeAttr(_, _, _, _))
+        .WillRepeatedly(DoAll(
+            SetArgPointee<2>(response),
+            Invoke(SetRpcService<BatchGetInodeAttrRequest,
+                                 BatchGetInodeAttrResponse>)));
+    status = metaserverCli_.BatchGetInodeAttr(fsid, inodeIds, &attrs);
+    ASSERT_EQ(MetaStatusCode::RPC_ERROR, status);
+}
+
 TEST_F(MetaServerClientImplTest, test_UpdateInode) {
     // in
     curvefs::metaserver::Inode inode;
@@ -749,6 +898,80 @@ TEST_F(MetaServerClientImplTest, test_UpdateInode) {
     ASSERT_EQ(MetaStatusCode::RPC_ERROR, status);
 }
 
+class BatchUpdateInodeTestDone : public MetaServerClientDone {
+ public:
+    void Run() override {
+        status.set_value(GetStatusCode());
+    }
+
+    std::promise<MetaStatusCode> status;
+};
+
+TEST_F(MetaServerClientImplTest, test_BatchUpdateInodeAsync) {
+    uint32_t fsId = 1;
+    uint64_t applyIndex = 10;
+
+    BatchUpdateInodeRequest request;
+    request.set_fsid(fsId);
+    auto *update = request.add_updateinode();
+    update->set_fsid(fsId);
+    update->set_inodeid(100);
+    update->set_length(4096);
+    auto *add = request.add_s3chunkinfoadd();
+    add->set_inodeid(101);
+    (*add->mutable_s3chunkinfoadd())[0].add_s3chunks()->set_chunkid(1);
+
+    // test1: success, location of request and inodes are filled in
+    BatchUpdateInodeRequest sent;
+    BatchUpdateInodeResponse response;
+    response.set_statuscode(curvefs::metaserver::OK);
+    response.set_appliedindex(applyIndex);
+    EXPECT_CALL(mockMetaServerService_, BatchUpdateInode(_, _, _, _))
+        .WillOnce(DoAll(
+            SaveArgPointee<1>(&sent),
+            SetArgPointee<2>(response),
+            Invoke(SetRpcService<BatchUpdateInodeRequest,
+                                 BatchUpdateInodeResponse>)));
+    EXPECT_CALL(*mockMetacache_.get(), GetTarget(fsId, 100, _, _, _))
+        .WillRepeatedly(DoAll(SetArgPointee<2>(target_),
+                              SetArgPointee<3>(applyIndex), Return(true)));
+    EXPECT_CALL(*mockMetacache_.get(), UpdateApplyIndex(_, _));
+
+    BatchUpdateInodeTestDone done1;
+    BatchUpdateInodeResponse out;
+    metaserverCli_.BatchUpdateInodeAsync(request, &out, &done1);
+    ASSERT_EQ(MetaStatusCode::OK, done1.status.get_future().get());
+    ASSERT_EQ(MetaStatusCode::OK, out.statuscode());
+    ASSERT_EQ(target_.partitionID, sent.partitionid());
+    ASSERT_EQ(1, sent.updateinode_size());
+    ASSERT_EQ(target_.groupID.poolID, sent.updateinode(0).poolid());
+    ASSERT_EQ(target_.groupID.copysetID, sent.updateinode(0).copysetid());
+    ASSERT_EQ(target_.partitionID, sent.updateinode(0).partitionid());
+    ASSERT_EQ(1, sent.s3chunkinfoadd_size());
+    ASSERT_EQ(101, sent.s3chunkinfoadd(0).inodeid());
+
+    // test2: overload, the failed inodes are returned
+    response.set_statuscode(curvefs::metaserver::OVERLOAD);
+    response.add_failedinodeid(100);
+    EXPECT_CALL(mockMetaServerService_, BatchUpdateInode(_, _, _, _))
+        .WillRepeatedly(DoAll(
+            SetArgPointee<2>(response),
+            Invoke(SetRpcService<BatchUpdateInodeRequest,
+                                 BatchUpdateInodeResponse>)));
+    BatchUpdateInodeTestDone done2;
+    metaserverCli_.BatchUpdateInodeAsync(request, &out, &done2);
+    ASSERT_EQ(MetaStatusCode::OVERLOAD, done2.status.get_future().get());
+    ASSERT_EQ(1, out.failedinodeid_size());
+    ASSERT_EQ(100, out.failedinodeid(0));
+
+    // test3: get target always fail
+    EXPECT_CALL(*mockMetacache_.get(), GetTarget(_, _, _, _, _))
+        .WillRepeatedly(Return(false));
+    BatchUpdateInodeTestDone done3;
+    metaserverCli_.BatchUpdateInodeAsync(request, &out, &done3);
+    ASSERT_EQ(MetaStatusCode::RPC_ERROR, done3.status.get_future().get());
+}
+
 TEST_F(MetaServerClientImplTest, test_GetOrModifyS3ChunkInfo) {
     uint32_t fsId = 1;
     uint64_t inodeId = 100;
@@ -779,8 +1002,9 @@ TEST_F(MetaServerClientImplTest, test_GetOrModifyS3ChunkInfo) {
 
     ASSERT_EQ(MetaStatusCode::OK, status);
 
-    // test2: overload
+    // test2: overload, the failed inodes are returned
     response.set_statuscode(curvefs::metaserver::OVERLOAD);
+    response.add_failedinodeid(100);
     EXPECT_CALL(mockMetaServerService_, GetOrModifyS3ChunkInfo(_, _, _, _))
         .WillRepeatedly(DoAll(
             SetArgPointee<2>(response),
@@ -992,6 +1216,235 @@ TEST_F(MetaServerClientImplTest, test_DeleteInode) {
     ASSERT_EQ(MetaStatusCode::RPC_ERROR, status);
 }
 
+TEST_F(MetaServerClientImplTest, test_UpdateDirStat) {
+    // in
+    uint32_t fsId = 2;
+    uint64_t inodeid = 10;
+    DirStat delta;
+    delta.set_bytes(4096);
+    delta.set_files(1);
+    delta.set_subdirs(0);
+
+    // out
+    uint64_t applyIndex = 10;
+    uint64_t parent = 0;
+    DirStat stat;
+
+    curvefs::metaserver::UpdateDirStatResponse response;
+
+    // test0: rpc error
+    EXPECT_CALL(mockMetaServerService_, UpdateDirStat(_, _, _, _))
+        .WillRepeatedly(Invoke(
+            SetRpcService<UpdateDirStatRequest, UpdateDirStatResponse, true>));
+    EXPECT_CALL(*mockMetacache_.get(), GetTarget(_, _, _, _, _))
+        .WillRepeatedly(DoAll(SetArgPointee<2>(target_),
+                              SetArgPointee<3>(applyIndex), Return(true)));
+    MetaStatusCode status = metaserverCli_.UpdateDirStat(
+        fsId, inodeid, delta, 0, 0, &parent, nullptr);
+    ASSERT_EQ(MetaStatusCode::RPC_ERROR, status);
+
+    // test1: add delta ok, the parent is returned
+    UpdateDirStatRequest request;
+    response.set_statuscode(MetaStatusCode::OK);
+    response.set_appliedindex(10);
+    response.set_parent(1);
+    EXPECT_CALL(mockMetaServerService_, UpdateDirStat(_, _, _, _))
+        .WillOnce(DoAll(
+            SaveArgPointee<1>(&request), SetArgPointee<2>(response),
+            Invoke(SetRpcService<UpdateDirStatRequest,
+                                 UpdateDirStatResponse>)));
+    EXPECT_CALL(*mockMetacache_.get(), UpdateApplyIndex(_, _));
+    status = metaserverCli_.UpdateDirStat(fsId, inodeid, delta, 1000, 0,
+                                          &parent, nullptr);
+    ASSERT_EQ(MetaStatusCode::OK, status);
+    ASSERT_EQ(1, parent);
+    ASSERT_EQ(4096, request.delta().bytes());
+    ASSERT_EQ(1000, request.requestid());
+    ASSERT_FALSE(request.has_parent());
+
+    // test2: reparent only, the stat is returned
+    response.mutable_stat()->set_bytes(100);
+    response.mutable_stat()->set_files(2);
+    response.mutable_stat()->set_subdirs(3);
+    response.set_parent(20);
+    EXPECT_CALL(mockMetaServerService_, UpdateDirStat(_, _, _, _))
+        .WillOnce(DoAll(
+            SaveArgPointee<1>(&request), SetArgPointee<2>(response),
+            Invoke(SetRpcService<UpdateDirStatRequest,
+                                 UpdateDirStatResponse>)));
+    EXPECT_CALL(*mockMetacache_.get(), UpdateApplyIndex(_, _));
+    status = metaserverCli_.UpdateDirStat(fsId, inodeid, DirStat(), 0, 20,
+                                          &parent, &stat);
+    ASSERT_EQ(MetaStatusCode::OK, status);
+    ASSERT_FALSE(request.has_delta());
+    ASSERT_EQ(20, request.parent());
+    ASSERT_EQ(20, parent);
+    ASSERT_EQ(100, stat.bytes());
+    ASSERT_EQ(3, stat.subdirs());
+
+    // test3: inode not found
+    response.set_statuscode(MetaStatusCode::NOT_FOUND);
+    EXPECT_CALL(mockMetaServerService_, UpdateDirStat(_, _, _, _))
+        .WillOnce(DoAll(
+            SetArgPointee<2>(response),
+            Invoke(SetRpcService<UpdateDirStatRequest,
+                                 UpdateDirStatResponse>)));
+    status = metaserverCli_.UpdateDirStat(fsId, inodeid, delta, 0, 0,
+                                          &parent, nullptr);
+    ASSERT_EQ(MetaStatusCode::NOT_FOUND, status);
+}
+
+TEST_F(MetaServerClientImplTest, test_CreateInodeAndDentry) {
+    // in
+    InodeParam inode;
+    inode.fsId = 2;
+    inode.length = 0;
+    inode.uid = 1;
+    inode.gid = 1;
+    inode.mode = 1;
+    inode.type = curvefs::metaserver::FsFileType::TYPE_FILE;
+    inode.rdev = 0;
+    Dentry dentry;
+    dentry.set_fsid(inode.fsId);
+    dentry.set_parentinodeid(1);
+    dentry.set_name("test10");
+    dentry.set_flag(1);
+
+    // out
+    uint64_t applyIndex = 10;
+    curvefs::metaserver::Inode out;
+    out.set_inodeid(100);
+    out.set_fsid(inode.fsId);
+    out.set_length(inode.length);
+    out.set_ctime(1623835517);
+    out.set_ctime_ns(0);
+    out.set_mtime(1623835517);
+    out.set_mtime_ns(0);
+    out.set_atime(1623835517);
+    out.set_atime_ns(0);
+    out.set_uid(inode.uid);
+    out.set_gid(inode.gid);
+    out.set_mode(inode.mode);
+    out.set_nlink(1);
+    out.set_type(inode.type);
+
+    curvefs::metaserver::CreateInodeAndDentryResponse response;
+
+    // test1: create ok in the partition of parent
+    response.set_statuscode(MetaStatusCode::OK);
+    response.set_appliedindex(10);
+    response.mutable_inode()->CopyFrom(out);
+    CreateInodeAndDentryRequest request;
+    EXPECT_CALL(mockMetaServerService_, CreateInodeAndDentry(_, _, _, _))
+        .WillOnce(DoAll(
+            SaveArgPointee<1>(&request), SetArgPointee<2>(response),
+            Invoke(SetRpcService<CreateInodeAndDentryRequest,
+                                 CreateInodeAndDentryResponse>)));
+    EXPECT_CALL(*mockMetacache_.get(), GetTarget(_, 1, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(target_), SetArgPointee<3>(applyIndex),
+                        Return(true)));
+    EXPECT_CALL(*mockMetacache_.get(), UpdateApplyIndex(_, _));
+    curvefs::metaserver::Inode created;
+    MetaStatusCode status =
+        metaserverCli_.CreateInodeAndDentry(inode, &dentry, &created);
+    ASSERT_EQ(MetaStatusCode::OK, status);
+    ASSERT_EQ(100, created.inodeid());
+    ASSERT_EQ(100, dentry.inodeid());
+    ASSERT_EQ(1, request.parentinodeid());
+    ASSERT_EQ("test10", request.name());
+    ASSERT_EQ(1, request.flag());
+    ASSERT_EQ(target_.partitionID, request.partitionid());
+
+    // test2: partition of parent has no inode id left, no retry
+    response.set_statuscode(MetaStatusCode::PARTITION_ALLOC_ID_FAIL);
+    EXPECT_CALL(mockMetaServerService_, CreateInodeAndDentry(_, _, _, _))
+        .WillOnce(DoAll(
+            SetArgPointee<2>(response),
+            Invoke(SetRpcService<CreateInodeAndDentryRequest,
+                                 CreateInodeAndDentryResponse>)));
+    EXPECT_CALL(*mockMetacache_.get(), GetTarget(_, 1, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(target_), SetArgPointee<3>(applyIndex),
+                        Return(true)));
+    EXPECT_CALL(*mockMetacache_.get(),
+                MarkPartitionUnavailable(target_.partitionID))
+        .WillOnce(Return(true));
+    status = metaserverCli_.CreateInodeAndDentry(inode, &dentry, &created);
+    ASSERT_EQ(MetaStatusCode::PARTITION_ALLOC_ID_FAIL, status);
+
+    // test3: dentry exist
+    response.set_statuscode(MetaStatusCode::DENTRY_EXIST);
+    EXPECT_CALL(mockMetaServerService_, CreateInodeAndDentry(_, _, _, _))
+        .WillOnce(DoAll(
+            SetArgPointee<2>(response),
+            Invoke(SetRpcService<CreateInodeAndDentryRequest,
+                                 CreateInodeAndDentryResponse>)));
+    EXPECT_CALL(*mockMetacache_.get(), GetTarget(_, 1, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(target_), SetArgPointee<3>(applyIndex),
+                        Return(true)));
+    status = metaserverCli_.CreateInodeAndDentry(inode, &dentry, &created);
+    ASSERT_EQ(MetaStatusCode::DENTRY_EXIST, status);
+}
+
+TEST_F(MetaServerClientImplTest, test_UnlinkDentryAndDecNlink) {
+    // in
+    uint32_t fsId = 2;
+    uint64_t parent = 1;
+    uint64_t inodeid = 100;
+    std::string name = "test11";
+
+    // out
+    uint64_t applyIndex = 10;
+
+    curvefs::metaserver::UnlinkDentryAndDecNlinkResponse response;
+
+    // test1: inode is not in the partition of parent, no rpc is sent
+    EXPECT_CALL(*mockMetacache_.get(), GetTxId(fsId, parent, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(1), Return(true)));
+    EXPECT_CALL(*mockMetacache_.get(), GetTxId(fsId, inodeid, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(2), Return(true)));
+    EXPECT_CALL(mockMetaServerService_, UnlinkDentryAndDecNlink(_, _, _, _))
+        .Times(0);
+    MetaStatusCode status =
+        metaserverCli_.UnlinkDentryAndDecNlink(fsId, parent, name, inodeid);
+    ASSERT_EQ(MetaStatusCode::PARTITION_ID_MISSMATCH, status);
+
+    // test2: unlink ok
+    response.set_statuscode(MetaStatusCode::OK);
+    response.set_appliedindex(10);
+    UnlinkDentryAndDecNlinkRequest request;
+    EXPECT_CALL(*mockMetacache_.get(), GetTxId(fsId, _, _, _))
+        .WillRepeatedly(DoAll(SetArgPointee<2>(1), Return(true)));
+    EXPECT_CALL(mockMetaServerService_, UnlinkDentryAndDecNlink(_, _, _, _))
+        .WillOnce(DoAll(
+            SaveArgPointee<1>(&request), SetArgPointee<2>(response),
+            Invoke(SetRpcService<UnlinkDentryAndDecNlinkRequest,
+                                 UnlinkDentryAndDecNlinkResponse>)));
+    EXPECT_CALL(*mockMetacache_.get(), GetTarget(_, parent, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(target_), SetArgPointee<3>(applyIndex),
+                        Return(true)));
+    EXPECT_CALL(*mockMetacache_.get(), UpdateApplyIndex(_, _));
+    status =
+        metaserverCli_.UnlinkDentryAndDecNlink(fsId, parent, name, inodeid);
+    ASSERT_EQ(MetaStatusCode::OK, status);
+    ASSERT_EQ(parent, request.parentinodeid());
+    ASSERT_EQ(name, request.name());
+    ASSERT_EQ(inodeid, request.inodeid());
+
+    // test3: the inode has moved to another partition
+    response.set_statuscode(MetaStatusCode::PARTITION_ID_MISSMATCH);
+    EXPECT_CALL(mockMetaServerService_, UnlinkDentryAndDecNlink(_, _, _, _))
+        .WillOnce(DoAll(
+            SetArgPointee<2>(response),
+            Invoke(SetRpcService<UnlinkDentryAndDecNlinkRequest,
+                                 UnlinkDentryAndDecNlinkResponse>)));
+    EXPECT_CALL(*mockMetacache_.get(), GetTarget(_, parent, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(target_), SetArgPointee<3>(applyIndex),
+                        Return(true)));
+    status =
+        metaserverCli_.UnlinkDentryAndDecNlink(fsId, parent, name, inodeid);
+    ASSERT_EQ(MetaStatusCode::PARTITION_ID_MISSMATCH, status);
+}
+
 }  // namespace rpcclient
 }  // namespace client
 }  // namespace curvefs
@@ -38,6 +38,15 @@ class MockMetaCache : public MetaCache {
                  bool(uint32_t fsID, uint64_t inodeID, CopysetTarget *target,
                       uint64_t *applyIndex, bool refresh));
 
+    MOCK_METHOD4(GetTxId, bool(uint32_t fsId, uint64_t inodeId,
+                               uint32_t *partitionId, uint64_t *txId));
+
+    MOCK_METHOD1(RefreshTxId, bool(uint32_t fsId));
+
+    MOCK_METHOD3(GroupInodesByPartition,
+                 bool(uint32_t fsID, const std::set<uint64_t> &inodeIDs,
+                      std::map<uint32_t, std::vector<uint64_t>> *groups));
+
     MOCK_METHOD3(SelectTarget, bool(uint32_t fsID, CopysetTarget *target,
                                     uint64_t *applyIndex));
 
@@ -63,11 +63,31 @@ class MockMetaServerService : public curvefs::metaserver::MetaServerService {
              ::curvefs::metaserver::PrepareRenameTxResponse* response,
              ::google::protobuf::Closure* done));
 
+    MOCK_METHOD4(
+        Rename,
+        void(::google::protobuf::RpcController* controller,
+             const ::curvefs::metaserver::RenameRequest* request,
+             ::curvefs::metaserver::RenameResponse* response,
+             ::google::protobuf::Closure* done));
+
+    MOCK_METHOD4(
+        UpdateDirStat,
+        void(::google::protobuf::RpcController* controller,
+             const ::curvefs::metaserver::UpdateDirStatRequest* request,
+             ::curvefs::metaserver::UpdateDirStatResponse* response,
+             ::google::protobuf::Closure* done));
+
     MOCK_METHOD4(GetInode,
                  void(::google::protobuf::RpcController *controller,
                       const ::curvefs::metaserver::GetInodeRequest *request,
                       ::curvefs::metaserver::GetInodeResponse *response,
                       ::google::protobuf::Closure *done));
+    MOCK_METHOD4(
+        BatchGetInodeAttr,
+        void(::google::protobuf::RpcController *controller,
+             const ::curvefs::metaserver::BatchGetInodeAttrRequest *request,
+             ::curvefs::metaserver::BatchGetInodeAttrResponse *response,
+             ::google::protobuf::Closure *done));
     MOCK_METHOD4(CreateInode,
                  void(::google::protobuf::RpcController *controller,
                       const ::curvefs::metaserver::CreateInodeRequest *request,
@@ -78,6 +98,11 @@ class MockMetaServerService : public curvefs::metaserver::MetaServerService {
                       const ::curvefs::metaserver::UpdateInodeRequest *request,
                       ::curvefs::metaserver::UpdateInodeResponse *response,
                       ::google::protobuf::Closure *done));
+    MOCK_METHOD4(BatchUpdateInode,
+        void(::google::protobuf::RpcController *controller,
+             const ::curvefs::metaserver::BatchUpdateInodeRequest *request,
+             ::curvefs::metaserver::BatchUpdateInodeResponse *response,
+             ::google::protobuf::Closure *done));
     MOCK_METHOD4(DeleteInode,
                  void(::google::protobuf::RpcController *controller,
                       const ::curvefs::metaserver::DeleteInodeRequest *request,
@@ -89,6 +114,18 @@ class MockMetaServerService : public curvefs::metaserver::MetaServerService {
             const ::curvefs::metaserver::GetOrModifyS3ChunkInfoRequest *request,
              ::curvefs::metaserver::GetOrModifyS3ChunkInfoResponse *response,
              ::google::protobuf::Closure *done));
+
+    MOCK_METHOD4(CreateInodeAndDentry,
+        void(::google::protobuf::RpcController *controller,
+             const ::curvefs::metaserver::CreateInodeAndDentryRequest *request,
+             ::curvefs::metaserver::CreateInodeAndDentryResponse *response,
+             ::google::protobuf::Closure *done));
+    MOCK_METHOD4(UnlinkDentryAndDecNlink,
+        void(::google::protobuf::RpcController *controller,
+             const ::curvefs::metaserver::UnlinkDentryAndDecNlinkRequest
+                 *request,
+             ::curvefs::metaserver::UnlinkDentryAndDecNlinkResponse *response,
+             ::google::protobuf::Closure *done));
 };
 }  // namespace rpcclient
 }  // namespace client
@@ -23,6 +23,7 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <google/protobuf/util/message_differencer.h>
+#include <unistd.h>
 
 #include "curvefs/test/client/mock_metaserver_client.h"
 #include "curvefs/src/client/dentry_cache_manager.h"
@@ -48,7 +49,7 @@ class TestDentryCacheManager : public ::testing::Test {
         metaClient_ = std::make_shared<MockMetaServerClient>();
         dCacheManager_ = std::make_shared<DentryCacheManagerImpl>(metaClient_);
         dCacheManager_->SetFsId(fsId_);
-        dCacheManager_->Init(10, true);
+        dCacheManager_->Init(10, true, 0);
     }
 
     virtual void TearDown() {
@@ -121,6 +122,62 @@ TEST_F(TestDentryCacheManager, CreateAndGetDentry) {
         google::protobuf::util::MessageDifferencer::Equals(dentryExp, out));
 }
 
+TEST_F(TestDentryCacheManager, NegativeCache) {
+    uint64_t parent = 99;
+    uint64_t inodeid = 100;
+    const std::string name = "test";
+    Dentry out;
+
+    // enable negative cache
+    dCacheManager_->Init(10, true, 100);
+
+    EXPECT_CALL(*metaClient_, GetDentry(fsId_, parent, name, _))
+        .Times(2)
+        .WillRepeatedly(Return(MetaStatusCode::NOT_FOUND));
+
+    // the second lookup hits the negative cache
+    CURVEFS_ERROR ret = dCacheManager_->GetDentry(parent, name, &out);
+    ASSERT_EQ(CURVEFS_ERROR::NOTEXIST, ret);
+    ret = dCacheManager_->GetDentry(parent, name, &out);
+    ASSERT_EQ(CURVEFS_ERROR::NOTEXIST, ret);
+
+    // other name of the same parent is not affected
+    EXPECT_CALL(*metaClient_, GetDentry(fsId_, parent, "other", _))
+        .WillOnce(Return(MetaStatusCode::NOT_FOUND));
+    ret = dCacheManager_->GetDentry(parent, "other", &out);
+    ASSERT_EQ(CURVEFS_ERROR::NOTEXIST, ret);
+
+    // negative entry expired
+    usleep(150 * 1000);
+    ret = dCacheManager_->GetDentry(parent, name, &out);
+    ASSERT_EQ(CURVEFS_ERROR::NOTEXIST, ret);
+
+    // negative entry is dropped after the name is created
+    Dentry dentry;
+    dentry.set_fsid(fsId_);
+    dentry.set_name(name);
+    dentry.set_parentinodeid(parent);
+    dentry.set_inodeid(inodeid);
+    EXPECT_CALL(*metaClient_, CreateDentry(_))
+        .WillOnce(Return(MetaStatusCode::OK));
+    ASSERT_EQ(CURVEFS_ERROR::OK, dCacheManager_->CreateDentry(dentry));
+    ret = dCacheManager_->GetDentry(parent, name, &out);
+    ASSERT_EQ(CURVEFS_ERROR::OK, ret);
+    ASSERT_EQ(inodeid, out.inodeid());
+
+    // the name is cached as not exist after deleted
+    EXPECT_CALL(*metaClient_, DeleteDentry(fsId_, parent, name))
+        .WillOnce(Return(MetaStatusCode::OK));
+    ASSERT_EQ(CURVEFS_ERROR::OK, dCacheManager_->DeleteDentry(parent, name));
+    ret = dCacheManager_->GetDentry(parent, name, &out);
+    ASSERT_EQ(CURVEFS_ERROR::NOTEXIST, ret);
+
+    // negative entry is dropped by inserting the dentry into cache
+    dCacheManager_->InsertOrReplaceCache(dentry);
+    ret = dCacheManager_->GetDentry(parent, name, &out);
+    ASSERT_EQ(CURVEFS_ERROR::OK, ret);
+}
+
 TEST_F(TestDentryCacheManager, DeleteDentry) {
     uint64_t parent = 99;
     const std::string name = "test";
@@ -136,6 +193,41 @@ TEST_F(TestDentryCacheManager, DeleteDentry) {
     ASSERT_EQ(CURVEFS_ERROR::OK, ret);
 }
 
+TEST_F(TestDentryCacheManager, UnlinkDentryAndDecNlink) {
+    uint64_t parent = 99;
+    uint64_t inodeid = 100;
+    const std::string name = "test";
+    Dentry out;
+
+    Dentry dentry;
+    dentry.set_fsid(fsId_);
+    dentry.set_name(name);
+    dentry.set_parentinodeid(parent);
+    dentry.set_inodeid(inodeid);
+    dCacheManager_->InsertOrReplaceCache(dentry);
+
+    // the inode isn't in the partition of parent, cache is kept
+    EXPECT_CALL(*metaClient_,
+                UnlinkDentryAndDecNlink(fsId_, parent, name, inodeid))
+        .WillOnce(Return(MetaStatusCode::PARTITION_ID_MISSMATCH))
+        .WillOnce(Return(MetaStatusCode::UNKNOWN_ERROR))
+        .WillOnce(Return(MetaStatusCode::OK));
+    CURVEFS_ERROR ret =
+        dCacheManager_->UnlinkDentryAndDecNlink(parent, name, inodeid);
+    ASSERT_EQ(CURVEFS_ERROR::NOTSUPPORT, ret);
+    ASSERT_EQ(CURVEFS_ERROR::OK, dCacheManager_->GetDentry(parent, name, &out));
+
+    ret = dCacheManager_->UnlinkDentryAndDecNlink(parent, name, inodeid);
+    ASSERT_EQ(CURVEFS_ERROR::UNKNOWN, ret);
+
+    ret = dCacheManager_->UnlinkDentryAndDecNlink(parent, name, inodeid);
+    ASSERT_EQ(CURVEFS_ERROR::OK, ret);
+    EXPECT_CALL(*metaClient_, GetDentry(fsId_, parent, name, _))
+        .WillOnce(Return(MetaStatusCode::NOT_FOUND));
+    ASSERT_EQ(CURVEFS_ERROR::NOTEXIST,
+              dCacheManager_->GetDentry(parent, name, &out));
+}
+
 TEST_F(TestDentryCacheManager, ListDentryNomal) {
     uint64_t parent = 99;
 
@@ -0,0 +1,265 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2022-06-27
+ * Author: chenwei
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <map>
+#include <set>
+
+#include "curvefs/src/client/dir_stat_manager.h"
+#include "curvefs/test/client/mock_metaserver_client.h"
+
+namespace curvefs {
+namespace client {
+
+using ::curvefs::metaserver::FsFileType;
+using ::curvefs::metaserver::MetaStatusCode;
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Invoke;
+using ::testing::Ne;
+using ::testing::Return;
+using ::testing::SaveArg;
+using ::testing::SetArgPointee;
+
+using rpcclient::MockMetaServerClient;
+
+class TestDirStatManager : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        metaClient_ = std::make_shared<MockMetaServerClient>();
+        manager_ = std::make_shared<DirStatManager>(metaClient_);
+        manager_->SetFsId(fsId_);
+    }
+
+    void TearDown() override {
+        manager_ = nullptr;
+        metaClient_ = nullptr;
+    }
+
+    InodeAttr GenAttr(uint64_t inodeId, FsFileType type, uint64_t length,
+                      uint32_t nlink) {
+        InodeAttr attr;
+        attr.set_inodeid(inodeId);
+        attr.set_fsid(fsId_);
+        attr.set_type(type);
+        attr.set_length(length);
+        attr.set_nlink(nlink);
+        return attr;
+    }
+
+    // mock the directories on metaserver, `parents` maps a directory to its
+    // parent, and the deltas added are recorded in `applied_`
+    void ExpectUpdateDirStat(const std::map<uint64_t, uint64_t> &parents) {
+        EXPECT_CALL(*metaClient_,
+                    UpdateDirStat(fsId_, _, _, _, 0, _, nullptr))
+            .WillRepeatedly(Invoke([this, parents](
+                uint32_t fsId, uint64_t inodeId, const DirStat &delta,
+                uint64_t requestId, uint64_t newParent, uint64_t *parent,
+                DirStat *stat) {
+                auto it = parents.find(inodeId);
+                if (it == parents.end()) {
+                    return MetaStatusCode::NOT_FOUND;
+                }
+                *parent = it->second;
+                if (!requestIds_.insert(requestId).second) {
+                    return MetaStatusCode::OK;
+                }
+                DirStat *applied = &applied_[inodeId];
+                applied->set_bytes(applied->bytes() + delta.bytes());
+                applied->set_files(applied->files() + delta.files());
+                applied->set_subdirs(applied->subdirs() + delta.subdirs());
+                return MetaStatusCode::OK;
+            }));
+    }
+
+    void AssertStat(const DirStat &stat, int64_t bytes, int64_t files,
+                    int64_t subdirs) {
+        ASSERT_EQ(bytes, stat.bytes());
+        ASSERT_EQ(files, stat.files());
+        ASSERT_EQ(subdirs, stat.subdirs());
+    }
+
+ protected:
+    const uint32_t fsId_ = 100;
+    std::shared_ptr<MockMetaServerClient> metaClient_;
+    std::shared_ptr<DirStatManager> manager_;
+    std::map<uint64_t, DirStat> applied_;
+    std::set<uint64_t> requestIds_;
+};
+
+TEST_F(TestDirStatManager, FlushUpToRoot) {
+    // 1 <- 10 <- 11
+    manager_->OnCreate(11, GenAttr(100, FsFileType::TYPE_S3, 4096, 1));
+    manager_->OnCreate(11, GenAttr(101, FsFileType::TYPE_SYM_LINK, 8, 1));
+    manager_->OnCreate(10, GenAttr(11, FsFileType::TYPE_DIRECTORY, 4096, 2));
+    manager_->OnLengthChange(11, 4096, 8192);
+    AssertStat(manager_->GetPendingDelta(11), 8200, 2, 0);
+    AssertStat(manager_->GetPendingDelta(10), 0, 0, 1);
+
+    ExpectUpdateDirStat({{1, 0}, {10, 1}, {11, 10}});
+    manager_->Flush();
+    AssertStat(applied_[11], 8200, 2, 0);
+    AssertStat(applied_[10], 8200, 2, 1);
+    AssertStat(applied_[1], 8200, 2, 1);
+    AssertStat(manager_->GetPendingDelta(11), 0, 0, 0);
+
+    // nothing to flush
+    applied_.clear();
+    manager_->Flush();
+    ASSERT_TRUE(applied_.empty());
+}
+
+TEST_F(TestDirStatManager, FlushFail) {
+    manager_->OnCreate(10, GenAttr(100, FsFileType::TYPE_S3, 10, 1));
+    manager_->OnCreate(20, GenAttr(200, FsFileType::TYPE_S3, 20, 1));
+
+    // the directory removed is dropped, and the failed one is kept
+    uint64_t requestId = 0;
+    EXPECT_CALL(*metaClient_, UpdateDirStat(fsId_, 10, _, _, 0, _, nullptr))
+        .WillOnce(Return(MetaStatusCode::NOT_FOUND));
+    EXPECT_CALL(*metaClient_, UpdateDirStat(fsId_, 20, _, _, 0, _, nullptr))
+        .WillOnce(DoAll(SaveArg<3>(&requestId),
+                        Return(MetaStatusCode::RPC_ERROR)));
+    manager_->Flush();
+    AssertStat(manager_->GetPendingDelta(10), 0, 0, 0);
+    AssertStat(manager_->GetPendingDelta(20), 20, 1, 0);
+
+    // retry by the next flush with the same request id, the delta added
+    // since then is sent apart
+    manager_->OnCreate(20, GenAttr(201, FsFileType::TYPE_S3, 30, 1));
+    DirStat resent;
+    EXPECT_CALL(*metaClient_,
+                UpdateDirStat(fsId_, 20, _, requestId, 0, _, nullptr))
+        .WillOnce(DoAll(SaveArg<2>(&resent), SetArgPointee<5>(0),
+                        Return(MetaStatusCode::OK)));
+    DirStat added;
+    EXPECT_CALL(*metaClient_,
+                UpdateDirStat(fsId_, 20, _, Ne(requestId), 0, _,
+                              nullptr))
+        .WillOnce(DoAll(SaveArg<2>(&added), SetArgPointee<5>(0),
+                        Return(MetaStatusCode::OK)));
+    manager_->Flush();
+    AssertStat(resent, 20, 1, 0);
+    AssertStat(added, 30, 1, 0);
+    AssertStat(manager_->GetPendingDelta(20), 0, 0, 0);
+}
+
+TEST_F(TestDirStatManager, FlushRetried) {
+    manager_->OnCreate(10, GenAttr(100, FsFileType::TYPE_S3, 10, 1));
+    ExpectUpdateDirStat({{1, 0}, {10, 1}});
+    manager_->Flush();
+
+    // the delta is resent after it's applied, it's added once
+    for (uint64_t requestId : std::set<uint64_t>(requestIds_)) {
+        uint64_t parent = 0;
+        DirStat delta;
+        delta.set_bytes(10);
+        delta.set_files(1);
+        ASSERT_EQ(MetaStatusCode::OK,
+                  metaClient_->UpdateDirStat(fsId_, 10, delta, requestId, 0,
+                                             &parent, nullptr));
+    }
+    AssertStat(applied_[10], 10, 1, 0);
+    AssertStat(applied_[1], 10, 1, 0);
+}
+
+TEST_F(TestDirStatManager, Unlink) {
+    // CASE 1: the last link of file
+    manager_->OnUnlink(10, GenAttr(100, FsFileType::TYPE_S3, 10, 1), 10);
+    AssertStat(manager_->GetPendingDelta(10), -10, -1, 0);
+
+    // CASE 2: hard link, the bytes are kept in the owner
+    manager_->OnLink(20, 10);
+    AssertStat(manager_->GetPendingDelta(20), 0, 1, 0);
+    manager_->OnUnlink(10, GenAttr(101, FsFileType::TYPE_S3, 10, 2), 10);
+    AssertStat(manager_->GetPendingDelta(10), -10, -2, 0);
+    manager_->OnUnlink(20, GenAttr(101, FsFileType::TYPE_S3, 10, 1), 10);
+    AssertStat(manager_->GetPendingDelta(20), 0, 0, 0);
+    AssertStat(manager_->GetPendingDelta(10), -20, -2, 0);
+
+    // CASE 3: directory
+    manager_->OnUnlink(30, GenAttr(31, FsFileType::TYPE_DIRECTORY, 4096, 2),
+                       30);
+    AssertStat(manager_->GetPendingDelta(30), 0, 0, -1);
+
+    // CASE 4: the inode created before dir stats isn't counted
+    manager_->OnUnlink(40, GenAttr(41, FsFileType::TYPE_S3, 10, 1), 0);
+    manager_->OnLink(40, 0);
+    AssertStat(manager_->GetPendingDelta(40), 0, 0, 0);
+}
+
+TEST_F(TestDirStatManager, RenameDirectory) {
+    DirStat stat;
+    stat.set_bytes(100);
+    stat.set_files(5);
+    stat.set_subdirs(2);
+    EXPECT_CALL(*metaClient_, UpdateDirStat(fsId_, 30, _, 0, 20, _, _))
+        .WillOnce(DoAll(SetArgPointee<6>(stat),
+                        Return(MetaStatusCode::OK)));
+
+    uint64_t newOwner = 0;
+    manager_->OnRename(10, 20, GenAttr(30, FsFileType::TYPE_DIRECTORY, 0, 4),
+                       10, &newOwner);
+    ASSERT_EQ(20, newOwner);
+    AssertStat(manager_->GetPendingDelta(10), -100, -5, -3);
+    AssertStat(manager_->GetPendingDelta(20), 100, 5, 3);
+
+    // reparent fail, it's still counted in the old parent
+    EXPECT_CALL(*metaClient_, UpdateDirStat(fsId_, 30, _, 0, 10, _, _))
+        .WillOnce(Return(MetaStatusCode::RPC_ERROR));
+    manager_->OnRename(20, 10, GenAttr(30, FsFileType::TYPE_DIRECTORY, 0, 4),
+                       20, &newOwner);
+    ASSERT_EQ(20, newOwner);
+    AssertStat(manager_->GetPendingDelta(20), 100, 5, 3);
+}
+
+TEST_F(TestDirStatManager, RenameFile) {
+    // CASE 1: the file is counted in the source directory
+    EXPECT_CALL(*metaClient_, UpdateDirStat(fsId_, 100, _, 0, 20, _, _))
+        .WillOnce(Return(MetaStatusCode::OK));
+    uint64_t newOwner = 0;
+    manager_->OnRename(10, 20, GenAttr(100, FsFileType::TYPE_S3, 10, 1), 10,
+                       &newOwner);
+    ASSERT_EQ(20, newOwner);
+    AssertStat(manager_->GetPendingDelta(10), -10, -1, 0);
+    AssertStat(manager_->GetPendingDelta(20), 10, 1, 0);
+
+    // CASE 2: a hard link of the file counted in other directory
+    EXPECT_CALL(*metaClient_, UpdateDirStat(_, _, _, _, _, _, _))
+        .Times(0);
+    manager_->OnRename(30, 40, GenAttr(101, FsFileType::TYPE_S3, 10, 2), 10,
+                       &newOwner);
+    ASSERT_EQ(10, newOwner);
+    AssertStat(manager_->GetPendingDelta(30), 0, -1, 0);
+    AssertStat(manager_->GetPendingDelta(40), 0, 1, 0);
+
+    // CASE 3: rename in the same directory
+    manager_->OnRename(30, 30, GenAttr(101, FsFileType::TYPE_S3, 10, 2), 30,
+                       &newOwner);
+    ASSERT_EQ(30, newOwner);
+    AssertStat(manager_->GetPendingDelta(30), 0, -1, 0);
+}
+
+}  // namespace client
+}  // namespace curvefs
@@ -0,0 +1,197 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2022-03-02
+ */
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "curvefs/src/client/s3/disk_cache_index.h"
+
+namespace curvefs {
+namespace client {
+
+class TestDiskCacheIndex : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        path_ = "./disk_cache_index_test_" + std::to_string(getpid());
+        unlink(path_.c_str());
+    }
+
+    void TearDown() override {
+        unlink(path_.c_str());
+    }
+
+    std::string path_;
+};
+
+TEST_F(TestDiskCacheIndex, AddGetRemove) {
+    DiskCacheIndex index;
+    ASSERT_FALSE(index.Get("obj1"));
+
+    index.Add("obj1", 10);
+    index.Add("obj2", 20);
+    ASSERT_TRUE(index.Get("obj1"));
+    ASSERT_EQ(2, index.Size());
+    ASSERT_EQ(30, index.TotalBytes());
+
+    // update size
+    index.Add("obj1", 15);
+    ASSERT_EQ(2, index.Size());
+    ASSERT_EQ(35, index.TotalBytes());
+
+    ASSERT_TRUE(index.Remove("obj2"));
+    ASSERT_FALSE(index.Remove("obj2"));
+    ASSERT_FALSE(index.Get("obj2"));
+    ASSERT_EQ(1, index.Size());
+    ASSERT_EQ(15, index.TotalBytes());
+}
+
+TEST_F(TestDiskCacheIndex, PopLru) {
+    DiskCacheIndex index;
+    for (int i = 0; i < 100; i++) {
+        index.Add("obj" + std::to_string(i), 1);
+    }
+    // access makes obj0 the most recently used one
+    ASSERT_TRUE(index.Get("obj0"));
+
+    std::string name;
+    uint64_t size = 0;
+    for (int i = 1; i < 100; i++) {
+        ASSERT_TRUE(index.PopLru(&name, &size));
+        ASSERT_EQ("obj" + std::to_string(i), name);
+        ASSERT_EQ(1, size);
+    }
+    ASSERT_TRUE(index.PopLru(&name, &size));
+    ASSERT_EQ("obj0", name);
+    ASSERT_FALSE(index.PopLru(&name, &size));
+    ASSERT_EQ(0, index.Size());
+    ASSERT_EQ(0, index.TotalBytes());
+}
+
+TEST_F(TestDiskCacheIndex, PersistAndLoad) {
+    {
+        DiskCacheIndex index;
+        ASSERT_EQ(-1, index.Load(path_));
+        ASSERT_EQ(0, index.Persist(path_));
+        index.Add("obj1", 10);
+        index.Add("obj2", 20);
+        index.Add("obj3", 30);
+        index.Remove("obj2");
+        // not closed, the journal is replayed
+    }
+    {
+        DiskCacheIndex index;
+        ASSERT_EQ(0, index.Load(path_));
+        ASSERT_EQ(2, index.Size());
+        ASSERT_EQ(40, index.TotalBytes());
+        ASSERT_TRUE(index.Get("obj3"));
+        ASSERT_FALSE(index.Get("obj2"));
+
+        // the snapshot keeps the lru order
+        ASSERT_EQ(0, index.Persist(path_));
+        ASSERT_TRUE(index.Get("obj1"));
+        index.Close();
+    }
+    {
+        DiskCacheIndex index;
+        ASSERT_EQ(0, index.Load(path_));
+        std::string name;
+        uint64_t size = 0;
+        ASSERT_TRUE(index.PopLru(&name, &size));
+        ASSERT_EQ("obj3", name);
+        ASSERT_EQ(30, size);
+        ASSERT_TRUE(index.PopLru(&name, &size));
+        ASSERT_EQ("obj1", name);
+    }
+}
+
+TEST_F(TestDiskCacheIndex, LoadBrokenIndex) {
+    {
+        std::ofstream out(path_);
+        out << "not an index\n";
+    }
+    DiskCacheIndex index;
+    ASSERT_EQ(-1, index.Load(path_));
+
+    // a record cut off by crash, the changes after it are unknown,
+    // nothing is loaded and the cache dir is scanned instead
+    {
+        std::ofstream out(path_);
+        out << "curvefs disk cache index v1\n+ 10 obj1\n+ 2";
+    }
+    ASSERT_EQ(-1, index.Load(path_));
+    ASSERT_EQ(0, index.Size());
+    ASSERT_EQ(0, index.TotalBytes());
+    ASSERT_FALSE(index.Get("obj1"));
+}
+
+TEST_F(TestDiskCacheIndex, PersistWhileChanging) {
+    const int kThreads = 4;
+    const int kObjects = 2000;
+    {
+        DiskCacheIndex index;
+        ASSERT_EQ(0, index.Persist(path_));
+
+        // each thread adds and removes its own objects, the ones
+        // with odd number are kept
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; t++) {
+            threads.emplace_back([&index, t]() {
+                for (int i = 0; i < kObjects; i++) {
+                    std::string name = std::to_string(t) + "_" +
+                                       std::to_string(i);
+                    index.Add(name, 1);
+                    if (i % 2 == 0) {
+                        index.Remove(name);
+                    }
+                }
+            });
+        }
+        for (int i = 0; i < 10; i++) {
+            ASSERT_EQ(0, index.Persist(path_));
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        ASSERT_EQ(kThreads * kObjects / 2, index.Size());
+        // not closed, the last snapshot and journal are replayed
+    }
+    {
+        DiskCacheIndex index;
+        ASSERT_EQ(0, index.Load(path_));
+        ASSERT_EQ(kThreads * kObjects / 2, index.Size());
+        ASSERT_EQ(kThreads * kObjects / 2, index.TotalBytes());
+        for (int t = 0; t < kThreads; t++) {
+            for (int i = 0; i < kObjects; i++) {
+                std::string name = std::to_string(t) + "_" +
+                                   std::to_string(i);
+                ASSERT_EQ(i % 2 == 1, index.Get(name));
+            }
+        }
+    }
+}
+
+}  // namespace client
+}  // namespace curvefs
@@ -23,6 +23,9 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <atomic>
+#include <string>
+
 #include "curvefs/test/client/mock_disk_cache_write.h"
 #include "curvefs/test/client/mock_disk_cache_read.h"
 #include "curvefs/test/client/mock_disk_cache_manager.h"
@@ -31,6 +34,7 @@
 #include "curvefs/test/client/mock_test_posix_wapper.h"
 #include "curvefs/src/client/s3/disk_cache_manager_impl.h"
 #include "curvefs/src/client/s3/client_s3_adaptor.h"
+#include "src/common/concurrent/count_down_event.h"
 
 namespace curvefs {
 namespace client {
@@ -90,6 +94,7 @@ class TestDiskCacheManagerImpl : public ::testing::Test {
 
 TEST_F(TestDiskCacheManagerImpl, Init) {
     S3ClientAdaptorOption s3AdaptorOption;
+    s3AdaptorOption.diskCacheOpt.ioThreads = 0;
     EXPECT_CALL(*diskCacheManager_, Init(_, _)).WillOnce(Return(-1));
     int ret = diskCacheManagerImpl_->Init(s3AdaptorOption);
     ASSERT_EQ(-1, ret);
@@ -242,5 +247,52 @@ TEST_F(TestDiskCacheManagerImpl, WriteReadDirect) {
     ASSERT_EQ(0, ret);
 }
 
+TEST_F(TestDiskCacheManagerImpl, WriteAsync) {
+    S3ClientAdaptorOption s3AdaptorOption;
+    s3AdaptorOption.diskCacheOpt.forceFlush = false;
+    s3AdaptorOption.diskCacheOpt.ioThreads = 2;
+    s3AdaptorOption.diskCacheOpt.ioQueueDepth = 4;
+    EXPECT_CALL(*diskCacheManager_, Init(_, _)).WillOnce(Return(0));
+    int ret = diskCacheManagerImpl_->Init(s3AdaptorOption);
+    ASSERT_EQ(0, ret);
+
+    // disk full, write falls back to upload
+    std::string buf = "test";
+    EXPECT_CALL(*diskCacheManager_, IsDiskCacheFull())
+        .WillRepeatedly(Return(true));
+    EXPECT_CALL(*client_, Upload(_, _, _))
+        .Times(16)
+        .WillRepeatedly(Return(4));
+    curve::common::CountDownEvent done(16);
+    std::atomic<int> failed(0);
+    for (int i = 0; i < 16; i++) {
+        diskCacheManagerImpl_->WriteAsync("test" + std::to_string(i),
+            buf.c_str(), 4, [&](int ret) {
+                if (ret < 0) {
+                    failed++;
+                }
+                done.Signal();
+            });
+    }
+    done.Wait();
+    ASSERT_EQ(0, failed.load());
+
+    done.Reset(1);
+    diskCacheManagerImpl_->WriteReadDirectAsync("test", buf.c_str(), 4,
+        [&](int ret) {
+            if (ret < 0) {
+                failed++;
+            }
+            done.Signal();
+        });
+    done.Wait();
+    ASSERT_EQ(1, failed.load());
+
+    EXPECT_CALL(*diskCacheWrite_, UploadAllCacheWriteFile())
+          .WillOnce(Return(0));
+    ret = diskCacheManagerImpl_->UmountDiskCache();
+    ASSERT_EQ(0, ret);
+}
+
 }  // namespace client
 }  // namespace curvefs
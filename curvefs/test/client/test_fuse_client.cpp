@@ -47,6 +47,7 @@ using ::testing::_;
 using ::testing::Contains;
 using ::testing::Invoke;
 using ::testing::Return;
+using ::testing::SaveArg;
 using ::testing::SetArgPointee;
 using ::testing::SetArgReferee;
 
@@ -80,6 +81,12 @@ class TestFuseVolumeClient : public ::testing::Test {
         fuseClientOption_.volumeOpt.bigFileSize = bigFileSize_;
         fuseClientOption_.listDentryLimit = listDentryLimit_;
         fuseClientOption_.maxNameLength = 20u;
+        fuseClientOption_.negativeEntryTimeOut = 1.0;
+        fuseClientOption_.openLeaseMs = 0;
+        fuseClientOption_.enableCompoundMetaOp = false;
+        fuseClientOption_.enableMetaserverRename = false;
+        fuseClientOption_.enableDirStat = false;
+        fuseClientOption_.dirStatFlushIntervalMs = 1000;
         client_ = std::make_shared<FuseVolumeClient>(
             mdsClient_, metaClient_, inodeManager_,
             dentryManager_, spaceClient_,  extManager_, blockDeviceClient_);
@@ -231,15 +238,17 @@ TEST_F(TestFuseVolumeClient, FuseOpLookup) {
     EXPECT_CALL(*dentryManager_, GetDentry(parent, name, _))
         .WillOnce(DoAll(SetArgPointee<2>(dentry), Return(CURVEFS_ERROR::OK)));
 
-    Inode inode;
-    auto inodeWrapper = std::make_shared<InodeWrapper>(inode, metaClient_);
-    EXPECT_CALL(*inodeManager_, GetInode(inodeid, _))
-        .WillOnce(
-            DoAll(SetArgReferee<1>(inodeWrapper), Return(CURVEFS_ERROR::OK)));
+    InodeAttr attr;
+    attr.set_inodeid(inodeid);
+    attr.set_length(4096);
+    EXPECT_CALL(*inodeManager_, GetInodeAttr(inodeid, _))
+        .WillOnce(DoAll(SetArgPointee<1>(attr), Return(CURVEFS_ERROR::OK)));
 
     fuse_entry_param e;
     CURVEFS_ERROR ret = client_->FuseOpLookup(req, parent, name.c_str(), &e);
     ASSERT_EQ(CURVEFS_ERROR::OK, ret);
+    ASSERT_EQ(inodeid, e.ino);
+    ASSERT_EQ(4096, e.attr.st_size);
 }
 
 TEST_F(TestFuseVolumeClient, FuseOpLookupFail) {
@@ -259,7 +268,7 @@ TEST_F(TestFuseVolumeClient, FuseOpLookupFail) {
         .WillOnce(Return(CURVEFS_ERROR::INTERNAL))
         .WillOnce(DoAll(SetArgPointee<2>(dentry), Return(CURVEFS_ERROR::OK)));
 
-    EXPECT_CALL(*inodeManager_, GetInode(inodeid, _))
+    EXPECT_CALL(*inodeManager_, GetInodeAttr(inodeid, _))
         .WillOnce(Return(CURVEFS_ERROR::INTERNAL));
 
     fuse_entry_param e;
@@ -270,6 +279,22 @@ TEST_F(TestFuseVolumeClient, FuseOpLookupFail) {
     ASSERT_EQ(CURVEFS_ERROR::INTERNAL, ret);
 }
 
+TEST_F(TestFuseVolumeClient, FuseOpLookupNotExist) {
+    fuse_req_t req;
+    fuse_ino_t parent = 1;
+    std::string name = "test";
+
+    EXPECT_CALL(*dentryManager_, GetDentry(parent, name, _))
+        .WillOnce(Return(CURVEFS_ERROR::NOTEXIST));
+
+    // reply a negative entry to kernel
+    fuse_entry_param e;
+    CURVEFS_ERROR ret = client_->FuseOpLookup(req, parent, name.c_str(), &e);
+    ASSERT_EQ(CURVEFS_ERROR::OK, ret);
+    ASSERT_EQ(0, e.ino);
+    ASSERT_EQ(1.0, e.entry_timeout);
+}
+
 TEST_F(TestFuseVolumeClient, FuseOpLookupNameTooLong) {
     fuse_req_t req;
     fuse_ino_t parent = 1;
@@ -713,6 +738,96 @@ TEST_F(TestFuseVolumeClient, FuseOpCreateFailed) {
     ASSERT_EQ(CURVEFS_ERROR::INTERNAL, ret);
 }
 
+TEST_F(TestFuseVolumeClient, FuseOpCreateWithCompoundMetaOp) {
+    fuseClientOption_.enableCompoundMetaOp = true;
+    client_->Init(fuseClientOption_);
+
+    fuse_req fakeReq;
+    fuse_ctx fakeCtx;
+    fakeReq.ctx = &fakeCtx;
+    fuse_req_t req = &fakeReq;
+    fuse_ino_t parent = 1;
+    const char* name = "xxx";
+    mode_t mode = 1;
+    struct fuse_file_info fi;
+    fi.flags = 0;
+
+    fuse_ino_t ino = 2;
+    Inode inode;
+    inode.set_fsid(fsId);
+    inode.set_inodeid(ino);
+    inode.set_length(4096);
+    inode.set_type(FsFileType::TYPE_FILE);
+    inode.set_openflag(false);
+    auto inodeWrapper = std::make_shared<InodeWrapper>(inode, metaClient_);
+
+    Inode parentInode;
+    parentInode.set_fsid(fsId);
+    parentInode.set_inodeid(parent);
+    parentInode.set_type(FsFileType::TYPE_DIRECTORY);
+    parentInode.set_nlink(2);
+    auto parentInodeWrapper = std::make_shared<InodeWrapper>(
+        parentInode, metaClient_);
+
+    // created with dentry by one request
+    Dentry dentry;
+    EXPECT_CALL(*inodeManager_, CreateInodeAndDentry(_, _, _))
+        .WillOnce(
+            DoAll(SetArgReferee<2>(inodeWrapper), Return(CURVEFS_ERROR::OK)));
+    EXPECT_CALL(*dentryManager_, InsertOrReplaceCache(_))
+        .WillOnce(SaveArg<0>(&dentry));
+    EXPECT_CALL(*inodeManager_, CreateInode(_, _))
+        .Times(0);
+    EXPECT_CALL(*dentryManager_, CreateDentry(_))
+        .Times(0);
+    EXPECT_CALL(*inodeManager_, GetInode(_, _))
+        .WillOnce(
+            DoAll(SetArgReferee<1>(parentInodeWrapper),
+                Return(CURVEFS_ERROR::OK)))
+        .WillOnce(
+            DoAll(SetArgReferee<1>(inodeWrapper), Return(CURVEFS_ERROR::OK)));
+    EXPECT_CALL(*metaClient_, UpdateInode(_))
+        .WillOnce(Return(MetaStatusCode::OK));
+
+    fuse_entry_param e;
+    CURVEFS_ERROR ret = client_->FuseOpCreate(req, parent, name, mode, &fi, &e);
+    ASSERT_EQ(CURVEFS_ERROR::OK, ret);
+    ASSERT_EQ(parent, dentry.parentinodeid());
+    ASSERT_EQ(name, dentry.name());
+    ASSERT_EQ(DentryFlag::TYPE_FILE_FLAG, dentry.flag());
+    ASSERT_EQ(3, parentInodeWrapper->GetInodeUnlocked().nlink());
+    ASSERT_EQ(1, inodeWrapper->GetOpenCount());
+
+    // fall back to create them separately
+    EXPECT_CALL(*inodeManager_, CreateInodeAndDentry(_, _, _))
+        .WillOnce(Return(CURVEFS_ERROR::NOTSUPPORT));
+    EXPECT_CALL(*inodeManager_, CreateInode(_, _))
+        .WillOnce(
+            DoAll(SetArgReferee<1>(inodeWrapper), Return(CURVEFS_ERROR::OK)));
+    EXPECT_CALL(*dentryManager_, CreateDentry(_))
+        .WillOnce(DoAll(SaveArg<0>(&dentry), Return(CURVEFS_ERROR::OK)));
+    EXPECT_CALL(*inodeManager_, GetInode(_, _))
+        .WillOnce(
+            DoAll(SetArgReferee<1>(parentInodeWrapper),
+                Return(CURVEFS_ERROR::OK)))
+        .WillOnce(
+            DoAll(SetArgReferee<1>(inodeWrapper), Return(CURVEFS_ERROR::OK)));
+
+    ret = client_->FuseOpCreate(req, parent, name, mode, &fi, &e);
+    ASSERT_EQ(CURVEFS_ERROR::OK, ret);
+    ASSERT_EQ(ino, dentry.inodeid());
+    ASSERT_EQ(4, parentInodeWrapper->GetInodeUnlocked().nlink());
+
+    // other errors are returned
+    EXPECT_CALL(*inodeManager_, CreateInodeAndDentry(_, _, _))
+        .WillOnce(Return(CURVEFS_ERROR::EXISTS));
+    EXPECT_CALL(*inodeManager_, CreateInode(_, _))
+        .Times(0);
+
+    ret = client_->FuseOpCreate(req, parent, name, mode, &fi, &e);
+    ASSERT_EQ(CURVEFS_ERROR::EXISTS, ret);
+}
+
 TEST_F(TestFuseVolumeClient, FuseOpCreateNameTooLong) {
     fuse_req fakeReq;
     fuse_ctx fakeCtx;
@@ -782,6 +897,84 @@ TEST_F(TestFuseVolumeClient, FuseOpUnlink) {
     ASSERT_EQ(nlink - 1, inode2.nlink());
 }
 
+TEST_F(TestFuseVolumeClient, FuseOpUnlinkWithCompoundMetaOp) {
+    fuseClientOption_.enableCompoundMetaOp = true;
+    client_->Init(fuseClientOption_);
+
+    fuse_req_t req;
+    fuse_ino_t parent = 1;
+    std::string name = "xxx";
+    uint32_t nlink = 100;
+
+    fuse_ino_t inodeid = 2;
+
+    Dentry dentry;
+    dentry.set_fsid(fsId);
+    dentry.set_name(name);
+    dentry.set_parentinodeid(parent);
+    dentry.set_inodeid(inodeid);
+
+    Inode inode;
+    inode.set_fsid(fsId);
+    inode.set_inodeid(inodeid);
+    inode.set_length(4096);
+    inode.set_nlink(nlink);
+    auto inodeWrapper = std::make_shared<InodeWrapper>(inode, metaClient_);
+
+    Inode parentInode;
+    parentInode.set_fsid(fsId);
+    parentInode.set_inodeid(parent);
+    parentInode.set_type(FsFileType::TYPE_DIRECTORY);
+    parentInode.set_nlink(3);
+    auto parentInodeWrapper = std::make_shared<InodeWrapper>(
+        parentInode, metaClient_);
+
+    // nlink of the inode is decreased by metaserver
+    EXPECT_CALL(*dentryManager_, GetDentry(parent, name, _))
+        .WillOnce(DoAll(SetArgPointee<2>(dentry), Return(CURVEFS_ERROR::OK)));
+    EXPECT_CALL(*dentryManager_,
+                UnlinkDentryAndDecNlink(parent, name, inodeid))
+        .WillOnce(Return(CURVEFS_ERROR::OK));
+    EXPECT_CALL(*dentryManager_, DeleteDentry(_, _))
+        .Times(0);
+    EXPECT_CALL(*inodeManager_, GetInode(parent, _))
+        .WillOnce(
+            DoAll(SetArgReferee<1>(parentInodeWrapper),
+                Return(CURVEFS_ERROR::OK)));
+    EXPECT_CALL(*metaClient_, UpdateInode(_))
+        .Times(0);
+    EXPECT_CALL(*inodeManager_, ClearInodeCache(inodeid))
+        .Times(1);
+
+    CURVEFS_ERROR ret = client_->FuseOpUnlink(req, parent, name.c_str());
+    ASSERT_EQ(CURVEFS_ERROR::OK, ret);
+    ASSERT_EQ(2, parentInodeWrapper->GetInodeUnlocked().nlink());
+
+    // fall back to unlink them separately
+    EXPECT_CALL(*dentryManager_, GetDentry(parent, name, _))
+        .WillOnce(DoAll(SetArgPointee<2>(dentry), Return(CURVEFS_ERROR::OK)));
+    EXPECT_CALL(*dentryManager_,
+                UnlinkDentryAndDecNlink(parent, name, inodeid))
+        .WillOnce(Return(CURVEFS_ERROR::NOTSUPPORT));
+    EXPECT_CALL(*dentryManager_, DeleteDentry(parent, name))
+        .WillOnce(Return(CURVEFS_ERROR::OK));
+    EXPECT_CALL(*inodeManager_, GetInode(parent, _))
+        .WillOnce(
+            DoAll(SetArgReferee<1>(parentInodeWrapper),
+                Return(CURVEFS_ERROR::OK)));
+    EXPECT_CALL(*inodeManager_, GetInode(inodeid, _))
+        .WillOnce(
+            DoAll(SetArgReferee<1>(inodeWrapper), Return(CURVEFS_ERROR::OK)));
+    EXPECT_CALL(*metaClient_, UpdateInode(_))
+        .WillOnce(Return(MetaStatusCode::OK));
+    EXPECT_CALL(*inodeManager_, ClearInodeCache(inodeid))
+        .Times(1);
+
+    ret = client_->FuseOpUnlink(req, parent, name.c_str());
+    ASSERT_EQ(CURVEFS_ERROR::OK, ret);
+    ASSERT_EQ(nlink - 1, inodeWrapper->GetInodeUnlocked().nlink());
+}
+
 TEST_F(TestFuseVolumeClient, FuseOpUnlinkFailed) {
     fuse_req_t req;
     fuse_ino_t parent = 1;
@@ -985,6 +1178,111 @@ TEST_F(TestFuseVolumeClient, FuseOpOpenAndFuseOpReadDirFailed) {
     ASSERT_EQ(CURVEFS_ERROR::INTERNAL, ret);
 }
 
+TEST_F(TestFuseVolumeClient, FuseOpOpenAndFuseOpReadDirPlus) {
+    fuse_req_t req;
+    fuse_ino_t ino = 1;
+    size_t size = 4096;
+    off_t off = 0;
+    struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
+    fi.fh = 0;
+    char* buffer;
+    size_t rSize = 0;
+
+    Inode inode;
+    inode.set_fsid(fsId);
+    inode.set_inodeid(ino);
+    inode.set_length(0);
+    inode.set_type(FsFileType::TYPE_DIRECTORY);
+    auto inodeWrapper = std::make_shared<InodeWrapper>(inode, metaClient_);
+
+    EXPECT_CALL(*inodeManager_, GetInode(ino, _))
+        .Times(2)
+        .WillRepeatedly(
+            DoAll(SetArgReferee<1>(inodeWrapper), Return(CURVEFS_ERROR::OK)));
+
+    CURVEFS_ERROR ret = client_->FuseOpOpenDir(req, ino, &fi);
+    ASSERT_EQ(CURVEFS_ERROR::OK, ret);
+
+    // inode 3 is deleted after listing dentry, which is listed without
+    // attributes
+    std::list<Dentry> dentryList;
+    Dentry dentry;
+    dentry.set_fsid(fsId);
+    dentry.set_parentinodeid(ino);
+    dentry.set_name("a");
+    dentry.set_inodeid(2);
+    dentryList.push_back(dentry);
+    dentry.set_name("b");
+    dentry.set_inodeid(3);
+    dentryList.push_back(dentry);
+
+    std::map<uint64_t, InodeAttr> attrs;
+    attrs[2].set_inodeid(2);
+
+    EXPECT_CALL(*dentryManager_, ListDentry(ino, _, listDentryLimit_))
+        .WillOnce(
+            DoAll(SetArgPointee<1>(dentryList), Return(CURVEFS_ERROR::OK)));
+    EXPECT_CALL(*inodeManager_,
+                BatchGetInodeAttr(std::set<uint64_t>{2, 3}, _))
+        .WillOnce(DoAll(SetArgPointee<1>(attrs), Return(CURVEFS_ERROR::OK)));
+    EXPECT_CALL(*dentryManager_, InsertOrReplaceCache(_))
+        .Times(1);
+
+    ret = client_->FuseOpReadDirPlus(req, ino, size, off, &fi, &buffer,
+                                     &rSize);
+    ASSERT_EQ(CURVEFS_ERROR::OK, ret);
+    ASSERT_EQ(fuse_add_direntry_plus(req, NULL, 0, "a", NULL, 0) +
+                  fuse_add_direntry_plus(req, NULL, 0, "b", NULL, 0),
+              rSize);
+    client_->FuseOpReleaseDir(req, ino, &fi);
+}
+
+TEST_F(TestFuseVolumeClient, FuseOpReadDirPlusFailed) {
+    fuse_req_t req;
+    fuse_ino_t ino = 1;
+    size_t size = 4096;
+    off_t off = 0;
+    struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
+    fi.fh = 0;
+    char* buffer;
+    size_t rSize = 0;
+
+    Inode inode;
+    inode.set_fsid(fsId);
+    inode.set_inodeid(ino);
+    inode.set_type(FsFileType::TYPE_DIRECTORY);
+    auto inodeWrapper = std::make_shared<InodeWrapper>(inode, metaClient_);
+
+    EXPECT_CALL(*inodeManager_, GetInode(ino, _))
+        .Times(2)
+        .WillRepeatedly(
+            DoAll(SetArgReferee<1>(inodeWrapper), Return(CURVEFS_ERROR::OK)));
+
+    CURVEFS_ERROR ret = client_->FuseOpOpenDir(req, ino, &fi);
+    ASSERT_EQ(CURVEFS_ERROR::OK, ret);
+
+    std::list<Dentry> dentryList;
+    Dentry dentry;
+    dentry.set_fsid(fsId);
+    dentry.set_name("xxx");
+    dentry.set_parentinodeid(ino);
+    dentry.set_inodeid(2);
+    dentryList.push_back(dentry);
+
+    EXPECT_CALL(*dentryManager_, ListDentry(ino, _, listDentryLimit_))
+        .WillOnce(
+            DoAll(SetArgPointee<1>(dentryList), Return(CURVEFS_ERROR::OK)));
+    EXPECT_CALL(*inodeManager_, BatchGetInodeAttr(_, _))
+        .WillOnce(Return(CURVEFS_ERROR::INTERNAL));
+
+    ret = client_->FuseOpReadDirPlus(req, ino, size, off, &fi, &buffer,
+                                     &rSize);
+    ASSERT_EQ(CURVEFS_ERROR::INTERNAL, ret);
+    client_->FuseOpReleaseDir(req, ino, &fi);
+}
+
 TEST_F(TestFuseVolumeClient, FuseOpRenameBasic) {
     fuse_req_t req;
     fuse_ino_t parent = 1;
@@ -1064,6 +1362,76 @@ TEST_F(TestFuseVolumeClient, FuseOpRenameBasic) {
     ASSERT_EQ(rc, CURVEFS_ERROR::OK);
 }
 
+TEST_F(TestFuseVolumeClient, FuseOpRenameByMetaserver) {
+    fuseClientOption_.enableMetaserverRename = true;
+    client_->Init(fuseClientOption_);
+
+    fuse_req_t req;
+    fuse_ino_t parent = 1;
+    std::string name = "A";
+    fuse_ino_t newparent = 3;
+    std::string newname = "B";
+    uint64_t inodeId = 1000;
+    uint32_t srcPartitionId = 1;
+    uint32_t dstPartitionId = 2;
+    uint64_t srcTxId = 0;
+    uint64_t dstTxId = 2;
+
+    EXPECT_CALL(*metaClient_, GetTxId(fsId, parent, _, _))
+        .WillRepeatedly(DoAll(SetArgPointee<2>(srcPartitionId),
+                              SetArgPointee<3>(srcTxId),
+                              Return(MetaStatusCode::OK)));
+    EXPECT_CALL(*metaClient_, GetTxId(fsId, newparent, _, _))
+        .WillRepeatedly(DoAll(SetArgPointee<2>(dstPartitionId),
+                              SetArgPointee<3>(dstTxId),
+                              Return(MetaStatusCode::OK)));
+    auto dentry = GenDentry(fsId, parent, name, srcTxId, inodeId, 0);
+    EXPECT_CALL(*dentryManager_, GetDentry(parent, name, _))
+        .WillRepeatedly(
+            DoAll(SetArgPointee<2>(dentry), Return(CURVEFS_ERROR::OK)));
+    EXPECT_CALL(*dentryManager_, GetDentry(newparent, newname, _))
+        .WillRepeatedly(Return(CURVEFS_ERROR::NOTEXIST));
+
+    // CASE 1: the transaction is committed by metaserver
+    EXPECT_CALL(*metaClient_, Rename(_, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(srcTxId + 3),
+                        SetArgPointee<3>(dstTxId + 1),
+                        Return(MetaStatusCode::OK)));
+    EXPECT_CALL(*metaClient_, PrepareRenameTx(_)).Times(0);
+    EXPECT_CALL(*mdsClient_, CommitTx(_)).Times(0);
+    EXPECT_CALL(*dentryManager_, DeleteCache(parent, name)).Times(1);
+    EXPECT_CALL(*dentryManager_, InsertOrReplaceCache(_))
+        .WillOnce(Invoke([&](const Dentry& dentry) {
+            auto dstDentry =
+                GenDentry(fsId, newparent, newname,
+                          dstTxId + 1, inodeId, TX_PREPARE);
+            ASSERT_TRUE(dentry == dstDentry);
+        }));
+    EXPECT_CALL(*metaClient_, SetTxId(srcPartitionId, srcTxId + 3)).Times(1);
+    EXPECT_CALL(*metaClient_, SetTxId(dstPartitionId, dstTxId + 1)).Times(1);
+
+    auto rc = client_->FuseOpRename(req, parent, name.c_str(), newparent,
+                                    newname.c_str());
+    ASSERT_EQ(rc, CURVEFS_ERROR::OK);
+
+    // CASE 2: metaserver failed, fall back to run the transaction by client
+    EXPECT_CALL(*metaClient_, Rename(_, _, _, _))
+        .WillOnce(Return(MetaStatusCode::RPC_ERROR));
+    EXPECT_CALL(*metaClient_, PrepareRenameTx(_))
+        .Times(2)
+        .WillRepeatedly(Return(MetaStatusCode::OK));
+    EXPECT_CALL(*mdsClient_, CommitTx(_))
+        .WillOnce(Return(TopoStatusCode::TOPO_OK));
+    EXPECT_CALL(*dentryManager_, DeleteCache(parent, name)).Times(1);
+    EXPECT_CALL(*dentryManager_, InsertOrReplaceCache(_)).Times(1);
+    EXPECT_CALL(*metaClient_, SetTxId(srcPartitionId, srcTxId + 1)).Times(1);
+    EXPECT_CALL(*metaClient_, SetTxId(dstPartitionId, dstTxId + 1)).Times(1);
+
+    rc = client_->FuseOpRename(req, parent, name.c_str(), newparent,
+                               newname.c_str());
+    ASSERT_EQ(rc, CURVEFS_ERROR::OK);
+}
+
 TEST_F(TestFuseVolumeClient, FuseOpRenameOverwrite) {
     fuse_req_t req;
     fuse_ino_t parent = 1;
@@ -1270,17 +1638,17 @@ TEST_F(TestFuseVolumeClient, FuseOpGetAttr) {
     memset(&fi, 0, sizeof(fi));
     struct stat attr;
 
-    Inode inode;
-    inode.set_inodeid(ino);
-    inode.set_length(0);
-    auto inodeWrapper = std::make_shared<InodeWrapper>(inode, metaClient_);
+    InodeAttr inodeAttr;
+    inodeAttr.set_inodeid(ino);
+    inodeAttr.set_length(0);
 
-    EXPECT_CALL(*inodeManager_, GetInode(ino, _))
+    EXPECT_CALL(*inodeManager_, GetInodeAttr(ino, _))
         .WillOnce(
-            DoAll(SetArgReferee<1>(inodeWrapper), Return(CURVEFS_ERROR::OK)));
+            DoAll(SetArgPointee<1>(inodeAttr), Return(CURVEFS_ERROR::OK)));
 
     CURVEFS_ERROR ret = client_->FuseOpGetAttr(req, ino, &fi, &attr);
     ASSERT_EQ(CURVEFS_ERROR::OK, ret);
+    ASSERT_EQ(ino, attr.st_ino);
 }
 
 TEST_F(TestFuseVolumeClient, FuseOpGetAttrFailed) {
@@ -1290,14 +1658,8 @@ TEST_F(TestFuseVolumeClient, FuseOpGetAttrFailed) {
     memset(&fi, 0, sizeof(fi));
     struct stat attr;
 
-    Inode inode;
-    inode.set_inodeid(ino);
-    inode.set_length(0);
-    auto inodeWrapper = std::make_shared<InodeWrapper>(inode, metaClient_);
-
-    EXPECT_CALL(*inodeManager_, GetInode(ino, _))
-        .WillOnce(DoAll(SetArgReferee<1>(inodeWrapper),
-                        Return(CURVEFS_ERROR::INTERNAL)));
+    EXPECT_CALL(*inodeManager_, GetInodeAttr(ino, _))
+        .WillOnce(Return(CURVEFS_ERROR::INTERNAL));
 
     CURVEFS_ERROR ret = client_->FuseOpGetAttr(req, ino, &fi, &attr);
     ASSERT_EQ(CURVEFS_ERROR::INTERNAL, ret);
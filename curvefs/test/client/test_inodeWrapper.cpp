@@ -26,6 +26,8 @@
 #include <gmock/gmock.h>
 #include <google/protobuf/util/message_differencer.h>
 
+#include <list>
+
 #include "curvefs/test/client/mock_metaserver_client.h"
 #include "curvefs/src/client/inode_wrapper.h"
 
@@ -170,6 +172,96 @@ TEST_F(TestInodeWrapper, testSyncFailed) {
     ASSERT_EQ(CURVEFS_ERROR::NOTEXIST, ret2);
 }
 
+TEST_F(TestInodeWrapper, testUpdateAfterWrite) {
+    inodeWrapper_->UpdateAfterWriteUnLocked(0, 4096, false);
+    Inode inode = inodeWrapper_->GetInodeUnlocked();
+    ASSERT_TRUE(inodeWrapper_->Dirty());
+    ASSERT_EQ(4096, inode.length());
+    ASSERT_GT(inode.mtime(), 0);
+    ASSERT_GT(inode.ctime(), 0);
+
+    // write inside the file does not change length
+    inodeWrapper_->UpdateAfterWriteUnLocked(0, 1024, false);
+    ASSERT_EQ(4096, inodeWrapper_->GetLength());
+
+    // times are maintained by kernel in writeback cache mode
+    Inode *mutableInode = inodeWrapper_->GetMutableInodeUnlocked();
+    mutableInode->set_mtime(1);
+    mutableInode->set_ctime(1);
+    inodeWrapper_->UpdateAfterWriteUnLocked(4096, 4096, true);
+    inode = inodeWrapper_->GetInodeUnlocked();
+    ASSERT_EQ(8192, inode.length());
+    ASSERT_EQ(1, inode.mtime());
+    ASSERT_EQ(1, inode.ctime());
+}
+
+TEST_F(TestInodeWrapper, testOpenLease) {
+    Inode *inode = inodeWrapper_->GetMutableInodeUnlocked();
+    inode->set_length(4096);
+
+    // set open flag when opened first
+    EXPECT_CALL(*metaClient_, UpdateInode(_))
+        .WillOnce(Return(MetaStatusCode::OK));
+    bool keepCache = true;
+    ASSERT_EQ(CURVEFS_ERROR::OK, inodeWrapper_->Open(&keepCache));
+    ASSERT_FALSE(keepCache);
+    ASSERT_TRUE(inodeWrapper_->GetInodeUnlocked().openflag());
+
+    // close and reopen within the lease doesn't set the open flag again,
+    // the page cache is kept if the file is unchanged in metaserver
+    InodeAttr attr;
+    attr.set_inodeid(inode->inodeid());
+    attr.set_length(4096);
+    attr.set_mtime(inode->mtime());
+    attr.set_mtime_ns(inode->mtime_ns());
+    EXPECT_CALL(*metaClient_, UpdateInode(_))
+        .Times(0);
+    EXPECT_CALL(*metaClient_, BatchGetInodeAttr(_, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(std::list<InodeAttr>{attr}),
+                        Return(MetaStatusCode::OK)));
+    ASSERT_EQ(CURVEFS_ERROR::OK, inodeWrapper_->Release(3000));
+    ASSERT_TRUE(inodeWrapper_->IsOpenLeaseHeld());
+    ASSERT_TRUE(inodeWrapper_->GetInodeUnlocked().openflag());
+    ASSERT_EQ(CURVEFS_ERROR::OK, inodeWrapper_->Open(&keepCache));
+    ASSERT_TRUE(keepCache);
+    ASSERT_FALSE(inodeWrapper_->IsOpenLeaseHeld());
+
+    // written by other client after closed
+    attr.set_length(8192);
+    EXPECT_CALL(*metaClient_, BatchGetInodeAttr(_, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(std::list<InodeAttr>{attr}),
+                        Return(MetaStatusCode::OK)));
+    ASSERT_EQ(CURVEFS_ERROR::OK, inodeWrapper_->Release(3000));
+    ASSERT_EQ(CURVEFS_ERROR::OK, inodeWrapper_->Open(&keepCache));
+    ASSERT_FALSE(keepCache);
+
+    // fail to get the attributes
+    EXPECT_CALL(*metaClient_, BatchGetInodeAttr(_, _, _))
+        .WillOnce(Return(MetaStatusCode::RPC_ERROR));
+    ASSERT_EQ(CURVEFS_ERROR::OK, inodeWrapper_->Release(3000));
+    ASSERT_EQ(CURVEFS_ERROR::OK, inodeWrapper_->Open(&keepCache));
+    ASSERT_FALSE(keepCache);
+
+    // file changed by this client after closed, no rpc needed
+    EXPECT_CALL(*metaClient_, BatchGetInodeAttr(_, _, _))
+        .Times(0);
+    ASSERT_EQ(CURVEFS_ERROR::OK, inodeWrapper_->Release(3000));
+    inode->set_length(8192);
+    ASSERT_EQ(CURVEFS_ERROR::OK, inodeWrapper_->Open(&keepCache));
+    ASSERT_FALSE(keepCache);
+
+    // lease is not released before expired
+    ASSERT_EQ(CURVEFS_ERROR::OK, inodeWrapper_->Release(3000));
+    ASSERT_FALSE(inodeWrapper_->ReleaseOpenLease(0, false));
+    ASSERT_TRUE(inodeWrapper_->IsOpenLeaseHeld());
+
+    // released lease clears the open flag by flush
+    ASSERT_TRUE(inodeWrapper_->ReleaseOpenLease(0, true));
+    ASSERT_FALSE(inodeWrapper_->IsOpenLeaseHeld());
+    ASSERT_FALSE(inodeWrapper_->GetInodeUnlocked().openflag());
+    ASSERT_TRUE(inodeWrapper_->Dirty());
+}
+
 
 }  // namespace client
 }  // namespace curvefs
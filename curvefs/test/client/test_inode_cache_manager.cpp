@@ -39,6 +39,7 @@ using ::testing::Invoke;
 
 using rpcclient::MockMetaServerClient;
 using rpcclient::MetaServerClientDone;
+using rpcclient::BatchUpdateInodeResponse;
 
 class TestInodeCacheManager : public ::testing::Test {
  protected:
@@ -134,6 +135,119 @@ TEST_F(TestInodeCacheManager, CreateAndGetInode) {
     ASSERT_EQ(FsFileType::TYPE_FILE, out.type());
 }
 
+TEST_F(TestInodeCacheManager, CreateInodeAndDentry) {
+    uint64_t inodeId = 100;
+
+    InodeParam param;
+    param.fsId = fsId_;
+    param.type = FsFileType::TYPE_FILE;
+    Dentry dentry;
+    dentry.set_fsid(fsId_);
+    dentry.set_parentinodeid(1);
+    dentry.set_name("test");
+
+    Inode inode;
+    inode.set_inodeid(inodeId);
+    inode.set_fsid(fsId_);
+    inode.set_type(FsFileType::TYPE_FILE);
+    EXPECT_CALL(*metaClient_, CreateInodeAndDentry(_, &dentry, _))
+        .WillOnce(Return(MetaStatusCode::PARTITION_ALLOC_ID_FAIL))
+        .WillOnce(Return(MetaStatusCode::PARTITION_ID_MISSMATCH))
+        .WillOnce(Return(MetaStatusCode::DENTRY_EXIST))
+        .WillOnce(DoAll(SetArgPointee<2>(inode),
+            Return(MetaStatusCode::OK)));
+
+    std::shared_ptr<InodeWrapper> inodeWrapper;
+    CURVEFS_ERROR ret =
+        iCacheManager_->CreateInodeAndDentry(param, &dentry, inodeWrapper);
+    ASSERT_EQ(CURVEFS_ERROR::NOTSUPPORT, ret);
+    ret = iCacheManager_->CreateInodeAndDentry(param, &dentry, inodeWrapper);
+    ASSERT_EQ(CURVEFS_ERROR::NOTSUPPORT, ret);
+    ret = iCacheManager_->CreateInodeAndDentry(param, &dentry, inodeWrapper);
+    ASSERT_EQ(CURVEFS_ERROR::EXISTS, ret);
+
+    ret = iCacheManager_->CreateInodeAndDentry(param, &dentry, inodeWrapper);
+    ASSERT_EQ(CURVEFS_ERROR::OK, ret);
+    ASSERT_EQ(inodeId, inodeWrapper->GetInodeId());
+
+    // the new inode is cached
+    ret = iCacheManager_->GetInode(inodeId, inodeWrapper);
+    ASSERT_EQ(CURVEFS_ERROR::OK, ret);
+    ASSERT_EQ(inodeId, inodeWrapper->GetInodeUnlocked().inodeid());
+}
+
+TEST_F(TestInodeCacheManager, BatchGetInodeAttrAndGetInodeAttr) {
+    uint64_t cachedId = 100;
+    uint64_t inodeId1 = 101;
+    uint64_t inodeId2 = 102;
+
+    // inode in icache is not fetched again
+    Inode inode;
+    inode.set_inodeid(cachedId);
+    inode.set_fsid(fsId_);
+    inode.set_length(100);
+    EXPECT_CALL(*metaClient_, GetInode(fsId_, cachedId, _))
+        .WillOnce(DoAll(SetArgPointee<2>(inode),
+                Return(MetaStatusCode::OK)));
+    std::shared_ptr<InodeWrapper> inodeWrapper;
+    ASSERT_EQ(CURVEFS_ERROR::OK,
+              iCacheManager_->GetInode(cachedId, inodeWrapper));
+
+    std::list<InodeAttr> attrList;
+    InodeAttr attr;
+    attr.set_inodeid(inodeId1);
+    attr.set_fsid(fsId_);
+    attr.set_length(1);
+    attrList.push_back(attr);
+    attr.set_inodeid(inodeId2);
+    attr.set_length(2);
+    attrList.push_back(attr);
+
+    std::set<uint64_t> missed{inodeId1, inodeId2};
+    EXPECT_CALL(*metaClient_, BatchGetInodeAttr(fsId_, missed, _))
+        .WillOnce(Return(MetaStatusCode::UNKNOWN_ERROR))
+        .WillOnce(DoAll(SetArgPointee<2>(attrList),
+                Return(MetaStatusCode::OK)));
+
+    std::set<uint64_t> inodeIds{cachedId, inodeId1, inodeId2};
+    std::map<uint64_t, InodeAttr> attrs;
+    CURVEFS_ERROR ret = iCacheManager_->BatchGetInodeAttr(inodeIds, &attrs);
+    ASSERT_EQ(CURVEFS_ERROR::UNKNOWN, ret);
+
+    attrs.clear();
+    ret = iCacheManager_->BatchGetInodeAttr(inodeIds, &attrs);
+    ASSERT_EQ(CURVEFS_ERROR::OK, ret);
+    ASSERT_EQ(3, attrs.size());
+    ASSERT_EQ(100, attrs[cachedId].length());
+    ASSERT_EQ(1, attrs[inodeId1].length());
+    ASSERT_EQ(2, attrs[inodeId2].length());
+
+    // hit the attr cache
+    attrs.clear();
+    ret = iCacheManager_->BatchGetInodeAttr(inodeIds, &attrs);
+    ASSERT_EQ(CURVEFS_ERROR::OK, ret);
+    ASSERT_EQ(3, attrs.size());
+
+    InodeAttr out;
+    ret = iCacheManager_->GetInodeAttr(inodeId2, &out);
+    ASSERT_EQ(CURVEFS_ERROR::OK, ret);
+    ASSERT_EQ(2, out.length());
+
+    // the attr cache is dropped after the inode is deleted
+    EXPECT_CALL(*metaClient_, DeleteInode(fsId_, inodeId2))
+        .WillOnce(Return(MetaStatusCode::OK));
+    ASSERT_EQ(CURVEFS_ERROR::OK, iCacheManager_->DeleteInode(inodeId2));
+
+    // only the attributes are fetched when missing the caches
+    std::set<uint64_t> deleted{inodeId2};
+    EXPECT_CALL(*metaClient_, BatchGetInodeAttr(fsId_, deleted, _))
+        .WillOnce(Return(MetaStatusCode::OK));
+    EXPECT_CALL(*metaClient_, GetInode(fsId_, inodeId2, _))
+        .Times(0);
+    ret = iCacheManager_->GetInodeAttr(inodeId2, &out);
+    ASSERT_EQ(CURVEFS_ERROR::NOTEXIST, ret);
+}
+
 TEST_F(TestInodeCacheManager, DeleteInode) {
     uint64_t inodeId = 100;
 
@@ -168,6 +282,10 @@ TEST_F(TestInodeCacheManager, ShipToFlushAndFlushAll) {
 
     iCacheManager_->ShipToFlush(inodeWrapper);
 
+    // partition unknown, flushed inode by inode
+    EXPECT_CALL(*metaClient_, GetTxId(fsId_, inodeId, _, _))
+        .WillOnce(Return(MetaStatusCode::NOT_FOUND));
+
     EXPECT_CALL(*metaClient_, UpdateInodeAsync(_, _))
         .WillOnce(Invoke([](const Inode &inode,
         MetaServerClientDone *done){
@@ -187,6 +305,117 @@ TEST_F(TestInodeCacheManager, ShipToFlushAndFlushAll) {
     iCacheManager_->FlushAll();
 }
 
+TEST_F(TestInodeCacheManager, OpenLease) {
+    uint64_t inodeId = 100;
+    Inode inode;
+    inode.set_inodeid(inodeId);
+    inode.set_fsid(fsId_);
+    inode.set_type(FsFileType::TYPE_FILE);
+    inode.set_openflag(true);
+
+    auto inodeWrapper = std::make_shared<InodeWrapper>(inode, metaClient_);
+    inodeWrapper->SetOpenCount(1);
+    ASSERT_EQ(CURVEFS_ERROR::OK, inodeWrapper->Release(3000));
+    iCacheManager_->AddOpenLease(inodeWrapper);
+
+    // the leased inode is reused rather than fetched from metaserver
+    EXPECT_CALL(*metaClient_, GetInode(_, _, _))
+        .Times(0);
+    std::shared_ptr<InodeWrapper> out;
+    ASSERT_EQ(CURVEFS_ERROR::OK, iCacheManager_->GetInode(inodeId, out));
+    ASSERT_EQ(inodeWrapper, out);
+
+    // lease not expired
+    iCacheManager_->FlushInodeOnce();
+    ASSERT_TRUE(inodeWrapper->IsOpenLeaseHeld());
+
+    // all leases are released by flush all
+    EXPECT_CALL(*metaClient_, GetTxId(fsId_, inodeId, _, _))
+        .WillOnce(Return(MetaStatusCode::NOT_FOUND));
+    EXPECT_CALL(*metaClient_, UpdateInodeAsync(_, _))
+        .WillOnce(Invoke([](const Inode &inode, MetaServerClientDone *done) {
+            ASSERT_FALSE(inode.openflag());
+            done->SetMetaStatusCode(MetaStatusCode::OK);
+            done->Run();
+        }));
+    iCacheManager_->FlushAll();
+    ASSERT_FALSE(inodeWrapper->IsOpenLeaseHeld());
+}
+
+TEST_F(TestInodeCacheManager, FlushAllInBatch) {
+    uint64_t inodeId1 = 100;
+    uint64_t inodeId2 = 101;
+    uint32_t partitionId = 1;
+    Inode inode;
+    inode.set_fsid(fsId_);
+    inode.set_type(FsFileType::TYPE_FILE);
+
+    inode.set_inodeid(inodeId1);
+    inode.set_length(4096);
+    auto inodeWrapper1 = std::make_shared<InodeWrapper>(inode, metaClient_);
+    inodeWrapper1->MarkDirty();
+    S3ChunkInfo info;
+    inodeWrapper1->AppendS3ChunkInfo(1, info);
+
+    inode.set_inodeid(inodeId2);
+    auto inodeWrapper2 = std::make_shared<InodeWrapper>(inode, metaClient_);
+    inodeWrapper2->AppendS3ChunkInfo(2, info);
+
+    iCacheManager_->ShipToFlush(inodeWrapper1);
+    iCacheManager_->ShipToFlush(inodeWrapper2);
+
+    EXPECT_CALL(*metaClient_, GetTxId(fsId_, _, _, _))
+        .Times(2)
+        .WillRepeatedly(DoAll(SetArgPointee<2>(partitionId),
+                Return(MetaStatusCode::OK)));
+    EXPECT_CALL(*metaClient_, UpdateInodeAsync(_, _))
+        .Times(0);
+    EXPECT_CALL(*metaClient_, GetOrModifyS3ChunkInfoAsync(_, _, _, _))
+        .Times(0);
+
+    // only the inode failed on metaserver is marked error
+    BatchUpdateInodeRequest request;
+    EXPECT_CALL(*metaClient_, BatchUpdateInodeAsync(_, _, _))
+        .WillOnce(Invoke([&](const BatchUpdateInodeRequest &req,
+            BatchUpdateInodeResponse *response, MetaServerClientDone *done) {
+            request = req;
+            response->set_statuscode(MetaStatusCode::UNKNOWN_ERROR);
+            response->add_failedinodeid(inodeId1);
+            done->SetMetaStatusCode(MetaStatusCode::UNKNOWN_ERROR);
+            done->Run();
+        }));
+
+    iCacheManager_->FlushAll();
+
+    ASSERT_EQ(fsId_, request.fsid());
+    ASSERT_EQ(1, request.updateinode_size());
+    ASSERT_EQ(inodeId1, request.updateinode(0).inodeid());
+    ASSERT_EQ(4096, request.updateinode(0).length());
+    ASSERT_EQ(2, request.s3chunkinfoadd_size());
+    ASSERT_FALSE(inodeWrapper1->isDirty());
+    ASSERT_EQ(InodeStatus::Error, inodeWrapper1->GetStatus());
+    ASSERT_EQ(InodeStatus::Normal, inodeWrapper2->GetStatus());
+
+    // the syncing locks are released even if the batch failed
+    inodeWrapper1->GetSyncingInodeUniqueLock();
+    inodeWrapper2->GetSyncingS3ChunkInfoUniqueLock();
+
+    // the batch isn't applied, all inodes are marked error
+    inodeWrapper2->AppendS3ChunkInfo(3, info);
+    iCacheManager_->ShipToFlush(inodeWrapper2);
+    EXPECT_CALL(*metaClient_, GetTxId(fsId_, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(partitionId),
+                        Return(MetaStatusCode::OK)));
+    EXPECT_CALL(*metaClient_, BatchUpdateInodeAsync(_, _, _))
+        .WillOnce(Invoke([&](const BatchUpdateInodeRequest &req,
+            BatchUpdateInodeResponse *response, MetaServerClientDone *done) {
+            done->SetMetaStatusCode(MetaStatusCode::RPC_ERROR);
+            done->Run();
+        }));
+    iCacheManager_->FlushAll();
+    ASSERT_EQ(InodeStatus::Error, inodeWrapper2->GetStatus());
+}
+
 
 }  // namespace client
 }  // namespace curvefs
@@ -24,7 +24,9 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>  // NOLINT
 #include <ctime>
+#include <thread>  // NOLINT
 
 #include "src/common/concurrent/count_down_event.h"
 
@@ -84,6 +86,128 @@ TEST(ApplyQueueTest, FlushTest) {
     applyQueue.Stop();
 }
 
+TEST(ApplyQueueTest, PushExclusiveTest) {
+    ApplyQueueOption option;
+    option.workerCount = 4;
+    option.queueDepth = 100;
+
+    ApplyQueue applyQueue;
+    ASSERT_TRUE(applyQueue.Start(option));
+
+    const int taskCount = 100;
+    std::atomic<int> before(0);
+    std::atomic<int> after(0);
+    std::atomic<bool> exclusiveRunned(false);
+    std::atomic<bool> outOfOrder(false);
+
+    for (int i = 0; i < taskCount; ++i) {
+        applyQueue.Push(i, [&]() {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            before.fetch_add(1);
+        });
+    }
+
+    applyQueue.PushExclusive([&]() {
+        if (before.load() != taskCount || after.load() != 0) {
+            outOfOrder = true;
+        }
+        exclusiveRunned = true;
+    });
+
+    for (int i = 0; i < taskCount; ++i) {
+        applyQueue.Push(i, [&]() {
+            if (!exclusiveRunned.load()) {
+                outOfOrder = true;
+            }
+            after.fetch_add(1);
+        });
+    }
+
+    applyQueue.Flush();
+    ASSERT_TRUE(exclusiveRunned.load());
+    ASSERT_FALSE(outOfOrder.load());
+    ASSERT_EQ(taskCount, after.load());
+    applyQueue.Stop();
+}
+
+TEST(ApplyQueueTest, PushJointTest) {
+    ApplyQueueOption option;
+    option.workerCount = 4;
+    option.queueDepth = 100;
+
+    ApplyQueue applyQueue;
+    ASSERT_TRUE(applyQueue.Start(option));
+
+    const int taskCount = 100;
+    std::atomic<int> before(0);
+    std::atomic<bool> jointRunned(false);
+    std::atomic<bool> outOfOrder(false);
+
+    // the tasks on workers 0, 1 and 2 run before the joint one
+    for (int i = 0; i < taskCount; ++i) {
+        applyQueue.Push(i % 3, [&]() {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            before.fetch_add(1);
+        });
+    }
+
+    // worker 3 isn't blocked by the joint task
+    std::atomic<bool> blocked(true);
+    applyQueue.Push(3, [&]() {
+        while (blocked.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    applyQueue.PushJoint({0, 1, 2, 4, 5}, [&]() {
+        if (before.load() != taskCount) {
+            outOfOrder = true;
+        }
+        jointRunned = true;
+    });
+
+    while (!jointRunned.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    blocked = false;
+    applyQueue.Flush();
+    ASSERT_FALSE(outOfOrder.load());
+    applyQueue.Stop();
+}
+
+TEST(ApplyQueueTest, DrainTest) {
+    ApplyQueueOption option;
+    option.workerCount = 4;
+    option.queueDepth = 100;
+
+    ApplyQueue applyQueue;
+    ASSERT_TRUE(applyQueue.Start(option));
+
+    const int taskCount = 100;
+    std::atomic<int> before(0);
+    std::atomic<bool> drained(false);
+    std::atomic<bool> outOfOrder(false);
+
+    for (int i = 0; i < taskCount; ++i) {
+        applyQueue.Push(i, [&]() {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            before.fetch_add(1);
+        });
+    }
+
+    applyQueue.Drain([&]() {
+        if (before.load() != taskCount) {
+            outOfOrder = true;
+        }
+        drained = true;
+    });
+
+    applyQueue.Flush();
+    ASSERT_TRUE(drained.load());
+    ASSERT_FALSE(outOfOrder.load());
+    applyQueue.Stop();
+}
+
 }  // namespace copyset
 }  // namespace metaserver
 }  // namespace curvefs
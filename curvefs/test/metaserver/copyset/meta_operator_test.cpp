@@ -25,9 +25,14 @@
 #include <brpc/server.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <condition_variable>
+#include <future>  // NOLINT
 #include <mutex>
 #include <regex>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "absl/memory/memory.h"
 #include "curvefs/test/metaserver/copyset/mock/mock_copyset_node_manager.h"
@@ -91,6 +96,7 @@ using ::testing::_;
 using ::testing::DoAll;
 using ::testing::Invoke;
 using ::testing::Return;
+using ::testing::SetArgPointee;
 
 class MetaOperatorTest : public testing::Test {
  protected:
@@ -141,10 +147,92 @@ TEST_F(MetaOperatorTest, OperatorTypeTest) {
     TEST_OPERATOR_TYPE(CreatePartition);
     TEST_OPERATOR_TYPE(DeletePartition);
     TEST_OPERATOR_TYPE(PrepareRenameTx);
+    TEST_OPERATOR_TYPE(CreateInodeAndDentry);
+    TEST_OPERATOR_TYPE(UnlinkDentryAndDecNlink);
+    TEST_OPERATOR_TYPE(UpdateDirStat);
 
 #undef TEST_OPERATOR_TYPE
 }
 
+TEST_F(MetaOperatorTest, HashCodeTest) {
+    PoolId poolId = 100;
+    CopysetId copysetId = 100;
+    braft::Configuration conf;
+    CopysetNode node(poolId, copysetId, conf, &mockNodeManager_);
+
+    // the dentrys and the inode of a directory are hashed by its inode id
+    CreateDentryRequest createDentry;
+    createDentry.set_partitionid(1);
+    createDentry.mutable_dentry()->set_parentinodeid(100);
+    UpdateInodeRequest updateInode;
+    updateInode.set_partitionid(1);
+    updateInode.set_inodeid(100);
+    ListDentryRequest listDentry;
+    listDentry.set_partitionid(1);
+    listDentry.set_dirinodeid(101);
+
+    CreateDentryOperator op1(&node, &createDentry, false);
+    UpdateInodeOperator op2(&node, &updateInode, false);
+    ListDentryOperator op3(&node, &listDentry, false);
+    EXPECT_EQ(op1.HashCode(), op2.HashCode());
+    EXPECT_NE(op1.HashCode(), op3.HashCode());
+
+    MetaOperator* op = &op1;
+    EXPECT_FALSE(op->IsExclusive());
+
+    PrepareRenameTxRequest renameTx;
+    PrepareRenameTxOperator op4(&node, &renameTx, false);
+    op = &op4;
+    EXPECT_TRUE(op->IsExclusive());
+
+    CreatePartitionRequest createPartition;
+    CreatePartitionOperator op5(&node, &createPartition, false);
+    op = &op5;
+    EXPECT_TRUE(op->IsExclusive());
+
+    // the batch read isn't a barrier of the other operators
+    BatchGetInodeAttrRequest batchGetInodeAttr;
+    batchGetInodeAttr.set_partitionid(1);
+    batchGetInodeAttr.add_inodeid(100);
+    batchGetInodeAttr.add_inodeid(101);
+    BatchGetInodeAttrOperator op8(&node, &batchGetInodeAttr, false);
+    op = &op8;
+    EXPECT_FALSE(op->IsExclusive());
+
+    // the new inode and the inode to unlink are the second hash codes
+    CreateInodeAndDentryRequest createInodeAndDentry;
+    createInodeAndDentry.set_partitionid(1);
+    createInodeAndDentry.set_parentinodeid(100);
+    CreateInodeAndDentryOperator op6(&node, &createInodeAndDentry, false);
+    EXPECT_EQ(op1.HashCode(), op6.HashCode());
+    op = &op6;
+    EXPECT_NE(op->HashCode(), op->SecondHashCode());
+    EXPECT_FALSE(op->IsExclusive());
+
+    UnlinkDentryAndDecNlinkRequest unlink;
+    unlink.set_partitionid(1);
+    unlink.set_parentinodeid(100);
+    unlink.set_inodeid(101);
+    UnlinkDentryAndDecNlinkOperator op7(&node, &unlink, false);
+    op = &op7;
+    EXPECT_EQ(op1.HashCode(), op->HashCode());
+    EXPECT_EQ(op3.HashCode(), op->SecondHashCode());
+    EXPECT_FALSE(op->IsExclusive());
+
+    // the batch update is hashed by all the inodes of it
+    BatchUpdateInodeRequest batchUpdateInode;
+    batchUpdateInode.set_partitionid(1);
+    batchUpdateInode.add_updateinode()->set_inodeid(100);
+    batchUpdateInode.add_s3chunkinfoadd()->set_inodeid(101);
+    BatchUpdateInodeOperator op9(&node, &batchUpdateInode, false);
+    op = &op9;
+    EXPECT_FALSE(op->IsExclusive());
+    std::vector<uint64_t> hashCodes;
+    op->GetHashCodes(&hashCodes);
+    EXPECT_EQ(hashCodes,
+              std::vector<uint64_t>({op2.HashCode(), op3.HashCode()}));
+}
+
 TEST_F(MetaOperatorTest, OnApplyErrorTest) {
     PoolId poolId = 100;
     CopysetId copysetId = 100;
@@ -178,7 +266,6 @@ TEST_F(MetaOperatorTest, OnApplyErrorTest) {
     OPERATOR_ON_APPLY_TEST(CreateDentry);
     OPERATOR_ON_APPLY_TEST(DeleteDentry);
     OPERATOR_ON_APPLY_TEST(GetInode);
-    OPERATOR_ON_APPLY_TEST(CreateInode);
     OPERATOR_ON_APPLY_TEST(UpdateInode);
     OPERATOR_ON_APPLY_TEST(GetOrModifyS3ChunkInfo);
     OPERATOR_ON_APPLY_TEST(DeleteInode);
@@ -186,9 +273,66 @@ TEST_F(MetaOperatorTest, OnApplyErrorTest) {
     OPERATOR_ON_APPLY_TEST(CreatePartition);
     OPERATOR_ON_APPLY_TEST(DeletePartition);
     OPERATOR_ON_APPLY_TEST(PrepareRenameTx);
+    OPERATOR_ON_APPLY_TEST(UnlinkDentryAndDecNlink);
+    OPERATOR_ON_APPLY_TEST(UpdateDirStat);
 
 #undef OPERATOR_ON_APPLY_TEST
 
+    // inode is created with the id reserved before apply
+    {
+        EXPECT_CALL(*mockMetaStore, ReserveInodeId(_, _))
+            .WillOnce(DoAll(SetArgPointee<1>(100),
+                            Return(MetaStatusCode::OK)));
+        EXPECT_CALL(*mockMetaStore, CreateInode(_, 100, _))
+            .WillOnce(Invoke([](const CreateInodeRequest* request,
+                                uint64_t inodeId,
+                                CreateInodeResponse* response) {
+                return FakeOnApplyFunc(request, response);
+            }));
+        CreateInodeRequest request;
+        CreateInodeResponse response;
+        FakeClosure closure;
+        auto op = absl::make_unique<CreateInodeOperator>(
+            &node, &cntl, &request, &response, nullptr);
+        ASSERT_TRUE(op->BeforeApply());
+        op->OnApply(1, &closure, TimeUtility::GetTimeofDayUs());
+        closure.WaitRunned();
+        EXPECT_EQ(MetaStatusCode::UNKNOWN_ERROR, response.statuscode());
+    }
+
+    {
+        EXPECT_CALL(*mockMetaStore, ReserveInodeId(10, _))
+            .WillOnce(DoAll(SetArgPointee<1>(100),
+                            Return(MetaStatusCode::OK)));
+        EXPECT_CALL(*mockMetaStore, CreateInodeAndDentry(_, 100, _))
+            .WillOnce(Invoke([](const CreateInodeAndDentryRequest* request,
+                                uint64_t inodeId,
+                                CreateInodeAndDentryResponse* response) {
+                return FakeOnApplyFunc(request, response);
+            }));
+        CreateInodeAndDentryRequest request;
+        request.set_partitionid(10);
+        CreateInodeAndDentryResponse response;
+        FakeClosure closure;
+        auto op = absl::make_unique<CreateInodeAndDentryOperator>(
+            &node, &cntl, &request, &response, nullptr);
+        ASSERT_TRUE(op->BeforeApply());
+        op->OnApply(1, &closure, TimeUtility::GetTimeofDayUs());
+        closure.WaitRunned();
+        EXPECT_EQ(MetaStatusCode::UNKNOWN_ERROR, response.statuscode());
+    }
+
+    // retry after apply queue is flushed if the partition isn't created yet
+    {
+        EXPECT_CALL(*mockMetaStore, ReserveInodeId(_, _))
+            .WillOnce(Return(MetaStatusCode::PARTITION_NOT_FOUND));
+        CreateInodeAndDentryRequest request;
+        CreateInodeAndDentryResponse response;
+        auto op = absl::make_unique<CreateInodeAndDentryOperator>(
+            &node, &cntl, &request, &response, nullptr);
+        ASSERT_FALSE(op->BeforeApply());
+    }
+
     EXPECT_TRUE(
         CheckMetric("curl -s 0.0.0.0:" + std::to_string(kDummyServerPort) +
                         "/vars | grep "
@@ -277,7 +421,6 @@ TEST_F(MetaOperatorTest, OnApplyFromLogErrorTest) {
 
     OPERATOR_ON_APPLY_FROM_LOG_TEST(CreateDentry);
     OPERATOR_ON_APPLY_FROM_LOG_TEST(DeleteDentry);
-    OPERATOR_ON_APPLY_FROM_LOG_TEST(CreateInode);
     OPERATOR_ON_APPLY_FROM_LOG_TEST(UpdateInode);
     OPERATOR_ON_APPLY_FROM_LOG_TEST(GetOrModifyS3ChunkInfo);
     OPERATOR_ON_APPLY_FROM_LOG_TEST(DeleteInode);
@@ -285,9 +428,31 @@ TEST_F(MetaOperatorTest, OnApplyFromLogErrorTest) {
     OPERATOR_ON_APPLY_FROM_LOG_TEST(CreatePartition);
     OPERATOR_ON_APPLY_FROM_LOG_TEST(DeletePartition);
     OPERATOR_ON_APPLY_FROM_LOG_TEST(PrepareRenameTx);
+    OPERATOR_ON_APPLY_FROM_LOG_TEST(UnlinkDentryAndDecNlink);
+    OPERATOR_ON_APPLY_FROM_LOG_TEST(UpdateDirStat);
 
 #undef OPERATOR_ON_APPLY_FROM_LOG_TEST
 
+    {
+        EXPECT_CALL(*mockMetaStore, CreateInode(_, _, _))
+            .WillOnce(Return(MetaStatusCode::UNKNOWN_ERROR));
+        CreateInodeRequest request;
+        auto op = absl::make_unique<CreateInodeOperator>(&node, &request,
+                                                         false);
+        op->OnApplyFromLog(TimeUtility::GetTimeofDayUs());
+        op.release();
+    }
+
+    {
+        EXPECT_CALL(*mockMetaStore, CreateInodeAndDentry(_, _, _))
+            .WillOnce(Return(MetaStatusCode::UNKNOWN_ERROR));
+        CreateInodeAndDentryRequest request;
+        auto op = absl::make_unique<CreateInodeAndDentryOperator>(
+            &node, &request, false);
+        op->OnApplyFromLog(TimeUtility::GetTimeofDayUs());
+        op.release();
+    }
+
 #define OPERATOR_ON_APPLY_FROM_LOG_DO_NOTHING_TEST(TYPE)                     \
     {                                                                        \
         EXPECT_CALL(*mockMetaStore, TYPE(_, _)).Times(0);                    \
@@ -414,6 +579,186 @@ TEST_F(MetaOperatorTest, PropostTest_RequestCanBypassProcess) {
     node.Stop();
 }
 
+// when raft log is replayed, e.g., on followers, the requests on the inode
+// created by CreateInodeAndDentry are pushed to apply queue right after it,
+// and they must be applied after the inode is created
+TEST_F(MetaOperatorTest, CreateInodeAndDentryReplayOrderTest) {
+    PoolId poolId = 100;
+    CopysetId copysetId = 100;
+    braft::Configuration conf;
+
+    CopysetNode node(poolId, copysetId, conf, &mockNodeManager_);
+    CopysetNodeOptions options;
+    options.dataUri = "local:///mnt/data";
+    options.applyQueueOption.workerCount = 8;
+    options.applyQueueOption.queueDepth = 100;
+
+    EXPECT_TRUE(node.Init(options));
+    auto* mockMetaStore = new mock::MockMetaStore();
+    node.SetMetaStore(mockMetaStore);
+    auto* mockRaftNode = new MockRaftNode();
+    node.SetRaftNode(mockRaftNode);
+    ON_CALL(*mockMetaStore, Clear())
+        .WillByDefault(Return(true));
+    EXPECT_CALL(*mockRaftNode, shutdown(_))
+        .Times(1);
+    EXPECT_CALL(*mockRaftNode, join())
+        .Times(1);
+
+    const uint64_t parentId = 1;
+    const int inodeCount = 16;
+    std::atomic<int> created(0);
+    std::atomic<bool> outOfOrder(false);
+    std::atomic<uint64_t> nextInodeId(100);
+    EXPECT_CALL(*mockMetaStore, ReserveInodeId(1, _))
+        .Times(inodeCount)
+        .WillRepeatedly(Invoke([&](uint32_t, uint64_t* inodeId) {
+            *inodeId = nextInodeId.fetch_add(1);
+            return MetaStatusCode::OK;
+        }));
+    EXPECT_CALL(*mockMetaStore, CreateInodeAndDentry(_, _, _))
+        .Times(inodeCount)
+        .WillRepeatedly(Invoke([&](const CreateInodeAndDentryRequest*,
+                                   uint64_t,
+                                   CreateInodeAndDentryResponse* response) {
+            // slow down the creates serialized on the parent
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            created.fetch_add(1);
+            response->set_statuscode(MetaStatusCode::OK);
+            return MetaStatusCode::OK;
+        }));
+    EXPECT_CALL(*mockMetaStore, UpdateInode(_, _))
+        .Times(inodeCount)
+        .WillRepeatedly(Invoke([&](const UpdateInodeRequest* request,
+                                   UpdateInodeResponse* response) {
+            // the i-th update is on the i-th inode created
+            if (created.load() < static_cast<int>(request->inodeid() - 99)) {
+                outOfOrder = true;
+            }
+            response->set_statuscode(MetaStatusCode::OK);
+            return MetaStatusCode::OK;
+        }));
+
+    for (int i = 0; i < inodeCount; ++i) {
+        auto* create = new CreateInodeAndDentryRequest();
+        create->set_partitionid(1);
+        create->set_parentinodeid(parentId);
+        auto* createOp = new CreateInodeAndDentryOperator(&node, create);
+        node.PushToApplyQueueForTest(
+            createOp, std::bind(&MetaOperator::OnApplyFromLog, createOp,
+                                TimeUtility::GetTimeofDayUs()));
+
+        auto* update = new UpdateInodeRequest();
+        update->set_partitionid(1);
+        update->set_inodeid(100 + i);
+        auto* updateOp = new UpdateInodeOperator(&node, update);
+        node.PushToApplyQueueForTest(
+            updateOp, std::bind(&MetaOperator::OnApplyFromLog, updateOp,
+                                TimeUtility::GetTimeofDayUs()));
+    }
+
+    node.FlushApplyQueue();
+    EXPECT_EQ(inodeCount, created.load());
+    EXPECT_FALSE(outOfOrder.load());
+
+    node.Stop();
+}
+
+TEST_F(MetaOperatorTest, PropostTest_LeaseRead) {
+    PoolId poolId = 100;
+    CopysetId copysetId = 100;
+    braft::Configuration conf;
+
+    CopysetNode node(poolId, copysetId, conf, &mockNodeManager_);
+    CopysetNodeOptions options;
+    options.dataUri = "local:///mnt/data";
+
+    EXPECT_TRUE(node.Init(options));
+    auto* mockMetaStore = new mock::MockMetaStore();
+    node.SetMetaStore(mockMetaStore);
+    auto* mockRaftNode = new MockRaftNode();
+    node.SetRaftNode(mockRaftNode);
+
+    braft::LeaderLeaseStatus validLease;
+    validLease.state = braft::LEASE_VALID;
+    validLease.term = 1;
+    braft::LeaderLeaseStatus expiredLease;
+    expiredLease.state = braft::LEASE_EXPIRED;
+
+    ON_CALL(*mockMetaStore, Clear())
+        .WillByDefault(Return(true));
+    EXPECT_CALL(*mockRaftNode, get_leader_lease_status(_))
+        .WillOnce(SetArgPointee<0>(validLease))
+        .WillOnce(SetArgPointee<0>(validLease))
+        .WillOnce(SetArgPointee<0>(expiredLease));
+    EXPECT_CALL(*mockRaftNode, shutdown(_))
+        .Times(1);
+    EXPECT_CALL(*mockRaftNode, join())
+        .Times(1);
+    EXPECT_CALL(*mockMetaStore, ListDentry(_, _))
+        .Times(2)
+        .WillRepeatedly(Return(MetaStatusCode::OK));
+
+    // an entry of previous term is still applying
+    std::promise<void> blocker;
+    std::shared_future<void> blocked = blocker.get_future().share();
+    node.GetApplyQueue()->Push(0, [blocked]() { blocked.wait(); });
+
+    node.on_leader_start(1);
+    node.UpdateAppliedIndex(101);
+
+    // CASE 1: lease is valid, but the request is queued behind the entries
+    // of previous term
+    ListDentryRequest request;
+    request.set_poolid(poolId);
+    request.set_copysetid(copysetId);
+    request.set_partitionid(1);
+    request.set_fsid(1);
+    request.set_dirinodeid(1);
+    request.set_txid(0);
+    request.set_appliedindex(100);
+    ListDentryResponse response;
+    FakeClosure done;
+    auto* op = new ListDentryOperator(&node, nullptr, &request, &response,
+                                      &done);
+    op->Propose();
+    EXPECT_FALSE(node.IsLeaseReadReady());
+    EXPECT_FALSE(done.Runned());
+
+    blocker.set_value();
+    done.WaitRunned();
+    node.FlushApplyQueue();
+    EXPECT_TRUE(node.IsLeaseReadReady());
+
+    // CASE 2: lease is valid, the request is served in rpc thread
+    ListDentryResponse response1;
+    FakeClosure done1;
+    op = new ListDentryOperator(&node, nullptr, &request, &response1,
+                                &done1);
+    op->Propose();
+
+    EXPECT_TRUE(done1.Runned());
+    EXPECT_TRUE(response1.has_appliedindex());
+    EXPECT_EQ(101, response1.appliedindex());
+
+    // CASE 3: lease is expired, the request is proposed to raft
+    EXPECT_CALL(*mockRaftNode, apply(_))
+        .WillOnce(Invoke([](const braft::Task& task) {
+            task.done->status().set_error(EPERM, "not leader");
+            task.done->Run();
+        }));
+
+    ListDentryResponse response2;
+    FakeClosure done2;
+    op = new ListDentryOperator(&node, nullptr, &request, &response2, &done2);
+    op->Propose();
+
+    EXPECT_TRUE(done2.Runned());
+    EXPECT_EQ(MetaStatusCode::REDIRECTED, response2.statuscode());
+
+    node.Stop();
+}
+
 TEST_F(MetaOperatorTest, PropostTest_PropostTaskFailed) {
     PoolId poolId = 100;
     CopysetId copysetId = 100;
@@ -441,5 +441,53 @@ TEST_F(DentryStorageTest, HandleTx) {
     ASSERT_EQ(dentry.inodeid(), 1);
 }
 
+TEST_F(DentryStorageTest, Stripes) {
+    MemoryDentryStorage storage(true, 4);
+
+    // dentrys of 8 directories are in 4 stripes
+    for (uint64_t parentId = 0; parentId < 8; parentId++) {
+        for (uint64_t i = 0; i < 10; i++) {
+            auto dentry = GenDentry(1, parentId, std::to_string(i), 0,
+                                    parentId * 10 + i + 100, false);
+            ASSERT_EQ(storage.Insert(dentry), MetaStatusCode::OK);
+        }
+    }
+    ASSERT_EQ(storage.Size(), 80);
+
+    for (uint64_t parentId = 0; parentId < 8; parentId++) {
+        std::vector<Dentry> dentrys;
+        auto dentry = GenDentry(1, parentId, "", 0, 0, false);
+        ASSERT_EQ(storage.List(dentry, &dentrys, 0), MetaStatusCode::OK);
+        ASSERT_EQ(dentrys.size(), 10);
+        for (const auto& item : dentrys) {
+            ASSERT_EQ(item.parentinodeid(), parentId);
+        }
+    }
+
+    auto dentry = GenDentry(1, 3, "5", 0, 0, false);
+    ASSERT_EQ(storage.Get(&dentry), MetaStatusCode::OK);
+    ASSERT_EQ(dentry.inodeid(), 135);
+    ASSERT_EQ(storage.Delete(dentry), MetaStatusCode::OK);
+    ASSERT_EQ(storage.Get(&dentry), MetaStatusCode::NOT_FOUND);
+
+    // all stripes are iterated
+    auto iterator = storage.NewIterator(1);
+    ASSERT_EQ(iterator->Size(), 79);
+    uint64_t count = 0;
+    for (iterator->SeekToFirst(); iterator->Valid(); iterator->Next()) {
+        ASSERT_EQ(iterator->Key(), "d:1");
+        count++;
+    }
+    ASSERT_EQ(count, 79);
+
+    DentryChanges changes;
+    ASSERT_EQ(storage.TakeChanges(&changes), MetaStatusCode::OK);
+    ASSERT_EQ(changes.dentrys.size(), 79);
+    ASSERT_EQ(changes.removedDentrys.size(), 1);
+
+    storage.Clear();
+    ASSERT_EQ(storage.Size(), 0);
+}
+
 }  // namespace metaserver
 }  // namespace curvefs
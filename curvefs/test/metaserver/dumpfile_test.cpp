@@ -27,6 +27,7 @@
 #include <memory>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "curvefs/src/common/process.h"
 #include "curvefs/src/metaserver/iterator.h"
@@ -252,6 +253,47 @@ TEST_F(DumpFileTest, TestLoadLargeValue) {
     ASSERT_EQ(dumpfile_->GetLoadStatus(), DUMPFILE_LOAD_STATUS::INVALID_PAIRS);
 }
 
+TEST_F(DumpFileTest, TestLoadCorruptedBlock) {
+    Hash hash;
+    auto hashIterator = std::make_shared<HashIterator>(&hash);
+    GenHash(&hash, 100);
+    ASSERT_EQ(dumpfile_->Save(hashIterator), DUMPFILE_ERROR::OK);
+
+    // CASE 1: blocks are verified independently
+    std::vector<DumpFileBlock> blocks;
+    ASSERT_EQ(dumpfile_->MapBlocks(&blocks), DUMPFILE_LOAD_STATUS::COMPLETE);
+    ASSERT_EQ(blocks.size(), 100);
+    for (const auto& block : blocks) {
+        std::vector<std::string> values;
+        auto status = dumpfile_->LoadBlock(
+            block, [&](const char* value, size_t length) {
+                values.emplace_back(value, length);
+                return true;
+            });
+        ASSERT_EQ(status, DUMPFILE_LOAD_STATUS::COMPLETE);
+        ASSERT_EQ(values.size(), 1);
+        ASSERT_EQ(values[0], block.key);
+    }
+
+    // CASE 2: the block with corrupted value fails to load,
+    //         the value of first block is after the magic, version, size
+    //         and the header of block
+    std::string ret;
+    auto offset = 7 + 1 + 8 + blocks[0].headerLength + 4;
+    ASSERT_TRUE(ExecShell("printf 'X' | dd of=" + dirname_ +
+                          "/curvefs.dump bs=1 seek=" +
+                          std::to_string(offset) +
+                          " conv=notrunc 2>/dev/null", &ret));
+    auto iter = dumpfile_->Load();
+    uint64_t count = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        count++;
+    }
+    ASSERT_EQ(count, 0);
+    ASSERT_EQ(dumpfile_->GetLoadStatus(),
+              DUMPFILE_LOAD_STATUS::INVALID_CHECKSUM);
+}
+
 TEST_F(DumpFileTest, TestFileNotOpen) {
     Hash hash;
     auto hashIterator = std::make_shared<HashIterator>(&hash);
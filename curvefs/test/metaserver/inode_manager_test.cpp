@@ -75,30 +75,30 @@ TEST_F(InodeManagerTest, test1) {
     std::string symlink = "";
     Inode inode1;
     ASSERT_EQ(manager.CreateInode(fsId, 2, length, uid, gid, mode, type,
-        symlink, 0, &inode1),
+        symlink, 0, 0, &inode1),
         MetaStatusCode::OK);
     ASSERT_EQ(inode1.inodeid(), 2);
 
     Inode inode2;
     ASSERT_EQ(manager.CreateInode(fsId, 3, length, uid, gid, mode, type,
-        symlink, 0, &inode2),
+        symlink, 0, 0, &inode2),
         MetaStatusCode::OK);
     ASSERT_EQ(inode2.inodeid(), 3);
 
     Inode inode3;
     ASSERT_EQ(manager.CreateInode(fsId, 4, length, uid, gid, mode,
-        FsFileType::TYPE_SYM_LINK, symlink, 0, &inode3),
+        FsFileType::TYPE_SYM_LINK, symlink, 0, 0, &inode3),
         MetaStatusCode::SYM_LINK_EMPTY);
 
     ASSERT_EQ(
         manager.CreateInode(fsId, 4, length, uid, gid, mode,
-        FsFileType::TYPE_SYM_LINK, "SYMLINK", 0, &inode3),
+        FsFileType::TYPE_SYM_LINK, "SYMLINK", 0, 0, &inode3),
         MetaStatusCode::OK);
     ASSERT_EQ(inode3.inodeid(), 4);
 
     Inode inode4;
     ASSERT_EQ(manager.CreateInode(fsId, 5, length, uid, gid, mode,
-        FsFileType::TYPE_S3, symlink, 0, &inode4),
+        FsFileType::TYPE_S3, symlink, 0, 0, &inode4),
         MetaStatusCode::OK);
     ASSERT_EQ(inode4.inodeid(), 5);
     ASSERT_EQ(inode4.type(), FsFileType::TYPE_S3);
@@ -268,5 +268,76 @@ TEST_F(InodeManagerTest, test1) {
     ASSERT_EQ(8, s3Out5.at(0).s3chunks(1).chunkid());
     ASSERT_EQ(9, s3Out5.at(0).s3chunks(2).chunkid());
 }
+
+TEST_F(InodeManagerTest, UpdateDirStat) {
+    std::shared_ptr<InodeStorage> inodeStorage =
+        std::make_shared<MemoryInodeStorage>();
+    auto trash = std::make_shared<TrashImpl>(inodeStorage);
+    InodeManager manager(inodeStorage, trash);
+
+    uint32_t fsId = 1;
+    Inode dir;
+    ASSERT_EQ(manager.CreateInode(fsId, 2, 0, 0, 0, 0777,
+        FsFileType::TYPE_DIRECTORY, "", 0, 1, &dir),
+        MetaStatusCode::OK);
+    ASSERT_EQ(dir.parent(), 1);
+    Inode file;
+    ASSERT_EQ(manager.CreateInode(fsId, 3, 100, 0, 0, 0777,
+        FsFileType::TYPE_FILE, "", 0, 2, &file),
+        MetaStatusCode::OK);
+    ASSERT_EQ(file.parent(), 2);
+
+    // CASE 1: apply delta, the parent is returned
+    UpdateDirStatRequest request;
+    request.set_fsid(fsId);
+    request.set_inodeid(2);
+    request.mutable_delta()->set_bytes(100);
+    request.mutable_delta()->set_files(2);
+    request.mutable_delta()->set_subdirs(1);
+    uint64_t parent = 0;
+    DirStat stat;
+    ASSERT_EQ(manager.UpdateDirStat(request, &parent, &stat),
+              MetaStatusCode::OK);
+    ASSERT_EQ(parent, 1);
+    ASSERT_EQ(stat.bytes(), 100);
+    request.mutable_delta()->set_bytes(-40);
+    request.mutable_delta()->set_files(-1);
+    request.mutable_delta()->set_subdirs(0);
+    ASSERT_EQ(manager.UpdateDirStat(request, &parent, &stat),
+              MetaStatusCode::OK);
+
+    Inode out;
+    ASSERT_EQ(manager.GetInode(fsId, 2, &out), MetaStatusCode::OK);
+    ASSERT_EQ(out.dirstat().bytes(), 60);
+    ASSERT_EQ(out.dirstat().files(), 1);
+    ASSERT_EQ(out.dirstat().subdirs(), 1);
+
+    // CASE 2: reparent only, the stat is kept
+    request.clear_delta();
+    request.set_parent(5);
+    ASSERT_EQ(manager.UpdateDirStat(request, &parent, &stat),
+              MetaStatusCode::OK);
+    ASSERT_EQ(parent, 5);
+    ASSERT_EQ(stat.bytes(), 60);
+    ASSERT_EQ(manager.GetInode(fsId, 2, &out), MetaStatusCode::OK);
+    ASSERT_EQ(out.parent(), 5);
+    ASSERT_EQ(out.dirstat().bytes(), 60);
+
+    // CASE 3: the stat is kept by UpdateInode
+    UpdateInodeRequest updateRequest = MakeUpdateInodeRequestFromInode(out);
+    updateRequest.set_length(4096);
+    ASSERT_EQ(manager.UpdateInode(updateRequest), MetaStatusCode::OK);
+    ASSERT_EQ(manager.GetInode(fsId, 2, &out), MetaStatusCode::OK);
+    ASSERT_EQ(out.dirstat().files(), 1);
+
+    // CASE 4: delta on file or missing inode
+    request.set_inodeid(3);
+    request.mutable_delta()->set_files(1);
+    ASSERT_EQ(manager.UpdateDirStat(request, &parent, &stat),
+              MetaStatusCode::PARAM_ERROR);
+    request.set_inodeid(100);
+    ASSERT_EQ(manager.UpdateDirStat(request, &parent, &stat),
+              MetaStatusCode::NOT_FOUND);
+}
 }  // namespace metaserver
 }  // namespace curvefs
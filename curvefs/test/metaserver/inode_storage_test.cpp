@@ -99,15 +99,57 @@ TEST_F(InodeStorageTest, test1) {
     ASSERT_FALSE(CompareInode(oldInode, inode2));
     ASSERT_TRUE(CompareInode(newInode, inode2));
 
-    // GetInodeContainer
-    auto mapPtr = storage.GetContainer();
-    ASSERT_TRUE(CompareInode(*((*mapPtr)[InodeKey(inode2)]), inode2));
-    ASSERT_TRUE(CompareInode(*((*mapPtr)[InodeKey(inode3)]), inode3));
-
     // GetInodeIdList
     std::list<uint64_t> inodeIdList;
     storage.GetInodeIdList(&inodeIdList);
     ASSERT_EQ(inodeIdList.size(), 2);
 }
+
+TEST_F(InodeStorageTest, Stripes) {
+    MemoryInodeStorage storage(true, 4);
+    for (uint64_t inodeId = 1; inodeId <= 100; inodeId++) {
+        Inode inode;
+        inode.set_fsid(1);
+        inode.set_inodeid(inodeId);
+        inode.set_atime(inodeId);
+        ASSERT_EQ(storage.Insert(inode), MetaStatusCode::OK);
+    }
+    ASSERT_EQ(storage.Count(), 100);
+
+    Inode temp;
+    ASSERT_EQ(storage.GetCopy(InodeKey(1, 37), &temp), MetaStatusCode::OK);
+    ASSERT_EQ(temp.atime(), 37);
+    ASSERT_EQ(storage.Delete(InodeKey(1, 37)), MetaStatusCode::OK);
+    ASSERT_EQ(storage.GetCopy(InodeKey(1, 37), &temp),
+              MetaStatusCode::NOT_FOUND);
+
+    S3ChunkInfoList list;
+    list.add_s3chunks()->set_chunkid(1);
+    ASSERT_EQ(storage.UpdateS3ChunkInfoList(InodeKey(1, 38), 0, list),
+              MetaStatusCode::OK);
+    ASSERT_EQ(storage.UpdateS3ChunkInfoList(InodeKey(1, 39), 0, list),
+              MetaStatusCode::OK);
+
+    std::list<uint64_t> inodeIdList;
+    storage.GetInodeIdList(&inodeIdList);
+    ASSERT_EQ(inodeIdList.size(), 99);
+
+    // all stripes are iterated
+    auto iterator = storage.NewIterator(1);
+    ASSERT_EQ(iterator->Size(), 99);
+    uint64_t count = 0;
+    for (iterator->SeekToFirst(); iterator->Valid(); iterator->Next()) {
+        ASSERT_EQ(iterator->Key(), "i:1");
+        count++;
+    }
+    ASSERT_EQ(count, 99);
+    ASSERT_EQ(storage.NewS3ChunkInfoIterator(1)->Size(), 2);
+
+    InodeChanges changes;
+    ASSERT_EQ(storage.TakeChanges(&changes), MetaStatusCode::OK);
+    ASSERT_EQ(changes.inodes.size(), 99);
+    ASSERT_EQ(changes.removedInodes.size(), 1);
+    ASSERT_EQ(changes.s3ChunkInfoLists.size(), 2);
+}
 }  // namespace metaserver
 }  // namespace curvefs
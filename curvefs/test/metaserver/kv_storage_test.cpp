@@ -0,0 +1,360 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2022-03-02
+ */
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "curvefs/src/metaserver/dentry_storage.h"
+#include "curvefs/src/metaserver/inode_storage.h"
+#include "curvefs/src/metaserver/kv_storage.h"
+
+namespace curvefs {
+namespace metaserver {
+
+using TX_OP_TYPE = DentryStorage::TX_OP_TYPE;
+
+class KVStorageTest : public ::testing::Test {
+ protected:
+    std::shared_ptr<KVStore> NewStore(const std::string &name) {
+        std::string path = "./kv_storage_test_" + name + "_" +
+                           std::to_string(getpid());
+        leveldb::Options options;
+        options.create_if_missing = true;
+        leveldb::DB *db = nullptr;
+        EXPECT_TRUE(leveldb::DB::Open(options, path, &db).ok());
+        return std::make_shared<KVStore>(db, path);
+    }
+
+    Inode GenInode(uint32_t fsId, uint64_t inodeId, uint64_t atime) {
+        Inode inode;
+        inode.set_fsid(fsId);
+        inode.set_inodeid(inodeId);
+        inode.set_length(0);
+        inode.set_ctime(0);
+        inode.set_ctime_ns(0);
+        inode.set_mtime(0);
+        inode.set_mtime_ns(0);
+        inode.set_atime(atime);
+        inode.set_atime_ns(0);
+        inode.set_uid(0);
+        inode.set_gid(0);
+        inode.set_mode(0);
+        inode.set_nlink(1);
+        inode.set_type(FsFileType::TYPE_FILE);
+        return inode;
+    }
+
+    Dentry GenDentry(uint32_t fsId,
+                     uint64_t parentId,
+                     const std::string& name,
+                     uint64_t txId,
+                     uint64_t inodeId,
+                     bool deleteMarkFlag) {
+        Dentry dentry;
+        dentry.set_fsid(fsId);
+        dentry.set_parentinodeid(parentId);
+        dentry.set_name(name);
+        dentry.set_txid(txId);
+        dentry.set_inodeid(inodeId);
+        dentry.set_flag(deleteMarkFlag ? DentryFlag::DELETE_MARK_FLAG : 0);
+        return dentry;
+    }
+
+    S3ChunkInfoList GenS3ChunkInfoList(uint64_t firstChunkId, int count) {
+        S3ChunkInfoList list;
+        for (int i = 0; i < count; i++) {
+            S3ChunkInfo *info = list.add_s3chunks();
+            info->set_chunkid(firstChunkId + i);
+            info->set_compaction(0);
+            info->set_offset(i);
+            info->set_len(1);
+            info->set_size(1);
+            info->set_zero(false);
+        }
+        return list;
+    }
+
+    void TestS3ChunkInfo(InodeStorage *storage) {
+        Inode inode1 = GenInode(1, 1, 100);
+        Inode inode2 = GenInode(1, 2, 200);
+        (*inode1.mutable_s3chunkinfomap())[0] = GenS3ChunkInfoList(1, 2);
+        (*inode1.mutable_s3chunkinfomap())[3] = GenS3ChunkInfoList(3, 1);
+
+        // chunk infos of the inode inserted are kept apart from it
+        ASSERT_EQ(storage->Insert(inode1), MetaStatusCode::OK);
+        ASSERT_EQ(storage->Insert(inode2), MetaStatusCode::OK);
+        Inode temp;
+        ASSERT_EQ(storage->GetCopy(InodeKey(inode1), &temp),
+                  MetaStatusCode::OK);
+        ASSERT_EQ(temp.s3chunkinfomap_size(), 0);
+        S3ChunkInfoList list;
+        ASSERT_EQ(storage->GetS3ChunkInfoList(InodeKey(inode1), 3, &list),
+                  MetaStatusCode::OK);
+        ASSERT_EQ(list.s3chunks_size(), 1);
+        ASSERT_EQ(storage->GetS3ChunkInfoList(InodeKey(inode1), 1, &list),
+                  MetaStatusCode::NOT_FOUND);
+
+        // update and range list
+        ASSERT_EQ(storage->UpdateS3ChunkInfoList(InodeKey(inode2), 1,
+                                                 GenS3ChunkInfoList(4, 3)),
+                  MetaStatusCode::OK);
+        ASSERT_EQ(storage->UpdateS3ChunkInfoList(InodeKey(inode1), 5,
+                                                 GenS3ChunkInfoList(7, 1)),
+                  MetaStatusCode::OK);
+        S3ChunkInfoMap out;
+        ASSERT_EQ(storage->ListS3ChunkInfo(InodeKey(inode1), 0, UINT64_MAX,
+                                           &out),
+                  MetaStatusCode::OK);
+        ASSERT_EQ(out.size(), 3);
+        ASSERT_EQ(out.at(0).s3chunks_size(), 2);
+        out.clear();
+        ASSERT_EQ(storage->ListS3ChunkInfo(InodeKey(inode1), 1, 5, &out),
+                  MetaStatusCode::OK);
+        ASSERT_EQ(out.size(), 1);
+        ASSERT_EQ(out.count(3), 1);
+
+        // update of inode doesn't touch the chunk infos
+        inode1.clear_s3chunkinfomap();
+        inode1.set_atime(300);
+        ASSERT_EQ(storage->Update(inode1), MetaStatusCode::OK);
+        out.clear();
+        ASSERT_EQ(storage->ListS3ChunkInfo(InodeKey(inode1), 0, UINT64_MAX,
+                                           &out),
+                  MetaStatusCode::OK);
+        ASSERT_EQ(out.size(), 3);
+
+        // empty list removes the chunk
+        ASSERT_EQ(storage->UpdateS3ChunkInfoList(InodeKey(inode1), 0,
+                                                 S3ChunkInfoList()),
+                  MetaStatusCode::OK);
+        ASSERT_EQ(storage->GetS3ChunkInfoList(InodeKey(inode1), 0, &list),
+                  MetaStatusCode::NOT_FOUND);
+
+        // delete inode removes its chunk infos only
+        ASSERT_EQ(storage->Delete(InodeKey(inode1)), MetaStatusCode::OK);
+        out.clear();
+        ASSERT_EQ(storage->ListS3ChunkInfo(InodeKey(inode1), 0, UINT64_MAX,
+                                           &out),
+                  MetaStatusCode::OK);
+        ASSERT_EQ(out.size(), 0);
+        ASSERT_EQ(storage->ListS3ChunkInfo(InodeKey(inode2), 0, UINT64_MAX,
+                                           &out),
+                  MetaStatusCode::OK);
+        ASSERT_EQ(out.size(), 1);
+        ASSERT_EQ(out.at(1).s3chunks_size(), 3);
+
+        auto iterator = storage->NewS3ChunkInfoIterator(5);
+        ASSERT_EQ(iterator->Size(), 1);
+        uint64_t count = 0;
+        for (iterator->SeekToFirst(); iterator->Valid(); iterator->Next()) {
+            ASSERT_EQ(iterator->Key(), "s:5");
+            InodeS3ChunkInfoList value;
+            ASSERT_TRUE(value.ParseFromString(iterator->Value()));
+            ASSERT_EQ(value.inodeid(), 2);
+            ASSERT_EQ(value.chunkindex(), 1);
+            count++;
+        }
+        ASSERT_EQ(count, 1);
+    }
+
+    // run on both storages and expect the same result
+    void ExpectList(MemoryDentryStorage *memory, KVDentryStorage *kv,
+                    const Dentry &dentry, uint32_t limit) {
+        std::vector<Dentry> expected;
+        std::vector<Dentry> actual;
+        ASSERT_EQ(memory->List(dentry, &expected, limit),
+                  kv->List(dentry, &actual, limit));
+        ASSERT_EQ(expected, actual);
+    }
+};
+
+TEST_F(KVStorageTest, InodeStorage) {
+    // cache only one inode, so most of reads go to the store
+    KVInodeStorage storage(NewStore("inode"), NewStore("chunk"), 1);
+    Inode inode1 = GenInode(1, 1, 100);
+    Inode inode2 = GenInode(2, 1, 200);
+    Inode inode3 = GenInode(1, 2, 300);
+
+    // insert
+    ASSERT_EQ(storage.Insert(inode1), MetaStatusCode::OK);
+    ASSERT_EQ(storage.Insert(inode2), MetaStatusCode::OK);
+    ASSERT_EQ(storage.Insert(inode3), MetaStatusCode::OK);
+    ASSERT_EQ(storage.Insert(inode1), MetaStatusCode::INODE_EXIST);
+    ASSERT_EQ(storage.Count(), 3);
+
+    // get
+    Inode temp;
+    ASSERT_EQ(storage.GetCopy(InodeKey(inode1), &temp), MetaStatusCode::OK);
+    ASSERT_EQ(temp.atime(), 100);
+    InodeAttr attr;
+    ASSERT_EQ(storage.GetAttr(InodeKey(inode2), &attr), MetaStatusCode::OK);
+    ASSERT_EQ(attr.atime(), 200);
+    ASSERT_EQ(storage.GetCopy(InodeKey(3, 3), &temp),
+              MetaStatusCode::NOT_FOUND);
+
+    // modify in place and update
+    std::shared_ptr<Inode> inode;
+    ASSERT_EQ(storage.Get(InodeKey(inode3), &inode), MetaStatusCode::OK);
+    inode->set_atime(400);
+    ASSERT_EQ(storage.Update(*inode), MetaStatusCode::OK);
+    // evict inode3 from cache
+    ASSERT_EQ(storage.GetCopy(InodeKey(inode1), &temp), MetaStatusCode::OK);
+    ASSERT_EQ(storage.GetCopy(InodeKey(inode3), &temp), MetaStatusCode::OK);
+    ASSERT_EQ(temp.atime(), 400);
+
+    // delete
+    ASSERT_EQ(storage.Delete(InodeKey(inode1)), MetaStatusCode::OK);
+    ASSERT_EQ(storage.Delete(InodeKey(inode1)), MetaStatusCode::NOT_FOUND);
+    ASSERT_EQ(storage.Update(inode1), MetaStatusCode::NOT_FOUND);
+    ASSERT_EQ(storage.Count(), 2);
+
+    std::list<uint64_t> inodeIdList;
+    storage.GetInodeIdList(&inodeIdList);
+    ASSERT_EQ(inodeIdList, std::list<uint64_t>({2, 1}));
+}
+
+TEST_F(KVStorageTest, InodeIterator) {
+    KVInodeStorage storage(NewStore("inode"), NewStore("chunk"), 0);
+    ASSERT_EQ(storage.Insert(GenInode(1, 1, 100)), MetaStatusCode::OK);
+    ASSERT_EQ(storage.Insert(GenInode(1, 2, 200)), MetaStatusCode::OK);
+
+    // the iterator reads the snapshot taken at creation
+    auto iterator = storage.NewIterator(5);
+    ASSERT_EQ(storage.Insert(GenInode(1, 3, 300)), MetaStatusCode::OK);
+    ASSERT_EQ(iterator->Size(), 2);
+
+    uint64_t atime = 100;
+    uint64_t count = 0;
+    for (iterator->SeekToFirst(); iterator->Valid(); iterator->Next()) {
+        ASSERT_EQ(iterator->Key(), "i:5");
+        Inode inode;
+        ASSERT_TRUE(inode.ParseFromString(iterator->Value()));
+        ASSERT_EQ(inode.atime(), atime);
+        atime += 100;
+        count++;
+    }
+    ASSERT_EQ(count, 2);
+    ASSERT_EQ(iterator->Status(), 0);
+}
+
+TEST_F(KVStorageTest, S3ChunkInfo) {
+    MemoryInodeStorage memory;
+    TestS3ChunkInfo(&memory);
+
+    KVInodeStorage kv(NewStore("inode"), NewStore("chunk"), 1);
+    TestS3ChunkInfo(&kv);
+}
+
+TEST_F(KVStorageTest, DentryStorage) {
+    MemoryDentryStorage memory;
+    KVDentryStorage kv(NewStore("dentry"));
+
+    // the kv storage must behave the same as the memory storage
+    auto expect = [&](std::function<MetaStatusCode(DentryStorage*)> op) {
+        ASSERT_EQ(op(&memory), op(&kv));
+        ASSERT_EQ(memory.Size(), kv.Size());
+    };
+
+    auto insert = [&](const Dentry& dentry) {
+        expect([&](DentryStorage* s) { return s->Insert(dentry); });
+    };
+    auto handleTx = [&](TX_OP_TYPE type, const Dentry& dentry) {
+        expect([&](DentryStorage* s) { return s->HandleTx(type, dentry); });
+    };
+
+    insert(GenDentry(1, 0, "A", 0, 1, false));
+    insert(GenDentry(1, 0, "A", 0, 1, false));  // idempotence
+    insert(GenDentry(1, 0, "A", 0, 2, false));  // exist
+    insert(GenDentry(1, 0, "B", 0, 3, false));
+    insert(GenDentry(1, 0, "AA", 0, 4, false));
+    insert(GenDentry(1, 1, "C", 0, 5, false));
+    insert(GenDentry(2, 0, "A", 0, 6, false));
+
+    // rename B to D in tx 1
+    handleTx(TX_OP_TYPE::PREPARE, GenDentry(1, 0, "B", 1, 3, true));
+    handleTx(TX_OP_TYPE::PREPARE, GenDentry(1, 0, "D", 1, 3, false));
+    handleTx(TX_OP_TYPE::PREPARE, GenDentry(1, 0, "D", 1, 3, false));
+    ExpectList(&memory, &kv, GenDentry(1, 0, "", 0, 0, false), 0);
+    ExpectList(&memory, &kv, GenDentry(1, 0, "", 1, 0, false), 0);
+    handleTx(TX_OP_TYPE::COMMIT, GenDentry(1, 0, "B", 1, 3, true));
+    handleTx(TX_OP_TYPE::COMMIT, GenDentry(1, 0, "D", 1, 3, false));
+
+    // rename A to E in tx 2, and rollback
+    handleTx(TX_OP_TYPE::PREPARE, GenDentry(1, 0, "A", 2, 1, true));
+    handleTx(TX_OP_TYPE::PREPARE, GenDentry(1, 0, "E", 2, 1, false));
+    handleTx(TX_OP_TYPE::ROLLBACK, GenDentry(1, 0, "A", 2, 1, true));
+    handleTx(TX_OP_TYPE::ROLLBACK, GenDentry(1, 0, "E", 2, 1, false));
+    handleTx(TX_OP_TYPE::ROLLBACK, GenDentry(1, 0, "E", 2, 1, false));
+
+    // get
+    for (const auto& name : {"A", "B", "D", "E"}) {
+        auto dentry1 = GenDentry(1, 0, name, 2, 0, false);
+        auto dentry2 = dentry1;
+        ASSERT_EQ(memory.Get(&dentry1), kv.Get(&dentry2));
+        ASSERT_EQ(dentry1, dentry2);
+    }
+
+    // list
+    for (uint32_t limit = 0; limit < 4; limit++) {
+        ExpectList(&memory, &kv, GenDentry(1, 0, "", 2, 0, false), limit);
+        ExpectList(&memory, &kv, GenDentry(1, 0, "A", 2, 0, false), limit);
+        ExpectList(&memory, &kv, GenDentry(1, 0, "AA", 2, 0, false), limit);
+    }
+    ExpectList(&memory, &kv, GenDentry(1, 1, "", 0, 0, false), 0);
+    ExpectList(&memory, &kv, GenDentry(1, 2, "", 0, 0, false), 0);
+    ExpectList(&memory, &kv, GenDentry(2, 0, "", 0, 0, false), 0);
+
+    // delete
+    expect([&](DentryStorage* s) {
+        return s->Delete(GenDentry(1, 0, "A", 2, 0, false));
+    });
+    expect([&](DentryStorage* s) {
+        return s->Delete(GenDentry(1, 0, "A", 2, 0, false));
+    });
+    ExpectList(&memory, &kv, GenDentry(1, 0, "", 2, 0, false), 0);
+
+    // iterator
+    auto iterator = kv.NewIterator(3);
+    ASSERT_EQ(iterator->Size(), kv.Size());
+    uint64_t count = 0;
+    for (iterator->SeekToFirst(); iterator->Valid(); iterator->Next()) {
+        ASSERT_EQ(iterator->Key(), "d:3");
+        Dentry dentry;
+        ASSERT_TRUE(dentry.ParseFromString(iterator->Value()));
+        count++;
+    }
+    ASSERT_EQ(count, kv.Size());
+
+    kv.Clear();
+    ASSERT_EQ(kv.Size(), 0);
+    std::vector<Dentry> dentrys;
+    ASSERT_EQ(kv.List(GenDentry(1, 0, "", 2, 0, false), &dentrys, 0),
+              MetaStatusCode::NOT_FOUND);
+}
+
+}  // namespace metaserver
+}  // namespace curvefs
@@ -23,7 +23,11 @@
 #include "curvefs/src/metaserver/metastore.h"
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <sys/stat.h>
 #include <condition_variable>  // NOLINT
+#include <cstdlib>
+#include <string>
+#include <vector>
 #include "curvefs/src/common/process.h"
 
 using ::testing::_;
@@ -115,20 +119,27 @@ class MetastoreTest : public ::testing::Test {
             ret_ = false;
             LOG(INFO) << "OnSnapshotSaveDone error";
         }
+        void AddFile(const std::string& filename) {
+            files_.push_back(filename);
+        }
         void Run() {
             LOG(INFO) << "OnSnapshotSaveDone Run";
             std::unique_lock<std::mutex> lk(mtx_);
+            finished_ = true;
             condition_.notify_one();
         }
         void Wait() {
             LOG(INFO) << "OnSnapshotSaveDone Wait";
             std::unique_lock<std::mutex> lk(mtx_);
-            condition_.wait(lk);
+            condition_.wait(lk, [this]() { return finished_; });
         }
         bool IsSuccess() { return ret_; }
+        const std::vector<std::string>& GetFiles() { return files_; }
 
      private:
-        bool ret_;
+        bool ret_ = false;
+        bool finished_ = false;
+        std::vector<std::string> files_;
         std::mutex mtx_;
         std::condition_variable condition_;
     };
@@ -365,6 +376,45 @@ TEST_F(MetastoreTest, test_inode) {
     ASSERT_EQ(getResponse2.statuscode(), MetaStatusCode::NOT_FOUND);
     ASSERT_EQ(getResponse2.statuscode(), ret);
 
+    // TEST BATCH GET INODE ATTR
+    BatchGetInodeAttrRequest batchRequest;
+    BatchGetInodeAttrResponse batchResponse;
+    batchRequest.set_poolid(poolId);
+    batchRequest.set_copysetid(copysetId);
+    batchRequest.set_partitionid(666);
+    batchRequest.set_fsid(fsId);
+    batchRequest.add_inodeid(createResponse.inode().inodeid());
+    batchRequest.add_inodeid(createResponse3.inode().inodeid());
+    // not exist inode is skipped
+    batchRequest.add_inodeid(createResponse.inode().inodeid() + 100);
+
+    ret = metastore.BatchGetInodeAttr(&batchRequest, &batchResponse);
+    ASSERT_EQ(batchResponse.statuscode(),
+              MetaStatusCode::PARTITION_NOT_FOUND);
+    ASSERT_EQ(batchResponse.statuscode(), ret);
+
+    batchRequest.set_partitionid(partitionId);
+    ret = metastore.BatchGetInodeAttr(&batchRequest, &batchResponse);
+    ASSERT_EQ(batchResponse.statuscode(), MetaStatusCode::OK);
+    ASSERT_EQ(batchResponse.statuscode(), ret);
+    ASSERT_EQ(2, batchResponse.attr_size());
+    ASSERT_EQ(batchResponse.attr(0).inodeid(),
+              createResponse.inode().inodeid());
+    ASSERT_EQ(batchResponse.attr(0).length(), length);
+    ASSERT_EQ(batchResponse.attr(0).mode(), mode);
+    ASSERT_EQ(batchResponse.attr(0).type(), type);
+    ASSERT_EQ(batchResponse.attr(1).inodeid(),
+              createResponse3.inode().inodeid());
+    ASSERT_EQ(batchResponse.attr(1).symlink(), "symlink");
+
+    // inode not belongs to partition
+    BatchGetInodeAttrResponse batchResponse2;
+    batchRequest.add_inodeid(partitionInfo1.end() + 1);
+    ret = metastore.BatchGetInodeAttr(&batchRequest, &batchResponse2);
+    ASSERT_EQ(batchResponse2.statuscode(),
+              MetaStatusCode::PARTITION_ID_MISSMATCH);
+    ASSERT_EQ(0, batchResponse2.attr_size());
+
     // update inode
     // no param need update
     UpdateInodeRequest updateRequest;
@@ -439,6 +489,66 @@ TEST_F(MetastoreTest, test_inode) {
     ASSERT_EQ(updateResponse3.statuscode(), MetaStatusCode::PARAM_ERROR);
     ASSERT_EQ(updateResponse3.statuscode(), ret);
 
+    // batch update inode
+    BatchUpdateInodeRequest batchUpdateRequest;
+    BatchUpdateInodeResponse batchUpdateResponse;
+    batchUpdateRequest.set_poolid(poolId);
+    batchUpdateRequest.set_copysetid(copysetId);
+    batchUpdateRequest.set_partitionid(666);
+    batchUpdateRequest.set_fsid(fsId);
+    UpdateInodeRequest* update = batchUpdateRequest.add_updateinode();
+    update->set_poolid(poolId);
+    update->set_copysetid(copysetId);
+    update->set_partitionid(partitionId);
+    update->set_fsid(fsId);
+    update->set_inodeid(createResponse.inode().inodeid());
+    update->set_length(length + 2);
+    // inode not exist is skipped
+    update = batchUpdateRequest.add_updateinode();
+    update->CopyFrom(batchUpdateRequest.updateinode(0));
+    update->set_inodeid(999);
+    InodeS3ChunkInfoAdd* s3Add = batchUpdateRequest.add_s3chunkinfoadd();
+    s3Add->set_inodeid(createResponse.inode().inodeid());
+    S3ChunkInfoList s3ChunkInfoList2;
+    S3ChunkInfo* s3ChunkInfo = s3ChunkInfoList2.add_s3chunks();
+    s3ChunkInfo->set_chunkid(1);
+    s3ChunkInfo->set_compaction(0);
+    s3ChunkInfo->set_offset(0);
+    s3ChunkInfo->set_len(length + 2);
+    s3ChunkInfo->set_size(length + 2);
+    s3ChunkInfo->set_zero(false);
+    s3Add->mutable_s3chunkinfoadd()->insert({0, s3ChunkInfoList2});
+
+    // BatchUpdateInode wrong partitionid
+    ret = metastore.BatchUpdateInode(&batchUpdateRequest,
+                                     &batchUpdateResponse);
+    ASSERT_EQ(ret, MetaStatusCode::PARTITION_NOT_FOUND);
+    ASSERT_EQ(batchUpdateResponse.statuscode(), ret);
+
+    batchUpdateRequest.set_partitionid(partitionId);
+    ret = metastore.BatchUpdateInode(&batchUpdateRequest,
+                                     &batchUpdateResponse);
+    ASSERT_EQ(ret, MetaStatusCode::OK);
+    ASSERT_EQ(batchUpdateResponse.statuscode(), ret);
+    ASSERT_EQ(0, batchUpdateResponse.failedinodeid_size());
+
+    GetInodeResponse getResponse5;
+    ret = metastore.GetInode(&getRequest4, &getResponse5);
+    ASSERT_EQ(ret, MetaStatusCode::OK);
+    ASSERT_EQ(getResponse5.inode().length(), length + 2);
+    ASSERT_EQ(getResponse5.inode().s3chunkinfomap().size(), 1);
+    ASSERT_EQ(getResponse5.inode().s3chunkinfomap().at(0).s3chunks_size(), 1);
+
+    // inode not belongs to the partition, nothing is updated
+    batchUpdateRequest.mutable_updateinode(0)->set_length(length + 3);
+    batchUpdateRequest.mutable_s3chunkinfoadd(0)->set_inodeid(1001);
+    ret = metastore.BatchUpdateInode(&batchUpdateRequest,
+                                     &batchUpdateResponse);
+    ASSERT_EQ(ret, MetaStatusCode::PARTITION_ID_MISSMATCH);
+    ret = metastore.GetInode(&getRequest4, &getResponse5);
+    ASSERT_EQ(ret, MetaStatusCode::OK);
+    ASSERT_EQ(getResponse5.inode().length(), length + 2);
+
     // DELETE INODE
     DeleteInodeRequest deleteRequest;
     DeleteInodeResponse deleteResponse;
@@ -826,6 +936,106 @@ TEST_F(MetastoreTest, persist_success) {
     ASSERT_TRUE(metastore.Clear());
 }
 
+// the retries after the snapshot are deduplicated by the replica loading it
+TEST_F(MetastoreTest, persist_applied_requests) {
+    MetaStoreImpl metastore(nullptr);
+    uint32_t partitionId = 4;
+    uint32_t fsId = 1;
+    CreatePartitionRequest createPartitionRequest;
+    CreatePartitionResponse createPartitionResponse;
+    PartitionInfo partitionInfo;
+    partitionInfo.set_fsid(fsId);
+    partitionInfo.set_poolid(2);
+    partitionInfo.set_copysetid(3);
+    partitionInfo.set_partitionid(partitionId);
+    partitionInfo.set_start(100);
+    partitionInfo.set_end(1000);
+    partitionInfo.set_txid(100);
+    partitionInfo.set_status(PartitionStatus::READWRITE);
+    createPartitionRequest.mutable_partition()->CopyFrom(partitionInfo);
+    ASSERT_EQ(MetaStatusCode::OK,
+              metastore.CreatePartition(&createPartitionRequest,
+                                        &createPartitionResponse));
+
+    CreateInodeRequest createInodeRequest;
+    CreateInodeResponse createInodeResponse;
+    createInodeRequest.set_poolid(2);
+    createInodeRequest.set_copysetid(3);
+    createInodeRequest.set_partitionid(partitionId);
+    createInodeRequest.set_fsid(fsId);
+    createInodeRequest.set_length(0);
+    createInodeRequest.set_uid(100);
+    createInodeRequest.set_gid(200);
+    createInodeRequest.set_mode(0755);
+    createInodeRequest.set_type(FsFileType::TYPE_DIRECTORY);
+    ASSERT_EQ(MetaStatusCode::OK,
+              metastore.CreateInode(&createInodeRequest,
+                                    &createInodeResponse));
+    uint64_t dirId = createInodeResponse.inode().inodeid();
+
+    CreateInodeAndDentryRequest createRequest;
+    createRequest.set_poolid(2);
+    createRequest.set_copysetid(3);
+    createRequest.set_partitionid(partitionId);
+    createRequest.set_fsid(fsId);
+    createRequest.set_length(0);
+    createRequest.set_uid(100);
+    createRequest.set_gid(200);
+    createRequest.set_mode(0644);
+    createRequest.set_type(FsFileType::TYPE_FILE);
+    createRequest.set_parentinodeid(dirId);
+    createRequest.set_name("file");
+    createRequest.set_txid(0);
+    createRequest.set_requestid(1000);
+    auto create = [&](MetaStoreImpl* store,
+                      CreateInodeAndDentryResponse* response) {
+        uint64_t inodeId = 0;
+        EXPECT_EQ(MetaStatusCode::OK,
+                  store->ReserveInodeId(partitionId, &inodeId));
+        return store->CreateInodeAndDentry(&createRequest, inodeId,
+                                           response);
+    };
+    CreateInodeAndDentryResponse createResponse;
+    ASSERT_EQ(MetaStatusCode::OK, create(&metastore, &createResponse));
+
+    UpdateDirStatRequest statRequest;
+    UpdateDirStatResponse statResponse;
+    statRequest.set_poolid(2);
+    statRequest.set_copysetid(3);
+    statRequest.set_partitionid(partitionId);
+    statRequest.set_fsid(fsId);
+    statRequest.set_inodeid(dirId);
+    statRequest.mutable_delta()->set_bytes(100);
+    statRequest.mutable_delta()->set_files(1);
+    statRequest.set_requestid(2000);
+    ASSERT_EQ(MetaStatusCode::OK,
+              metastore.UpdateDirStat(&statRequest, &statResponse));
+    ASSERT_EQ(100, statResponse.stat().bytes());
+
+    OnSnapshotSaveDoneImpl done;
+    ASSERT_TRUE(metastore.Save("./metastore_test", &done));
+    done.Wait();
+    ASSERT_TRUE(done.IsSuccess());
+
+    MetaStoreImpl metastoreNew(nullptr);
+    ASSERT_TRUE(metastoreNew.Load("./metastore_test"));
+
+    // the retry gets the inode created before the snapshot
+    CreateInodeAndDentryResponse retried;
+    ASSERT_EQ(MetaStatusCode::OK, create(&metastoreNew, &retried));
+    ASSERT_EQ(createResponse.inode().inodeid(), retried.inode().inodeid());
+
+    // the delta of the retry isn't added again
+    UpdateDirStatResponse statRetried;
+    ASSERT_EQ(MetaStatusCode::OK,
+              metastoreNew.UpdateDirStat(&statRequest, &statRetried));
+    ASSERT_EQ(100, statRetried.stat().bytes());
+    ASSERT_EQ(1, statRetried.stat().files());
+
+    ASSERT_TRUE(metastore.Clear());
+    ASSERT_TRUE(metastoreNew.Clear());
+}
+
 TEST_F(MetastoreTest, persist_deleting_partition_success) {
     MetaStoreImpl metastore(nullptr);
     uint32_t partitionId = 4;
@@ -1084,6 +1294,200 @@ TEST_F(MetastoreTest, persist_dentry_fail) {
     ASSERT_TRUE(metastore.Clear());
 }
 
+TEST_F(MetastoreTest, persist_incremental_success) {
+    KVStorageOption option;
+    option.incrementalSnapshot = true;
+    option.snapshotMaxDeltas = 2;
+    option.snapshotMaxDeltaPercent = 1000;
+    ASSERT_EQ(0, KVStorageManager::GetInstance().Init(option));
+
+    std::string dir = "./metastore_incremental_test";
+    ASSERT_EQ(0, system(("rm -rf " + dir).c_str()));
+    ASSERT_EQ(0, mkdir(dir.c_str(), 0755));
+    auto save = [&](MetaStoreImpl* metastore, const std::string& name,
+                    std::vector<std::string>* files) {
+        ASSERT_EQ(0, mkdir((dir + "/" + name).c_str(), 0755));
+        OnSnapshotSaveDoneImpl done;
+        ASSERT_TRUE(metastore->Save(dir + "/" + name + "/metadata", &done));
+        done.Wait();
+        ASSERT_TRUE(done.IsSuccess());
+        *files = done.GetFiles();
+    };
+
+    MetaStoreImpl metastore(nullptr);
+    uint32_t partitionId = 4;
+    uint32_t fsId = 1;
+    CreatePartitionRequest createPartitionRequest;
+    CreatePartitionResponse createPartitionResponse;
+    PartitionInfo partitionInfo;
+    partitionInfo.set_fsid(fsId);
+    partitionInfo.set_poolid(2);
+    partitionInfo.set_copysetid(3);
+    partitionInfo.set_partitionid(partitionId);
+    partitionInfo.set_start(100);
+    partitionInfo.set_end(1000);
+    partitionInfo.set_txid(100);
+    partitionInfo.set_status(PartitionStatus::READWRITE);
+    createPartitionRequest.mutable_partition()->CopyFrom(partitionInfo);
+    ASSERT_EQ(MetaStatusCode::OK,
+              metastore.CreatePartition(&createPartitionRequest,
+                                        &createPartitionResponse));
+
+    CreateInodeRequest createInodeRequest;
+    createInodeRequest.set_poolid(2);
+    createInodeRequest.set_copysetid(3);
+    createInodeRequest.set_partitionid(partitionId);
+    createInodeRequest.set_fsid(fsId);
+    createInodeRequest.set_length(0);
+    createInodeRequest.set_uid(100);
+    createInodeRequest.set_gid(200);
+    createInodeRequest.set_mode(777);
+    createInodeRequest.set_type(FsFileType::TYPE_DIRECTORY);
+    auto createInode = [&]() {
+        CreateInodeResponse response;
+        EXPECT_EQ(MetaStatusCode::OK,
+                  metastore.CreateInode(&createInodeRequest, &response));
+        return response.inode().inodeid();
+    };
+    auto createDentry = [&](const std::string& name, uint64_t inodeId) {
+        CreateDentryRequest request;
+        CreateDentryResponse response;
+        request.set_poolid(2);
+        request.set_copysetid(3);
+        request.set_partitionid(partitionId);
+        Dentry* dentry = request.mutable_dentry();
+        dentry->set_fsid(fsId);
+        dentry->set_inodeid(inodeId);
+        dentry->set_parentinodeid(100);
+        dentry->set_name(name);
+        dentry->set_txid(0);
+        EXPECT_EQ(MetaStatusCode::OK,
+                  metastore.CreateDentry(&request, &response));
+    };
+
+    uint64_t inode1 = createInode();
+    uint64_t inode2 = createInode();
+    uint64_t inode3 = createInode();
+    createDentry("dentry2", inode2);
+    createDentry("dentry3", inode3);
+
+    // the first snapshot is a base
+    std::vector<std::string> files;
+    save(&metastore, "1", &files);
+    ASSERT_TRUE(files.empty());
+
+    // remove, update and insert entries
+    DeleteDentryRequest deleteDentryRequest;
+    DeleteDentryResponse deleteDentryResponse;
+    deleteDentryRequest.set_poolid(2);
+    deleteDentryRequest.set_copysetid(3);
+    deleteDentryRequest.set_partitionid(partitionId);
+    deleteDentryRequest.set_fsid(fsId);
+    deleteDentryRequest.set_parentinodeid(100);
+    deleteDentryRequest.set_name("dentry3");
+    deleteDentryRequest.set_txid(0);
+    ASSERT_EQ(MetaStatusCode::OK, metastore.DeleteDentry(
+        &deleteDentryRequest, &deleteDentryResponse));
+
+    DeleteInodeRequest deleteInodeRequest;
+    DeleteInodeResponse deleteInodeResponse;
+    deleteInodeRequest.set_poolid(2);
+    deleteInodeRequest.set_copysetid(3);
+    deleteInodeRequest.set_partitionid(partitionId);
+    deleteInodeRequest.set_fsid(fsId);
+    deleteInodeRequest.set_inodeid(inode3);
+    ASSERT_EQ(MetaStatusCode::OK, metastore.DeleteInode(
+        &deleteInodeRequest, &deleteInodeResponse));
+
+    UpdateInodeRequest updateInodeRequest;
+    UpdateInodeResponse updateInodeResponse;
+    updateInodeRequest.set_poolid(2);
+    updateInodeRequest.set_copysetid(3);
+    updateInodeRequest.set_partitionid(partitionId);
+    updateInodeRequest.set_fsid(fsId);
+    updateInodeRequest.set_inodeid(inode2);
+    updateInodeRequest.set_length(4096);
+    ASSERT_EQ(MetaStatusCode::OK, metastore.UpdateInode(
+        &updateInodeRequest, &updateInodeResponse));
+
+    uint64_t inode4 = createInode();
+    createDentry("dentry4", inode4);
+
+    // only the changes are saved in a delta
+    save(&metastore, "2", &files);
+    ASSERT_EQ(files, std::vector<std::string>{"metadata.delta.1"});
+
+    auto check = [&](const std::string& name) {
+        MetaStoreImpl metastoreNew(nullptr);
+        ASSERT_TRUE(metastoreNew.Load(dir + "/" + name + "/metadata"));
+        auto partition = metastoreNew.GetPartition(partitionId);
+        ASSERT_NE(nullptr, partition);
+        ASSERT_TRUE(ComparePartition(
+            partition->GetPartitionInfo(),
+            metastore.GetPartition(partitionId)->GetPartitionInfo()));
+        ASSERT_EQ(partition->GetPartitionInfo().nextid(),
+                  metastore.GetPartition(partitionId)
+                      ->GetPartitionInfo().nextid());
+
+        Inode inode;
+        Inode expected;
+        for (auto inodeId : {inode1, inode2, inode4}) {
+            ASSERT_EQ(MetaStatusCode::OK,
+                      partition->GetInode(fsId, inodeId, &inode));
+            ASSERT_EQ(MetaStatusCode::OK,
+                      metastore.GetPartition(partitionId)
+                          ->GetInode(fsId, inodeId, &expected));
+            ASSERT_TRUE(CompareInode(inode, expected));
+        }
+        ASSERT_EQ(MetaStatusCode::NOT_FOUND,
+                  partition->GetInode(fsId, inode3, &inode));
+
+        Dentry dentry;
+        dentry.set_fsid(fsId);
+        dentry.set_parentinodeid(100);
+        dentry.set_txid(0);
+        dentry.set_name("dentry2");
+        ASSERT_EQ(MetaStatusCode::OK, partition->GetDentry(&dentry));
+        ASSERT_EQ(inode2, dentry.inodeid());
+        dentry.set_name("dentry4");
+        ASSERT_EQ(MetaStatusCode::OK, partition->GetDentry(&dentry));
+        ASSERT_EQ(inode4, dentry.inodeid());
+        dentry.set_name("dentry3");
+        ASSERT_EQ(MetaStatusCode::NOT_FOUND, partition->GetDentry(&dentry));
+    };
+    check("2");
+
+    // the base and deltas are linked to the next snapshot
+    updateInodeRequest.set_inodeid(inode4);
+    updateInodeRequest.set_length(8192);
+    ASSERT_EQ(MetaStatusCode::OK, metastore.UpdateInode(
+        &updateInodeRequest, &updateInodeResponse));
+    save(&metastore, "3", &files);
+    ASSERT_EQ(files, (std::vector<std::string>{"metadata.delta.1",
+                                               "metadata.delta.2"}));
+    check("3");
+
+    // too many deltas, save a new base
+    save(&metastore, "4", &files);
+    ASSERT_TRUE(files.empty());
+    check("4");
+
+    // a new partition can't be saved in a delta
+    save(&metastore, "5", &files);
+    ASSERT_EQ(files, std::vector<std::string>{"metadata.delta.1"});
+    partitionInfo.set_partitionid(partitionId + 1);
+    createPartitionRequest.mutable_partition()->CopyFrom(partitionInfo);
+    ASSERT_EQ(MetaStatusCode::OK,
+              metastore.CreatePartition(&createPartitionRequest,
+                                        &createPartitionResponse));
+    save(&metastore, "6", &files);
+    ASSERT_TRUE(files.empty());
+
+    ASSERT_TRUE(metastore.Clear());
+    ASSERT_EQ(0, system(("rm -rf " + dir).c_str()));
+    ASSERT_EQ(0, KVStorageManager::GetInstance().Init(KVStorageOption()));
+}
+
 }  // namespace metaserver
 }  // namespace curvefs
 
@@ -57,20 +57,38 @@ class MockMetaStore : public curvefs::metaserver::MetaStore {
 
     MOCK_METHOD2(CreateInode, MetaStatusCode(const CreateInodeRequest*,
                                              CreateInodeResponse*));
+    MOCK_METHOD2(ReserveInodeId, MetaStatusCode(uint32_t, uint64_t*));
+    MOCK_METHOD3(CreateInode, MetaStatusCode(const CreateInodeRequest*,
+                                             uint64_t, CreateInodeResponse*));
     MOCK_METHOD2(CreateRootInode, MetaStatusCode(const CreateRootInodeRequest*,
                                                  CreateRootInodeResponse*));
     MOCK_METHOD2(GetInode,
                  MetaStatusCode(const GetInodeRequest*, GetInodeResponse*));
+    MOCK_METHOD2(BatchGetInodeAttr,
+                 MetaStatusCode(const BatchGetInodeAttrRequest*,
+                                BatchGetInodeAttrResponse*));
     MOCK_METHOD2(DeleteInode, MetaStatusCode(const DeleteInodeRequest*,
                                              DeleteInodeResponse*));
     MOCK_METHOD2(UpdateInode, MetaStatusCode(const UpdateInodeRequest*,
                                              UpdateInodeResponse*));
+    MOCK_METHOD2(BatchUpdateInode,
+                 MetaStatusCode(const BatchUpdateInodeRequest*,
+                                BatchUpdateInodeResponse*));
+    MOCK_METHOD2(UpdateDirStat,
+                 MetaStatusCode(const UpdateDirStatRequest*,
+                                UpdateDirStatResponse*));
     MOCK_METHOD2(GetOrModifyS3ChunkInfo, MetaStatusCode(
         const GetOrModifyS3ChunkInfoRequest* request,
         GetOrModifyS3ChunkInfoResponse* response));
 
     MOCK_METHOD2(PrepareRenameTx, MetaStatusCode(const PrepareRenameTxRequest*,
                                                  PrepareRenameTxResponse*));
+    MOCK_METHOD3(CreateInodeAndDentry,
+                 MetaStatusCode(const CreateInodeAndDentryRequest*, uint64_t,
+                                CreateInodeAndDentryResponse*));
+    MOCK_METHOD2(UnlinkDentryAndDecNlink,
+                 MetaStatusCode(const UnlinkDentryAndDecNlinkRequest*,
+                                UnlinkDentryAndDecNlinkResponse*));
 };
 
 }  // namespace mock
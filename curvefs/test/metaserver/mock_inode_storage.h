@@ -25,6 +25,7 @@
 
 #include <gmock/gmock.h>
 #include <list>
+#include <memory>
 #include "curvefs/src/metaserver/inode_storage.h"
 
 namespace curvefs {
@@ -39,11 +40,26 @@ class MockInodeStorage : public InodeStorage {
     MOCK_METHOD2(Get, MetaStatusCode(const InodeKey &key,
         std::shared_ptr<Inode> *inode));
     MOCK_METHOD2(GetCopy, MetaStatusCode(const InodeKey &key, Inode *inode));
+    MOCK_METHOD2(GetAttr, MetaStatusCode(const InodeKey &key,
+                                         InodeAttr *attr));
     MOCK_METHOD1(Delete, MetaStatusCode(const InodeKey &key));
     MOCK_METHOD1(Update, MetaStatusCode(const Inode &inode));
     MOCK_METHOD0(Count, int());
-    MOCK_METHOD0(GetContainer, InodeStorage::ContainerType*());
     MOCK_METHOD1(GetInodeIdList, void(std::list<uint64_t> *InodeIdList));
+    MOCK_METHOD1(NewIterator, std::shared_ptr<Iterator>(uint32_t partitionId));
+    MOCK_METHOD3(GetS3ChunkInfoList,
+                 MetaStatusCode(const InodeKey &key, uint64_t chunkIndex,
+                                S3ChunkInfoList *list));
+    MOCK_METHOD3(UpdateS3ChunkInfoList,
+                 MetaStatusCode(const InodeKey &key, uint64_t chunkIndex,
+                                const S3ChunkInfoList &list));
+    MOCK_METHOD4(ListS3ChunkInfo,
+                 MetaStatusCode(const InodeKey &key, uint64_t beginIndex,
+                                uint64_t endIndex, S3ChunkInfoMap *out));
+    MOCK_METHOD1(NewS3ChunkInfoIterator,
+                 std::shared_ptr<Iterator>(uint32_t partitionId));
+    MOCK_METHOD1(TakeChanges, MetaStatusCode(InodeChanges *changes));
+    MOCK_METHOD0(ClearChanges, void());
 };
 
 }  // namespace metaserver
@@ -33,6 +33,8 @@
 #include "curvefs/src/metaserver/s3compact_manager.h"
 #include "src/common/s3_adapter.h"
 
+using ::curve::common::GetObjectAsyncContext;
+using ::curve::common::PutObjectAsyncContext;
 using ::curve::common::S3Adapter;
 using ::testing::Return;
 
@@ -64,6 +66,8 @@ class MockS3Adapter : public S3Adapter {
     MOCK_METHOD0(GetBucketName, std::string());
     MOCK_METHOD2(PutObject, int(const Aws::String&, const std::string&));
     MOCK_METHOD2(GetObject, int(const Aws::String&, std::string*));
+    MOCK_METHOD1(GetObjectAsync, void(std::shared_ptr<GetObjectAsyncContext>));
+    MOCK_METHOD1(PutObjectAsync, void(std::shared_ptr<PutObjectAsyncContext>));
     MOCK_METHOD1(DeleteObject, int(const Aws::String&));
 };
 }  // namespace metaserver
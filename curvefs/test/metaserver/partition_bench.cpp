@@ -0,0 +1,148 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2022-08-01
+ */
+
+// Each thread creates files in its own directory of one partition and
+// stats them, as the apply queue workers do with the inode ids reserved
+// in raft log order. Prints the operations per second with one lock and
+// with lock striping.
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "curvefs/src/metaserver/kv_storage.h"
+#include "curvefs/src/metaserver/partition.h"
+
+DEFINE_int32(files_per_thread, 20000, "Files created by each thread");
+DEFINE_int32(max_threads, 16, "Threads are doubled from 1 up to it");
+DEFINE_int32(stripes, 16, "Lock stripes compared with one lock");
+
+namespace curvefs {
+namespace metaserver {
+
+namespace {
+
+const uint32_t kFsId = 1;
+
+// run `work` by `threads` threads, return the operations per second
+double Run(int threads, const std::function<void(int)>& work) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back(work, t);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return threads * FLAGS_files_per_thread / elapsed.count();
+}
+
+void Bench(uint32_t stripes, int threads) {
+    PartitionInfo partitionInfo;
+    partitionInfo.set_fsid(kFsId);
+    partitionInfo.set_poolid(1);
+    partitionInfo.set_copysetid(1);
+    partitionInfo.set_partitionid(1);
+    partitionInfo.set_start(100);
+    partitionInfo.set_end(UINT64_MAX - 1);
+    Partition partition(partitionInfo);
+
+    std::vector<uint64_t> dirs;
+    std::vector<std::vector<uint64_t>> files(threads);
+    for (int t = 0; t < threads; t++) {
+        Inode dir;
+        CHECK_EQ(MetaStatusCode::OK,
+                 partition.CreateInode(kFsId, 0, 0, 0, 0755,
+                                       FsFileType::TYPE_DIRECTORY, "", 0,
+                                       &dir));
+        dirs.push_back(dir.inodeid());
+        for (int i = 0; i < FLAGS_files_per_thread; i++) {
+            files[t].push_back(partition.GetNewInodeId());
+        }
+    }
+
+    double createOps = Run(threads, [&](int t) {
+        for (int i = 0; i < FLAGS_files_per_thread; i++) {
+            Inode inode;
+            CHECK_EQ(MetaStatusCode::OK,
+                     partition.CreateInode(kFsId, files[t][i], 0, 0, 0, 0644,
+                                           FsFileType::TYPE_FILE, "", 0,
+                                           dirs[t], &inode));
+            Dentry dentry;
+            dentry.set_fsid(kFsId);
+            dentry.set_parentinodeid(dirs[t]);
+            dentry.set_name(std::to_string(i));
+            dentry.set_inodeid(files[t][i]);
+            dentry.set_txid(0);
+            CHECK_EQ(MetaStatusCode::OK, partition.CreateDentry(dentry));
+        }
+    });
+
+    double statOps = Run(threads, [&](int t) {
+        for (int i = 0; i < FLAGS_files_per_thread; i++) {
+            Dentry dentry;
+            dentry.set_fsid(kFsId);
+            dentry.set_parentinodeid(dirs[t]);
+            dentry.set_name(std::to_string(i));
+            dentry.set_txid(0);
+            CHECK_EQ(MetaStatusCode::OK, partition.GetDentry(&dentry));
+            InodeAttr attr;
+            CHECK_EQ(MetaStatusCode::OK,
+                     partition.GetInodeAttr(kFsId, dentry.inodeid(), &attr));
+        }
+    });
+
+    std::cout << "stripes: " << stripes << ", threads: " << threads
+              << ", create: " << static_cast<uint64_t>(createOps)
+              << " ops/s, stat: " << static_cast<uint64_t>(statOps)
+              << " ops/s" << std::endl;
+}
+
+}  // namespace
+
+}  // namespace metaserver
+}  // namespace curvefs
+
+int main(int argc, char** argv) {
+    google::ParseCommandLineFlags(&argc, &argv, false);
+    google::InitGoogleLogging(argv[0]);
+
+    using ::curvefs::metaserver::KVStorageManager;
+    using ::curvefs::metaserver::KVStorageOption;
+    for (uint32_t stripes : {1u, static_cast<uint32_t>(FLAGS_stripes)}) {
+        KVStorageOption option;
+        option.lockStripes = stripes;
+        CHECK_EQ(0, KVStorageManager::GetInstance().Init(option));
+        for (int threads = 1; threads <= FLAGS_max_threads; threads *= 2) {
+            ::curvefs::metaserver::Bench(stripes, threads);
+        }
+    }
+    return 0;
+}
@@ -24,6 +24,11 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
 #include "curvefs/test/metaserver/test_helper.h"
 
 using ::testing::AtLeast;
@@ -330,5 +335,310 @@ TEST_F(PartitionTest, PARTITION_ID_MISSMATCH_ERROR) {
               MetaStatusCode::PARTITION_ID_MISSMATCH);
 }
 
+TEST_F(PartitionTest, CreateInodeAndDentryAndUnlink) {
+    PartitionInfo partitionInfo1;
+    partitionInfo1.set_fsid(1);
+    partitionInfo1.set_poolid(2);
+    partitionInfo1.set_copysetid(3);
+    partitionInfo1.set_partitionid(4);
+    partitionInfo1.set_start(100);
+    partitionInfo1.set_end(199);
+
+    Partition partition1(partitionInfo1);
+
+    uint32_t fsId = 1;
+    Inode parent;
+    ASSERT_EQ(partition1.CreateInode(fsId, 0, 0, 0, 0755,
+                                     FsFileType::TYPE_DIRECTORY, "", 0,
+                                     &parent),
+              MetaStatusCode::OK);
+
+    CreateInodeAndDentryRequest request;
+    request.set_fsid(fsId);
+    request.set_length(0);
+    request.set_uid(0);
+    request.set_gid(0);
+    request.set_mode(0644);
+    request.set_type(FsFileType::TYPE_FILE);
+    request.set_parentinodeid(parent.inodeid());
+    request.set_name("file");
+    request.set_txid(0);
+    request.set_flag(DentryFlag::TYPE_FILE_FLAG);
+
+    // the inode and its dentry are created, and the parent is updated
+    Inode inode;
+    uint64_t inodeId = partition1.GetNewInodeId();
+    ASSERT_EQ(partition1.CreateInodeAndDentry(request, inodeId, &inode),
+              MetaStatusCode::OK);
+    ASSERT_EQ(inode.inodeid(), inodeId);
+    ASSERT_EQ(inode.nlink(), 1);
+    Dentry dentry;
+    dentry.set_fsid(fsId);
+    dentry.set_parentinodeid(parent.inodeid());
+    dentry.set_name("file");
+    dentry.set_txid(0);
+    ASSERT_EQ(partition1.GetDentry(&dentry), MetaStatusCode::OK);
+    ASSERT_EQ(dentry.inodeid(), inodeId);
+    Inode out;
+    ASSERT_EQ(partition1.GetInode(fsId, parent.inodeid(), &out),
+              MetaStatusCode::OK);
+    ASSERT_EQ(out.nlink(), parent.nlink() + 1);
+
+    // nothing is left if the dentry exists
+    uint64_t inodeId2 = partition1.GetNewInodeId();
+    ASSERT_EQ(partition1.CreateInodeAndDentry(request, inodeId2, &inode),
+              MetaStatusCode::DENTRY_EXIST);
+    ASSERT_EQ(partition1.GetInode(fsId, inodeId2, &out),
+              MetaStatusCode::NOT_FOUND);
+    ASSERT_EQ(partition1.GetInodeNum(), 2);
+
+    // or the parent doesn't exist
+    request.set_name("file2");
+    request.set_parentinodeid(199);
+    ASSERT_EQ(partition1.CreateInodeAndDentry(request, inodeId2, &inode),
+              MetaStatusCode::NOT_FOUND);
+    ASSERT_EQ(partition1.GetInodeNum(), 2);
+    ASSERT_EQ(partition1.GetDentryNum(), 1);
+
+    // the parent or the id isn't in this partition
+    request.set_parentinodeid(200);
+    ASSERT_EQ(partition1.CreateInodeAndDentry(request, inodeId2, &inode),
+              MetaStatusCode::PARTITION_ID_MISSMATCH);
+    request.set_parentinodeid(parent.inodeid());
+    ASSERT_EQ(partition1.CreateInodeAndDentry(request, UINT64_MAX, &inode),
+              MetaStatusCode::PARTITION_ALLOC_ID_FAIL);
+
+    // the dentry doesn't point to the inode
+    dentry.set_inodeid(inodeId + 1);
+    ASSERT_EQ(partition1.UnlinkDentryAndDecNlink(dentry),
+              MetaStatusCode::PARAM_ERROR);
+    dentry.set_inodeid(200);
+    ASSERT_EQ(partition1.UnlinkDentryAndDecNlink(dentry),
+              MetaStatusCode::PARTITION_ID_MISSMATCH);
+    ASSERT_EQ(partition1.GetDentryNum(), 1);
+
+    // the dentry is removed, and the nlinks of both are decreased
+    dentry.set_inodeid(inodeId);
+    ASSERT_EQ(partition1.UnlinkDentryAndDecNlink(dentry),
+              MetaStatusCode::OK);
+    ASSERT_EQ(partition1.GetDentryNum(), 0);
+    ASSERT_EQ(partition1.GetInode(fsId, inodeId, &out), MetaStatusCode::OK);
+    ASSERT_EQ(out.nlink(), 0);
+    ASSERT_GT(out.dtime(), 0);
+    ASSERT_EQ(partition1.GetInode(fsId, parent.inodeid(), &out),
+              MetaStatusCode::OK);
+    ASSERT_EQ(out.nlink(), parent.nlink());
+
+    ASSERT_EQ(partition1.UnlinkDentryAndDecNlink(dentry),
+              MetaStatusCode::NOT_FOUND);
+}
+
+TEST_F(PartitionTest, CreateInodeAndDentryRetry) {
+    PartitionInfo partitionInfo1;
+    partitionInfo1.set_fsid(1);
+    partitionInfo1.set_poolid(2);
+    partitionInfo1.set_copysetid(3);
+    partitionInfo1.set_partitionid(4);
+    partitionInfo1.set_start(100);
+    partitionInfo1.set_end(199);
+
+    Partition partition1(partitionInfo1);
+
+    uint32_t fsId = 1;
+    Inode parent;
+    ASSERT_EQ(partition1.CreateInode(fsId, 0, 0, 0, 0755,
+                                     FsFileType::TYPE_DIRECTORY, "", 0,
+                                     &parent),
+              MetaStatusCode::OK);
+
+    CreateInodeAndDentryRequest request;
+    request.set_fsid(fsId);
+    request.set_length(0);
+    request.set_uid(0);
+    request.set_gid(0);
+    request.set_mode(0644);
+    request.set_type(FsFileType::TYPE_FILE);
+    request.set_parentinodeid(parent.inodeid());
+    request.set_name("file");
+    request.set_txid(0);
+    request.set_requestid(1000);
+
+    Inode inode;
+    uint64_t inodeId = partition1.GetNewInodeId();
+    ASSERT_EQ(partition1.CreateInodeAndDentry(request, inodeId, &inode),
+              MetaStatusCode::OK);
+
+    // the retry gets the inode created, nothing else is changed
+    Inode retried;
+    ASSERT_EQ(partition1.CreateInodeAndDentry(
+                  request, partition1.GetNewInodeId(), &retried),
+              MetaStatusCode::OK);
+    ASSERT_EQ(retried.inodeid(), inodeId);
+    ASSERT_EQ(partition1.GetInodeNum(), 2);
+    ASSERT_EQ(partition1.GetDentryNum(), 1);
+    Inode out;
+    ASSERT_EQ(partition1.GetInode(fsId, parent.inodeid(), &out),
+              MetaStatusCode::OK);
+    ASSERT_EQ(out.nlink(), parent.nlink() + 1);
+
+    // other requests on the same name still fail
+    request.set_requestid(1001);
+    ASSERT_EQ(partition1.CreateInodeAndDentry(
+                  request, partition1.GetNewInodeId(), &retried),
+              MetaStatusCode::DENTRY_EXIST);
+    request.clear_requestid();
+    ASSERT_EQ(partition1.CreateInodeAndDentry(
+                  request, partition1.GetNewInodeId(), &retried),
+              MetaStatusCode::DENTRY_EXIST);
+
+    // the dentry is removed after it's created
+    Dentry dentry;
+    dentry.set_fsid(fsId);
+    dentry.set_parentinodeid(parent.inodeid());
+    dentry.set_name("file");
+    dentry.set_txid(0);
+    dentry.set_inodeid(inodeId);
+    ASSERT_EQ(partition1.UnlinkDentryAndDecNlink(dentry),
+              MetaStatusCode::OK);
+    request.set_requestid(1000);
+    uint64_t inodeId2 = partition1.GetNewInodeId();
+    ASSERT_EQ(partition1.CreateInodeAndDentry(request, inodeId2, &retried),
+              MetaStatusCode::OK);
+    ASSERT_EQ(retried.inodeid(), inodeId2);
+}
+
+TEST_F(PartitionTest, UpdateDirStatRetry) {
+    PartitionInfo partitionInfo1;
+    partitionInfo1.set_fsid(1);
+    partitionInfo1.set_poolid(2);
+    partitionInfo1.set_copysetid(3);
+    partitionInfo1.set_partitionid(4);
+    partitionInfo1.set_start(100);
+    partitionInfo1.set_end(199);
+
+    Partition partition1(partitionInfo1);
+
+    uint32_t fsId = 1;
+    Inode dir;
+    ASSERT_EQ(partition1.CreateInode(fsId, 0, 0, 0, 0755,
+                                     FsFileType::TYPE_DIRECTORY, "", 0, &dir),
+              MetaStatusCode::OK);
+
+    UpdateDirStatRequest request;
+    request.set_poolid(2);
+    request.set_copysetid(3);
+    request.set_partitionid(4);
+    request.set_fsid(fsId);
+    request.set_inodeid(dir.inodeid());
+    request.mutable_delta()->set_bytes(100);
+    request.mutable_delta()->set_files(1);
+    request.set_requestid(1000);
+
+    uint64_t parent = 0;
+    DirStat stat;
+    ASSERT_EQ(partition1.UpdateDirStat(request, &parent, &stat),
+              MetaStatusCode::OK);
+    ASSERT_EQ(stat.bytes(), 100);
+    ASSERT_EQ(stat.files(), 1);
+
+    // the retry gets the stats, the delta isn't added again
+    ASSERT_EQ(partition1.UpdateDirStat(request, &parent, &stat),
+              MetaStatusCode::OK);
+    ASSERT_EQ(stat.bytes(), 100);
+    ASSERT_EQ(stat.files(), 1);
+
+    // other deltas are added
+    request.set_requestid(1001);
+    ASSERT_EQ(partition1.UpdateDirStat(request, &parent, &stat),
+              MetaStatusCode::OK);
+    ASSERT_EQ(stat.bytes(), 200);
+    request.clear_requestid();
+    ASSERT_EQ(partition1.UpdateDirStat(request, &parent, &stat),
+              MetaStatusCode::OK);
+    ASSERT_EQ(stat.bytes(), 300);
+    ASSERT_EQ(stat.files(), 3);
+}
+
+// the apply queue workers create and stat files in different directories
+// of one partition concurrently
+TEST_F(PartitionTest, ConcurrentCreateAndStat) {
+    const uint32_t fsId = 1;
+    const int threads = 4;
+    const int filesPerThread = 100;
+
+    PartitionInfo partitionInfo;
+    partitionInfo.set_fsid(fsId);
+    partitionInfo.set_poolid(1);
+    partitionInfo.set_copysetid(1);
+    partitionInfo.set_partitionid(1);
+    partitionInfo.set_start(100);
+    partitionInfo.set_end(UINT64_MAX - 1);
+    Partition partition(partitionInfo);
+
+    std::vector<uint64_t> dirs;
+    std::vector<std::vector<uint64_t>> files(threads);
+    for (int t = 0; t < threads; t++) {
+        Inode dir;
+        ASSERT_EQ(MetaStatusCode::OK,
+                  partition.CreateInode(fsId, 0, 0, 0, 0755,
+                                        FsFileType::TYPE_DIRECTORY, "", 0,
+                                        &dir));
+        dirs.push_back(dir.inodeid());
+        for (int i = 0; i < filesPerThread; i++) {
+            files[t].push_back(partition.GetNewInodeId());
+        }
+    }
+
+    std::atomic<int> failed(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            for (int i = 0; i < filesPerThread; i++) {
+                Inode inode;
+                Dentry dentry;
+                dentry.set_fsid(fsId);
+                dentry.set_parentinodeid(dirs[t]);
+                dentry.set_name(std::to_string(i));
+                dentry.set_inodeid(files[t][i]);
+                dentry.set_txid(0);
+                if (partition.CreateInode(fsId, files[t][i], 0, 0, 0, 0644,
+                                          FsFileType::TYPE_FILE, "", 0,
+                                          dirs[t], &inode) !=
+                        MetaStatusCode::OK ||
+                    partition.CreateDentry(dentry) != MetaStatusCode::OK) {
+                    failed++;
+                    continue;
+                }
+
+                Dentry out;
+                out.set_fsid(fsId);
+                out.set_parentinodeid(dirs[t]);
+                out.set_name(std::to_string(i));
+                out.set_txid(0);
+                InodeAttr attr;
+                if (partition.GetDentry(&out) != MetaStatusCode::OK ||
+                    out.inodeid() != files[t][i] ||
+                    partition.GetInodeAttr(fsId, out.inodeid(), &attr) !=
+                        MetaStatusCode::OK) {
+                    failed++;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    ASSERT_EQ(0, failed.load());
+    ASSERT_EQ(threads * (filesPerThread + 1), partition.GetInodeNum());
+    ASSERT_EQ(threads * filesPerThread, partition.GetDentryNum());
+    for (int t = 0; t < threads; t++) {
+        Inode dir;
+        ASSERT_EQ(MetaStatusCode::OK,
+                  partition.GetInode(fsId, dirs[t], &dir));
+        ASSERT_EQ(2 + filesPerThread, dir.nlink());
+    }
+}
+
 }  // namespace metaserver
 }  // namespace curvefs
@@ -0,0 +1,338 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2022-06-20
+ * Author: chenwei
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "curvefs/src/metaserver/rename_coordinator.h"
+
+namespace curvefs {
+namespace metaserver {
+
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::SaveArg;
+using ::testing::SetArgPointee;
+
+class MockRenameCoordinator : public RenameCoordinator {
+ public:
+    explicit MockRenameCoordinator(const RenameCoordinatorOption& option)
+        : RenameCoordinator(nullptr, option) {}
+
+    MOCK_METHOD2(PrepareLocal, MetaStatusCode(
+        const PrepareRenameTxRequest& request, uint64_t* appliedIndex));
+    MOCK_METHOD2(PrepareRemote, MetaStatusCode(
+        const std::string& leaderAddr, const PrepareRenameTxRequest& request));
+    MOCK_METHOD1(CommitTx, MetaStatusCode(
+        const std::vector<PartitionTxId>& txIds));
+    MOCK_METHOD3(RefreshTxId, bool(uint32_t fsId, uint32_t partitionId,
+                                   uint64_t* txId));
+};
+
+class CountClosure : public google::protobuf::Closure {
+ public:
+    void Run() override { count++; }
+
+    // the renames are done in background
+    void WaitFor(int expected) {
+        for (int i = 0; i < 500 && count.load() < expected; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        ASSERT_EQ(count.load(), expected);
+    }
+
+    std::atomic<int> count{0};
+};
+
+class RenameCoordinatorTest : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        coordinator_ = std::make_shared<MockRenameCoordinator>(option_);
+    }
+
+    Dentry GenDentry(uint64_t parentId, const std::string& name,
+                     uint64_t txId) {
+        Dentry dentry;
+        dentry.set_fsid(1);
+        dentry.set_parentinodeid(parentId);
+        dentry.set_name(name);
+        dentry.set_inodeid(100);
+        dentry.set_txid(txId);
+        return dentry;
+    }
+
+    RenameRequest GenRequest(uint32_t partitionId, uint32_t dstPartitionId,
+                             const Dentry& dentry, const Dentry& newDentry) {
+        RenameRequest request;
+        request.set_poolid(1);
+        request.set_copysetid(partitionId);
+        request.set_partitionid(partitionId);
+        *request.mutable_dentry() = dentry;
+        *request.mutable_newdentry() = newDentry;
+        request.set_dstpoolid(1);
+        request.set_dstcopysetid(dstPartitionId);
+        request.set_dstpartitionid(dstPartitionId);
+        request.set_dstleaderaddr("127.0.0.1:6701");
+        return request;
+    }
+
+ protected:
+    RenameCoordinatorOption option_;
+    std::shared_ptr<MockRenameCoordinator> coordinator_;
+};
+
+TEST_F(RenameCoordinatorTest, RenameInSamePartition) {
+    auto request = GenRequest(1, 1, GenDentry(10, "A", 3),
+                              GenDentry(10, "B", 3));
+    RenameResponse response;
+    CountClosure done;
+
+    PrepareRenameTxRequest prepareRequest;
+    std::vector<PartitionTxId> txIds;
+    EXPECT_CALL(*coordinator_, PrepareLocal(_, _))
+        .WillOnce(DoAll(SaveArg<0>(&prepareRequest),
+                        Return(MetaStatusCode::OK)));
+    EXPECT_CALL(*coordinator_, PrepareRemote(_, _))
+        .Times(0);
+    EXPECT_CALL(*coordinator_, CommitTx(_))
+        .WillOnce(DoAll(SaveArg<0>(&txIds), Return(MetaStatusCode::OK)));
+
+    coordinator_->Rename(&request, &response, &done);
+    done.WaitFor(1);
+    ASSERT_EQ(response.statuscode(), MetaStatusCode::OK);
+    ASSERT_EQ(response.txid(), 4);
+    ASSERT_EQ(response.dsttxid(), 4);
+
+    ASSERT_EQ(prepareRequest.partitionid(), 1);
+    ASSERT_EQ(prepareRequest.dentrys_size(), 2);
+    ASSERT_EQ(prepareRequest.dentrys(0).name(), "A");
+    ASSERT_EQ(prepareRequest.dentrys(0).txid(), 4);
+    ASSERT_EQ(prepareRequest.dentrys(0).flag(),
+              DentryFlag::DELETE_MARK_FLAG |
+              DentryFlag::TRANSACTION_PREPARE_FLAG);
+    ASSERT_EQ(prepareRequest.dentrys(1).name(), "B");
+    ASSERT_EQ(prepareRequest.dentrys(1).txid(), 4);
+    ASSERT_EQ(prepareRequest.dentrys(1).flag(),
+              DentryFlag::TRANSACTION_PREPARE_FLAG);
+
+    ASSERT_EQ(txIds.size(), 1);
+    ASSERT_EQ(txIds[0].partitionid(), 1);
+    ASSERT_EQ(txIds[0].txid(), 4);
+}
+
+TEST_F(RenameCoordinatorTest, RenameBetweenPartitions) {
+    // CASE 1: rename success
+    auto request = GenRequest(1, 2, GenDentry(10, "A", 3),
+                              GenDentry(20, "B", 7));
+    RenameResponse response;
+    CountClosure done;
+
+    PrepareRenameTxRequest localRequest, remoteRequest;
+    std::string leaderAddr;
+    std::vector<PartitionTxId> txIds;
+    EXPECT_CALL(*coordinator_, PrepareLocal(_, _))
+        .WillOnce(DoAll(SaveArg<0>(&localRequest),
+                        Return(MetaStatusCode::OK)));
+    EXPECT_CALL(*coordinator_, PrepareRemote(_, _))
+        .WillOnce(DoAll(SaveArg<0>(&leaderAddr), SaveArg<1>(&remoteRequest),
+                        Return(MetaStatusCode::OK)));
+    EXPECT_CALL(*coordinator_, CommitTx(_))
+        .WillOnce(DoAll(SaveArg<0>(&txIds), Return(MetaStatusCode::OK)));
+
+    coordinator_->Rename(&request, &response, &done);
+    done.WaitFor(1);
+    ASSERT_EQ(response.statuscode(), MetaStatusCode::OK);
+    ASSERT_EQ(response.txid(), 4);
+    ASSERT_EQ(response.dsttxid(), 8);
+
+    ASSERT_EQ(localRequest.partitionid(), 1);
+    ASSERT_EQ(localRequest.dentrys_size(), 1);
+    ASSERT_EQ(localRequest.dentrys(0).txid(), 4);
+    ASSERT_EQ(leaderAddr, "127.0.0.1:6701");
+    ASSERT_EQ(remoteRequest.partitionid(), 2);
+    ASSERT_EQ(remoteRequest.dentrys_size(), 1);
+    ASSERT_EQ(remoteRequest.dentrys(0).txid(), 8);
+    ASSERT_EQ(txIds.size(), 2);
+
+    // CASE 2: prepare on destination fail, the client falls back
+    request = GenRequest(1, 2, GenDentry(10, "C", 3),
+                         GenDentry(20, "D", 7));
+    response.Clear();
+    EXPECT_CALL(*coordinator_, PrepareLocal(_, _))
+        .WillOnce(Return(MetaStatusCode::OK));
+    EXPECT_CALL(*coordinator_, PrepareRemote(_, _))
+        .WillOnce(Return(MetaStatusCode::REDIRECTED));
+    EXPECT_CALL(*coordinator_, CommitTx(_))
+        .Times(0);
+
+    coordinator_->Rename(&request, &response, &done);
+    done.WaitFor(2);
+    ASSERT_EQ(response.statuscode(), MetaStatusCode::RPC_ERROR);
+
+    // CASE 3: the txids known by the client are stale, the ones committed
+    //         by the coordinator are used, and the failed one is reused
+    response.Clear();
+    EXPECT_CALL(*coordinator_, PrepareLocal(_, _))
+        .WillOnce(DoAll(SaveArg<0>(&localRequest),
+                        Return(MetaStatusCode::OK)));
+    EXPECT_CALL(*coordinator_, PrepareRemote(_, _))
+        .WillOnce(DoAll(SaveArg<1>(&remoteRequest),
+                        Return(MetaStatusCode::OK)));
+    EXPECT_CALL(*coordinator_, CommitTx(_))
+        .WillOnce(Return(MetaStatusCode::OK));
+
+    coordinator_->Rename(&request, &response, &done);
+    done.WaitFor(3);
+    ASSERT_EQ(response.statuscode(), MetaStatusCode::OK);
+    ASSERT_EQ(response.txid(), 5);
+    ASSERT_EQ(response.dsttxid(), 9);
+    ASSERT_EQ(localRequest.dentrys(0).txid(), 5);
+    ASSERT_EQ(remoteRequest.dentrys(0).txid(), 9);
+}
+
+TEST_F(RenameCoordinatorTest, RenameInBatch) {
+    std::vector<RenameRequest> requests{
+        GenRequest(1, 2, GenDentry(10, "A", 3), GenDentry(20, "A", 7)),
+        GenRequest(1, 2, GenDentry(10, "B", 3), GenDentry(20, "B", 7)),
+        GenRequest(1, 2, GenDentry(10, "C", 3), GenDentry(20, "C", 7)),
+        // conflict with the second one
+        GenRequest(1, 2, GenDentry(10, "D", 3), GenDentry(20, "B", 7)),
+    };
+    std::vector<RenameResponse> responses(requests.size());
+    CountClosure done;
+
+    std::promise<void> entered, release;
+    auto releaseFuture = release.get_future().share();
+    std::vector<int> batchSizes;
+    EXPECT_CALL(*coordinator_, PrepareLocal(_, _))
+        .WillOnce(Invoke([&](const PrepareRenameTxRequest& request,
+                             uint64_t* appliedIndex) {
+            batchSizes.push_back(request.dentrys_size());
+            entered.set_value();
+            releaseFuture.wait();
+            return MetaStatusCode::OK;
+        }))
+        .WillRepeatedly(Invoke([&](const PrepareRenameTxRequest& request,
+                                   uint64_t* appliedIndex) {
+            batchSizes.push_back(request.dentrys_size());
+            return MetaStatusCode::OK;
+        }));
+    EXPECT_CALL(*coordinator_, PrepareRemote(_, _))
+        .WillRepeatedly(Return(MetaStatusCode::OK));
+    EXPECT_CALL(*coordinator_, CommitTx(_))
+        .Times(3)
+        .WillRepeatedly(Return(MetaStatusCode::OK));
+
+    coordinator_->Rename(&requests[0], &responses[0], &done);
+    entered.get_future().wait();
+
+    // the partitions are busy, the renames are queued
+    for (size_t i = 1; i < requests.size(); i++) {
+        coordinator_->Rename(&requests[i], &responses[i], &done);
+    }
+    ASSERT_EQ(done.count, 0);
+
+    release.set_value();
+    done.WaitFor(4);
+    ASSERT_EQ(batchSizes, std::vector<int>({1, 2, 1}));
+
+    ASSERT_EQ(responses[0].txid(), 4);
+    ASSERT_EQ(responses[1].txid(), 5);
+    ASSERT_EQ(responses[2].txid(), 5);
+    ASSERT_EQ(responses[3].txid(), 6);
+    ASSERT_EQ(responses[3].dsttxid(), 10);
+    for (const auto& response : responses) {
+        ASSERT_EQ(response.statuscode(), MetaStatusCode::OK);
+    }
+}
+
+TEST_F(RenameCoordinatorTest, CommitUnknown) {
+    auto request = GenRequest(1, 2, GenDentry(10, "A", 3),
+                              GenDentry(20, "B", 7));
+    RenameResponse response;
+    CountClosure done;
+
+    // CASE 1: commit to mds fail, the client falls back
+    EXPECT_CALL(*coordinator_, PrepareLocal(_, _))
+        .WillRepeatedly(Return(MetaStatusCode::OK));
+    EXPECT_CALL(*coordinator_, PrepareRemote(_, _))
+        .WillRepeatedly(Return(MetaStatusCode::OK));
+    EXPECT_CALL(*coordinator_, CommitTx(_))
+        .WillOnce(Return(MetaStatusCode::RPC_ERROR));
+
+    coordinator_->Rename(&request, &response, &done);
+    done.WaitFor(1);
+    ASSERT_EQ(response.statuscode(), MetaStatusCode::RPC_ERROR);
+    ASSERT_FALSE(response.has_txid());
+
+    // CASE 2: commit unknown, the txids tried are returned
+    response.Clear();
+    EXPECT_CALL(*coordinator_, CommitTx(_))
+        .WillOnce(Return(MetaStatusCode::TX_COMMIT_UNKNOWN));
+
+    coordinator_->Rename(&request, &response, &done);
+    done.WaitFor(2);
+    ASSERT_EQ(response.statuscode(), MetaStatusCode::TX_COMMIT_UNKNOWN);
+    ASSERT_EQ(response.txid(), 4);
+    ASSERT_EQ(response.dsttxid(), 8);
+
+    // CASE 3: the txids are got from mds before the next transaction,
+    //         fail to get them
+    response.Clear();
+    EXPECT_CALL(*coordinator_, RefreshTxId(1, 1, _))
+        .WillOnce(Return(false));
+    EXPECT_CALL(*coordinator_, CommitTx(_))
+        .Times(0);
+
+    coordinator_->Rename(&request, &response, &done);
+    done.WaitFor(3);
+    ASSERT_EQ(response.statuscode(), MetaStatusCode::TX_COMMIT_UNKNOWN);
+    ASSERT_FALSE(response.has_txid());
+
+    // CASE 4: the transaction was committed by mds, the next one goes on
+    //         with the txids on mds rather than the stale ones of client
+    response.Clear();
+    EXPECT_CALL(*coordinator_, RefreshTxId(1, 1, _))
+        .WillOnce(DoAll(SetArgPointee<2>(4), Return(true)));
+    EXPECT_CALL(*coordinator_, RefreshTxId(1, 2, _))
+        .WillOnce(DoAll(SetArgPointee<2>(8), Return(true)));
+    EXPECT_CALL(*coordinator_, CommitTx(_))
+        .WillOnce(Return(MetaStatusCode::OK));
+
+    coordinator_->Rename(&request, &response, &done);
+    done.WaitFor(4);
+    ASSERT_EQ(response.statuscode(), MetaStatusCode::OK);
+    ASSERT_EQ(response.txid(), 5);
+    ASSERT_EQ(response.dsttxid(), 9);
+}
+
+}  // namespace metaserver
+}  // namespace curvefs
@@ -23,6 +23,10 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <cstring>
+#include <map>
+#include <string>
+
 #include "curvefs/src/metaserver/s3compact_manager.h"
 #include "curvefs/src/metaserver/s3compact_wq_impl.h"
 #include "curvefs/test/metaserver/mock_s3_adapter.h"
@@ -51,6 +55,10 @@ class S3CompactWorkQueueImplTest : public ::testing::Test {
         opts_.maxChunksPerCompact = 10;
         opts_.s3ReadMaxRetry = 2;
         opts_.s3ReadRetryInterval = 1;
+        opts_.overlapRatioThreshold = 0.5;
+        opts_.s3Concurrency = 2;
+        opts_.s3IopsLimit = 0;
+        opts_.s3BpsLimitMB = 0;
         uint64_t s3adapterSize = 10;
         S3AdapterOption opts;
         s3adapterManager_ =
@@ -408,78 +416,132 @@ TEST_F(S3CompactWorkQueueImplTest, test_BuildValidList) {
     ASSERT_EQ(next->end, 2);
 }
 
-TEST_F(S3CompactWorkQueueImplTest, test_ReadFullChunk) {
-    int ret;
-    std::list<struct S3CompactWorkQueueImpl::Node> validList;
-    struct S3CompactWorkQueueImpl::S3CompactCtx ctx {
-        1, 1, PartitionInfo(), 4, 64, 0, s3adapter_.get()
-    };
-    struct S3CompactWorkQueueImpl::S3NewChunkInfo newChunkInfo;
-    std::string fullChunk;
-
-    auto reset = [&]() {
-        validList.clear();
-        fullChunk.clear();
-        newChunkInfo = {};
+TEST_F(S3CompactWorkQueueImplTest, test_PlanCompaction) {
+    auto add = [](S3ChunkInfoList* l, uint64_t chunkid, uint64_t off,
+                  uint64_t len) {
+        auto ref = l->add_s3chunks();
+        ref->set_chunkid(chunkid);
+        ref->set_compaction(0);
+        ref->set_offset(off);
+        ref->set_len(len);
+        ref->set_size(len);
+        ref->set_zero(false);
     };
 
-    EXPECT_CALL(*s3adapter_, DeleteObject(_)).WillRepeatedly(Return(0));
-    auto mock_getobj = [&](const Aws::String& key, std::string* data) {
-        data->clear();
-        data->append(ctx.blockSize, '\0');
-        return 0;
-    };
-    EXPECT_CALL(*s3adapter_, GetObject(_, _))
-        .WillRepeatedly(testing::Invoke(mock_getobj));
+    // no overlap, merge all
+    S3ChunkInfoList l;
+    for (int i = 0; i < 16; i++) add(&l, i, i * 4, 4);
+    ASSERT_EQ(impl_->PlanCompaction(l).s3chunks_size(), 16);
+
+    // [8, 12) is overwritten repeatedly, only merge the overwritten ones
+    for (int i = 16; i < 24; i++) add(&l, i, 8, 4);
+    auto toMerge = impl_->PlanCompaction(l);
+    ASSERT_EQ(toMerge.s3chunks_size(), 9);
+    ASSERT_EQ(toMerge.s3chunks(0).chunkid(), 2);
+    for (int i = 1; i < 9; i++) {
+        ASSERT_EQ(toMerge.s3chunks(i).chunkid(), i + 15);
+    }
 
-    validList.emplace_back(0, 1, 0, 0, 0, 0, true);
-    ret = impl_->ReadFullChunk(ctx, validList, &fullChunk, &newChunkInfo);
-    ASSERT_EQ(ret, 0);
-    ASSERT_EQ(newChunkInfo.newChunkId, 0);
-    ASSERT_EQ(newChunkInfo.newCompaction, 1);
+    // the objs of chunk 23 are shared with fragment outside, merge all
+    auto shared(l);
+    add(&shared, 23, 64, 4);
+    ASSERT_EQ(impl_->PlanCompaction(shared).s3chunks_size(), 25);
 
-    reset();
-    validList.emplace_back(0, 0, 1, 1, 0, 1, false);
-    validList.emplace_back(1, 10, 0, 0, 1, 11, false);
-    validList.emplace_back(13, 13, 2, 0, 13, 14, false);
-    ret = impl_->ReadFullChunk(ctx, validList, &fullChunk, &newChunkInfo);
-    ASSERT_EQ(ret, 0);
-    ASSERT_EQ(newChunkInfo.newChunkId, 2);
-    ASSERT_EQ(newChunkInfo.newCompaction, 1);
-    ASSERT_EQ(fullChunk.size(), 14);
+    // still too many fragments after merging, merge all
+    auto fragmented(l);
+    for (int i = 24; i < 30; i++) add(&fragmented, i, i * 4, 4);
+    ASSERT_EQ(impl_->PlanCompaction(fragmented).s3chunks_size(), 30);
 
-    reset();
-    EXPECT_CALL(*s3adapter_, GetObject(_, _)).WillRepeatedly(Return(-1));
-    validList.emplace_back(0, 1, 1, 1, 0, 0, false);
-    ret = impl_->ReadFullChunk(ctx, validList, &fullChunk, &newChunkInfo);
-    ASSERT_EQ(ret, -1);
+    // overlap ratio is too low, merge all
+    l.Clear();
+    add(&l, 0, 0, 8);
+    add(&l, 1, 4, 8);
+    ASSERT_EQ(impl_->PlanCompaction(l).s3chunks_size(), 2);
 }
 
-TEST_F(S3CompactWorkQueueImplTest, test_WriteFullChunk) {
+TEST_F(S3CompactWorkQueueImplTest, test_CopyChunk) {
     struct S3CompactWorkQueueImpl::S3CompactCtx ctx {
-        100, 1, PartitionInfo(), 4, 16, 0, s3adapter_.get()
+        100, 1, PartitionInfo(), 4, 64, 0, s3adapter_.get()
+    };
+    std::list<struct S3CompactWorkQueueImpl::Node> validList;
+    validList.emplace_back(0, 5, 1, 0, 0, 6, false);
+    validList.emplace_back(8, 9, 2, 0, 8, 2, false);
+    validList.emplace_back(10, 12, 3, 0, 10, 3, true);
+    std::vector<struct S3CompactWorkQueueImpl::S3Request> reqs;
+    struct S3CompactWorkQueueImpl::S3NewChunkInfo newChunkInfo;
+    impl_->GenS3ReadRequests(ctx, validList, &reqs, &newChunkInfo);
+    ASSERT_EQ(newChunkInfo.newChunkId, 2);
+    ASSERT_EQ(newChunkInfo.newOff, 0);
+    ASSERT_EQ(newChunkInfo.newCompaction, 1);
+
+    // the data read is filled with the chunkid of obj
+    uint64_t reads = 0;
+    auto mock_getobj = [&](std::shared_ptr<GetObjectAsyncContext> context) {
+        reads++;
+        char c = context->key[context->key.find('_', 2) + 1];
+        memset(context->buf, c, context->len);
+        context->retCode = 0;
+        context->cb(s3adapter_.get(), context);
     };
-    struct S3CompactWorkQueueImpl::S3NewChunkInfo newChunkInfo {
-        2, 0, 3
+    std::map<std::string, std::string> objs;
+    auto mock_putobj = [&](std::shared_ptr<PutObjectAsyncContext> context) {
+        objs[context->key] =
+            std::string(context->buffer, context->bufferSize);
+        context->retCode = 0;
+        context->cb(context);
     };
-    EXPECT_CALL(*s3adapter_, PutObject(_, _)).WillRepeatedly(Return(0));
-    std::string fullChunk(10, '0');
+    EXPECT_CALL(*s3adapter_, GetObjectAsync(_))
+        .WillRepeatedly(testing::Invoke(mock_getobj));
+    EXPECT_CALL(*s3adapter_, PutObjectAsync(_))
+        .WillRepeatedly(testing::Invoke(mock_putobj));
+
+    uint64_t len = 0;
     std::vector<std::string> objsAdded;
-    int ret = impl_->WriteFullChunk(ctx, newChunkInfo, fullChunk, &objsAdded);
+    int ret = impl_->CopyChunk(ctx, newChunkInfo, reqs, &len, &objsAdded);
     ASSERT_EQ(ret, 0);
-    ASSERT_EQ(objsAdded[0], "1_100_2_0_3");
-    ASSERT_EQ(objsAdded[1], "1_100_2_1_3");
-    ASSERT_EQ(objsAdded[2], "1_100_2_2_3");
-
-    EXPECT_CALL(*s3adapter_, PutObject(_, _)).WillRepeatedly(Return(-1));
-    ret = impl_->WriteFullChunk(ctx, newChunkInfo, fullChunk, &objsAdded);
+    ASSERT_EQ(len, 13);
+    ASSERT_EQ(reads, 3);
+    ASSERT_EQ(objsAdded.size(), 4);
+    ASSERT_EQ(objs["1_100_2_0_1"], "1111");
+    ASSERT_EQ(objs["1_100_2_1_1"], std::string("11\0\0", 4));
+    ASSERT_EQ(objs["1_100_2_2_1"], std::string("22\0\0", 4));
+    ASSERT_EQ(objs["1_100_2_3_1"], std::string(1, '\0'));
+
+    // write fail, the objs written are returned
+    objsAdded.clear();
+    auto mock_putobj_fail =
+        [&](std::shared_ptr<PutObjectAsyncContext> context) {
+            context->retCode = context->key == "1_100_2_2_1" ? -1 : 0;
+            context->cb(context);
+        };
+    EXPECT_CALL(*s3adapter_, PutObjectAsync(_))
+        .WillRepeatedly(testing::Invoke(mock_putobj_fail));
+    ret = impl_->CopyChunk(ctx, newChunkInfo, reqs, &len, &objsAdded);
     ASSERT_EQ(ret, -1);
+    ASSERT_EQ(objsAdded.size(), 3);
+
+    // read fail after retry
+    objsAdded.clear();
+    reads = 0;
+    auto mock_getobj_fail =
+        [&](std::shared_ptr<GetObjectAsyncContext> context) {
+            reads++;
+            context->retCode = -1;
+            context->cb(s3adapter_.get(), context);
+        };
+    EXPECT_CALL(*s3adapter_, GetObjectAsync(_))
+        .WillRepeatedly(testing::Invoke(mock_getobj_fail));
+    ret = impl_->CopyChunk(ctx, newChunkInfo, reqs, &len, &objsAdded);
+    ASSERT_EQ(ret, -1);
+    ASSERT_EQ(reads, 2 * (opts_.s3ReadMaxRetry + 1));
+    ASSERT_TRUE(objsAdded.empty());
 }
 
 TEST_F(S3CompactWorkQueueImplTest, test_CompactChunks) {
     uint64_t blockSize = 4;
     uint64_t chunkSize = 64;
     Inode tmp;
+    ::google::protobuf::Map<uint64_t, S3ChunkInfoList> tmpRemove;
     auto mock_updateinode =
         [&](CopysetNode* copysetNode, const PartitionInfo& pinfo,
             uint64_t inode,
@@ -487,18 +549,24 @@ TEST_F(S3CompactWorkQueueImplTest, test_CompactChunks) {
             ::google::protobuf::Map<uint64_t, S3ChunkInfoList>
                 s3ChunkInfoRemove) {
             *tmp.mutable_s3chunkinfomap() = s3ChunkInfoAdd;
+            tmpRemove = s3ChunkInfoRemove;
             return MetaStatusCode::OK;
         };
     EXPECT_CALL(*mockImpl_, UpdateInode_rvr(_, _, _, _, _))
         .WillRepeatedly(testing::Invoke(mock_updateinode));
-    EXPECT_CALL(*s3adapter_, PutObject(_, _)).WillRepeatedly(Return(0));
+    auto mock_putobj = [&](std::shared_ptr<PutObjectAsyncContext> context) {
+        context->retCode = 0;
+        context->cb(context);
+    };
+    EXPECT_CALL(*s3adapter_, PutObjectAsync(_))
+        .WillRepeatedly(testing::Invoke(mock_putobj));
     EXPECT_CALL(*s3adapter_, DeleteObject(_)).WillRepeatedly(Return(0));
-    auto mock_getobj = [&](const Aws::String& key, std::string* data) {
-        data->clear();
-        data->append(blockSize, '\0');
-        return 0;
+    auto mock_getobj = [&](std::shared_ptr<GetObjectAsyncContext> context) {
+        memset(context->buf, 0, context->len);
+        context->retCode = 0;
+        context->cb(s3adapter_.get(), context);
     };
-    EXPECT_CALL(*s3adapter_, GetObject(_, _))
+    EXPECT_CALL(*s3adapter_, GetObjectAsync(_))
         .WillRepeatedly(testing::Invoke(mock_getobj));
 
     EXPECT_CALL(*mockCopysetNodeWrapper_, IsLeaderTerm())
@@ -574,19 +642,21 @@ TEST_F(S3CompactWorkQueueImplTest, test_CompactChunks) {
         ref->set_size(5);
         ref->set_zero(false);
     }
-    (*inode1.mutable_s3chunkinfomap())[0] = l0;
-    ASSERT_EQ(inodeStorage_->Update(inode1), MetaStatusCode::OK);
+    ASSERT_EQ(inodeStorage_->UpdateS3ChunkInfoList(InodeKey(inode1), 0, l0),
+              MetaStatusCode::OK);
     mockImpl_->CompactChunks(t);
     ASSERT_EQ(tmp.s3chunkinfomap().size(), 1);
     const auto& l = tmp.s3chunkinfomap().at(0);
     ASSERT_EQ(l.s3chunks_size(), 1);
+    // only the fragments overlapping [16, 28) are merged
     const auto& s3chunkinfo = l.s3chunks(0);
     ASSERT_EQ(s3chunkinfo.chunkid(), 21);
     ASSERT_EQ(s3chunkinfo.compaction(), 1);
-    ASSERT_EQ(s3chunkinfo.offset(), 0);
-    ASSERT_EQ(s3chunkinfo.len(), 60);
-    ASSERT_EQ(s3chunkinfo.size(), 60);
+    ASSERT_EQ(s3chunkinfo.offset(), 16);
+    ASSERT_EQ(s3chunkinfo.len(), 12);
+    ASSERT_EQ(s3chunkinfo.size(), 12);
     ASSERT_EQ(s3chunkinfo.zero(), false);
+    ASSERT_EQ(tmpRemove.at(0).s3chunks_size(), 9);
     // inode nlink = 0, deleted
     inode1.set_nlink(0);
     ASSERT_EQ(inodeStorage_->Update(inode1), MetaStatusCode::OK);
@@ -24,8 +24,10 @@
 #include <glog/logging.h>
 #include <google/protobuf/util/message_differencer.h>
 
+#include <atomic>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "curvefs/proto/metaserver.pb.h"
 #include "curvefs/src/common/process.h"
@@ -288,6 +290,72 @@ TEST_F(StorageTest, Storage) {
     ASSERT_TRUE(match);
 }
 
+TEST_F(StorageTest, LoadInParallel) {
+    // step1: generate partitions and their inodes, the inodes of each
+    //        partition are saved in more than one block
+    const uint32_t nPartitions = 4;
+    const uint64_t nInodes = 200000;
+    auto partitions = std::make_shared<std::vector<PartitionInfo>>();
+    std::vector<std::shared_ptr<Iterator>> children;
+    for (uint32_t i = 0; i < nPartitions; i++) {
+        PartitionInfo info;
+        info.set_fsid(1);
+        info.set_poolid(1);
+        info.set_copysetid(1);
+        info.set_partitionid(i);
+        info.set_start(0);
+        info.set_end(UINT64_MAX);
+        info.set_txid(0);
+        info.set_status(common::PartitionStatus::READWRITE);
+        partitions->push_back(info);
+    }
+    children.push_back(
+        std::make_shared<SetContainerIterator<std::vector<PartitionInfo>>>(
+            ENTRY_TYPE::PARTITION, 0, partitions));
+    for (uint32_t i = 0; i < nPartitions; i++) {
+        auto inodes = std::make_shared<std::vector<Inode>>();
+        for (uint64_t ino = 1; ino <= nInodes; ino++) {
+            auto inode = GenInode();
+            inode.set_inodeid(ino);
+            inodes->push_back(inode);
+        }
+        children.push_back(
+            std::make_shared<SetContainerIterator<std::vector<Inode>>>(
+                ENTRY_TYPE::INODE, i, inodes));
+    }
+    auto miter = std::make_shared<MergeIterator>(children);
+
+    // step2: save to file
+    ASSERT_TRUE(SaveToFile(pathname_, miter, false));
+
+    // step3: load from file, the partitions are loaded before inodes,
+    //        and the inodes of each partition are loaded in order
+    std::atomic<uint32_t> npartition(0);
+    std::vector<uint64_t> lastInode(nPartitions, 0);
+    auto callback = [&](ENTRY_TYPE type, uint32_t partitionId, void* entry) {
+        if (type == ENTRY_TYPE::PARTITION) {
+            npartition++;
+            return true;
+        } else if (type != ENTRY_TYPE::INODE ||
+                   npartition != nPartitions ||
+                   partitionId >= nPartitions) {
+            return false;
+        }
+
+        auto inode = reinterpret_cast<Inode*>(entry);
+        if (inode->inodeid() != lastInode[partitionId] + 1) {
+            return false;
+        }
+        lastInode[partitionId] = inode->inodeid();
+        return true;
+    };
+    ASSERT_TRUE(LoadFromFile(pathname_, callback, 4));
+    ASSERT_EQ(npartition, nPartitions);
+    for (uint32_t i = 0; i < nPartitions; i++) {
+        ASSERT_EQ(lastInode[i], nInodes);
+    }
+}
+
 };  // namespace metaserver
 };  // namespace curvefs
 
@@ -88,12 +88,12 @@ TEST_F(TransactionTest, PreCheck) {
     auto rc = txManager_->HandleRenameTx(dentrys);
     ASSERT_EQ(rc, MetaStatusCode::PARAM_ERROR);
 
-    // CASE 2: sizeof(dentrys) > 2
+    // CASE 2: dentrys are duplicate
     dentrys = std::vector<Dentry>{
         // { fsId, parentId, name, txId, inodeId, flag }
         GenDentry(1, 0, "A", 0, 1, 0),
         GenDentry(1, 0, "B", 0, 2, 0),
-        GenDentry(1, 0, "C", 0, 3, 0),
+        GenDentry(1, 0, "A", 0, 3, 0),
     };
     rc = txManager_->HandleRenameTx(dentrys);
     ASSERT_EQ(rc, MetaStatusCode::PARAM_ERROR);
@@ -172,6 +172,46 @@ TEST_F(TransactionTest, HandleTxWithCommit) {
     ASSERT_EQ(dentryStorage_->Size(), 2);
 }
 
+TEST_F(TransactionTest, HandleTxWithBatch) {
+    InsertDentrys(dentryStorage_, std::vector<Dentry>{
+        // { fsId, parentId, name, txId, inodeId, flag }
+        GenDentry(1, 0, "A", 0, 1, 0),
+        GenDentry(1, 0, "C", 0, 2, 0),
+    });
+
+    // step-1: prepare tx success (rename A B, rename C D)
+    auto dentrys = std::vector<Dentry> {
+        // { fsId, parentId, name, txId, inodeId, flag }
+        GenDentry(1, 0, "A", 1, 1, DELETE),
+        GenDentry(1, 0, "B", 1, 1, 0),
+        GenDentry(1, 0, "C", 1, 2, DELETE),
+        GenDentry(1, 0, "D", 1, 2, 0),
+    };
+    auto rc = txManager_->HandleRenameTx(dentrys);
+    ASSERT_EQ(rc, MetaStatusCode::OK);
+    ASSERT_EQ(dentryStorage_->Size(), 6);
+
+    // step-2: prepare a new tx success with commit
+    dentrys = std::vector<Dentry> {
+        // { fsId, parentId, name, txId, inodeId, flag }
+        GenDentry(1, 0, "E", 2, 3, 0),
+    };
+    rc = txManager_->HandleRenameTx(dentrys);
+    ASSERT_EQ(rc, MetaStatusCode::OK);
+
+    // step-3: check dentrys
+    dentrys.clear();
+    auto dentry = GenDentry(1, 0, "", 2, 0, 0);
+    rc = dentryManager_->ListDentry(dentry, &dentrys, 0);
+    ASSERT_EQ(rc, MetaStatusCode::OK);
+    ASSERT_DENTRYS_EQ(dentrys, std::vector<Dentry>{
+        GenDentry(1, 0, "B", 1, 1, 0),
+        GenDentry(1, 0, "D", 1, 2, 0),
+        GenDentry(1, 0, "E", 2, 3, 0),
+    });
+    ASSERT_EQ(dentryStorage_->Size(), 3);
+}
+
 TEST_F(TransactionTest, HandleTxWithRollback) {
     InsertDentrys(dentryStorage_, std::vector<Dentry>{
         // { fsId, parentId, name, txId, inodeId, flag }
@@ -50,11 +50,17 @@
 #include <libnl3/netlink/genl/mngt.h>
 #include <string>
 #include <memory>
+#include <vector>
 
 #include "nbd/src/nbd-netlink.h"
 #include "nbd/src/define.h"
 #include "nbd/src/util.h"
 
+// 较老的内核头文件中没有定义
+#ifndef NBD_FLAG_CAN_MULTI_CONN
+#define NBD_FLAG_CAN_MULTI_CONN (1 << 8)
+#endif
+
 namespace curve {
 namespace nbd {
 
@@ -69,12 +75,13 @@ class NBDController {
     /**
      * @brief: 安装NBD设备，并初始化设备属性
      * @param config: 启动NBD设备相关的配置参数
-     * @param sockfd: socketpair其中一端的fd，传给NBD设备用于跟NBDServer间的数据传输
+     * @param sockfds: 每个socketpair其中一端的fd，传给NBD设备用于跟NBDServer间的数据传输
+     *                 ioctl方式只支持一个连接
      * @param size: 设置NBD设备的大小
      * @param flags: 设置加载NBD设备的flags
      * @return: 成功返回0，失败返回负值
      */
-    virtual int SetUp(NBDConfig* config, int sockfd,
+    virtual int SetUp(NBDConfig* config, const std::vector<int>& sockfds,
                       uint64_t size, uint64_t flags) = 0;
     /**
      * @brief: 根据设备名来卸载已经映射的NBD设备
@@ -141,7 +148,7 @@ class IOController : public NBDController {
     IOController() {}
     ~IOController() {}
 
-    int SetUp(NBDConfig* config, int sockfd,
+    int SetUp(NBDConfig* config, const std::vector<int>& sockfds,
               uint64_t size, uint64_t flags) override;
     int DisconnectByPath(const std::string& devpath) override;
     int Resize(uint64_t size) override;
@@ -158,7 +165,7 @@ class NetLinkController : public NBDController {
     NetLinkController() : nlId_(-1), sock_(nullptr) {}
     ~NetLinkController() {}
 
-    int SetUp(NBDConfig* config, int sockfd,
+    int SetUp(NBDConfig* config, const std::vector<int>& sockfds,
               uint64_t size, uint64_t flags) override;
     int DisconnectByPath(const std::string& devpath) override;
     int Resize(uint64_t size) override;
@@ -171,7 +178,7 @@ class NetLinkController : public NBDController {
  private:
     int Init();
     void Uninit();
-    int ConnectInternal(NBDConfig* config, int sockfd,
+    int ConnectInternal(NBDConfig* config, const std::vector<int>& sockfds,
                         uint64_t size, uint64_t flags);
     int DisconnectInternal(int index);
     int ResizeInternal(int nbdIndex, uint64_t size);
@@ -42,8 +42,11 @@
 #include <signal.h>
 #include <glog/logging.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <netinet/in.h>
 
+#include <algorithm>
+
 #include "nbd/src/util.h"
 
 namespace curve {
@@ -51,6 +54,70 @@ namespace nbd {
 
 #define REQUEST_TYPE_MASK 0x0000ffff
 
+// 每个连接缓存的请求上下文数量上限
+static const size_t kMaxFreeContexts = 256;
+// 请求上下文中可以缓存的buffer大小上限
+static const size_t kMaxCachedDataSize = 4 * 1024 * 1024;
+// 读取请求时使用的缓冲区大小，多个小请求可以通过一次read读上来
+static const size_t kRecvBufferSize = 256 * 1024;
+// 超过该大小的写数据直接读到请求的buffer中，避免多一次拷贝
+static const size_t kDirectReadThreshold = kRecvBufferSize / 2;
+
+// 带缓冲的请求读取，减少读取小请求时的系统调用次数
+class RequestReader {
+ public:
+    RequestReader(SafeIO* safeIO, int sock)
+        : safeIO_(safeIO),
+          sock_(sock),
+          buf_(new char[kRecvBufferSize]),
+          begin_(0),
+          end_(0) {}
+
+    /**
+     * @brief 读取指定长度的数据
+     * @return 成功返回0，失败返回负的错误码
+     */
+    ssize_t Read(void* dst, size_t len) {
+        char* out = static_cast<char*>(dst);
+        size_t n = std::min(len, end_ - begin_);
+        memcpy(out, buf_.get() + begin_, n);
+        begin_ += n;
+        out += n;
+        len -= n;
+        if (len == 0) {
+            return 0;
+        }
+
+        // 缓冲区中的数据已经读完
+        begin_ = end_ = 0;
+        if (len > kDirectReadThreshold) {
+            return safeIO_->ReadExact(sock_, out, len);
+        }
+
+        while (end_ < len) {
+            ssize_t r = safeIO_->ReadSome(sock_, buf_.get() + end_,
+                                          kRecvBufferSize - end_);
+            if (r < 0) {
+                return r;
+            } else if (r == 0) {
+                return -ECONNRESET;
+            }
+            end_ += r;
+        }
+
+        memcpy(out, buf_.get(), len);
+        begin_ = len;
+        return 0;
+    }
+
+ private:
+    SafeIO* safeIO_;
+    int sock_;
+    std::unique_ptr<char[]> buf_;
+    size_t begin_;
+    size_t end_;
+};
+
 static std::ostream& operator<<(std::ostream& os, const IOContext& ctx) {
     auto convert = [](const char* handle) {
         return *reinterpret_cast<const uint64_t*>(handle);
@@ -101,8 +168,10 @@ NBDServer::~NBDServer() {
 
         Shutdown();
 
-        writerThread_.join();
-        readerThread_.join();
+        for (auto& conn : connections_) {
+            conn->writerThread.join();
+            conn->readerThread.join();
+        }
 
         WaitClean();
 
@@ -119,9 +188,15 @@ void NBDServer::Start() {
 
     started_ = true;
 
-    readerThread_ = std::thread(&NBDServer::ReaderFunc, this);
-    writerThread_ = std::thread(&NBDServer::WriterFunc, this);
+    for (auto& conn : connections_) {
+        conn->readerThread =
+            std::thread(&NBDServer::ReaderFunc, this, conn.get());
+        conn->writerThread =
+            std::thread(&NBDServer::WriterFunc, this, conn.get());
+    }
 
+    LOG(INFO) << "NBDServer started with " << connections_.size()
+              << " connections";
     return;
 }
 
@@ -139,31 +214,37 @@ void NBDServer::Shutdown() {
     bool expected = false;
 
     if (terminated_.compare_exchange_strong(expected, true)) {
-        shutdown(sock_, SHUT_RDWR);
+        for (auto& conn : connections_) {
+            shutdown(conn->sock, SHUT_RDWR);
+        }
 
-        std::lock_guard<std::mutex> lk(requestMtx_);
-        requestCond_.notify_all();
+        for (auto& conn : connections_) {
+            std::lock_guard<std::mutex> lk(conn->mtx);
+            conn->cond.notify_all();
+        }
     }
 }
 
-void NBDServer::ReaderFunc() {
+void NBDServer::ReaderFunc(NBDConnection* conn) {
     ssize_t r = 0;
     bool disconnect = false;
+    RequestReader reader(safeIO_.get(), conn->sock);
 
     while (!terminated_) {
-        std::unique_ptr<IOContext> ctx(new IOContext());
-        ctx->server = this;
+        IOContext* ctx = AllocContext(conn);
 
-        r = safeIO_->ReadExact(sock_, &ctx->request, sizeof(ctx->request));
+        r = reader.Read(&ctx->request, sizeof(ctx->request));
         if (r < 0) {
             LOG(ERROR) << "Failed to read nbd request header: "
                        << cpp_strerror(r);
+            ReleaseContexts(conn, {ctx});
             break;
         }
 
         if (ctx->request.magic != htonl(NBD_REQUEST_MAGIC)) {
             LOG(ERROR) << "Invalid nbd request magic" << std::hex
                        << ctx->request.magic;
+            ReleaseContexts(conn, {ctx});
             break;
         }
 
@@ -183,11 +264,10 @@ void NBDServer::ReaderFunc() {
                 disconnect = true;
                 break;
             case NBD_CMD_WRITE:
-                ctx->data.reset(new char[ctx->request.len]);
+                ctx->ReserveData(ctx->request.len);
 
                 // 写请求，继续读取写入数据
-                r = safeIO_->ReadExact(sock_, ctx->data.get(),
-                                       ctx->request.len);
+                r = reader.Read(ctx->data.get(), ctx->request.len);
                 if (r < 0) {
                     LOG(ERROR) << "Failed to read nbd request data "
                                << cpp_strerror(r);
@@ -195,22 +275,23 @@ void NBDServer::ReaderFunc() {
                 }
                 break;
             case NBD_CMD_READ:
-                ctx->data.reset(new char[ctx->request.len]);
+                ctx->ReserveData(ctx->request.len);
                 break;
         }
 
         if (disconnect) {
+            ReleaseContexts(conn, {ctx});
             break;
         }
 
-        OnRequestStart();
+        OnRequestStart(conn);
 
-        IOContext* pctx = ctx.get();
-        bool ret = StartAioRequest(ctx.release());
+        bool ret = StartAioRequest(ctx);
 
         if (ret == false) {
-            pctx->nebdAioCtx.ret = -1;
-            OnRequestFinish(pctx);
+            ctx->nebdAioCtx.ret = -1;
+            ctx->reply.error = htonl(EINVAL);
+            OnRequestFinish(ctx);
             break;
         }
     }
@@ -223,78 +304,150 @@ void NBDServer::ReaderFunc() {
     Shutdown();
 }
 
-void NBDServer::WriterFunc() {
+void NBDServer::WriterFunc(NBDConnection* conn) {
     signal(SIGPIPE, SIG_IGN);
 
-    ssize_t r = 0;
+    std::vector<IOContext*> ctxs;
 
     while (!terminated_) {
-        std::unique_ptr<IOContext> ctx(WaitRequestFinish());
-
-        if (ctx == nullptr) {
+        if (!WaitRequestFinish(conn, &ctxs)) {
             LOG(INFO) << "No more requests, terminating";
             break;
         }
 
-        r = safeIO_->Write(sock_, &ctx->reply, sizeof(struct nbd_reply));
-        if (r < 0) {
-            LOG(ERROR) << *ctx << ": failed to write reply header : "
-                       << cpp_strerror(r);
+        bool ret = SendReplies(conn, ctxs);
+        ReleaseContexts(conn, ctxs);
+        if (!ret) {
             return;
         }
+    }
+
+    LOG(INFO) << "WriterFunc terminated!";
+    Shutdown();
+}
+
+bool NBDServer::SendReplies(NBDConnection* conn,
+                            const std::vector<IOContext*>& ctxs) {
+    // 每个请求最多占用两个iovec
+    static const size_t kMaxIovPerWrite = IOV_MAX - 1;
 
+    std::vector<struct iovec> iovs;
+    iovs.reserve(std::min(ctxs.size() * 2, kMaxIovPerWrite + 1));
+
+    for (size_t i = 0; i < ctxs.size(); ++i) {
+        IOContext* ctx = ctxs[i];
+        iovs.push_back({&ctx->reply, sizeof(struct nbd_reply)});
         if (ctx->command == NBD_CMD_READ && ctx->reply.error == htonl(0)) {
-            r = safeIO_->Write(sock_, ctx->data.get(), ctx->request.len);
-            if (r < 0) {
-                LOG(ERROR) << *ctx << ": faield to write reply data : "
-                           << cpp_strerror(r);
-                return;
-            }
+            iovs.push_back({ctx->data.get(), ctx->request.len});
         }
+
+        if (iovs.size() < kMaxIovPerWrite && i + 1 < ctxs.size()) {
+            continue;
+        }
+
+        ssize_t r = safeIO_->WriteV(conn->sock, iovs.data(), iovs.size());
+        if (r < 0) {
+            LOG(ERROR) << *ctx << ": failed to write replies : "
+                       << cpp_strerror(r) << ", batch size: " << iovs.size();
+            return false;
+        }
+        iovs.clear();
     }
 
-    LOG(INFO) << "WriterFunc terminated!";
-    Shutdown();
+    return true;
 }
 
-IOContext* NBDServer::WaitRequestFinish() {
-    std::unique_lock<std::mutex> lk(requestMtx_);
-    requestCond_.wait(
-        lk, [this]() { return !finishedRequests_.empty() || terminated_; });
+bool NBDServer::WaitRequestFinish(NBDConnection* conn,
+                                  std::vector<IOContext*>* ctxs) {
+    ctxs->clear();
+
+    std::unique_lock<std::mutex> lk(conn->mtx);
+    conn->cond.wait(lk, [this, conn]() {
+        return !conn->finishedRequests.empty() || terminated_;
+    });
 
-    if (finishedRequests_.empty()) {
-        return nullptr;
+    if (conn->finishedRequests.empty()) {
+        return false;
     }
 
-    IOContext* ctx = finishedRequests_.front();
-    finishedRequests_.pop_front();
+    ctxs->assign(conn->finishedRequests.begin(),
+                 conn->finishedRequests.end());
+    conn->finishedRequests.clear();
 
-    return ctx;
+    return true;
 }
 
-void NBDServer::OnRequestStart() {
-    std::lock_guard<std::mutex> lk(requestMtx_);
-    ++pendingRequestCounts_;
+void NBDServer::OnRequestStart(NBDConnection* conn) {
+    std::lock_guard<std::mutex> lk(conn->mtx);
+    ++conn->pendingRequestCounts;
 }
 
 void NBDServer::OnRequestFinish(IOContext* ctx) {
-    std::lock_guard<std::mutex> lk(requestMtx_);
+    NBDConnection* conn = ctx->conn;
+    std::lock_guard<std::mutex> lk(conn->mtx);
 
-    --pendingRequestCounts_;
+    --conn->pendingRequestCounts;
 
-    finishedRequests_.push_back(ctx);
-    requestCond_.notify_all();
+    conn->finishedRequests.push_back(ctx);
+    conn->cond.notify_all();
 }
 
 void NBDServer::WaitClean() {
-    LOG(INFO) << "WaitClean, current pending requests: "
-              << pendingRequestCounts_;
-    std::unique_lock<std::mutex> lk(requestMtx_);
-    requestCond_.wait(lk, [this]() { return pendingRequestCounts_ == 0; });
-
-    while (!finishedRequests_.empty()) {
-        std::unique_ptr<IOContext> ctx(finishedRequests_.front());
-        finishedRequests_.pop_front();
+    for (auto& conn : connections_) {
+        std::unique_lock<std::mutex> lk(conn->mtx);
+        LOG(INFO) << "WaitClean, current pending requests: "
+                  << conn->pendingRequestCounts;
+        conn->cond.wait(
+            lk, [&conn]() { return conn->pendingRequestCounts == 0; });
+
+        for (auto* ctx : conn->finishedRequests) {
+            delete ctx;
+        }
+        conn->finishedRequests.clear();
+
+        for (auto* ctx : conn->freeContexts) {
+            delete ctx;
+        }
+        conn->freeContexts.clear();
+    }
+}
+
+IOContext* NBDServer::AllocContext(NBDConnection* conn) {
+    IOContext* ctx = nullptr;
+    {
+        std::lock_guard<std::mutex> lk(conn->mtx);
+        if (!conn->freeContexts.empty()) {
+            ctx = conn->freeContexts.back();
+            conn->freeContexts.pop_back();
+        }
+    }
+
+    if (ctx == nullptr) {
+        ctx = new IOContext();
+    } else {
+        ctx->Reset();
+    }
+
+    ctx->server = this;
+    ctx->conn = conn;
+    return ctx;
+}
+
+void NBDServer::ReleaseContexts(NBDConnection* conn,
+                                const std::vector<IOContext*>& ctxs) {
+    std::lock_guard<std::mutex> lk(conn->mtx);
+    for (auto* ctx : ctxs) {
+        if (conn->freeContexts.size() >= kMaxFreeContexts) {
+            delete ctx;
+            continue;
+        }
+
+        // 不缓存过大的buffer，避免偶发的大请求长期占用内存
+        if (ctx->dataCapacity > kMaxCachedDataSize) {
+            ctx->data.reset();
+            ctx->dataCapacity = 0;
+        }
+        conn->freeContexts.push_back(ctx);
     }
 }
 
@@ -48,6 +48,7 @@
 #include <mutex>  // NOLINT
 #include <string>
 #include <thread>  // NOLINT
+#include <vector>
 
 #include "nbd/src/ImageInstance.h"
 #include "nbd/src/NBDController.h"
@@ -58,6 +59,7 @@ namespace curve {
 namespace nbd {
 
 class NBDServer;
+struct NBDConnection;
 
 // NBD IO请求上下文信息
 struct IOContext {
@@ -68,7 +70,11 @@ struct IOContext {
     int command = 0;
 
     NBDServer* server = nullptr;
+    // 请求所属的连接，回复需要从同一个连接返回
+    NBDConnection* conn = nullptr;
     std::unique_ptr<char[]> data;
+    // data的容量，上下文复用时只有容量不够才重新分配
+    size_t dataCapacity = 0;
 
     // NEBD请求上下文信息
     NebdClientAioContext nebdAioCtx;
@@ -76,6 +82,46 @@ struct IOContext {
     IOContext() {
         memset(&nebdAioCtx, 0, sizeof(nebdAioCtx));
     }
+
+    // 复用前清理上一个请求的信息，保留data
+    void Reset() {
+        memset(&request, 0, sizeof(request));
+        memset(&reply, 0, sizeof(reply));
+        command = 0;
+        memset(&nebdAioCtx, 0, sizeof(nebdAioCtx));
+    }
+
+    void ReserveData(size_t size) {
+        if (dataCapacity < size) {
+            data.reset(new char[size]);
+            dataCapacity = size;
+        }
+    }
+};
+
+// 与nbd内核之间的一个连接，每个连接有独立的读写线程
+// 内核要求请求从哪个连接下发，回复就从哪个连接返回
+struct NBDConnection {
+    explicit NBDConnection(int sock) : sock(sock), pendingRequestCounts(0) {}
+
+    // 与内核通信的socket fd
+    int sock;
+
+    // 读线程
+    std::thread readerThread;
+    // 写线程
+    std::thread writerThread;
+
+    // 保护以下成员
+    std::mutex mtx;
+    std::condition_variable cond;
+
+    // 正在执行过程中的请求数量
+    uint64_t pendingRequestCounts;
+    // 已完成请求上下文队列
+    std::deque<IOContext*> finishedRequests;
+    // 可复用的请求上下文
+    std::vector<IOContext*> freeContexts;
 };
 
 // NBDServer负责与nbd内核进行数据通信
@@ -84,13 +130,20 @@ class NBDServer {
     NBDServer(int sock, NBDControllerPtr nbdCtrl,
               std::shared_ptr<ImageInstance> imageInstance,
               std::shared_ptr<SafeIO> safeIO = std::make_shared<SafeIO>())
+        : NBDServer(std::vector<int>{sock}, nbdCtrl, imageInstance, safeIO) {}
+
+    NBDServer(const std::vector<int>& socks, NBDControllerPtr nbdCtrl,
+              std::shared_ptr<ImageInstance> imageInstance,
+              std::shared_ptr<SafeIO> safeIO = std::make_shared<SafeIO>())
         : started_(false),
           terminated_(false),
-          sock_(sock),
           nbdCtrl_(nbdCtrl),
           image_(imageInstance),
-          pendingRequestCounts_(0),
-          safeIO_(safeIO) {}
+          safeIO_(safeIO) {
+        for (int sock : socks) {
+            connections_.emplace_back(new NBDConnection(sock));
+        }
+    }
 
     ~NBDServer();
 
@@ -133,18 +186,20 @@ class NBDServer {
 
     /**
      * @brief 读线程执行函数
+     * @param conn 读线程负责的连接
      */
-    void ReaderFunc();
+    void ReaderFunc(NBDConnection* conn);
 
     /**
      * @brief 写线程执行函数
+     * @param conn 写线程负责的连接
      */
-    void WriterFunc();
+    void WriterFunc(NBDConnection* conn);
 
     /**
      * @brief 异步请求开始时执行函数
      */
-    void OnRequestStart();
+    void OnRequestStart(NBDConnection* conn);
 
     /**
      * @brief 异步请求结束时执行函数
@@ -153,10 +208,19 @@ class NBDServer {
     void OnRequestFinish(IOContext* ctx);
 
     /**
-     * @brief 等待异步请求返回
-     * @return 异步请求context
+     * @brief 等待异步请求返回，一次取出所有已完成的请求
+     * @param conn 请求所属的连接
+     * @param[out] ctxs 已完成的异步请求context
+     * @return 没有请求并且server已经停止时返回false
      */
-    IOContext* WaitRequestFinish();
+    bool WaitRequestFinish(NBDConnection* conn, std::vector<IOContext*>* ctxs);
+
+    /**
+     * @brief 将一批请求的回复合并写入socket
+     * @return 成功返回true，失败返回false
+     */
+    bool SendReplies(NBDConnection* conn,
+                     const std::vector<IOContext*>& ctxs);
 
     /**
      * 发起异步请求
@@ -165,32 +229,29 @@ class NBDServer {
      */
     bool StartAioRequest(IOContext* ctx);
 
+    /**
+     * @brief 获取请求上下文，优先复用已经释放的上下文
+     */
+    IOContext* AllocContext(NBDConnection* conn);
+
+    /**
+     * @brief 释放请求上下文，放回连接的缓存中
+     */
+    void ReleaseContexts(NBDConnection* conn,
+                         const std::vector<IOContext*>& ctxs);
+
  private:
     // server是否启动
     std::atomic<bool> started_;
     // server是否停止
     std::atomic<bool> terminated_;
 
-    // 与内核通信的socket fd
-    int sock_;
     NBDControllerPtr nbdCtrl_;
     std::shared_ptr<ImageInstance> image_;
     std::shared_ptr<SafeIO> safeIO_;
 
-    // 保护pendingRequestCounts_和finishedRequests_
-    std::mutex requestMtx_;
-    std::condition_variable requestCond_;
-
-    // 正在执行过程中的请求数量
-    uint64_t pendingRequestCounts_;
-
-    // 已完成请求上下文队列
-    std::deque<IOContext*> finishedRequests_;
-
-    // 读线程
-    std::thread readerThread_;
-    // 写线程
-    std::thread writerThread_;
+    // 与内核之间的所有连接
+    std::vector<std::unique_ptr<NBDConnection>> connections_;
 
     // 等待断开连接锁/条件变量
     std::mutex disconnectMutex_;
@@ -60,14 +60,6 @@ NBDControllerPtr NBDTool::GetController(bool tryNetlink) {
 int NBDTool::Connect(NBDConfig *cfg) {
     // loadmodule 到时候放到外面做
 
-    // init socket pair
-    int ret = socketPair_.Init();
-    if (ret < 0) {
-        dout << "init socker pair failed, imgname = " << cfg->imgname
-             << std::endl;
-        return ret;
-    }
-
     // 初始化打开文件
     ImagePtr imageInstance = GenerateImage(cfg->imgname, cfg);
     bool openSuccess = imageInstance->Open();
@@ -90,14 +82,30 @@ int NBDTool::Connect(NBDConfig *cfg) {
     }
 
     // load nbd module
-    ret = load_module(cfg);
+    int ret = load_module(cfg);
     if (ret < 0) {
         dout << "load module failed, imgname = " << cfg->imgname << std::endl;
         return ret;
     }
 
+    // 多连接只有netlink方式支持
+    int connections = cfg->connections;
     NBDControllerPtr nbdCtrl = GetController(cfg->try_netlink);
-    nbdServer_ = std::make_shared<NBDServer>(socketPair_.Second(), nbdCtrl,
+    if (connections > 1 && !nbdCtrl->IsNetLink()) {
+        dout << "curve-nbd: multiple connections require netlink interface, "
+             << "fall back to 1 connection" << std::endl;
+        connections = 1;
+    }
+
+    // init socket pair
+    ret = socketPairs_.Init(connections);
+    if (ret < 0) {
+        dout << "init socker pair failed, imgname = " << cfg->imgname
+             << std::endl;
+        return ret;
+    }
+
+    nbdServer_ = std::make_shared<NBDServer>(socketPairs_.Second(), nbdCtrl,
                                              imageInstance);
 
     // setup controller
@@ -106,7 +114,11 @@ int NBDTool::Connect(NBDConfig *cfg) {
     if (cfg->readonly) {
         flags |= NBD_FLAG_READ_ONLY;
     }
-    ret = nbdCtrl->SetUp(cfg, socketPair_.First(), fileSize, flags);
+    // 写请求返回时数据已经持久化，任意连接上的flush都能覆盖所有连接
+    if (connections > 1) {
+        flags |= NBD_FLAG_CAN_MULTI_CONN;
+    }
+    ret = nbdCtrl->SetUp(cfg, socketPairs_.First(), fileSize, flags);
     if (ret < 0) {
         dout << "nbd controller setup failed, imgname = " << cfg->imgname
              << std::endl;
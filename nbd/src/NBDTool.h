@@ -72,47 +72,57 @@ class NBDTool {
     int WaitForTerminate(pid_t pid, const NBDConfig* config);
 
  private:
-    class NBDSocketPair {
+    // 与nbd内核通信的socketpair，每个连接一对
+    class NBDSocketPairs {
      public:
-        NBDSocketPair() : inited_(false) {}
-        ~NBDSocketPair() {
+        NBDSocketPairs() {}
+        ~NBDSocketPairs() {
             Uninit();
         }
 
-        int Init() {
-            if (inited_) {
+        int Init(int count) {
+            if (!first_.empty()) {
                 return 0;
             }
-            int ret = socketpair(AF_UNIX, SOCK_STREAM, 0, fd_);
-            if (ret < 0) {
-                return -errno;
+            for (int i = 0; i < count; ++i) {
+                int fd[2];
+                int ret = socketpair(AF_UNIX, SOCK_STREAM, 0, fd);
+                if (ret < 0) {
+                    ret = -errno;
+                    Uninit();
+                    return ret;
+                }
+                first_.push_back(fd[0]);
+                second_.push_back(fd[1]);
             }
-            inited_ = true;
             return 0;
         }
 
         void Uninit() {
-            if (inited_) {
-                close(fd_[0]);
-                close(fd_[1]);
-                inited_ = false;
+            for (size_t i = 0; i < first_.size(); ++i) {
+                close(first_[i]);
+                close(second_[i]);
             }
+            first_.clear();
+            second_.clear();
         }
 
-        int First() {
-            return fd_[0];
+        // 传给nbd内核的一端
+        const std::vector<int>& First() {
+            return first_;
         }
 
-        int Second() {
-            return fd_[1];
+        // NBDServer使用的一端
+        const std::vector<int>& Second() {
+            return second_;
         }
 
      private:
-        bool inited_;
-        int fd_[2];
+        std::vector<int> first_;
+        std::vector<int> second_;
     };
 
-    NBDSocketPair socketPair_;
+    NBDSocketPairs socketPairs_;
     NBDServerPtr nbdServer_;
     std::shared_ptr<NBDWatchContext> nbdWatchCtx_;
 };
@@ -61,6 +61,8 @@ namespace nbd {
 #define NBD_PATH_PREFIX "/sys/block/nbd"
 #define DEV_PATH_PREFIX "/dev/nbd"
 #define CURVETAB_PATH "/etc/curve/curvetab"
+// 单个nbd设备支持的最大连接数
+#define NBD_MAX_CONNECTIONS 16
 
 using std::cerr;
 
@@ -93,6 +95,8 @@ struct NBDConfig {
     int block_size = 4096;
     // libnebd config file path
     std::string nebd_conf;
+    // 与nbd内核模块之间的连接数，大于1时需要使用netlink方式
+    int connections = 1;
 
     /**
      * @brief Return options for map operation
@@ -173,6 +177,7 @@ inline std::string NBDConfig::MapOptions() const {
     opts.append(KeyValueOption("block-size", block_size, 4096, &firstOpt));
     opts.append(KeyValueOption("nebd-conf", nebd_conf, {}, &firstOpt));
     opts.append(BoolOption("no-exclusive", !exclusive, &firstOpt));
+    opts.append(KeyValueOption("connections", connections, 1, &firstOpt));
 
     return opts.empty() ? "defaults" : opts;
 }
@@ -89,6 +89,7 @@ static void Usage() {
         << "  --block-size            NBD Devices's block size, default is 4096, support 512 and 4096\n"  // NOLINT
         << "  --nebd-conf             LibNebd config file\n"
         << "  --no-exclusive          Map image non exclusive\n"
+        << "  --connections <num>     Number of connections to nbd device, default is 1, requires --try-netlink when greater than 1\n"  // NOLINT
         << "\n"
         << "Unmap options:\n"
         << "  -f, --force                 Force unmap even if the device is mounted\n"              // NOLINT
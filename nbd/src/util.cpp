@@ -40,6 +40,7 @@
 #include <linux/nbd.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <libgen.h>
 #include <string.h>
 #include <sstream>
@@ -190,6 +191,17 @@ int parse_args(std::vector<const char*>& args, std::ostream *err_msg,   // NOLIN
                 *err_msg << "curve-nbd: " << err.str();
                 return -EINVAL;
             }
+        } else if (argparse_witharg(args, i, &cfg->connections, err, "--connections", (char*)(NULL))) {  // NOLINT
+            if (!err.str().empty()) {
+                *err_msg << "curve-nbd: " << err.str();
+                return -EINVAL;
+            }
+
+            if (cfg->connections < 1 || cfg->connections > NBD_MAX_CONNECTIONS) {  // NOLINT
+                *err_msg << "curve-nbd: Invalid argument for connections(1~"
+                         << NBD_MAX_CONNECTIONS << ")!";
+                return -EINVAL;
+            }
         } else {
             ++i;
         }
@@ -507,6 +519,40 @@ ssize_t safe_read_exact(int fd, void* buf, size_t count) {
     return 0;
 }
 
+ssize_t safe_read_some(int fd, void* buf, size_t count) {
+    while (true) {
+        ssize_t r = read(fd, buf, count);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        return r < 0 ? -errno : r;
+    }
+}
+
+ssize_t safe_writev(int fd, struct iovec* iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t r = writev(fd, iov, iovcnt);
+        if (r < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+
+        // 跳过已经写完的部分
+        while (iovcnt > 0 && static_cast<size_t>(r) >= iov->iov_len) {
+            r -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + r;
+            iov->iov_len -= r;
+        }
+    }
+    return 0;
+}
+
 ssize_t safe_write(int fd, const void* buf, size_t count) {
     while (count > 0) {
         ssize_t r = write(fd, buf, count);
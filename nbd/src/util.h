@@ -25,6 +25,7 @@
 #ifndef NBD_SRC_UTIL_H_
 #define NBD_SRC_UTIL_H_
 
+#include <sys/uio.h>
 #include <string>
 #include <vector>
 #include "nbd/src/define.h"
@@ -67,6 +68,10 @@ int check_dev_can_unmap(const NBDConfig *cfg);
 ssize_t safe_read_exact(int fd, void* buf, size_t count);
 ssize_t safe_read(int fd, void* buf, size_t count);
 ssize_t safe_write(int fd, const void* buf, size_t count);
+// 只调用一次read，返回实际读到的字节数，0表示对端已关闭
+ssize_t safe_read_some(int fd, void* buf, size_t count);
+// 写入全部iov，iov数组的内容会被修改
+ssize_t safe_writev(int fd, struct iovec* iov, int iovcnt);
 
 // 网络字节序转换
 inline uint64_t ntohll(uint64_t val) {
@@ -32,6 +32,7 @@ namespace curve {
 namespace nbd {
 
 using FuncType = std::function<ssize_t(int, void*, size_t)>;
+using WriteVFuncType = std::function<ssize_t(int, struct iovec*, int)>;
 
 class FakeSafeIO : public SafeIO {
  public:
@@ -47,6 +48,14 @@ class FakeSafeIO : public SafeIO {
         return writeTask_ ? writeTask_(fd, const_cast<void*>(buf), count) : -1;
     }
 
+    ssize_t ReadSome(int fd, void* buf, size_t count) override {
+        return readSomeTask_ ? readSomeTask_(fd, buf, count) : -1;
+    }
+
+    ssize_t WriteV(int fd, struct iovec* iov, int iovcnt) override {
+        return writeVTask_ ? writeVTask_(fd, iov, iovcnt) : -1;
+    }
+
     void SetReadExactTask(FuncType task) {
         readExactTask_ = task;
     }
@@ -59,10 +68,20 @@ class FakeSafeIO : public SafeIO {
         writeTask_ = task;
     }
 
+    void SetReadSomeTask(FuncType task) {
+        readSomeTask_ = task;
+    }
+
+    void SetWriteVTask(WriteVFuncType task) {
+        writeVTask_ = task;
+    }
+
  private:
     FuncType readExactTask_;
     FuncType readTask_;
     FuncType writeTask_;
+    FuncType readSomeTask_;
+    WriteVFuncType writeVTask_;
 };
 
 }  // namespace nbd
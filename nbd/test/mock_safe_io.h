@@ -40,6 +40,8 @@ class MockSafeIO : public SafeIO {
     MOCK_METHOD3(ReadExact, ssize_t(int, void*, size_t));
     MOCK_METHOD3(Read, ssize_t(int, void*, size_t));
     MOCK_METHOD3(Write, ssize_t(int, const void*, size_t));
+    MOCK_METHOD3(ReadSome, ssize_t(int, void*, size_t));
+    MOCK_METHOD3(WriteV, ssize_t(int, struct iovec*, int));
 };
 
 }  // namespace nbd
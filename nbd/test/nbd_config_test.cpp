@@ -64,6 +64,14 @@ TEST(NBDConfigTest, TestMapOptions) {
         ASSERT_EQ("try-netlink,nebd-conf=/etc/nebd/nebd-client.conf",
                   config.MapOptions());
     }
+
+    {
+        NBDConfig config;
+        config.try_netlink = true;
+        config.connections = 4;
+
+        ASSERT_EQ("try-netlink,connections=4", config.MapOptions());
+    }
 }
 
 }  // namespace nbd
@@ -30,7 +30,9 @@
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <memory>
+#include <vector>
 #include "nbd/src/NBDServer.h"
+#include "nbd/src/util.h"
 #include "nbd/test/fake_safe_io.h"
 #include "nbd/test/mock_image_instance.h"
 #include "nbd/test/mock_safe_io.h"
@@ -122,7 +124,7 @@ TEST_F(NBDServerTest, ReadRequestErrorTest) {
     auto fakeSafeIO = std::make_shared<FakeSafeIO>();
     server_.reset(new NBDServer(fd_[1], nullptr, image_, fakeSafeIO));
 
-    fakeSafeIO->SetReadExactTask(
+    fakeSafeIO->SetReadSomeTask(
         [](int fd, void* buf, size_t count) { return -1; });
 
     ASSERT_NO_THROW(server_->Start());
@@ -277,17 +279,18 @@ TEST_F(NBDServerTest, ReadWriteDataErrorTest) {
     EXPECT_CALL(*image_, AioWrite(_))
         .Times(0);
 
-    auto task = [this](int fd, void* buf, size_t count) {
+    // 第一次只返回请求头，读取写数据时失败
+    auto task = [this](int fd, void* buf, size_t count) -> ssize_t {
         static int callTime = 1;
         if (callTime++ == 1) {
             *reinterpret_cast<struct nbd_request*>(buf) = request_;
-            return 0;
+            return NBDRequestSize;
         } else {
             return -1;
         }
     };
 
-    fakeSafeIO->SetReadExactTask(task);
+    fakeSafeIO->SetReadSomeTask(task);
 
     ASSERT_NO_THROW(server_->Start());
 
@@ -296,5 +299,57 @@ TEST_F(NBDServerTest, ReadWriteDataErrorTest) {
     ASSERT_TRUE(server_->IsTerminated());
 }
 
+TEST_F(NBDServerTest, MultiConnectionTest) {
+    int other[2];
+    ASSERT_NE(-1, socketpair(AF_UNIX, SOCK_STREAM, 0, other));
+    server_.reset(new NBDServer(std::vector<int>{fd_[1], other[1]}, nullptr,
+                                image_));
+    ASSERT_NO_THROW(server_->Start());
+
+    request_.from = 0;
+    request_.len = htonl(8);
+    request_.type = htonl(NBD_CMD_WRITE);
+    request_.magic = htonl(NBD_REQUEST_MAGIC);
+    memcpy(&request_.handle, &handle_, sizeof(request_.handle));
+
+    std::vector<NebdClientAioContext*> contexts;
+    EXPECT_CALL(*image_, AioWrite(_))
+        .Times(2)
+        .WillRepeatedly(Invoke([&contexts](NebdClientAioContext* ctx) {
+            contexts.push_back(ctx);
+        }));
+
+    // 两个连接上各发送一个写请求
+    ASSERT_EQ(NBDRequestSize, write(fd_[0], &request_, NBDRequestSize));
+    ASSERT_EQ(8, write(fd_[0], "hello, world", 8));
+    std::this_thread::sleep_for(std::chrono::milliseconds(kSleepTime));
+
+    request_.from = ntohll(4096);
+    ASSERT_EQ(NBDRequestSize, write(other[0], &request_, NBDRequestSize));
+    ASSERT_EQ(8, write(other[0], "hello, world", 8));
+    std::this_thread::sleep_for(std::chrono::milliseconds(kSleepTime));
+
+    ASSERT_EQ(2, contexts.size());
+    ASSERT_EQ(0, contexts[0]->offset);
+    ASSERT_EQ(4096, contexts[1]->offset);
+
+    // 响应需要从请求所在的连接返回
+    contexts[1]->ret = 0;
+    contexts[1]->cb(contexts[1]);
+    ASSERT_EQ(NBDReplySize, read(other[0], &reply_, NBDReplySize));
+    ASSERT_EQ(0, reply_.error);
+
+    contexts[0]->ret = 0;
+    contexts[0]->cb(contexts[0]);
+    ASSERT_EQ(NBDReplySize, read(fd_[0], &reply_, NBDReplySize));
+    ASSERT_EQ(0, reply_.error);
+
+    ASSERT_FALSE(server_->IsTerminated());
+
+    ::shutdown(other[0], SHUT_RDWR);
+    server_.reset();
+    ::close(other[0]);
+}
+
 }  // namespace nbd
 }  // namespace curve
@@ -0,0 +1,317 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ * Created Date: 2022-01-14
+ */
+
+#include "nebd/src/common/shm_ring.h"
+
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <new>
+
+namespace nebd {
+namespace common {
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "shared memory ring requires lock free atomics");
+
+const uint32_t kShmRingMagic = 0x4e454244;  // "NEBD"
+const uint32_t kShmRingVersion = 1;
+const uint64_t kShmRingAlignment = 4096;
+
+struct ShmRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t queueDepth;
+    uint32_t reserved;
+    uint64_t sqOffset;
+    uint64_t cqOffset;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+
+    // 生产者和消费者分别修改的字段放在不同的cache line上
+    alignas(64) std::atomic<uint32_t> sqHead;
+    std::atomic<uint32_t> sqWaiting;
+    alignas(64) std::atomic<uint32_t> sqTail;
+    alignas(64) std::atomic<uint32_t> cqHead;
+    std::atomic<uint32_t> cqWaiting;
+    alignas(64) std::atomic<uint32_t> cqTail;
+    alignas(64) std::atomic<uint64_t> serverHeartbeatMs;
+};
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static void FutexWait(std::atomic<uint32_t>* addr, uint32_t expected,
+                      uint32_t timeoutMs) {
+    struct timespec ts;
+    ts.tv_sec = timeoutMs / 1000;
+    ts.tv_nsec = (timeoutMs % 1000) * 1000000L;
+    // 不使用FUTEX_PRIVATE_FLAG，等待者和唤醒者在不同进程
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT,
+            expected, &ts, nullptr, 0);
+}
+
+static void FutexWake(std::atomic<uint32_t>* addr) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE, 1,
+            nullptr, nullptr, 0);
+}
+
+template <typename T>
+static bool Push(std::atomic<uint32_t>* head, std::atomic<uint32_t>* tail,
+                 std::atomic<uint32_t>* waiting, T* entries, uint32_t depth,
+                 const T& entry) {
+    uint32_t t = tail->load(std::memory_order_relaxed);
+    uint32_t h = head->load(std::memory_order_acquire);
+    if (t - h >= depth) {
+        return false;
+    }
+
+    entries[t & (depth - 1)] = entry;
+    tail->store(t + 1, std::memory_order_seq_cst);
+
+    if (waiting->load(std::memory_order_seq_cst) != 0) {
+        waiting->store(0, std::memory_order_relaxed);
+        FutexWake(tail);
+    }
+    return true;
+}
+
+template <typename T>
+static bool Pop(std::atomic<uint32_t>* head, std::atomic<uint32_t>* tail,
+                T* entries, uint32_t depth, T* entry) {
+    uint32_t h = head->load(std::memory_order_relaxed);
+    uint32_t t = tail->load(std::memory_order_acquire);
+    if (h == t) {
+        return false;
+    }
+
+    *entry = entries[h & (depth - 1)];
+    head->store(h + 1, std::memory_order_release);
+    return true;
+}
+
+static void Wait(std::atomic<uint32_t>* head, std::atomic<uint32_t>* tail,
+                 std::atomic<uint32_t>* waiting, uint32_t timeoutMs) {
+    uint32_t h = head->load(std::memory_order_relaxed);
+    waiting->store(1, std::memory_order_seq_cst);
+    if (tail->load(std::memory_order_seq_cst) == h) {
+        // tail在此期间被修改时futex会直接返回
+        FutexWait(tail, h, timeoutMs);
+    }
+    waiting->store(0, std::memory_order_relaxed);
+}
+
+int ShmRing::Create(const std::string& path, uint32_t queueDepth,
+                    uint64_t dataSize) {
+    if (queueDepth == 0 || (queueDepth & (queueDepth - 1)) != 0) {
+        LOG(ERROR) << "Queue depth must be power of 2, depth: " << queueDepth;
+        return -1;
+    }
+
+    uint64_t sqOffset = AlignUp(sizeof(ShmRingHeader), kShmRingAlignment);
+    uint64_t cqOffset = sqOffset + sizeof(ShmIoRequest) * queueDepth;
+    uint64_t dataOffset = AlignUp(
+        cqOffset + sizeof(ShmIoCompletion) * queueDepth, kShmRingAlignment);
+    uint64_t size = dataOffset + AlignUp(dataSize, kShmRingAlignment);
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        LOG(ERROR) << "Create shm file failed, path: " << path
+                   << ", errno: " << errno;
+        return -1;
+    }
+
+    if (::ftruncate(fd, size) != 0 || Map(fd, size) != 0) {
+        LOG(ERROR) << "Init shm file failed, path: " << path
+                   << ", size: " << size << ", errno: " << errno;
+        ::close(fd);
+        ::unlink(path.c_str());
+        return -1;
+    }
+    ::close(fd);
+
+    header_ = new (base_) ShmRingHeader();
+    header_->queueDepth = queueDepth;
+    header_->sqOffset = sqOffset;
+    header_->cqOffset = cqOffset;
+    header_->dataOffset = dataOffset;
+    header_->dataSize = size - dataOffset;
+    header_->sqHead.store(0);
+    header_->sqWaiting.store(0);
+    header_->sqTail.store(0);
+    header_->cqHead.store(0);
+    header_->cqWaiting.store(0);
+    header_->cqTail.store(0);
+    header_->serverHeartbeatMs.store(0);
+    header_->version = kShmRingVersion;
+    queueDepth_ = queueDepth;
+    sqOffset_ = sqOffset;
+    cqOffset_ = cqOffset;
+    dataOffset_ = dataOffset;
+    dataSize_ = header_->dataSize;
+    // magic最后写入，part2据此判断是否初始化完成
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = kShmRingMagic;
+
+    return 0;
+}
+
+int ShmRing::Attach(const std::string& path, uint64_t size) {
+    // 路径由part2生成，这里仍然拒绝符号链接
+    int fd = ::open(path.c_str(), O_RDWR | O_NOFOLLOW);
+    if (fd < 0) {
+        LOG(ERROR) << "Open shm file failed, path: " << path
+                   << ", errno: " << errno;
+        return -1;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        static_cast<uint64_t>(st.st_size) != size ||
+        size < sizeof(ShmRingHeader) || Map(fd, size) != 0) {
+        LOG(ERROR) << "Map shm file failed, path: " << path
+                   << ", size: " << size << ", errno: " << errno;
+        ::close(fd);
+        return -1;
+    }
+    ::close(fd);
+
+    header_ = reinterpret_cast<ShmRingHeader*>(base_);
+    queueDepth_ = header_->queueDepth;
+    sqOffset_ = header_->sqOffset;
+    cqOffset_ = header_->cqOffset;
+    dataOffset_ = header_->dataOffset;
+    dataSize_ = header_->dataSize;
+    bool valid = header_->magic == kShmRingMagic &&
+                 header_->version == kShmRingVersion &&
+                 queueDepth_ != 0 && (queueDepth_ & (queueDepth_ - 1)) == 0 &&
+                 sqOffset_ >= sizeof(ShmRingHeader) &&
+                 cqOffset_ >= sqOffset_ + sizeof(ShmIoRequest) * queueDepth_ &&
+                 dataOffset_ >=
+                     cqOffset_ + sizeof(ShmIoCompletion) * queueDepth_ &&
+                 dataOffset_ <= size && dataSize_ <= size - dataOffset_;
+    if (!valid) {
+        LOG(ERROR) << "Invalid shm file, path: " << path;
+        Detach();
+        return -1;
+    }
+
+    return 0;
+}
+
+void ShmRing::Detach() {
+    if (base_ != nullptr) {
+        ::munmap(base_, size_);
+        base_ = nullptr;
+        header_ = nullptr;
+        size_ = 0;
+    }
+}
+
+int ShmRing::Unlink(const std::string& path) {
+    return ::unlink(path.c_str());
+}
+
+std::string ShmRing::MakePath(const std::string& dir, uint32_t pid, int fd,
+                              uint64_t generation) {
+    return dir + "/nebd-" + std::to_string(pid) + "-" + std::to_string(fd) +
+           "-" + std::to_string(generation);
+}
+
+int ShmRing::Map(int fd, uint64_t size) {
+    void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                        fd, 0);
+    if (addr == MAP_FAILED) {
+        return -1;
+    }
+
+    base_ = static_cast<char*>(addr);
+    size_ = size;
+    return 0;
+}
+
+bool ShmRing::PushRequest(const ShmIoRequest& request) {
+    return Push(&header_->sqHead, &header_->sqTail, &header_->sqWaiting,
+                reinterpret_cast<ShmIoRequest*>(base_ + sqOffset_),
+                queueDepth_, request);
+}
+
+bool ShmRing::PopRequest(ShmIoRequest* request) {
+    return Pop(&header_->sqHead, &header_->sqTail,
+               reinterpret_cast<ShmIoRequest*>(base_ + sqOffset_),
+               queueDepth_, request);
+}
+
+bool ShmRing::PushCompletion(const ShmIoCompletion& completion) {
+    return Push(&header_->cqHead, &header_->cqTail, &header_->cqWaiting,
+                reinterpret_cast<ShmIoCompletion*>(base_ + cqOffset_),
+                queueDepth_, completion);
+}
+
+bool ShmRing::PopCompletion(ShmIoCompletion* completion) {
+    return Pop(&header_->cqHead, &header_->cqTail,
+               reinterpret_cast<ShmIoCompletion*>(base_ + cqOffset_),
+               queueDepth_, completion);
+}
+
+void ShmRing::WaitRequest(uint32_t timeoutMs) {
+    Wait(&header_->sqHead, &header_->sqTail, &header_->sqWaiting, timeoutMs);
+}
+
+void ShmRing::WaitCompletion(uint32_t timeoutMs) {
+    Wait(&header_->cqHead, &header_->cqTail, &header_->cqWaiting, timeoutMs);
+}
+
+void ShmRing::UpdateServerHeartbeat() {
+    header_->serverHeartbeatMs.store(NowMs(), std::memory_order_relaxed);
+}
+
+uint64_t ShmRing::ServerHeartbeatMs() const {
+    return header_->serverHeartbeatMs.load(std::memory_order_relaxed);
+}
+
+char* ShmRing::Data(uint64_t dataOffset) const {
+    return base_ + dataOffset_ + dataOffset;
+}
+
+uint64_t ShmRing::DataSize() const {
+    return dataSize_;
+}
+
+uint32_t ShmRing::QueueDepth() const {
+    return queueDepth_;
+}
+
+uint64_t ShmRing::NowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+}  // namespace common
+}  // namespace nebd
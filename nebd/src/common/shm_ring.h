@@ -0,0 +1,160 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ * Created Date: 2022-01-14
+ */
+
+#ifndef NEBD_SRC_COMMON_SHM_RING_H_
+#define NEBD_SRC_COMMON_SHM_RING_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+namespace nebd {
+namespace common {
+
+// part1提交给part2的io请求
+struct ShmIoRequest {
+    // 请求id，由part1分配，completion中原样返回
+    uint64_t id;
+    // 请求类型，取值同LIBAIO_OP
+    uint32_t op;
+    uint32_t reserved;
+    // 文件内的偏移和长度
+    uint64_t offset;
+    uint64_t length;
+    // 数据在共享内存数据区中的偏移，discard/flush请求不使用
+    uint64_t dataOffset;
+};
+
+// part2返回给part1的io结果
+struct ShmIoCompletion {
+    uint64_t id;
+    // 0表示成功，-1表示失败，kShmRetryByRpc表示需要part1改为rpc重发
+    int32_t ret;
+    uint32_t reserved;
+};
+
+// part2不向part1返回io错误时(returnRpcWhenIoError为false)，把请求交还给
+// part1通过rpc重发，与rpc通道的行为保持一致
+const int32_t kShmRetryByRpc = -2;
+
+struct ShmRingHeader;
+
+/**
+ * part1和part2之间基于共享内存的io通道，每个打开的文件一个。
+ * 共享内存由part1创建，包含:
+ *   - 提交队列(sq)：part1生产，part2消费
+ *   - 完成队列(cq)：part2生产，part1消费
+ *   - 数据区：读写请求的数据，由part1负责分配
+ * 两个队列都是单生产者单消费者的无锁环形队列，多线程生产时由调用者加锁。
+ * 消费者在队列为空时通过futex等待，生产者只在消费者等待时才唤醒。
+ */
+class ShmRing {
+ public:
+    ShmRing() : header_(nullptr), base_(nullptr), size_(0), queueDepth_(0),
+                sqOffset_(0), cqOffset_(0), dataOffset_(0), dataSize_(0) {}
+
+    ~ShmRing() {
+        Detach();
+    }
+
+    /**
+     * @brief part1创建并初始化共享内存
+     * @param path 共享内存文件路径
+     * @param queueDepth 队列深度，需要是2的幂
+     * @param dataSize 数据区大小
+     * @return 成功返回0，失败返回-1
+     */
+    int Create(const std::string& path, uint32_t queueDepth,
+               uint64_t dataSize);
+
+    /**
+     * @brief part2映射part1创建的共享内存
+     * @param path 共享内存文件路径
+     * @param size 共享内存的大小，需要与文件大小一致
+     * @return 成功返回0，失败返回-1
+     */
+    int Attach(const std::string& path, uint64_t size);
+
+    // 解除映射
+    void Detach();
+
+    // 删除共享内存文件，已经映射的进程不受影响
+    static int Unlink(const std::string& path);
+
+    /**
+     * @brief 共享内存文件路径，part1创建和part2映射时都通过该函数生成，
+     *        part2不使用part1传入的路径
+     * @param dir 共享内存文件所在目录
+     * @param pid part1的进程号
+     * @param fd 文件的fd
+     * @param generation 通道的版本，同一个文件重建通道时递增
+     */
+    static std::string MakePath(const std::string& dir, uint32_t pid, int fd,
+                                uint64_t generation);
+
+    bool PushRequest(const ShmIoRequest& request);
+    bool PopRequest(ShmIoRequest* request);
+    bool PushCompletion(const ShmIoCompletion& completion);
+    bool PopCompletion(ShmIoCompletion* completion);
+
+    /**
+     * @brief 提交队列为空时等待，直到有新请求或者超时
+     */
+    void WaitRequest(uint32_t timeoutMs);
+
+    /**
+     * @brief 完成队列为空时等待，直到有新结果或者超时
+     */
+    void WaitCompletion(uint32_t timeoutMs);
+
+    // part2定期更新，part1据此判断part2是否还在处理请求
+    void UpdateServerHeartbeat();
+    uint64_t ServerHeartbeatMs() const;
+
+    char* Data(uint64_t dataOffset) const;
+    uint64_t DataSize() const;
+    uint32_t QueueDepth() const;
+    uint64_t Size() const { return size_; }
+
+    // 单调时钟，进程间可比较
+    static uint64_t NowMs();
+
+ private:
+    int Map(int fd, uint64_t size);
+
+ private:
+    ShmRingHeader* header_;
+    char* base_;
+    uint64_t size_;
+
+    // 布局信息在映射时校验并保存在本地，避免对端修改共享内存中的值导致越界
+    uint32_t queueDepth_;
+    uint64_t sqOffset_;
+    uint64_t cqOffset_;
+    uint64_t dataOffset_;
+    uint64_t dataSize_;
+};
+
+}  // namespace common
+}  // namespace nebd
+
+#endif  // NEBD_SRC_COMMON_SHM_RING_H_
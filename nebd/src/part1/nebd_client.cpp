@@ -52,6 +52,8 @@ namespace nebd {
 namespace client {
 
 using nebd::common::FileLock;
+using nebd::common::ReadLockGuard;
+using nebd::common::WriteLockGuard;
 
 NebdClient &nebdClient = NebdClient::GetInstance();
 
@@ -195,10 +197,24 @@ int NebdClient::Open(const char* filename, const NebdOpenFlags* flags) {
     }
 
     metaCache_->AddFileInfo({fd, filename, fileLock});
+
+    if (option_.shmOption.enable) {
+        SetupShmChannel(fd);
+    }
     return fd;
 }
 
 int NebdClient::Close(int fd) {
+    std::shared_ptr<NebdShmChannel> shmChannel;
+    {
+        WriteLockGuard lock(shmChannelsLock_);
+        auto iter = shmChannels_.find(fd);
+        if (iter != shmChannels_.end()) {
+            shmChannel = iter->second;
+            shmChannels_.erase(iter);
+        }
+    }
+
     auto task = [&](brpc::Controller* cntl,
                     brpc::Channel* channel,
                     bool* rpcFailed) -> int64_t {
@@ -229,6 +245,10 @@ int NebdClient::Close(int fd) {
     };
 
     int rpcRet = ExecuteSyncRpc(task);
+    if (shmChannel != nullptr) {
+        shmChannel->Fini();
+    }
+
     NebdClientFileInfo fileInfo;
     int ret = metaCache_->GetFileInfo(fd, &fileInfo);
     if (ret == 0) {
@@ -320,6 +340,14 @@ int64_t NebdClient::GetFileSize(int fd) {
 }
 
 int NebdClient::Discard(int fd, NebdClientAioContext* aioctx) {
+    if (SubmitByShm(fd, aioctx)) {
+        return 0;
+    }
+
+    return DiscardByRpc(fd, aioctx);
+}
+
+int NebdClient::DiscardByRpc(int fd, NebdClientAioContext* aioctx) {
     auto task = [this, fd, aioctx]() {
         nebd::client::NebdFileService_Stub stub(&channel_);
         nebd::client::DiscardRequest request;
@@ -340,6 +368,14 @@ int NebdClient::Discard(int fd, NebdClientAioContext* aioctx) {
 }
 
 int NebdClient::AioRead(int fd, NebdClientAioContext* aioctx) {
+    if (SubmitByShm(fd, aioctx)) {
+        return 0;
+    }
+
+    return AioReadByRpc(fd, aioctx);
+}
+
+int NebdClient::AioReadByRpc(int fd, NebdClientAioContext* aioctx) {
     auto task = [this, fd, aioctx]() {
         nebd::client::NebdFileService_Stub stub(&channel_);
         nebd::client::ReadRequest request;
@@ -362,6 +398,14 @@ int NebdClient::AioRead(int fd, NebdClientAioContext* aioctx) {
 static void EmptyDeleter(void* m) {}
 
 int NebdClient::AioWrite(int fd, NebdClientAioContext* aioctx) {
+    if (SubmitByShm(fd, aioctx)) {
+        return 0;
+    }
+
+    return AioWriteByRpc(fd, aioctx);
+}
+
+int NebdClient::AioWriteByRpc(int fd, NebdClientAioContext* aioctx) {
     auto task = [this, fd, aioctx]() {
         nebd::client::NebdFileService_Stub stub(&channel_);
         nebd::client::WriteRequest request;
@@ -385,6 +429,14 @@ int NebdClient::AioWrite(int fd, NebdClientAioContext* aioctx) {
 }
 
 int NebdClient::Flush(int fd, NebdClientAioContext* aioctx) {
+    if (SubmitByShm(fd, aioctx)) {
+        return 0;
+    }
+
+    return FlushByRpc(fd, aioctx);
+}
+
+int NebdClient::FlushByRpc(int fd, NebdClientAioContext* aioctx) {
     auto task = [this, fd, aioctx]() {
         nebd::client::NebdFileService_Stub stub(&channel_);
         nebd::client::FlushRequest request;
@@ -535,6 +587,29 @@ int NebdClient::InitNebdClientOption(Configuration* conf) {
     LOG_IF(ERROR, ret != true) << "Load log.path failed";
     RETURN_IF_FALSE(ret);
 
+    // 共享内存通道的配置项都是可选的
+    ShmOption& shmOption = option_.shmOption;
+    LOG_IF(WARNING, !conf->GetBoolValue("shm.enable", &shmOption.enable))
+        << "Load shm.enable failed, current value is " << shmOption.enable;
+    LOG_IF(WARNING, !conf->GetStringValue("shm.dir", &shmOption.dir))
+        << "Load shm.dir failed, current value is " << shmOption.dir;
+    LOG_IF(WARNING,
+           !conf->GetUInt32Value("shm.queueDepth", &shmOption.queueDepth))
+        << "Load shm.queueDepth failed, current value is "
+        << shmOption.queueDepth;
+    LOG_IF(WARNING,
+           !conf->GetUInt32Value("shm.dataSizeMB", &shmOption.dataSizeMB))
+        << "Load shm.dataSizeMB failed, current value is "
+        << shmOption.dataSizeMB;
+    LOG_IF(WARNING,
+           !conf->GetUInt32Value("shm.blockSizeKB", &shmOption.blockSizeKB))
+        << "Load shm.blockSizeKB failed, current value is "
+        << shmOption.blockSizeKB;
+    LOG_IF(WARNING, !conf->GetUInt32Value("shm.serverTimeoutMs",
+                                          &shmOption.serverTimeoutMs))
+        << "Load shm.serverTimeoutMs failed, current value is "
+        << shmOption.serverTimeoutMs;
+
     return 0;
 }
 
@@ -600,6 +675,202 @@ int64_t NebdClient::ExecuteSyncRpc(RpcTask task) {
     return -1;
 }
 
+void NebdClient::SetupShmChannel(int fd) {
+    auto shmChannel = CreateShmChannel(fd);
+    if (shmChannel == nullptr) {
+        return;
+    }
+
+    WriteLockGuard lock(shmChannelsLock_);
+    shmChannels_[fd] = shmChannel;
+}
+
+std::shared_ptr<NebdShmChannel> NebdClient::CreateShmChannel(int fd) {
+    auto fallback = [this](int fd, NebdClientAioContext* aioctx) {
+        switch (aioctx->op) {
+            case LIBAIO_OP::LIBAIO_OP_READ:
+                AioReadByRpc(fd, aioctx);
+                break;
+            case LIBAIO_OP::LIBAIO_OP_WRITE:
+                AioWriteByRpc(fd, aioctx);
+                break;
+            case LIBAIO_OP::LIBAIO_OP_DISCARD:
+                DiscardByRpc(fd, aioctx);
+                break;
+            case LIBAIO_OP::LIBAIO_OP_FLUSH:
+                FlushByRpc(fd, aioctx);
+                break;
+            default:
+                LOG(ERROR) << "Unknown aio op: " << aioctx->op;
+                aioctx->ret = -1;
+                aioctx->cb(aioctx);
+                break;
+        }
+    };
+
+    auto fence = [this](int fd, uint64_t generation) -> int {
+        return DetachShm(fd, generation);
+    };
+
+    uint64_t generation = shmGeneration_.fetch_add(1) + 1;
+    auto shmChannel = std::make_shared<NebdShmChannel>(
+        fd, generation, option_.shmOption, fallback, fence);
+    if (shmChannel->Init() != 0) {
+        LOG(WARNING) << "Init shm channel failed, use rpc instead, fd = "
+                     << fd;
+        return nullptr;
+    }
+
+    auto task = [&](brpc::Controller* cntl,
+                    brpc::Channel* channel,
+                    bool* rpcFailed) -> int64_t {
+        NebdFileService_Stub stub(channel);
+        AttachShmRequest request;
+        AttachShmResponse response;
+
+        request.set_fd(fd);
+        request.set_pid(getpid());
+        request.set_generation(generation);
+        request.set_size(shmChannel->Size());
+        stub.AttachShm(cntl, &request, &response, nullptr);
+
+        *rpcFailed = cntl->Failed();
+        if (*rpcFailed) {
+            LOG(WARNING) << "AttachShm rpc failed, error = "
+                         << cntl->ErrorText()
+                         << ", log id = " << cntl->log_id();
+            return -1;
+        } else {
+            if (response.retcode() != RetCode::kOK) {
+                LOG(ERROR) << "AttachShm failed, "
+                           << "retcode = " << response.retcode()
+                           <<",  retmsg = " << response.retmsg()
+                           << ", fd = " << fd
+                           << ", log id = " << cntl->log_id();
+                return -1;
+            }
+
+            return 0;
+        }
+    };
+
+    int64_t ret = ExecuteSyncRpc(task);
+    if (ret < 0) {
+        LOG(WARNING) << "Attach shm channel failed, use rpc instead, fd = "
+                     << fd;
+        shmChannel->Fini();
+        return nullptr;
+    }
+
+    // part2已经映射，文件不再需要
+    nebd::common::ShmRing::Unlink(shmChannel->Path());
+    return shmChannel;
+}
+
+int NebdClient::DetachShm(int fd, uint64_t generation) {
+    auto task = [&](brpc::Controller* cntl,
+                    brpc::Channel* channel,
+                    bool* rpcFailed) -> int64_t {
+        NebdFileService_Stub stub(channel);
+        DetachShmRequest request;
+        DetachShmResponse response;
+
+        request.set_fd(fd);
+        request.set_generation(generation);
+        stub.DetachShm(cntl, &request, &response, nullptr);
+
+        *rpcFailed = cntl->Failed();
+        if (*rpcFailed) {
+            LOG(WARNING) << "DetachShm rpc failed, error = "
+                         << cntl->ErrorText()
+                         << ", log id = " << cntl->log_id();
+            return -1;
+        } else {
+            if (response.retcode() != RetCode::kOK) {
+                LOG(ERROR) << "DetachShm failed, "
+                           << "retcode = " << response.retcode()
+                           <<",  retmsg = " << response.retmsg()
+                           << ", fd = " << fd
+                           << ", log id = " << cntl->log_id();
+                return -1;
+            }
+
+            return 0;
+        }
+    };
+
+    return ExecuteSyncRpc(task);
+}
+
+struct ReattachShmArg {
+    NebdClient* client;
+    int fd;
+    std::shared_ptr<NebdShmChannel> old;
+};
+
+void* NebdClient::ReattachShmChannel(void* arg) {
+    std::unique_ptr<ReattachShmArg> reattachArg(
+        static_cast<ReattachShmArg*>(arg));
+    NebdClient* client = reattachArg->client;
+    int fd = reattachArg->fd;
+    auto old = reattachArg->old;
+
+    auto shmChannel = client->CreateShmChannel(fd);
+    if (shmChannel == nullptr) {
+        old->ReattachFailed();
+        return nullptr;
+    }
+
+    bool replaced = false;
+    {
+        WriteLockGuard lock(client->shmChannelsLock_);
+        auto iter = client->shmChannels_.find(fd);
+        // 文件在重建期间被关闭时不再使用新通道
+        if (iter != client->shmChannels_.end() && iter->second == old) {
+            iter->second = shmChannel;
+            replaced = true;
+        }
+    }
+
+    if (replaced) {
+        LOG(INFO) << "Reattach shm channel success, fd = " << fd
+                  << ", generation = " << shmChannel->Generation();
+        old->Fini();
+    } else {
+        shmChannel->Fini();
+    }
+    return nullptr;
+}
+
+bool NebdClient::SubmitByShm(int fd, NebdClientAioContext* aioctx) {
+    std::shared_ptr<NebdShmChannel> shmChannel;
+    {
+        ReadLockGuard lock(shmChannelsLock_);
+        auto iter = shmChannels_.find(fd);
+        if (iter == shmChannels_.end()) {
+            return false;
+        }
+        shmChannel = iter->second;
+    }
+
+    if (shmChannel->Submit(aioctx)) {
+        return true;
+    }
+
+    // part2停止处理旧通道后(例如part2重启)，在后台重建通道
+    if (shmChannel->TryStartReattach()) {
+        auto* arg = new ReattachShmArg{this, fd, shmChannel};
+        bthread_t tid;
+        if (bthread_start_background(&tid, nullptr, ReattachShmChannel,
+                                     arg) != 0) {
+            LOG(ERROR) << "Start reattach shm channel failed, fd = " << fd;
+            delete arg;
+            shmChannel->ReattachFailed();
+        }
+    }
+    return false;
+}
+
 std::string NebdClient::ReplaceSlash(const std::string& str) {
     std::string ret(str);
     for (auto& ch : ret) {
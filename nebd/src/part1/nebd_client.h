@@ -29,6 +29,7 @@
 #include <functional>
 #include <string>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "nebd/src/part1/nebd_common.h"
@@ -37,6 +38,8 @@
 #include "nebd/src/part1/libnebd.h"
 #include "nebd/src/part1/heartbeat_manager.h"
 #include "nebd/src/part1/nebd_metacache.h"
+#include "nebd/src/part1/shm_channel.h"
+#include "nebd/src/common/rw_lock.h"
 
 #include "include/curve_compiler_specific.h"
 
@@ -165,6 +168,42 @@ class NebdClient {
     std::string ReplaceSlash(const std::string& str);
 
     int64_t ExecuteSyncRpc(RpcTask task);
+
+    /**
+     * @brief 为打开的文件创建共享内存通道，并通知part2映射
+     *        失败时该文件的读写请求仍然走rpc
+     */
+    void SetupShmChannel(int fd);
+
+    /**
+     * @brief 创建共享内存通道并通知part2映射
+     * @return 成功返回新的通道，失败返回nullptr
+     */
+    std::shared_ptr<NebdShmChannel> CreateShmChannel(int fd);
+
+    /**
+     * @brief 通知part2停止处理指定版本的共享内存通道
+     *        part2停止消费提交队列并且已提交的请求都返回之后rpc才返回
+     * @return 成功返回0，失败返回-1
+     */
+    int DetachShm(int fd, uint64_t generation);
+
+    // 在后台重建已经失效的共享内存通道，由bthread执行
+    static void* ReattachShmChannel(void* arg);
+
+    /**
+     * @brief 尝试通过共享内存通道提交异步请求
+     *        通道失效并且part2已经停止处理时，在后台重建通道
+     * @return 提交成功返回true，否则由调用者走rpc
+     */
+    bool SubmitByShm(int fd, NebdClientAioContext* aioctx);
+
+    // 以下函数直接通过rpc发送异步请求，不经过共享内存通道
+    int DiscardByRpc(int fd, NebdClientAioContext* aioctx);
+    int AioReadByRpc(int fd, NebdClientAioContext* aioctx);
+    int AioWriteByRpc(int fd, NebdClientAioContext* aioctx);
+    int FlushByRpc(int fd, NebdClientAioContext* aioctx);
+
     // 心跳管理模块
     std::shared_ptr<HeartbeatManager> heartbeatMgr_;
     // 缓存模块
@@ -176,6 +215,12 @@ class NebdClient {
 
     std::atomic<uint64_t> logId_{1};
 
+    // 每个文件的共享内存通道
+    nebd::common::RWLock shmChannelsLock_;
+    std::unordered_map<int, std::shared_ptr<NebdShmChannel>> shmChannels_;
+    // 共享内存通道的版本，每次创建通道时递增
+    std::atomic<uint64_t> shmGeneration_{0};
+
  private:
     using AsyncRpcTask = std::function<void()>;
 
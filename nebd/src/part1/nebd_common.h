@@ -49,6 +49,22 @@ struct LogOption {
     std::string logPath;
 };
 
+// 共享内存io通道配置项
+struct ShmOption {
+    // 是否通过共享内存与part2传输读写请求
+    bool enable = false;
+    // 共享内存文件所在目录
+    std::string dir = "/dev/shm";
+    // 提交队列和完成队列的深度，需要是2的幂
+    uint32_t queueDepth = 256;
+    // 数据区大小
+    uint32_t dataSizeMB = 64;
+    // 数据区的分配粒度
+    uint32_t blockSizeKB = 64;
+    // part2心跳超时后，未完成的请求改为通过rpc发送，也是重建通道的间隔
+    uint32_t serverTimeoutMs = 10000;
+};
+
 // nebd client配置项
 struct NebdClientOption {
     // part2 socket file address
@@ -59,6 +75,8 @@ struct NebdClientOption {
     RequestOption requestOption;
     // 日志配置项
     LogOption logOption;
+    // 共享内存io通道配置项
+    ShmOption shmOption;
 };
 
 // heartbeat配置项
@@ -0,0 +1,324 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ * Created Date: 2022-01-14
+ */
+
+#include "nebd/src/part1/shm_channel.h"
+
+#include <glog/logging.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace nebd {
+namespace client {
+
+using nebd::common::ShmIoCompletion;
+using nebd::common::ShmIoRequest;
+using nebd::common::ShmRing;
+
+// 完成线程每次等待的最长时间，同时也是检查part2心跳的周期
+const uint32_t kCompletionWaitMs = 100;
+
+NebdShmChannel::NebdShmChannel(int fd, uint64_t generation,
+                               const ShmOption& option,
+                               const ShmFallbackFunc& fallback,
+                               const ShmFenceFunc& fence)
+    : fd_(fd),
+      generation_(generation),
+      option_(option),
+      fallback_(fallback),
+      fence_(fence),
+      broken_(false),
+      fenced_(false),
+      fencedMs_(0),
+      reattaching_(false),
+      nextId_(0),
+      blockSize_(static_cast<uint64_t>(option.blockSizeKB) * 1024),
+      nextBlock_(0),
+      running_(false) {}
+
+NebdShmChannel::~NebdShmChannel() {
+    Fini();
+}
+
+int NebdShmChannel::Init() {
+    if (option_.blockSizeKB == 0 || option_.dataSizeMB == 0 ||
+        option_.dataSizeMB * 1024ULL < option_.blockSizeKB) {
+        LOG(ERROR) << "Invalid shm option, dataSizeMB: " << option_.dataSizeMB
+                   << ", blockSizeKB: " << option_.blockSizeKB;
+        return -1;
+    }
+
+    path_ = ShmRing::MakePath(option_.dir, getpid(), fd_, generation_);
+    // 同名文件只可能是之前同pid的进程残留的
+    ShmRing::Unlink(path_);
+
+    uint64_t dataSize = static_cast<uint64_t>(option_.dataSizeMB) << 20;
+    if (ring_.Create(path_, option_.queueDepth, dataSize) != 0) {
+        LOG(ERROR) << "Create shm ring failed, fd: " << fd_
+                   << ", path: " << path_;
+        return -1;
+    }
+
+    blockUsed_.assign(ring_.DataSize() / blockSize_, false);
+    running_ = true;
+    completionThread_ = std::thread(&NebdShmChannel::CompletionLoop, this);
+
+    LOG(INFO) << "Init shm channel success, fd: " << fd_
+              << ", generation: " << generation_
+              << ", path: " << path_ << ", size: " << ring_.Size();
+    return 0;
+}
+
+void NebdShmChannel::Fini() {
+    if (running_.exchange(false)) {
+        completionThread_.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        LOG_IF(WARNING, !inflight_.empty())
+            << "Shm channel has " << inflight_.size()
+            << " inflight requests when fini, fd: " << fd_;
+        broken_ = true;
+    }
+
+    if (!path_.empty()) {
+        ShmRing::Unlink(path_);
+    }
+    ring_.Detach();
+}
+
+bool NebdShmChannel::Submit(NebdClientAioContext* aioctx) {
+    bool hasData = aioctx->op == LIBAIO_OP::LIBAIO_OP_READ ||
+                   aioctx->op == LIBAIO_OP::LIBAIO_OP_WRITE;
+    uint32_t blocks = 0;
+    if (hasData) {
+        if (aioctx->length == 0 || aioctx->length > ring_.DataSize()) {
+            return false;
+        }
+        blocks = (aioctx->length + blockSize_ - 1) / blockSize_;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (broken_ || inflight_.size() >= ring_.QueueDepth()) {
+        return false;
+    }
+
+    uint64_t dataOffset = 0;
+    if (blocks > 0 && !AllocBlocks(blocks, &dataOffset)) {
+        return false;
+    }
+
+    if (aioctx->op == LIBAIO_OP::LIBAIO_OP_WRITE) {
+        memcpy(ring_.Data(dataOffset), aioctx->buf, aioctx->length);
+    }
+
+    ShmIoRequest request;
+    request.id = nextId_++;
+    request.op = aioctx->op;
+    request.reserved = 0;
+    request.offset = aioctx->offset;
+    request.length = aioctx->length;
+    request.dataOffset = dataOffset;
+    if (!ring_.PushRequest(request)) {
+        FreeBlocks(dataOffset, blocks);
+        return false;
+    }
+
+    inflight_.emplace(request.id, InflightRequest{aioctx, dataOffset, blocks});
+    return true;
+}
+
+void NebdShmChannel::CompletionLoop() {
+    ShmIoCompletion completion;
+    while (running_) {
+        while (ring_.PopCompletion(&completion)) {
+            OnCompletion(completion);
+        }
+
+        CheckServerAlive();
+        ring_.WaitCompletion(kCompletionWaitMs);
+    }
+}
+
+void NebdShmChannel::OnCompletion(const ShmIoCompletion& completion) {
+    InflightRequest request;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto iter = inflight_.find(completion.id);
+        if (iter == inflight_.end()) {
+            LOG(WARNING) << "Shm completion not found, fd: " << fd_
+                         << ", id: " << completion.id;
+            return;
+        }
+        request = iter->second;
+        inflight_.erase(iter);
+    }
+
+    NebdClientAioContext* aioctx = request.aioctx;
+    if (aioctx->op == LIBAIO_OP::LIBAIO_OP_READ && completion.ret >= 0) {
+        memcpy(aioctx->buf, ring_.Data(request.dataOffset), aioctx->length);
+    }
+
+    if (request.blocks > 0) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        FreeBlocks(request.dataOffset, request.blocks);
+    }
+
+    if (completion.ret == nebd::common::kShmRetryByRpc) {
+        // part2已经处理完该请求，直接改为rpc发送
+        LOG(WARNING) << "Shm request is returned to rpc, fd: " << fd_
+                     << ", op: " << aioctx->op
+                     << ", offset: " << aioctx->offset
+                     << ", length: " << aioctx->length;
+        fallback_(fd_, aioctx);
+        return;
+    }
+
+    LOG_IF(ERROR, completion.ret < 0)
+        << "Shm request failed, fd: " << fd_ << ", op: " << aioctx->op
+        << ", offset: " << aioctx->offset << ", length: " << aioctx->length
+        << ", ret: " << completion.ret;
+    aioctx->ret = completion.ret < 0 ? -1 : 0;
+    aioctx->cb(aioctx);
+}
+
+void NebdShmChannel::CheckServerAlive() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (fenced_) {
+            return;
+        }
+
+        if (!broken_) {
+            if (inflight_.empty()) {
+                return;
+            }
+
+            uint64_t heartbeatMs = ring_.ServerHeartbeatMs();
+            if (ShmRing::NowMs() < heartbeatMs + option_.serverTimeoutMs) {
+                return;
+            }
+
+            broken_ = true;
+            LOG(ERROR) << "Part2 heartbeat timeout, stop using shm channel, "
+                       << "fd: " << fd_ << ", generation: " << generation_
+                       << ", inflight: " << inflight_.size();
+        }
+    }
+
+    // part2可能只是处理变慢，还在消费提交队列，
+    // 必须等part2确认停止处理后才能重发，否则旧的写请求可能覆盖新数据
+    if (fence_(fd_, generation_) != 0) {
+        LOG(WARNING) << "Fence shm channel failed, retry later, fd: " << fd_
+                     << ", generation: " << generation_;
+        return;
+    }
+
+    // part2停止之前完成的请求已经放入完成队列
+    ShmIoCompletion completion;
+    while (ring_.PopCompletion(&completion)) {
+        OnCompletion(completion);
+    }
+
+    std::vector<NebdClientAioContext*> pending;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (const auto& item : inflight_) {
+            pending.push_back(item.second.aioctx);
+        }
+        inflight_.clear();
+        fenced_ = true;
+        fencedMs_ = ShmRing::NowMs();
+    }
+
+    LOG(ERROR) << "Shm channel is fenced, resend " << pending.size()
+               << " inflight requests by rpc, fd: " << fd_
+               << ", generation: " << generation_ << ", path: " << path_;
+    for (auto* aioctx : pending) {
+        fallback_(fd_, aioctx);
+    }
+}
+
+bool NebdShmChannel::Fenced() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return fenced_;
+}
+
+bool NebdShmChannel::TryStartReattach() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!fenced_ || reattaching_ ||
+        ShmRing::NowMs() < fencedMs_ + option_.serverTimeoutMs) {
+        return false;
+    }
+
+    reattaching_ = true;
+    return true;
+}
+
+void NebdShmChannel::ReattachFailed() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    reattaching_ = false;
+    fencedMs_ = ShmRing::NowMs();
+}
+
+bool NebdShmChannel::AllocBlocks(uint32_t count, uint64_t* dataOffset) {
+    uint32_t total = blockUsed_.size();
+    if (count > total) {
+        return false;
+    }
+
+    // 从上次分配的位置开始查找连续的空闲block，到末尾后回绕
+    uint32_t start = nextBlock_ + count <= total ? nextBlock_ : 0;
+    for (uint32_t scanned = 0; scanned < total;) {
+        uint32_t free = 0;
+        while (free < count && !blockUsed_[start + free]) {
+            ++free;
+        }
+
+        if (free == count) {
+            for (uint32_t i = 0; i < count; ++i) {
+                blockUsed_[start + i] = true;
+            }
+            nextBlock_ = (start + count) % total;
+            *dataOffset = static_cast<uint64_t>(start) * blockSize_;
+            return true;
+        }
+
+        scanned += free + 1;
+        start += free + 1;
+        if (start + count > total) {
+            scanned += total - start;
+            start = 0;
+        }
+    }
+
+    return false;
+}
+
+void NebdShmChannel::FreeBlocks(uint64_t dataOffset, uint32_t count) {
+    uint32_t start = dataOffset / blockSize_;
+    for (uint32_t i = 0; i < count; ++i) {
+        blockUsed_[start + i] = false;
+    }
+}
+
+}  // namespace client
+}  // namespace nebd
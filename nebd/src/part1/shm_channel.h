@@ -0,0 +1,152 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ * Created Date: 2022-01-14
+ */
+
+#ifndef NEBD_SRC_PART1_SHM_CHANNEL_H_
+#define NEBD_SRC_PART1_SHM_CHANNEL_H_
+
+#include <atomic>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "nebd/src/common/shm_ring.h"
+#include "nebd/src/part1/libnebd.h"
+#include "nebd/src/part1/nebd_common.h"
+
+namespace nebd {
+namespace client {
+
+// 共享内存通道不可用时，通过该函数把请求改为rpc发送
+using ShmFallbackFunc = std::function<void(int fd, NebdClientAioContext*)>;
+// 通知part2停止处理指定版本的通道，part2确认之后返回0
+using ShmFenceFunc = std::function<int(int fd, uint64_t generation)>;
+
+/**
+ * 单个文件的共享内存io通道。
+ * 读写请求的数据拷贝到共享内存数据区中，请求本身通过提交队列发给part2，
+ * 完成线程从完成队列中取出结果并回调。
+ * 通道一旦发现part2失去响应就不再接收新请求；part2确认停止处理该通道后，
+ * 未完成的请求才改为rpc发送，避免part2之后处理的旧写请求覆盖新数据。
+ */
+class NebdShmChannel {
+ public:
+    NebdShmChannel(int fd, uint64_t generation, const ShmOption& option,
+                   const ShmFallbackFunc& fallback,
+                   const ShmFenceFunc& fence);
+
+    ~NebdShmChannel();
+
+    /**
+     * @brief 创建共享内存并启动完成线程
+     * @return 成功返回0，失败返回-1
+     */
+    int Init();
+
+    /**
+     * @brief 停止完成线程并解除映射
+     */
+    void Fini();
+
+    /**
+     * @brief 通过共享内存提交异步请求
+     * @return 提交成功返回true；通道不可用或者资源不足时返回false，
+     *         由调用者改为rpc发送
+     */
+    bool Submit(NebdClientAioContext* aioctx);
+
+    // 共享内存文件路径，part2根据pid、fd和generation生成相同的路径映射
+    const std::string& Path() const {
+        return path_;
+    }
+
+    uint64_t Size() const {
+        return ring_.Size();
+    }
+
+    uint64_t Generation() const {
+        return generation_;
+    }
+
+    /**
+     * @brief 通道已经失效并且part2已经停止处理时，判断是否可以重建通道
+     *        两次重建之间至少间隔serverTimeoutMs，同一时间只有一个调用者
+     *        返回true，重建失败时需要调用ReattachFailed
+     */
+    bool TryStartReattach();
+
+    void ReattachFailed();
+
+    // part2已经确认停止处理该通道，未完成的请求已改为rpc发送
+    bool Fenced();
+
+ private:
+    struct InflightRequest {
+        NebdClientAioContext* aioctx;
+        uint64_t dataOffset;
+        uint32_t blocks;
+    };
+
+    void CompletionLoop();
+
+    void OnCompletion(const nebd::common::ShmIoCompletion& completion);
+
+    // 检查part2心跳，超时后等待part2停止处理通道，再将未完成的请求改为rpc发送
+    void CheckServerAlive();
+
+    // 在数据区中分配连续的block，调用者持有mtx_
+    bool AllocBlocks(uint32_t count, uint64_t* dataOffset);
+    void FreeBlocks(uint64_t dataOffset, uint32_t count);
+
+ private:
+    int fd_;
+    const uint64_t generation_;
+    ShmOption option_;
+    ShmFallbackFunc fallback_;
+    ShmFenceFunc fence_;
+    std::string path_;
+    nebd::common::ShmRing ring_;
+
+    std::mutex mtx_;
+    // part2失去响应后置为true，之后的请求都走rpc
+    bool broken_;
+    // part2确认停止处理通道后置为true
+    bool fenced_;
+    uint64_t fencedMs_;
+    bool reattaching_;
+    uint64_t nextId_;
+    std::unordered_map<uint64_t, InflightRequest> inflight_;
+
+    // 数据区按block分配
+    uint64_t blockSize_;
+    std::vector<bool> blockUsed_;
+    uint32_t nextBlock_;
+
+    std::atomic<bool> running_;
+    std::thread completionThread_;
+};
+
+}  // namespace client
+}  // namespace nebd
+
+#endif  // NEBD_SRC_PART1_SHM_CHANNEL_H_
@@ -96,6 +96,8 @@ struct NebdServerAioContext {
     RpcController* cntl = nullptr;
     // return rpc when io error
     bool returnRpcWhenIoError = false;
+    // buf指向连续内存而不是butil::IOBuf，共享内存通道的请求使用
+    bool rawBuffer = false;
 };
 
 struct NebdFileInfo {
@@ -122,6 +124,7 @@ const char HEARTBEATTIMEOUTSEC[] = "heartbeat.timeout.sec";
 const char HEARTBEATCHECKINTERVALMS[] = "heartbeat.check.interval.ms";
 const char CURVECLIENTCONFPATH[] = "curveclient.confPath";
 const char RESPONSERETURNRPCWHENIOERROR[] = "response.returnRpcWhenIoError";
+const char SHMDIR[] = "shm.dir";
 
 }  // namespace server
 }  // namespace nebd
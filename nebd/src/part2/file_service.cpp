@@ -301,24 +301,50 @@ void NebdFileServiceImpl::GetInfo(
     }
 }
 
+// 共享内存通道上已提交的请求都返回之后再关闭文件并返回rpc
+class CloseFileClosure : public google::protobuf::Closure {
+ public:
+    CloseFileClosure(std::shared_ptr<NebdFileManager> fileManager,
+                     const nebd::client::CloseFileRequest* request,
+                     nebd::client::CloseFileResponse* response,
+                     google::protobuf::Closure* done)
+        : fileManager_(fileManager),
+          request_(request),
+          response_(response),
+          done_(done) {}
+
+    void Run() override {
+        std::unique_ptr<CloseFileClosure> selfGuard(this);
+        brpc::ClosureGuard doneGuard(done_);
+        int rc = fileManager_->Close(request_->fd(), true);
+        if (rc < 0) {
+            LOG(ERROR) << "Close file failed. "
+                       << "fd: " << request_->fd()
+                       << ", return code: " << rc;
+        } else {
+            response_->set_retcode(RetCode::kOK);
+            LOG(INFO) << "Close file success. "
+                      << "fd: " << request_->fd();
+        }
+    }
+
+ private:
+    std::shared_ptr<NebdFileManager> fileManager_;
+    const nebd::client::CloseFileRequest* request_;
+    nebd::client::CloseFileResponse* response_;
+    google::protobuf::Closure* done_;
+};
+
 void NebdFileServiceImpl::CloseFile(
     google::protobuf::RpcController* cntl_base,
     const nebd::client::CloseFileRequest* request,
     nebd::client::CloseFileResponse* response,
     google::protobuf::Closure* done) {
-    brpc::ClosureGuard doneGuard(done);
     response->set_retcode(RetCode::kNoOK);
 
-    int rc = fileManager_->Close(request->fd(), true);
-    if (rc < 0) {
-        LOG(ERROR) << "Close file failed. "
-                   << "fd: " << request->fd()
-                   << ", return code: " << rc;
-    } else {
-        response->set_retcode(RetCode::kOK);
-        LOG(INFO) << "Close file success. "
-                  << "fd: " << request->fd();
-    }
+    // 先停止共享内存通道，避免关闭过程中还有新请求进来
+    shmManager_.Detach(request->fd(),
+        new CloseFileClosure(fileManager_, request, response, done));
 }
 
 void NebdFileServiceImpl::ResizeFile(
@@ -358,5 +384,43 @@ void NebdFileServiceImpl::InvalidateCache(
     }
 }
 
+void NebdFileServiceImpl::AttachShm(
+    google::protobuf::RpcController* cntl_base,
+    const nebd::client::AttachShmRequest* request,
+    nebd::client::AttachShmResponse* response,
+    google::protobuf::Closure* done) {
+    brpc::ClosureGuard doneGuard(done);
+    response->set_retcode(RetCode::kNoOK);
+
+    if (fileManager_->GetFileEntity(request->fd()) == nullptr) {
+        LOG(ERROR) << "Attach shm failed, file not exist. "
+                   << "fd: " << request->fd();
+        return;
+    }
+
+    int rc = shmManager_.Attach(request->fd(), request->pid(),
+                                request->generation(), request->size());
+    if (rc < 0) {
+        LOG(ERROR) << "Attach shm failed. "
+                   << "fd: " << request->fd()
+                   << ", pid: " << request->pid()
+                   << ", generation: " << request->generation()
+                   << ", size: " << request->size();
+    } else {
+        response->set_retcode(RetCode::kOK);
+    }
+}
+
+void NebdFileServiceImpl::DetachShm(
+    google::protobuf::RpcController* cntl_base,
+    const nebd::client::DetachShmRequest* request,
+    nebd::client::DetachShmResponse* response,
+    google::protobuf::Closure* done) {
+    // 文件已经关闭或者part2重启过时通道不存在，同样返回成功，
+    // 否则在通道上已提交的请求都返回之后才返回
+    response->set_retcode(RetCode::kOK);
+    shmManager_.Fence(request->fd(), request->generation(), done);
+}
+
 }  // namespace server
 }  // namespace nebd
@@ -31,6 +31,7 @@
 
 #include "nebd/proto/client.pb.h"
 #include "nebd/src/part2/file_manager.h"
+#include "nebd/src/part2/shm_server.h"
 
 namespace nebd {
 namespace server {
@@ -40,9 +41,13 @@ void NebdFileServiceCallback(NebdServerAioContext* context);
 class NebdFileServiceImpl : public nebd::client::NebdFileService {
  public:
     explicit NebdFileServiceImpl(std::shared_ptr<NebdFileManager> fileManager,
-                                 const bool returnRpcWhenIoError)
+                                 const bool returnRpcWhenIoError,
+                                 const std::string& shmDir = "/dev/shm")
                                  : fileManager_(fileManager),
-                                 returnRpcWhenIoError_(returnRpcWhenIoError) {}
+                                 returnRpcWhenIoError_(returnRpcWhenIoError),
+                                 shmManager_(fileManager,
+                                             returnRpcWhenIoError,
+                                             shmDir) {}
 
     virtual ~NebdFileServiceImpl() {}
 
@@ -91,9 +96,21 @@ class NebdFileServiceImpl : public nebd::client::NebdFileService {
                             nebd::client::InvalidateCacheResponse* response,
                             google::protobuf::Closure* done);
 
+    virtual void AttachShm(google::protobuf::RpcController* cntl_base,
+                           const nebd::client::AttachShmRequest* request,
+                           nebd::client::AttachShmResponse* response,
+                           google::protobuf::Closure* done);
+
+    virtual void DetachShm(google::protobuf::RpcController* cntl_base,
+                           const nebd::client::DetachShmRequest* request,
+                           nebd::client::DetachShmResponse* response,
+                           google::protobuf::Closure* done);
+
  private:
     std::shared_ptr<NebdFileManager> fileManager_;
     const bool returnRpcWhenIoError_;
+    // 各文件的共享内存io通道
+    NebdShmManager shmManager_;
 };
 
 }  // namespace server
@@ -219,7 +219,13 @@ bool NebdServer::StartServer() {
         return false;
     }
 
-    NebdFileServiceImpl fileService(fileManager_, returnRpcWhenIoError);
+    // 共享内存文件所在目录，需要与part1的配置一致
+    std::string shmDir = "/dev/shm";
+    LOG_IF(WARNING, !conf_.GetStringValue(SHMDIR, &shmDir))
+        << "get " << SHMDIR << " fail, use default value " << shmDir;
+
+    NebdFileServiceImpl fileService(fileManager_, returnRpcWhenIoError,
+                                    shmDir);
     int addFileServiceRes = server_.AddService(
         &fileService, brpc::SERVER_DOESNT_OWN_SERVICE);
     if (0 != addFileServiceRes) {
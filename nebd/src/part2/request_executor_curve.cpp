@@ -234,7 +234,9 @@ int CurveRequestExecutor::AioRead(
     }
 
     ret = client_->AioRead(curveFd, &curveCombineCtx->curveCtx,
-                           curve::client::UserDataType::IOBuffer);
+                           aioctx->rawBuffer
+                               ? curve::client::UserDataType::RawBuffer
+                               : curve::client::UserDataType::IOBuffer);
     if (ret !=  LIBCURVE_ERROR::OK) {
         delete curveCombineCtx;
         return -1;
@@ -259,7 +261,9 @@ int CurveRequestExecutor::AioWrite(
     }
 
     ret = client_->AioWrite(curveFd, &curveCombineCtx->curveCtx,
-                            curve::client::UserDataType::IOBuffer);
+                            aioctx->rawBuffer
+                                ? curve::client::UserDataType::RawBuffer
+                                : curve::client::UserDataType::IOBuffer);
     if (ret !=  LIBCURVE_ERROR::OK) {
         delete curveCombineCtx;
         return -1;
@@ -0,0 +1,387 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ * Created Date: 2022-01-14
+ */
+
+#include "nebd/src/part2/shm_server.h"
+
+#include <brpc/closure_guard.h>
+#include <bthread/bthread.h>
+#include <glog/logging.h>
+
+#include <chrono>  // NOLINT
+
+namespace nebd {
+namespace server {
+
+using nebd::common::ShmIoCompletion;
+using nebd::common::ShmIoRequest;
+
+// 提交队列为空时每次等待的最长时间
+const uint32_t kPollWaitMs = 100;
+// 更新part2心跳的周期
+const uint32_t kHeartbeatIntervalMs = 100;
+
+// 共享内存通道上的请求上下文，回调中据此找到所属的通道
+struct ShmAioContext : public NebdServerAioContext {
+    std::shared_ptr<NebdShmServer> server;
+    uint64_t id = 0;
+};
+
+static void* RunDetachDones(void* arg) {
+    std::unique_ptr<std::vector<Closure*>> dones(
+        static_cast<std::vector<Closure*>*>(arg));
+    for (auto done : *dones) {
+        done->Run();
+    }
+    return nullptr;
+}
+
+NebdShmServer::NebdShmServer(int fd, uint64_t generation,
+                             std::shared_ptr<NebdFileManager> fileManager,
+                             bool returnRpcWhenIoError)
+    : fd_(fd),
+      generation_(generation),
+      fileManager_(fileManager),
+      returnRpcWhenIoError_(returnRpcWhenIoError),
+      inflight_(0),
+      running_(false),
+      detaching_(false),
+      polling_(false),
+      detached_(false) {}
+
+int NebdShmServer::Attach(const std::string& path, uint64_t size) {
+    if (ring_.Attach(path, size) != 0) {
+        LOG(ERROR) << "Attach shm failed, fd: " << fd_ << ", path: " << path;
+        return -1;
+    }
+
+    // part1在rpc返回后才开始检查心跳，这里先更新一次
+    ring_.UpdateServerHeartbeat();
+    running_ = true;
+    polling_ = true;
+    // 轮询线程持有通道的引用，退出时自行结束，关闭通道时不需要等待它
+    std::thread(&NebdShmServer::PollLoop, shared_from_this()).detach();
+
+    LOG(INFO) << "Attach shm success, fd: " << fd_ << ", path: " << path
+              << ", size: " << size;
+    return 0;
+}
+
+void NebdShmServer::Detach(Closure* done) {
+    running_ = false;
+    {
+        std::lock_guard<std::mutex> lock(detachMtx_);
+        detaching_ = true;
+        if (!detached_ && done != nullptr) {
+            detachDones_.push_back(done);
+            done = nullptr;
+        }
+    }
+    // 已经解除映射时直接执行
+    brpc::ClosureGuard doneGuard(done);
+
+    // 数据区还在被请求使用时，由最后返回的请求解除映射
+    FinishDetachIfDrained(false);
+}
+
+void NebdShmServer::UpdateHeartbeat() {
+    std::lock_guard<std::mutex> lock(detachMtx_);
+    if (!detaching_) {
+        ring_.UpdateServerHeartbeat();
+    }
+}
+
+void NebdShmServer::FinishDetachIfDrained(bool inCallback) {
+    std::unique_ptr<std::vector<Closure*>> dones(new std::vector<Closure*>());
+    {
+        std::lock_guard<std::mutex> lock(detachMtx_);
+        if (!detaching_ || polling_ || detached_ || inflight_.load() > 0) {
+            return;
+        }
+        ring_.Detach();
+        detached_ = true;
+        dones->swap(detachDones_);
+    }
+
+    LOG(INFO) << "Detach shm success, fd: " << fd_
+              << ", generation: " << generation_;
+    if (dones->empty()) {
+        return;
+    }
+
+    // done中可能会关闭文件，不能阻塞io的回调线程
+    if (inCallback) {
+        bthread_t tid;
+        if (bthread_start_background(&tid, nullptr, RunDetachDones,
+                                     dones.get()) == 0) {
+            dones.release();
+            return;
+        }
+        LOG(WARNING) << "Start bthread to run detach done failed, fd: "
+                     << fd_;
+    }
+    RunDetachDones(dones.release());
+}
+
+void NebdShmServer::PollLoop() {
+    ShmIoRequest request;
+    while (running_) {
+        bool busy = false;
+        while (running_ && ring_.PopRequest(&request)) {
+            ProcessRequest(request);
+            busy = true;
+        }
+
+        if (!busy) {
+            if (fileManager_->GetFileEntity(fd_) == nullptr) {
+                LOG(INFO) << "File is removed, stop polling shm, fd: " << fd_;
+                break;
+            }
+            ring_.WaitRequest(kPollWaitMs);
+        }
+    }
+
+    // 文件被删除时不会再有人关闭通道，同样在请求都返回后解除映射，
+    // 心跳随之停止，part1会切回rpc通道
+    running_ = false;
+    {
+        std::lock_guard<std::mutex> lock(detachMtx_);
+        polling_ = false;
+        detaching_ = true;
+    }
+    FinishDetachIfDrained(false);
+}
+
+void NebdShmServer::ProcessRequest(const ShmIoRequest& request) {
+    auto op = static_cast<LIBAIO_OP>(request.op);
+    bool hasData = op == LIBAIO_OP::LIBAIO_OP_READ ||
+                   op == LIBAIO_OP::LIBAIO_OP_WRITE;
+    uint64_t dataSize = ring_.DataSize();
+    // 请求来自另一个进程，越界的请求直接返回失败
+    bool valid = request.op < static_cast<uint32_t>(
+                                  LIBAIO_OP::LIBAIO_OP_UNKNOWN) &&
+                 (!hasData || (request.length > 0 &&
+                               request.length <= dataSize &&
+                               request.dataOffset <=
+                                   dataSize - request.length));
+    if (!valid) {
+        LOG(ERROR) << "Invalid shm request, fd: " << fd_
+                   << ", op: " << request.op
+                   << ", length: " << request.length
+                   << ", data offset: " << request.dataOffset;
+        Complete(request.id, -1);
+        return;
+    }
+
+    ShmAioContext* context = new ShmAioContext();
+    context->server = shared_from_this();
+    context->id = request.id;
+    context->offset = request.offset;
+    context->size = request.length;
+    context->op = op;
+    context->cb = ShmAioCallback;
+    context->returnRpcWhenIoError = returnRpcWhenIoError_;
+    context->rawBuffer = true;
+    if (hasData) {
+        context->buf = ring_.Data(request.dataOffset);
+    }
+
+    inflight_.fetch_add(1);
+    int rc = -1;
+    switch (op) {
+        case LIBAIO_OP::LIBAIO_OP_READ:
+            rc = fileManager_->AioRead(fd_, context);
+            break;
+        case LIBAIO_OP::LIBAIO_OP_WRITE:
+            rc = fileManager_->AioWrite(fd_, context);
+            break;
+        case LIBAIO_OP::LIBAIO_OP_DISCARD:
+            rc = fileManager_->Discard(fd_, context);
+            break;
+        case LIBAIO_OP::LIBAIO_OP_FLUSH:
+            rc = fileManager_->Flush(fd_, context);
+            break;
+        default:
+            break;
+    }
+
+    if (rc < 0) {
+        LOG(ERROR) << Op2Str(op) << " file failed. "
+                   << "fd: " << fd_
+                   << ", offset: " << request.offset
+                   << ", length: " << request.length
+                   << ", return code: " << rc;
+        delete context;
+        inflight_.fetch_sub(1);
+        Complete(request.id, -1);
+    }
+}
+
+void NebdShmServer::Complete(uint64_t id, int ret) {
+    ShmIoCompletion completion;
+    completion.id = id;
+    completion.ret = ret;
+    completion.reserved = 0;
+
+    std::lock_guard<std::mutex> lock(completionMtx_);
+    // part1保证未完成的请求数不超过队列深度，这里不会失败
+    if (!ring_.PushCompletion(completion)) {
+        LOG(ERROR) << "Push shm completion failed, fd: " << fd_
+                   << ", id: " << id;
+    }
+}
+
+void NebdShmServer::ShmAioCallback(NebdServerAioContext* context) {
+    CHECK(context != nullptr);
+    std::unique_ptr<ShmAioContext> shmContext(
+        static_cast<ShmAioContext*>(context));
+    NebdShmServer* server = shmContext->server.get();
+    {
+        // 释放文件的读锁，关闭文件需要等待读锁释放，所以在解除映射之前释放
+        brpc::ClosureGuard doneGuard(context->done);
+
+        if (context->ret < 0 && !context->returnRpcWhenIoError) {
+            // 与rpc通道保持一致，不向part1返回io错误；
+            // part1的共享内存通道没有超时，不能丢弃请求，交还给part1通过rpc重发
+            LOG(ERROR) << *context;
+            LOG(ERROR) << Op2Str(context->op)
+                       << " file failed and return the shm request to rpc.";
+            server->Complete(shmContext->id, nebd::common::kShmRetryByRpc);
+        } else {
+            LOG_IF(ERROR, context->ret < 0) << *context;
+            server->Complete(shmContext->id, context->ret < 0 ? -1 : 0);
+        }
+    }
+
+    if (server->inflight_.fetch_sub(1) == 1) {
+        server->FinishDetachIfDrained(true);
+    }
+}
+
+NebdShmManager::NebdShmManager(std::shared_ptr<NebdFileManager> fileManager,
+                               bool returnRpcWhenIoError,
+                               const std::string& shmDir)
+    : fileManager_(fileManager),
+      returnRpcWhenIoError_(returnRpcWhenIoError),
+      shmDir_(shmDir) {
+    heartbeatThread_ = std::thread(&NebdShmManager::HeartbeatLoop, this);
+}
+
+NebdShmManager::~NebdShmManager() {
+    sleeper_.interrupt();
+    heartbeatThread_.join();
+
+    std::unordered_map<int, std::shared_ptr<NebdShmServer>> servers;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        servers.swap(servers_);
+    }
+
+    for (auto& item : servers) {
+        item.second->Detach(nullptr);
+    }
+}
+
+void NebdShmManager::HeartbeatLoop() {
+    while (sleeper_.wait_for(std::chrono::milliseconds(kHeartbeatIntervalMs))) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (auto& item : servers_) {
+            item.second->UpdateHeartbeat();
+        }
+    }
+}
+
+int NebdShmManager::Attach(int fd, uint32_t pid, uint64_t generation,
+                           uint64_t size) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto iter = servers_.find(fd);
+        if (iter != servers_.end() &&
+            iter->second->Generation() >= generation) {
+            LOG(ERROR) << "Attach stale shm channel, fd: " << fd
+                       << ", generation: " << generation
+                       << ", current generation: "
+                       << iter->second->Generation();
+            return -1;
+        }
+    }
+
+    std::string path =
+        nebd::common::ShmRing::MakePath(shmDir_, pid, fd, generation);
+    auto server = std::make_shared<NebdShmServer>(
+        fd, generation, fileManager_, returnRpcWhenIoError_);
+    if (server->Attach(path, size) != 0) {
+        return -1;
+    }
+
+    std::shared_ptr<NebdShmServer> old;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        old = servers_[fd];
+        servers_[fd] = server;
+    }
+
+    if (old != nullptr) {
+        LOG(INFO) << "Replace shm channel of fd: " << fd
+                  << ", old generation: " << old->Generation()
+                  << ", new generation: " << generation;
+        old->Detach(nullptr);
+    }
+    return 0;
+}
+
+void NebdShmManager::Detach(int fd, Closure* done) {
+    brpc::ClosureGuard doneGuard(done);
+    std::shared_ptr<NebdShmServer> server;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto iter = servers_.find(fd);
+        if (iter == servers_.end()) {
+            return;
+        }
+        server = iter->second;
+        servers_.erase(iter);
+    }
+
+    server->Detach(doneGuard.release());
+}
+
+void NebdShmManager::Fence(int fd, uint64_t generation, Closure* done) {
+    brpc::ClosureGuard doneGuard(done);
+    std::shared_ptr<NebdShmServer> server;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto iter = servers_.find(fd);
+        if (iter == servers_.end() ||
+            iter->second->Generation() != generation) {
+            return;
+        }
+        server = iter->second;
+        servers_.erase(iter);
+    }
+
+    // 不阻塞rpc，轮询线程退出且已提交的请求都返回后执行done
+    LOG(INFO) << "Fence shm channel, fd: " << fd
+              << ", generation: " << generation;
+    server->Detach(doneGuard.release());
+}
+
+}  // namespace server
+}  // namespace nebd
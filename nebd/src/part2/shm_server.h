@@ -0,0 +1,166 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ * Created Date: 2022-01-14
+ */
+
+#ifndef NEBD_SRC_PART2_SHM_SERVER_H_
+#define NEBD_SRC_PART2_SHM_SERVER_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "nebd/src/common/interrupt_sleep.h"
+#include "nebd/src/common/shm_ring.h"
+#include "nebd/src/part2/file_manager.h"
+
+namespace nebd {
+namespace server {
+
+/**
+ * 处理单个文件共享内存通道上的请求。
+ * 轮询线程从提交队列中取出请求，buf直接指向共享内存数据区，
+ * 请求完成后将结果放入完成队列。
+ * 轮询线程和未返回的请求都持有通道的引用，通道在它们都结束后才析构。
+ */
+class NebdShmServer : public std::enable_shared_from_this<NebdShmServer> {
+ public:
+    NebdShmServer(int fd, uint64_t generation,
+                  std::shared_ptr<NebdFileManager> fileManager,
+                  bool returnRpcWhenIoError);
+
+    /**
+     * @brief 映射part1创建的共享内存并启动轮询线程
+     * @return 成功返回0，失败返回-1
+     */
+    int Attach(const std::string& path, uint64_t size);
+
+    /**
+     * @brief 停止消费提交队列，已提交的请求都返回后解除映射，不阻塞调用者
+     * @param done 解除映射之后执行，为nullptr时不通知
+     */
+    void Detach(Closure* done);
+
+    /**
+     * @brief 更新part2的心跳，由管理者的定时器调用，
+     *        与轮询线程独立，提交请求较慢时心跳也不会中断
+     */
+    void UpdateHeartbeat();
+
+    uint64_t Generation() const {
+        return generation_;
+    }
+
+ private:
+    void PollLoop();
+
+    void ProcessRequest(const nebd::common::ShmIoRequest& request);
+
+    void Complete(uint64_t id, int ret);
+
+    /**
+     * @brief 轮询线程已退出且已提交的请求都返回时解除映射并执行done
+     * @param inCallback 是否在io回调中调用，回调中的done放到bthread中执行
+     */
+    void FinishDetachIfDrained(bool inCallback);
+
+    static void ShmAioCallback(NebdServerAioContext* context);
+
+ private:
+    int fd_;
+    const uint64_t generation_;
+    std::shared_ptr<NebdFileManager> fileManager_;
+    const bool returnRpcWhenIoError_;
+    nebd::common::ShmRing ring_;
+
+    // 完成队列是单生产者的，多个回调并发完成时需要加锁
+    std::mutex completionMtx_;
+    // 已经提交还未返回的请求数
+    std::atomic<uint32_t> inflight_;
+
+    std::atomic<bool> running_;
+
+    // 保护下面的关闭状态
+    std::mutex detachMtx_;
+    // 是否已经开始关闭，开始关闭后不再更新心跳
+    bool detaching_;
+    // 轮询线程是否还在运行
+    bool polling_;
+    // 是否已经解除映射
+    bool detached_;
+    // 解除映射后需要执行的done
+    std::vector<Closure*> detachDones_;
+};
+
+// 管理所有文件的共享内存通道
+class NebdShmManager {
+ public:
+    NebdShmManager(std::shared_ptr<NebdFileManager> fileManager,
+                   bool returnRpcWhenIoError, const std::string& shmDir);
+
+    ~NebdShmManager();
+
+    /**
+     * @brief 为文件建立共享内存通道，已有的旧版本通道会被替换
+     *        共享内存文件路径由part2根据配置的目录生成
+     * @param fd 文件的fd
+     * @param pid part1的进程号
+     * @param generation 通道的版本
+     * @param size 共享内存的大小
+     * @return 成功返回0，失败返回-1
+     */
+    int Attach(int fd, uint32_t pid, uint64_t generation, uint64_t size);
+
+    /**
+     * @brief 关闭文件的共享内存通道，文件没有通道时直接执行done
+     * @param done 通道上已提交的请求都返回后执行，可以为nullptr
+     */
+    void Detach(int fd, Closure* done);
+
+    /**
+     * @brief part1重发通道上的请求之前调用，关闭指定版本的通道
+     *        done执行时part2已经停止消费提交队列，且已提交的请求都已返回，
+     *        通道不存在或者已经被新版本替换时直接执行done
+     */
+    void Fence(int fd, uint64_t generation, Closure* done);
+
+ private:
+    // 定期更新所有通道的心跳
+    void HeartbeatLoop();
+
+ private:
+    std::shared_ptr<NebdFileManager> fileManager_;
+    const bool returnRpcWhenIoError_;
+    const std::string shmDir_;
+
+    std::mutex mtx_;
+    std::unordered_map<int, std::shared_ptr<NebdShmServer>> servers_;
+
+    std::thread heartbeatThread_;
+    nebd::common::InterruptibleSleeper sleeper_;
+};
+
+}  // namespace server
+}  // namespace nebd
+
+#endif  // NEBD_SRC_PART2_SHM_SERVER_H_
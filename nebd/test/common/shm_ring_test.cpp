@@ -0,0 +1,147 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ * Created Date: 2022-01-14
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <thread>  // NOLINT
+
+#include "nebd/src/common/shm_ring.h"
+
+#define SHM_PATH "/tmp/shm_ring_test"
+
+namespace nebd {
+namespace common {
+
+class ShmRingTest : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        ShmRing::Unlink(SHM_PATH);
+    }
+
+    void TearDown() override {
+        ShmRing::Unlink(SHM_PATH);
+    }
+};
+
+TEST_F(ShmRingTest, CreateAndAttachTest) {
+    ShmRing client;
+    // 队列深度必须是2的幂
+    ASSERT_EQ(-1, client.Create(SHM_PATH, 100, 1024 * 1024));
+    ASSERT_EQ(0, client.Create(SHM_PATH, 128, 1024 * 1024));
+    ASSERT_EQ(128, client.QueueDepth());
+    ASSERT_EQ(1024 * 1024, client.DataSize());
+    // 文件已经存在
+    ShmRing other;
+    ASSERT_EQ(-1, other.Create(SHM_PATH, 128, 1024 * 1024));
+
+    ShmRing server;
+    // 大小不一致
+    ASSERT_EQ(-1, server.Attach(SHM_PATH, client.Size() + 4096));
+    ASSERT_EQ(0, server.Attach(SHM_PATH, client.Size()));
+    ASSERT_EQ(128, server.QueueDepth());
+    ASSERT_EQ(client.DataSize(), server.DataSize());
+
+    // 数据区两边可见
+    memcpy(client.Data(4096), "nebd", 4);
+    ASSERT_EQ(0, memcmp(server.Data(4096), "nebd", 4));
+
+    server.UpdateServerHeartbeat();
+    ASSERT_GT(client.ServerHeartbeatMs(), 0);
+}
+
+TEST_F(ShmRingTest, PushAndPopTest) {
+    ShmRing client;
+    ShmRing server;
+    ASSERT_EQ(0, client.Create(SHM_PATH, 4, 4096));
+    ASSERT_EQ(0, server.Attach(SHM_PATH, client.Size()));
+
+    ShmIoRequest request;
+    ShmIoCompletion completion;
+    ASSERT_FALSE(server.PopRequest(&request));
+    ASSERT_FALSE(client.PopCompletion(&completion));
+
+    // 多轮push/pop，覆盖队列回绕的情况
+    uint64_t id = 0;
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 4; ++i) {
+            request.id = id + i;
+            request.op = 1;
+            request.offset = (id + i) * 4096;
+            request.length = 4096;
+            request.dataOffset = 0;
+            ASSERT_TRUE(client.PushRequest(request));
+        }
+        // 队列已满
+        ASSERT_FALSE(client.PushRequest(request));
+
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_TRUE(server.PopRequest(&request));
+            ASSERT_EQ(id + i, request.id);
+            ASSERT_EQ((id + i) * 4096, request.offset);
+
+            completion.id = request.id;
+            completion.ret = -i;
+            ASSERT_TRUE(server.PushCompletion(completion));
+        }
+        ASSERT_FALSE(server.PopRequest(&request));
+
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_TRUE(client.PopCompletion(&completion));
+            ASSERT_EQ(id + i, completion.id);
+            ASSERT_EQ(-i, completion.ret);
+        }
+        ASSERT_FALSE(client.PopCompletion(&completion));
+        id += 4;
+    }
+}
+
+TEST_F(ShmRingTest, WaitTest) {
+    ShmRing client;
+    ShmRing server;
+    ASSERT_EQ(0, client.Create(SHM_PATH, 16, 4096));
+    ASSERT_EQ(0, server.Attach(SHM_PATH, client.Size()));
+
+    // 队列为空时等待超时返回
+    uint64_t start = ShmRing::NowMs();
+    server.WaitRequest(100);
+    ASSERT_GE(ShmRing::NowMs() - start, 90);
+
+    // 生产者push后等待者被唤醒
+    std::thread producer([&client]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ShmIoRequest request;
+        request.id = 1;
+        client.PushRequest(request);
+    });
+
+    ShmIoRequest request;
+    start = ShmRing::NowMs();
+    while (!server.PopRequest(&request)) {
+        server.WaitRequest(5000);
+    }
+    ASSERT_LT(ShmRing::NowMs() - start, 5000);
+    ASSERT_EQ(1, request.id);
+    producer.join();
+}
+
+}  // namespace common
+}  // namespace nebd
@@ -0,0 +1,228 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ * Created Date: 2022-02-21
+ */
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "nebd/src/common/shm_ring.h"
+#include "nebd/src/part1/shm_channel.h"
+
+namespace nebd {
+namespace client {
+
+using nebd::common::kShmRetryByRpc;
+using nebd::common::ShmIoCompletion;
+using nebd::common::ShmIoRequest;
+using nebd::common::ShmRing;
+
+const int kFd = 1;
+const uint64_t kGeneration = 1;
+
+static std::atomic<int> aioFinished{0};
+
+static void AioCallback(NebdClientAioContext* aioctx) {
+    aioFinished.fetch_add(1);
+}
+
+class ShmChannelTest : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        aioFinished = 0;
+        fallbackCount_ = 0;
+        fenceCount_ = 0;
+        fenceRet_ = 0;
+
+        option_.enable = true;
+        option_.dir = "/tmp";
+        option_.queueDepth = 16;
+        option_.dataSizeMB = 1;
+        option_.blockSizeKB = 4;
+        option_.serverTimeoutMs = 200;
+
+        auto fallback = [this](int fd, NebdClientAioContext* aioctx) {
+            ASSERT_EQ(kFd, fd);
+            resent_.push_back(aioctx);
+            fallbackCount_.fetch_add(1);
+        };
+        auto fence = [this](int fd, uint64_t generation) -> int {
+            EXPECT_EQ(kFd, fd);
+            EXPECT_EQ(kGeneration, generation);
+            // 重发只能发生在part2确认停止处理之后
+            EXPECT_EQ(0, fallbackCount_.load());
+            fenceCount_.fetch_add(1);
+            if (onFence_) {
+                onFence_();
+            }
+            return fenceRet_.load();
+        };
+
+        channel_.reset(new NebdShmChannel(kFd, kGeneration, option_,
+                                          fallback, fence));
+        ASSERT_EQ(0, channel_->Init());
+        // 模拟part2，路径由pid、fd和generation生成
+        ASSERT_EQ(0, server_.Attach(ShmRing::MakePath(option_.dir, getpid(),
+                                                      kFd, kGeneration),
+                                    channel_->Size()));
+        server_.UpdateServerHeartbeat();
+    }
+
+    void TearDown() override {
+        channel_->Fini();
+        server_.Detach();
+    }
+
+    void InitAioContext(NebdClientAioContext* aioctx, off_t offset) {
+        aioctx->offset = offset;
+        aioctx->length = sizeof(buf_);
+        aioctx->ret = 0;
+        aioctx->op = LIBAIO_OP::LIBAIO_OP_WRITE;
+        aioctx->cb = AioCallback;
+        aioctx->buf = buf_;
+        aioctx->retryCount = 0;
+    }
+
+    template <typename Pred>
+    bool WaitFor(Pred pred, uint32_t timeoutMs = 5000) {
+        uint64_t start = ShmRing::NowMs();
+        while (!pred()) {
+            if (ShmRing::NowMs() - start > timeoutMs) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return true;
+    }
+
+ protected:
+    ShmOption option_;
+    std::unique_ptr<NebdShmChannel> channel_;
+    ShmRing server_;
+    char buf_[4096];
+
+    std::vector<NebdClientAioContext*> resent_;
+    std::atomic<int> fallbackCount_;
+    std::atomic<int> fenceCount_;
+    std::atomic<int> fenceRet_;
+    std::function<void()> onFence_;
+};
+
+TEST_F(ShmChannelTest, RetryByRpcTest) {
+    NebdClientAioContext aioctx;
+    InitAioContext(&aioctx, 0);
+    ASSERT_TRUE(channel_->Submit(&aioctx));
+
+    ShmIoRequest request;
+    ASSERT_TRUE(server_.PopRequest(&request));
+    ShmIoCompletion completion;
+    completion.id = request.id;
+    completion.ret = kShmRetryByRpc;
+    completion.reserved = 0;
+    ASSERT_TRUE(server_.PushCompletion(completion));
+
+    // 请求交还给rpc，不需要fence，通道继续可用
+    ASSERT_TRUE(WaitFor([this]() { return fallbackCount_.load() == 1; }));
+    ASSERT_EQ(&aioctx, resent_[0]);
+    ASSERT_EQ(0, aioFinished.load());
+    ASSERT_EQ(0, fenceCount_.load());
+    ASSERT_FALSE(channel_->Fenced());
+    ASSERT_TRUE(channel_->Submit(&aioctx));
+}
+
+TEST_F(ShmChannelTest, FenceBeforeResendTest) {
+    NebdClientAioContext aioctx1;
+    NebdClientAioContext aioctx2;
+    InitAioContext(&aioctx1, 0);
+    InitAioContext(&aioctx2, 4096);
+    ASSERT_TRUE(channel_->Submit(&aioctx1));
+    ASSERT_TRUE(channel_->Submit(&aioctx2));
+
+    ShmIoRequest request1;
+    ShmIoRequest request2;
+    ASSERT_TRUE(server_.PopRequest(&request1));
+    ASSERT_TRUE(server_.PopRequest(&request2));
+
+    // part2在fence返回之前处理完了第一个请求
+    onFence_ = [&]() {
+        ShmIoCompletion completion;
+        completion.id = request1.id;
+        completion.ret = 0;
+        completion.reserved = 0;
+        server_.PushCompletion(completion);
+    };
+
+    // 不再更新心跳，超时后先fence，再只重发未完成的请求
+    ASSERT_TRUE(WaitFor([this]() { return fallbackCount_.load() == 1; }));
+    ASSERT_EQ(1, fenceCount_.load());
+    ASSERT_EQ(1, aioFinished.load());
+    ASSERT_EQ(0, aioctx1.ret);
+    ASSERT_EQ(&aioctx2, resent_[0]);
+    ASSERT_TRUE(channel_->Fenced());
+
+    // 通道不再接收新请求
+    NebdClientAioContext aioctx3;
+    InitAioContext(&aioctx3, 8192);
+    ASSERT_FALSE(channel_->Submit(&aioctx3));
+}
+
+TEST_F(ShmChannelTest, FenceFailTest) {
+    NebdClientAioContext aioctx;
+    InitAioContext(&aioctx, 0);
+    ASSERT_TRUE(channel_->Submit(&aioctx));
+
+    // fence失败时不能重发，之后继续重试
+    fenceRet_ = -1;
+    ASSERT_TRUE(WaitFor([this]() { return fenceCount_.load() >= 2; }));
+    ASSERT_EQ(0, fallbackCount_.load());
+    ASSERT_FALSE(channel_->Fenced());
+
+    fenceRet_ = 0;
+    ASSERT_TRUE(WaitFor([this]() { return fallbackCount_.load() == 1; }));
+    ASSERT_EQ(&aioctx, resent_[0]);
+    ASSERT_TRUE(channel_->Fenced());
+}
+
+TEST_F(ShmChannelTest, ReattachTest) {
+    // 通道正常时不需要重建
+    ASSERT_FALSE(channel_->TryStartReattach());
+
+    NebdClientAioContext aioctx;
+    InitAioContext(&aioctx, 0);
+    ASSERT_TRUE(channel_->Submit(&aioctx));
+    ASSERT_TRUE(WaitFor([this]() { return channel_->Fenced(); }));
+
+    // fence之后至少间隔serverTimeoutMs才重建，同一时间只有一个调用者重建
+    ASSERT_FALSE(channel_->TryStartReattach());
+    ASSERT_TRUE(WaitFor([this]() { return channel_->TryStartReattach(); }));
+    ASSERT_FALSE(channel_->TryStartReattach());
+
+    // 重建失败后等待下一个周期
+    channel_->ReattachFailed();
+    ASSERT_FALSE(channel_->TryStartReattach());
+    ASSERT_TRUE(WaitFor([this]() { return channel_->TryStartReattach(); }));
+}
+
+}  // namespace client
+}  // namespace nebd
@@ -0,0 +1,280 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ * Created Date: 2022-02-21
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+
+#include "nebd/src/common/shm_ring.h"
+#include "nebd/src/part2/shm_server.h"
+#include "nebd/test/part2/mock_file_entity.h"
+#include "nebd/test/part2/mock_file_manager.h"
+
+namespace nebd {
+namespace server {
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::Return;
+
+using nebd::common::kShmRetryByRpc;
+using nebd::common::ShmIoCompletion;
+using nebd::common::ShmIoRequest;
+using nebd::common::ShmRing;
+
+const char kShmDir[] = "/tmp";
+const int kTestFd = 1;
+
+class ShmServerTestClosure : public Closure {
+ public:
+    void Run() override {
+        std::lock_guard<std::mutex> lock(mtx_);
+        runned_ = true;
+        cv_.notify_all();
+    }
+
+    bool WaitRunned(uint32_t timeoutMs) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        return cv_.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                            [this]() { return runned_; });
+    }
+
+ private:
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool runned_ = false;
+};
+
+class ShmServerTest : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        fileManager_ = std::make_shared<MockFileManager>();
+        ON_CALL(*fileManager_, GetFileEntity(kTestFd))
+            .WillByDefault(Return(std::make_shared<MockFileEntity>()));
+        EXPECT_CALL(*fileManager_, GetFileEntity(kTestFd))
+            .Times(::testing::AnyNumber());
+    }
+
+    void TearDown() override {
+        client_.Detach();
+        ShmRing::Unlink(Path(1));
+    }
+
+    std::string Path(uint64_t generation) {
+        return ShmRing::MakePath(kShmDir, getpid(), kTestFd, generation);
+    }
+
+    // 模拟part1创建共享内存
+    void CreateRing(uint64_t generation) {
+        ASSERT_EQ(0, client_.Create(Path(generation), 16, 64 * 1024));
+    }
+
+    void SubmitWrite(uint64_t id) {
+        ShmIoRequest request;
+        request.id = id;
+        request.op = static_cast<uint32_t>(LIBAIO_OP::LIBAIO_OP_WRITE);
+        request.reserved = 0;
+        request.offset = id * 4096;
+        request.length = 4096;
+        request.dataOffset = 0;
+        ASSERT_TRUE(client_.PushRequest(request));
+    }
+
+    bool WaitCompletion(ShmIoCompletion* completion) {
+        uint64_t start = ShmRing::NowMs();
+        while (!client_.PopCompletion(completion)) {
+            if (ShmRing::NowMs() - start > 5000) {
+                return false;
+            }
+            client_.WaitCompletion(100);
+        }
+        return true;
+    }
+
+ protected:
+    std::shared_ptr<MockFileManager> fileManager_;
+    ShmRing client_;
+};
+
+TEST_F(ShmServerTest, AttachTest) {
+    NebdShmManager manager(fileManager_, false, kShmDir);
+    CreateRing(1);
+
+    // 路径由part2根据pid、fd和generation生成，对应的文件不存在
+    ASSERT_EQ(-1, manager.Attach(kTestFd, getpid(), 2, client_.Size()));
+    ASSERT_EQ(0, manager.Attach(kTestFd, getpid(), 1, client_.Size()));
+    // 不能用旧版本替换已有的通道
+    ASSERT_EQ(-1, manager.Attach(kTestFd, getpid(), 1, client_.Size()));
+    manager.Detach(kTestFd, nullptr);
+}
+
+TEST_F(ShmServerTest, IoErrorTest) {
+    auto failWrite = [](int fd, NebdServerAioContext* context) {
+        context->ret = -1;
+        context->cb(context);
+        return 0;
+    };
+    EXPECT_CALL(*fileManager_, AioWrite(kTestFd, _))
+        .Times(2)
+        .WillRepeatedly(Invoke(failWrite));
+
+    // 不返回io错误时，请求交还给part1通过rpc重发，而不是丢弃
+    {
+        NebdShmManager manager(fileManager_, false, kShmDir);
+        CreateRing(1);
+        ASSERT_EQ(0, manager.Attach(kTestFd, getpid(), 1, client_.Size()));
+        SubmitWrite(100);
+
+        ShmIoCompletion completion;
+        ASSERT_TRUE(WaitCompletion(&completion));
+        ASSERT_EQ(100, completion.id);
+        ASSERT_EQ(kShmRetryByRpc, completion.ret);
+        manager.Detach(kTestFd, nullptr);
+        client_.Detach();
+        ShmRing::Unlink(Path(1));
+    }
+
+    // 返回io错误
+    {
+        NebdShmManager manager(fileManager_, true, kShmDir);
+        CreateRing(1);
+        ASSERT_EQ(0, manager.Attach(kTestFd, getpid(), 1, client_.Size()));
+        SubmitWrite(101);
+
+        ShmIoCompletion completion;
+        ASSERT_TRUE(WaitCompletion(&completion));
+        ASSERT_EQ(101, completion.id);
+        ASSERT_EQ(-1, completion.ret);
+        manager.Detach(kTestFd, nullptr);
+    }
+}
+
+TEST_F(ShmServerTest, FenceTest) {
+    NebdShmManager manager(fileManager_, false, kShmDir);
+    CreateRing(1);
+    ASSERT_EQ(0, manager.Attach(kTestFd, getpid(), 1, client_.Size()));
+
+    // 请求提交给文件之后一直没有返回
+    std::atomic<NebdServerAioContext*> pending{nullptr};
+    EXPECT_CALL(*fileManager_, AioWrite(kTestFd, _))
+        .Times(1)
+        .WillOnce(Invoke([&pending](int fd, NebdServerAioContext* context) {
+            pending = context;
+            return 0;
+        }));
+    SubmitWrite(100);
+    uint64_t start = ShmRing::NowMs();
+    while (pending.load() == nullptr && ShmRing::NowMs() - start < 5000) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_NE(nullptr, pending.load());
+
+    // 版本不一致的fence直接返回
+    ShmServerTestClosure staleDone;
+    manager.Fence(kTestFd, 2, &staleDone);
+    ASSERT_TRUE(staleDone.WaitRunned(0));
+
+    // fence不阻塞调用者，已提交的请求返回之后才执行done
+    ShmServerTestClosure fenceDone;
+    manager.Fence(kTestFd, 1, &fenceDone);
+    ASSERT_FALSE(fenceDone.WaitRunned(300));
+
+    NebdServerAioContext* context = pending.load();
+    context->ret = 0;
+    context->cb(context);
+    ASSERT_TRUE(fenceDone.WaitRunned(5000));
+
+    ShmIoCompletion completion;
+    ASSERT_TRUE(WaitCompletion(&completion));
+    ASSERT_EQ(100, completion.id);
+    ASSERT_EQ(0, completion.ret);
+
+    // fence之后part2不再消费提交队列
+    SubmitWrite(101);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ASSERT_FALSE(client_.PopCompletion(&completion));
+}
+
+TEST_F(ShmServerTest, HeartbeatTest) {
+    NebdShmManager manager(fileManager_, false, kShmDir);
+    CreateRing(1);
+    ASSERT_EQ(0, manager.Attach(kTestFd, getpid(), 1, client_.Size()));
+
+    // 提交请求很慢时心跳也要持续更新
+    std::atomic<bool> submitted{false};
+    EXPECT_CALL(*fileManager_, AioWrite(kTestFd, _))
+        .Times(1)
+        .WillOnce(Invoke([&submitted](int fd, NebdServerAioContext* context) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+            submitted = true;
+            context->ret = 0;
+            context->cb(context);
+            return 0;
+        }));
+    SubmitWrite(100);
+    for (int i = 0; i < 8; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        ASSERT_LT(ShmRing::NowMs() - client_.ServerHeartbeatMs(), 500u);
+    }
+    ASSERT_FALSE(submitted.load());
+
+    ShmIoCompletion completion;
+    ASSERT_TRUE(WaitCompletion(&completion));
+    ASSERT_EQ(100, completion.id);
+    ASSERT_EQ(0, completion.ret);
+
+    // 关闭之后不再更新心跳
+    ShmServerTestClosure detachDone;
+    manager.Detach(kTestFd, &detachDone);
+    ASSERT_TRUE(detachDone.WaitRunned(5000));
+    uint64_t heartbeat = client_.ServerHeartbeatMs();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ASSERT_EQ(heartbeat, client_.ServerHeartbeatMs());
+}
+
+TEST_F(ShmServerTest, FileRemovedTest) {
+    NebdShmManager manager(fileManager_, false, kShmDir);
+    CreateRing(1);
+    ASSERT_EQ(0, manager.Attach(kTestFd, getpid(), 1, client_.Size()));
+
+    // 文件被删除后轮询线程退出，心跳停止，part1切回rpc通道
+    EXPECT_CALL(*fileManager_, GetFileEntity(kTestFd))
+        .WillRepeatedly(Return(nullptr));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    uint64_t heartbeat = client_.ServerHeartbeatMs();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ASSERT_EQ(heartbeat, client_.ServerHeartbeatMs());
+
+    // 通道已经解除映射，再次关闭时直接执行done
+    ShmServerTestClosure detachDone;
+    manager.Detach(kTestFd, &detachDone);
+    ASSERT_TRUE(detachDone.WaitRunned(0));
+}
+
+}  // namespace server
+}  // namespace nebd
@@ -241,7 +241,11 @@ ReadChunkRequest::ReadChunkRequest(std::shared_ptr<CopysetNode> nodePtr,
 void ReadChunkRequest::Process() {
     brpc::ClosureGuard doneGuard(done_);
 
-    if (!node_->IsLeaderTerm()) {
+    /**
+     * 非leader节点只服务client的hedged read：请求需要携带followerRead标记
+     * 和applied index，并且本节点已经apply到该index，否则重定向给leader
+     */
+    if (!node_->IsLeaderTerm() && !CanFollowerRead()) {
         RedirectChunkRequest();
         return;
     }
@@ -327,6 +331,11 @@ void ReadChunkRequest::OnApply(uint64_t index,
         }
         // 如果需要从源端拷贝数据，需要将请求转发给clone manager处理
         if ( needLazyClone || NeedClone(chunkInfo) ) {
+            // follower上无法propose paste请求，clone交给leader处理
+            if (!node_->IsLeaderTerm()) {
+                RedirectChunkRequest();
+                break;
+            }
             applyIndex = index;
             std::shared_ptr<CloneTask> cloneTask =
             cloneMgr_->GenerateCloneTask(
@@ -366,6 +375,14 @@ void ReadChunkRequest::OnApply(uint64_t index,
     response_->set_appliedindex(maxIndex);
 }
 
+bool ReadChunkRequest::CanFollowerRead() const {
+    return request_->optype() == CHUNK_OP_TYPE::CHUNK_OP_READ
+        && request_->followerread()
+        && request_->has_appliedindex()
+        && request_->appliedindex() > 0
+        && node_->GetAppliedIndex() >= request_->appliedindex();
+}
+
 void ReadChunkRequest::OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,
                                       const ChunkRequest &request,
                                       const butil::IOBuf &data) {
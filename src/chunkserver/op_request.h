@@ -232,6 +232,8 @@ class ReadChunkRequest : public ChunkOpRequest {
  private:
     // 根据chunk信息判断是否需要拷贝数据
     bool NeedClone(const CSChunkInfo& chunkInfo);
+    // 非leader节点是否可以直接服务本次读请求
+    bool CanFollowerRead() const;
     // 从chunk文件中读数据
     void ReadChunk();
 
@@ -485,6 +485,124 @@ void WriteChunkClosure::OnSuccess() {
         response_->appliedindex());
 }
 
+bool HedgedReadContext::OnLeaderReturned(ReadChunkClosure* closure,
+                                         bool terminal) {
+    curve::common::UniqueLock lk(mtx_);
+    if (finished_) {
+        // 请求已经由follower上的备份读完成，done已经被回调，这里直接丢弃
+        lk.unlock();
+        closure->Discard();
+        return false;
+    }
+
+    // 备份读发送过程中不能完成请求，
+    // 需要重试时如果备份读还在进行，等待备份读的结果，不丢弃可能成功的备份读
+    if (sending_ || (hedging_ && !terminal)) {
+        deferred_ = closure;
+        deferredTerminal_ = terminal;
+        return false;
+    }
+
+    finished_ = true;
+    return true;
+}
+
+bool HedgedReadContext::BeginSendHedge(const std::function<bool()>& prepare) {
+    curve::common::LockGuard lk(mtx_);
+    if (finished_ || !prepare()) {
+        return false;
+    }
+    sending_ = true;
+    hedging_ = true;
+    return true;
+}
+
+void HedgedReadContext::EndSendHedge() {
+    curve::common::UniqueLock lk(mtx_);
+    sending_ = false;
+    ReadChunkClosure* deferred = TakeDeferredLocked();
+    lk.unlock();
+
+    if (deferred != nullptr) {
+        deferred->RunDeferred();
+    }
+}
+
+bool HedgedReadContext::OnHedgeReturned(bool success) {
+    curve::common::UniqueLock lk(mtx_);
+    hedging_ = false;
+    if (finished_) {
+        return false;
+    }
+
+    if (success) {
+        // 备份读的回调在发送之后才会执行，不会再访问done，
+        // 即使发送流程还未结束也可以完成请求
+        finished_ = true;
+        ReadChunkClosure* deferred = deferred_;
+        deferred_ = nullptr;
+        lk.unlock();
+        if (deferred != nullptr) {
+            deferred->Discard();
+        }
+        return true;
+    }
+
+    ReadChunkClosure* deferred = TakeDeferredLocked();
+    lk.unlock();
+    if (deferred != nullptr) {
+        deferred->RunDeferred();
+    }
+    return false;
+}
+
+ReadChunkClosure* HedgedReadContext::TakeDeferredLocked() {
+    if (deferred_ == nullptr || sending_ ||
+        (hedging_ && !deferredTerminal_)) {
+        return nullptr;
+    }
+
+    finished_ = true;
+    ReadChunkClosure* deferred = deferred_;
+    deferred_ = nullptr;
+    return deferred;
+}
+
+void ReadChunkClosure::Run() {
+    if (hedgeCtx_ != nullptr &&
+        !hedgeCtx_->OnLeaderReturned(this, IsTerminal())) {
+        return;
+    }
+
+    ClientClosure::Run();
+}
+
+void ReadChunkClosure::RunDeferred() {
+    ClientClosure::Run();
+}
+
+void ReadChunkClosure::Discard() {
+    std::unique_ptr<ReadChunkClosure> selfGuard(this);
+    std::unique_ptr<brpc::Controller> cntlGuard(cntl_);
+}
+
+bool ReadChunkClosure::IsTerminal() const {
+    if (cntl_->Failed()) {
+        return false;
+    }
+
+    switch (GetResponseStatus()) {
+    case CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS:
+    case CHUNK_OP_STATUS::CHUNK_OP_STATUS_CHUNK_NOTEXIST:
+    case CHUNK_OP_STATUS::CHUNK_OP_STATUS_INVALID_REQUEST:
+    case CHUNK_OP_STATUS::CHUNK_OP_STATUS_BACKWARD:
+    case CHUNK_OP_STATUS::CHUNK_OP_STATUS_CHUNK_EXIST:
+        return true;
+    default:
+        return false;
+    }
+}
+
 void ReadChunkClosure::SendRetryRequest() {
     client_->ReadChunk(reqCtx_->idinfo_, reqCtx_->seq_,
                        reqCtx_->offset_,
@@ -514,6 +632,47 @@ void ReadChunkClosure::OnChunkNotExist() {
                                    response_->appliedindex());
 }
 
+void HedgedReadChunkClosure::Run() {
+    std::unique_ptr<HedgedReadChunkClosure> selfGuard(this);
+    std::unique_ptr<brpc::Controller> cntlGuard(cntl_);
+
+    bool success = false;
+    if (cntl_->Failed()) {
+        LOG_EVERY_SECOND(WARNING) << "hedged read failed, error code: "
+            << cntl_->ErrorCode() << ", error: " << cntl_->ErrorText()
+            << ", chunkserver id = " << chunkserverID_
+            << ", remote side = "
+            << butil::endpoint2str(cntl_->remote_side()).c_str();
+    } else {
+        // follower落后于appliedindex时会返回redirect，交给leader上的请求处理
+        status_ = GetResponseStatus();
+        success = status_ == CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS ||
+                  status_ == CHUNK_OP_STATUS::CHUNK_OP_STATUS_CHUNK_NOTEXIST;
+    }
+
+    if (!hedgeCtx_->OnHedgeReturned(success)) {
+        return;
+    }
+
+    brpc::ClosureGuard doneGuard(done_);
+    reqDone_ = static_cast<RequestClosure*>(done_);
+    fileMetric_ = reqDone_->GetMetric();
+    reqCtx_ = reqDone_->GetReqCtx();
+
+    if (status_ == CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS) {
+        reqCtx_->readData_ = cntl_->response_attachment();
+    } else {
+        reqCtx_->readData_.resize(reqCtx_->rawlength_, 0);
+    }
+    reqDone_->SetFailed(0);
+
+    MetricHelper::IncremHedgedReadWinCount(fileMetric_);
+    MetricHelper::LatencyRecord(
+        fileMetric_, cntl_->latency_us(), reqCtx_->optype_);
+    MetricHelper::IncremRPCQPSCount(
+        fileMetric_, reqCtx_->rawlength_, reqCtx_->optype_);
+}
+
 void ReadChunkSnapClosure::SendRetryRequest() {
     client_->ReadChunkSnapshot(reqCtx_->idinfo_, reqCtx_->seq_,
                                reqCtx_->offset_,
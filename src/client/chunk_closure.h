@@ -26,6 +26,7 @@
 #include <google/protobuf/stubs/callback.h>
 #include <brpc/controller.h>
 #include <brpc/errno.pb.h>
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -34,6 +35,7 @@
 #include "src/client/client_common.h"
 #include "src/client/client_metric.h"
 #include "src/client/request_closure.h"
+#include "src/common/concurrent/concurrent.h"
 #include "src/common/math_util.h"
 
 namespace curve {
@@ -241,14 +243,152 @@ class WriteChunkClosure : public ClientClosure {
     void SendRetryRequest() override;
 };
 
+class ReadChunkClosure;
+
+/**
+ * hedged read的共享上下文，由发往leader的ReadChunkClosure和发往follower的
+ * HedgedReadChunkClosure共同持有，只有先拿到完成权的一方可以回调上层done，
+ * 另一方的返回直接丢弃。
+ * leader返回需要重试的结果时，如果备份读还没有返回，先暂存leader的返回，
+ * 备份读成功则由备份读完成请求，失败再按leader的返回重试
+ */
+class HedgedReadContext {
+ public:
+    HedgedReadContext(Closure* done, const ChunkIDInfo& idinfo, uint64_t sn,
+                      off_t offset, size_t length, uint64_t appliedindex)
+        : done_(done),
+          idinfo_(idinfo),
+          sn_(sn),
+          offset_(offset),
+          length_(length),
+          appliedindex_(appliedindex),
+          finished_(false),
+          sending_(false),
+          hedging_(false),
+          deferred_(nullptr),
+          deferredTerminal_(false) {}
+
+    /**
+     * leader上的请求返回时调用
+     * @param: closure为发往leader的请求
+     * @param: terminal为true表示返回的结果不需要重试
+     * @return: 获取完成权返回true，由closure完成或者重试请求；
+     *          请求已经被备份读完成，或者需要等待备份读的结果时返回false，
+     *          closure被丢弃或者暂存
+     */
+    bool OnLeaderReturned(ReadChunkClosure* closure, bool terminal);
+
+    /**
+     * 请求还未完成时在锁内执行prepare，prepare返回true表示可以发送备份读，
+     * 之后到EndSendHedge之前请求不会被完成，
+     * 保证prepare和发送时访问的done以及copyset client仍然有效
+     * @return: 可以发送备份读返回true
+     */
+    bool BeginSendHedge(const std::function<bool()>& prepare);
+
+    /**
+     * 备份读发送之后调用，处理发送期间暂存的leader返回
+     */
+    void EndSendHedge();
+
+    /**
+     * 备份读返回时调用
+     * @param: success为备份读是否成功
+     * @return: 获取完成权返回true，由备份读完成请求
+     */
+    bool OnHedgeReturned(bool success);
+
+    Closure* GetClosure() const {
+        return done_;
+    }
+
+    const ChunkIDInfo& GetChunkIDInfo() const {
+        return idinfo_;
+    }
+
+    uint64_t GetSn() const {
+        return sn_;
+    }
+
+    off_t GetOffset() const {
+        return offset_;
+    }
+
+    size_t GetLength() const {
+        return length_;
+    }
+
+    uint64_t GetAppliedIndex() const {
+        return appliedindex_;
+    }
+
+ private:
+    // 上层的RequestClosure，只有拿到完成权之后才能访问
+    Closure* done_;
+    // 备份读请求需要的参数，在原请求完成后RequestContext会被释放，所以这里拷贝一份
+    ChunkIDInfo idinfo_;
+    uint64_t sn_;
+    off_t offset_;
+    size_t length_;
+    uint64_t appliedindex_;
+
+    // 暂存的leader返回在备份读已经返回，或者不需要重试时才能处理，
+    // 处理之前获取完成权，返回暂存的closure，否则返回nullptr
+    ReadChunkClosure* TakeDeferredLocked();
+
+    curve::common::Mutex mtx_;
+    // 上层done已经或者正在被某一方完成
+    bool finished_;
+    // 正在发送备份读，发送过程中会访问done
+    bool sending_;
+    // 备份读已经发出，还未返回
+    bool hedging_;
+    // 等待备份读结果的leader返回
+    ReadChunkClosure* deferred_;
+    bool deferredTerminal_;
+};
+
 class ReadChunkClosure : public ClientClosure {
  public:
-    ReadChunkClosure(CopysetClient* client, Closure* done)
-        : ClientClosure(client, done) {}
+    ReadChunkClosure(CopysetClient* client, Closure* done,
+                     std::shared_ptr<HedgedReadContext> hedgeCtx = nullptr)
+        : ClientClosure(client, done), hedgeCtx_(std::move(hedgeCtx)) {}
 
+    void Run() override;
     void OnSuccess() override;
     void OnChunkNotExist() override;
     void SendRetryRequest() override;
+
+    // 处理暂存的返回结果
+    void RunDeferred();
+
+    // 丢弃返回结果，请求已经由另一方完成
+    void Discard();
+
+ private:
+    // 返回的结果不需要重试，与ClientClosure::Run的处理一致
+    bool IsTerminal() const;
+
+    // 开启了hedged read时不为空
+    std::shared_ptr<HedgedReadContext> hedgeCtx_;
+};
+
+/**
+ * 发往follower的备份读请求的回调，备份请求不进行重试，
+ * 只有成功返回且先于leader返回时才完成上层请求
+ */
+class HedgedReadChunkClosure : public ClientClosure {
+ public:
+    HedgedReadChunkClosure(CopysetClient* client,
+                           std::shared_ptr<HedgedReadContext> hedgeCtx)
+        : ClientClosure(client, hedgeCtx->GetClosure()),
+          hedgeCtx_(std::move(hedgeCtx)) {}
+
+    void Run() override;
+    void SendRetryRequest() override {}
+
+ private:
+    std::shared_ptr<HedgedReadContext> hedgeCtx_;
 };
 
 class ReadChunkSnapClosure : public ClientClosure {
@@ -127,6 +127,33 @@ int ClientConfig::Init(const char* configpath) {
         &fileServiceOption_.ioOpt.ioSenderOpt.failRequestOpt.chunkserverMaxRetryTimesBeforeConsiderSuspend);   // NOLINT
     LOG_IF(ERROR, ret == false) << "config no chunkserver.maxRetryTimesBeforeConsiderSuspend info";             // NOLINT
 
+    ret = conf_.GetBoolValue("chunkserver.hedgedRead.enable",
+        &fileServiceOption_.ioOpt.ioSenderOpt.hedgedReadOpt.enable);
+    LOG_IF(WARNING, ret == false)
+        << "config no chunkserver.hedgedRead.enable info, using default value "
+        << fileServiceOption_.ioOpt.ioSenderOpt.hedgedReadOpt.enable;
+
+    ret = conf_.GetDoubleValue("chunkserver.hedgedRead.delayPercentile",
+        &fileServiceOption_.ioOpt.ioSenderOpt.hedgedReadOpt.delayPercentile);
+    LOG_IF(WARNING, ret == false)
+        << "config no chunkserver.hedgedRead.delayPercentile info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.ioSenderOpt.hedgedReadOpt.delayPercentile;
+
+    ret = conf_.GetUInt32Value("chunkserver.hedgedRead.minDelayMS",
+        &fileServiceOption_.ioOpt.ioSenderOpt.hedgedReadOpt.minDelayMS);
+    LOG_IF(WARNING, ret == false)
+        << "config no chunkserver.hedgedRead.minDelayMS info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.ioSenderOpt.hedgedReadOpt.minDelayMS;
+
+    ret = conf_.GetUInt32Value("chunkserver.hedgedRead.maxHedgeRatio",
+        &fileServiceOption_.ioOpt.ioSenderOpt.hedgedReadOpt.maxHedgeRatio);
+    LOG_IF(WARNING, ret == false)
+        << "config no chunkserver.hedgedRead.maxHedgeRatio info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.ioSenderOpt.hedgedReadOpt.maxHedgeRatio;
+
     ret = conf_.GetUInt64Value("global.fileMaxInFlightRPCNum",
         &fileServiceOption_.ioOpt.ioSenderOpt.inflightOpt.fileMaxInFlightRPCNum);   // NOLINT
     LOG_IF(ERROR, ret == false) << "config no global.fileMaxInFlightRPCNum info";   // NOLINT
@@ -147,6 +174,59 @@ int ClientConfig::Init(const char* configpath) {
     LOG_IF(ERROR, ret == false) << "config no metacache.getLeaderTimeOutMS info";   // NOLINT
     RETURN_IF_FALSE(ret);
 
+    ret = conf_.GetUInt32Value("global.segmentAlloc.batchSize",
+        &fileServiceOption_.ioOpt.ioSplitOpt.segmentAllocOpt.batchSize);
+    LOG_IF(WARNING, ret == false)
+        << "config no global.segmentAlloc.batchSize info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.ioSplitOpt.segmentAllocOpt.batchSize;
+
+    ret = conf_.GetBoolValue("global.segmentAlloc.prefetchEnable",
+        &fileServiceOption_.ioOpt.ioSplitOpt.segmentAllocOpt.prefetchEnable);
+    LOG_IF(WARNING, ret == false)
+        << "config no global.segmentAlloc.prefetchEnable info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.ioSplitOpt.segmentAllocOpt.prefetchEnable;
+
+    ret = conf_.GetUInt32Value("global.segmentAlloc.prefetchTriggerPercent",
+        &fileServiceOption_.ioOpt.ioSplitOpt.segmentAllocOpt
+             .prefetchTriggerPercent);
+    LOG_IF(WARNING, ret == false)
+        << "config no global.segmentAlloc.prefetchTriggerPercent info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.ioSplitOpt.segmentAllocOpt
+               .prefetchTriggerPercent;
+
+    ret = conf_.GetUInt64Value("global.segmentAlloc.prefetchRPCMaxRetryMS",
+        &fileServiceOption_.ioOpt.ioSplitOpt.segmentAllocOpt
+             .prefetchRPCMaxRetryMS);
+    LOG_IF(WARNING, ret == false)
+        << "config no global.segmentAlloc.prefetchRPCMaxRetryMS info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.ioSplitOpt.segmentAllocOpt
+               .prefetchRPCMaxRetryMS;
+
+    ret = conf_.GetBoolValue("metacache.leaderRefresh.enable",
+        &fileServiceOption_.ioOpt.metaCacheOpt.leaderRefreshEnable);
+    LOG_IF(WARNING, ret == false)
+        << "config no metacache.leaderRefresh.enable info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.metaCacheOpt.leaderRefreshEnable;
+
+    ret = conf_.GetUInt32Value("metacache.leaderRefresh.intervalMS",
+        &fileServiceOption_.ioOpt.metaCacheOpt.leaderRefreshIntervalMS);
+    LOG_IF(WARNING, ret == false)
+        << "config no metacache.leaderRefresh.intervalMS info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.metaCacheOpt.leaderRefreshIntervalMS;
+
+    ret = conf_.GetUInt32Value("metacache.leaderRefresh.batchSize",
+        &fileServiceOption_.ioOpt.metaCacheOpt.leaderRefreshBatchSize);
+    LOG_IF(WARNING, ret == false)
+        << "config no metacache.leaderRefresh.batchSize info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.metaCacheOpt.leaderRefreshBatchSize;
+
     ret = conf_.GetUInt32Value("schedule.queueCapacity",
         &fileServiceOption_.ioOpt.reqSchdulerOpt.scheduleQueueCapacity);
     LOG_IF(ERROR, ret == false) << "config no schedule.queueCapacity info";
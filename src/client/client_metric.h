@@ -131,6 +131,16 @@ struct FileMetric {
     // get leader失败重试qps
     PerSecondMetric getLeaderRetryQPS;
 
+    // 所有类型rpc被redirect的qps
+    PerSecondMetric redirectQPS;
+    // 后台提前发现leader变化并更新metacache的qps
+    PerSecondMetric proactiveLeaderRefreshQPS;
+
+    // 发往follower的hedged read请求qps
+    PerSecondMetric hedgedReadQPS;
+    // hedged read先于leader成功返回的qps
+    PerSecondMetric hedgedReadWinQPS;
+
     // 当前文件上的悬挂IO数量
     IOSuspendMetric suspendRPCMetric;
 
@@ -148,6 +158,11 @@ struct FileMetric {
           userWrite(prefix, filename + "_write"),
           userDiscard(prefix, filename + "_discard"),
           getLeaderRetryQPS(prefix, filename + "_get_leader_retry_rpc"),
+          redirectQPS(prefix, filename + "_redirect_rpc"),
+          proactiveLeaderRefreshQPS(prefix,
+                                    filename + "_proactive_leader_refresh"),
+          hedgedReadQPS(prefix, filename + "_hedged_read_rpc"),
+          hedgedReadWinQPS(prefix, filename + "_hedged_read_win"),
           suspendRPCMetric(prefix, filename + "_suspend_io_num"),
           discardMetric(prefix + filename) {}
 };
@@ -376,6 +391,7 @@ class MetricHelper {
      */
     static void IncremRedirectRPCCount(FileMetric* fileMetric, OpType opType) {
         if (fileMetric) {
+            fileMetric->redirectQPS.count << 1;
             switch (opType) {
                 case OpType::READ:
                     fileMetric->readRPC.redirectQps.count << 1;
@@ -472,6 +488,36 @@ class MetricHelper {
         }
     }
 
+    /**
+     * 统计后台提前发现leader变化的次数
+     * @param: fm为当前文件的metric指针
+     */
+    static void IncremProactiveLeaderRefreshCount(FileMetric* fm) {
+        if (fm != nullptr) {
+            fm->proactiveLeaderRefreshQPS.count << 1;
+        }
+    }
+
+    /**
+     * 统计发送的hedged read请求次数
+     * @param: fm为当前文件的metric指针
+     */
+    static void IncremHedgedReadCount(FileMetric* fm) {
+        if (fm != nullptr) {
+            fm->hedgedReadQPS.count << 1;
+        }
+    }
+
+    /**
+     * 统计hedged read先于leader返回并完成请求的次数
+     * @param: fm为当前文件的metric指针
+     */
+    static void IncremHedgedReadWinCount(FileMetric* fm) {
+        if (fm != nullptr) {
+            fm->hedgedReadWinQPS.count << 1;
+        }
+    }
+
     static void IncremInflightRPC(FileMetric* fm) {
         if (fm != nullptr) {
             fm->inflightRPCNum << 1;
@@ -154,16 +154,34 @@ struct FailureRequestOption {
     uint64_t chunkserverMaxRetryTimesBeforeConsiderSuspend = 20;
 };
 
+/**
+ * hedged read配置，leader在一定时间内没有返回时，携带appliedindex
+ * 向copyset的其他副本发送一个备份读请求，先成功返回的结果作为读结果
+ * @enable: 是否开启hedged read，依赖chunkserverEnableAppliedIndexRead
+ * @delayPercentile: 以read rpc延迟的该分位值作为发送备份请求前的等待时间
+ * @minDelayMS: 发送备份请求前的最小等待时间
+ * @maxHedgeRatio: 备份请求数量占read rpc数量的百分比上限，
+ *                 避免集群整体变慢时备份请求放大负载
+ */
+struct HedgedReadOption {
+    bool enable = false;
+    double delayPercentile = 0.99;
+    uint32_t minDelayMS = 10;
+    uint32_t maxHedgeRatio = 5;
+};
+
 /**
  * 发送rpc给chunkserver的配置
  * @chunkserverEnableAppliedIndexRead: 是否开启使用appliedindex read
  * @inflightOpt: 一个文件向chunkserver发送请求时的inflight 请求控制配置
  * @failRequestOpt: rpc发送失败之后，需要进行rpc重试的相关配置
+ * @hedgedReadOpt: hedged read相关配置
  */
 struct IOSenderOption {
     bool chunkserverEnableAppliedIndexRead;
     InFlightIOCntlInfo inflightOpt;
     FailureRequestOption failRequestOpt;
+    HedgedReadOption hedgedReadOpt;
 };
 
 /**
@@ -199,6 +217,10 @@ struct RequestScheduleOption {
  *                            backup request的时间就为该值。
  * @metacacheGetLeaderBackupRequestLbName: 为getleader backup rpc
  *                            选择底层服务节点的策略
+ * @leaderRefreshEnable: 是否在后台定期从mds拉取copyset的leader信息，
+ *                            提前发现leader变化，避免IO先发到旧leader
+ * @leaderRefreshIntervalMS: 后台拉取leader信息的时间间隔
+ * @leaderRefreshBatchSize: 每次向mds拉取leader信息时携带的最大copyset数量
  */
 struct MetaCacheOption {
     uint32_t metacacheGetLeaderRetry = 3;
@@ -208,6 +230,9 @@ struct MetaCacheOption {
     uint32_t discardGranularity = 4096;
     std::string metacacheGetLeaderBackupRequestLbName = "rr";
     ChunkServerUnstableOption chunkserverUnstableOption;
+    bool leaderRefreshEnable = false;
+    uint32_t leaderRefreshIntervalMS = 1000;
+    uint32_t leaderRefreshBatchSize = 256;
 };
 
 struct AlignmentOption {
@@ -215,6 +240,20 @@ struct AlignmentOption {
     uint32_t cloneVolume = 4096;
 };
 
+/**
+ * segment分配相关配置信息
+ * @batchSize: 写IO遇到未分配的segment时，一次向mds获取(分配)的连续segment数量
+ * @prefetchEnable: 顺序写接近未分配的segment时，是否在后台提前分配
+ * @prefetchTriggerPercent: 写到当前segment的该百分比位置之后触发预分配
+ * @prefetchRPCMaxRetryMS: 后台预分配rpc的最大重试时间
+ */
+struct SegmentAllocOption {
+    uint32_t batchSize = 1;
+    bool prefetchEnable = false;
+    uint32_t prefetchTriggerPercent = 50;
+    uint64_t prefetchRPCMaxRetryMS = 8000;
+};
+
 /**
  * IO 拆分模块配置信息
  * @fileIOSplitMaxSizeKB:
@@ -224,6 +263,7 @@ struct AlignmentOption {
 struct IOSplitOption {
     uint64_t fileIOSplitMaxSizeKB = 64;
     AlignmentOption alignment;
+    SegmentAllocOption segmentAllocOpt;
 };
 
 /**
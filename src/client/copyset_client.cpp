@@ -23,10 +23,15 @@
 #include "src/client/copyset_client.h"
 
 #include <glog/logging.h>
+#include <bthread/unstable.h>
+#include <butil/fast_rand.h>
+#include <butil/time.h>
 #include <unistd.h>
+#include <algorithm>
 #include <memory>
 #include <utility>
 
+#include "src/client/chunk_closure.h"
 #include "src/client/request_sender.h"
 #include "src/client/metacache.h"
 #include "src/client/client_config.h"
@@ -36,6 +41,18 @@
 namespace curve {
 namespace client {
 
+namespace {
+
+// 备份读比例统计窗口，窗口内读请求数量超过该值后重新统计
+const uint64_t kHedgedReadBudgetWindow = 10000;
+
+struct HedgedReadTimerArg {
+    CopysetClient* client;
+    std::shared_ptr<HedgedReadContext> hedgeCtx;
+};
+
+}  // namespace
+
 int CopysetClient::Init(MetaCache *metaCache,
     const IOSenderOption& ioSenderOpt, RequestScheduler* scheduler,
     FileMetric* fileMetric) {
@@ -122,15 +139,123 @@ int CopysetClient::ReadChunk(const ChunkIDInfo& idinfo, uint64_t sn,
         }
     }
 
+    std::shared_ptr<HedgedReadContext> hedgeCtx;
+    uint64_t hedgeDelayMS = 0;
+    if (ShouldHedgeRead(reqclosure, appliedindex, sourceInfo, &hedgeDelayMS)) {
+        hedgeCtx = std::make_shared<HedgedReadContext>(
+            done, idinfo, sn, offset, length, appliedindex);
+    }
+
     auto task = [&](Closure* done, std::shared_ptr<RequestSender> senderPtr) {
-        ReadChunkClosure *readDone = new ReadChunkClosure(this, done);
+        ReadChunkClosure *readDone = new ReadChunkClosure(this, done, hedgeCtx);
         senderPtr->ReadChunk(idinfo, sn, offset, length,
                              appliedindex, sourceInfo, readDone);
+        // 只有请求真正发送给leader之后才启动备份读定时器
+        if (hedgeCtx != nullptr) {
+            ScheduleHedgedRead(hedgeCtx, hedgeDelayMS);
+        }
     };
 
     return DoRPCTask(idinfo, task, doneGuard.release());
 }
 
+bool CopysetClient::ShouldHedgeRead(RequestClosure* reqclosure,
+                                    uint64_t appliedindex,
+                                    const RequestSourceInfo& sourceInfo,
+                                    uint64_t* delayMS) {
+    const HedgedReadOption& opt = iosenderopt_.hedgedReadOpt;
+    // 1. follower只能服务携带appliedindex的读，重试的请求按原有逻辑处理
+    // 2. 需要从克隆源拷贝数据的读只能由leader处理
+    if (!opt.enable || !iosenderopt_.chunkserverEnableAppliedIndexRead ||
+        appliedindex == 0 || sourceInfo.IsValid() ||
+        reqclosure->GetRetriedTimes() != 0 || fileMetric_ == nullptr) {
+        return false;
+    }
+
+    uint64_t candidates = hedgeCandidateCount_.fetch_add(1) + 1;
+    if (candidates >= kHedgedReadBudgetWindow) {
+        hedgeCandidateCount_.store(0);
+        hedgeSentCount_.store(0);
+    }
+
+    if (hedgeSentCount_.load() * 100 >= candidates * opt.maxHedgeRatio) {
+        return false;
+    }
+
+    uint64_t percentileUS =
+        fileMetric_->readRPC.latency.latency_percentile(opt.delayPercentile);
+    *delayMS = std::max<uint64_t>(opt.minDelayMS, percentileUS / 1000);
+    return true;
+}
+
+void CopysetClient::ScheduleHedgedRead(
+    std::shared_ptr<HedgedReadContext> hedgeCtx, uint64_t delayMS) {
+    HedgedReadTimerArg* arg = new HedgedReadTimerArg{this, hedgeCtx};
+    bthread_timer_t timerId;
+    int ret = bthread_timer_add(&timerId, butil::milliseconds_from_now(delayMS),
+                                OnHedgedReadTimer, arg);
+    if (ret != 0) {
+        LOG(WARNING) << "add hedged read timer failed, ret = " << ret;
+        delete arg;
+    }
+}
+
+void CopysetClient::OnHedgedReadTimer(void* arg) {
+    std::unique_ptr<HedgedReadTimerArg> timerArg(
+        static_cast<HedgedReadTimerArg*>(arg));
+
+    CopysetClient* client = timerArg->client;
+    const std::shared_ptr<HedgedReadContext>& hedgeCtx = timerArg->hedgeCtx;
+
+    // 请求已经完成时文件可能已经关闭，不能再访问copyset client，
+    // 只在hedgeCtx的锁内选择follower，发送时不持锁
+    std::shared_ptr<RequestSender> senderPtr;
+    bool start = hedgeCtx->BeginSendHedge([&]() {
+        senderPtr = client->GetHedgedReadSender(hedgeCtx->GetChunkIDInfo());
+        return senderPtr != nullptr;
+    });
+    if (!start) {
+        return;
+    }
+
+    HedgedReadChunkClosure* hedgeDone =
+        new HedgedReadChunkClosure(client, hedgeCtx);
+    senderPtr->ReadChunk(hedgeCtx->GetChunkIDInfo(), hedgeCtx->GetSn(),
+                         hedgeCtx->GetOffset(), hedgeCtx->GetLength(),
+                         hedgeCtx->GetAppliedIndex(), RequestSourceInfo(),
+                         hedgeDone, true);
+    hedgeCtx->EndSendHedge();
+}
+
+std::shared_ptr<RequestSender> CopysetClient::GetHedgedReadSender(
+    const ChunkIDInfo& idinfo) {
+    CopysetInfo<ChunkServerID> cpinfo =
+        metaCache_->GetCopysetinfo(idinfo.lpid_, idinfo.cpid_);
+
+    int peerSize = cpinfo.csinfos_.size();
+    int leaderIndex = cpinfo.GetCurrentLeaderIndex();
+    if (leaderIndex < 0 || peerSize <= 1) {
+        return nullptr;
+    }
+
+    // 随机选择一个follower，避免备份读集中到同一个副本上
+    int index = (leaderIndex + 1 +
+                 butil::fast_rand_less_than(peerSize - 1)) % peerSize;
+    const CopysetPeerInfo<ChunkServerID>& peer = cpinfo.csinfos_[index];
+
+    auto senderPtr = senderManager_->GetOrCreateSender(
+        peer.peerID, peer.externalAddr.addr_, iosenderopt_);
+    if (nullptr == senderPtr) {
+        LOG(WARNING) << "create sender for hedged read failed"
+                     << ", chunkserver id = " << peer.peerID;
+        return nullptr;
+    }
+
+    hedgeSentCount_.fetch_add(1);
+    MetricHelper::IncremHedgedReadCount(fileMetric_);
+    return senderPtr;
+}
+
 int CopysetClient::WriteChunk(const ChunkIDInfo& idinfo, uint64_t sn,
                               const butil::IOBuf& data,
                               off_t offset, size_t length,
@@ -26,6 +26,7 @@
 #include <google/protobuf/stubs/callback.h>
 #include <butil/iobuf.h>
 
+#include <atomic>
 #include <string>
 #include <memory>
 
@@ -45,7 +46,9 @@ using ::google::protobuf::Closure;
 
 // TODO(tongguangxun) :后续除了read、write的接口也需要调整重试逻辑
 class MetaCache;
+class RequestClosure;
 class RequestScheduler;
+class HedgedReadContext;
 /**
  * 负责管理 ChunkServer 的链接，向上层提供访问
  * 指定 copyset 的 chunk 的 read/write 等接口
@@ -57,7 +60,9 @@ class CopysetClient {
         metaCache_(nullptr),
         senderManager_(nullptr),
         scheduler_(nullptr),
-        exitFlag_(false) {}
+        exitFlag_(false),
+        hedgeCandidateCount_(0),
+        hedgeSentCount_(0) {}
 
     CopysetClient(const CopysetClient&) = delete;
     CopysetClient& operator=(const CopysetClient&) = delete;
@@ -232,6 +237,35 @@ class CopysetClient {
         std::function<void(Closure*, std::shared_ptr<RequestSender>)> task,
         Closure *done);
 
+    /**
+     * 判断本次读请求是否需要在leader响应慢时发送备份读请求
+     * @param[in]: reqclosure为本次请求的closure
+     * @param[in]: appliedindex为本次读请求携带的appliedindex
+     * @param[in]: sourceInfo为chunk克隆源信息
+     * @param[out]: delayMS为发送备份读请求前的等待时间
+     * @return: 需要发送备份读请求返回true
+     */
+    bool ShouldHedgeRead(RequestClosure* reqclosure,
+                         uint64_t appliedindex,
+                         const RequestSourceInfo& sourceInfo,
+                         uint64_t* delayMS);
+
+    /**
+     * 启动定时器，delayMS之后请求还未完成则向follower发送备份读请求
+     */
+    void ScheduleHedgedRead(std::shared_ptr<HedgedReadContext> hedgeCtx,
+                            uint64_t delayMS);
+
+    /**
+     * 随机选择copyset中非leader的副本作为备份读请求的目标
+     * 请求完成之后copyset client可能已经释放，需要在hedgeCtx的锁内调用
+     * @return: 没有可用的副本时返回nullptr
+     */
+    std::shared_ptr<RequestSender> GetHedgedReadSender(
+        const ChunkIDInfo& idinfo);
+
+    static void OnHedgedReadTimer(void* arg);
+
  private:
     // 元数据缓存
     MetaCache            *metaCache_;
@@ -253,6 +287,11 @@ class CopysetClient {
 
     // 是否在停止状态中，如果是在关闭过程中且session失效，需要将rpc直接返回不下发
     bool exitFlag_;
+
+    // 当前统计窗口内可以发送备份读的读请求数量，以及实际发送的备份读请求数量
+    // 用于将备份读请求的比例限制在maxHedgeRatio以内
+    std::atomic<uint64_t> hedgeCandidateCount_;
+    std::atomic<uint64_t> hedgeSentCount_;
 };
 
 }   // namespace client
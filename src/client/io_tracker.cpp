@@ -459,6 +459,12 @@ int IOTracker::Wait() {
     return iocv_.Wait();
 }
 
+void IOTracker::PrefetchSegment(SegmentIndex segmentIndex) {
+    if (iomanager_ != nullptr) {
+        iomanager_->PrefetchSegment(segmentIndex);
+    }
+}
+
 void IOTracker::Done() {
     if (type_ == OpType::READ || type_ == OpType::WRITE) {
         ReleaseAllSegmentLocks();
@@ -223,6 +223,12 @@ class CURVE_CACHELINE_ALIGNMENT IOTracker {
         return disableStripe_;
     }
 
+    /**
+     * 顺序写即将到达未分配的segment时，通知iomanager在后台提前分配
+     * @param: segmentIndex为需要预分配的segment
+     */
+    void PrefetchSegment(SegmentIndex segmentIndex);
+
     static void InitDiscardOption(const DiscardOption& opt);
 
  private:
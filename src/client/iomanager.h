@@ -60,6 +60,15 @@ class IOManager {
         return;
     }
 
+    /**
+     * @brief 在后台提前获取(分配)segment
+     * @param: segmentIndex为需要预分配的segment
+     */
+    virtual void PrefetchSegment(SegmentIndex segmentIndex) {
+        (void)segmentIndex;
+        return;
+    }
+
     /**
      * @brief 处理异步返回的response
      * @param: iotracker是当前reponse的归属
@@ -87,6 +87,13 @@ bool IOManager4File::Initialize(const std::string& filename,
     discardTaskManager_.reset(
         new DiscardTaskManager(&(fileMetric_->discardMetric)));
 
+    LeaderRefresher::GetInstance().Register(ioopt_.metaCacheOpt, &mc_,
+                                            mdsclient, fileMetric_);
+
+    segmentPrefetcher_.Init(ioopt_.ioSplitOpt.segmentAllocOpt, &mc_,
+                            mdsclient);
+    segmentPrefetcher_.Start();
+
     LOG(INFO) << "iomanager init success, conf info: "
               << "isolationTaskThreadPoolSize = "
               << ioopt_.taskThreadOpt.isolationTaskThreadPoolSize
@@ -101,6 +108,10 @@ void IOManager4File::UnInitialize() {
         throttle_->Stop();
     }
 
+    // leader refresher会使用fileMetric_, 需要在其释放之前注销
+    LeaderRefresher::GetInstance().Unregister(&mc_);
+    segmentPrefetcher_.Stop();
+
     bool exitFlag = false;
     std::mutex exitMtx;
     std::condition_variable exitCv;
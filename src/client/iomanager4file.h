@@ -36,6 +36,8 @@
 #include "src/client/client_common.h"
 #include "src/client/inflight_controller.h"
 #include "src/client/iomanager.h"
+#include "src/client/leader_refresher.h"
+#include "src/client/segment_prefetcher.h"
 #include "src/client/mds_client.h"
 #include "src/client/metacache.h"
 #include "src/client/request_scheduler.h"
@@ -137,6 +139,13 @@ class IOManager4File : public IOManager {
      */
     void ReleaseInflightRpcToken() override;
 
+    /**
+     * @brief 在后台提前获取(分配)segment
+     */
+    void PrefetchSegment(SegmentIndex segmentIndex) override {
+        segmentPrefetcher_.Prefetch(segmentIndex);
+    }
+
     /**
      * 获取metacache，测试代码使用
      */
@@ -265,6 +274,9 @@ class IOManager4File : public IOManager {
     // client端metric统计信息
     FileMetric* fileMetric_;
 
+    // 顺序写时在后台提前分配segment
+    SegmentPrefetcher segmentPrefetcher_;
+
     // task thread pool为了将qemu线程与curve线程隔离
     curve::common::TaskThreadPool<bthread::Mutex, bthread::ConditionVariable>
         taskPool_;
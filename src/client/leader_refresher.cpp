@@ -0,0 +1,230 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/**
+ * Project: curve
+ * Created Date: 2022-01-10
+ */
+
+#include "src/client/leader_refresher.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "src/client/mds_client.h"
+#include "src/client/metacache.h"
+
+namespace curve {
+namespace client {
+
+void LeaderRefresher::Register(const MetaCacheOption& opt,
+                               MetaCache* metaCache, MDSClient* mdsClient,
+                               FileMetric* fileMetric) {
+    if (!opt.leaderRefreshEnable) {
+        return;
+    }
+
+    std::unique_ptr<File> file(new File());
+    file->opt = opt;
+    file->metaCache = metaCache;
+    file->mdsClient = mdsClient;
+    file->fileMetric = fileMetric;
+    file->nextRefreshTime = std::chrono::steady_clock::now() +
+        std::chrono::milliseconds(opt.leaderRefreshIntervalMS);
+
+    std::lock_guard<std::mutex> threadLk(threadMtx_);
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        files_.push_back(std::move(file));
+        // 新文件的刷新间隔可能比其他文件短，唤醒后台线程重新计算
+        wakeup_ = true;
+    }
+    cond_.notify_all();
+    Start();
+}
+
+void LeaderRefresher::Unregister(MetaCache* metaCache) {
+    std::lock_guard<std::mutex> threadLk(threadMtx_);
+    bool empty = false;
+    {
+        std::unique_lock<std::mutex> lk(mtx_);
+        auto iter = std::find_if(files_.begin(), files_.end(),
+            [metaCache](const std::unique_ptr<File>& file) {
+                return file->metaCache == metaCache;
+            });
+        if (iter == files_.end()) {
+            return;
+        }
+
+        // 等待后台线程结束对该文件的刷新
+        File* file = iter->get();
+        cond_.wait(lk, [this, file]() { return current_ != file; });
+        files_.erase(iter);
+        empty = files_.empty();
+    }
+
+    if (empty) {
+        Stop();
+    }
+}
+
+void LeaderRefresher::Start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+
+    thread_.reset(new std::thread(&LeaderRefresher::Run, this));
+    LOG(INFO) << "leader refresher started";
+}
+
+void LeaderRefresher::Stop() {
+    {
+        // 持有mtx_修改，避免后台线程错过唤醒
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (!running_.exchange(false)) {
+            return;
+        }
+    }
+
+    cond_.notify_all();
+    thread_->join();
+    thread_.reset();
+    LOG(INFO) << "leader refresher stopped";
+}
+
+void LeaderRefresher::Run() {
+    using Clock = std::chrono::steady_clock;
+
+    std::unique_lock<std::mutex> lk(mtx_);
+    while (running_.load()) {
+        Clock::time_point wakeupTime = Clock::time_point::max();
+        // 文件在刷新期间不会被注销，迭代器保持有效
+        for (auto iter = files_.begin();
+             iter != files_.end() && running_.load(); ++iter) {
+            File* file = iter->get();
+            Clock::time_point now = Clock::now();
+            if (now >= file->nextRefreshTime) {
+                // 解锁之后文件可能被注销，先更新下次刷新的时间
+                file->nextRefreshTime = now + std::chrono::milliseconds(
+                    file->opt.leaderRefreshIntervalMS);
+                current_ = file;
+                lk.unlock();
+                RefreshOnce(file);
+                lk.lock();
+                current_ = nullptr;
+                cond_.notify_all();
+            }
+            wakeupTime = std::min(wakeupTime, file->nextRefreshTime);
+        }
+
+        auto woken = [this]() { return !running_.load() || wakeup_; };
+        if (wakeupTime == Clock::time_point::max()) {
+            cond_.wait(lk, woken);
+        } else {
+            cond_.wait_until(lk, wakeupTime, woken);
+        }
+        wakeup_ = false;
+    }
+}
+
+uint32_t LeaderRefresher::RefreshOnce(File* file) {
+    std::vector<CopysetLeaderHint> cached =
+        file->metaCache->GetCopysetLeaders();
+    if (cached.empty()) {
+        file->handled.clear();
+        return 0;
+    }
+
+    std::unordered_map<LogicPoolID, std::vector<CopysetID>> copysets;
+    std::unordered_map<uint64_t, ChunkServerID> cachedLeaders;
+    for (const auto& leader : cached) {
+        copysets[leader.lpid].push_back(leader.cpid);
+        cachedLeaders[MetaCache::CalcLogicPoolCopysetID(
+            leader.lpid, leader.cpid)] = leader.leaderId;
+    }
+
+    uint32_t changed = 0;
+    const uint32_t batchSize = std::max(1u, file->opt.leaderRefreshBatchSize);
+    for (const auto& pool : copysets) {
+        const std::vector<CopysetID>& ids = pool.second;
+        for (size_t start = 0; start < ids.size(); start += batchSize) {
+            size_t end = std::min(ids.size(), start + batchSize);
+            std::vector<CopysetID> batch(ids.begin() + start,
+                                         ids.begin() + end);
+            std::vector<CopysetLeaderHint> hints;
+            // 后台线程由所有文件共用，mds不可用时最多重试一个刷新周期，
+            // 放弃本轮刷新，不阻塞其他文件
+            if (LIBCURVE_ERROR::OK != file->mdsClient->GetCopysetLeaderHints(
+                    pool.first, batch, &hints,
+                    file->opt.leaderRefreshIntervalMS)) {
+                LOG(WARNING) << "get copyset leader hints from mds failed"
+                             << ", logicpool id = " << pool.first;
+                return changed;
+            }
+
+            for (const auto& hint : hints) {
+                uint64_t key =
+                    MetaCache::CalcLogicPoolCopysetID(hint.lpid, hint.cpid);
+                ChunkServerID cachedLeader = cachedLeaders[key];
+                bool mismatch = hint.leaderId != 0 &&
+                                hint.leaderId != cachedLeader;
+                if (!mismatch && !hint.leaderMayChange) {
+                    file->handled.erase(key);
+                    continue;
+                }
+
+                // 配置变更可能持续多个周期，同样的提示只处理一次，
+                // 避免反复向chunkserver获取leader
+                auto iter = file->handled.find(key);
+                if (iter != file->handled.end() &&
+                    iter->second.leaderId == hint.leaderId &&
+                    iter->second.leaderMayChange == hint.leaderMayChange) {
+                    continue;
+                }
+
+                // mds的leader信息来自心跳，可能比client缓存的更旧，
+                // 所以这里只把它当作提示，以chunkserver返回的leader为准
+                ChunkServerID leaderId = 0;
+                butil::EndPoint leaderAddr;
+                if (0 != file->metaCache->GetLeader(hint.lpid, hint.cpid,
+                                                    &leaderId, &leaderAddr,
+                                                    true, file->fileMetric)) {
+                    continue;
+                }
+                file->handled[key] = hint;
+
+                if (leaderId != cachedLeader) {
+                    ++changed;
+                    MetricHelper::IncremProactiveLeaderRefreshCount(
+                        file->fileMetric);
+                    LOG(INFO) << "leader of copyset (" << hint.lpid << ", "
+                              << hint.cpid << ") changed from "
+                              << cachedLeader << " to " << leaderId
+                              << " before io redirected";
+                }
+            }
+        }
+    }
+
+    return changed;
+}
+
+}  // namespace client
+}  // namespace curve
@@ -0,0 +1,123 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/**
+ * Project: curve
+ * Created Date: 2022-01-10
+ */
+
+#ifndef SRC_CLIENT_LEADER_REFRESHER_H_
+#define SRC_CLIENT_LEADER_REFRESHER_H_
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>
+#include <unordered_map>
+
+#include "src/client/client_metric.h"
+#include "src/client/config_info.h"
+#include "src/client/metacache_struct.h"
+
+namespace curve {
+namespace client {
+
+class MDSClient;
+class MetaCache;
+
+/**
+ * 后台定期从mds拉取已打开文件缓存的copyset的leader信息。
+ * mds上的leader来自chunkserver心跳，只作为提示：当mds记录的leader与
+ * metacache中的不一致，或者copyset上正在进行transfer leader等配置变更时，
+ * 在后台向chunkserver刷新leader，使IO在到达旧leader之前就切换到新leader，
+ * 避免leader调度时所有inflight IO都经历一次redirect。
+ * 进程内所有文件共用一个后台线程，第一个文件注册时启动，最后一个文件注销时停止。
+ * 每个文件按照自己配置的间隔刷新，后台线程在最早到期的文件到期时唤醒。
+ */
+class LeaderRefresher {
+ public:
+    static LeaderRefresher& GetInstance() {
+        static LeaderRefresher refresher;
+        return refresher;
+    }
+
+    /**
+     * 注册文件，之后由后台线程刷新文件metacache中的leader
+     * @param: metaCache同时作为文件的标识
+     */
+    void Register(const MetaCacheOption& opt, MetaCache* metaCache,
+                  MDSClient* mdsClient, FileMetric* fileMetric);
+
+    /**
+     * 注销文件，返回之后后台线程不会再访问文件的metaCache等信息
+     */
+    void Unregister(MetaCache* metaCache);
+
+ private:
+    struct File {
+        MetaCacheOption opt;
+        MetaCache* metaCache;
+        MDSClient* mdsClient;
+        FileMetric* fileMetric;
+        // 下一次刷新的时间
+        std::chrono::steady_clock::time_point nextRefreshTime;
+        // 已经处理过的mds提示，提示不变时不再重复向chunkserver获取leader
+        std::unordered_map<uint64_t, CopysetLeaderHint> handled;
+    };
+
+    LeaderRefresher()
+        : current_(nullptr), wakeup_(false), running_(false) {}
+
+    ~LeaderRefresher() {
+        std::lock_guard<std::mutex> lk(threadMtx_);
+        Stop();
+    }
+
+    void Start();
+
+    void Stop();
+
+    void Run();
+
+    /**
+     * 执行一轮文件的leader刷新
+     * @return: 本轮刷新发现的leader变化的copyset数量
+     */
+    uint32_t RefreshOnce(File* file);
+
+ private:
+    // 保护files_、current_和wakeup_
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    std::list<std::unique_ptr<File>> files_;
+    // 后台线程正在刷新的文件
+    File* current_;
+    // 有新文件注册，后台线程需要重新计算唤醒时间
+    bool wakeup_;
+
+    // 串行化后台线程的启动和停止
+    std::mutex threadMtx_;
+    std::atomic<bool> running_;
+    std::unique_ptr<std::thread> thread_;
+};
+
+}  // namespace client
+}  // namespace curve
+
+#endif  // SRC_CLIENT_LEADER_REFRESHER_H_
@@ -778,6 +778,49 @@ MDSClient::GetServerList(const LogicPoolID &logicalpooid,
     return ReturnError(rpcExcutor_.DoRPCTask(task, 0));
 }
 
+LIBCURVE_ERROR
+MDSClient::GetCopysetLeaderHints(const LogicPoolID &logicalpooid,
+                                 const std::vector<CopysetID> &copysetidvec,
+                                 std::vector<CopysetLeaderHint> *hints,
+                                 uint64_t maxRetryMS) {
+    auto task = RPCTaskDefine {
+        GetChunkServerListInCopySetsResponse response;
+        mdsClientMetric_.getServerList.qps.count << 1;
+        LatencyGuard lg(&mdsClientMetric_.getServerList.latency);
+        MDSClientBase::GetServerList(logicalpooid, copysetidvec, &response,
+                                     cntl, channel);
+        if (cntl->Failed()) {
+            mdsClientMetric_.getServerList.eps.count << 1;
+            LOG(WARNING) << "get copyset leader from mds failed, error is "
+                         << cntl->ErrorText()
+                         << ", log id = " << cntl->log_id();
+            return -cntl->ErrorCode();
+        }
+
+        if (response.statuscode() != 0) {
+            LOG(WARNING) << "GetCopysetLeaderHints failed"
+                         << ", errocde = " << response.statuscode()
+                         << ", log id = " << cntl->log_id();
+            return LIBCURVE_ERROR::FAILED;
+        }
+
+        hints->clear();
+        for (int i = 0; i < response.csinfo_size(); i++) {
+            const CopySetServerInfo& info = response.csinfo(i);
+            CopysetLeaderHint hint;
+            hint.lpid = logicalpooid;
+            hint.cpid = info.copysetid();
+            hint.leaderId = info.leaderchunkserverid();
+            hint.leaderMayChange = info.leadermaychange();
+            hints->push_back(hint);
+        }
+
+        return LIBCURVE_ERROR::OK;
+    };
+    return ReturnError(
+        rpcExcutor_.DoRPCTask(task, maxRetryMS));
+}
+
 LIBCURVE_ERROR MDSClient::GetClusterInfo(ClusterContext *clsctx) {
     auto task = RPCTaskDefine {
         curve::mds::topology::GetClusterInfoResponse response;
@@ -888,12 +931,41 @@ LIBCURVE_ERROR MDSClient::SetCloneFileStatus(const std::string &filename,
 LIBCURVE_ERROR MDSClient::GetOrAllocateSegment(bool allocate, uint64_t offset,
                                                const FInfo_t *fi,
                                                SegmentInfo *segInfo) {
+    std::vector<SegmentInfo> segInfos;
+    LIBCURVE_ERROR ret =
+        GetOrAllocateSegments(allocate, offset, 1, fi, &segInfos);
+    if (ret == LIBCURVE_ERROR::OK) {
+        *segInfo = std::move(segInfos[0]);
+    }
+
+    return ret;
+}
+
+static void PageFileSegment2SegmentInfo(const PageFileSegment &pfs,
+                                        SegmentInfo *segInfo) {
+    segInfo->chunksize = pfs.chunksize();
+    segInfo->segmentsize = pfs.segmentsize();
+    segInfo->startoffset = pfs.startoffset();
+    LogicPoolID logicpoolid = pfs.logicalpoolid();
+    segInfo->lpcpIDInfo.lpid = pfs.logicalpoolid();
+
+    for (int i = 0; i < pfs.chunks_size(); i++) {
+        ChunkID chunkid = pfs.chunks(i).chunkid();
+        CopysetID copysetid = pfs.chunks(i).copysetid();
+        segInfo->lpcpIDInfo.cpidVec.push_back(copysetid);
+        segInfo->chunkvec.emplace_back(chunkid, logicpoolid, copysetid);
+    }
+}
+
+LIBCURVE_ERROR MDSClient::GetOrAllocateSegments(
+    bool allocate, uint64_t offset, uint32_t count, const FInfo_t *fi,
+    std::vector<SegmentInfo> *segInfos, uint64_t maxRetryMS) {
     auto task = RPCTaskDefine {
         GetOrAllocateSegmentResponse response;
         mdsClientMetric_.getOrAllocateSegment.qps.count << 1;
         LatencyGuard lg(&mdsClientMetric_.getOrAllocateSegment.latency);
-        MDSClientBase::GetOrAllocateSegment(allocate, offset, fi, &response,
-                                            cntl, channel);
+        MDSClientBase::GetOrAllocateSegment(allocate, offset, fi, count,
+                                            &response, cntl, channel);
         if (cntl->Failed()) {
             mdsClientMetric_.getOrAllocateSegment.eps.count << 1;
             LOG(WARNING) << "allocate segment failed, error code = "
@@ -921,29 +993,28 @@ LIBCURVE_ERROR MDSClient::GetOrAllocateSegment(bool allocate, uint64_t offset,
             break;
         }
 
-        PageFileSegment pfs = response.pagefilesegment();
-        segInfo->chunksize = pfs.chunksize();
-        segInfo->segmentsize = pfs.segmentsize();
-        segInfo->startoffset = pfs.startoffset();
-        LogicPoolID logicpoolid = pfs.logicalpoolid();
-        segInfo->lpcpIDInfo.lpid = pfs.logicalpoolid();
-
-        int chunksNum = pfs.chunks_size();
-        if (allocate && chunksNum <= 0) {
+        const PageFileSegment &pfs = response.pagefilesegment();
+        if (allocate && pfs.chunks_size() <= 0) {
             LOG(WARNING) << "MDS allocate segment, but no chunkinfo!";
             // Now, we will retry until allocate segment success
             return -LIBCURVE_ERROR::RETRY_UNTIL_SUCCESS;
         }
 
-        for (int i = 0; i < chunksNum; i++) {
-            ChunkID chunkid = pfs.chunks(i).chunkid();
-            CopysetID copysetid = pfs.chunks(i).copysetid();
-            segInfo->lpcpIDInfo.cpidVec.push_back(copysetid);
-            segInfo->chunkvec.emplace_back(chunkid, logicpoolid, copysetid);
+        segInfos->clear();
+        segInfos->resize(1);
+        PageFileSegment2SegmentInfo(pfs, &segInfos->front());
+
+        // 后续segment只是顺带获取的，遇到不完整的就丢弃剩下的部分
+        for (const auto &following : response.followingsegments()) {
+            if (following.chunks_size() <= 0) {
+                break;
+            }
+            segInfos->emplace_back();
+            PageFileSegment2SegmentInfo(following, &segInfos->back());
         }
         return LIBCURVE_ERROR::OK;
     };
-    return ReturnError(rpcExcutor_.DoRPCTask(task, 0));
+    return ReturnError(rpcExcutor_.DoRPCTask(task, maxRetryMS));
 }
 
 LIBCURVE_ERROR MDSClient::DeAllocateSegment(const FInfo *fileInfo,
@@ -209,6 +209,20 @@ class MDSClient : public MDSClientBase,
                   const std::vector<CopysetID> &csid,
                   std::vector<CopysetInfo<ChunkServerID>> *cpinfoVec);
 
+    /**
+     * 获取copyset在mds一侧记录的leader信息，用于提前发现leader变化
+     * @param: logicPoolId逻辑池信息
+     * @param: csid为要获取的copyset列表
+     * @param: hints保存获取到的leader信息
+     * @param: maxRetryMS为最大重试时间，leader信息只作为提示，不需要长时间重试
+     * @return: 成功返回LIBCURVE_ERROR::OK,否则返回LIBCURVE_ERROR::FAILED
+     */
+    LIBCURVE_ERROR
+    GetCopysetLeaderHints(const LogicPoolID &logicPoolId,
+                          const std::vector<CopysetID> &csid,
+                          std::vector<CopysetLeaderHint> *hints,
+                          uint64_t maxRetryMS);
+
     /**
      * 获取当前mds所属的集群信息
      * @param[out]: clsctx 为要获取的集群信息
@@ -230,6 +244,22 @@ class MDSClient : public MDSClientBase,
                                         const FInfo_t *fi,
                                         SegmentInfo *segInfo);
 
+    /**
+     * 批量获取从offset所在segment开始的连续多个segment的chunk信息
+     * @param: allocate为true的时候mds端发现不存在就分配，为false的时候不分配
+     * @param: offset为文件整体偏移
+     * @param: count为期望获取的segment数量，mds端可能返回更少
+     * @param: fi是当前文件的基本信息
+     * @param[out]: segInfos按偏移顺序保存获取到的segment信息，
+     *              成功时至少包含offset所在的segment
+     * @param: maxRetryMS为最大重试时间，为0时一直重试直到成功
+     * @return: 同GetOrAllocateSegment，只由offset所在的segment决定
+     */
+    LIBCURVE_ERROR GetOrAllocateSegments(bool allocate, uint64_t offset,
+                                         uint32_t count, const FInfo_t *fi,
+                                         std::vector<SegmentInfo> *segInfos,
+                                         uint64_t maxRetryMS = 0);
+
     /**
      * @brief Send DeAllocateSegment request to current working MDS
      * @param fileInfo current file info
@@ -352,6 +352,7 @@ void MDSClientBase::SetCloneFileStatus(const std::string& filename,
 void MDSClientBase::GetOrAllocateSegment(bool allocate,
                                          uint64_t offset,
                                          const FInfo_t* fi,
+                                         uint32_t segmentCount,
                                          GetOrAllocateSegmentResponse* response,
                                          brpc::Controller* cntl,
                                          brpc::Channel* channel) {
@@ -364,11 +365,15 @@ void MDSClientBase::GetOrAllocateSegment(bool allocate,
     request.set_filename(fi->fullPathName);
     request.set_offset(seg_offset);
     request.set_allocateifnotexist(allocate);
+    if (segmentCount > 1) {
+        request.set_segmentcount(segmentCount);
+    }
     FillUserInfo(&request, fi->userinfo);
 
     LOG(INFO) << "GetOrAllocateSegment: filename = " << fi->fullPathName
               << ", allocate = " << allocate << ", owner = " << fi->owner
               << ", offset = " << offset << ", segment offset = " << seg_offset
+              << ", segment count = " << segmentCount
               << ", log id = " << cntl->log_id();
 
     curve::mds::CurveFSService_Stub stub(channel);
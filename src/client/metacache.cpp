@@ -404,6 +404,23 @@ void MetaCache::UpdateChunkserverCopysetInfo(LogicPoolID lpid,
     }
 }
 
+std::vector<CopysetLeaderHint> MetaCache::GetCopysetLeaders() {
+    std::vector<CopysetLeaderHint> leaders;
+
+    ReadLockGuard rdlk(rwlock4CopysetInfo_);
+    leaders.reserve(lpcsid2CopsetInfoMap_.size());
+    for (const auto& item : lpcsid2CopsetInfoMap_) {
+        CopysetLeaderHint leader;
+        leader.lpid = static_cast<LogicPoolID>(item.first >> 32);
+        leader.cpid = static_cast<CopysetID>(item.first);
+        item.second.GetCurrentLeaderID(&leader.leaderId);
+        leader.leaderMayChange = item.second.LeaderMayChange();
+        leaders.push_back(leader);
+    }
+
+    return leaders;
+}
+
 CopysetInfo<ChunkServerID> MetaCache::GetCopysetinfo(
     LogicPoolID lpid, CopysetID csid) {
     ReadLockGuard rdlk(rwlock4CopysetInfo_);
@@ -25,6 +25,7 @@
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "src/client/client_common.h"
 #include "src/client/client_config.h"
@@ -233,6 +234,11 @@ class MetaCache {
     virtual CopysetInfo<ChunkServerID> GetCopysetinfo(LogicPoolID lpid,
                                                       CopysetID csid);
 
+    /**
+     * 获取当前缓存的所有copyset及其leader，leader未知时leaderId为0
+     */
+    virtual std::vector<CopysetLeaderHint> GetCopysetLeaders();
+
     UnstableHelper &GetUnstableHelper() { return unstableHelper_; }
 
     uint64_t InodeId() const { return fileInfo_.id; }
@@ -289,6 +289,16 @@ struct CopysetIDInfo {
     CopysetIDInfo &operator=(const CopysetIDInfo &other) = default;
 };
 
+// copyset的leader信息，mds返回的leader来自chunkserver心跳，只作为提示使用
+struct CopysetLeaderHint {
+    LogicPoolID lpid = 0;
+    CopysetID cpid = 0;
+    // leader的chunkserver id，0表示未知
+    ChunkServerID leaderId = 0;
+    // copyset上正在进行配置变更（如transfer leader），leader可能即将变化
+    bool leaderMayChange = false;
+};
+
 inline bool operator<(const CopysetIDInfo &cpidinfo1,
                       const CopysetIDInfo &cpidinfo2) {
     return cpidinfo1.lpid <= cpidinfo2.lpid && cpidinfo1.cpid < cpidinfo2.cpid;
@@ -317,6 +327,8 @@ class FileSegment {
 
     void AcquireReadLock() { rwlock_.RDLock(); }
 
+    bool TryAcquireReadLock() { return rwlock_.TryRDLock() == 0; }
+
     void AcquireWriteLock() { rwlock_.WRLock(); }
 
     void ReleaseLock() { rwlock_.Unlock(); }
@@ -79,7 +79,8 @@ int RequestSender::ReadChunk(const ChunkIDInfo& idinfo,
                              size_t length,
                              uint64_t appliedindex,
                              const RequestSourceInfo& sourceInfo,
-                             ClientClosure *done) {
+                             ClientClosure *done,
+                             bool followerRead) {
     brpc::ClosureGuard doneGuard(done);
     brpc::Controller *cntl = new brpc::Controller();
     ChunkResponse *response = new ChunkResponse();
@@ -102,6 +103,9 @@ int RequestSender::ReadChunk(const ChunkIDInfo& idinfo,
 
     if (iosenderopt_.chunkserverEnableAppliedIndexRead && appliedindex > 0) {
         request.set_appliedindex(appliedindex);
+        if (followerRead) {
+            request.set_followerread(true);
+        }
     }
 
     ChunkService_Stub stub(&channel_);
@@ -62,6 +62,7 @@ class RequestSender {
      * @param appliedindex:需要读到>=appliedIndex的数据
      * @param sourceInfo 数据源信息
      * @param done:上一层异步回调的closure
+     * @param followerRead:是否允许非leader副本在满足appliedindex时直接服务读
      */
     int ReadChunk(const ChunkIDInfo& idinfo,
                   uint64_t sn,
@@ -69,7 +70,8 @@ class RequestSender {
                   size_t length,
                   uint64_t appliedindex,
                   const RequestSourceInfo& sourceInfo,
-                  ClientClosure *done);
+                  ClientClosure *done,
+                  bool followerRead = false);
 
     /**
    * 写Chunk
@@ -0,0 +1,109 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/**
+ * Project: curve
+ * Created Date: 2022-01-12
+ */
+
+#include "src/client/segment_prefetcher.h"
+
+#include <glog/logging.h>
+
+#include "src/client/metacache.h"
+#include "src/client/splitor.h"
+
+namespace curve {
+namespace client {
+
+constexpr size_t SegmentPrefetcher::kMaxPendingSegments;
+
+void SegmentPrefetcher::Init(const SegmentAllocOption& opt,
+                             MetaCache* metaCache, MDSClient* mdsClient) {
+    opt_ = opt;
+    metaCache_ = metaCache;
+    mdsClient_ = mdsClient;
+}
+
+void SegmentPrefetcher::Start() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (!opt_.prefetchEnable || running_) {
+        return;
+    }
+
+    running_ = true;
+    thread_.reset(new std::thread(&SegmentPrefetcher::Run, this));
+    LOG(INFO) << "segment prefetcher started, batch size = "
+              << opt_.batchSize;
+}
+
+void SegmentPrefetcher::Stop() {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (!running_) {
+            return;
+        }
+
+        running_ = false;
+        pending_.clear();
+        pendingSet_.clear();
+    }
+
+    cond_.notify_all();
+    thread_->join();
+    thread_.reset();
+    LOG(INFO) << "segment prefetcher stopped";
+}
+
+void SegmentPrefetcher::Prefetch(SegmentIndex segmentIndex) {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (!running_ || pending_.size() >= kMaxPendingSegments ||
+            !pendingSet_.insert(segmentIndex).second) {
+            return;
+        }
+
+        pending_.push_back(segmentIndex);
+    }
+
+    cond_.notify_one();
+}
+
+void SegmentPrefetcher::Run() {
+    while (true) {
+        SegmentIndex segmentIndex;
+        {
+            std::unique_lock<std::mutex> lk(mtx_);
+            cond_.wait(lk, [this]() { return !running_ || !pending_.empty(); });
+            if (!running_) {
+                return;
+            }
+
+            segmentIndex = pending_.front();
+            pending_.pop_front();
+        }
+
+        Splitor::PrefetchSegments(segmentIndex, mdsClient_, metaCache_,
+                                  metaCache_->GetFileInfo());
+
+        // 处理完之后才从pendingSet_中移除，避免同一个segment被重复提交
+        std::lock_guard<std::mutex> lk(mtx_);
+        pendingSet_.erase(segmentIndex);
+    }
+}
+
+}   // namespace client
+}   // namespace curve
@@ -0,0 +1,90 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/**
+ * Project: curve
+ * Created Date: 2022-01-12
+ */
+
+#ifndef SRC_CLIENT_SEGMENT_PREFETCHER_H_
+#define SRC_CLIENT_SEGMENT_PREFETCHER_H_
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <memory>
+#include <mutex>               // NOLINT
+#include <thread>              // NOLINT
+#include <unordered_set>
+
+#include "src/client/client_common.h"
+#include "src/client/config_info.h"
+
+namespace curve {
+namespace client {
+
+class MDSClient;
+class MetaCache;
+
+/**
+ * 顺序写接近未分配的segment时，在后台线程中提前向mds分配segment，
+ * 使写IO到达该segment时metacache中已经有chunk信息，不用在IO路径上等待mds。
+ * 提交预分配任务不会阻塞IO路径，重复的任务会被忽略。
+ */
+class SegmentPrefetcher {
+ public:
+    SegmentPrefetcher() : metaCache_(nullptr), mdsClient_(nullptr),
+                          running_(false) {}
+
+    ~SegmentPrefetcher() {
+        Stop();
+    }
+
+    void Init(const SegmentAllocOption& opt, MetaCache* metaCache,
+              MDSClient* mdsClient);
+
+    void Start();
+
+    void Stop();
+
+    /**
+     * 提交预分配任务
+     * @param: segmentIndex为需要预分配的segment
+     */
+    void Prefetch(SegmentIndex segmentIndex);
+
+ private:
+    void Run();
+
+ private:
+    // 等待处理的任务数量上限，超过之后新的任务直接丢弃
+    static constexpr size_t kMaxPendingSegments = 16;
+
+    SegmentAllocOption opt_;
+    MetaCache* metaCache_;
+    MDSClient* mdsClient_;
+
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    std::deque<SegmentIndex> pending_;
+    std::unordered_set<SegmentIndex> pendingSet_;
+    bool running_;
+    std::unique_ptr<std::thread> thread_;
+};
+
+}   // namespace client
+}   // namespace curve
+
+#endif  // SRC_CLIENT_SEGMENT_PREFETCHER_H_
@@ -25,6 +25,8 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -208,6 +210,11 @@ bool Splitor::AssignInternal(IOTracker* iotracker, MetaCache* metaCache,
             // acquire filesegment read lock
             fileSegment->AcquireReadLock();
             iotracker->segmentLocks_.emplace_back(fileSegment);
+
+            if (iotracker->Optype() == OpType::WRITE) {
+                MaybePrefetchSegment(iotracker, metaCache, fileInfo,
+                                     segmentIndex, startOffset + len);
+            }
         }
 
         return ret == 0;
@@ -225,64 +232,186 @@ bool Splitor::GetOrAllocateSegment(bool allocateIfNotExist,
                                    MetaCache* metaCache,
                                    const FInfo* fileInfo,
                                    ChunkIndex chunkidx) {
-    SegmentInfo segmentInfo;
-    LIBCURVE_ERROR errCode = mdsClient->GetOrAllocateSegment(
-        allocateIfNotExist, offset, fileInfo, &segmentInfo);
+    // 新卷的顺序写每跨过一个segment都要同步等待一次mds，
+    // 这里顺带把后面还没有缓存的segment一起分配回来
+    std::vector<FileSegment*> lockedSegments;
+    const uint32_t batchSize = iosplitopt_.segmentAllocOpt.batchSize;
+    if (allocateIfNotExist && batchSize > 1) {
+        SegmentIndex segmentIndex = offset / fileInfo->segmentsize;
+        TryLockUncachedSegments(metaCache, fileInfo, segmentIndex + 1,
+                                batchSize - 1, &lockedSegments);
+    }
 
-    if (errCode == LIBCURVE_ERROR::FAILED ||
-        errCode == LIBCURVE_ERROR::AUTHFAIL) {
-        LOG(ERROR) << "GetOrAllocateSegmen failed, filename: "
-                   << fileInfo->filename << ", offset: " << offset;
-        return false;
-    } else if (errCode == LIBCURVE_ERROR::NOT_ALLOCATE) {
+    bool ret = FetchSegments(allocateIfNotExist, offset,
+                             1 + lockedSegments.size(), mdsClient, metaCache,
+                             fileInfo, chunkidx, 0);
+
+    for (auto* segment : lockedSegments) {
+        segment->ReleaseLock();
+    }
+
+    return ret;
+}
+
+bool Splitor::PrefetchSegments(SegmentIndex segmentIndex,
+                               MDSClient* mdsClient,
+                               MetaCache* metaCache,
+                               const FInfo* fileInfo) {
+    const SegmentAllocOption& opt = iosplitopt_.segmentAllocOpt;
+
+    std::vector<FileSegment*> lockedSegments;
+    TryLockUncachedSegments(metaCache, fileInfo, segmentIndex,
+                            std::max(1u, opt.batchSize), &lockedSegments);
+    if (lockedSegments.empty()) {
+        return true;
+    }
+
+    uint64_t offset =
+        static_cast<uint64_t>(segmentIndex) * fileInfo->segmentsize;
+    bool ret = FetchSegments(true, offset, lockedSegments.size(), mdsClient,
+                             metaCache, fileInfo,
+                             offset / fileInfo->chunksize,
+                             opt.prefetchRPCMaxRetryMS);
+
+    for (auto* segment : lockedSegments) {
+        segment->ReleaseLock();
+    }
+
+    LOG_IF(WARNING, !ret) << "prefetch segment failed, filename: "
+                          << fileInfo->filename
+                          << ", segment index: " << segmentIndex;
+    return ret;
+}
+
+bool Splitor::IsSegmentCached(MetaCache* metaCache, const FInfo* fileInfo,
+                              SegmentIndex segmentIndex) {
+    ChunkIndex chunkidx = static_cast<uint64_t>(segmentIndex) *
+                          fileInfo->segmentsize / fileInfo->chunksize;
+    ChunkIDInfo chunkIdInfo;
+    return metaCache->GetChunkInfoByIndex(chunkidx, &chunkIdInfo) ==
+               MetaCacheErrorType::OK &&
+           chunkIdInfo.chunkExist;
+}
+
+uint32_t Splitor::TryLockUncachedSegments(
+    MetaCache* metaCache, const FInfo* fileInfo, SegmentIndex segmentIndex,
+    uint32_t maxCount, std::vector<FileSegment*>* lockedSegments) {
+    const uint64_t segmentCount = fileInfo->length / fileInfo->segmentsize;
+
+    // 只处理连续的、还没有缓存的segment，并且要持有segment的读锁，
+    // 避免和discard并发时把已经被释放的segment重新写回metacache
+    for (uint32_t i = 0; i < maxCount; ++i) {
+        SegmentIndex index = segmentIndex + i;
+        if (index >= segmentCount ||
+            IsSegmentCached(metaCache, fileInfo, index)) {
+            break;
+        }
+
+        FileSegment* segment = metaCache->GetFileSegment(index);
+        if (!segment->TryAcquireReadLock()) {
+            break;
+        }
+
+        lockedSegments->push_back(segment);
+    }
+
+    return lockedSegments->size();
+}
+
+bool Splitor::FetchSegments(bool allocateIfNotExist,
+                            uint64_t offset,
+                            uint32_t count,
+                            MDSClient* mdsClient,
+                            MetaCache* metaCache,
+                            const FInfo* fileInfo,
+                            ChunkIndex chunkidx,
+                            uint64_t maxRetryMS) {
+    std::vector<SegmentInfo> segmentInfos;
+    LIBCURVE_ERROR errCode = mdsClient->GetOrAllocateSegments(
+        allocateIfNotExist, offset, count, fileInfo, &segmentInfos,
+        maxRetryMS);
+
+    if (errCode == LIBCURVE_ERROR::NOT_ALLOCATE) {
         // this chunkIdInfo(0, 0, 0) identify the unallocated chunk when read
         ChunkIDInfo chunkIdInfo(0, 0, 0);
         chunkIdInfo.chunkExist = false;
         metaCache->UpdateChunkInfoByIndex(chunkidx, chunkIdInfo);
         return true;
+    } else if (errCode != LIBCURVE_ERROR::OK || segmentInfos.empty()) {
+        LOG(ERROR) << "GetOrAllocateSegmen failed, filename: "
+                   << fileInfo->filename << ", offset: " << offset;
+        return false;
     }
 
     const auto chunksize = fileInfo->chunksize;
-    uint32_t count = 0;
-    for (const auto& chunkIdInfo : segmentInfo.chunkvec) {
-        uint64_t chunkIdx =
-            (segmentInfo.startoffset + count * chunksize) / chunksize;
-        metaCache->UpdateChunkInfoByIndex(chunkIdx, chunkIdInfo);
-        ++count;
+    std::map<LogicPoolID, std::set<CopysetID>> copysets;
+    for (const auto& segmentInfo : segmentInfos) {
+        uint64_t chunkIdx = segmentInfo.startoffset / chunksize;
+        for (const auto& chunkIdInfo : segmentInfo.chunkvec) {
+            metaCache->UpdateChunkInfoByIndex(chunkIdx++, chunkIdInfo);
+        }
+
+        copysets[segmentInfo.lpcpIDInfo.lpid].insert(
+            segmentInfo.lpcpIDInfo.cpidVec.begin(),
+            segmentInfo.lpcpIDInfo.cpidVec.end());
     }
 
-    std::vector<CopysetInfo<ChunkServerID>> copysetInfos;
-    errCode = mdsClient->GetServerList(segmentInfo.lpcpIDInfo.lpid,
-                                       segmentInfo.lpcpIDInfo.cpidVec,
-                                       &copysetInfos);
+    for (const auto& pool : copysets) {
+        const LogicPoolID lpid = pool.first;
+        std::vector<CopysetID> cpidVec(pool.second.begin(),
+                                       pool.second.end());
+        std::vector<CopysetInfo<ChunkServerID>> copysetInfos;
+        errCode = mdsClient->GetServerList(lpid, cpidVec, &copysetInfos);
+
+        if (errCode == LIBCURVE_ERROR::FAILED) {
+            std::string failedCopysets;
+            for (const auto& id : cpidVec) {
+                failedCopysets.append(std::to_string(id)).append(",");
+            }
+
+            LOG(ERROR) << "GetServerList failed, logicpool id: " << lpid
+                       << ", copysets: " << failedCopysets;
 
-    if (errCode == LIBCURVE_ERROR::FAILED) {
-        std::string failedCopysets;
-        for (const auto& id : segmentInfo.lpcpIDInfo.cpidVec) {
-            failedCopysets.append(std::to_string(id)).append(",");
+            return false;
         }
 
-        LOG(ERROR) << "GetServerList failed, logicpool id: "
-                   << segmentInfo.lpcpIDInfo.lpid
-                   << ", copysets: " << failedCopysets;
+        for (const auto& copysetInfo : copysetInfos) {
+            for (const auto& peerInfo : copysetInfo.csinfos_) {
+                metaCache->AddCopysetIDInfo(
+                    peerInfo.peerID, CopysetIDInfo(lpid, copysetInfo.cpid_));
+            }
+        }
 
-        return false;
+        for (const auto& copysetInfo : copysetInfos) {
+            metaCache->UpdateCopysetInfo(lpid, copysetInfo.cpid_,
+                                         copysetInfo);
+        }
     }
 
-    for (const auto& copysetInfo : copysetInfos) {
-        for (const auto& peerInfo : copysetInfo.csinfos_) {
-            metaCache->AddCopysetIDInfo(
-                peerInfo.peerID,
-                CopysetIDInfo(segmentInfo.lpcpIDInfo.lpid, copysetInfo.cpid_));
-        }
+    return true;
+}
+
+void Splitor::MaybePrefetchSegment(IOTracker* iotracker,
+                                   MetaCache* metaCache,
+                                   const FInfo* fileInfo,
+                                   SegmentIndex segmentIndex,
+                                   uint64_t endOffsetInSegment) {
+    const SegmentAllocOption& opt = iosplitopt_.segmentAllocOpt;
+    if (!opt.prefetchEnable ||
+        endOffsetInSegment * 100 <
+            static_cast<uint64_t>(fileInfo->segmentsize) *
+                opt.prefetchTriggerPercent) {
+        return;
     }
 
-    for (const auto& copysetInfo : copysetInfos) {
-        metaCache->UpdateCopysetInfo(segmentInfo.lpcpIDInfo.lpid,
-                                     copysetInfo.cpid_, copysetInfo);
+    SegmentIndex next = segmentIndex + 1;
+    if (static_cast<uint64_t>(next + 1) * fileInfo->segmentsize >
+            fileInfo->length ||
+        IsSegmentCached(metaCache, fileInfo, next)) {
+        return;
     }
 
-    return true;
+    iotracker->PrefetchSegment(next);
 }
 
 int Splitor::SplitForNormal(IOTracker* iotracker, MetaCache* metaCache,
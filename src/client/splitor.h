@@ -99,6 +99,20 @@ class Splitor {
                                          const ChunkIDInfo& chunkInfo,
                                          const MetaCache* metaCache);
 
+    /**
+     * 在后台获取(分配)从segmentIndex开始的连续segment，并更新到metacache
+     * 已经缓存或者正在被其他操作加锁的segment会被跳过
+     * @param: segmentIndex为需要预分配的第一个segment
+     * @param: mdsClient用于向mds获取segment信息
+     * @param: metaCache为当前文件的缓存信息
+     * @param: fileInfo为当前文件的基本信息
+     * @return: 成功或者没有需要处理的segment时返回true，否则返回false
+     */
+    static bool PrefetchSegments(SegmentIndex segmentIndex,
+                                 MDSClient* mdsClient,
+                                 MetaCache* metaCache,
+                                 const FInfo* fileInfo);
+
  private:
     /**
      * IO2ChunkRequests内部会调用这个函数，进行真正的拆分操作
@@ -129,6 +143,35 @@ class Splitor {
                                      const FInfo* fileInfo,
                                      ChunkIndex chunkidx);
 
+    static bool IsSegmentCached(MetaCache* metaCache,
+                                const FInfo* fileInfo,
+                                SegmentIndex segmentIndex);
+
+    /**
+     * 从segmentIndex开始，对连续的、未缓存的segment加读锁
+     * @param[out]: lockedSegments为加锁成功的segment，由调用者负责解锁
+     * @return: 加锁成功的segment数量
+     */
+    static uint32_t TryLockUncachedSegments(
+        MetaCache* metaCache, const FInfo* fileInfo,
+        SegmentIndex segmentIndex, uint32_t maxCount,
+        std::vector<FileSegment*>* lockedSegments);
+
+    static bool FetchSegments(bool allocateIfNotExist,
+                              uint64_t offset,
+                              uint32_t count,
+                              MDSClient* mdsClient,
+                              MetaCache* metaCache,
+                              const FInfo* fileInfo,
+                              ChunkIndex chunkidx,
+                              uint64_t maxRetryMS);
+
+    static void MaybePrefetchSegment(IOTracker* iotracker,
+                                     MetaCache* metaCache,
+                                     const FInfo* fileInfo,
+                                     SegmentIndex segmentIndex,
+                                     uint64_t endOffsetInSegment);
+
     static int SplitForNormal(IOTracker* iotracker, MetaCache* metaCache,
                               std::vector<RequestContext*>* targetlist,
                               butil::IOBuf* data, off_t offset, size_t length,
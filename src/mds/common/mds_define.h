@@ -51,6 +51,10 @@ const int kCsClientCSOffline = -6;
 // to prevent the request from being intercepted and played back
 const uint64_t kStaledRequestTimeIntervalUs = 15 * 1000 * 1000u;
 
+// max number of segments one GetOrAllocateSegment request can get or
+// allocate, to bound the time the file lock is held
+const uint32_t kMaxSegmentsPerGetOrAllocate = 64;
+
 }  // namespace mds
 }  // namespace curve
 
@@ -28,6 +28,8 @@
 #include <set>
 #include <utility>
 #include <map>
+#include <algorithm>
+#include <vector>
 #include "src/common/string_util.h"
 #include "src/common/encode.h"
 #include "src/common/timeutility.h"
@@ -1135,33 +1137,87 @@ StatusCode CurveFS::ChangeOwner(const std::string &filename,
     return PutFile(fileInfo);
 }
 
-StatusCode CurveFS::GetOrAllocateSegment(const std::string & filename,
-        offset_t offset, bool allocateIfNoExist,
-        PageFileSegment *segment) {
-    assert(segment != nullptr);
-
-    FileInfo  fileInfo;
-    auto ret = GetFileInfo(filename, &fileInfo);
+StatusCode CurveFS::GetSegmentFileInfo(const std::string & filename,
+        offset_t offset, FileInfo *fileInfo) {
+    auto ret = GetFileInfo(filename, fileInfo);
     if (ret != StatusCode::kOK) {
         LOG(INFO) << "get source file error, errCode = " << ret;
         return  ret;
     }
 
-    if (fileInfo.filetype() != FileType::INODE_PAGEFILE) {
+    if (fileInfo->filetype() != FileType::INODE_PAGEFILE) {
         LOG(INFO) << "not pageFile, can't do this";
         return StatusCode::kParaError;
     }
 
-    if (offset % fileInfo.segmentsize() != 0) {
+    if (offset % fileInfo->segmentsize() != 0) {
         LOG(INFO) << "offset not align with segment";
         return StatusCode::kParaError;
     }
 
-    if (offset + fileInfo.segmentsize() > fileInfo.length()) {
+    if (offset + fileInfo->segmentsize() > fileInfo->length()) {
         LOG(INFO) << "bigger than file length, first extentFile";
         return StatusCode::kParaError;
     }
 
+    return StatusCode::kOK;
+}
+
+StatusCode CurveFS::GetOrAllocateSegment(const std::string & filename,
+        offset_t offset, bool allocateIfNoExist,
+        PageFileSegment *segment) {
+    assert(segment != nullptr);
+
+    FileInfo  fileInfo;
+    auto ret = GetSegmentFileInfo(filename, offset, &fileInfo);
+    if (ret != StatusCode::kOK) {
+        return ret;
+    }
+
+    return GetOrAllocateSegmentInternal(filename, fileInfo, offset,
+                                        allocateIfNoExist, segment);
+}
+
+StatusCode CurveFS::GetOrAllocateSegments(const std::string & filename,
+        offset_t offset, uint32_t count, bool allocateIfNoExist,
+        std::vector<PageFileSegment> *segments) {
+    assert(segments != nullptr);
+    segments->clear();
+
+    FileInfo  fileInfo;
+    auto ret = GetSegmentFileInfo(filename, offset, &fileInfo);
+    if (ret != StatusCode::kOK) {
+        return ret;
+    }
+
+    count = std::max(1u, std::min(count, kMaxSegmentsPerGetOrAllocate));
+    for (uint32_t i = 0; i < count; ++i) {
+        offset_t segOffset =
+            offset + static_cast<offset_t>(i) * fileInfo.segmentsize();
+        if (segOffset + fileInfo.segmentsize() > fileInfo.length()) {
+            break;
+        }
+
+        PageFileSegment segment;
+        ret = GetOrAllocateSegmentInternal(filename, fileInfo, segOffset,
+                                           allocateIfNoExist, &segment);
+        if (ret != StatusCode::kOK) {
+            // only the first segment decides the result, the following ones
+            // are best effort
+            if (i == 0) {
+                return ret;
+            }
+            break;
+        }
+        segments->emplace_back(std::move(segment));
+    }
+
+    return StatusCode::kOK;
+}
+
+StatusCode CurveFS::GetOrAllocateSegmentInternal(const std::string & filename,
+        const FileInfo & fileInfo, offset_t offset, bool allocateIfNoExist,
+        PageFileSegment *segment) {
     auto storeRet = storage_->GetSegment(fileInfo.id(), offset, segment);
     if (storeRet == StoreStatus::OK) {
         return StatusCode::kOK;
@@ -273,6 +273,26 @@ class CurveFS {
         offset_t offset,
         bool allocateIfNoExist, PageFileSegment *segment);
 
+    /**
+     *  @brief get or allocate at most count consecutive segments starting
+     *         at offset. The first segment is handled the same as
+     *         GetOrAllocateSegment, the following ones stop at the end of
+     *         file or at the first one that fails
+     *
+     *  @param filename
+     *  @param offset
+     *  @param count: number of segments wanted, capped by
+     *                kMaxSegmentsPerGetOrAllocate
+     *  @param allocateIfNoExist: If the segment does not exist,
+     *                            whether or not creating a new one
+     *  @param segments: Return the queried segments in offset order
+     *  @return status of the first segment
+     */
+    StatusCode GetOrAllocateSegments(
+        const std::string & filename,
+        offset_t offset, uint32_t count,
+        bool allocateIfNoExist, std::vector<PageFileSegment> *segments);
+
     /**
      * @brief deallocate file segment start at offset
      * @param filename
@@ -599,6 +619,25 @@ class CurveFS {
 
     StatusCode PutFile(const FileInfo & fileInfo);
 
+    /**
+     * @brief get fileinfo of a pagefile and check offset of the segment
+     * @param filename
+     * @param offset: offset of the segment
+     * @param[out] fileInfo
+     * @return StatusCode::kOK if the segment can be get or allocated
+     */
+    StatusCode GetSegmentFileInfo(const std::string & filename,
+                                  offset_t offset, FileInfo *fileInfo);
+
+    /**
+     * @brief get or allocate segment of a checked file
+     */
+    StatusCode GetOrAllocateSegmentInternal(const std::string & filename,
+                                            const FileInfo & fileInfo,
+                                            offset_t offset,
+                                            bool allocateIfNoExist,
+                                            PageFileSegment *segment);
+
     /**
      * @brief Execute a snapshot transaction of a fileinfo
      * @param originalFileInfo: fileInfo of the original file
@@ -449,10 +449,25 @@ void NameSpaceService::GetOrAllocateSegment(
         return;
     }
 
-    retCode = kCurveFS.GetOrAllocateSegment(request->filename(),
-                request->offset(),
-                request->allocateifnotexist(),
-                response->mutable_pagefilesegment());
+    if (request->has_segmentcount() && request->segmentcount() > 1) {
+        std::vector<PageFileSegment> segments;
+        retCode = kCurveFS.GetOrAllocateSegments(request->filename(),
+                    request->offset(),
+                    request->segmentcount(),
+                    request->allocateifnotexist(),
+                    &segments);
+        if (retCode == StatusCode::kOK) {
+            response->mutable_pagefilesegment()->Swap(&segments[0]);
+            for (size_t i = 1; i < segments.size(); ++i) {
+                response->add_followingsegments()->Swap(&segments[i]);
+            }
+        }
+    } else {
+        retCode = kCurveFS.GetOrAllocateSegment(request->filename(),
+                    request->offset(),
+                    request->allocateifnotexist(),
+                    response->mutable_pagefilesegment());
+    }
 
     if (retCode != StatusCode::kOK)  {
         response->set_statuscode(retCode);
@@ -476,12 +491,15 @@ void NameSpaceService::GetOrAllocateSegment(
                 << ", cost " << expiredTime.ExpiredMs() << " ms";
         }
         response->clear_pagefilesegment();
+        response->clear_followingsegments();
     } else {
         response->set_statuscode(StatusCode::kOK);
         LOG(INFO) << "logid = " << cntl->log_id()
                   << ", GetOrAllocateSegment ok, filename = "
                   << request->filename() << ", offset = " << request->offset()
                   << ", allocateTag = " << request->allocateifnotexist()
+                  << ", segment count = "
+                  << 1 + response->followingsegments_size()
                   << ", cost " << expiredTime.ExpiredMs() << " ms";
     }
     return;
@@ -1342,6 +1342,10 @@ void TopologyServiceManager::GetChunkServerListInCopySets(
         if (topology_->GetCopySet(key, &csInfo)) {
             CopySetServerInfo *cssInfo = response->add_csinfo();
             cssInfo->set_copysetid(csInfo.GetId());
+            if (csInfo.GetLeader() != UNINTIALIZE_ID) {
+                cssInfo->set_leaderchunkserverid(csInfo.GetLeader());
+            }
+            cssInfo->set_leadermaychange(csInfo.HasCandidate());
             for (ChunkServerIdType csId : csInfo.GetCopySetMembers()) {
                 ChunkServer cs;
                 if (topology_->GetChunkServer(csId, &cs)) {
@@ -3938,5 +3938,213 @@ TEST(CopysetClientBasicTest, TestReScheduleWhenSessionNotValid) {
     }
 }
 
+static void SlowLeaderReadChunkFunc(
+    ::google::protobuf::RpcController *controller,
+    const ::curve::chunkserver::ChunkRequest *request,
+    ::curve::chunkserver::ChunkResponse *response,
+    google::protobuf::Closure *done) {
+    brpc::ClosureGuard doneGuard(done);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    brpc::Controller *cntl = dynamic_cast<brpc::Controller *>(controller);
+    response->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS);
+    cntl->response_attachment().append(std::string(request->size(), 'a'));
+}
+
+static void FollowerReadChunkFunc(
+    ::google::protobuf::RpcController *controller,
+    const ::curve::chunkserver::ChunkRequest *request,
+    ::curve::chunkserver::ChunkResponse *response,
+    google::protobuf::Closure *done) {
+    brpc::ClosureGuard doneGuard(done);
+    brpc::Controller *cntl = dynamic_cast<brpc::Controller *>(controller);
+    if (!request->followerread() || !request->has_appliedindex()) {
+        response->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_REDIRECTED);
+        return;
+    }
+    response->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS);
+    cntl->response_attachment().append(std::string(request->size(), 'b'));
+}
+
+static void SlowLeaderRedirectReadChunkFunc(
+    ::google::protobuf::RpcController *controller,
+    const ::curve::chunkserver::ChunkRequest *request,
+    ::curve::chunkserver::ChunkResponse *response,
+    google::protobuf::Closure *done) {
+    brpc::ClosureGuard doneGuard(done);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    response->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_REDIRECTED);
+}
+
+static void SlowFollowerReadChunkFunc(
+    ::google::protobuf::RpcController *controller,
+    const ::curve::chunkserver::ChunkRequest *request,
+    ::curve::chunkserver::ChunkResponse *response,
+    google::protobuf::Closure *done) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    FollowerReadChunkFunc(controller, request, response, done);
+}
+
+TEST_F(CopysetClientTest, hedged_read_test) {
+    MockChunkServiceImpl leaderService;
+    ASSERT_EQ(server_->AddService(&leaderService,
+                                  brpc::SERVER_DOESNT_OWN_SERVICE), 0);
+    ASSERT_EQ(server_->Start(listenAddr_.c_str(), nullptr), 0);
+
+    std::string followerStr = "127.0.0.1:9110";
+    brpc::Server followerServer;
+    MockChunkServiceImpl followerService;
+    ASSERT_EQ(followerServer.AddService(&followerService,
+                                        brpc::SERVER_DOESNT_OWN_SERVICE), 0);
+    ASSERT_EQ(followerServer.Start(followerStr.c_str(), nullptr), 0);
+
+    IOSenderOption ioSenderOpt;
+    ioSenderOpt.failRequestOpt.chunkserverRPCTimeoutMS = 5000;
+    ioSenderOpt.failRequestOpt.chunkserverOPMaxRetry = 3;
+    ioSenderOpt.failRequestOpt.chunkserverOPRetryIntervalUS = 500;
+    ioSenderOpt.chunkserverEnableAppliedIndexRead = 1;
+    ioSenderOpt.hedgedReadOpt.enable = true;
+    ioSenderOpt.hedgedReadOpt.minDelayMS = 50;
+    ioSenderOpt.hedgedReadOpt.maxHedgeRatio = 100;
+
+    RequestScheduleOption reqopt;
+    reqopt.ioSenderOpt = ioSenderOpt;
+
+    LogicPoolID logicPoolId = 1;
+    CopysetID copysetId = 100001;
+    ChunkID chunkId = 1;
+    uint64_t sn = 1;
+    size_t len = 8;
+    off_t offset = 0;
+
+    butil::EndPoint leaderAddr;
+    butil::EndPoint followerAddr;
+    butil::str2endpoint(listenAddr_.c_str(), &leaderAddr);
+    butil::str2endpoint(followerStr.c_str(), &followerAddr);
+
+    MetaCache metaCache;
+    CopysetInfo<ChunkServerID> cpinfo;
+    cpinfo.lpid_ = logicPoolId;
+    cpinfo.cpid_ = copysetId;
+    cpinfo.AddCopysetPeerInfo(CopysetPeerInfo<ChunkServerID>(
+        10000, PeerAddr(leaderAddr), PeerAddr(leaderAddr)));
+    cpinfo.AddCopysetPeerInfo(CopysetPeerInfo<ChunkServerID>(
+        10001, PeerAddr(followerAddr), PeerAddr(followerAddr)));
+    ASSERT_EQ(0, cpinfo.UpdateLeaderInfo(PeerAddr(leaderAddr)));
+    metaCache.UpdateCopysetInfo(logicPoolId, copysetId, cpinfo);
+
+    RequestScheduler scheduler;
+    scheduler.Init(reqopt, &metaCache);
+    scheduler.Run();
+
+    FileMetric fm("hedged_read_test");
+    CopysetClient copysetClient;
+    ASSERT_EQ(0, copysetClient.Init(&metaCache, ioSenderOpt, &scheduler, &fm));
+
+    IOTracker iot(nullptr, nullptr, nullptr, &fm);
+    iot.PrepareReadIOBuffers(1);
+
+    /* leader响应慢，follower上的备份读先返回 */
+    {
+        RequestContext *reqCtx = new FakeRequestContext();
+        reqCtx->optype_ = OpType::READ;
+        reqCtx->idinfo_ = ChunkIDInfo(chunkId, logicPoolId, copysetId);
+        reqCtx->subIoIndex_ = 0;
+        reqCtx->offset_ = 0;
+        reqCtx->rawlength_ = len;
+
+        curve::common::CountDownEvent cond(1);
+        RequestClosure *reqDone = new FakeRequestClosure(&cond, reqCtx);
+        reqDone->SetFileMetric(&fm);
+        reqDone->SetIOTracker(&iot);
+        reqCtx->done_ = reqDone;
+
+        EXPECT_CALL(leaderService, ReadChunk(_, _, _, _)).Times(1)
+            .WillOnce(Invoke(SlowLeaderReadChunkFunc));
+        EXPECT_CALL(followerService, ReadChunk(_, _, _, _)).Times(1)
+            .WillOnce(Invoke(FollowerReadChunkFunc));
+
+        uint64_t start = TimeUtility::GetTimeofDayMs();
+        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+                                offset, len, 1, {}, reqDone);
+        cond.Wait();
+        uint64_t end = TimeUtility::GetTimeofDayMs();
+
+        ASSERT_EQ(0, reqDone->GetErrorCode());
+        ASSERT_EQ(std::string(len, 'b'), reqCtx->readData_.to_string());
+        ASSERT_LT(end - start, 500);
+
+        // 等待leader返回，leader的返回直接被丢弃
+        std::this_thread::sleep_for(std::chrono::milliseconds(600));
+        delete reqDone;
+        delete reqCtx;
+    }
+
+    /* leader返回需要重试的结果，等待还未返回的备份读，而不是丢弃它 */
+    {
+        RequestContext *reqCtx = new FakeRequestContext();
+        reqCtx->optype_ = OpType::READ;
+        reqCtx->idinfo_ = ChunkIDInfo(chunkId, logicPoolId, copysetId);
+        reqCtx->subIoIndex_ = 0;
+        reqCtx->offset_ = 0;
+        reqCtx->rawlength_ = len;
+
+        curve::common::CountDownEvent cond(1);
+        RequestClosure *reqDone = new FakeRequestClosure(&cond, reqCtx);
+        reqDone->SetFileMetric(&fm);
+        reqDone->SetIOTracker(&iot);
+        reqCtx->done_ = reqDone;
+
+        EXPECT_CALL(leaderService, ReadChunk(_, _, _, _)).Times(1)
+            .WillOnce(Invoke(SlowLeaderRedirectReadChunkFunc));
+        EXPECT_CALL(followerService, ReadChunk(_, _, _, _)).Times(1)
+            .WillOnce(Invoke(SlowFollowerReadChunkFunc));
+
+        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+                                offset, len, 1, {}, reqDone);
+        cond.Wait();
+
+        ASSERT_EQ(0, reqDone->GetErrorCode());
+        ASSERT_EQ(std::string(len, 'b'), reqCtx->readData_.to_string());
+        delete reqDone;
+        delete reqCtx;
+    }
+
+    /* 不携带appliedindex的读不发送备份读 */
+    {
+        RequestContext *reqCtx = new FakeRequestContext();
+        reqCtx->optype_ = OpType::READ;
+        reqCtx->idinfo_ = ChunkIDInfo(chunkId, logicPoolId, copysetId);
+        reqCtx->subIoIndex_ = 0;
+        reqCtx->offset_ = 0;
+        reqCtx->rawlength_ = len;
+
+        curve::common::CountDownEvent cond(1);
+        RequestClosure *reqDone = new FakeRequestClosure(&cond, reqCtx);
+        reqDone->SetFileMetric(&fm);
+        reqDone->SetIOTracker(&iot);
+        reqCtx->done_ = reqDone;
+
+        EXPECT_CALL(leaderService, ReadChunk(_, _, _, _)).Times(1)
+            .WillOnce(Invoke(SlowLeaderReadChunkFunc));
+        EXPECT_CALL(followerService, ReadChunk(_, _, _, _)).Times(0);
+
+        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+                                offset, len, 0, {}, reqDone);
+        cond.Wait();
+
+        ASSERT_EQ(0, reqDone->GetErrorCode());
+        ASSERT_EQ(std::string(len, 'a'), reqCtx->readData_.to_string());
+        delete reqDone;
+        delete reqCtx;
+    }
+
+    ASSERT_EQ(2, fm.hedgedReadQPS.count.get_value());
+    ASSERT_EQ(2, fm.hedgedReadWinQPS.count.get_value());
+
+    followerServer.Stop(0);
+    followerServer.Join();
+    scheduler.Fini();
+}
+
 }   // namespace client
 }   // namespace curve
@@ -0,0 +1,148 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Date: 2022-01-10
+ */
+
+#include "src/client/leader_refresher.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "test/client/mock/mock_meta_cache.h"
+
+namespace curve {
+namespace client {
+
+using ::testing::Invoke;
+
+class LeaderRefresherTest : public ::testing::Test {
+ protected:
+    static MetaCacheOption MakeOption(bool enable, uint32_t intervalMS) {
+        MetaCacheOption opt;
+        opt.leaderRefreshEnable = enable;
+        opt.leaderRefreshIntervalMS = intervalMS;
+        return opt;
+    }
+
+    // metacache中没有缓存copyset，刷新时只记录次数，不会访问mds
+    static void CountRefresh(MockMetaCache* metaCache,
+                             std::atomic<int>* count) {
+        EXPECT_CALL(*metaCache, GetCopysetLeaders())
+            .WillRepeatedly(Invoke([count]() {
+                count->fetch_add(1);
+                return std::vector<CopysetLeaderHint>();
+            }));
+    }
+
+    static bool WaitFor(const std::atomic<int>& count, int expected) {
+        for (int i = 0; i < 500 && count.load() < expected; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return count.load() >= expected;
+    }
+
+    static void Sleep(uint32_t ms) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+};
+
+TEST_F(LeaderRefresherTest, RegisterDisabledTest) {
+    auto& refresher = LeaderRefresher::GetInstance();
+
+    MockMetaCache metaCache;
+    EXPECT_CALL(metaCache, GetCopysetLeaders()).Times(0);
+    refresher.Register(MakeOption(false, 10), &metaCache, nullptr, nullptr);
+    Sleep(100);
+
+    // 没有注册的文件直接返回
+    refresher.Unregister(&metaCache);
+}
+
+TEST_F(LeaderRefresherTest, IntervalOfEachFileTest) {
+    auto& refresher = LeaderRefresher::GetInstance();
+
+    MockMetaCache slowFile;
+    MockMetaCache fastFile;
+    std::atomic<int> slowCount{0};
+    std::atomic<int> fastCount{0};
+    CountRefresh(&slowFile, &slowCount);
+    CountRefresh(&fastFile, &fastCount);
+
+    // 后注册的文件间隔更短，不需要等待先注册文件的间隔就开始刷新
+    refresher.Register(MakeOption(true, 1000), &slowFile, nullptr, nullptr);
+    refresher.Register(MakeOption(true, 50), &fastFile, nullptr, nullptr);
+    Sleep(500);
+    ASSERT_GE(fastCount.load(), 4);
+    ASSERT_EQ(0, slowCount.load());
+
+    // 每个文件仍然按照自己的间隔刷新
+    ASSERT_TRUE(WaitFor(slowCount, 1));
+    ASSERT_LE(slowCount.load(), 2);
+
+    // 注销之后不再刷新
+    refresher.Unregister(&fastFile);
+    int count = fastCount.load();
+    Sleep(200);
+    ASSERT_EQ(count, fastCount.load());
+
+    refresher.Unregister(&slowFile);
+}
+
+TEST_F(LeaderRefresherTest, UnregisterAndStopTest) {
+    auto& refresher = LeaderRefresher::GetInstance();
+
+    // 注销等待正在进行的刷新结束
+    MockMetaCache metaCache;
+    std::atomic<bool> refreshing{false};
+    std::atomic<int> count{0};
+    EXPECT_CALL(metaCache, GetCopysetLeaders())
+        .WillRepeatedly(Invoke([&]() {
+            refreshing = true;
+            Sleep(200);
+            refreshing = false;
+            count.fetch_add(1);
+            return std::vector<CopysetLeaderHint>();
+        }));
+    refresher.Register(MakeOption(true, 10), &metaCache, nullptr, nullptr);
+    for (int i = 0; i < 500 && !refreshing.load(); ++i) {
+        Sleep(10);
+    }
+    ASSERT_TRUE(refreshing.load());
+    refresher.Unregister(&metaCache);
+    ASSERT_FALSE(refreshing.load());
+    int refreshed = count.load();
+    Sleep(100);
+    ASSERT_EQ(refreshed, count.load());
+
+    // 最后一个文件注销时后台线程停止，再次注册时重新启动
+    MockMetaCache otherFile;
+    std::atomic<int> otherCount{0};
+    CountRefresh(&otherFile, &otherCount);
+    refresher.Register(MakeOption(true, 10), &otherFile, nullptr, nullptr);
+    ASSERT_TRUE(WaitFor(otherCount, 3));
+    refresher.Unregister(&otherFile);
+}
+
+}  // namespace client
+}  // namespace curve
@@ -28,6 +28,7 @@
 #include <gtest/gtest.h>
 
 #include <string>
+#include <vector>
 
 #include "test/client/mock/mock_namespace_service.h"
 
@@ -38,6 +39,7 @@ using ::testing::_;
 using ::testing::DoAll;
 using ::testing::Invoke;
 using ::testing::Return;
+using ::testing::SaveArgPointee;
 using ::testing::SetArgPointee;
 
 constexpr uint64_t kGiB = 1024ull * 1024 * 1024;
@@ -417,5 +419,53 @@ TEST_F(MDSClientTest, TestOpenFile) {
     }
 }
 
+TEST_F(MDSClientTest, TestGetOrAllocateSegments) {
+    FInfo fileInfo;
+    fileInfo.fullPathName = "/TestGetOrAllocateSegments";
+    fileInfo.chunksize = 16 * 1024 * 1024;
+    fileInfo.segmentsize = 1 * kGiB;
+
+    auto fillSegment = [](curve::mds::PageFileSegment* segment,
+                          uint64_t offset, bool withChunk) {
+        segment->set_logicalpoolid(1);
+        segment->set_segmentsize(1 * kGiB);
+        segment->set_chunksize(16 * 1024 * 1024);
+        segment->set_startoffset(offset);
+        if (withChunk) {
+            auto* chunk = segment->add_chunks();
+            chunk->set_chunkid(offset / kGiB + 1);
+            chunk->set_copysetid(offset / kGiB + 1);
+        }
+    };
+
+    curve::mds::GetOrAllocateSegmentRequest request;
+    curve::mds::GetOrAllocateSegmentResponse response;
+    response.set_statuscode(curve::mds::StatusCode::kOK);
+    fillSegment(response.mutable_pagefilesegment(), 1 * kGiB, true);
+    fillSegment(response.add_followingsegments(), 2 * kGiB, true);
+    // segment without chunk info and the following ones are dropped
+    fillSegment(response.add_followingsegments(), 3 * kGiB, false);
+    fillSegment(response.add_followingsegments(), 4 * kGiB, true);
+
+    EXPECT_CALL(mockNameService_, GetOrAllocateSegment(_, _, _, _))
+        .WillOnce(DoAll(SaveArgPointee<1>(&request),
+                        SetArgPointee<2>(response),
+                        Invoke(FakeRpcService<GetOrAllocateSegmentRequest,
+                                              GetOrAllocateSegmentResponse>)));
+
+    std::vector<SegmentInfo> segInfos;
+    ASSERT_EQ(LIBCURVE_ERROR::OK,
+              mdsClient_.GetOrAllocateSegments(true, 1 * kGiB + 4096, 4,
+                                               &fileInfo, &segInfos));
+    ASSERT_EQ(1 * kGiB, request.offset());
+    ASSERT_EQ(4, request.segmentcount());
+
+    ASSERT_EQ(2, segInfos.size());
+    ASSERT_EQ(1 * kGiB, segInfos[0].startoffset);
+    ASSERT_EQ(1, segInfos[0].chunkvec[0].cid_);
+    ASSERT_EQ(2 * kGiB, segInfos[1].startoffset);
+    ASSERT_EQ(2, segInfos[1].chunkvec[0].cid_);
+}
+
 }  // namespace client
 }  // namespace curve
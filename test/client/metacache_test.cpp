@@ -110,5 +110,35 @@ TEST_F(MetaCacheTest, TestCleanChunksInSegment) {
     }
 }
 
+TEST_F(MetaCacheTest, TestGetCopysetLeaders) {
+    ASSERT_TRUE(metaCache_.GetCopysetLeaders().empty());
+
+    CopysetInfo<ChunkServerID> csinfo;
+    for (ChunkServerID id = 1; id <= 3; ++id) {
+        butil::EndPoint ep;
+        butil::str2endpoint("127.0.0.1", 9100 + id, &ep);
+        PeerAddr addr(ep);
+        csinfo.AddCopysetPeerInfo(
+            CopysetPeerInfo<ChunkServerID>(id, addr, addr));
+    }
+    metaCache_.UpdateCopysetInfo(1, 100, csinfo);
+
+    // leader未知
+    auto leaders = metaCache_.GetCopysetLeaders();
+    ASSERT_EQ(1, leaders.size());
+    ASSERT_EQ(1, leaders[0].lpid);
+    ASSERT_EQ(100, leaders[0].cpid);
+    ASSERT_EQ(0, leaders[0].leaderId);
+
+    butil::EndPoint leader;
+    butil::str2endpoint("127.0.0.1", 9102, &leader);
+    ASSERT_EQ(0, metaCache_.UpdateLeader(1, 100, leader));
+
+    leaders = metaCache_.GetCopysetLeaders();
+    ASSERT_EQ(1, leaders.size());
+    ASSERT_EQ(2, leaders[0].leaderId);
+    ASSERT_FALSE(leaders[0].leaderMayChange);
+}
+
 }  // namespace client
 }  // namespace curve
@@ -80,6 +80,8 @@ class MockMetaCache : public MetaCache {
 
     MOCK_METHOD1(CleanChunksInSegment, void(SegmentIndex));
 
+    MOCK_METHOD0(GetCopysetLeaders, std::vector<CopysetLeaderHint>());
+
  private:
     FakeMetaCache fakeMetaCache_;
 };
@@ -0,0 +1,47 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Date: 2022-01-12
+ */
+
+#ifndef TEST_CLIENT_MOCK_MOCK_TOPOLOGY_SERVICE_H_
+#define TEST_CLIENT_MOCK_MOCK_TOPOLOGY_SERVICE_H_
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "proto/topology.pb.h"
+
+namespace curve {
+namespace mds {
+namespace topology {
+
+class MockTopologyService : public TopologyService {
+ public:
+    MOCK_METHOD4(GetChunkServerListInCopySets,
+                 void(google::protobuf::RpcController* cntl,
+                      const GetChunkServerListInCopySetsRequest* request,
+                      GetChunkServerListInCopySetsResponse* response,
+                      google::protobuf::Closure* done));
+};
+
+}  // namespace topology
+}  // namespace mds
+}  // namespace curve
+
+#endif  // TEST_CLIENT_MOCK_MOCK_TOPOLOGY_SERVICE_H_
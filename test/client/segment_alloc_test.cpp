@@ -0,0 +1,427 @@
+/*
+ *  Copyright (c) 2022 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Date: 2022-01-12
+ */
+
+#include <brpc/server.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <future>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "src/client/io_tracker.h"
+#include "src/client/iomanager.h"
+#include "src/client/mds_client.h"
+#include "src/client/metacache.h"
+#include "src/client/segment_prefetcher.h"
+#include "src/client/splitor.h"
+#include "test/client/mock/mock_namespace_service.h"
+#include "test/client/mock/mock_topology_service.h"
+
+namespace curve {
+namespace client {
+
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Invoke;
+using ::testing::SaveArgPointee;
+using ::testing::SetArgPointee;
+
+using curve::mds::GetOrAllocateSegmentRequest;
+using curve::mds::GetOrAllocateSegmentResponse;
+using curve::mds::topology::GetChunkServerListInCopySetsRequest;
+using curve::mds::topology::GetChunkServerListInCopySetsResponse;
+
+constexpr uint64_t kMiB = 1024ull * 1024;
+constexpr uint64_t kGiB = 1024ull * kMiB;
+constexpr uint64_t kChunkSize = 16 * kMiB;
+constexpr uint64_t kSegmentSize = 1 * kGiB;
+constexpr uint64_t kFileLength = 10 * kGiB;
+const char kMdsAddr[] = "127.0.0.1:9620";
+
+class MockIOManager : public IOManager {
+ public:
+    MOCK_METHOD1(PrefetchSegment, void(SegmentIndex segmentIndex));
+    MOCK_METHOD1(HandleAsyncIOResponse, void(IOTracker* iotracker));
+};
+
+template <typename RpcRequestType, typename RpcResponseType>
+void FakeRpcService(google::protobuf::RpcController* cntl_base,
+                    const RpcRequestType* request, RpcResponseType* response,
+                    google::protobuf::Closure* done) {
+    done->Run();
+}
+
+// 返回从offset开始的segmentCount个segment，每个segment只带第一个chunk
+void FakeGetOrAllocateSegment(google::protobuf::RpcController* cntl_base,
+                              const GetOrAllocateSegmentRequest* request,
+                              GetOrAllocateSegmentResponse* response,
+                              google::protobuf::Closure* done) {
+    auto fillSegment = [](curve::mds::PageFileSegment* segment,
+                          uint64_t offset) {
+        segment->set_logicalpoolid(1);
+        segment->set_segmentsize(kSegmentSize);
+        segment->set_chunksize(kChunkSize);
+        segment->set_startoffset(offset);
+        auto* chunk = segment->add_chunks();
+        chunk->set_chunkid(offset / kChunkSize + 1);
+        chunk->set_copysetid(1);
+    };
+
+    response->set_statuscode(curve::mds::StatusCode::kOK);
+    fillSegment(response->mutable_pagefilesegment(), request->offset());
+    uint32_t count =
+        request->has_segmentcount() ? request->segmentcount() : 1;
+    for (uint32_t i = 1; i < count; ++i) {
+        fillSegment(response->add_followingsegments(),
+                    request->offset() + i * kSegmentSize);
+    }
+    done->Run();
+}
+
+class SegmentAllocTest : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        ASSERT_EQ(0, server_.AddService(&nameService_,
+                                        brpc::SERVER_DOESNT_OWN_SERVICE));
+        ASSERT_EQ(0, server_.AddService(&topologyService_,
+                                        brpc::SERVER_DOESNT_OWN_SERVICE));
+        ASSERT_EQ(0, server_.Start(kMdsAddr, nullptr));
+
+        MetaServerOption option;
+        option.rpcRetryOpt.addrs = {kMdsAddr};
+        option.rpcRetryOpt.rpcTimeoutMs = 2000;
+        option.rpcRetryOpt.maxRPCTimeoutMS = 4000;
+        option.mdsMaxRetryMS = 8000;
+        ASSERT_EQ(LIBCURVE_ERROR::OK, mdsClient_.Initialize(option));
+
+        fileInfo_.fullPathName = "/SegmentAllocTest";
+        fileInfo_.filename = "SegmentAllocTest";
+        fileInfo_.chunksize = kChunkSize;
+        fileInfo_.segmentsize = kSegmentSize;
+        fileInfo_.length = kFileLength;
+        metaCache_.UpdateFileInfo(fileInfo_);
+
+        splitOpt_.alignment.commonVolume = 512;
+        splitOpt_.alignment.cloneVolume = 4096;
+        splitOpt_.fileIOSplitMaxSizeKB = 64;
+        Splitor::Init(splitOpt_);
+
+        // 拓扑信息与segment的分配无关，直接返回成功
+        GetChunkServerListInCopySetsResponse response;
+        response.set_statuscode(0);
+        EXPECT_CALL(topologyService_, GetChunkServerListInCopySets(_, _, _, _))
+            .WillRepeatedly(DoAll(
+                SetArgPointee<2>(response),
+                Invoke(FakeRpcService<GetChunkServerListInCopySetsRequest,
+                                      GetChunkServerListInCopySetsResponse>)));
+    }
+
+    void TearDown() override {
+        Splitor::Init(IOSplitOption());
+        server_.Stop(0);
+        server_.Join();
+    }
+
+    void InitSegmentAllocOption(uint32_t batchSize, bool prefetchEnable) {
+        splitOpt_.segmentAllocOpt.batchSize = batchSize;
+        splitOpt_.segmentAllocOpt.prefetchEnable = prefetchEnable;
+        splitOpt_.segmentAllocOpt.prefetchTriggerPercent = 50;
+        splitOpt_.segmentAllocOpt.prefetchRPCMaxRetryMS = 1000;
+        Splitor::Init(splitOpt_);
+    }
+
+    void CacheChunk(uint64_t offset) {
+        ChunkIndex chunkIdx = offset / kChunkSize;
+        metaCache_.UpdateChunkInfoByIndex(chunkIdx,
+                                          ChunkIDInfo(chunkIdx + 1, 1, 1));
+    }
+
+    bool IsSegmentCached(SegmentIndex segmentIndex) {
+        ChunkIDInfo chunkIdInfo;
+        return metaCache_.GetChunkInfoByIndex(
+                   segmentIndex * kSegmentSize / kChunkSize, &chunkIdInfo) ==
+                   MetaCacheErrorType::OK &&
+               chunkIdInfo.chunkExist;
+    }
+
+    int DoIO(IOTracker* iotracker, OpType opType, uint64_t offset,
+             uint64_t length) {
+        iotracker->SetOpType(opType);
+        butil::IOBuf data;
+        data.append(std::string(length, 'a'));
+
+        std::vector<RequestContext*> requests;
+        int ret = Splitor::IO2ChunkRequests(
+            iotracker, &metaCache_, &requests,
+            opType == OpType::WRITE ? &data : nullptr, offset, length,
+            &mdsClient_, &fileInfo_);
+        for (auto* request : requests) {
+            request->UnInit();
+            delete request;
+        }
+
+        // 拆分成功时io持有segment的读锁，直到io返回才释放
+        if (ret == 0) {
+            metaCache_.GetFileSegment(offset / kSegmentSize)->ReleaseLock();
+        }
+        return ret;
+    }
+
+ protected:
+    brpc::Server server_;
+    curve::mds::MockNameService nameService_;
+    curve::mds::topology::MockTopologyService topologyService_;
+    MDSClient mdsClient_;
+    MetaCache metaCache_;
+    FInfo fileInfo_;
+    IOSplitOption splitOpt_;
+};
+
+TEST_F(SegmentAllocTest, BatchAllocateTest) {
+    InitSegmentAllocOption(4, false);
+    IOTracker iotracker(nullptr, &metaCache_, nullptr);
+
+    GetOrAllocateSegmentRequest request;
+    EXPECT_CALL(nameService_, GetOrAllocateSegment(_, _, _, _))
+        .WillRepeatedly(DoAll(SaveArgPointee<1>(&request),
+                              Invoke(FakeGetOrAllocateSegment)));
+
+    // 顺带分配后面连续的、未缓存的segment，遇到已缓存的segment停止
+    CacheChunk(4 * kSegmentSize);
+    ASSERT_EQ(0, DoIO(&iotracker, OpType::WRITE, 1 * kSegmentSize, 4096));
+    ASSERT_EQ(1 * kSegmentSize, request.offset());
+    ASSERT_EQ(3, request.segmentcount());
+    ASSERT_TRUE(IsSegmentCached(1));
+    ASSERT_TRUE(IsSegmentCached(2));
+    ASSERT_TRUE(IsSegmentCached(3));
+    ASSERT_FALSE(IsSegmentCached(5));
+
+    // 不会超过文件末尾
+    ASSERT_EQ(0, DoIO(&iotracker, OpType::WRITE, 8 * kSegmentSize, 4096));
+    ASSERT_EQ(8 * kSegmentSize, request.offset());
+    ASSERT_EQ(2, request.segmentcount());
+    ASSERT_TRUE(IsSegmentCached(8));
+    ASSERT_TRUE(IsSegmentCached(9));
+
+    // 读请求不分配segment，也不批量获取
+    ASSERT_EQ(0, DoIO(&iotracker, OpType::READ, 5 * kSegmentSize, 4096));
+    ASSERT_EQ(5 * kSegmentSize, request.offset());
+    ASSERT_FALSE(request.has_segmentcount());
+    ASSERT_TRUE(IsSegmentCached(5));
+    ASSERT_FALSE(IsSegmentCached(6));
+
+    // batchSize为1时只分配io所在的segment
+    InitSegmentAllocOption(1, false);
+    ASSERT_EQ(0, DoIO(&iotracker, OpType::WRITE, 6 * kSegmentSize, 4096));
+    ASSERT_EQ(6 * kSegmentSize, request.offset());
+    ASSERT_FALSE(request.has_segmentcount());
+    ASSERT_TRUE(IsSegmentCached(6));
+    ASSERT_FALSE(IsSegmentCached(7));
+}
+
+TEST_F(SegmentAllocTest, PrefetchTriggerTest) {
+    MockIOManager ioManager;
+    IOTracker iotracker(&ioManager, &metaCache_, nullptr);
+
+    // io所在的chunk都已经缓存，不需要向mds获取
+    EXPECT_CALL(nameService_, GetOrAllocateSegment(_, _, _, _)).Times(0);
+    const uint64_t beforeTrigger = 1 * kSegmentSize;
+    const uint64_t afterTrigger = 1 * kSegmentSize + kSegmentSize / 2;
+    CacheChunk(beforeTrigger);
+    CacheChunk(afterTrigger);
+
+    // 没有开启预分配
+    InitSegmentAllocOption(1, false);
+    EXPECT_CALL(ioManager, PrefetchSegment(_)).Times(0);
+    ASSERT_EQ(0, DoIO(&iotracker, OpType::WRITE, afterTrigger, 4096));
+
+    // 没有写过segment的一半
+    InitSegmentAllocOption(1, true);
+    ASSERT_EQ(0, DoIO(&iotracker, OpType::WRITE, beforeTrigger, 4096));
+
+    // 读请求不触发预分配
+    ASSERT_EQ(0, DoIO(&iotracker, OpType::READ, afterTrigger, 4096));
+
+    // 顺序写过了segment的一半，预分配下一个segment
+    EXPECT_CALL(ioManager, PrefetchSegment(2)).Times(1);
+    ASSERT_EQ(0, DoIO(&iotracker, OpType::WRITE, afterTrigger, 4096));
+
+    // 下一个segment已经缓存
+    CacheChunk(2 * kSegmentSize);
+    ASSERT_EQ(0, DoIO(&iotracker, OpType::WRITE, afterTrigger, 4096));
+
+    // 下一个segment超过了文件末尾
+    CacheChunk(9 * kSegmentSize + kSegmentSize / 2);
+    ASSERT_EQ(0, DoIO(&iotracker, OpType::WRITE,
+                      9 * kSegmentSize + kSegmentSize / 2, 4096));
+}
+
+TEST_F(SegmentAllocTest, LockUncachedSegmentsTest) {
+    InitSegmentAllocOption(4, true);
+
+    GetOrAllocateSegmentRequest request;
+    EXPECT_CALL(nameService_, GetOrAllocateSegment(_, _, _, _))
+        .WillRepeatedly(DoAll(SaveArgPointee<1>(&request),
+                              Invoke(FakeGetOrAllocateSegment)));
+
+    // discard持有segment的写锁时跳过该segment以及之后的segment
+    FileSegment* segment3 = metaCache_.GetFileSegment(3);
+    segment3->AcquireWriteLock();
+    ASSERT_TRUE(Splitor::PrefetchSegments(2, &mdsClient_, &metaCache_,
+                                          &fileInfo_));
+    ASSERT_EQ(2 * kSegmentSize, request.offset());
+    ASSERT_FALSE(request.has_segmentcount());
+    ASSERT_TRUE(IsSegmentCached(2));
+    ASSERT_FALSE(IsSegmentCached(3));
+
+    // 第一个segment就被锁住时不阻塞，也不会发送请求
+    request.Clear();
+    auto future = std::async(std::launch::async, [this]() {
+        return Splitor::PrefetchSegments(3, &mdsClient_, &metaCache_,
+                                         &fileInfo_);
+    });
+    ASSERT_EQ(std::future_status::ready,
+              future.wait_for(std::chrono::seconds(5)));
+    ASSERT_TRUE(future.get());
+    ASSERT_FALSE(request.has_offset());
+    ASSERT_FALSE(IsSegmentCached(3));
+    segment3->ReleaseLock();
+
+    // 正在进行的io持有读锁，不影响预分配
+    FileSegment* segment5 = metaCache_.GetFileSegment(5);
+    segment5->AcquireReadLock();
+    ASSERT_TRUE(Splitor::PrefetchSegments(5, &mdsClient_, &metaCache_,
+                                          &fileInfo_));
+    segment5->ReleaseLock();
+    ASSERT_EQ(5 * kSegmentSize, request.offset());
+    ASSERT_EQ(4, request.segmentcount());
+    for (SegmentIndex i = 5; i < 9; ++i) {
+        ASSERT_TRUE(IsSegmentCached(i));
+    }
+
+    // 预分配持有读锁期间，discard等待预分配完成
+    std::promise<void> arrived;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    EXPECT_CALL(nameService_, GetOrAllocateSegment(_, _, _, _))
+        .WillOnce(Invoke([&](google::protobuf::RpcController* cntl,
+                             const GetOrAllocateSegmentRequest* rpcRequest,
+                             GetOrAllocateSegmentResponse* response,
+                             google::protobuf::Closure* done) {
+            arrived.set_value();
+            released.wait();
+            FakeGetOrAllocateSegment(cntl, rpcRequest, response, done);
+        }));
+    auto prefetch = std::async(std::launch::async, [this]() {
+        return Splitor::PrefetchSegments(9, &mdsClient_, &metaCache_,
+                                         &fileInfo_);
+    });
+    arrived.get_future().wait();
+
+    std::atomic<bool> discarded{false};
+    std::thread discard([&]() {
+        FileSegmentWriteLockGuard lk(metaCache_.GetFileSegment(9));
+        discarded = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_FALSE(discarded.load());
+
+    release.set_value();
+    ASSERT_TRUE(prefetch.get());
+    discard.join();
+    ASSERT_TRUE(discarded.load());
+    ASSERT_TRUE(IsSegmentCached(9));
+}
+
+TEST_F(SegmentAllocTest, SegmentPrefetcherTest) {
+    InitSegmentAllocOption(1, true);
+
+    // 第一个请求返回之前重复提交的任务会被忽略
+    std::promise<void> arrived;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::vector<uint64_t> offsets;
+    EXPECT_CALL(nameService_, GetOrAllocateSegment(_, _, _, _))
+        .Times(2)
+        .WillOnce(Invoke([&](google::protobuf::RpcController* cntl,
+                             const GetOrAllocateSegmentRequest* request,
+                             GetOrAllocateSegmentResponse* response,
+                             google::protobuf::Closure* done) {
+            offsets.push_back(request->offset());
+            arrived.set_value();
+            released.wait();
+            FakeGetOrAllocateSegment(cntl, request, response, done);
+        }))
+        .WillOnce(Invoke([&](google::protobuf::RpcController* cntl,
+                             const GetOrAllocateSegmentRequest* request,
+                             GetOrAllocateSegmentResponse* response,
+                             google::protobuf::Closure* done) {
+            offsets.push_back(request->offset());
+            FakeGetOrAllocateSegment(cntl, request, response, done);
+        }));
+
+    SegmentPrefetcher prefetcher;
+    prefetcher.Init(splitOpt_.segmentAllocOpt, &metaCache_, &mdsClient_);
+    prefetcher.Start();
+
+    prefetcher.Prefetch(2);
+    arrived.get_future().wait();
+    prefetcher.Prefetch(2);
+    prefetcher.Prefetch(4);
+    prefetcher.Prefetch(4);
+    release.set_value();
+
+    uint64_t startMs = TimeUtility::GetTimeofDayMs();
+    while ((!IsSegmentCached(2) || !IsSegmentCached(4)) &&
+           TimeUtility::GetTimeofDayMs() - startMs < 5000) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(IsSegmentCached(2));
+    ASSERT_TRUE(IsSegmentCached(4));
+    prefetcher.Stop();
+    ASSERT_EQ(std::vector<uint64_t>({2 * kSegmentSize, 4 * kSegmentSize}),
+              offsets);
+
+    // 停止之后提交的任务直接丢弃
+    prefetcher.Prefetch(6);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_FALSE(IsSegmentCached(6));
+}
+
+TEST_F(SegmentAllocTest, SegmentPrefetcherDisabledTest) {
+    InitSegmentAllocOption(4, false);
+    EXPECT_CALL(nameService_, GetOrAllocateSegment(_, _, _, _)).Times(0);
+
+    SegmentPrefetcher prefetcher;
+    prefetcher.Init(splitOpt_.segmentAllocOpt, &metaCache_, &mdsClient_);
+    prefetcher.Start();
+    prefetcher.Prefetch(2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    prefetcher.Stop();
+    ASSERT_FALSE(IsSegmentCached(2));
+}
+
+}  // namespace client
+}  // namespace curve
@@ -2362,6 +2362,88 @@ TEST_F(CurveFSTest, testGetOrAllocateSegment) {
     }
 }
 
+TEST_F(CurveFSTest, testGetOrAllocateSegments) {
+    FileInfo fileInfo1;
+    fileInfo1.set_filetype(FileType::INODE_DIRECTORY);
+
+    FileInfo fileInfo2;
+    fileInfo2.set_filetype(FileType::INODE_PAGEFILE);
+    fileInfo2.set_length(4 * DefaultSegmentSize);
+    fileInfo2.set_segmentsize(DefaultSegmentSize);
+
+    // get exist segment and allocate the following ones
+    {
+        std::vector<PageFileSegment> segments;
+
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        EXPECT_CALL(*storage_, GetSegment(_, _, _))
+        .Times(3)
+        .WillOnce(Return(StoreStatus::OK))
+        .WillRepeatedly(Return(StoreStatus::KeyNotExist));
+
+        EXPECT_CALL(*mockChunkAllocator_, AllocateChunkSegment(_, _, _, _, _))
+        .Times(2)
+        .WillRepeatedly(Return(true));
+
+        EXPECT_CALL(*storage_, PutSegment(_, _, _, _))
+        .Times(2)
+        .WillRepeatedly(Return(StoreStatus::OK));
+
+        ASSERT_EQ(curvefs_->GetOrAllocateSegments("/user1/file2",
+                  DefaultSegmentSize, 8, true, &segments), StatusCode::kOK);
+        // stop at the end of file
+        ASSERT_EQ(3, segments.size());
+    }
+
+    // the following segments are best effort
+    {
+        std::vector<PageFileSegment> segments;
+
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        EXPECT_CALL(*storage_, GetSegment(_, _, _))
+        .Times(2)
+        .WillOnce(Return(StoreStatus::OK))
+        .WillOnce(Return(StoreStatus::KeyNotExist));
+
+        ASSERT_EQ(curvefs_->GetOrAllocateSegments("/user1/file2",
+                  0, 4, false, &segments), StatusCode::kOK);
+        ASSERT_EQ(1, segments.size());
+    }
+
+    // the first segment decides the result
+    {
+        std::vector<PageFileSegment> segments;
+
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        EXPECT_CALL(*storage_, GetSegment(_, _, _))
+        .Times(1)
+        .WillOnce(Return(StoreStatus::KeyNotExist));
+
+        ASSERT_EQ(curvefs_->GetOrAllocateSegments("/user1/file2",
+                  0, 4, false, &segments),
+                  StatusCode::kSegmentNotAllocated);
+        ASSERT_TRUE(segments.empty());
+    }
+}
+
 TEST_F(CurveFSTest, TestDeAllocateSegment) {
     const std::string filename = "/TestDeAllocateSegment";
     const uint64_t offset = 1ull * 1024 * 1024 * 1024;
@@ -2642,6 +2642,9 @@ TEST_F(TestTopologyServiceManager,
     ASSERT_EQ("ip1", response.csinfo(0).cslocs(0).hostip());
     ASSERT_EQ("ip2", response.csinfo(0).cslocs(0).externalip());
     ASSERT_EQ(8888, response.csinfo(0).cslocs(0).port());
+    // no heartbeat reported yet
+    ASSERT_FALSE(response.csinfo(0).has_leaderchunkserverid());
+    ASSERT_FALSE(response.csinfo(0).leadermaychange());
 }
 
 TEST_F(TestTopologyServiceManager,